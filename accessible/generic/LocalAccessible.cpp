@@ -835,6 +835,10 @@ nsresult LocalAccessible::HandleAccEvent(AccEvent* aEvent) {
                         : reinterpret_cast<uintptr_t>(
                               aEvent->GetAccessible()->UniqueID());
 
+#if !defined(XP_WIN)
+      ipcDoc->UpdateCacheForEvent(aEvent);
+#endif
+
       switch (aEvent->GetEventType()) {
         case nsIAccessibleEvent::EVENT_SHOW:
           ipcDoc->ShowEvent(downcast_accEvent(aEvent));
@@ -236,6 +236,12 @@ mozilla::ipc::IPCResult DocAccessibleParent::RecvEvent(
     return IPC_OK();
   }
 
+#if !defined(XP_WIN)
+  if (aEventType == nsIAccessibleEvent::EVENT_REORDER) {
+    InvalidateCachedBounds();
+  }
+#endif
+
   ProxyEvent(proxy, aEventType);
 
   if (!nsCoreUtils::AccEventObserversExist()) {
@@ -446,6 +452,10 @@ mozilla::ipc::IPCResult DocAccessibleParent::RecvScrollingEvent(
     return IPC_OK();
   }
 
+#if !defined(XP_WIN)
+  InvalidateCachedBounds();
+#endif
+
 #if defined(MOZ_WIDGET_ANDROID)
   ProxyScrollingEvent(target, aType, aScrollX, aScrollY, aMaxScrollX,
                       aMaxScrollY);
@@ -975,6 +985,30 @@ mozilla::ipc::IPCResult DocAccessibleParent::RecvBatch(
   return IPC_OK();
 }
 
+mozilla::ipc::IPCResult DocAccessibleParent::RecvCache(
+    nsTArray<CacheData>&& aData) {
+  if (mShutdown) {
+    return IPC_OK();
+  }
+
+  for (const CacheData& data : aData) {
+    // Accessibles shown and hidden in the same tick are already gone.
+    if (RemoteAccessible* proxy = GetAccessible(data.ID())) {
+      proxy->ApplyCache(data);
+    }
+  }
+  return IPC_OK();
+}
+
+void DocAccessibleParent::InvalidateCachedBounds() {
+  for (auto iter = mAccessibles.Iter(); !iter.Done(); iter.Next()) {
+    iter.Get()->mProxy->InvalidateCachedBounds();
+  }
+  for (size_t i = 0; i < ChildDocCount(); i++) {
+    ChildDocAt(i)->InvalidateCachedBounds();
+  }
+}
+
 bool DocAccessibleParent::DeallocPDocAccessiblePlatformExtParent(
     PDocAccessiblePlatformExtParent* aActor) {
   delete aActor;
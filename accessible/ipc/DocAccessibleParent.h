@@ -246,6 +246,9 @@ class DocAccessibleParent : public RemoteAccessible,
   virtual mozilla::ipc::IPCResult RecvBatch(
       const uint64_t& aBatchType, nsTArray<BatchData>&& aData) override;
 
+  virtual mozilla::ipc::IPCResult RecvCache(
+      nsTArray<CacheData>&& aData) override;
+
   virtual bool DeallocPDocAccessiblePlatformExtParent(
       PDocAccessiblePlatformExtParent* aActor) override;
 
@@ -305,6 +308,14 @@ class DocAccessibleParent : public RemoteAccessible,
     RemoteAccessible* mProxy;
   };
 
+#if !defined(XP_WIN)
+  /*
+   * Drop the cached bounds of the accessibles of this document and of its
+   * child documents, after something moved them without telling us which.
+   */
+  void InvalidateCachedBounds();
+#endif
+
   uint32_t AddSubtree(RemoteAccessible* aParent,
                       const nsTArray<AccessibleData>& aNewTree, uint32_t aIdx,
                       uint32_t aIdxInParent);
@@ -21,11 +21,72 @@
 #  include "AccessibleWrap.h"
 #endif
 #include "mozilla/PresShell.h"
+#include "mozilla/StaticPrefs_accessibility.h"
 #include "mozilla/a11y/DocAccessiblePlatformExtChild.h"
+#include "AccEvent.h"
 
 namespace mozilla {
 namespace a11y {
 
+/* static */
+CacheData DocAccessibleChild::CacheDataFor(LocalAccessible* aAcc) {
+  nsAutoString name;
+  uint32_t nameFlag = aAcc->Name(name);
+  nsAutoString description;
+  aAcc->Description(description);
+  return CacheData(reinterpret_cast<uint64_t>(aAcc->UniqueID()), aAcc->State(),
+                   nameFlag, name, description, aAcc->Bounds());
+}
+
+void DocAccessibleChild::MaybeSendShowEvent(ShowEventData& aData,
+                                            bool aFromUser) {
+  DocAccessibleChildBase::MaybeSendShowEvent(aData, aFromUser);
+  if (!StaticPrefs::accessibility_ipc_cache_enabled() || !mDoc) {
+    return;
+  }
+
+  // The parent process gets what it caches of the shown accessibles right
+  // after they are created there.
+  nsTArray<CacheData> cache(aData.NewTree().Length());
+  for (const AccessibleData& accData : aData.NewTree()) {
+    if (LocalAccessible* acc = IdToAccessible(accData.ID())) {
+      cache.AppendElement(CacheDataFor(acc));
+    }
+  }
+  Unused << SendCache(cache);
+}
+
+void DocAccessibleChild::UpdateCacheForEvent(AccEvent* aEvent) {
+  if (!StaticPrefs::accessibility_ipc_cache_enabled()) {
+    return;
+  }
+
+  LocalAccessible* acc = aEvent->GetAccessible();
+  switch (aEvent->GetEventType()) {
+    case nsIAccessibleEvent::EVENT_STATE_CHANGE:
+    case nsIAccessibleEvent::EVENT_NAME_CHANGE:
+    case nsIAccessibleEvent::EVENT_DESCRIPTION_CHANGE:
+    case nsIAccessibleEvent::EVENT_FOCUS:
+      break;
+    case nsIAccessibleEvent::EVENT_VIRTUALCURSOR_CHANGED: {
+      // Screen readers highlight the new position, whose bounds may have
+      // changed since they were cached.
+      AccVCChangeEvent* vcEvent = downcast_accEvent(aEvent);
+      acc = vcEvent->NewAccessible();
+      break;
+    }
+    default:
+      return;
+  }
+
+  if (!acc || acc->IsDoc() || acc->IsDefunct()) {
+    return;
+  }
+  nsTArray<CacheData> cache(1);
+  cache.AppendElement(CacheDataFor(acc));
+  Unused << SendCache(cache);
+}
+
 LocalAccessible* DocAccessibleChild::IdToAccessible(const uint64_t& aID) const {
   if (!aID) return mDoc;
 
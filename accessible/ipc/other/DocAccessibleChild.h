@@ -12,6 +12,7 @@
 namespace mozilla {
 namespace a11y {
 
+class AccEvent;
 class LocalAccessible;
 class DocAccessiblePlatformExtChild;
 class HyperTextAccessible;
@@ -41,6 +42,12 @@ class DocAccessibleChild : public DocAccessibleChildBase {
   virtual mozilla::ipc::IPCResult RecvConstructedInParentProcess() override;
   virtual mozilla::ipc::IPCResult RecvRestoreFocus() override;
 
+  /*
+   * Push what the parent process caches of the accessibles |aEvent| changes,
+   * before the event itself, with accessibility.ipc_cache.enabled.
+   */
+  void UpdateCacheForEvent(AccEvent* aEvent);
+
   /*
    * Return the state for the accessible with given ID.
    */
@@ -484,7 +491,13 @@ class DocAccessibleChild : public DocAccessibleChildBase {
 
   DocAccessiblePlatformExtChild* GetPlatformExtension();
 
+ protected:
+  virtual void MaybeSendShowEvent(ShowEventData& aData,
+                                  bool aFromUser) override;
+
  private:
+  static CacheData CacheDataFor(LocalAccessible* aAcc);
+
   LocalAccessible* IdToAccessible(const uint64_t& aID) const;
   LocalAccessible* IdToAccessibleLink(const uint64_t& aID) const;
   LocalAccessible* IdToAccessibleSelect(const uint64_t& aID) const;
@@ -18,7 +18,22 @@
 namespace mozilla {
 namespace a11y {
 
+void RemoteAccessible::ApplyCache(const CacheData& aData) {
+  if (!mCache) {
+    mCache = MakeUnique<Cache>();
+  }
+  mCache->mState = aData.State();
+  mCache->mNameFlag = aData.NameFlag();
+  mCache->mName = aData.Name();
+  mCache->mDescription = aData.Description();
+  mCache->mBounds = aData.Bounds();
+  mCache->mHasBounds = true;
+}
+
 uint64_t RemoteAccessible::State() const {
+  if (mCache) {
+    return mCache->mState;
+  }
   uint64_t state = 0;
   Unused << mDoc->SendState(mID, &state);
   return state;
@@ -31,6 +46,10 @@ uint64_t RemoteAccessible::NativeState() const {
 }
 
 uint32_t RemoteAccessible::Name(nsString& aName) const {
+  if (mCache) {
+    aName = mCache->mName;
+    return mCache->mNameFlag;
+  }
   uint32_t flag;
   Unused << mDoc->SendName(mID, &aName, &flag);
   return flag;
@@ -45,6 +64,10 @@ void RemoteAccessible::Help(nsString& aHelp) const {
 }
 
 void RemoteAccessible::Description(nsString& aDesc) const {
+  if (mCache) {
+    aDesc = mCache->mDescription;
+    return;
+  }
   Unused << mDoc->SendDescription(mID, &aDesc);
 }
 
@@ -854,9 +877,16 @@ Accessible* RemoteAccessible::ChildAtPoint(
 }
 
 nsIntRect RemoteAccessible::Bounds() {
+  if (mCache && mCache->mHasBounds) {
+    return mCache->mBounds;
+  }
   nsIntRect rect;
   Unused << mDoc->SendExtents(mID, false, &(rect.x), &(rect.y), &(rect.width),
                               &(rect.height));
+  if (mCache) {
+    mCache->mBounds = rect;
+    mCache->mHasBounds = true;
+  }
   return rect;
 }
 
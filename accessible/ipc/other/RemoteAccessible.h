@@ -10,6 +10,7 @@
 #include "LocalAccessible.h"
 #include "mozilla/a11y/RemoteAccessibleBase.h"
 #include "mozilla/a11y/Role.h"
+#include "mozilla/UniquePtr.h"
 #include "nsIAccessibleText.h"
 #include "nsIAccessibleTypes.h"
 #include "nsString.h"
@@ -19,6 +20,8 @@
 namespace mozilla {
 namespace a11y {
 
+class CacheData;
+
 class RemoteAccessible : public RemoteAccessibleBase<RemoteAccessible> {
  public:
   RemoteAccessible(uint64_t aID, RemoteAccessible* aParent,
@@ -33,11 +36,37 @@ class RemoteAccessible : public RemoteAccessibleBase<RemoteAccessible> {
 
 #include "mozilla/a11y/RemoteAccessibleShared.h"
 
+  /*
+   * Store what the content process pushed of this accessible with
+   * accessibility.ipc_cache.enabled. From then on, State(), Name(),
+   * Description() and Bounds() are answered from it.
+   */
+  void ApplyCache(const CacheData& aData);
+
+  /*
+   * Make the next Bounds() ask the content process, after the layout changed.
+   */
+  void InvalidateCachedBounds() {
+    if (mCache) {
+      mCache->mHasBounds = false;
+    }
+  }
+
  protected:
   explicit RemoteAccessible(DocAccessibleParent* aThisAsDoc)
       : RemoteAccessibleBase(aThisAsDoc) {
     MOZ_COUNT_CTOR(RemoteAccessible);
   }
+
+  struct Cache {
+    uint64_t mState;
+    uint32_t mNameFlag;
+    nsString mName;
+    nsString mDescription;
+    nsIntRect mBounds;
+    bool mHasBounds;
+  };
+  UniquePtr<Cache> mCache;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
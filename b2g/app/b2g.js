@@ -66,6 +66,17 @@ pref("network.http.customheader.hosts", "ssp.kaiads.com,kaios-analytics.com,kaio
 pref("network.http.customheader.name", "X-Kai-Ads");
 pref("network.http.customheader.version", "v1");
 
+// DNS lookups are slow on cellular links. Entries past their TTL are still
+// used for this long while they are refreshed in the background.
+pref("network.dnsCacheExpirationGracePeriod", 300);
+
+// A full TLS handshake costs several round trips on 2G/3G. Keep resumption
+// tokens across restarts; with them, TLS 1.3 sends safe requests as 0-RTT
+// early data to servers whose tickets allow it.
+pref("network.ssl_tokens_cache_enabled", true);
+pref("network.ssl_tokens_cache_capacity", 512);
+pref("network.ssl_tokens_cache_persist", true);
+
 // See bug 545869 for details on why these are set the way they are
 pref("network.buffer.cache.count", 24);
 pref("network.buffer.cache.size",  16384);
@@ -82,6 +93,11 @@ pref("network.disable.ipc.security", true);
 // See KaiOS Bug 108187
 pref("network.http.tcp_keepalive.long_lived_idle_time", 1800);
 
+// Keep the permessage-deflate state of websockets small and let idle
+// connections give it back.
+pref("network.websocket.extensions.permessage-deflate.max-window-bits", 12);
+pref("network.websocket.extensions.permessage-deflate.no-context-takeover", true);
+
 /* session history */
 pref("browser.sessionhistory.max_entries", 50);
 pref("browser.sessionhistory.contentViewerTimeout", 360);
@@ -254,6 +270,11 @@ pref("security.mixed_content.block_active_content", true);
 // added, there may be a need to change this pref.
 pref("security.cert_pinning.enforcement_level", 2);
 
+// Chain building and signature checks cost tens of milliseconds per
+// connection on low-end CPUs. Reuse verified server chains for a day, also
+// across restarts.
+pref("security.pki.verified_chain_cache.lifetime", 86400);
+
 
 // Override some named colors to avoid inverse OS themes
 pref("ui.-moz-dialog", "#efebe7");
@@ -356,6 +377,13 @@ pref("image.mem.surfacecache.size_factor", 32);  // 1/32 of main memory
 pref("image.mem.surfacecache.max_size_kb", 131072);  // 128MB
 pref("image.mem.surfacecache.size_factor", 8);  // 1/8 of main memory
 #endif
+// Background apps only keep what fits in 4MB (1MB on 256MB devices), rather
+// than everything until the LMK comes for them.
+#ifdef DEVICE_256MB_SUPPORT
+pref("image.mem.surfacecache.background_max_size_kb", 1024);
+#else
+pref("image.mem.surfacecache.background_max_size_kb", 4096);
+#endif
 pref("image.mem.surfacecache.discard_factor", 2);  // Discard 1/2 of the surface cache at a time.
 pref("image.mem.surfacecache.min_expiration_ms", 86400000); // 24h, we rely on the out of memory hook
 
@@ -411,6 +439,9 @@ pref("privacy.trackingprotection.pbmode.enabled", true);
 pref("browser.firstrun.show.uidiscovery", true);
 pref("browser.firstrun.show.localepicker", true);
 
+// Share the Fluent resources of the apps between processes.
+pref("intl.l10n.shared_resources.enabled", true);
+
 // initiated by a user
 pref("content.ime.strict_policy", true);
 
@@ -439,6 +470,10 @@ pref("dom.ipc.processCount", 100000);
 
 pref("dom.ipc.browser_frames.oop_by_default", false);
 
+// Gaia changes many prefs at once during setup and boot; send each burst to
+// the content processes as a single message.
+pref("dom.ipc.batchPreferenceUpdates", true);
+
 pref("dom.meta-viewport.enabled", true);
 
 // SMS/MMS
@@ -472,6 +507,8 @@ pref("dom.permissions.manager.enabled", true);
 
 // controls if we want camera support
 pref("device.camera.enabled", true);
+// Have the camera render recording frames straight into the video encoder.
+pref("camera.control.recorder.surface_input.enabled", true);
 pref("media.realtime_decoder.enabled", true);
 
 // TCPSocket
@@ -509,6 +546,10 @@ pref("app.update.silent", false);
 pref("app.update.mode", 0);
 pref("app.update.incompatible.mode", 0);
 pref("app.update.staging.enabled", true);
+// Stage updates with idle I/O and CPU priority, and only let the updater
+// run a quarter of the time while the user interacts with the device.
+pref("app.update.staging.lowPriority", true);
+pref("app.update.staging.interactiveDutyPercent", 25);
 pref("app.update.service.enabled", true);
 
 pref("app.update.url", "https://aus5.mozilla.org/update/5/%PRODUCT%/%VERSION%/%BUILD_ID%/%PRODUCT_DEVICE%/%LOCALE%/%CHANNEL%/%OS_VERSION%/%DISTRIBUTION%/%DISTRIBUTION_VERSION%/%IMEI%/update.xml");
@@ -592,6 +633,12 @@ pref("javascript.options.mem.gc_allocation_threshold_mb", 1);
 pref("javascript.options.mem.gc_decommit_threshold_mb", 1);
 pref("javascript.options.mem.gc_min_empty_chunk_count", 1);
 pref("javascript.options.mem.gc_max_empty_chunk_count", 2);
+// Background apps allocate little, and are the first the LMK kills, so
+// don't let them keep a large nursery around.
+#ifdef DEVICE_256MB_SUPPORT
+pref("javascript.options.mem.nursery.max_kb", 2048);
+#endif
+pref("javascript.options.mem.nursery.background_max_kb", 256);
 
 // Show/Hide scrollbars when active/inactive
 pref("ui.showHideScrollbars", 1);
@@ -619,6 +666,19 @@ pref("dom.ipc.processPriorityManager.backgroundGracePeriodMS", 1000);
 pref("dom.ipc.processPriorityManager.backgroundPerceivableGracePeriodMS", 5000);
 pref("dom.ipc.processPriorityManager.temporaryPriorityLockMS", 5000);
 
+// JS modules to import in preallocated processes while they wait, so the
+// app that takes the process doesn't pay for compiling them.
+pref("dom.ipc.processPrelaunch.preloadModules", "resource://gre/modules/Services.jsm,resource://gre/modules/XPCOMUtils.jsm,resource://gre/modules/AppConstants.jsm");
+
+// Origins whose style sheets are linked by most apps. Once parsed, their
+// sheets are kept for the lifetime of the process and shared by documents of
+// any origin.
+pref("layout.css.shared-sheets.origins", "http://shared.localhost");
+// Comma separated sheets from those origins to parse in preallocated
+// processes while they wait, e.g. http://shared.localhost/style/<name>.css.
+// Which ones are worth it depends on the apps, so Gaia builds fill this in.
+pref("dom.ipc.processPrelaunch.preloadStyleSheets", "");
+
 // Number of different background/foreground levels for background/foreground
 // processes.  We use these different levels to force the low-memory killer to
 // kill processes in a LRU order.
@@ -632,9 +692,9 @@ pref("dom.ipc.processPriorityManager.BACKGROUND_PERCEIVABLE.LRUPoolLevels", 4);
 // okay, kernel will still kill processes with larger OomScoreAdjust first even
 // its OomScoreAdjust don't have a corresponding KillUnderKB.
 
-pref("hal.processPriorityManager.gonk.MASTER.OomScoreAdjust", 0);
-pref("hal.processPriorityManager.gonk.MASTER.KillUnderKB", 4096);
-pref("hal.processPriorityManager.gonk.MASTER.cgroup", "");
+pref("hal.processPriorityManager.gonk.PARENT_PROCESS.OomScoreAdjust", 0);
+pref("hal.processPriorityManager.gonk.PARENT_PROCESS.KillUnderKB", 4096);
+pref("hal.processPriorityManager.gonk.PARENT_PROCESS.cgroup", "");
 
 pref("hal.processPriorityManager.gonk.PREALLOC.OomScoreAdjust", 67);
 pref("hal.processPriorityManager.gonk.PREALLOC.cgroup", "apps/bg_non_interactive");
@@ -670,6 +730,11 @@ pref("hal.processPriorityManager.gonk.BACKGROUND.KillUnderKB", 65536);
 #endif
 pref("hal.processPriorityManager.gonk.BACKGROUND.cgroup", "apps/bg_non_interactive");
 
+// With zram, the KillUnderKB of the background classes are divided by the
+// compression ratio, down to this percentage of their value, so that
+// background apps are swapped out before they are killed.
+pref("hal.processPriorityManager.gonk.zramMinKillUnderPercent", 50);
+
 // Control group definitions (i.e., CPU priority groups) for B2G processes.
 //
 // memory_swappiness -   0 - The kernel will swap only to avoid an out of memory condition
@@ -696,6 +761,29 @@ pref("hal.processPriorityManager.gonk.cgroups.apps/bg_non_interactive.cpu_shares
 pref("hal.processPriorityManager.gonk.cgroups.apps/bg_non_interactive.cpu_notify_on_migrate", 0);
 pref("hal.processPriorityManager.gonk.cgroups.apps/bg_non_interactive.memory_swappiness", 100);
 
+// While an app launches, and for a short while after each touch, the
+// foreground groups get a minimum utilization clamp (cpu.uclamp.min, a
+// percentage of the biggest CPU's capacity) or a schedtune boost on kernels
+// that have /dev/stune, so that the governor ramps up the frequency and the
+// scheduler places their tasks on the big cores right away. See
+// dom.ipc.processPriorityManager.launchBoostMS and inputBoostMS.
+pref("hal.processPriorityManager.gonk.cgroups.apps.uclamp_min", 0);
+pref("hal.processPriorityManager.gonk.cgroups.apps.boosted_uclamp_min", 50);
+pref("hal.processPriorityManager.gonk.cgroups.apps.schedtune_boost", 0);
+pref("hal.processPriorityManager.gonk.cgroups.apps.boosted_schedtune_boost", 20);
+pref("hal.processPriorityManager.gonk.cgroups.apps/critical.uclamp_min", 0);
+pref("hal.processPriorityManager.gonk.cgroups.apps/critical.boosted_uclamp_min", 50);
+pref("hal.processPriorityManager.gonk.cgroups.apps/critical.schedtune_boost", 0);
+pref("hal.processPriorityManager.gonk.cgroups.apps/critical.boosted_schedtune_boost", 20);
+
+// The CPUs each group may run on, in the kernel's cpuset list format. CPU
+// numbering depends on the SoC, so devices set these in their own prefs, e.g.
+// to keep background apps on the little cores of a big.LITTLE SoC:
+// pref("hal.processPriorityManager.gonk.cgroups.apps.cpuset", "0-7");
+// pref("hal.processPriorityManager.gonk.cgroups.apps/critical.cpuset", "0-7");
+// pref("hal.processPriorityManager.gonk.cgroups.apps/bg_perceivable.cpuset", "0-3");
+// pref("hal.processPriorityManager.gonk.cgroups.apps/bg_non_interactive.cpuset", "0-3");
+
 // By default the compositor thread on gonk runs without real-time priority.  RT
 // priority can be enabled by setting this pref to a value between 1 and 99.
 // Note that audio processing currently runs at RT priority 2 or 3 at most.
@@ -846,6 +934,18 @@ pref("network.sntp.pools", // Servers separated by ';'.
      "0.pool.ntp.org;1.pool.ntp.org;2.pool.ntp.org;3.pool.ntp.org");
 pref("network.sntp.port", 123);
 pref("network.sntp.timeout", 30); // In seconds.
+// The refresh period is adapted to the clock drift, between these bounds,
+// so that the clock drifts by about driftTolerance between two requests.
+// A minRefreshPeriod of 0 keeps refreshPeriod.
+pref("network.sntp.minRefreshPeriod", 3600); // In seconds.
+pref("network.sntp.maxRefreshPeriod", 604800); // In seconds.
+pref("network.sntp.driftTolerance", 500); // In ms.
+// On mobile data, a due refresh waits this long for the radio to be woken
+// up by something else, the screen turning on or Wi-Fi connecting.
+pref("network.sntp.radioWindow", 3600); // In seconds.
+// Corrections of the system clock smaller than this are not worth stepping
+// it, which makes every pending timer fire early or late.
+pref("network.time.minClockStep", 1000); // In ms.
 
 // Allow ADB to run for this many hours before disabling
 // (only applies when marionette is disabled)
@@ -913,6 +1013,7 @@ pref("security.exthelperapp.disable_background_handling", true);
 pref("osfile.reset_worker_delay", 5000);
 
 // APZ physics settings, tuned by UX designers
+pref("apz.adaptive_displayport.enabled", true);
 pref("apz.axis_lock.mode", 2); // Use "sticky" axis locking
 pref("apz.fling_curve_function_x1", "0.41");
 pref("apz.fling_curve_function_y1", "0.0");
@@ -977,6 +1078,10 @@ pref("dom.serviceWorkers.disable_open_click_delay", 5000);
 // or executing "long-running" JS after the "idle_timeout" period has expired.
 pref("dom.serviceWorkers.idle_extended_timeout", 300000);
 pref("dom.serviceWorkers.shutdown_observer.enabled", true);
+// Start the service workers of the most used apps once the main thread is
+// idle after boot. The system app keeps the ranked scope list up to date.
+pref("dom.serviceWorkers.prelaunch.max", 3);
+pref("dom.serviceWorkers.prelaunch.scopes", "");
 
 // Enable W3C Push API
 pref("dom.webnotifications.serviceworker.enabled", true);
@@ -985,7 +1090,12 @@ pref("dom.push.enabled", true);
 // extend request timeout if fetching token is required
 pref("dom.push.extendTimeout.token", 3000);
 
-// Adaptive ping
+// Dispatch bursts of push messages to a service worker together.
+pref("dom.push.coalesceWindow", 500);
+
+// Adaptive ping: probe for the NAT timeout instead of pinging on a fixed
+// short interval, so the radio wakes up as rarely as the network allows.
+pref("dom.push.adaptive.enabled", true);
 pref("dom.push.adaptive.lastGoodPingInterval", 180000);// 3 min
 pref("dom.push.adaptive.lastGoodPingInterval.mobile", 180000);// 3 min
 pref("dom.push.adaptive.lastGoodPingInterval.wifi", 180000);// 3 min
@@ -1009,6 +1119,7 @@ pref("dom.webdriver.enabled", false);
 
 // In B2G by deafult any AudioChannelAgent is muted when created.
 pref("dom.audiochannel.mutedByDefault", true);
+pref("dom.audiochannel.local_policy.enabled", true);
 
 // The app origin of bluetooth app, which is responsible for listening pairing
 // requests.
@@ -1127,6 +1238,12 @@ pref("dom.b2g_ipv6_addr_mode", 0);
 // Support primary sim switch
 pref("ril.support.primarysim.switch", false);
 
+// Keep the USIM phonebook in the profile and validate it against the card's
+// change counter instead of reading every record at each boot.
+pref("ril.icc.contacts.cache.enabled", true);
+// Number of SIM IO reads kept in flight while reading phonebook records.
+pref("ril.icc.contacts.maxPendingReads", 4);
+
 // Enable app cell broadcast list configuration (apn.json)
 pref("dom.app_cb_configuration", true);
 
@@ -1155,6 +1272,11 @@ pref("browser.privatebrowsing.autostart", false);
 pref("security.sandbox.content.level", 4);
 
 pref("gfx.e10s.font-list.shared", true);
+// Comma separated device pixel sizes at which preallocated processes draw
+// the ASCII glyphs of the default sans-serif font while they wait, so that
+// apps don't rasterize them for their first paint. Glyph caches are per
+// process, so this trades a little memory for launch time.
+pref("gfx.font-prerender.sizes", "14,17");
 
 pref("dom.systemMessage.enabled", true);
 
@@ -1180,7 +1302,9 @@ pref("dom.ipc.forkserver.enable", true);
 // the system app, until nsContentSecurityManager.cpp stabilizes (eg. bug 1544011)
 pref("dom.security.skip_remote_script_assertion_in_system_priv_context", true);
 
-// Disable WebRender by default
+// Disable WebRender by default. When it is enabled, devices whose GPU only
+// does GLES2 fall back to software WebRender composited with CompositorOGL.
+// The small picture tiles keep the per-frame upload down on those devices.
 pref("gfx.webrender.all", false);
 pref("gfx.webrender.enabled", false);
 pref("gfx.webrender.force-disabled", true);
@@ -1235,6 +1359,11 @@ pref("gfx.font_rendering.native_font_source_none", true);
 pref("captivedetect.canonicalURL", "http://detectportal.kaiostech.com/success.txt");
 pref("captivedetect.canonicalContent", "success");
 
+// Answer repeated settings reads from Gecko without a round trip to the
+// api-daemon. The listed settings are fetched in one batch at startup.
+pref("b2g.settings.cache.enabled", true);
+pref("b2g.settings.cache.prefetch", "audio.volume.content,audio.volume.notification,geolocation.enabled,language.current,ril.data.enabled,screen.brightness");
+
 pref("externalAPI.websocket.protocols", "kaios-services");
 pref("externalAPI.websocket.url", "ws://localhost/");
 
@@ -1250,4 +1379,74 @@ pref("voice-input.excluded-x-inputmodes", "native, plain, simplified, spell");
 
 pref("dom.storage.next_gen", false);
 
+// Records a cursor preloads are held in the parent and the child until the
+// app iterates over them, keep that to a page worth of them rather than half
+// an IPC message.
+pref("dom.indexedDB.maxPreloadBytes", 262144);
+
 pref("dom.popup_allowed_events", "change click dblclick auxclick mouseup pointerup notificationclick reset submit touchend contextmenu keydown keyup");
+
+// The system app shares the parent's main thread, so any stall there freezes
+// the whole UI. Log the hangs the background hang monitor sees that are long
+// enough to be noticed.
+pref("toolkit.background-hang-monitor.log_threshold_ms", 200);
+
+#ifdef MOZ_GECKO_PROFILER
+// Keep a 10Hz profile of the main threads so that hangs reported from the
+// field can be diagnosed from the profiler_field_mode.json they leave behind.
+pref("profiler.field_mode.enabled", true);
+#endif
+
+// Trace app launches from startup, see AppLaunchTracer.jsm. Harnesses can
+// also enable it at runtime. An app is ready once it makes the performance
+// mark named by ready_mark.
+pref("b2g.launch_tracer.enabled", false);
+pref("b2g.launch_tracer.ready_mark", "fullyLoaded");
+pref("b2g.launch_tracer.timeout_ms", 30000);
+
+// Scale back composition, background timers and GC helper threads as the
+// device heats up, before the kernel throttles the CPU.
+pref("dom.thermal_governor.enabled", true);
+
+// Keep large blobs (camera photos, recordings) in temporary files instead of
+// on the heap of every process that holds them.
+pref("dom.blob.spill_threshold", 1048576);
+pref("dom.blob.spill_on_memory_pressure", true);
+
+// Apps do many small SimpleDB writes, batch them across apps so that the
+// eMMC sees a few larger ones.
+pref("dom.simpledb.write_behind.delay_ms", 200);
+
+// Dump a line to logcat for every chrome script loaded on demand, see
+// LazyScripts.jsm.
+pref("b2g.lazy_scripts.log", false);
+
+// Let core apps share content processes once the windows of all processes
+// use more than budget_mb or memory is under pressure, see
+// B2GProcessSelector.jsm. A budget of 0 only shares under pressure.
+pref("b2g.process_sharing.enabled", true);
+pref("b2g.process_sharing.budget_mb", 0);
+pref("b2g.process_sharing.max_process_mb", 40);
+pref("b2g.process_sharing.refresh_ms", 5000);
+
+// Prerender the app users usually launch next when the device is idle, see
+// AppLaunchPredictor.jsm. min_probability is a percentage.
+pref("b2g.app_predictor.enabled", true);
+pref("b2g.app_predictor.delay_ms", 3000);
+pref("b2g.app_predictor.min_samples", 3);
+pref("b2g.app_predictor.min_probability", 40);
+pref("b2g.app_predictor.min_free_mb", 64);
+
+// Answer network location queries from the fixes previously obtained for the
+// same cells and Wi-Fi access points. A cached fix loses decayMetersPerMinute
+// of accuracy per minute and is dropped past maxAccuracy meters or
+// maxAgeHours.
+pref("geo.provider.network.fixCache.enabled", true);
+pref("geo.provider.network.fixCache.maxEntries", 200);
+pref("geo.provider.network.fixCache.maxAgeHours", 168);
+pref("geo.provider.network.fixCache.decayMetersPerMinute", 10);
+pref("geo.provider.network.fixCache.maxAccuracy", 2000);
+
+// Deliver the notifications posted within batch_ms of each other to the
+// system app together, see AlertsHelper.jsm. 0 delivers each right away.
+pref("b2g.notifications.batch_ms", 100);
@@ -258,7 +258,15 @@ uint32_t gBlocklistInitFlags = eDllBlocklistInitFlagDefault;
 int main(int argc, char* argv[], char* envp[]) {
 #if defined(MOZ_ENABLE_FORKSERVER)
   if (strcmp(argv[argc - 1], "forkserver") == 0) {
+#  ifdef MOZ_WIDGET_GONK
+    // Every content process is forked from here, so pull all of libxul
+    // (code, read-only data and the ICU data linked into it) into the page
+    // cache once now. The children then map warm pages instead of each
+    // faulting them in from flash during app launch.
+    nsresult rv = InitXPCOMGlue(LibLoadingStrategy::ReadAhead);
+#  else
     nsresult rv = InitXPCOMGlue(LibLoadingStrategy::NoReadAhead);
+#  endif
     if (NS_FAILED(rv)) {
       return 255;
     }
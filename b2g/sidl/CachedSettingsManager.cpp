@@ -0,0 +1,365 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "CachedSettingsManager.h"
+#include "mozilla/Logging.h"
+#include "mozilla/Preferences.h"
+#include "nsCharSeparatedTokenizer.h"
+#include "nsThreadUtils.h"
+
+namespace mozilla {
+
+static LazyLogModule gSettingsCacheLog("SettingsCache");
+#define LOG(...) \
+  MOZ_LOG(gSettingsCacheLog, LogLevel::Debug, (__VA_ARGS__))
+
+#define PREF_CACHE_PREFETCH "b2g.settings.cache.prefetch"
+
+namespace {
+
+class CachedSettingInfo final : public nsISettingInfo {
+ public:
+  NS_DECL_ISUPPORTS
+  NS_DECL_NSISETTINGINFO
+
+  CachedSettingInfo(const nsAString& aName, const nsAString& aValue)
+      : mName(aName), mValue(aValue) {}
+
+ private:
+  ~CachedSettingInfo() = default;
+
+  nsString mName;
+  nsString mValue;
+};
+
+NS_IMPL_ISUPPORTS(CachedSettingInfo, nsISettingInfo)
+
+NS_IMETHODIMP
+CachedSettingInfo::GetName(nsAString& aName) {
+  aName = mName;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+CachedSettingInfo::SetName(const nsAString& aName) {
+  mName = aName;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+CachedSettingInfo::GetValue(nsAString& aValue) {
+  aValue = mValue;
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+CachedSettingInfo::SetValue(const nsAString& aValue) {
+  mValue = aValue;
+  return NS_OK;
+}
+
+class FillGetResponse final : public nsISettingsGetResponse {
+ public:
+  NS_DECL_ISUPPORTS
+
+  FillGetResponse(CachedSettingsManager* aManager, const nsAString& aName)
+      : mManager(aManager), mName(aName) {}
+
+  NS_IMETHOD Resolve(nsISettingInfo* aInfo) override {
+    mManager->OnGetResolved(mName, aInfo);
+    return NS_OK;
+  }
+
+  NS_IMETHOD Reject(nsISettingError* aError) override {
+    mManager->OnGetRejected(mName, aError);
+    return NS_OK;
+  }
+
+ private:
+  ~FillGetResponse() = default;
+
+  RefPtr<CachedSettingsManager> mManager;
+  nsString mName;
+};
+
+NS_IMPL_ISUPPORTS(FillGetResponse, nsISettingsGetResponse)
+
+// Fills the cache from a batch, then passes it on to aCallback if any.
+class FillBatchResponse final : public nsISettingsGetBatchResponse {
+ public:
+  NS_DECL_ISUPPORTS
+
+  FillBatchResponse(CachedSettingsManager* aManager,
+                    nsISettingsGetBatchResponse* aCallback)
+      : mManager(aManager), mCallback(aCallback) {}
+
+  NS_IMETHOD Resolve(
+      const nsTArray<RefPtr<nsISettingInfo>>& aSettings) override {
+    mManager->OnSettingsFetched(aSettings);
+    return mCallback ? mCallback->Resolve(aSettings) : NS_OK;
+  }
+
+  NS_IMETHOD Reject(nsISettingError* aError) override {
+    return mCallback ? mCallback->Reject(aError) : NS_OK;
+  }
+
+ private:
+  ~FillBatchResponse() = default;
+
+  RefPtr<CachedSettingsManager> mManager;
+  nsCOMPtr<nsISettingsGetBatchResponse> mCallback;
+};
+
+NS_IMPL_ISUPPORTS(FillBatchResponse, nsISettingsGetBatchResponse)
+
+}  // namespace
+
+// Registered with the inner manager for its change event. Holds a weak
+// pointer, since the inner manager keeps its listeners alive.
+class CachedSettingsManager::ChangeListener final
+    : public nsISidlEventListener {
+ public:
+  NS_DECL_ISUPPORTS
+
+  explicit ChangeListener(CachedSettingsManager* aManager)
+      : mManager(aManager) {}
+
+  void Disconnect() { mManager = nullptr; }
+
+  NS_IMETHOD HandleEvent(nsISupports* aData) override {
+    nsCOMPtr<nsISettingInfo> info = do_QueryInterface(aData);
+    if (mManager && info) {
+      mManager->OnSettingChanged(info);
+    }
+    return NS_OK;
+  }
+
+ private:
+  ~ChangeListener() = default;
+
+  CachedSettingsManager* mManager;
+};
+
+NS_IMPL_ISUPPORTS(CachedSettingsManager::ChangeListener, nsISidlEventListener)
+
+NS_IMPL_ISUPPORTS(CachedSettingsManager, nsISettingsManager)
+
+/* static */
+already_AddRefed<nsISettingsManager> CachedSettingsManager::Create(
+    nsISettingsManager* aInner) {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  nsCOMPtr<nsISettingsManager> manager = aInner;
+  if (!aInner) {
+    return manager.forget();
+  }
+
+  RefPtr<CachedSettingsManager> cached = new CachedSettingsManager(aInner);
+  cached->mChangeListener = new ChangeListener(cached);
+  if (NS_FAILED(aInner->AddEventListener(nsISettingsManager::CHANGE_EVENT,
+                                         cached->mChangeListener))) {
+    // Without change events the cache could serve stale values.
+    NS_WARNING("Can't observe settings changes, not caching settings");
+    cached->mChangeListener->Disconnect();
+    cached->mChangeListener = nullptr;
+    return manager.forget();
+  }
+  cached->Prefetch();
+
+  manager = cached.forget();
+  return manager.forget();
+}
+
+CachedSettingsManager::CachedSettingsManager(nsISettingsManager* aInner)
+    : mInner(aInner), mHits(0), mMisses(0) {}
+
+CachedSettingsManager::~CachedSettingsManager() {
+  if (mChangeListener) {
+    mChangeListener->Disconnect();
+    mInner->RemoveEventListener(nsISettingsManager::CHANGE_EVENT,
+                                mChangeListener);
+  }
+  uint32_t total = mHits + mMisses;
+  MOZ_LOG(gSettingsCacheLog, LogLevel::Info,
+          ("%u gets, %u answered from the cache (%u%%)", total, mHits,
+           total ? mHits * 100 / total : 0));
+}
+
+void CachedSettingsManager::Prefetch() {
+  nsAutoString list;
+  Preferences::GetString(PREF_CACHE_PREFETCH, list);
+
+  nsTArray<nsString> names;
+  for (const nsAString& name :
+       nsCharSeparatedTokenizer(list, ',').ToRange()) {
+    if (!name.IsEmpty()) {
+      names.AppendElement(name);
+    }
+  }
+  if (names.IsEmpty()) {
+    return;
+  }
+
+  LOG("Prefetching %zu settings", names.Length());
+  nsCOMPtr<nsISettingsGetBatchResponse> callback =
+      new FillBatchResponse(this, nullptr);
+  mInner->GetBatch(names, callback);
+}
+
+NS_IMETHODIMP
+CachedSettingsManager::Get(const nsAString& aName,
+                           nsISettingsGetResponse* aCallback) {
+  MOZ_ASSERT(NS_IsMainThread());
+  NS_ENSURE_ARG(aCallback);
+
+  if (auto value = mValues.Lookup(aName)) {
+    mHits++;
+    // Callers expect to be called back asynchronously, as they are by the
+    // daemon.
+    nsCOMPtr<nsISettingInfo> info = new CachedSettingInfo(aName, *value);
+    nsCOMPtr<nsISettingsGetResponse> callback = aCallback;
+    return NS_DispatchToCurrentThread(NS_NewRunnableFunction(
+        "CachedSettingsManager::Get",
+        [callback, info]() { callback->Resolve(info); }));
+  }
+
+  mMisses++;
+  if (auto pending = mPendingGets.Lookup(aName)) {
+    (*pending)->mCallbacks.AppendElement(aCallback);
+    return NS_OK;
+  }
+
+  auto pending = MakeUnique<PendingGet>();
+  pending->mCallbacks.AppendElement(aCallback);
+  mPendingGets.InsertOrUpdate(aName, std::move(pending));
+
+  nsCOMPtr<nsISettingsGetResponse> fill = new FillGetResponse(this, aName);
+  nsresult rv = mInner->Get(aName, fill);
+  if (NS_FAILED(rv)) {
+    mPendingGets.Remove(aName);
+  }
+  return rv;
+}
+
+void CachedSettingsManager::OnGetResolved(const nsAString& aName,
+                                          nsISettingInfo* aInfo) {
+  UniquePtr<PendingGet> pending;
+  mPendingGets.Remove(aName, &pending);
+
+  nsCOMPtr<nsISettingInfo> info = aInfo;
+  if (pending && pending->mStale) {
+    // Answer with what the change event told us rather than the older
+    // value the daemon returned.
+    if (auto value = mValues.Lookup(aName)) {
+      info = new CachedSettingInfo(aName, *value);
+    }
+  } else if (aInfo) {
+    nsAutoString value;
+    aInfo->GetValue(value);
+    mValues.InsertOrUpdate(aName, value);
+  }
+
+  if (!pending) {
+    return;
+  }
+  for (nsISettingsGetResponse* callback : pending->mCallbacks) {
+    callback->Resolve(info);
+  }
+}
+
+void CachedSettingsManager::OnGetRejected(const nsAString& aName,
+                                          nsISettingError* aError) {
+  UniquePtr<PendingGet> pending;
+  mPendingGets.Remove(aName, &pending);
+  if (!pending) {
+    return;
+  }
+  for (nsISettingsGetResponse* callback : pending->mCallbacks) {
+    callback->Reject(aError);
+  }
+}
+
+void CachedSettingsManager::OnSettingsFetched(
+    const nsTArray<RefPtr<nsISettingInfo>>& aSettings) {
+  for (nsISettingInfo* info : aSettings) {
+    if (!info) {
+      continue;
+    }
+    nsAutoString name;
+    info->GetName(name);
+    if (mPendingGets.Contains(name)) {
+      // That get will fill it in.
+      continue;
+    }
+    nsAutoString value;
+    info->GetValue(value);
+    mValues.LookupOrInsert(name, value);
+  }
+}
+
+void CachedSettingsManager::OnSettingChanged(nsISettingInfo* aInfo) {
+  nsAutoString name;
+  nsAutoString value;
+  aInfo->GetName(name);
+  aInfo->GetValue(value);
+  LOG("Setting %s changed", NS_ConvertUTF16toUTF8(name).get());
+
+  mValues.InsertOrUpdate(name, value);
+  if (auto pending = mPendingGets.Lookup(name)) {
+    (*pending)->mStale = true;
+  }
+}
+
+NS_IMETHODIMP
+CachedSettingsManager::Set(const nsTArray<RefPtr<nsISettingInfo>>& aSettings,
+                           nsISidlDefaultResponse* aCallback) {
+  // The write may still fail, so rather than guessing, forget what we have
+  // and let the change event tell us the new value.
+  for (nsISettingInfo* info : aSettings) {
+    if (info) {
+      nsAutoString name;
+      info->GetName(name);
+      mValues.Remove(name);
+    }
+  }
+  return mInner->Set(aSettings, aCallback);
+}
+
+NS_IMETHODIMP
+CachedSettingsManager::GetBatch(const nsTArray<nsString>& aNames,
+                                nsISettingsGetBatchResponse* aCallback) {
+  nsCOMPtr<nsISettingsGetBatchResponse> callback =
+      new FillBatchResponse(this, aCallback);
+  return mInner->GetBatch(aNames, callback);
+}
+
+NS_IMETHODIMP
+CachedSettingsManager::AddObserver(const nsAString& aName,
+                                   nsISettingsObserver* aObserver,
+                                   nsISidlDefaultResponse* aCallback) {
+  return mInner->AddObserver(aName, aObserver, aCallback);
+}
+
+NS_IMETHODIMP
+CachedSettingsManager::RemoveObserver(const nsAString& aName,
+                                      nsISettingsObserver* aObserver,
+                                      nsISidlDefaultResponse* aCallback) {
+  return mInner->RemoveObserver(aName, aObserver, aCallback);
+}
+
+NS_IMETHODIMP
+CachedSettingsManager::AddEventListener(int32_t aEvent,
+                                        nsISidlEventListener* aListener) {
+  return mInner->AddEventListener(aEvent, aListener);
+}
+
+NS_IMETHODIMP
+CachedSettingsManager::RemoveEventListener(int32_t aEvent,
+                                           nsISidlEventListener* aListener) {
+  return mInner->RemoveEventListener(aEvent, aListener);
+}
+
+}  // namespace mozilla
@@ -0,0 +1,72 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef CachedSettingsManager_h
+#define CachedSettingsManager_h
+
+#include "mozilla/UniquePtr.h"
+#include "nsCOMPtr.h"
+#include "nsHashKeys.h"
+#include "nsISettings.h"
+#include "nsString.h"
+#include "nsTArray.h"
+#include "nsTHashMap.h"
+
+namespace mozilla {
+
+/**
+ * Sits in front of the settings manager implemented by the api-daemon
+ * bridge and answers get() for settings it has already seen without a round
+ * trip to the daemon.
+ *
+ * The cache is kept current by the manager's change event, which the daemon
+ * sends for every setting written by anyone. Concurrent gets of a setting
+ * that isn't cached yet share one request. The settings listed in the
+ * b2g.settings.cache.prefetch pref are fetched in one batch up front.
+ *
+ * Main thread only.
+ */
+class CachedSettingsManager final : public nsISettingsManager {
+ public:
+  NS_DECL_ISUPPORTS
+  NS_DECL_NSISETTINGSMANAGER
+
+  static already_AddRefed<nsISettingsManager> Create(
+      nsISettingsManager* aInner);
+
+  void OnGetResolved(const nsAString& aName, nsISettingInfo* aInfo);
+  void OnGetRejected(const nsAString& aName, nsISettingError* aError);
+  void OnSettingsFetched(const nsTArray<RefPtr<nsISettingInfo>>& aSettings);
+  void OnSettingChanged(nsISettingInfo* aInfo);
+
+ private:
+  class ChangeListener;
+
+  struct PendingGet {
+    nsTArray<nsCOMPtr<nsISettingsGetResponse>> mCallbacks;
+    // Set if the setting changed while the request was in flight, in which
+    // case its answer may be older than what the change event told us.
+    bool mStale = false;
+  };
+
+  explicit CachedSettingsManager(nsISettingsManager* aInner);
+  ~CachedSettingsManager();
+
+  void Prefetch();
+
+  nsCOMPtr<nsISettingsManager> mInner;
+  RefPtr<ChangeListener> mChangeListener;
+
+  nsTHashMap<nsStringHashKey, nsString> mValues;
+  nsTHashMap<nsStringHashKey, UniquePtr<PendingGet>> mPendingGets;
+
+  uint32_t mHits;
+  uint32_t mMisses;
+};
+
+}  // namespace mozilla
+
+#endif  // CachedSettingsManager_h
@@ -62,18 +62,14 @@ NS_IMETHODIMP
 PreferenceDelegateService::GetChar(const nsAString& key, nsAString& value) {
 
   nsAutoCString nKey;
-  nsAutoString nValue;
   LossyCopyUTF16toASCII(key, nKey);
 
-  nsresult rv = Preferences::GetString(nKey.get(), nValue);
+  // Read straight into the caller's string; settings dumps can be large.
+  nsresult rv = Preferences::GetString(nKey.get(), value);
   if (NS_WARN_IF(NS_FAILED(rv))) {
     return NS_ERROR_FAILURE;
   }
 
-  if (!nValue.IsEmpty()) {
-    value.Assign(nValue);
-  }
-
   return NS_OK;
 }
 
@@ -106,9 +102,7 @@ NS_IMETHODIMP
 PreferenceDelegateService::SetChar(const nsAString& key, const nsAString& value) {
 
   nsAutoCString nKey;
-  nsAutoCString nValue;
   LossyCopyUTF16toASCII(key, nKey);
-  LossyCopyUTF16toASCII(value, nValue);
 
   return Preferences::SetString(nKey.get(), value);
 }
@@ -3,6 +3,8 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "nsCOMPtr.h"
+#include "CachedSettingsManager.h"
+#include "mozilla/Preferences.h"
 #include "SidlComponents.h"
 
 namespace {
@@ -29,6 +31,9 @@ already_AddRefed<nsIGeckoBridge> ConstructGeckoBridge() {
 already_AddRefed<nsISettingsManager> ConstructSettingsManager() {
   nsCOMPtr<nsISettingsManager> manager;
   settings_manager_construct(getter_AddRefs(manager));
+  if (mozilla::Preferences::GetBool("b2g.settings.cache.enabled", false)) {
+    return mozilla::CachedSettingsManager::Create(manager);
+  }
   return manager.forget();
 }
 
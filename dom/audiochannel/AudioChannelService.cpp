@@ -9,6 +9,7 @@
 #include "base/basictypes.h"
 
 #include "mozilla/Services.h"
+#include "mozilla/StaticPrefs_dom.h"
 #include "mozilla/StaticPtr.h"
 #include "mozilla/Unused.h"
 #include "mozilla/dom/Document.h"
@@ -41,6 +42,9 @@ namespace {
 
 bool sXPCOMShuttingDown = false;
 
+// mRemoteActiveChannels until the parent has sent the active channels.
+const uint32_t kUnknownActiveChannels = UINT32_MAX;
+
 class NotifyChannelActiveRunnable final : public Runnable {
  public:
   NotifyChannelActiveRunnable(uint64_t aWindowID, AudioChannel aAudioChannel,
@@ -224,6 +228,65 @@ static const nsAttrValue::EnumTable kMozAudioChannelAttributeTable[] = {
     {"system", (int16_t)AudioChannel::System},
     {nullptr, 0}};
 
+// Indexed by the active channel, then by the new one.
+static AudioChannelService::CompetitionRule
+    sCompetitionRules[NUMBER_OF_AUDIO_CHANNELS][NUMBER_OF_AUDIO_CHANNELS];
+
+// The higher the rank, the more important the channel. System and public
+// notification sounds have no rank: they mix with everything.
+static int32_t CompetitionRank(AudioChannel aChannel) {
+  switch (aChannel) {
+    case AudioChannel::Normal:
+    case AudioChannel::Content:
+      return 0;
+    case AudioChannel::Notification:
+      return 1;
+    case AudioChannel::Alarm:
+      return 2;
+    case AudioChannel::Ringer:
+      return 3;
+    case AudioChannel::Telephony:
+      return 4;
+    default:
+      return -1;
+  }
+}
+
+static AudioChannelService::CompetitionRule ComputeCompetitionRule(
+    AudioChannel aActive, AudioChannel aNew) {
+  int32_t activeRank = CompetitionRank(aActive);
+  int32_t newRank = CompetitionRank(aNew);
+  if (activeRank < 0 || newRank < 0) {
+    return AudioChannelService::eMix;
+  }
+
+  if (newRank == activeRank) {
+    // Only one piece of content plays at a time, the latest one.
+    return activeRank == 0 ? AudioChannelService::eSuspendActive
+                           : AudioChannelService::eMix;
+  }
+
+  if (newRank < activeRank) {
+    // Content may start under a notification, nothing else may start under
+    // a more important channel.
+    return activeRank == 1 ? AudioChannelService::eMix
+                           : AudioChannelService::eRejectNew;
+  }
+
+  // Notifications duck content, everything else suspends it.
+  return activeRank == 0 && newRank == 1 ? AudioChannelService::eDuckActive
+                                         : AudioChannelService::eSuspendActive;
+}
+
+static void InitCompetitionRules() {
+  for (uint32_t i = 0; i < NUMBER_OF_AUDIO_CHANNELS; ++i) {
+    for (uint32_t j = 0; j < NUMBER_OF_AUDIO_CHANNELS; ++j) {
+      sCompetitionRules[i][j] = ComputeCompetitionRule(
+          static_cast<AudioChannel>(i), static_cast<AudioChannel>(j));
+    }
+  }
+}
+
 /* static */
 void AudioChannelService::CreateServiceIfNeeded() {
   MOZ_ASSERT(NS_IsMainThread());
@@ -259,6 +322,14 @@ LogModule* AudioChannelService::GetAudioChannelLog() {
   return gAudioChannelLog;
 }
 
+/* static */
+AudioChannelService::CompetitionRule AudioChannelService::GetCompetitionRule(
+    AudioChannel aActive, AudioChannel aNew) {
+  CreateServiceIfNeeded();
+  return sCompetitionRules[static_cast<uint32_t>(aActive)]
+                          [static_cast<uint32_t>(aNew)];
+}
+
 /* static */
 void AudioChannelService::Shutdown() {
   if (gAudioChannelService) {
@@ -322,7 +393,11 @@ AudioChannelService::AudioChannelService()
     : mDefChannelChildID(hal::CONTENT_PROCESS_ID_UNKNOWN),
       mTelephonyChannel(false),
       mContentOrNormalChannel(false),
-      mAnyChannel(false) {
+      mAnyChannel(false),
+      mActiveChannels(0),
+      mRemoteActiveChannels(kUnknownActiveChannels) {
+  InitCompetitionRules();
+
   nsCOMPtr<nsIObserverService> obs = mozilla::services::GetObserverService();
   if (obs) {
     obs->AddObserver(this, "xpcom-shutdown", false);
@@ -350,6 +425,7 @@ void AudioChannelService::RegisterAudioChannelAgent(AudioChannelAgent* aAgent,
   // callback function of AudioChannelAgentOwner that means the agent might be
   // released in their callback.
   RefPtr<AudioChannelAgent> kungFuDeathGrip(aAgent);
+  MaybeApplyLocalPolicy(aAgent);
   winData->AppendAgent(aAgent, aAudible);
 
   MaybeSendStatusUpdate();
@@ -370,6 +446,12 @@ void AudioChannelService::UnregisterAudioChannelAgent(
   RefPtr<AudioChannelAgent> kungFuDeathGrip(aAgent);
   winData->RemoveAgent(aAgent);
 
+  int32_t channel = aAgent->AudioChannelType();
+  if (!winData->mChannels[channel].mNumberOfAgents) {
+    winData->mChannels[channel].mSuspendFromParent = false;
+    MaybeRestoreDuckedChannels(static_cast<AudioChannel>(channel));
+  }
+
 #ifdef MOZ_WIDGET_GONK
   bool active = AnyAudioChannelIsActive(false);
   for (auto* service : mSpeakerManagerServices) {
@@ -402,7 +484,7 @@ AudioPlaybackConfig AudioChannelService::GetMediaConfig(
   if (window) {
     AudioChannelWindow* winData = GetWindowData(window->WindowID());
     if (winData) {
-      config.mVolume = winData->mChannels[aAudioChannel].mVolume;
+      config.mVolume = winData->mChannels[aAudioChannel].Volume();
       config.mMuted = winData->mChannels[aAudioChannel].mMuted;
       config.mSuspend = winData->mChannels[aAudioChannel].mSuspend;
     }
@@ -426,7 +508,7 @@ AudioPlaybackConfig AudioChannelService::GetMediaConfig(
   do {
     winData = GetWindowData(window->WindowID());
     if (winData) {
-      config.mVolume *= winData->mChannels[aAudioChannel].mVolume;
+      config.mVolume *= winData->mChannels[aAudioChannel].Volume();
       config.mMuted = config.mMuted || winData->mChannels[aAudioChannel].mMuted;
       config.mCapturedAudio = winData->mIsAudioCaptured;
     }
@@ -624,6 +706,7 @@ AudioChannelService::Observe(nsISupports* aSubject, const char* aTopic,
     }
 
     RemoveChildStatus(childID);
+    MaybeBroadcastActiveChannels();
   }
 
   return NS_OK;
@@ -872,6 +955,7 @@ bool AudioChannelService::SetAudioChannelVolume(nsPIDOMWindowOuter* aWindow,
   AudioChannelConfig* config = GetChannelConfig(aWindow, aChannel);
   config->mVolume = aVolume;
   config->mMuted = aMuted;
+  config->mDuckedBy = 0;
   RefreshAgentsVolumeAndPropagate(aWindow, aChannel, aVolume, aMuted);
   return true;
 }
@@ -891,7 +975,12 @@ bool AudioChannelService::SetAudioChannelSuspend(nsPIDOMWindowOuter* aWindow,
            "type = %" PRIu32 ", suspend = %" PRIu32 "\n",
            aWindow, static_cast<uint32_t>(aChannel), aSuspend));
 
-  GetChannelConfig(aWindow, aChannel)->mSuspend = aSuspend;
+  AudioChannelConfig* config = GetChannelConfig(aWindow, aChannel);
+  config->mSuspend = aSuspend;
+  config->mSuspendFromParent = true;
+  if (aSuspend != nsISuspendedTypes::NONE_SUSPENDED) {
+    MaybeRestoreDuckedChannels(aChannel);
+  }
   MaybeSendStatusUpdate();
   RefreshAgentsSuspendAndPropagate(aWindow, aChannel, aSuspend);
   return true;
@@ -975,36 +1064,41 @@ void AudioChannelService::SetDefaultVolumeControlChannelInternal(
 
 void AudioChannelService::MaybeSendStatusUpdate() {
   if (XRE_IsParentProcess()) {
+    MaybeBroadcastActiveChannels();
     return;
   }
 
   bool telephonyChannel = TelephonyChannelIsActive();
   bool contentOrNormalChannel = ContentOrNormalChannelIsActive();
   bool anyChannel = AnyAudioChannelIsActive();
+  uint32_t activeChannels = ActiveChannels();
 
   if (telephonyChannel == mTelephonyChannel &&
       contentOrNormalChannel == mContentOrNormalChannel &&
-      anyChannel == mAnyChannel) {
+      anyChannel == mAnyChannel && activeChannels == mActiveChannels) {
     return;
   }
 
   mTelephonyChannel = telephonyChannel;
   mContentOrNormalChannel = contentOrNormalChannel;
   mAnyChannel = anyChannel;
+  mActiveChannels = activeChannels;
 
   ContentChild* cc = ContentChild::GetSingleton();
   if (cc) {
     cc->SendAudioChannelServiceStatus(telephonyChannel, contentOrNormalChannel,
-                                      anyChannel);
+                                      anyChannel, activeChannels);
   }
 }
 
 void AudioChannelService::ChildStatusReceived(uint64_t aChildID,
                                               bool aTelephonyChannel,
                                               bool aContentOrNormalChannel,
-                                              bool aAnyChannel) {
+                                              bool aAnyChannel,
+                                              uint32_t aActiveChannels) {
   if (!aAnyChannel) {
     RemoveChildStatus(aChildID);
+    MaybeBroadcastActiveChannels();
     return;
   }
 
@@ -1016,6 +1110,129 @@ void AudioChannelService::ChildStatusReceived(uint64_t aChildID,
 
   data->mActiveTelephonyChannel = aTelephonyChannel;
   data->mActiveContentOrNormalChannel = aContentOrNormalChannel;
+  data->mActiveChannels = aActiveChannels;
+  MaybeBroadcastActiveChannels();
+}
+
+void AudioChannelService::ActiveChannelsReceived(uint32_t aActiveChannels) {
+  MOZ_ASSERT(!XRE_IsParentProcess());
+  mRemoteActiveChannels = aActiveChannels;
+}
+
+uint32_t AudioChannelService::ActiveChannels() {
+  uint32_t activeChannels = 0;
+  nsTObserverArray<UniquePtr<AudioChannelWindow>>::ForwardIterator iter(
+      mWindows);
+  while (iter.HasMore()) {
+    auto& next = iter.GetNext();
+    for (uint32_t i = 0; i < NUMBER_OF_AUDIO_CHANNELS; ++i) {
+      if (next->IsChannelActive(static_cast<AudioChannel>(i))) {
+        activeChannels |= 1 << i;
+      }
+    }
+  }
+  return activeChannels;
+}
+
+void AudioChannelService::MaybeBroadcastActiveChannels() {
+  MOZ_ASSERT(XRE_IsParentProcess());
+
+  if (!StaticPrefs::dom_audiochannel_local_policy_enabled()) {
+    return;
+  }
+
+  uint32_t activeChannels = ActiveChannels();
+  nsTObserverArray<UniquePtr<AudioChannelChildStatus>>::ForwardIterator iter(
+      mPlayingChildren);
+  while (iter.HasMore()) {
+    activeChannels |= iter.GetNext()->mActiveChannels;
+  }
+
+  if (activeChannels == mActiveChannels) {
+    return;
+  }
+  mActiveChannels = activeChannels;
+
+  for (auto* cp : ContentParent::AllProcesses(ContentParent::eLive)) {
+    Unused << cp->SendActiveAudioChannelsChanged(activeChannels);
+  }
+}
+
+void AudioChannelService::MaybeApplyLocalPolicy(AudioChannelAgent* aAgent) {
+  if (XRE_IsParentProcess() ||
+      !StaticPrefs::dom_audiochannel_local_policy_enabled() ||
+      mRemoteActiveChannels == kUnknownActiveChannels) {
+    return;
+  }
+
+  AudioChannelWindow* winData = GetWindowData(aAgent->WindowID());
+  MOZ_ASSERT(winData);
+
+  // Only the first agent of a channel still suspended by default.
+  uint32_t channel = aAgent->AudioChannelType();
+  AudioChannelConfig& config = winData->mChannels[channel];
+  if (config.mNumberOfAgents || config.mSuspendFromParent ||
+      config.mSuspend != nsISuspendedTypes::SUSPENDED_BLOCK) {
+    return;
+  }
+
+  // Suspending a channel, here or in another process, is left to the parent.
+  uint32_t activeChannels = mRemoteActiveChannels | ActiveChannels();
+  for (uint32_t i = 0; i < NUMBER_OF_AUDIO_CHANNELS; ++i) {
+    if (!(activeChannels & (1 << i))) {
+      continue;
+    }
+    CompetitionRule rule = sCompetitionRules[i][channel];
+    if (rule == eSuspendActive || rule == eRejectNew) {
+      return;
+    }
+  }
+
+  MOZ_LOG(GetAudioChannelLog(), LogLevel::Debug,
+          ("AudioChannelService, MaybeApplyLocalPolicy, window = %" PRIu64
+           ", type = %" PRIu32 "\n",
+           winData->mWindowID, channel));
+
+  config.mSuspend = nsISuspendedTypes::NONE_SUSPENDED;
+
+  nsTObserverArray<UniquePtr<AudioChannelWindow>>::ForwardIterator iter(
+      mWindows);
+  while (iter.HasMore()) {
+    auto& next = iter.GetNext();
+    for (uint32_t i = 0; i < NUMBER_OF_AUDIO_CHANNELS; ++i) {
+      if (sCompetitionRules[i][channel] != eDuckActive ||
+          !next->IsChannelActive(static_cast<AudioChannel>(i))) {
+        continue;
+      }
+      bool wasDucked = next->mChannels[i].mDuckedBy;
+      next->mChannels[i].mDuckedBy |= 1 << channel;
+      if (!wasDucked) {
+        next->RefreshVolume(static_cast<AudioChannel>(i));
+      }
+    }
+  }
+}
+
+void AudioChannelService::MaybeRestoreDuckedChannels(AudioChannel aChannel) {
+  uint32_t bit = 1 << static_cast<uint32_t>(aChannel);
+  if (ActiveChannels() & bit) {
+    return;
+  }
+
+  nsTObserverArray<UniquePtr<AudioChannelWindow>>::ForwardIterator iter(
+      mWindows);
+  while (iter.HasMore()) {
+    auto& next = iter.GetNext();
+    for (uint32_t i = 0; i < NUMBER_OF_AUDIO_CHANNELS; ++i) {
+      if (!(next->mChannels[i].mDuckedBy & bit)) {
+        continue;
+      }
+      next->mChannels[i].mDuckedBy &= ~bit;
+      if (!next->mChannels[i].mDuckedBy) {
+        next->RefreshVolume(static_cast<AudioChannel>(i));
+      }
+    }
+  }
 }
 
 void AudioChannelService::NotifyMediaResumedFromBlock(
@@ -1035,6 +1252,13 @@ void AudioChannelService::NotifyMediaResumedFromBlock(
   winData->NotifyMediaBlockStop(aWindow);
 }
 
+float AudioChannelService::AudioChannelConfig::Volume() const {
+  if (!mDuckedBy) {
+    return mVolume;
+  }
+  return mVolume * StaticPrefs::dom_audiochannel_local_policy_duck_volume();
+}
+
 /* static */
 nsSuspendedTypes AudioChannelService::InitialSuspendType() {
   CreateServiceIfNeeded();
@@ -1089,6 +1313,17 @@ bool AudioChannelService::AudioChannelWindow::IsChannelActive(
          mChannels[channel].mSuspend == nsISuspendedTypes::NONE_SUSPENDED;
 }
 
+void AudioChannelService::AudioChannelWindow::RefreshVolume(
+    AudioChannel aChannel) {
+  const AudioChannelConfig& config =
+      mChannels[static_cast<uint32_t>(aChannel)];
+  for (AudioChannelAgent* agent : mAgents.ForwardRange()) {
+    if (agent->AudioChannelType() == static_cast<int32_t>(aChannel)) {
+      agent->WindowVolumeChanged(config.Volume(), config.mMuted);
+    }
+  }
+}
+
 void AudioChannelService::AudioChannelWindow::AppendAgentAndIncreaseAgentsNum(
     AudioChannelAgent* aAgent) {
   MOZ_ASSERT(aAgent);
@@ -115,6 +115,20 @@ class AudioChannelService final : public nsIObserver {
     ePauseStateChanged = 2
   };
 
+  /**
+   * What happens to an active channel when another one starts playing.
+   * eMix : both keep playing
+   * eDuckActive : the active channel keeps playing at a lower volume
+   * eSuspendActive : the active channel is suspended
+   * eRejectNew : the new channel is suspended until the active one stops
+   */
+  enum CompetitionRule : uint8_t {
+    eMix = 0,
+    eDuckActive = 1,
+    eSuspendActive = 2,
+    eRejectNew = 3
+  };
+
   /**
    * Returns the AudioChannelServce singleton.
    * If AudioChannelService doesn't exist, create and return new one.
@@ -132,6 +146,14 @@ class AudioChannelService final : public nsIObserver {
 
   static LogModule* GetAudioChannelLog();
 
+  /**
+   * Returns the rule applied when aNew starts while aActive is playing. The
+   * rules for every pair of channels are computed once, when the service is
+   * created.
+   */
+  static CompetitionRule GetCompetitionRule(AudioChannel aActive,
+                                            AudioChannel aNew);
+
   static bool IsEnableAudioCompeting();
 
   static already_AddRefed<nsPIDOMWindowOuter> GetTopAppWindow(
@@ -255,7 +277,14 @@ class AudioChannelService final : public nsIObserver {
   void Notify(uint64_t aWindowID);
 
   void ChildStatusReceived(uint64_t aChildID, bool aTelephonyChannel,
-                           bool aContentOrNormalChannel, bool aAnyChannel);
+                           bool aContentOrNormalChannel, bool aAnyChannel,
+                           uint32_t aActiveChannels);
+
+  /**
+   * Called in the content processes with the channels active in any process,
+   * as a bitmask indexed by AudioChannel.
+   */
+  void ActiveChannelsReceived(uint32_t aActiveChannels);
 
   void NotifyMediaResumedFromBlock(nsPIDOMWindowOuter* aWindow);
 
@@ -277,6 +306,26 @@ class AudioChannelService final : public nsIObserver {
 
   bool ContentOrNormalChannelIsActive();
 
+  // Returns the channels active in this process as a bitmask indexed by
+  // AudioChannel.
+  uint32_t ActiveChannels();
+
+  // Sends the channels active in any process to the content processes, when
+  // they have changed. Only called in the parent process.
+  void MaybeBroadcastActiveChannels();
+
+  // When dom.audiochannel.local_policy.enabled is set, lets the first agent
+  // of a channel play in a content process without waiting for the parent,
+  // as long as that doesn't suspend any active channel. Channels which the
+  // new one ducks are ducked right away if they play in this process. The
+  // parent's decision arrives later through SetAudioChannelSuspend() and
+  // SetAudioChannelVolume() and always wins.
+  void MaybeApplyLocalPolicy(AudioChannelAgent* aAgent);
+
+  // Undoes the local ducking done for aChannel once it stopped playing in
+  // this process.
+  void MaybeRestoreDuckedChannels(AudioChannel aChannel);
+
   /* Send the default-volume-channel-changed notification */
   void SetDefaultVolumeControlChannelInternal(int32_t aChannel, bool aVisible,
                                               uint64_t aChildID);
@@ -287,9 +336,21 @@ class AudioChannelService final : public nsIObserver {
    public:
     AudioChannelConfig()
         : AudioPlaybackConfig(1.0, false, InitialSuspendType()),
-          mNumberOfAgents(0) {}
+          mNumberOfAgents(0),
+          mDuckedBy(0),
+          mSuspendFromParent(false) {}
+
+    // The volume to play at, including any local ducking.
+    float Volume() const;
 
     uint32_t mNumberOfAgents;
+
+    // Channels which ducked this one locally, see MaybeApplyLocalPolicy().
+    uint32_t mDuckedBy;
+
+    // Whether the parent has decided on the suspend state since the channel
+    // last stopped playing.
+    bool mSuspendFromParent;
   };
 
   class AudioChannelWindow final {
@@ -309,6 +370,8 @@ class AudioChannelService final : public nsIObserver {
 
     bool IsChannelActive(AudioChannel aChannel);
 
+    void RefreshVolume(AudioChannel aChannel);
+
     uint64_t mWindowID;
     bool mIsAudioCaptured;
     AudioChannelConfig mChannels[NUMBER_OF_AUDIO_CHANNELS];
@@ -354,11 +417,13 @@ class AudioChannelService final : public nsIObserver {
     explicit AudioChannelChildStatus(uint64_t aChildID)
         : mChildID(aChildID),
           mActiveTelephonyChannel(false),
-          mActiveContentOrNormalChannel(false) {}
+          mActiveContentOrNormalChannel(false),
+          mActiveChannels(0) {}
 
     uint64_t mChildID;
     bool mActiveTelephonyChannel;
     bool mActiveContentOrNormalChannel;
+    uint32_t mActiveChannels;
   };
 
   AudioChannelChildStatus* GetChildStatus(uint64_t aChildID) const;
@@ -386,6 +451,15 @@ class AudioChannelService final : public nsIObserver {
   bool mContentOrNormalChannel;
   bool mAnyChannel;
 
+  // In the content processes, the channels active here as last sent to the
+  // parent. In the parent, the channels active in any process as last sent to
+  // the content processes.
+  uint32_t mActiveChannels;
+
+  // In the content processes, the channels active in any process as last
+  // received from the parent.
+  uint32_t mRemoteActiveChannels;
+
   // This is needed for IPC comunication between
   // AudioChannelServiceChild and this class.
   friend class ContentParent;
@@ -14,9 +14,11 @@
 #include "MainThreadUtils.h"
 #include "mozilla/dom/bluetooth/BluetoothCommon.h"
 #include "mozilla/Services.h"
+#include "mozilla/StaticPrefs_bluetooth.h"
 #include "mozilla/StaticPtr.h"
 #include "nsTHashMap.h"
 #include "nsIObserverService.h"
+#include "nsITimer.h"
 #include "nsThreadUtils.h"
 
 #define ENSURE_GATT_INTF_IS_READY_VOID(runnable)                               \
@@ -55,6 +57,21 @@ static StaticAutoPtr<nsTArray<RefPtr<BluetoothGattServer> > > sServers;
 static StaticAutoPtr<nsTArray<RefPtr<BluetoothGattScanner> > > sScanners;
 static StaticAutoPtr<nsTArray<RefPtr<BluetoothGattAdvertiser> > > sAdvertisers;
 
+struct BluetoothGattScanResult {
+  int32_t mRssi;
+  nsTArray<uint8_t> mAdvData;
+};
+
+// Scan results waiting for the end of the current coalescing window, and
+// the type of every device seen since scanning started.
+static StaticAutoPtr<
+    nsTHashMap<BluetoothAddressHashKey, BluetoothGattScanResult> >
+    sPendingScanResults;
+static StaticAutoPtr<
+    nsTHashMap<BluetoothAddressHashKey, BluetoothTypeOfDevice> >
+    sScanDeviceTypes;
+static StaticRefPtr<nsITimer> sScanResultTimer;
+
 struct BluetoothGattClientReadCharState {
   bool mAuthRetry;
   RefPtr<BluetoothReplyRunnable> mRunnable;
@@ -778,6 +795,9 @@ class BluetoothGattManager::UnregisterScannerResultHandler final
     mScanner->mUnregisterScannerRunnable = nullptr;
 
     sScanners->RemoveElement(mScanner);
+    if (sScanners->IsEmpty()) {
+      ClearScanResults();
+    }
   }
 
   void OnError(BluetoothStatus aStatus) override {
@@ -2477,45 +2497,92 @@ void BluetoothGattManager::RegisterAdvertiserNotification(
   }
 }
 
+static void DistributeSignalDeviceFound(const BluetoothAddress& aBdAddr,
+                                        int32_t aRssi,
+                                        const nsTArray<uint8_t>& aAdvData,
+                                        BluetoothTypeOfDevice aType) {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  nsTArray<BluetoothNamedValue> properties;
+
+  AppendNamedValue(properties, "Address", aBdAddr);
+  AppendNamedValue(properties, "Rssi", aRssi);
+  AppendNamedValue(properties, "GattAdv", aAdvData);
+  AppendNamedValue(properties, "Type", static_cast<uint32_t>(aType));
+
+  BluetoothService* bs = BluetoothService::Get();
+  NS_ENSURE_TRUE_VOID(bs);
+
+  bs->DistributeSignal(u"LeDeviceFound"_ns, KEY_ADAPTER,
+                       BluetoothValue(properties));
+}
+
 class BluetoothGattManager::ScanDeviceTypeResultHandler final
     : public BluetoothGattResultHandler {
  public:
-  ScanDeviceTypeResultHandler(const BluetoothAddress& aBdAddr, int aRssi,
-                              const BluetoothGattAdvData& aAdvData)
-      : mBdAddr(aBdAddr), mRssi(static_cast<int32_t>(aRssi)) {
-    mAdvData.AppendElements(aAdvData.mAdvData, sizeof(aAdvData.mAdvData));
-  }
+  ScanDeviceTypeResultHandler(const BluetoothAddress& aBdAddr,
+                              BluetoothGattScanResult&& aResult)
+      : mBdAddr(aBdAddr), mResult(std::move(aResult)) {}
 
   void GetDeviceType(BluetoothTypeOfDevice type) override {
-    DistributeSignalDeviceFound(type);
+    // Remember the type, so later results from this device don't need
+    // another round trip to the daemon.
+    if (sScanDeviceTypes) {
+      sScanDeviceTypes->InsertOrUpdate(mBdAddr, type);
+    }
+    DistributeSignalDeviceFound(mBdAddr, mResult.mRssi, mResult.mAdvData,
+                                type);
   }
 
   void OnError(BluetoothStatus aStatus) override {
-    DistributeSignalDeviceFound(TYPE_OF_DEVICE_BLE);
+    DistributeSignalDeviceFound(mBdAddr, mResult.mRssi, mResult.mAdvData,
+                                TYPE_OF_DEVICE_BLE);
   }
 
  private:
-  void DistributeSignalDeviceFound(BluetoothTypeOfDevice type) {
-    MOZ_ASSERT(NS_IsMainThread());
+  BluetoothAddress mBdAddr;
+  BluetoothGattScanResult mResult;
+};
 
-    nsTArray<BluetoothNamedValue> properties;
+void BluetoothGattManager::FlushScanResults() {
+  MOZ_ASSERT(NS_IsMainThread());
 
-    AppendNamedValue(properties, "Address", mBdAddr);
-    AppendNamedValue(properties, "Rssi", mRssi);
-    AppendNamedValue(properties, "GattAdv", mAdvData);
-    AppendNamedValue(properties, "Type", static_cast<uint32_t>(type));
+  sScanResultTimer = nullptr;
 
-    BluetoothService* bs = BluetoothService::Get();
-    NS_ENSURE_TRUE_VOID(bs);
+  if (!sPendingScanResults || sPendingScanResults->IsEmpty()) {
+    return;
+  }
 
-    bs->DistributeSignal(u"LeDeviceFound"_ns, KEY_ADAPTER,
-                         BluetoothValue(properties));
+  nsTHashMap<BluetoothAddressHashKey, BluetoothGattScanResult> results;
+  results.SwapElements(*sPendingScanResults);
+
+  for (auto iter = results.Iter(); !iter.Done(); iter.Next()) {
+    BluetoothTypeOfDevice type;
+    if (sScanDeviceTypes->Get(iter.Key(), &type)) {
+      DistributeSignalDeviceFound(iter.Key(), iter.Data().mRssi,
+                                  iter.Data().mAdvData, type);
+      continue;
+    }
+
+    // Distribute "LeDeviceFound" signal after we know the corresponding
+    // BluetoothTypeOfDevice of the device
+    NS_ENSURE_TRUE_VOID(sBluetoothGattInterface);
+    sBluetoothGattInterface->GetDeviceType(
+        iter.Key(),
+        new ScanDeviceTypeResultHandler(iter.Key(), std::move(iter.Data())));
   }
+}
 
-  BluetoothAddress mBdAddr;
-  int32_t mRssi;
-  nsTArray<uint8_t> mAdvData;
-};
+void BluetoothGattManager::ClearScanResults() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (sScanResultTimer) {
+    sScanResultTimer->Cancel();
+    sScanResultTimer = nullptr;
+  }
+  sPendingScanResults = nullptr;
+  sScanDeviceTypes = nullptr;
+}
 
 void BluetoothGattManager::ScanResultNotification(
     const BluetoothAddress& aBdAddr, int aRssi,
@@ -2524,10 +2591,47 @@ void BluetoothGattManager::ScanResultNotification(
 
   NS_ENSURE_TRUE_VOID(sBluetoothGattInterface);
 
-  // Distribute "LeDeviceFound" signal after we know the corresponding
-  // BluetoothTypeOfDevice of the device
-  sBluetoothGattInterface->GetDeviceType(
-      aBdAddr, new ScanDeviceTypeResultHandler(aBdAddr, aRssi, aAdvData));
+  if (aRssi < StaticPrefs::bluetooth_le_scan_min_rssi()) {
+    return;
+  }
+
+  if (!sPendingScanResults) {
+    sPendingScanResults =
+        new nsTHashMap<BluetoothAddressHashKey, BluetoothGattScanResult>();
+    sScanDeviceTypes =
+        new nsTHashMap<BluetoothAddressHashKey, BluetoothTypeOfDevice>();
+  }
+
+  // Devices advertise many times a second. Only the latest result of each
+  // device within a coalescing window is passed on.
+  BluetoothGattScanResult& result =
+      sPendingScanResults->LookupOrInsert(aBdAddr);
+  result.mRssi = static_cast<int32_t>(aRssi);
+  result.mAdvData.ReplaceElementsAt(0, result.mAdvData.Length(),
+                                    aAdvData.mAdvData,
+                                    sizeof(aAdvData.mAdvData));
+
+  if (sScanResultTimer) {
+    return;
+  }
+
+  uint32_t delay = StaticPrefs::bluetooth_le_scan_coalesce_ms();
+  if (!delay) {
+    FlushScanResults();
+    return;
+  }
+
+  nsCOMPtr<nsITimer> timer;
+  nsresult rv = NS_NewTimerWithFuncCallback(
+      getter_AddRefs(timer),
+      [](nsITimer*, void*) { BluetoothGattManager::FlushScanResults(); },
+      nullptr, delay, nsITimer::TYPE_ONE_SHOT,
+      "BluetoothGattManager::FlushScanResults");
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    FlushScanResults();
+    return;
+  }
+  sScanResultTimer = timer;
 }
 
 void BluetoothGattManager::ConnectNotification(
@@ -3265,6 +3369,7 @@ void BluetoothGattManager::HandleShutdown() {
   sServers = nullptr;
   sScanners = nullptr;
   sAdvertisers = nullptr;
+  ClearScanResults();
 }
 
 NS_IMPL_ISUPPORTS(BluetoothGattManager, nsIObserver)
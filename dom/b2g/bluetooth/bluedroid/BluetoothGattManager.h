@@ -171,6 +171,11 @@ class BluetoothGattManager final : public nsIObserver,
   void Uninit();
   void HandleShutdown();
 
+  // Passes the scan results coalesced so far on as "LeDeviceFound".
+  static void FlushScanResults();
+  // Drops pending scan results and cached device types.
+  static void ClearScanResults();
+
   void RegisterClientNotification(BluetoothGattStatus aStatus, int aClientIf,
                                   const BluetoothUuid& aAppUuid) override;
 
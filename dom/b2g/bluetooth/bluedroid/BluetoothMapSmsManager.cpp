@@ -1043,11 +1043,12 @@ bool BluetoothMapSmsManager::ReplyToGetWithHeaderBody(
     uint32_t remainingPacketSize =
         mRemoteMaxPacketLength - kObexBodyHeaderSize - aIndex;
 
-    // Read blob data from input stream
+    // Read blob data straight into the response, behind the Body header,
+    // so only one packet of the listing or bMessage is ever held here.
     uint32_t numRead = 0;
-    auto buf = MakeUnique<char[]>(remainingPacketSize);
-    nsresult rv =
-        mMasDataStream->Read(buf.get(), remainingPacketSize, &numRead);
+    nsresult rv = mMasDataStream->Read(
+        reinterpret_cast<char*>(&aResponse[aIndex + kObexBodyHeaderSize]),
+        remainingPacketSize, &numRead);
     if (NS_FAILED(rv)) {
       BT_LOGR("Failed to read from input stream. rv=0x%x",
               static_cast<uint32_t>(rv));
@@ -1057,9 +1058,10 @@ bool BluetoothMapSmsManager::ReplyToGetWithHeaderBody(
     // |numRead| must be non-zero
     MOZ_ASSERT(numRead);
 
-    aIndex += AppendHeaderBody(&aResponse[aIndex],
-                               remainingPacketSize + kObexBodyHeaderSize,
-                               reinterpret_cast<uint8_t*>(buf.get()), numRead);
+    aResponse[aIndex] = ObexHeaderId::Body;
+    BigEndian::writeUint16(&aResponse[aIndex + 1],
+                           numRead + kObexBodyHeaderSize);
+    aIndex += numRead + kObexBodyHeaderSize;
 
     opcode = ObexResponseCode::Continue;
   }
@@ -1500,7 +1502,7 @@ void BluetoothMapSmsManager::HandleSmsMmsFolderListing(
     }
 
     nsresult rv = NS_NewCStringInputStream(getter_AddRefs(mMasDataStream),
-                                           folderListingObject);
+                                           std::move(folderListingObject));
     if (NS_FAILED(rv)) {
       BT_LOGR(
           "Failed to get internal stream from folder-listing object. rv=0x%x",
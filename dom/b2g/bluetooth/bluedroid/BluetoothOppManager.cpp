@@ -31,6 +31,7 @@
 #include "nsIVolumeService.h"
 #include "nsNetUtil.h"
 #include "nsServiceManagerUtils.h"
+#include "nsThreadUtils.h"
 
 #define TARGET_SUBDIR "downloads/Bluetooth/"
 
@@ -91,30 +92,36 @@ BluetoothOppManager::Observe(nsISupports* aSubject, const char* aTopic,
 
 class BluetoothOppManager::SendSocketDataTask final : public Runnable {
  public:
-  SendSocketDataTask(UniquePtr<uint8_t[]> aStream, uint32_t aSize)
+  SendSocketDataTask(nsIInputStream* aInputStream, UniquePtr<uint8_t[]> aPacket,
+                     int aBodyLength)
       : Runnable("SendSocketDataTask"),
-        mStream(std::move(aStream)),
-        mSize(aSize) {
+        mInputStream(aInputStream),
+        mPacket(std::move(aPacket)),
+        mBodyLength(aBodyLength) {
     MOZ_ASSERT(!NS_IsMainThread());
   }
 
   NS_IMETHOD Run() {
     MOZ_ASSERT(NS_IsMainThread());
 
-    sBluetoothOppManager->SendPutRequest(mStream.get(), mSize);
+    sBluetoothOppManager->OnFileChunkRead(mInputStream, std::move(mPacket),
+                                          mBodyLength);
 
     return NS_OK;
   }
 
  private:
-  UniquePtr<uint8_t[]> mStream;
-  uint32_t mSize;
+  nsCOMPtr<nsIInputStream> mInputStream;
+  UniquePtr<uint8_t[]> mPacket;
+  int mBodyLength;
 };
 
 class BluetoothOppManager::ReadFileTask final : public Runnable {
  public:
   ReadFileTask(nsIInputStream* aInputStream, uint32_t aRemoteMaxPacketSize)
-      : Runnable("ReadFileTask"), mInputStream(aInputStream) {
+      : Runnable("ReadFileTask"),
+        mInputStream(aInputStream),
+        mPacketSize(aRemoteMaxPacketSize) {
     MOZ_ASSERT(NS_IsMainThread());
 
     mAvailablePacketSize = aRemoteMaxPacketSize - kPutRequestHeaderSize;
@@ -123,27 +130,24 @@ class BluetoothOppManager::ReadFileTask final : public Runnable {
   NS_IMETHOD Run() {
     MOZ_ASSERT(!NS_IsMainThread());
 
+    // Read the body straight into a whole PUT packet, behind the room for its
+    // headers, so that SendPutRequest() can send it without another copy.
     uint32_t numRead;
-    auto buf = MakeUnique<uint8_t[]>(mAvailablePacketSize);
+    auto packet = MakeUnique<uint8_t[]>(mPacketSize);
 
     // function inputstream->Read() only works on non-main thread
-    nsresult rv =
-        mInputStream->Read((char*)buf.get(), mAvailablePacketSize, &numRead);
+    nsresult rv = mInputStream->Read(
+        (char*)&packet[kPutRequestHeaderSize], mAvailablePacketSize, &numRead);
     if (NS_FAILED(rv)) {
-      // Needs error handling here
       BT_WARNING("Failed to read from input stream");
-      return NS_ERROR_FAILURE;
+      packet = nullptr;
     }
 
-    if (numRead > 0) {
-      sBluetoothOppManager->CheckPutFinal(numRead);
-
-      RefPtr<SendSocketDataTask> task =
-          new SendSocketDataTask(std::move(buf), numRead);
-      if (NS_FAILED(NS_DispatchToMainThread(task))) {
-        BT_WARNING("Failed to dispatch to main thread!");
-        return NS_ERROR_FAILURE;
-      }
+    RefPtr<SendSocketDataTask> task = new SendSocketDataTask(
+        mInputStream, std::move(packet), NS_FAILED(rv) ? -1 : (int)numRead);
+    if (NS_FAILED(NS_DispatchToMainThread(task))) {
+      BT_WARNING("Failed to dispatch to main thread!");
+      return NS_ERROR_FAILURE;
     }
 
     return NS_OK;
@@ -151,6 +155,7 @@ class BluetoothOppManager::ReadFileTask final : public Runnable {
 
  private:
   nsCOMPtr<nsIInputStream> mInputStream;
+  uint32_t mPacketSize;
   uint32_t mAvailablePacketSize;
 };
 
@@ -180,6 +185,7 @@ BluetoothOppManager::BluetoothOppManager()
       mPacketLength(0),
       mPutPacketReceivedLength(0),
       mBodySegmentLength(0),
+      mUpdateProgressCounter(0),
       mNeedsUpdatingSdpRecords(false),
       mAbortFlag(false),
       mNewFileFlag(false),
@@ -191,6 +197,10 @@ BluetoothOppManager::BluetoothOppManager()
       mFileLength(0),
       mSentFileLength(0),
       mWaitingToSendPutFinal(false),
+      mPrefetchedBodyLength(0),
+      mReadPending(false),
+      mPutContinued(false),
+      mWriteFailed(false),
       mCurrentBlobIndex(-1) {}
 
 BluetoothOppManager::~BluetoothOppManager() {}
@@ -529,14 +539,14 @@ bool BluetoothOppManager::ConfirmReceivingFile(bool aConfirm) {
   if (aConfirm) {
     StartFileTransfer();
     if (CreateFile()) {
-      success = WriteToFile(mBodySegment.get(), mBodySegmentLength);
+      success = WriteToFile(std::move(mBodySegment), mBodySegmentLength);
     }
   }
 
   if (success && mPutFinalFlag) {
-    mSuccessFlag = true;
-    RestoreReceivedFileAndNotify();
-    FileTransferComplete();
+    // Replies once everything is on disk.
+    FinishReceivingFile();
+    return true;
   }
 
   ReplyToPut(mPutFinalFlag, success);
@@ -552,6 +562,9 @@ void BluetoothOppManager::AfterFirstPut() {
   mWaitingToSendPutFinal = false;
   mSuccessFlag = false;
   mBodySegmentLength = 0;
+  mPrefetchedBody = nullptr;
+  mPrefetchedBodyLength = 0;
+  mPutContinued = false;
 }
 
 void BluetoothOppManager::AfterOppConnected() {
@@ -590,10 +603,7 @@ void BluetoothOppManager::AfterOppDisconnected() {
     mInputStream = nullptr;
   }
 
-  if (mOutputStream) {
-    mOutputStream->Close();
-    mOutputStream = nullptr;
-  }
+  CloseOutputStream();
 
   // Store local pointer of |mReadFileThread| to avoid shutdown reentry crash
   // See bug 1191715 comment 19 for more details.
@@ -635,10 +645,7 @@ void BluetoothOppManager::RestoreReceivedFileAndNotify() {
 }
 
 void BluetoothOppManager::DeleteReceivedFile() {
-  if (mOutputStream) {
-    mOutputStream->Close();
-    mOutputStream = nullptr;
-  }
+  CloseOutputStream();
 
   if (mDsFile && mDsFile->mFile) {
     mDsFile->mFile->Remove(false);
@@ -716,19 +723,100 @@ bool BluetoothOppManager::CreateFile() {
   NS_NewLocalFileOutputStream(getter_AddRefs(mOutputStream), mDsFile->mFile);
   NS_ENSURE_TRUE(mOutputStream, false);
 
+  if (!mWriteTaskQueue) {
+    nsresult rv = NS_CreateBackgroundTaskQueue("OppFileWriter",
+                                               getter_AddRefs(mWriteTaskQueue));
+    NS_ENSURE_SUCCESS(rv, false);
+  }
+  mWriteFailed = false;
+
   return true;
 }
 
-bool BluetoothOppManager::WriteToFile(const uint8_t* aData, int aDataLength) {
+bool BluetoothOppManager::WriteToFile(UniquePtr<uint8_t[]> aData,
+                                      int aDataLength) {
   NS_ENSURE_TRUE(mOutputStream, false);
 
-  uint32_t wrote = 0;
-  mOutputStream->Write((const char*)aData, aDataLength, &wrote);
-  NS_ENSURE_TRUE(aDataLength == (int)wrote, false);
+  // A write that failed after we already asked for the next packet is
+  // reported on this one.
+  NS_ENSURE_FALSE(mWriteFailed, false);
+
+  if (aDataLength <= 0) {
+    return true;
+  }
+
+  // Written off the main thread, so the remote can send the next packet
+  // while this one goes to disk. The task queue keeps writes in order.
+  nsCOMPtr<nsIOutputStream> stream = mOutputStream;
+  RefPtr<BluetoothOppManager> self = this;
+  nsresult rv = mWriteTaskQueue->Dispatch(NS_NewRunnableFunction(
+      "BluetoothOppManager::WriteToFile",
+      [self, stream, data = std::move(aData), aDataLength]() {
+        uint32_t wrote = 0;
+        nsresult rv =
+            stream->Write((const char*)data.get(), aDataLength, &wrote);
+        if (NS_FAILED(rv) || aDataLength != (int)wrote) {
+          BT_WARNING("Failed to write received file");
+          self->mWriteFailed = true;
+        }
+      }));
+  NS_ENSURE_SUCCESS(rv, false);
 
   return true;
 }
 
+void BluetoothOppManager::CloseOutputStream() {
+  nsCOMPtr<nsIOutputStream> stream = std::move(mOutputStream);
+  if (!stream) {
+    return;
+  }
+
+  // Close behind any writes still queued for this stream.
+  if (!mWriteTaskQueue ||
+      NS_FAILED(mWriteTaskQueue->Dispatch(NS_NewRunnableFunction(
+          "BluetoothOppManager::CloseOutputStream",
+          [stream]() { stream->Close(); })))) {
+    stream->Close();
+  }
+}
+
+void BluetoothOppManager::FinishReceivingFile() {
+  MOZ_ASSERT(NS_IsMainThread());
+  MOZ_ASSERT(mPutFinalFlag);
+
+  // Wait for the queued writes and the close to finish before the file gets
+  // its real name and apps are told about it.
+  CloseOutputStream();
+
+  RefPtr<BluetoothOppManager> self = this;
+  RefPtr<DeviceStorageFile> dsFile = mDsFile;
+  auto afterFlush = [self, dsFile]() {
+    // Bail out if the transfer ended while we were flushing; whoever ended it
+    // has already cleaned up and notified.
+    if (self->mDsFile != dsFile) {
+      return;
+    }
+    bool success = !self->mWriteFailed;
+    if (success) {
+      self->mSuccessFlag = true;
+      self->RestoreReceivedFileAndNotify();
+    } else {
+      self->DeleteReceivedFile();
+    }
+    self->FileTransferComplete();
+    self->ReplyToPut(true, success);
+  };
+
+  if (!mWriteTaskQueue ||
+      NS_FAILED(mWriteTaskQueue->Dispatch(NS_NewRunnableFunction(
+          "BluetoothOppManager::FinishReceivingFile", [afterFlush]() {
+            NS_DispatchToMainThread(NS_NewRunnableFunction(
+                "BluetoothOppManager::AfterFileWritten", afterFlush));
+          })))) {
+    afterFlush();
+  }
+}
+
 // Virtual function of class SocketConsumer
 void BluetoothOppManager::ExtractPacketHeaders(const ObexHeaderSet& aHeader) {
   if (aHeader.Has(ObexHeaderId::Name)) {
@@ -1004,26 +1092,27 @@ void BluetoothOppManager::ServerDataHandler(UnixSocketBuffer* aMessage) {
       mNewFileFlag = false;
     }
 
-    if (!WriteToFile(mBodySegment.get(), mBodySegmentLength)) {
+    int bodyLength = mBodySegmentLength;
+    if (!WriteToFile(std::move(mBodySegment), bodyLength)) {
       ReplyToPut(mPutFinalFlag, false);
       return;
     }
 
-    ReplyToPut(mPutFinalFlag, true);
-
     // Send progress update
-    mSentFileLength += mBodySegmentLength;
+    mSentFileLength += bodyLength;
     if (mSentFileLength > kUpdateProgressBase * mUpdateProgressCounter) {
       UpdateProgress();
       mUpdateProgressCounter = mSentFileLength / kUpdateProgressBase + 1;
     }
 
-    // Success to receive a file and notify completion
+    // Success to receive a file and notify completion, replying once it's
+    // all on disk
     if (mPutFinalFlag) {
-      mSuccessFlag = true;
-      RestoreReceivedFileAndNotify();
-      FileTransferComplete();
+      FinishReceivingFile();
+      return;
     }
+
+    ReplyToPut(mPutFinalFlag, true);
   } else if (opCode == ObexRequestCode::Get ||
              opCode == ObexRequestCode::GetFinal ||
              opCode == ObexRequestCode::SetPath) {
@@ -1140,24 +1229,10 @@ void BluetoothOppManager::ClientDataHandler(UnixSocketBuffer* aMessage) {
       mUpdateProgressCounter = mSentFileLength / kUpdateProgressBase + 1;
     }
 
-    ErrorResult rv;
-    if (!mInputStream) {
-      mBlob->CreateInputStream(getter_AddRefs(mInputStream), rv);
-      if (NS_WARN_IF(rv.Failed())) {
-        SendDisconnectRequest();
-        rv.SuppressException();
-        return;
-      }
-    }
-
-    RefPtr<ReadFileTask> task =
-        new ReadFileTask(mInputStream, mRemoteMaxPacketLength);
-    rv = mReadFileThread->Dispatch(task, NS_DISPATCH_NORMAL);
-    if (NS_WARN_IF(rv.Failed())) {
-      SendDisconnectRequest();
-      rv.SuppressException();
-      return;
-    }
+    // Usually the next chunk has been read while this one was in flight.
+    mPutContinued = true;
+    MaybeSendPrefetchedBody();
+    ReadNextFileChunk();
   } else {
     BT_WARNING("Unhandled ObexRequestCode");
   }
@@ -1217,31 +1292,113 @@ void BluetoothOppManager::SendPutHeaderRequest(const nsAString& aFileName,
   uint8_t opcode =
       (aFileSize > 0) ? ObexRequestCode::Put : ObexRequestCode::PutFinal;
   SendObexData(std::move(req), opcode, index);
+
+  // Start reading the body while the remote looks at the headers.
+  if (aFileSize > 0) {
+    ReadNextFileChunk();
+  }
 }
 
-void BluetoothOppManager::SendPutRequest(uint8_t* aFileBody,
-                                         int aFileBodyLength) {
+void BluetoothOppManager::SendPutRequest(UniquePtr<uint8_t[]> aPacket,
+                                         int aBodyLength) {
   if (!mConnected) {
     return;
   }
 
   int packetLeftSpace = mRemoteMaxPacketLength - kPutRequestHeaderSize;
-  if (aFileBodyLength > packetLeftSpace) {
+  if (aBodyLength > packetLeftSpace) {
     BT_WARNING("Not allowed such a small MaxPacketLength value");
     return;
   }
 
   // Section 3.3.3 "Put", IrOBEX 1.2
   // [opcode:1][length:2][Headers:var]
-  auto req = MakeUnique<uint8_t[]>(mRemoteMaxPacketLength);
+  // ReadFileTask left room for the Body header in front of the data.
+  aPacket[3] = ObexHeaderId::Body;
+  BigEndian::writeUint16(&aPacket[4], aBodyLength + 3);
 
-  int index = 3;
-  index += AppendHeaderBody(&req[index], mRemoteMaxPacketLength - index,
-                            aFileBody, aFileBodyLength);
+  SendObexData(std::move(aPacket), ObexRequestCode::Put,
+               kPutRequestHeaderSize + aBodyLength);
 
-  SendObexData(std::move(req), ObexRequestCode::Put, index);
+  mSentFileLength += aBodyLength;
+  if (mSentFileLength >= mFileLength) {
+    mWaitingToSendPutFinal = true;
+  }
+}
+
+void BluetoothOppManager::ReadNextFileChunk() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  // Keep at most one chunk read ahead of what has been sent.
+  if (mReadPending || mPrefetchedBody || mWaitingToSendPutFinal ||
+      !mReadFileThread) {
+    return;
+  }
+
+  ErrorResult rv;
+  if (!mInputStream) {
+    mBlob->CreateInputStream(getter_AddRefs(mInputStream), rv);
+    if (NS_WARN_IF(rv.Failed())) {
+      SendDisconnectRequest();
+      rv.SuppressException();
+      return;
+    }
+  }
 
-  mSentFileLength += aFileBodyLength;
+  RefPtr<ReadFileTask> task =
+      new ReadFileTask(mInputStream, mRemoteMaxPacketLength);
+  rv = mReadFileThread->Dispatch(task, NS_DISPATCH_NORMAL);
+  if (NS_WARN_IF(rv.Failed())) {
+    SendDisconnectRequest();
+    rv.SuppressException();
+    return;
+  }
+  mReadPending = true;
+}
+
+void BluetoothOppManager::OnFileChunkRead(nsIInputStream* aInputStream,
+                                          UniquePtr<uint8_t[]> aPacket,
+                                          int aBodyLength) {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  mReadPending = false;
+
+  // Read ahead for a file whose transfer has since ended.
+  if (aInputStream != mInputStream) {
+    if (mPutContinued) {
+      ReadNextFileChunk();
+    }
+    return;
+  }
+
+  if (aBodyLength < 0) {
+    SendDisconnectRequest();
+    return;
+  }
+
+  if (aBodyLength == 0) {
+    // The blob is shorter than it claimed to be.
+    mWaitingToSendPutFinal = true;
+    if (mPutContinued) {
+      mPutContinued = false;
+      SendPutFinalRequest();
+    }
+    return;
+  }
+
+  mPrefetchedBody = std::move(aPacket);
+  mPrefetchedBodyLength = aBodyLength;
+  MaybeSendPrefetchedBody();
+}
+
+void BluetoothOppManager::MaybeSendPrefetchedBody() {
+  if (!mPutContinued || !mPrefetchedBody) {
+    return;
+  }
+
+  mPutContinued = false;
+  SendPutRequest(std::move(mPrefetchedBody), mPrefetchedBodyLength);
+  ReadNextFileChunk();
 }
 
 void BluetoothOppManager::SendPutFinalRequest() {
@@ -1279,12 +1436,6 @@ void BluetoothOppManager::SendDisconnectRequest() {
   SendObexData(req, ObexRequestCode::Disconnect, index);
 }
 
-void BluetoothOppManager::CheckPutFinal(uint32_t aNumRead) {
-  if (mSentFileLength + aNumRead >= mFileLength) {
-    mWaitingToSendPutFinal = true;
-  }
-}
-
 bool BluetoothOppManager::IsConnected() { return mConnected; }
 
 bool BluetoothOppManager::ReplyToConnectionRequest(bool aAccept) {
@@ -1403,6 +1554,15 @@ void BluetoothOppManager::FileTransferComplete() {
 
   BT_ENSURE_TRUE_VOID_BROADCAST_SYSMSG(type, parameters);
 
+  if (!mTransferStartTime.IsNull()) {
+    double seconds = (TimeStamp::Now() - mTransferStartTime).ToSeconds();
+    BT_LOGR("%s %u bytes in %.1f s, %.1f KiB/s (%s)",
+            mIsServer ? "Received" : "Sent", mSentFileLength, seconds,
+            seconds > 0 ? mSentFileLength / 1024.0 / seconds : 0.0,
+            mSuccessFlag ? "done" : "failed");
+    mTransferStartTime = TimeStamp();
+  }
+
   mTransferCompleteFlag = true;
   mContentType = EmptyString();
 }
@@ -1420,6 +1580,7 @@ void BluetoothOppManager::StartFileTransfer() {
   BT_ENSURE_TRUE_VOID_BROADCAST_SYSMSG(type, parameters);
 
   mTransferCompleteFlag = false;
+  mTransferStartTime = TimeStamp::Now();
 }
 
 void BluetoothOppManager::UpdateProgress() {
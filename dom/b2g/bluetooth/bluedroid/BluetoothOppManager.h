@@ -11,12 +11,14 @@
 #include "BluetoothProfileManagerBase.h"
 #include "BluetoothSocketObserver.h"
 #include "DeviceStorage.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/ipc/SocketBase.h"
 #include "mozilla/UniquePtr.h"
 #include "nsCOMArray.h"
 
 class nsIOutputStream;
 class nsIInputStream;
+class nsISerialEventTarget;
 class nsIVolumeMountLock;
 
 BEGIN_BLUETOOTH_NAMESPACE
@@ -65,13 +67,14 @@ class BluetoothOppManager : public BluetoothSocketObserver,
 
   void SendConnectRequest();
   void SendPutHeaderRequest(const nsAString& aFileName, int aFileSize);
-  void SendPutRequest(uint8_t* aFileBody, int aFileBodyLength);
+  void SendPutRequest(UniquePtr<uint8_t[]> aPacket, int aBodyLength);
   void SendPutFinalRequest();
   void SendDisconnectRequest();
 
   void ExtractPacketHeaders(const ObexHeaderSet& aHeader);
   bool ExtractBlobHeaders();
-  void CheckPutFinal(uint32_t aNumRead);
+  void OnFileChunkRead(nsIInputStream* aInputStream,
+                       UniquePtr<uint8_t[]> aPacket, int aBodyLength);
 
  protected:
   virtual ~BluetoothOppManager();
@@ -89,7 +92,11 @@ class BluetoothOppManager : public BluetoothSocketObserver,
   void UpdateProgress();
   void ReceivingFileConfirmation();
   bool CreateFile();
-  bool WriteToFile(const uint8_t* aData, int aDataLength);
+  bool WriteToFile(UniquePtr<uint8_t[]> aData, int aDataLength);
+  void CloseOutputStream();
+  void FinishReceivingFile();
+  void ReadNextFileChunk();
+  void MaybeSendPrefetchedBody();
   void RestoreReceivedFileAndNotify();
   void DeleteReceivedFile();
   void ReplyToConnect();
@@ -211,6 +218,28 @@ class BluetoothOppManager : public BluetoothSocketObserver,
   UniquePtr<uint8_t[]> mBodySegment;
   UniquePtr<uint8_t[]> mReceivedDataBuffer;
 
+  /**
+   * The next PUT packet, read by mReadFileThread while the previous one is
+   * in flight. The body starts after the packet's header.
+   */
+  UniquePtr<uint8_t[]> mPrefetchedBody;
+  int mPrefetchedBodyLength;
+  bool mReadPending;
+
+  /**
+   * Set when the remote has asked for the next PUT packet and it hasn't been
+   * sent yet.
+   */
+  bool mPutContinued;
+
+  /**
+   * Received data is written on mWriteTaskQueue. Set there if a write fails.
+   */
+  nsCOMPtr<nsISerialEventTarget> mWriteTaskQueue;
+  mozilla::Atomic<bool> mWriteFailed;
+
+  mozilla::TimeStamp mTransferStartTime;
+
   int mCurrentBlobIndex;
   RefPtr<BlobImpl> mBlob;
   nsTArray<SendFileBatch> mBatches;
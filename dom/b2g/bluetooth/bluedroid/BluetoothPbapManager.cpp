@@ -1073,10 +1073,12 @@ bool BluetoothPbapManager::ReplyToGet(uint16_t aPhonebookSize) {
       uint32_t remainingPacketSize =
           mRemoteMaxPacketLength - kObexBodyHeaderSize - index;
 
-      // Read vCard data from input stream
+      // Read vCard data straight into the response, behind the Body header,
+      // so only one packet of the phonebook is ever held here.
       uint32_t numRead = 0;
-      UniquePtr<char[]> buf(new char[remainingPacketSize]);
-      rv = mVCardDataStream->Read(buf.get(), remainingPacketSize, &numRead);
+      rv = mVCardDataStream->Read(
+          reinterpret_cast<char*>(&res[index + kObexBodyHeaderSize]),
+          remainingPacketSize, &numRead);
       if (NS_FAILED(rv)) {
         BT_LOGR("Failed to read from input stream. rv=0x%x",
                 static_cast<uint32_t>(rv));
@@ -1087,9 +1089,9 @@ bool BluetoothPbapManager::ReplyToGet(uint16_t aPhonebookSize) {
       MOZ_ASSERT(numRead);
 
       // ----  Part 3b: [headerId:1][length:2][Body:var] ---- //
-      index += AppendHeaderBody(&res[index],
-                                remainingPacketSize + kObexBodyHeaderSize,
-                                reinterpret_cast<uint8_t*>(buf.get()), numRead);
+      res[index] = ObexHeaderId::Body;
+      BigEndian::writeUint16(&res[index + 1], numRead + kObexBodyHeaderSize);
+      index += numRead + kObexBodyHeaderSize;
 
       opcode = ObexResponseCode::Continue;
     }
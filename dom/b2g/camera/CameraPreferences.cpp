@@ -33,6 +33,10 @@ bool CameraPreferences::sPrefCameraParametersIsLowMemory = false;
 
 bool CameraPreferences::sPrefCameraParametersPermission = false;
 
+bool CameraPreferences::sPrefCameraControlZslEnabled = true;
+
+bool CameraPreferences::sPrefCameraRecorderSurfaceInput = true;
+
 #ifdef MOZ_WIDGET_GONK
 StaticRefPtr<CameraPreferences> CameraPreferences::sObserver;
 
@@ -119,6 +123,12 @@ CameraPreferences::Pref CameraPreferences::sPrefs[] = {
     {"camera.control.low_memory_thresholdMB",
      kPrefValueIsUint32,
      {&sPrefCameraControlLowMemoryThresholdMB}},
+    {"camera.control.zsl.enabled",
+     kPrefValueIsBoolean,
+     {&sPrefCameraControlZslEnabled}},
+    {"camera.control.recorder.surface_input.enabled",
+     kPrefValueIsBoolean,
+     {&sPrefCameraRecorderSurfaceInput}},
 };
 
 /* static */
@@ -83,6 +83,10 @@ class CameraPreferences
 
   static bool sPrefCameraParametersPermission;
 
+  static bool sPrefCameraControlZslEnabled;
+
+  static bool sPrefCameraRecorderSurfaceInput;
+
 #ifdef MOZ_WIDGET_GONK
   static StaticRefPtr<CameraPreferences> sObserver;
 
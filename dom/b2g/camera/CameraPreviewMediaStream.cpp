@@ -8,14 +8,6 @@
 #include "MediaTrackListener.h"
 #include "VideoFrameContainer.h"
 
-/**
- * Maximum number of outstanding invalidates before we start to drop frames;
- * if we hit this threshold, it is an indicator that the main thread is
- * either very busy or the device is busy elsewhere (e.g. encoding or
- * persisting video data).
- */
-#define MAX_INVALIDATE_PENDING 4
-
 using namespace mozilla::layers;
 using namespace mozilla::dom;
 
@@ -49,7 +41,7 @@ CameraPreviewMediaStream::CameraPreviewMediaStream()
     : ProcessedMediaTrack(FakeMediaTrackGraph::REQUEST_DEFAULT_SAMPLE_RATE,
                           MediaSegment::VIDEO, new VideoSegment()),
       mMutex("mozilla::camera::CameraPreviewMediaStream"),
-      mInvalidatePending(0),
+      mInvalidatePending(false),
       mDiscardedFrames(0),
       mRateLimit(false),
       mTrackCreated(false) {
@@ -123,7 +115,7 @@ void CameraPreviewMediaStream::Destroy() {
 
 void CameraPreviewMediaStream::Invalidate() {
   MutexAutoLock lock(mMutex);
-  --mInvalidatePending;
+  mInvalidatePending = false;
   for (nsTArray<RefPtr<VideoFrameContainer> >::size_type i = 0;
        i < mVideoOutputs.Length(); ++i) {
     VideoFrameContainer* output = mVideoOutputs[i];
@@ -140,22 +132,22 @@ void CameraPreviewMediaStream::RateLimit(bool aLimit) { mRateLimit = aLimit; }
 
 void CameraPreviewMediaStream::SetCurrentFrame(
     const gfx::IntSize& aIntrinsicSize, Image* aImage) {
+  bool needsInvalidate;
   {
     MutexAutoLock lock(mMutex);
 
-    if (mInvalidatePending > 0) {
-      if (mRateLimit || mInvalidatePending > MAX_INVALIDATE_PENDING) {
-        ++mDiscardedFrames;
-        DOM_CAMERA_LOGW("Discard preview frame %d, %d invalidation(s) pending",
-                        mDiscardedFrames, mInvalidatePending);
-        return;
-      }
-
-      DOM_CAMERA_LOGI("Update preview frame, %d invalidation(s) pending",
-                      mInvalidatePending);
+    if (mInvalidatePending && mRateLimit) {
+      ++mDiscardedFrames;
+      DOM_CAMERA_LOGW("Discard preview frame %d, invalidation pending",
+                      mDiscardedFrames);
+      return;
     }
     mDiscardedFrames = 0;
 
+    // Frames are never queued: the newest one replaces whatever the outputs
+    // hold, painted or not, so when the main thread is busy the preview skips
+    // ahead instead of falling behind. The images go to the compositor
+    // without the main thread; one pending invalidation covers them all.
     TimeStamp now = TimeStamp::Now();
     for (nsTArray<RefPtr<VideoFrameContainer> >::size_type i = 0;
          i < mVideoOutputs.Length(); ++i) {
@@ -163,12 +155,15 @@ void CameraPreviewMediaStream::SetCurrentFrame(
       output->SetCurrentFrame(aIntrinsicSize, aImage, now);
     }
 
-    ++mInvalidatePending;
+    needsInvalidate = !mInvalidatePending;
+    mInvalidatePending = true;
   }
 
-  NS_DispatchToMainThread(
-      NewRunnableMethod("CameraPreviewMediaStream::SetCurrentFrame", this,
-                        &CameraPreviewMediaStream::Invalidate));
+  if (needsInvalidate) {
+    NS_DispatchToMainThread(
+        NewRunnableMethod("CameraPreviewMediaStream::SetCurrentFrame", this,
+                          &CameraPreviewMediaStream::Invalidate));
+  }
 }
 
 void CameraPreviewMediaStream::ClearCurrentFrame() {
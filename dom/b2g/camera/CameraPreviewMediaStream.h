@@ -75,7 +75,7 @@ class CameraPreviewMediaStream : public ProcessedMediaTrack {
   // This class is not registered to MediaTrackGraph.
   // It needs to protect all the fields.
   Mutex mMutex;
-  int32_t mInvalidatePending;
+  bool mInvalidatePending;
   uint32_t mDiscardedFrames;
   bool mRateLimit;
   bool mTrackCreated;
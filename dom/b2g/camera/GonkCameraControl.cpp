@@ -45,6 +45,7 @@
 #include "GonkCameraHwMgr.h"
 #include "GonkRecorderProfiles.h"
 #include "CameraCommon.h"
+#include "CameraPreferences.h"
 #include "GonkCameraParameters.h"
 #include "DeviceStorageFileDescriptor.h"
 #include "MemoryBlobImpl.h"
@@ -79,6 +80,8 @@ nsGonkCameraControl::nsGonkCameraControl(uint32_t aCameraId)
       mLuminanceSupported(false),
       mAutoFlashModeOverridden(false),
       mSeparateVideoAndPreviewSizesSupported(false),
+      mZslSupported(false),
+      mZslEnabled(false),
       mDeferConfigUpdate(0)
 #ifdef MOZ_WIDGET_GONK
       ,
@@ -223,6 +226,10 @@ nsresult nsGonkCameraControl::Initialize() {
   mParams.Get(CAMERA_PARAM_FLASHMODE, flashMode);
   mFlashSupported = !flashMode.IsEmpty();
 
+  AutoTArray<nsString, 2> zslModes;
+  mParams.Get(CAMERA_PARAM_SUPPORTED_ZSLMODES, zslModes);
+  mZslSupported = zslModes.Contains(u"on"_ns);
+
   double quality;  // informational only
   mParams.Get(CAMERA_PARAM_PICTURE_QUALITY, quality);
 
@@ -243,6 +250,8 @@ nsresult nsGonkCameraControl::Initialize() {
                   mCurrentConfiguration.mPreviewSize.height);
   DOM_CAMERA_LOGI(" - luminance reporting:           %ssupported\n",
                   mLuminanceSupported ? "" : "NOT ");
+  DOM_CAMERA_LOGI(" - zero shutter lag:              %ssupported\n",
+                  mZslSupported ? "" : "NOT ");
   if (mFlashSupported) {
     DOM_CAMERA_LOGI(
         " - flash:                         supported, default mode '%s'\n",
@@ -384,6 +393,18 @@ nsresult nsGonkCameraControl::SetConfigurationInternal(
     DOM_CAMERA_LOGE("Failed to set recording hint (0x%x)\n", rv);
   }
 
+  if (mZslSupported) {
+    // The recorder wants the sensor to itself, so ZSL is for pictures only.
+    bool zsl = false;
+    CameraPreferences::GetPref("camera.control.zsl.enabled", zsl);
+    zsl = zsl && aConfig.mMode == kPictureMode;
+    rv = Set(CAMERA_PARAM_ZSL, zsl ? u"on"_ns : u"off"_ns);
+    mZslEnabled = zsl && NS_SUCCEEDED(rv);
+    if (NS_FAILED(rv)) {
+      DOM_CAMERA_LOGE("Failed to set zero shutter lag mode (0x%x)\n", rv);
+    }
+  }
+
   mCurrentConfiguration.mMode = aConfig.mMode;
   mCurrentConfiguration.mRecorderProfile = aConfig.mRecorderProfile;
 
@@ -1064,8 +1085,11 @@ nsresult nsGonkCameraControl::TakePictureImpl() {
   }
 
   // In Gonk, taking a picture implicitly stops the preview stream,
-  // so we need to reflect that here.
-  OnPreviewStateChange(CameraControlListener::kPreviewPaused);
+  // so we need to reflect that here. In ZSL mode the picture comes from
+  // frames the HAL already has, and the preview keeps running.
+  if (!mZslEnabled) {
+    OnPreviewStateChange(CameraControlListener::kPreviewPaused);
+  }
   return NS_OK;
 }
 
@@ -1535,7 +1559,7 @@ void nsGonkCameraControl::OnTakePictureComplete(uint8_t* aData,
                   NS_ConvertUTF16toUTF8(s).get(), aLength);
   OnTakePictureComplete(aData, aLength, s);
 
-  if (mResumePreviewAfterTakingPicture) {
+  if (mResumePreviewAfterTakingPicture && !mZslEnabled) {
     nsresult rv = StartPreview();
     if (NS_FAILED(rv)) {
       DOM_CAMERA_LOGE("Failed to restart camera preview (%x)\n", rv);
@@ -192,6 +192,10 @@ class nsGonkCameraControl : public CameraControlImpl {
   bool mLuminanceSupported;
   bool mAutoFlashModeOverridden;
   bool mSeparateVideoAndPreviewSizesSupported;
+  // Zero shutter lag: the HAL keeps recent full size frames, takePicture()
+  // returns one of them and the preview keeps running.
+  bool mZslSupported;
+  bool mZslEnabled;
   Atomic<uint32_t> mDeferConfigUpdate;
   GonkCameraParameters mParams;
 
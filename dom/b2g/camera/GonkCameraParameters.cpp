@@ -195,6 +195,9 @@ const char* GonkCameraParameters::GetTextKey(uint32_t aKey) {
     case CAMERA_PARAM_METERINGMODE:
       // Not every platform defines CameraParameters::AUTO_EXPOSURE.
       return "auto-exposure";
+    case CAMERA_PARAM_ZSL:
+      // Zero shutter lag is a vendor extension, not in AOSP CameraParameters.
+      return "zsl";
 
     case CAMERA_PARAM_SUPPORTED_PREVIEWSIZES:
       return CameraParameters::KEY_SUPPORTED_PREVIEW_SIZES;
@@ -242,6 +245,8 @@ const char* GonkCameraParameters::GetTextKey(uint32_t aKey) {
     case CAMERA_PARAM_SUPPORTED_METERINGMODES:
       // Not every platform defines CameraParameters::SUPPORTED_AUTO_EXPOSURE.
       return "auto-exposure-values";
+    case CAMERA_PARAM_SUPPORTED_ZSLMODES:
+      return "zsl-values";
     default:
       DOM_CAMERA_LOGE("Unhandled camera parameter value %u\n", aKey);
       return nullptr;
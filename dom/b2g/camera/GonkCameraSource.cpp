@@ -628,7 +628,16 @@ int GonkCameraSource::startCameraRecording() {
   CS_LOGV("startCameraRecording");
   status_t err;
 
-  if (mVideoBufferMode == hardware::ICamera::VIDEO_BUFFER_MODE_BUFFER_QUEUE) {
+  if (mEncoderInputSurface != nullptr) {
+    // The camera feeds the encoder directly.
+    err = mCameraHw->SetVideoTarget(mEncoderInputSurface);
+    if (err != OK) {
+      CS_LOGE("%s: Failed to set encoder input surface: %s (err=%d)",
+              __FUNCTION__, strerror(-err), err);
+      return err;
+    }
+  } else if (mVideoBufferMode ==
+             hardware::ICamera::VIDEO_BUFFER_MODE_BUFFER_QUEUE) {
     // Initialize buffer queue.
     err = initBufferQueue(mVideoSize.width, mVideoSize.height, mEncoderFormat,
                           (android_dataspace_t)mEncoderDataSpace,
@@ -754,6 +763,7 @@ status_t GonkCameraSource::reset() {
 
   mVideoBufferConsumer.clear();
   mVideoBufferProducer.clear();
+  mEncoderInputSurface.clear();
   releaseCamera();
 
   if (mDirectBufferListener.get()) {
@@ -873,12 +883,27 @@ status_t GonkCameraSource::AddDirectBufferListener(
   return OK;
 }
 
+status_t GonkCameraSource::setEncoderInputSurface(
+    const sp<IGraphicBufferProducer>& aInputSurface) {
+  if (mStarted || mInitCheck != OK ||
+      mVideoBufferMode != hardware::ICamera::VIDEO_BUFFER_MODE_BUFFER_QUEUE) {
+    return INVALID_OPERATION;
+  }
+  mEncoderInputSurface = aInputSurface;
+  return OK;
+}
+
 status_t GonkCameraSource::read(MediaBufferBase** buffer,
                                 const ReadOptions* options) {
   CS_LOGV("read");
 
   *buffer = NULL;
 
+  if (mEncoderInputSurface != nullptr) {
+    // Frames go to the encoder's input surface.
+    return INVALID_OPERATION;
+  }
+
   int64_t seekTimeUs;
   ReadOptions::SeekMode mode;
   if (options && options->getSeekTo(&seekTimeUs, &mode)) {
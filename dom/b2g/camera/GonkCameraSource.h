@@ -101,6 +101,16 @@ class GonkCameraSource : public MediaSource, public MediaBufferObserver {
 
   status_t AddDirectBufferListener(DirectBufferListener* aListener);
 
+  /**
+   * Have the camera render recording frames straight into the encoder's
+   * input surface, instead of handing them out through read(). Frames then
+   * never pass through this class, and the encoder drops them based on
+   * their timestamps. Must be called before start(), and is only supported
+   * when the camera runs in VIDEO_BUFFER_MODE_BUFFER_QUEUE.
+   */
+  status_t setEncoderInputSurface(
+      const sp<IGraphicBufferProducer>& aInputSurface);
+
  protected:
   /**
    * The class for listening to BufferQueue's onFrameAvailable. This is used to
@@ -216,6 +226,8 @@ class GonkCameraSource : public MediaSource, public MediaBufferObserver {
   // from camera. This is protected by mLock.
   KeyedVector<ANativeWindowBuffer*, BufferItem> mReceivedBufferItemMap;
   sp<BufferQueueListener> mBufferQueueListener;
+  // The encoder's input surface the camera renders into, if any.
+  sp<IGraphicBufferProducer> mEncoderInputSurface;
 
   sp<GonkCameraHardware> mCameraHw;
   sp<DirectBufferListener> mDirectBufferListener;
@@ -18,6 +18,7 @@
 #include "nsDebug.h"
 #define DOM_CAMERA_LOG_LEVEL 3
 #include "CameraCommon.h"
+#include "CameraPreferences.h"
 #include "GonkCameraSource.h"
 #include "GonkRecorder.h"
 #include "mozilla/CondVar.h"
@@ -36,6 +37,7 @@
 #include <binder/IPCThreadState.h>
 #if defined(MOZ_WIDGET_GONK)
 #  include <media/openmax/OMX_Audio.h>
+#  include <media/openmax/OMX_IVCommon.h>
 #endif
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/AudioSource.h>
@@ -175,6 +177,51 @@ status_t GonkRecorder::WrappedMediaSource::resume() {
   return mResumeStatus;
 }
 
+// The video encoder when the camera renders into its input surface. The
+// camera is started after the encoder, so that the surface is ready for the
+// first frame, and stopped before it, so that the encoder sees the end of
+// the stream.
+struct GonkRecorder::SurfaceInputSource : MediaSource {
+ public:
+  SurfaceInputSource(const sp<MediaSource>& encoder,
+                     const sp<GonkCameraSource>& cameraSource)
+      : mEncoder(encoder), mCameraSource(cameraSource) {}
+  status_t start(MetaData* params = NULL) override;
+  status_t stop() override;
+  sp<MetaData> getFormat() override { return mEncoder->getFormat(); }
+  status_t read(MediaBufferBase** buffer,
+                const ReadOptions* options = NULL) override {
+    return mEncoder->read(buffer, options);
+  }
+
+ protected:
+  virtual ~SurfaceInputSource(){};
+
+ private:
+  SurfaceInputSource(const SurfaceInputSource&);
+  SurfaceInputSource& operator=(const SurfaceInputSource&);
+
+  sp<MediaSource> mEncoder;
+  sp<GonkCameraSource> mCameraSource;
+};
+
+status_t GonkRecorder::SurfaceInputSource::start(MetaData* params) {
+  status_t err = mEncoder->start(params);
+  if (err != OK) {
+    return err;
+  }
+  err = mCameraSource->start();
+  if (err != OK) {
+    mEncoder->stop();
+  }
+  return err;
+}
+
+status_t GonkRecorder::SurfaceInputSource::stop() {
+  mCameraSource->stop();
+  return mEncoder->stop();
+}
+
 GonkRecorder::GonkRecorder()
     : mWriter(NULL),
       mOutputFd(-1),
@@ -1376,6 +1423,10 @@ status_t GonkRecorder::setupCameraSource(sp<GonkCameraSource>* cameraSource) {
     useMeta = false;
   }
 
+  bool useSurfaceInput = false;
+  mozilla::CameraPreferences::GetPref(
+      "camera.control.recorder.surface_input.enabled", useSurfaceInput);
+
   *cameraSource =
       GonkCameraSource::Create(mCameraHw, videoSize, mFrameRate, useMeta);
   if (*cameraSource == NULL) {
@@ -1405,6 +1456,12 @@ status_t GonkRecorder::setupCameraSource(sp<GonkCameraSource>* cameraSource) {
   mMetaDataStoredInVideoBuffers =
       (*cameraSource)->metaDataStoredInVideoBuffers();
 
+  // Rendering into the encoder's input surface needs the camera to produce
+  // graphic buffers, i.e. to run in buffer queue mode.
+  mUseSurfaceInput =
+      useMeta && useSurfaceInput &&
+      mMetaDataStoredInVideoBuffers == kMetadataBufferTypeANWBuffer;
+
   return OK;
 }
 
@@ -1451,7 +1508,15 @@ status_t GonkRecorder::setupVideoEncoder(sp<MediaSource> cameraSource,
   format->setInt32("height", height);
   format->setInt32("stride", stride);
   format->setInt32("slice-height", sliceHeight);
-  format->setInt32("color-format", colorFormat);
+  if (mUseSurfaceInput) {
+    // The encoder allocates gralloc buffers the camera can render into.
+    format->setInt32("color-format", OMX_COLOR_FormatAndroidOpaque);
+    // Let the encoder's input surface drop frames coming faster than the
+    // requested rate, based on their timestamps.
+    format->setFloat("max-fps-to-encoder", mFrameRate);
+  } else {
+    format->setInt32("color-format", colorFormat);
+  }
 
   format->setInt32("bitrate", videoBitRate);
   format->setInt32("frame-rate", mFrameRate);
@@ -1467,21 +1532,22 @@ status_t GonkRecorder::setupVideoEncoder(sp<MediaSource> cameraSource,
     format->setInt32("level", mVideoEncoderLevel);
   }
 
-  if (mMetaDataStoredInVideoBuffers != kMetadataBufferTypeInvalid) {
+  if (mMetaDataStoredInVideoBuffers != kMetadataBufferTypeInvalid &&
+      !mUseSurfaceInput) {
     format->setInt32("android._input-metadata-buffer-type",
                      mMetaDataStoredInVideoBuffers);
   }
 
   uint32_t flags = 0;
-  if (cameraSource == NULL) {
+  if (cameraSource == NULL || mUseSurfaceInput) {
     flags |= MediaCodecSource::FLAG_USE_SURFACE_INPUT;
   } else {
     // require dataspace setup even if not using surface input
     format->setInt32("android._using-recorder", 1);
   }
 
-  sp<MediaCodecSource> encoder =
-      MediaCodecSource::Create(mLooper, format, cameraSource, NULL, flags);
+  sp<MediaCodecSource> encoder = MediaCodecSource::Create(
+      mLooper, format, mUseSurfaceInput ? NULL : cameraSource, NULL, flags);
   if (encoder == NULL) {
     RE_LOGE("Failed to create video encoder");
     // When the encoder fails to be created, we need
@@ -1491,6 +1557,20 @@ status_t GonkRecorder::setupVideoEncoder(sp<MediaSource> cameraSource,
     return UNKNOWN_ERROR;
   }
 
+  if (mUseSurfaceInput) {
+    sp<GonkCameraSource> gonkCameraSource =
+        static_cast<GonkCameraSource*>(cameraSource.get());
+    status_t err = gonkCameraSource->setEncoderInputSurface(
+        encoder->getGraphicBufferProducer());
+    if (err != OK) {
+      RE_LOGE("Failed to set the encoder input surface");
+      cameraSource->stop();
+      return err;
+    }
+    *source = new SurfaceInputSource(encoder, gonkCameraSource);
+    return OK;
+  }
+
   *source = encoder;
 
   return OK;
@@ -1843,6 +1923,7 @@ status_t GonkRecorder::reset() {
   mMaxFileSizeBytes = 0;
   mTrackEveryTimeDurationUs = 0;
   mMetaDataStoredInVideoBuffers = kMetadataBufferTypeInvalid;
+  mUseSurfaceInput = false;
   mEncoderProfiles = MediaProfiles::getInstance();
   mRotationDegrees = 0;
   mLatitudex10000 = -3600000;
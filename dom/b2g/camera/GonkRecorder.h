@@ -75,6 +75,7 @@ struct GonkRecorder {
 
  private:
   struct WrappedMediaSource;
+  struct SurfaceInputSource;
 
   sp<IMediaRecorderClient> mListener;
   String16 mClientName;
@@ -115,6 +116,8 @@ struct GonkRecorder {
   String8 mParams;
 
   MetadataBufferType mMetaDataStoredInVideoBuffers;
+  // Whether the camera renders straight into the encoder's input surface.
+  bool mUseSurfaceInput;
   MediaProfiles* mEncoderProfiles;
 
   bool mStarted;
@@ -53,6 +53,7 @@ enum {
   CAMERA_PARAM_RECORDINGHINT,
   CAMERA_PARAM_PREFERRED_PREVIEWSIZE_FOR_VIDEO,
   CAMERA_PARAM_METERINGMODE,
+  CAMERA_PARAM_ZSL,
 
   // supported features
   CAMERA_PARAM_SUPPORTED_PREVIEWSIZES,
@@ -74,7 +75,8 @@ enum {
   CAMERA_PARAM_SUPPORTED_MAXDETECTEDFACES,
   CAMERA_PARAM_SUPPORTED_JPEG_THUMBNAIL_SIZES,
   CAMERA_PARAM_SUPPORTED_ISOMODES,
-  CAMERA_PARAM_SUPPORTED_METERINGMODES
+  CAMERA_PARAM_SUPPORTED_METERINGMODES,
+  CAMERA_PARAM_SUPPORTED_ZSLMODES
 };
 
 class ICameraControl {
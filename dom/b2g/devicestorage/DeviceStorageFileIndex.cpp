@@ -0,0 +1,976 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "DeviceStorageFileIndex.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base/task.h"
+#include "DeviceStorage.h"
+#include "mozilla/StaticMutex.h"
+#include "mozilla/StaticPrefs_device.h"
+#include "mozilla/StaticPtr.h"
+#include "nsAppDirectoryServiceDefs.h"
+#include "nsDeviceStorage.h"
+#include "nsDirectoryServiceUtils.h"
+#include "nsIFile.h"
+#include "nsThreadUtils.h"
+#include "nsXULAppAPI.h"
+
+namespace mozilla {
+namespace dom {
+namespace devicestorage {
+
+static const uint32_t kIndexMagic = 0x58495344;  // "DSIX"
+static const uint32_t kIndexVersion = 1;
+
+// Don't bother reading back anything implausibly large; it gets rebuilt.
+static const size_t kMaxIndexFileSize = 64 * 1024 * 1024;
+
+// Saving is throttled. Losing the last few changes is harmless: the
+// directories they touched have a newer mtime and are rescanned on load.
+static const uint32_t kSaveIntervalSec = 30;
+
+// If the I/O thread collects more than this many events before a query
+// consumes them, give up on them and rebuild instead.
+static const uint32_t kMaxQueuedEvents = 65536;
+
+static const uint32_t kWatchMask = IN_CREATE | IN_CLOSE_WRITE | IN_ATTRIB |
+                                   IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE |
+                                   IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+static StaticMutex sIndexMutex;
+static StaticAutoPtr<nsCString> sIndexDir;
+static StaticAutoPtr<nsTArray<RefPtr<DeviceStorageFileIndex>>> sIndexes;
+
+static PRTime TimespecToMillis(const struct timespec& aTimeSpec) {
+  return PRTime(aTimeSpec.tv_sec) * PR_MSEC_PER_SEC +
+         PRTime(aTimeSpec.tv_nsec) / PR_NSEC_PER_MSEC;
+}
+
+static void ParentOf(const nsACString& aRelPath, nsACString& aParent) {
+  int32_t slash = aRelPath.RFindChar('/');
+  if (slash == kNotFound) {
+    aParent.Truncate();
+  } else {
+    aParent = Substring(aRelPath, 0, slash);
+  }
+}
+
+static void ChildOf(const nsACString& aRelPath, const nsACString& aName,
+                    nsACString& aChild) {
+  aChild = aRelPath;
+  if (!aChild.IsEmpty()) {
+    aChild.Append('/');
+  }
+  aChild.Append(aName);
+}
+
+template <typename T>
+static void WriteValue(nsACString& aBuffer, const T& aValue) {
+  aBuffer.Append(reinterpret_cast<const char*>(&aValue), sizeof(aValue));
+}
+
+static void WriteString(nsACString& aBuffer, const nsACString& aString) {
+  WriteValue(aBuffer, uint32_t(aString.Length()));
+  aBuffer.Append(aString);
+}
+
+class IndexReader final {
+ public:
+  explicit IndexReader(const nsACString& aBuffer)
+      : mCur(aBuffer.BeginReading()), mEnd(aBuffer.EndReading()) {}
+
+  template <typename T>
+  bool ReadValue(T& aValue) {
+    if (size_t(mEnd - mCur) < sizeof(T)) {
+      return false;
+    }
+    memcpy(&aValue, mCur, sizeof(T));
+    mCur += sizeof(T);
+    return true;
+  }
+
+  bool ReadString(nsACString& aString) {
+    uint32_t length;
+    if (!ReadValue(length) || size_t(mEnd - mCur) < length) {
+      return false;
+    }
+    aString.Assign(mCur, length);
+    mCur += length;
+    return true;
+  }
+
+ private:
+  const char* mCur;
+  const char* mEnd;
+};
+
+/* static */ void DeviceStorageFileIndex::Initialize() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (!XRE_IsParentProcess()) {
+    return;
+  }
+
+  StaticMutexAutoLock lock(sIndexMutex);
+  if (sIndexDir) {
+    return;
+  }
+
+  // Without a profile we still index, we just can't keep it across runs.
+  sIndexDir = new nsCString();
+  nsCOMPtr<nsIFile> dir;
+  nsresult rv =
+      NS_GetSpecialDirectory(NS_APP_USER_PROFILE_50_DIR, getter_AddRefs(dir));
+  if (NS_SUCCEEDED(rv)) {
+    dir->AppendNative("devicestorage"_ns);
+    dir->GetNativePath(*sIndexDir);
+  }
+}
+
+/* static */ void DeviceStorageFileIndex::Shutdown() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  StaticMutexAutoLock lock(sIndexMutex);
+  sIndexDir = nullptr;
+  if (!sIndexes) {
+    return;
+  }
+
+  MessageLoop* ioLoop = XRE_GetIOMessageLoop();
+  for (auto& index : *sIndexes) {
+    if (ioLoop) {
+      ioLoop->PostTask(NewRunnableMethod("DeviceStorageFileIndex::StopWatching",
+                                         index,
+                                         &DeviceStorageFileIndex::StopWatching));
+    }
+  }
+  sIndexes = nullptr;
+}
+
+/* static */ already_AddRefed<DeviceStorageFileIndex>
+DeviceStorageFileIndex::GetForStorage(const nsAString& aStorageType,
+                                      const nsAString& aStorageName) {
+  if (!XRE_IsParentProcess() || !StaticPrefs::device_storage_index_enabled() ||
+      !DeviceStorageTypeChecker::IsVolumeBased(aStorageType)) {
+    return nullptr;
+  }
+
+  // On gonk all the volume based types share the mount point of the volume
+  // as their root, so they end up sharing one index.
+  nsCOMPtr<nsIFile> root;
+  DeviceStorageFile::GetRootDirectoryForType(aStorageType, aStorageName,
+                                             getter_AddRefs(root));
+  if (!root) {
+    return nullptr;
+  }
+  nsAutoCString rootPath;
+  if (NS_FAILED(root->GetNativePath(rootPath)) || rootPath.IsEmpty()) {
+    return nullptr;
+  }
+
+  StaticMutexAutoLock lock(sIndexMutex);
+  if (!sIndexDir) {
+    return nullptr;
+  }
+  if (!sIndexes) {
+    sIndexes = new nsTArray<RefPtr<DeviceStorageFileIndex>>();
+  }
+  for (auto& index : *sIndexes) {
+    if (index->mRoot.Equals(rootPath)) {
+      return do_AddRef(index);
+    }
+  }
+
+  RefPtr<DeviceStorageFileIndex> index = new DeviceStorageFileIndex(rootPath);
+  if (!index->Open()) {
+    return nullptr;
+  }
+  if (!sIndexDir->IsEmpty()) {
+    nsAutoCString name(rootPath);
+    name.ReplaceChar('/', '_');
+    index->mIndexFile = *sIndexDir + "/"_ns + name + ".idx"_ns;
+  }
+  sIndexes->AppendElement(index);
+  return index.forget();
+}
+
+/* static */ void DeviceStorageFileIndex::UpdateForVolume(
+    const nsAString& aStorageName) {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  RefPtr<DeviceStorageFileIndex> index =
+      GetForStorage(NS_LITERAL_STRING_FROM_CSTRING(DEVICESTORAGE_SDCARD),
+                    aStorageName);
+  if (!index) {
+    return;
+  }
+
+  NS_DispatchBackgroundTask(
+      NS_NewRunnableFunction("DeviceStorageFileIndex::UpdateForVolume",
+                             [index]() {
+                               MutexAutoLock lock(index->mMutex);
+                               index->EnsureReadyLocked();
+                             }),
+      NS_DISPATCH_EVENT_MAY_BLOCK);
+}
+
+DeviceStorageFileIndex::DeviceStorageFileIndex(const nsACString& aRoot)
+    : mRoot(aRoot),
+      mMutex("DeviceStorageFileIndex::mMutex"),
+      mQueueMutex("DeviceStorageFileIndex::mQueueMutex"),
+      mFd(-1),
+      mQueueOverflowed(false),
+      mRootDevice(0),
+      mReady(false),
+      mBroken(false),
+      mNeedsRebuild(false),
+      mDirty(false) {}
+
+DeviceStorageFileIndex::~DeviceStorageFileIndex() {
+  if (mFd != -1) {
+    close(mFd);
+  }
+}
+
+bool DeviceStorageFileIndex::Open() {
+  mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (mFd == -1) {
+    DS_LOG_WARN("inotify_init1 failed (%d), not indexing '%s'", errno,
+                mRoot.get());
+    return false;
+  }
+
+  // Queries read the fd themselves before answering, so watching it on the
+  // I/O thread only serves to keep the kernel queue from overflowing while
+  // nobody is asking. If there's no I/O loop the index is still correct.
+  MessageLoop* ioLoop = XRE_GetIOMessageLoop();
+  if (ioLoop) {
+    ioLoop->PostTask(NewRunnableMethod("DeviceStorageFileIndex::StartWatching",
+                                       this,
+                                       &DeviceStorageFileIndex::StartWatching));
+  }
+  return true;
+}
+
+void DeviceStorageFileIndex::StartWatching() {
+  MOZ_ASSERT(XRE_GetIOMessageLoop() == MessageLoopForIO::current());
+
+  if (!MessageLoopForIO::current()->WatchFileDescriptor(
+          mFd, /* persistent = */ true, MessageLoopForIO::WATCH_READ,
+          &mReadWatcher, this)) {
+    NS_WARNING("Unable to watch inotify fd.");
+  }
+}
+
+void DeviceStorageFileIndex::StopWatching() {
+  MOZ_ASSERT(XRE_GetIOMessageLoop() == MessageLoopForIO::current());
+
+  mReadWatcher.StopWatchingFileDescriptor();
+}
+
+void DeviceStorageFileIndex::OnFileCanReadWithoutBlocking(int aFd) {
+  MOZ_ASSERT(aFd == mFd);
+  ReadEvents();
+}
+
+void DeviceStorageFileIndex::ReadEvents() {
+  MutexAutoLock lock(mQueueMutex);
+
+  alignas(struct inotify_event) char buf[4096];
+  while (true) {
+    ssize_t len = read(mFd, buf, sizeof(buf));
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      // EAGAIN: the kernel queue is drained.
+      break;
+    }
+
+    for (char* p = buf; p < buf + len;) {
+      const struct inotify_event* ev =
+          reinterpret_cast<const struct inotify_event*>(p);
+      p += sizeof(struct inotify_event) + ev->len;
+
+      if (mQueueOverflowed) {
+        continue;
+      }
+      if (mQueue.Length() >= kMaxQueuedEvents) {
+        mQueue.Clear();
+        mQueueOverflowed = true;
+        continue;
+      }
+
+      Event* event = mQueue.AppendElement();
+      event->mWatch = ev->wd;
+      event->mMask = ev->mask;
+      if (ev->len) {
+        event->mName.Assign(ev->name);
+      }
+    }
+  }
+}
+
+void DeviceStorageFileIndex::ProcessEventsLocked() {
+  mMutex.AssertCurrentThreadOwns();
+
+  // Pick up whatever the I/O thread hasn't read yet, so that a file written
+  // just before this query is already reflected in the answer.
+  ReadEvents();
+
+  nsTArray<Event> events;
+  {
+    MutexAutoLock lock(mQueueMutex);
+    events = std::move(mQueue);
+    if (mQueueOverflowed) {
+      mQueueOverflowed = false;
+      mNeedsRebuild = true;
+    }
+  }
+
+  for (const Event& event : events) {
+    if (event.mMask & IN_Q_OVERFLOW) {
+      mNeedsRebuild = true;
+      continue;
+    }
+
+    auto watch = mWatches.Lookup(uint32_t(event.mWatch));
+    if (!watch) {
+      continue;
+    }
+    nsAutoCString dir(*watch);
+
+    if (event.mMask & IN_IGNORED) {
+      mWatches.Remove(uint32_t(event.mWatch));
+      continue;
+    }
+    if (event.mMask & IN_UNMOUNT) {
+      mNeedsRebuild = true;
+      continue;
+    }
+    if (event.mMask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+      // Subdirectories are dropped through their parent's IN_DELETE or
+      // IN_MOVED_FROM; only losing the root itself matters here.
+      if (dir.IsEmpty()) {
+        mNeedsRebuild = true;
+      }
+      continue;
+    }
+    if (event.mName.IsEmpty()) {
+      continue;
+    }
+
+    nsAutoCString path;
+    ChildOf(dir, event.mName, path);
+    if (event.mMask & (IN_DELETE | IN_MOVED_FROM)) {
+      if (event.mMask & IN_ISDIR) {
+        RemoveTreeLocked(path);
+      } else {
+        RemoveLocked(path);
+      }
+      mPending.Remove(path);
+    } else {
+      mPending.Insert(path);
+    }
+  }
+}
+
+void DeviceStorageFileIndex::ApplyPendingLocked() {
+  mMutex.AssertCurrentThreadOwns();
+
+  if (mPending.IsEmpty()) {
+    return;
+  }
+
+  nsTHashSet<nsCString> pending = std::move(mPending);
+  mPending.Clear();
+
+  for (const nsACString& relPath : pending) {
+    nsAutoCString path;
+    AbsolutePath(relPath, path);
+
+    struct stat st;
+    if (stat(path.get(), &st)) {
+      RemoveTreeLocked(relPath);
+    } else if (S_ISDIR(st.st_mode)) {
+      // Either a new directory, which gets scanned in full, or one we know
+      // whose attributes changed, which only has its own entries refreshed.
+      ScanDirectoryLocked(relPath);
+    } else if (S_ISREG(st.st_mode)) {
+      UpdateEntryLocked(relPath, TimespecToMillis(st.st_mtim), st.st_size);
+    }
+
+    if (mBroken) {
+      return;
+    }
+  }
+}
+
+bool DeviceStorageFileIndex::EnsureReadyLocked() {
+  mMutex.AssertCurrentThreadOwns();
+
+  if (mBroken) {
+    return false;
+  }
+
+  ProcessEventsLocked();
+
+  // A volume mounted or unmounted on top of the root doesn't generate any
+  // event on the directory underneath, but it does change the device.
+  struct stat st;
+  if (stat(mRoot.get(), &st) || !S_ISDIR(st.st_mode)) {
+    ResetLocked();
+    return false;
+  }
+  if (mReady && st.st_dev != mRootDevice) {
+    mNeedsRebuild = true;
+  }
+
+  if (!mReady || mNeedsRebuild) {
+    RebuildLocked();
+    if (!mReady) {
+      return false;
+    }
+  }
+
+  ApplyPendingLocked();
+  if (mBroken) {
+    ResetLocked();
+    return false;
+  }
+
+  MaybeSaveLocked();
+  return true;
+}
+
+void DeviceStorageFileIndex::RebuildLocked() {
+  mMutex.AssertCurrentThreadOwns();
+
+  ResetLocked();
+  mNeedsRebuild = false;
+
+  struct stat st;
+  if (stat(mRoot.get(), &st) || !S_ISDIR(st.st_mode)) {
+    return;
+  }
+  mRootDevice = st.st_dev;
+
+  TimeStamp start = TimeStamp::Now();
+  bool loaded = LoadLocked();
+  if (loaded) {
+    // Only directories can be checked cheaply. Anything created, removed or
+    // renamed while we weren't running bumps the mtime of its directory, so
+    // those are rescanned; the rest are just watched again.
+    nsTArray<nsCString> dirs;
+    for (auto iter = mDirectories.ConstIter(); !iter.Done(); iter.Next()) {
+      dirs.AppendElement(iter.Key());
+    }
+    dirs.Sort();
+
+    nsTArray<nsCString> changed;
+    for (const nsCString& relPath : dirs) {
+      auto dir = mDirectories.Lookup(relPath);
+      if (!dir) {
+        // Already dropped along with a missing parent.
+        continue;
+      }
+
+      nsAutoCString path;
+      AbsolutePath(relPath, path);
+      // Watch first, so nothing can change unnoticed between the checks.
+      int wd = inotify_add_watch(mFd, path.get(), kWatchMask);
+      if (wd < 0) {
+        if (errno == ENOSPC) {
+          mBroken = true;
+          break;
+        }
+        RemoveTreeLocked(relPath);
+        continue;
+      }
+      dir->mWatch = wd;
+      mWatches.InsertOrUpdate(uint32_t(wd), relPath);
+
+      struct stat dirSt;
+      if (stat(path.get(), &dirSt) || !S_ISDIR(dirSt.st_mode)) {
+        RemoveTreeLocked(relPath);
+      } else if (TimespecToMillis(dirSt.st_mtim) != dir->mLastModified) {
+        changed.AppendElement(relPath);
+      }
+    }
+
+    for (const nsCString& relPath : changed) {
+      if (mBroken) {
+        break;
+      }
+      ScanDirectoryLocked(relPath);
+    }
+    DS_LOG_INFO("loaded index of '%s', %u of %u directories changed",
+                mRoot.get(), uint32_t(changed.Length()),
+                uint32_t(dirs.Length()));
+  } else if (!ScanDirectoryLocked(""_ns)) {
+    ResetLocked();
+    return;
+  }
+
+  if (mBroken) {
+    DS_LOG_WARN("out of inotify watches, not indexing '%s'", mRoot.get());
+    ResetLocked();
+    return;
+  }
+
+  mReady = true;
+  mDirty = true;
+  mLastSave = TimeStamp();
+  DS_LOG_INFO("indexed %u files in '%s' in %.1f ms", mEntries.Count(),
+              mRoot.get(), (TimeStamp::Now() - start).ToMilliseconds());
+}
+
+bool DeviceStorageFileIndex::ScanDirectoryLocked(const nsACString& aRelPath) {
+  mMutex.AssertCurrentThreadOwns();
+
+  nsAutoCString path;
+  AbsolutePath(aRelPath, path);
+
+  // Watch before reading, so nothing created in between is missed.
+  int wd = inotify_add_watch(mFd, path.get(), kWatchMask);
+  if (wd < 0) {
+    if (errno == ENOSPC) {
+      mBroken = true;
+    }
+    return false;
+  }
+
+  DIR* dir = opendir(path.get());
+  if (!dir) {
+    inotify_rm_watch(mFd, wd);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(dirfd(dir), &st)) {
+    closedir(dir);
+    inotify_rm_watch(mFd, wd);
+    return false;
+  }
+
+  bool wasKnown = mDirectories.Contains(aRelPath);
+  mDirectories.InsertOrUpdate(aRelPath,
+                              Directory{TimespecToMillis(st.st_mtim), wd});
+  mWatches.InsertOrUpdate(uint32_t(wd), nsCString(aRelPath));
+  mDirty = true;
+
+  nsTHashSet<nsCString> seen;
+  struct dirent* de;
+  while (!mBroken && (de = readdir(dir))) {
+    if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..")) {
+      continue;
+    }
+
+    nsAutoCString child;
+    ChildOf(aRelPath, nsDependentCString(de->d_name), child);
+
+    struct stat childSt;
+    if (fstatat(dirfd(dir), de->d_name, &childSt, AT_SYMLINK_NOFOLLOW)) {
+      continue;
+    }
+    if (S_ISLNK(childSt.st_mode)) {
+      // Follow links to files, but never into directories: that could loop.
+      if (fstatat(dirfd(dir), de->d_name, &childSt, 0) ||
+          !S_ISREG(childSt.st_mode)) {
+        continue;
+      }
+    }
+
+    if (S_ISDIR(childSt.st_mode)) {
+      seen.Insert(child);
+      // Known subdirectories have their own watch and are checked on their
+      // own; only new ones are walked.
+      if (!mDirectories.Contains(child)) {
+        ScanDirectoryLocked(child);
+      }
+    } else if (S_ISREG(childSt.st_mode)) {
+      seen.Insert(child);
+      UpdateEntryLocked(child, TimespecToMillis(childSt.st_mtim),
+                        childSt.st_size);
+    }
+  }
+  closedir(dir);
+
+  if (!wasKnown || mBroken) {
+    return !mBroken;
+  }
+
+  // Drop whatever disappeared from this directory since it was last seen.
+  nsTArray<nsCString> gone;
+  nsAutoCString parent;
+  for (auto iter = mEntries.ConstIter(); !iter.Done(); iter.Next()) {
+    ParentOf(iter.Key(), parent);
+    if (parent.Equals(aRelPath) && !seen.Contains(iter.Key())) {
+      gone.AppendElement(iter.Key());
+    }
+  }
+  for (auto iter = mDirectories.ConstIter(); !iter.Done(); iter.Next()) {
+    if (iter.Key().IsEmpty()) {
+      continue;
+    }
+    ParentOf(iter.Key(), parent);
+    if (parent.Equals(aRelPath) && !seen.Contains(iter.Key())) {
+      gone.AppendElement(iter.Key());
+    }
+  }
+  for (const nsCString& relPath : gone) {
+    RemoveTreeLocked(relPath);
+  }
+  return true;
+}
+
+void DeviceStorageFileIndex::UpdateEntryLocked(const nsACString& aRelPath,
+                                               PRTime aLastModified,
+                                               uint64_t aSize) {
+  mMutex.AssertCurrentThreadOwns();
+
+  mEntries.InsertOrUpdate(aRelPath,
+                          Entry{aLastModified, aSize, TypeFromName(aRelPath)});
+  mDirty = true;
+}
+
+void DeviceStorageFileIndex::RemoveLocked(const nsACString& aRelPath) {
+  mMutex.AssertCurrentThreadOwns();
+
+  if (mEntries.Remove(aRelPath)) {
+    mDirty = true;
+  }
+}
+
+void DeviceStorageFileIndex::RemoveTreeLocked(const nsACString& aRelPath) {
+  mMutex.AssertCurrentThreadOwns();
+
+  if (aRelPath.IsEmpty()) {
+    mNeedsRebuild = true;
+    return;
+  }
+
+  RemoveLocked(aRelPath);
+
+  nsAutoCString prefix(aRelPath);
+  prefix.Append('/');
+  mEntries.RemoveIf(
+      [&](const auto& aIter) { return StringBeginsWith(aIter.Key(), prefix); });
+  mDirectories.RemoveIf([&](const auto& aIter) {
+    if (!aIter.Key().Equals(aRelPath) &&
+        !StringBeginsWith(aIter.Key(), prefix)) {
+      return false;
+    }
+    if (aIter.Data().mWatch >= 0) {
+      inotify_rm_watch(mFd, aIter.Data().mWatch);
+      mWatches.Remove(uint32_t(aIter.Data().mWatch));
+    }
+    return true;
+  });
+  mDirty = true;
+}
+
+void DeviceStorageFileIndex::ResetLocked() {
+  mMutex.AssertCurrentThreadOwns();
+
+  for (auto iter = mDirectories.ConstIter(); !iter.Done(); iter.Next()) {
+    if (iter.Data().mWatch >= 0) {
+      inotify_rm_watch(mFd, iter.Data().mWatch);
+    }
+  }
+  mEntries.Clear();
+  mDirectories.Clear();
+  mWatches.Clear();
+  mPending.Clear();
+  mReady = false;
+}
+
+bool DeviceStorageFileIndex::LoadLocked() {
+  mMutex.AssertCurrentThreadOwns();
+
+  if (mIndexFile.IsEmpty()) {
+    return false;
+  }
+
+  int fd = open(mIndexFile.get(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+
+  nsAutoCString buffer;
+  struct stat st;
+  bool ok = !fstat(fd, &st) && size_t(st.st_size) <= kMaxIndexFileSize &&
+            buffer.SetLength(st.st_size, fallible);
+  size_t done = 0;
+  while (ok && done < buffer.Length()) {
+    ssize_t len =
+        read(fd, buffer.BeginWriting() + done, buffer.Length() - done);
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    ok = len > 0;
+    done += ok ? len : 0;
+  }
+  close(fd);
+  if (!ok) {
+    return false;
+  }
+
+  IndexReader reader(buffer);
+  uint32_t magic, version, dirCount, entryCount;
+  nsAutoCString root;
+  if (!reader.ReadValue(magic) || magic != kIndexMagic ||
+      !reader.ReadValue(version) || version != kIndexVersion ||
+      !reader.ReadString(root) || !root.Equals(mRoot) ||
+      !reader.ReadValue(dirCount) || !reader.ReadValue(entryCount)) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < dirCount && ok; ++i) {
+    nsAutoCString relPath;
+    PRTime lastModified;
+    ok = reader.ReadString(relPath) && reader.ReadValue(lastModified);
+    if (ok) {
+      mDirectories.InsertOrUpdate(relPath, Directory{lastModified, -1});
+    }
+  }
+  for (uint32_t i = 0; i < entryCount && ok; ++i) {
+    nsAutoCString relPath;
+    PRTime lastModified;
+    uint64_t size;
+    ok = reader.ReadString(relPath) && reader.ReadValue(lastModified) &&
+         reader.ReadValue(size);
+    if (ok) {
+      // The type is recomputed in case the extension lists changed.
+      UpdateEntryLocked(relPath, lastModified, size);
+    }
+  }
+
+  if (!ok || !mDirectories.Contains(""_ns)) {
+    mEntries.Clear();
+    mDirectories.Clear();
+    return false;
+  }
+  return true;
+}
+
+void DeviceStorageFileIndex::MaybeSaveLocked() {
+  mMutex.AssertCurrentThreadOwns();
+
+  if (!mDirty || mIndexFile.IsEmpty()) {
+    return;
+  }
+  TimeStamp now = TimeStamp::Now();
+  if (!mLastSave.IsNull() &&
+      now - mLastSave < TimeDuration::FromSeconds(kSaveIntervalSec)) {
+    return;
+  }
+
+  nsAutoCString buffer;
+  WriteValue(buffer, kIndexMagic);
+  WriteValue(buffer, kIndexVersion);
+  WriteString(buffer, mRoot);
+  WriteValue(buffer, mDirectories.Count());
+  WriteValue(buffer, mEntries.Count());
+  for (auto iter = mDirectories.ConstIter(); !iter.Done(); iter.Next()) {
+    WriteString(buffer, iter.Key());
+    WriteValue(buffer, iter.Data().mLastModified);
+  }
+  for (auto iter = mEntries.ConstIter(); !iter.Done(); iter.Next()) {
+    WriteString(buffer, iter.Key());
+    WriteValue(buffer, iter.Data().mLastModified);
+    WriteValue(buffer, iter.Data().mSize);
+  }
+
+  nsAutoCString dir;
+  ParentOf(mIndexFile, dir);
+  mkdir(dir.get(), 0700);
+
+  // Write a temporary file and rename it over the old one, so a crash
+  // can't leave a truncated index behind.
+  nsAutoCString tmpFile(mIndexFile);
+  tmpFile.AppendLiteral(".tmp");
+  int fd = open(tmpFile.get(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd == -1) {
+    return;
+  }
+  const char* data = buffer.BeginReading();
+  size_t left = buffer.Length();
+  while (left) {
+    ssize_t len = write(fd, data, left);
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      break;
+    }
+    data += len;
+    left -= len;
+  }
+  close(fd);
+
+  if (left || rename(tmpFile.get(), mIndexFile.get())) {
+    unlink(tmpFile.get());
+    return;
+  }
+  mDirty = false;
+  mLastSave = now;
+}
+
+bool DeviceStorageFileIndex::RelativePath(DeviceStorageFile* aDir,
+                                          nsACString& aRelPath) const {
+  if (!aDir->mFile) {
+    return false;
+  }
+
+  nsAutoCString path;
+  if (NS_FAILED(aDir->mFile->GetNativePath(path))) {
+    return false;
+  }
+  while (path.Length() > 1 && path.Last() == '/') {
+    path.Truncate(path.Length() - 1);
+  }
+
+  if (path.Equals(mRoot)) {
+    aRelPath.Truncate();
+    return true;
+  }
+  if (path.Length() > mRoot.Length() + 1 && StringBeginsWith(path, mRoot) &&
+      path.CharAt(mRoot.Length()) == '/') {
+    aRelPath = Substring(path, mRoot.Length() + 1);
+    return true;
+  }
+  return false;
+}
+
+void DeviceStorageFileIndex::AbsolutePath(const nsACString& aRelPath,
+                                          nsACString& aPath) const {
+  aPath = mRoot;
+  if (!aRelPath.IsEmpty()) {
+    aPath.Append('/');
+    aPath.Append(aRelPath);
+  }
+}
+
+/* static */ DeviceStorageFileIndex::MediaType
+DeviceStorageFileIndex::TypeFromName(const nsACString& aName) {
+  DeviceStorageTypeChecker* typeChecker =
+      DeviceStorageTypeChecker::CreateOrGet();
+  MOZ_ASSERT(typeChecker);
+
+  nsAutoString type;
+  typeChecker->GetTypeFromFileName(NS_ConvertUTF8toUTF16(aName), type);
+  if (type.EqualsLiteral(DEVICESTORAGE_PICTURES)) {
+    return MediaType::Pictures;
+  }
+  if (type.EqualsLiteral(DEVICESTORAGE_VIDEOS)) {
+    return MediaType::Videos;
+  }
+  if (type.EqualsLiteral(DEVICESTORAGE_MUSIC)) {
+    return MediaType::Music;
+  }
+  return MediaType::Other;
+}
+
+bool DeviceStorageFileIndex::CollectFiles(
+    DeviceStorageFile* aDir, PRTime aSince,
+    nsTArray<RefPtr<DeviceStorageFile>>& aFiles) {
+  MOZ_ASSERT(!NS_IsMainThread());
+
+  MutexAutoLock lock(mMutex);
+  nsAutoCString relDir;
+  if (!RelativePath(aDir, relDir) || !EnsureReadyLocked()) {
+    return false;
+  }
+  if (!relDir.IsEmpty() && !mDirectories.Contains(relDir)) {
+    // Not a directory we know of; let the caller report it properly.
+    return false;
+  }
+
+  DeviceStorageTypeChecker* typeChecker =
+      DeviceStorageTypeChecker::CreateOrGet();
+  MOZ_ASSERT(typeChecker);
+
+  nsAutoCString prefix(relDir);
+  if (!prefix.IsEmpty()) {
+    prefix.Append('/');
+  }
+
+  for (auto iter = mEntries.ConstIter(); !iter.Done(); iter.Next()) {
+    const Entry& entry = iter.Data();
+    if (entry.mLastModified < aSince ||
+        !StringBeginsWith(iter.Key(), prefix)) {
+      continue;
+    }
+
+    nsAutoCString fullPath;
+    AbsolutePath(iter.Key(), fullPath);
+    if (!typeChecker->Check(aDir->mStorageType,
+                            NS_ConvertUTF8toUTF16(fullPath))) {
+      continue;
+    }
+
+    NS_ConvertUTF8toUTF16 path(Substring(iter.Key(), prefix.Length()));
+    RefPtr<DeviceStorageFile> dsf = new DeviceStorageFile(
+        aDir->mStorageType, aDir->mStorageName, aDir->mRootDir, path);
+    dsf->mLength = entry.mSize;
+    dsf->mLastModifiedDate = entry.mLastModified;
+    aFiles.AppendElement(dsf);
+  }
+  return true;
+}
+
+bool DeviceStorageFileIndex::AccumDirectoryUsage(DeviceStorageFile* aDir,
+                                                 uint64_t* aPicturesSoFar,
+                                                 uint64_t* aVideosSoFar,
+                                                 uint64_t* aMusicSoFar,
+                                                 uint64_t* aTotalSoFar) {
+  MOZ_ASSERT(!NS_IsMainThread());
+
+  MutexAutoLock lock(mMutex);
+  nsAutoCString relDir;
+  if (!RelativePath(aDir, relDir) || !EnsureReadyLocked()) {
+    return false;
+  }
+
+  nsAutoCString prefix(relDir);
+  if (!prefix.IsEmpty()) {
+    prefix.Append('/');
+  }
+
+  for (auto iter = mEntries.ConstIter(); !iter.Done(); iter.Next()) {
+    if (!StringBeginsWith(iter.Key(), prefix)) {
+      continue;
+    }
+    const Entry& entry = iter.Data();
+    switch (entry.mType) {
+      case MediaType::Pictures:
+        *aPicturesSoFar += entry.mSize;
+        break;
+      case MediaType::Videos:
+        *aVideosSoFar += entry.mSize;
+        break;
+      case MediaType::Music:
+        *aMusicSoFar += entry.mSize;
+        break;
+      case MediaType::Other:
+        break;
+    }
+    *aTotalSoFar += entry.mSize;
+  }
+  return true;
+}
+
+}  // namespace devicestorage
+}  // namespace dom
+}  // namespace mozilla
@@ -0,0 +1,161 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef mozilla_dom_devicestorage_DeviceStorageFileIndex_h
+#define mozilla_dom_devicestorage_DeviceStorageFileIndex_h
+
+#include "base/message_loop.h"
+#include "mozilla/Mutex.h"
+#include "mozilla/TimeStamp.h"
+#include "nsHashKeys.h"
+#include "nsString.h"
+#include "nsTArray.h"
+#include "nsTHashMap.h"
+#include "nsTHashSet.h"
+#include "prtime.h"
+
+class DeviceStorageFile;
+
+namespace mozilla {
+namespace dom {
+namespace devicestorage {
+
+/**
+ * An in-memory index of every regular file below the root of a volume based
+ * storage area (sdcard, pictures, videos, music), so that enumerate() and
+ * usedSpace() don't have to walk and stat the whole tree each time.
+ *
+ * The index is built by one full walk the first time a volume is queried,
+ * and kept current from then on by an inotify watch on every directory. The
+ * inotify fd is read on the IPC I/O thread, which only records what changed;
+ * anything that needs the file system is resolved lazily by the next query.
+ * When nothing has changed a query is answered without touching the disk.
+ *
+ * The index is saved in the profile. On the next start only the directories
+ * whose mtime moved while we weren't running are rescanned.
+ *
+ * Only the parent process keeps indexes. If the index can't be used (no
+ * inotify, watch limit reached, volume unmounted mid-build, ...) the lookup
+ * functions return false and callers should fall back to walking the tree.
+ */
+class DeviceStorageFileIndex final : public MessageLoopForIO::Watcher {
+ public:
+  NS_INLINE_DECL_THREADSAFE_REFCOUNTING(DeviceStorageFileIndex)
+
+  // Must be called on the main thread before the first lookup, to resolve
+  // where indexes are persisted.
+  static void Initialize();
+  static void Shutdown();
+
+  // Returns the index of the volume holding aStorageType/aStorageName, or
+  // null if that storage area isn't indexed. May be called on any thread.
+  static already_AddRefed<DeviceStorageFileIndex> GetForStorage(
+      const nsAString& aStorageType, const nsAString& aStorageName);
+
+  // Brings the index of a volume that has just been mounted up to date on a
+  // background thread, so the first query after boot or card insertion
+  // doesn't have to wait for the scan. Main thread only.
+  static void UpdateForVolume(const nsAString& aStorageName);
+
+  // Appends a DeviceStorageFile, relative to aDir, for every file below aDir
+  // that matches the storage type of aDir and was modified at or after
+  // aSince. Sizes and dates are filled in from the index.
+  bool CollectFiles(DeviceStorageFile* aDir, PRTime aSince,
+                    nsTArray<RefPtr<DeviceStorageFile>>& aFiles);
+
+  // Adds the size of every file below aDir to the matching total.
+  bool AccumDirectoryUsage(DeviceStorageFile* aDir, uint64_t* aPicturesSoFar,
+                           uint64_t* aVideosSoFar, uint64_t* aMusicSoFar,
+                           uint64_t* aTotalSoFar);
+
+  // MessageLoopForIO::Watcher
+  void OnFileCanReadWithoutBlocking(int aFd) override;
+  void OnFileCanWriteWithoutBlocking(int aFd) override {
+    MOZ_CRASH("Must not write to the inotify fd");
+  }
+
+ private:
+  enum class MediaType : uint8_t { Other, Pictures, Videos, Music };
+
+  struct Entry {
+    PRTime mLastModified;
+    uint64_t mSize;
+    MediaType mType;
+  };
+
+  struct Directory {
+    PRTime mLastModified;
+    int mWatch;
+  };
+
+  struct Event {
+    int mWatch;
+    uint32_t mMask;
+    nsCString mName;
+  };
+
+  explicit DeviceStorageFileIndex(const nsACString& aRoot);
+  ~DeviceStorageFileIndex();
+
+  bool Open();
+  void StartWatching();
+  void StopWatching();
+
+  // Drains the inotify fd into mQueue. Called on the I/O thread and by
+  // every query.
+  void ReadEvents();
+
+  // Everything below runs with mMutex held.
+  bool EnsureReadyLocked();
+  void ProcessEventsLocked();
+  void ApplyPendingLocked();
+  void RebuildLocked();
+  bool ScanDirectoryLocked(const nsACString& aRelPath);
+  void UpdateEntryLocked(const nsACString& aRelPath, PRTime aLastModified,
+                         uint64_t aSize);
+  void RemoveLocked(const nsACString& aRelPath);
+  void RemoveTreeLocked(const nsACString& aRelPath);
+  void ResetLocked();
+  bool LoadLocked();
+  void MaybeSaveLocked();
+
+  bool RelativePath(DeviceStorageFile* aDir, nsACString& aRelPath) const;
+  void AbsolutePath(const nsACString& aRelPath, nsACString& aPath) const;
+  static MediaType TypeFromName(const nsACString& aName);
+
+  const nsCString mRoot;
+  nsCString mIndexFile;
+
+  // mMutex guards the index itself and is held for whole scans, so the I/O
+  // thread never takes it; it only appends to mQueue under mQueueMutex.
+  Mutex mMutex;
+  Mutex mQueueMutex;
+  int mFd;
+  MessageLoopForIO::FileDescriptorWatcher mReadWatcher;
+  nsTArray<Event> mQueue;
+  bool mQueueOverflowed;
+
+  // Keyed by path relative to mRoot; the root itself is "".
+  nsTHashMap<nsCStringHashKey, Entry> mEntries;
+  nsTHashMap<nsCStringHashKey, Directory> mDirectories;
+  nsTHashMap<nsUint32HashKey, nsCString> mWatches;
+
+  // Paths reported by inotify that still need to be looked at.
+  nsTHashSet<nsCString> mPending;
+
+  uint64_t mRootDevice;
+  bool mReady;
+  bool mBroken;
+  bool mNeedsRebuild;
+  bool mDirty;
+  TimeStamp mLastSave;
+};
+
+}  // namespace devicestorage
+}  // namespace dom
+}  // namespace mozilla
+
+#endif
@@ -9,6 +9,8 @@
 #include "nsDeviceStorage.h"
 #include "mozilla/dom/File.h"
 #include "mozilla/dom/IPCBlobUtils.h"
+#include "mozilla/dom/MemoryBlobImpl.h"
+#include "prio.h"
 
 namespace mozilla {
 namespace dom {
@@ -69,6 +71,26 @@ mozilla::ipc::IPCResult DeviceStorageRequestChild::Recv__delete__(
       break;
     }
 
+    case DeviceStorageResponseValue::TFileDescriptorBlobResponse: {
+      DS_LOG_INFO("fd blob %u", mRequest->GetId());
+      FileDescriptorBlobResponse r = aValue;
+
+      RefPtr<BlobImpl> blobImpl;
+      auto rawFD = r.fileDescriptor().ClonePlatformHandle();
+      PRFileDesc* fd = PR_ImportFile(PROsfd(rawFD.release()));
+      if (fd) {
+        blobImpl = MemoryBlobImpl::CreateFromFileDescriptor(
+            fd, r.length(), r.name(), r.mimeType(), r.lastModified());
+      }
+      if (!blobImpl) {
+        mRequest->Reject(
+            NS_LITERAL_STRING_FROM_CSTRING(POST_ERROR_EVENT_UNKNOWN));
+        break;
+      }
+      mRequest->Resolve(blobImpl.get());
+      break;
+    }
+
     case DeviceStorageResponseValue::TIsDiskFullStorageResponse: {
       DS_LOG_INFO("isdiskfull %u", mRequest->GetId());
       IsDiskFullStorageResponse r = aValue;
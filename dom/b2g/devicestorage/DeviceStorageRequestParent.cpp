@@ -13,8 +13,11 @@
 #include "ContentParent.h"
 #include "nsProxyRelease.h"
 #include "mozilla/Preferences.h"
+#include "mozilla/StaticPrefs_device.h"
 #include "nsNetCID.h"
 #include "nsIAsyncInputStream.h"
+#include "prio.h"
+#include "private/pprio.h"
 
 namespace mozilla {
 namespace dom {
@@ -295,6 +298,22 @@ nsresult DeviceStorageRequestParent::PostBlobSuccessEvent::CancelableRun() {
   return NS_OK;
 }
 
+nsresult
+DeviceStorageRequestParent::PostFileDescriptorBlobEvent::CancelableRun() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  nsString mime;
+  CopyASCIItoUTF16(mMimeType, mime);
+
+  nsString fullPath;
+  mFile->GetFullPath(fullPath);
+
+  FileDescriptorBlobResponse response(mFileDescriptor, fullPath, mime, mLength,
+                                      mLastModificationDate);
+  Unused << mParent->Send__delete__(mParent, response);
+  return NS_OK;
+}
+
 nsresult
 DeviceStorageRequestParent::PostEnumerationSuccessEvent::CancelableRun() {
   MOZ_ASSERT(NS_IsMainThread());
@@ -534,6 +553,25 @@ nsresult DeviceStorageRequestParent::ReadFileEvent::CancelableRun() {
         new PostErrorEvent(mParent, POST_ERROR_EVENT_UNKNOWN));
   }
 
+  // Large files are handed over as a descriptor that the child maps, so
+  // that its reads don't go through IPC streams from here.
+  if (StaticPrefs::device_storage_fd_blobs_enabled() &&
+      uint64_t(fileSize) >= StaticPrefs::device_storage_fd_blobs_min_size() &&
+      uint64_t(fileSize) <= StaticPrefs::device_storage_fd_blobs_max_size()) {
+    PRFileDesc* fd = nullptr;
+    rv = mFile->mFile->OpenNSPRFileDesc(PR_RDONLY, 0, &fd);
+    if (NS_SUCCEEDED(rv)) {
+      // The FileDescriptor constructor dups the descriptor.
+      FileDescriptor fileDescriptor(
+          FileDescriptor::PlatformHandleType(PR_FileDesc2NativeHandle(fd)));
+      PR_Close(fd);
+      return NS_DispatchToMainThread(new PostFileDescriptorBlobEvent(
+          mParent, mFile.forget(), fileDescriptor, uint64_t(fileSize),
+          mMimeType, modDate));
+    }
+    NS_WARNING("Failed to open the file, sending it as a blob");
+  }
+
   return NS_DispatchToMainThread(new PostBlobSuccessEvent(
       mParent, mFile.forget(), static_cast<uint64_t>(fileSize), mMimeType,
       modDate));
@@ -116,6 +116,28 @@ class DeviceStorageRequestParent : public PDeviceStorageRequestParent {
     nsCString mMimeType;
   };
 
+  class PostFileDescriptorBlobEvent : public CancelableFileEvent {
+   public:
+    PostFileDescriptorBlobEvent(DeviceStorageRequestParent* aParent,
+                                already_AddRefed<DeviceStorageFile>&& aFile,
+                                const FileDescriptor& aFileDescriptor,
+                                uint64_t aLength, const nsACString& aMimeType,
+                                int64_t aLastModifiedDate)
+        : CancelableFileEvent(aParent, std::move(aFile)),
+          mFileDescriptor(aFileDescriptor),
+          mLength(aLength),
+          mLastModificationDate(aLastModifiedDate),
+          mMimeType(aMimeType) {}
+    virtual ~PostFileDescriptorBlobEvent() {}
+    virtual nsresult CancelableRun();
+
+   private:
+    FileDescriptor mFileDescriptor;
+    uint64_t mLength;
+    int64_t mLastModificationDate;
+    nsCString mMimeType;
+  };
+
   class PostEnumerationSuccessEvent : public CancelableRunnable {
    public:
     PostEnumerationSuccessEvent(DeviceStorageRequestParent* aParent,
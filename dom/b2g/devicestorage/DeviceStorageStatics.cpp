@@ -5,6 +5,9 @@
  * You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "DeviceStorageStatics.h"
+#ifdef XP_LINUX
+#  include "DeviceStorageFileIndex.h"
+#endif
 #include "mozilla/Preferences.h"
 #include "nsDeviceStorage.h"
 #include "nsIObserverService.h"
@@ -261,6 +264,10 @@ void DeviceStorageStatics::InitDirs() {
                                       nsDependentCString(kPrefOverrideRootDir),
                                       this);
   ResetOverrideRootDir();
+
+#ifdef XP_LINUX
+  DeviceStorageFileIndex::Initialize();
+#endif
 }
 
 void DeviceStorageStatics::DumpDirs() {
@@ -301,6 +308,10 @@ void DeviceStorageStatics::Shutdown() {
   Preferences::UnregisterPrefixCallback(
       DeviceStorageStatics::PrefsChanged,
       nsDependentCString(kPrefOverrideRootDir), this);
+
+#ifdef XP_LINUX
+  DeviceStorageFileIndex::Shutdown();
+#endif
 }
 
 /* static */ void DeviceStorageStatics::GetDeviceStorageLocationsForIPC(
@@ -616,6 +627,17 @@ DeviceStorageStatics::Observe(nsISupports* aSubject, const char* aTopic,
       return NS_OK;
     }
 
+#  ifdef XP_LINUX
+    // Takes sMutex itself to resolve the volume's root.
+    int32_t state;
+    if (NS_SUCCEEDED(volume->GetState(&state)) &&
+        state == nsIVolume::STATE_MOUNTED) {
+      nsAutoString name;
+      volume->GetName(name);
+      DeviceStorageFileIndex::UpdateForVolume(name);
+    }
+#  endif
+
     StaticMutexAutoLock lock(sMutex);
     if (NS_WARN_IF(!sInstance)) {
       return NS_OK;
@@ -763,6 +785,16 @@ DeviceStorageStatics::Observe(nsISupports* aSubject, const char* aTopic,
     return NS_OK;
   }
 
+  // Our own file operations keep the used space total current; files written
+  // by the MTP server or the downloader mean the volume has to be measured
+  // again.
+  if (strcmp(aTopic, kFileWatcherNotify)) {
+    DeviceStorageUsedSpaceCache* usedSpaceCache =
+        DeviceStorageUsedSpaceCache::CreateOrGet();
+    MOZ_ASSERT(usedSpaceCache);
+    usedSpaceCache->Invalidate(dsf->mStorageName);
+  }
+
   // Multiple storage types may match the same files. So walk through each of
   // the storage types, and if the extension matches, tell them about it.
   nsCOMPtr<nsIObserverService> obs = mozilla::services::GetObserverService();
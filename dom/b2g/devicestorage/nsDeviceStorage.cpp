@@ -26,6 +26,7 @@
 #include "mozilla/EventDispatcher.h"
 #include "mozilla/EventListenerManager.h"
 #include "mozilla/LazyIdleThread.h"
+#include "mozilla/Maybe.h"
 #include "mozilla/Scoped.h"
 #include "mozilla/Services.h"
 #include "mozilla/ipc/BackgroundUtils.h"  // for PrincipalInfoToPrincipal
@@ -49,6 +50,9 @@
 #include "DeviceStorageFileDescriptor.h"
 #include "DeviceStorageRequestChild.h"
 #include "DeviceStorageStatics.h"
+#ifdef XP_LINUX
+#  include "DeviceStorageFileIndex.h"
+#endif
 #include "nsCRT.h"
 #include "nsIObserverService.h"
 #include "nsIMIMEService.h"
@@ -106,6 +110,7 @@ bool TokenizerIgnoreNothing(char16_t /* aChar */) { return false; }
 
 StaticAutoPtr<DeviceStorageUsedSpaceCache>
     DeviceStorageUsedSpaceCache::sDeviceStorageUsedSpaceCache;
+Atomic<uint64_t> DeviceStorageUsedSpaceCache::sSequence(0);
 
 DeviceStorageUsedSpaceCache::DeviceStorageUsedSpaceCache() {
   MOZ_ASSERT(NS_IsMainThread());
@@ -142,29 +147,15 @@ DeviceStorageUsedSpaceCache::GetCacheEntry(const nsAString& aStorageName) {
   return nullptr;
 }
 
-static int64_t GetFreeBytes(const nsAString& aStorageName) {
-  // This function makes the assumption that the various types
-  // are all stored on the same filesystem. So we use pictures.
-
-  RefPtr<DeviceStorageFile> dsf(new DeviceStorageFile(
-      NS_LITERAL_STRING_FROM_CSTRING(DEVICESTORAGE_PICTURES), aStorageName));
-  int64_t freeBytes = 0;
-  dsf->GetStorageFreeSpace(&freeBytes);
-  return freeBytes;
-}
-
 nsresult DeviceStorageUsedSpaceCache::AccumUsedSizes(
     const nsAString& aStorageName, uint64_t* aPicturesSoFar,
     uint64_t* aVideosSoFar, uint64_t* aMusicSoFar, uint64_t* aTotalSoFar) {
+  MOZ_ASSERT(XRE_IsParentProcess());
+
   RefPtr<CacheEntry> cacheEntry = GetCacheEntry(aStorageName);
   if (!cacheEntry || cacheEntry->mDirty) {
     return NS_ERROR_NOT_AVAILABLE;
   }
-  int64_t freeBytes = GetFreeBytes(cacheEntry->mStorageName);
-  if (freeBytes != cacheEntry->mFreeBytes) {
-    // Free space changed, so our cached results are no longer valid.
-    return NS_ERROR_NOT_AVAILABLE;
-  }
 
   *aPicturesSoFar += cacheEntry->mPicturesUsedSize;
   *aVideosSoFar += cacheEntry->mVideosUsedSize;
@@ -178,22 +169,84 @@ void DeviceStorageUsedSpaceCache::SetUsedSizes(const nsAString& aStorageName,
                                                uint64_t aPictureSize,
                                                uint64_t aVideosSize,
                                                uint64_t aMusicSize,
-                                               uint64_t aTotalUsedSize) {
+                                               uint64_t aTotalUsedSize,
+                                               uint64_t aSequenceStart) {
+  MOZ_ASSERT(XRE_IsParentProcess());
+
   RefPtr<CacheEntry> cacheEntry = GetCacheEntry(aStorageName);
   if (!cacheEntry) {
     cacheEntry = new CacheEntry;
     cacheEntry->mStorageName = aStorageName;
     mCacheEntries.AppendElement(cacheEntry);
   }
-  cacheEntry->mFreeBytes = GetFreeBytes(cacheEntry->mStorageName);
 
   cacheEntry->mPicturesUsedSize = aPictureSize;
   cacheEntry->mVideosUsedSize = aVideosSize;
   cacheEntry->mMusicUsedSize = aMusicSize;
   cacheEntry->mTotalUsedSize = aTotalUsedSize;
+  cacheEntry->mSequenceStart = aSequenceStart;
+  cacheEntry->mSequenceEnd = CurrentSequence();
   cacheEntry->mDirty = false;
 }
 
+void DeviceStorageUsedSpaceCache::UpdateUsedSize(const nsAString& aStorageName,
+                                                 const nsAString& aType,
+                                                 int64_t aDelta,
+                                                 uint64_t aSequence) {
+  MOZ_ASSERT(NS_IsMainThread());
+  MOZ_ASSERT(mIOThread);
+
+  nsString storageName(aStorageName);
+  nsString type(aType);
+  mIOThread->Dispatch(
+      NS_NewRunnableFunction(
+          "devicestorage:UpdateUsedSize",
+          [this, storageName, type, aDelta, aSequence]() {
+            ApplyUsedSizeChange(storageName, type, aDelta, aSequence);
+          }),
+      NS_DISPATCH_NORMAL);
+}
+
+void DeviceStorageUsedSpaceCache::ApplyUsedSizeChange(
+    const nsAString& aStorageName, const nsAString& aType, int64_t aDelta,
+    uint64_t aSequence) {
+  RefPtr<CacheEntry> cacheEntry = GetCacheEntry(aStorageName);
+  if (!cacheEntry || cacheEntry->mDirty ||
+      aSequence <= cacheEntry->mSequenceStart) {
+    // Nothing cached, or the last scan started after this change and
+    // already counted it.
+    return;
+  }
+  if (aSequence <= cacheEntry->mSequenceEnd) {
+    // The change landed while the scan was running, so we can't tell
+    // whether it was counted.
+    cacheEntry->mDirty = true;
+    return;
+  }
+
+  uint64_t* typeSize = nullptr;
+  if (aType.EqualsLiteral(DEVICESTORAGE_PICTURES)) {
+    typeSize = &cacheEntry->mPicturesUsedSize;
+  } else if (aType.EqualsLiteral(DEVICESTORAGE_VIDEOS)) {
+    typeSize = &cacheEntry->mVideosUsedSize;
+  } else if (aType.EqualsLiteral(DEVICESTORAGE_MUSIC)) {
+    typeSize = &cacheEntry->mMusicUsedSize;
+  }
+
+  if (aDelta < 0 &&
+      (uint64_t(-aDelta) > cacheEntry->mTotalUsedSize ||
+       (typeSize && uint64_t(-aDelta) > *typeSize))) {
+    // Removing more than we know of; something changed behind our back.
+    cacheEntry->mDirty = true;
+    return;
+  }
+
+  if (typeSize) {
+    *typeSize += aDelta;
+  }
+  cacheEntry->mTotalUsedSize += aDelta;
+}
+
 StaticAutoPtr<DeviceStorageTypeChecker>
     DeviceStorageTypeChecker::sDeviceStorageTypeChecker;
 
@@ -438,8 +491,16 @@ bool DeviceStorageTypeChecker::IsSharedMediaRoot(const nsAString& aType) {
 
 class IOEventComplete : public Runnable {
  public:
-  IOEventComplete(DeviceStorageFile* aFile, const char* aType)
-      : Runnable("devicestorage:IOEventComplete"), mFile(aFile), mType(aType) {}
+  // aSizeDelta is how much the file grew or shrank, or Nothing() if that
+  // isn't known, in which case the used space of the volume is measured
+  // again on the next request.
+  IOEventComplete(DeviceStorageFile* aFile, const char* aType,
+                  const Maybe<int64_t>& aSizeDelta)
+      : Runnable("devicestorage:IOEventComplete"),
+        mFile(aFile),
+        mType(aType),
+        mSizeDelta(aSizeDelta),
+        mSequence(DeviceStorageUsedSpaceCache::NextSequence()) {}
 
   ~IOEventComplete() {}
 
@@ -454,13 +515,25 @@ class IOEventComplete : public Runnable {
     DeviceStorageUsedSpaceCache* usedSpaceCache =
         DeviceStorageUsedSpaceCache::CreateOrGet();
     MOZ_ASSERT(usedSpaceCache);
-    usedSpaceCache->Invalidate(mFile->mStorageName);
+    if (mSizeDelta.isNothing() || !mFile->mFile) {
+      usedSpaceCache->Invalidate(mFile->mStorageName);
+    } else if (*mSizeDelta) {
+      DeviceStorageTypeChecker* typeChecker =
+          DeviceStorageTypeChecker::CreateOrGet();
+      MOZ_ASSERT(typeChecker);
+      nsAutoString type;
+      typeChecker->GetTypeFromFile(mFile->mFile, type);
+      usedSpaceCache->UpdateUsedSize(mFile->mStorageName, type, *mSizeDelta,
+                                     mSequence);
+    }
     return NS_OK;
   }
 
  private:
   RefPtr<DeviceStorageFile> mFile;
   nsCString mType;
+  Maybe<int64_t> mSizeDelta;
+  uint64_t mSequence;
 };
 
 DeviceStorageFile::DeviceStorageFile(const nsAString& aStorageType,
@@ -781,6 +854,17 @@ nsresult DeviceStorageFile::CreateFileDescriptor(
   //       Our scoped file descriptor will automatically close fd.
   aFileDescriptor = FileDescriptor(
       FileDescriptor::PlatformHandleType(PR_FileDesc2NativeHandle(fd)));
+
+  // Whatever gets written through the descriptor bypasses the used space
+  // accounting, so the volume has to be measured again.
+  nsString storageName(mStorageName);
+  NS_DispatchToMainThread(NS_NewRunnableFunction(
+      "DeviceStorageFile::CreateFileDescriptor", [storageName]() {
+        DeviceStorageUsedSpaceCache* usedSpaceCache =
+            DeviceStorageUsedSpaceCache::CreateOrGet();
+        MOZ_ASSERT(usedSpaceCache);
+        usedSpaceCache->Invalidate(storageName);
+      }));
   return NS_OK;
 }
 
@@ -793,7 +877,8 @@ nsresult DeviceStorageFile::Create() {
     return rv;
   }
 
-  rv = NS_DispatchToMainThread(new IOEventComplete(this, "created"));
+  rv = NS_DispatchToMainThread(
+      new IOEventComplete(this, "created", Some(int64_t(0))));
   if (NS_WARN_IF(NS_FAILED(rv))) {
     DS_LOG_ERROR(
         "NS_DispatchToMainThread of IOEventComplete created failed. rv[%x]",
@@ -849,7 +934,8 @@ nsresult DeviceStorageFile::Write(nsTArray<uint8_t>& aBits) {
   uint32_t wrote;
   outputStream->Write((char*)aBits.Elements(), aBits.Length(), &wrote);
 
-  rv = NS_DispatchToMainThread(new IOEventComplete(this, "modified"));
+  rv = NS_DispatchToMainThread(
+      new IOEventComplete(this, "modified", Some(int64_t(wrote))));
   if (NS_WARN_IF(NS_FAILED(rv))) {
     DS_LOG_ERROR(
         "NS_DispatchToMainThread of IOEventComplete modified failed. rv[%x]",
@@ -895,6 +981,7 @@ nsresult DeviceStorageFile::Append(nsIInputStream* aInputStream,
                                    nsIOutputStream* aOutputStream) {
   uint32_t wrote;
   uint64_t avail = 0;
+  int64_t written = 0;
   nsCOMPtr<nsIAsyncInputStream> asyncInputStream =
       do_QueryInterface(aInputStream);
   nsCOMPtr<nsIInputStreamLength> lengthWrapper =
@@ -935,6 +1022,7 @@ nsresult DeviceStorageFile::Append(nsIInputStream* aInputStream,
         break;
       }
       mRemainsSize -= wrote;
+      written += wrote;
     }
   } else {
     rv = aInputStream->Available(&avail);
@@ -952,10 +1040,12 @@ nsresult DeviceStorageFile::Append(nsIInputStream* aInputStream,
         break;
       }
       avail -= wrote;
+      written += wrote;
     }
   }
 
-  rv = NS_DispatchToMainThread(new IOEventComplete(this, "modified"));
+  rv = NS_DispatchToMainThread(
+      new IOEventComplete(this, "modified", Some(written)));
   if (NS_WARN_IF(NS_FAILED(rv))) {
     DS_LOG_ERROR(
         "NS_DispatchToMainThread of IOEventComplete modified failed. rv[%x]",
@@ -982,12 +1072,21 @@ nsresult DeviceStorageFile::Remove() {
     return NS_OK;
   }
 
+  // Removing a directory takes an unknown amount of space with it.
+  Maybe<int64_t> sizeDelta;
+  bool isDir = false;
+  int64_t size = 0;
+  if (NS_SUCCEEDED(mFile->IsDirectory(&isDir)) && !isDir &&
+      NS_SUCCEEDED(mFile->GetFileSize(&size))) {
+    sizeDelta = Some(-size);
+  }
+
   rv = mFile->Remove(true);
   if (NS_WARN_IF(NS_FAILED(rv))) {
     return rv;
   }
 
-  rv = NS_DispatchToMainThread(new IOEventComplete(this, "deleted"));
+  rv = NS_DispatchToMainThread(new IOEventComplete(this, "deleted", sizeDelta));
   if (NS_WARN_IF(NS_FAILED(rv))) {
     DS_LOG_ERROR(
         "NS_DispatchToMainThread of IOEventComplete deleted failed. rv[%x]",
@@ -1045,6 +1144,17 @@ void DeviceStorageFile::CollectFiles(
   if (!mFile) {
     return;
   }
+
+#ifdef XP_LINUX
+  if (IsAvailable()) {
+    RefPtr<DeviceStorageFileIndex> index =
+        DeviceStorageFileIndex::GetForStorage(mStorageType, mStorageName);
+    if (index && index->CollectFiles(this, aSince, aFiles)) {
+      return;
+    }
+  }
+#endif
+
   nsString fullRootPath;
   mFile->GetPath(fullRootPath);
   collectFilesInternal(aFiles, aSince, fullRootPath);
@@ -1136,10 +1246,21 @@ void DeviceStorageFile::AccumDiskUsage(uint64_t* aPicturesSoFar,
     if (NS_SUCCEEDED(rv)) {
       return;
     }
-    AccumDirectoryUsage(mFile, &pictureUsage, &videoUsage, &musicUsage,
-                        &totalUsage);
+    uint64_t sequenceStart = DeviceStorageUsedSpaceCache::CurrentSequence();
+    bool indexed = false;
+#ifdef XP_LINUX
+    RefPtr<DeviceStorageFileIndex> index =
+        DeviceStorageFileIndex::GetForStorage(mStorageType, mStorageName);
+    indexed = index &&
+              index->AccumDirectoryUsage(this, &pictureUsage, &videoUsage,
+                                         &musicUsage, &totalUsage);
+#endif
+    if (!indexed) {
+      AccumDirectoryUsage(mFile, &pictureUsage, &videoUsage, &musicUsage,
+                          &totalUsage);
+    }
     usedSpaceCache->SetUsedSizes(mStorageName, pictureUsage, videoUsage,
-                                 musicUsage, totalUsage);
+                                 musicUsage, totalUsage, sequenceStart);
   } else {
     AccumDirectoryUsage(mFile, &pictureUsage, &videoUsage, &musicUsage,
                         &totalUsage);
@@ -3318,14 +3439,16 @@ void nsDOMDeviceStorage::OnVolumeStateChanged(nsIVolume* aVolume) {
   MOZ_ASSERT(IsOwningThread());
 
   // We invalidate the used space cache for the volume that actually changed
-  // state.
+  // state. Only the parent keeps one; children ask it over IPC.
   nsString volName;
   aVolume->GetName(volName);
 
-  DeviceStorageUsedSpaceCache* usedSpaceCache =
-      DeviceStorageUsedSpaceCache::CreateOrGet();
-  MOZ_ASSERT(usedSpaceCache);
-  usedSpaceCache->Invalidate(volName);
+  if (XRE_IsParentProcess()) {
+    DeviceStorageUsedSpaceCache* usedSpaceCache =
+        DeviceStorageUsedSpaceCache::CreateOrGet();
+    MOZ_ASSERT(usedSpaceCache);
+    usedSpaceCache->Invalidate(volName);
+  }
 
   if (!volName.Equals(mStorageName)) {
     // Not our volume - we can ignore.
@@ -135,13 +135,26 @@ class DeviceStorageUsedSpaceCache final {
     mIOThread->Dispatch(std::move(aRunnable), NS_DISPATCH_NORMAL);
   }
 
+  // Applies the size change of one file created, written or removed through
+  // DeviceStorageFile to the cached totals, instead of dropping them and
+  // walking the volume again. aType is the media type of the file.
+  void UpdateUsedSize(const nsAString& aStorageName, const nsAString& aType,
+                      int64_t aDelta, uint64_t aSequence);
+
   nsresult AccumUsedSizes(const nsAString& aStorageName, uint64_t* aPictureSize,
                           uint64_t* aVideosSize, uint64_t* aMusicSize,
                           uint64_t* aTotalSize);
 
+  // aSequenceStart is CurrentSequence() from before the sizes were measured.
   void SetUsedSizes(const nsAString& aStorageName, uint64_t aPictureSize,
                     uint64_t aVideosSize, uint64_t aMusicSize,
-                    uint64_t aTotalSize);
+                    uint64_t aTotalSize, uint64_t aSequenceStart);
+
+  // Every file operation takes a sequence number once it has completed. A
+  // rescan notes the current number before and after it measures, which
+  // tells UpdateUsedSize whether the scan already saw a given change.
+  static uint64_t NextSequence() { return ++sSequence; }
+  static uint64_t CurrentSequence() { return sSequence; }
 
  private:
   friend class InvalidateRunnable;
@@ -154,16 +167,22 @@ class DeviceStorageUsedSpaceCache final {
 
     bool mDirty;
     nsString mStorageName;
-    int64_t mFreeBytes;
     uint64_t mPicturesUsedSize;
     uint64_t mVideosUsedSize;
     uint64_t mMusicUsedSize;
     uint64_t mTotalUsedSize;
+    uint64_t mSequenceStart;
+    uint64_t mSequenceEnd;
 
    private:
     ~CacheEntry() {}
   };
   already_AddRefed<CacheEntry> GetCacheEntry(const nsAString& aStorageName);
+  void ApplyUsedSizeChange(const nsAString& aStorageName,
+                           const nsAString& aType, int64_t aDelta,
+                           uint64_t aSequence);
+
+  static mozilla::Atomic<uint64_t> sSequence;
 
   nsTArray<RefPtr<CacheEntry>> mCacheEntries;
 
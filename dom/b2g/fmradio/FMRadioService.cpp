@@ -81,7 +81,8 @@ FMRadioService::FMRadioService()
       mRadiotextAB(false),
       mRDSGroupSet(false),
       mPSNameSet(false),
-      mRadiotextSet(false) {
+      mRadiotextSet(false),
+      mPendingRDSEvents(0) {
   memset(mPSName, 0, sizeof(mPSName));
   memset(mRadiotext, 0, sizeof(mRadiotext));
   memset(mTempPSName, 0, sizeof(mTempPSName));
@@ -241,6 +242,31 @@ void FMRadioService::DispatchFMRadioEventToMainThread(
       [self, aType]() -> void { self->NotifyFMRadioEvent(aType); }));
 }
 
+void FMRadioService::DispatchRDSEventToMainThread(
+    enum FMRadioEventType aType) {
+  // RDS changes arriving before the main thread got to the previous ones are
+  // delivered together, in a single runnable.
+  const uint32_t bit = 1 << aType;
+  uint32_t pending = mPendingRDSEvents;
+  while (!mPendingRDSEvents.compareExchange(pending, pending | bit)) {
+    pending = mPendingRDSEvents;
+  }
+  if (pending) {
+    return;
+  }
+
+  RefPtr<FMRadioService> self = this;
+  NS_DispatchToMainThread(NS_NewRunnableFunction(
+      "FMRadioService::DispatchRDSEventToMainThread", [self]() -> void {
+        uint32_t events = self->mPendingRDSEvents.exchange(0);
+        for (uint32_t type = 0; events; type++, events >>= 1) {
+          if (events & 1) {
+            self->NotifyFMRadioEvent(static_cast<FMRadioEventType>(type));
+          }
+        }
+      }));
+}
+
 void FMRadioService::TransitionState(const FMRadioResponseType& aResponse,
                                      FMRadioState aState) {
   if (mPendingRequest) {
@@ -1078,7 +1104,7 @@ void FMRadioService::Notify(const hal::FMRadioRDSGroup& aRDSGroup) {
     }
     mPISet = true;
 
-    DispatchFMRadioEventToMainThread(PIChanged);
+    DispatchRDSEventToMainThread(PIChanged);
   }
   mLastPI = blocks[0];
 
@@ -1088,7 +1114,7 @@ void FMRadioService::Notify(const hal::FMRadioRDSGroup& aRDSGroup) {
     mPTY = pty;
     mPTYSet = true;
 
-    DispatchFMRadioEventToMainThread(PTYChanged);
+    DispatchRDSEventToMainThread(PTYChanged);
   }
   mLastPTY = pty;
 
@@ -1120,7 +1146,7 @@ void FMRadioService::Notify(const hal::FMRadioRDSGroup& aRDSGroup) {
         mPSNameSet = true;
         memcpy(mPSName, mTempPSName, sizeof(mTempPSName));
 
-        DispatchFMRadioEventToMainThread(PSChanged);
+        DispatchRDSEventToMainThread(PSChanged);
       }
       break;
     }
@@ -1133,9 +1159,10 @@ void FMRadioService::Notify(const hal::FMRadioRDSGroup& aRDSGroup) {
         memset(mTempRadiotext, 0, sizeof(mTempRadiotext));
         mRadiotextAB = textAB;
         MutexAutoLock lock(mRDSLock);
-        memset(mRadiotext, 0, sizeof(mRadiotext));
-
-        DispatchFMRadioEventToMainThread(RadiotextChanged);
+        if (mRadiotext[0]) {
+          memset(mRadiotext, 0, sizeof(mRadiotext));
+          DispatchRDSEventToMainThread(RadiotextChanged);
+        }
       }
 
       // mRadiotextState is a bitmask that lets us ensure all segments
@@ -1175,7 +1202,7 @@ void FMRadioService::Notify(const hal::FMRadioRDSGroup& aRDSGroup) {
       mRadiotextSet = true;
       memcpy(mRadiotext, mTempRadiotext, sizeof(mTempRadiotext));
 
-      DispatchFMRadioEventToMainThread(RadiotextChanged);
+      DispatchRDSEventToMainThread(RadiotextChanged);
       break;
     }
     case 5:  // 2b Radiotext
@@ -1187,9 +1214,10 @@ void FMRadioService::Notify(const hal::FMRadioRDSGroup& aRDSGroup) {
         memset(mTempRadiotext, 0, sizeof(mTempRadiotext));
         mRadiotextAB = textAB;
         MutexAutoLock lock(mRDSLock);
-        memset(mRadiotext, 0, sizeof(mRadiotext));
-
-        DispatchFMRadioEventToMainThread(RadiotextChanged);
+        if (mRadiotext[0]) {
+          memset(mRadiotext, 0, sizeof(mRadiotext));
+          DispatchRDSEventToMainThread(RadiotextChanged);
+        }
       }
 
       if (!segmentAddr) {
@@ -1224,7 +1252,7 @@ void FMRadioService::Notify(const hal::FMRadioRDSGroup& aRDSGroup) {
       mRadiotextSet = true;
       memcpy(mRadiotext, mTempRadiotext, sizeof(mTempRadiotext));
 
-      DispatchFMRadioEventToMainThread(RadiotextChanged);
+      DispatchRDSEventToMainThread(RadiotextChanged);
       break;
     }
     case 31:  // 15b Fast Tuning and Switching
@@ -1235,7 +1263,7 @@ void FMRadioService::Notify(const hal::FMRadioRDSGroup& aRDSGroup) {
       }
       mPTY = pty;
 
-      DispatchFMRadioEventToMainThread(PTYChanged);
+      DispatchRDSEventToMainThread(PTYChanged);
       break;
     }
   }
@@ -1255,10 +1283,14 @@ void FMRadioService::Notify(const hal::FMRadioRDSGroup& aRDSGroup) {
   newgroup |= blocks[3];
 
   MutexAutoLock lock(mRDSLock);
+  // Stations repeat the same groups over and over; only a new one is news.
+  if (mRDSGroupSet && mRDSGroup == newgroup) {
+    return;
+  }
   mRDSGroup = newgroup;
   mRDSGroupSet = true;
 
-  DispatchFMRadioEventToMainThread(NewRDSGroup);
+  DispatchRDSEventToMainThread(NewRDSGroup);
 }
 
 void FMRadioService::UpdatePowerState() {
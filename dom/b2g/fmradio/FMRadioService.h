@@ -198,6 +198,8 @@ class FMRadioService final : public IFMRadioService,
   void EnableFMRadio();
   void DisableFMRadio();
   void DispatchFMRadioEventToMainThread(enum FMRadioEventType aType);
+  // Called on the RDS thread.
+  void DispatchRDSEventToMainThread(enum FMRadioEventType aType);
 
  protected:
   FMRadioService();
@@ -268,6 +270,8 @@ class FMRadioService final : public IFMRadioService,
   bool mRDSGroupSet;
   bool mPSNameSet;
   bool mRadiotextSet;
+  /* Bitmask of the RDS events waiting to be delivered on the main thread */
+  Atomic<uint32_t> mPendingRDSEvents;
 
   bool mRequireWakeLock;
   RefPtr<WakeLock> mWakeLock;
@@ -10,6 +10,7 @@
 #include "mozilla/dom/InputMethodServiceChild.h"
 #include "mozilla/dom/Promise.h"
 #include "mozilla/dom/IMELog.h"
+#include "mozilla/ProfilerMarkers.h"
 
 namespace mozilla {
 namespace dom {
@@ -40,6 +41,7 @@ InputMethodHandler::InputMethodHandler(Promise* aPromise)
 NS_IMETHODIMP
 InputMethodHandler::OnSetComposition(uint32_t aId, nsresult aStatus) {
   IME_LOGD("--InputMethodHandler::OnSetComposition");
+  EndTrace(aStatus);
   if (mPromise) {
     if (NS_SUCCEEDED(aStatus)) {
       mPromise->MaybeResolve(JS::UndefinedHandleValue);
@@ -56,6 +58,7 @@ InputMethodHandler::OnSetComposition(uint32_t aId, nsresult aStatus) {
 NS_IMETHODIMP
 InputMethodHandler::OnEndComposition(uint32_t aId, nsresult aStatus) {
   IME_LOGD("--InputMethodHandler::OnEndComposition");
+  EndTrace(aStatus);
   if (mPromise) {
     if (NS_SUCCEEDED(aStatus)) {
       mPromise->MaybeResolve(JS::UndefinedHandleValue);
@@ -72,6 +75,7 @@ InputMethodHandler::OnEndComposition(uint32_t aId, nsresult aStatus) {
 NS_IMETHODIMP
 InputMethodHandler::OnKeydown(uint32_t aId, nsresult aStatus) {
   IME_LOGD("--InputMethodHandler::OnKeydown");
+  EndTrace(aStatus);
   if (mPromise) {
     if (NS_SUCCEEDED(aStatus)) {
       mPromise->MaybeResolve(JS::UndefinedHandleValue);
@@ -88,6 +92,7 @@ InputMethodHandler::OnKeydown(uint32_t aId, nsresult aStatus) {
 NS_IMETHODIMP
 InputMethodHandler::OnKeyup(uint32_t aId, nsresult aStatus) {
   IME_LOGD("--InputMethodHandler::OnKeyup");
+  EndTrace(aStatus);
   if (mPromise) {
     if (NS_SUCCEEDED(aStatus)) {
       mPromise->MaybeResolve(JS::UndefinedHandleValue);
@@ -104,6 +109,7 @@ InputMethodHandler::OnKeyup(uint32_t aId, nsresult aStatus) {
 NS_IMETHODIMP
 InputMethodHandler::OnSendKey(uint32_t aId, nsresult aStatus) {
   IME_LOGD("--InputMethodHandler::OnSendKey");
+  EndTrace(aStatus);
   if (mPromise) {
     if (NS_SUCCEEDED(aStatus)) {
       mPromise->MaybeResolve(JS::UndefinedHandleValue);
@@ -120,6 +126,7 @@ InputMethodHandler::OnSendKey(uint32_t aId, nsresult aStatus) {
 NS_IMETHODIMP
 InputMethodHandler::OnDeleteBackward(uint32_t aId, nsresult aStatus) {
   IME_LOGD("--InputMethodHandler::OnDeleteBackward");
+  EndTrace(aStatus);
   if (mPromise) {
     if (NS_SUCCEEDED(aStatus)) {
       IME_LOGD("--InputMethodHandler::OnDeleteBackward: true");
@@ -208,6 +215,7 @@ InputMethodHandler::OnClearAll(uint32_t aId, nsresult aStatus) {
 NS_IMETHODIMP
 InputMethodHandler::OnReplaceSurroundingText(uint32_t aId, nsresult aStatus) {
   IME_LOGD("--InputMethodHandler::OnReplaceSurroundingText");
+  EndTrace(aStatus);
   if (mPromise) {
     if (NS_SUCCEEDED(aStatus)) {
       mPromise->MaybeResolve(JS::UndefinedHandleValue);
@@ -220,6 +228,7 @@ InputMethodHandler::OnReplaceSurroundingText(uint32_t aId, nsresult aStatus) {
 }
 
 nsresult InputMethodHandler::SetComposition(const nsAString& aText) {
+  StartTrace("SetComposition");
   nsString text(aText);
   // TODO use a pure interface, and make it point to either the remote version
   // or the local version at Listener's creation.
@@ -239,6 +248,7 @@ nsresult InputMethodHandler::SetComposition(const nsAString& aText) {
 }
 
 nsresult InputMethodHandler::EndComposition(const nsAString& aText) {
+  StartTrace("EndComposition");
   nsString text(aText);
   ContentChild* contentChild = ContentChild::GetSingleton();
   if (contentChild) {
@@ -256,6 +266,7 @@ nsresult InputMethodHandler::EndComposition(const nsAString& aText) {
 }
 
 nsresult InputMethodHandler::Keydown(const nsAString& aKey) {
+  StartTrace("Keydown");
   nsString key(aKey);
   ContentChild* contentChild = ContentChild::GetSingleton();
   if (contentChild) {
@@ -273,6 +284,7 @@ nsresult InputMethodHandler::Keydown(const nsAString& aKey) {
 }
 
 nsresult InputMethodHandler::Keyup(const nsAString& aKey) {
+  StartTrace("Keyup");
   nsString key(aKey);
   ContentChild* contentChild = ContentChild::GetSingleton();
   if (contentChild) {
@@ -290,6 +302,7 @@ nsresult InputMethodHandler::Keyup(const nsAString& aKey) {
 }
 
 nsresult InputMethodHandler::SendKey(const nsAString& aKey) {
+  StartTrace("SendKey");
   nsString key(aKey);
   ContentChild* contentChild = ContentChild::GetSingleton();
   if (contentChild) {
@@ -307,6 +320,7 @@ nsresult InputMethodHandler::SendKey(const nsAString& aKey) {
 }
 
 nsresult InputMethodHandler::DeleteBackward() {
+  StartTrace("DeleteBackward");
   ContentChild* contentChild = ContentChild::GetSingleton();
   if (contentChild) {
     IME_LOGD("--InputMethodHandler::DeleteBackward content process");
@@ -406,6 +420,7 @@ void InputMethodHandler::ClearAll() {
 nsresult InputMethodHandler::ReplaceSurroundingText(const nsAString& aText,
                                                     int32_t aOffset,
                                                     int32_t aLength) {
+  StartTrace("ReplaceSurroundingText");
   nsString text(aText);
   ContentChild* contentChild = ContentChild::GetSingleton();
   if (contentChild) {
@@ -421,6 +436,25 @@ nsresult InputMethodHandler::ReplaceSurroundingText(const nsAString& aText,
   return NS_OK;
 }
 
+void InputMethodHandler::StartTrace(const char* aName) {
+  mTraceName = aName;
+  mTraceStart = TimeStamp::Now();
+}
+
+void InputMethodHandler::EndTrace(nsresult aStatus) {
+  if (!mTraceName) {
+    return;
+  }
+
+  IME_LOGD("--InputMethodHandler::%s applied in %.2fms, status:[%x]",
+           mTraceName, (TimeStamp::Now() - mTraceStart).ToMilliseconds(),
+           static_cast<uint32_t>(aStatus));
+  PROFILER_MARKER_TEXT("IME Request", DOM,
+                       MarkerTiming::IntervalUntilNowFrom(mTraceStart),
+                       nsDependentCString(mTraceName));
+  mTraceName = nullptr;
+}
+
 void InputMethodHandler::SendRequest(ContentChild* aContentChild,
                                      const InputMethodRequest& aRequest) {
   InputMethodServiceChild* child = new InputMethodServiceChild(this);
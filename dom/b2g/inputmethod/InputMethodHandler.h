@@ -8,6 +8,7 @@
 #define mozilla_dom_InputMethodHandler_h
 
 #include "mozilla/AlreadyAddRefed.h"
+#include "mozilla/TimeStamp.h"
 #include "nsIEditableSupport.h"
 
 namespace mozilla {
@@ -47,7 +48,15 @@ class InputMethodHandler final : public nsIEditableSupportListener {
   void Initialize();
   void SendRequest(ContentChild* aContentChild,
                    const InputMethodRequest& aRequest);
+
+  // Keystroke latency tracing: the time from the keyboard app issuing an
+  // editing request to the focused editor reporting that it was applied.
+  void StartTrace(const char* aName);
+  void EndTrace(nsresult aStatus);
+
   RefPtr<Promise> mPromise;
+  const char* mTraceName = nullptr;
+  TimeStamp mTraceStart;
 };
 
 }  // namespace dom
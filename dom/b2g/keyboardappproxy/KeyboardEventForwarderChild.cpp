@@ -26,6 +26,27 @@ KeyboardEventForwarderChild::~KeyboardEventForwarderChild() {
 }
 
 IPCResult KeyboardEventForwarderChild::RecvKey(const KeyRequest& aKey) {
+  bool defaultPrevented = DispatchKey(aKey);
+  Unused << SendResponse(
+      KeyResponse(aKey.eventType(), defaultPrevented, aKey.generation()));
+  return IPC_OK();
+}
+
+IPCResult KeyboardEventForwarderChild::RecvKeys(
+    nsTArray<KeyRequest>&& aEvents) {
+  MOZ_LOG(gKeyboardAppProxyLog, LogLevel::Debug,
+          ("KeyboardEventForwarderChild::RecvKeys [%zu]", aEvents.Length()));
+  nsTArray<KeyResponse> responses(aEvents.Length());
+  for (const KeyRequest& key : aEvents) {
+    bool defaultPrevented = DispatchKey(key);
+    responses.AppendElement(
+        KeyResponse(key.eventType(), defaultPrevented, key.generation()));
+  }
+  Unused << SendResponses(responses);
+  return IPC_OK();
+}
+
+bool KeyboardEventForwarderChild::DispatchKey(const KeyRequest& aKey) {
   bool defaultPrevented = false;
   do {
     BrowserChild* browserChild = static_cast<BrowserChild*>(Manager());
@@ -74,9 +95,7 @@ IPCResult KeyboardEventForwarderChild::RecvKey(const KeyRequest& aKey) {
     defaultPrevented = domEvent->DefaultPrevented();
   } while (0);
 
-  Unused << SendResponse(
-      KeyResponse(aKey.eventType(), defaultPrevented, aKey.generation()));
-  return IPC_OK();
+  return defaultPrevented;
 }
 
 IPCResult KeyboardEventForwarderChild::RecvTextChanged(const nsCString& aText) {
@@ -18,10 +18,15 @@ class KeyboardEventForwarderChild final : public PKeyboardEventForwarderChild {
  public:
   KeyboardEventForwarderChild();
   IPCResult RecvKey(const KeyRequest& aEvent);
+  IPCResult RecvKeys(nsTArray<KeyRequest>&& aEvents);
   IPCResult RecvTextChanged(const nsCString& aText);
 
  private:
   ~KeyboardEventForwarderChild();
+
+  // Dispatches the key to the keyboard app and returns whether it was
+  // consumed.
+  bool DispatchKey(const KeyRequest& aKey);
 };
 
 }  // namespace dom
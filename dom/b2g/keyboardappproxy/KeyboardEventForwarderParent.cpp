@@ -32,15 +32,54 @@ IPCResult KeyboardEventForwarderParent::RecvResponse(
   RefPtr<nsIKeyboardAppProxy> proxy = KeyboardAppProxy::GetInstance();
   proxy->ReplyKey(aResponse.eventType(), aResponse.defaultPrevented(),
                   aResponse.generation());
+  OnResponses(1);
   return IPC_OK();
 }
 
+IPCResult KeyboardEventForwarderParent::RecvResponses(
+    nsTArray<KeyResponse>&& aResponses) {
+  RefPtr<nsIKeyboardAppProxy> proxy = KeyboardAppProxy::GetInstance();
+  for (const KeyResponse& response : aResponses) {
+    proxy->ReplyKey(response.eventType(), response.defaultPrevented(),
+                    response.generation());
+  }
+  OnResponses(aResponses.Length());
+  return IPC_OK();
+}
+
+void KeyboardEventForwarderParent::OnResponses(uint32_t aCount) {
+  mInFlight = aCount < mInFlight ? mInFlight - aCount : 0;
+  if (mInFlight || mPendingKeys.IsEmpty()) {
+    return;
+  }
+
+  MOZ_LOG(gKeyboardAppProxyLog, LogLevel::Debug,
+          ("KeyboardEventForwarderParent::OnResponses flush [%zu]",
+           mPendingKeys.Length()));
+  mInFlight = mPendingKeys.Length();
+  if (mInFlight == 1) {
+    Unused << SendKey(mPendingKeys[0]);
+  } else {
+    Unused << SendKeys(mPendingKeys);
+  }
+  mPendingKeys.Clear();
+}
+
 NS_IMETHODIMP
 KeyboardEventForwarderParent::OnKeyboardEventReceived(
     const nsACString& aEventType, uint32_t aKeyCode, uint32_t aCharCode,
     const nsACString& aKey, uint64_t aTimeStamp, uint64_t aGeneration) {
-  Unused << SendKey(KeyRequest(nsAutoCString(aEventType), aKeyCode, aCharCode,
-                               nsAutoCString(aKey), aTimeStamp, aGeneration));
+  KeyRequest request(nsAutoCString(aEventType), aKeyCode, aCharCode,
+                     nsAutoCString(aKey), aTimeStamp, aGeneration);
+  if (mInFlight) {
+    // The keyboard app is still busy with earlier events. Replies are
+    // matched in order, so queueing here keeps the order intact.
+    mPendingKeys.AppendElement(std::move(request));
+    return NS_OK;
+  }
+
+  mInFlight = 1;
+  Unused << SendKey(request);
   return NS_OK;
 }
 
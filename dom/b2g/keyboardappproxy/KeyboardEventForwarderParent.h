@@ -25,9 +25,17 @@ class KeyboardEventForwarderParent final : public PKeyboardEventForwarderParent,
 
   explicit KeyboardEventForwarderParent();
   IPCResult RecvResponse(const KeyResponse& aResponse);
+  IPCResult RecvResponses(nsTArray<KeyResponse>&& aResponses);
 
  private:
   ~KeyboardEventForwarderParent();
+
+  void OnResponses(uint32_t aCount);
+
+  // Number of events sent to the keyboard app and not replied yet. New events
+  // are held in mPendingKeys until it drops to zero, then sent together.
+  uint32_t mInFlight = 0;
+  nsTArray<KeyRequest> mPendingKeys;
 };
 
 }  // namespace dom
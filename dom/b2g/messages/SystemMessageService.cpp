@@ -11,6 +11,7 @@
 #include "mozilla/dom/ContentParent.h"
 #include "mozilla/dom/WakeLock.h"
 #include "mozilla/dom/power/PowerManagerService.h"
+#include "mozilla/StaticPrefs_dom.h"
 #include "mozilla/StaticPtr.h"
 #include "nsISystemMessageListener.h"
 #include "nsCharSeparatedTokenizer.h"
@@ -109,11 +110,32 @@ void BuildPermissionsTable() {
    **/
 }
 
+#ifdef XP_LINUX
+// Returns MemAvailable from /proc/meminfo in MB, or -1 if unknown.
+int64_t GetAvailableMemoryMB() {
+  FILE* fp = fopen("/proc/meminfo", "r");
+  if (!fp) {
+    return -1;
+  }
+  int64_t result = -1;
+  char line[128];
+  while (fgets(line, sizeof(line), fp)) {
+    long long kb;
+    if (sscanf(line, "MemAvailable: %lld kB", &kb) == 1) {
+      result = kb / 1024;
+      break;
+    }
+  }
+  fclose(fp);
+  return result;
+}
+#endif
+
 }  // anonymous namespace
 
 NS_IMPL_ISUPPORTS(SystemMessageService, nsISystemMessageService)
 
-SystemMessageService::SystemMessageService() {}
+SystemMessageService::SystemMessageService() : mColdStarts(0) {}
 
 SystemMessageService::~SystemMessageService() {}
 
@@ -215,32 +237,12 @@ SystemMessageService::SendMessage(const nsAString& aMessageName,
     return NS_OK;
   }
 
-  // ServiceWorkerParentInterceptEnabled() is default to true in 73.0b2., which
-  // whether the ServiceWorker is registered on parent processes or content
-  // processes, its ServiceWorker will be spawned and executed on a content
-  // process (This behavior is more secured as well).
-  // As a result, we don't need to consider whether the SystemMessage.subscribe
-  // is called on a content process or a parent process, and since this
-  // SystemMessageService::SendMessage() is for used on chrome process only,
-  // we can use ServiceWorkerManager to send SystemMessageEvent directly.
-  RefPtr<ServiceWorkerManager> swm = ServiceWorkerManager::GetInstance();
-  if (NS_WARN_IF(!swm)) {
-    return NS_ERROR_FAILURE;
-  }
-
   // Unlike the old implementation in gecko48, where it acquires wake lock per
   // requests, we are using a global wake lock here. File Bug 78954 to track
   // if we want to improve on that.
-  AcquireWakeLock();
-  NS_NewTimerWithFuncCallback(getter_AddRefs(mWakeLockTimer),
-                              WakeLockTimerCallback, this, kWakeLockHoldTime,
-                              nsITimer::TYPE_ONE_SHOT,
-                              "SystemMessageService::SendMessage");
+  HoldWakeLock();
 
-  LOG("Sending message %s to %s",
-      NS_LossyConvertUTF16toASCII(aMessageName).get(), (info->mScope).get());
-  return swm->SendSystemMessageEvent(info->mOriginSuffix, info->mScope,
-                                     aMessageName, std::move(messageData));
+  return Deliver(*info, aMessageName, std::move(messageData));
 }
 
 NS_IMETHODIMP
@@ -264,30 +266,157 @@ SystemMessageService::BroadcastMessage(const nsAString& aMessageName,
     return NS_OK;
   }
 
+  HoldWakeLock();
+
+  for (auto iter = table->Iter(); !iter.Done(); iter.Next()) {
+    // Every subscriber reads the same clone data.
+    RefPtr<ServiceWorkerCloneData> data = messageData;
+    Unused << Deliver(*iter.Data(), aMessageName, std::move(data));
+  }
+
+  return NS_OK;
+}
+
+nsresult SystemMessageService::Deliver(
+    const SubscriberInfo& aInfo, const nsAString& aMessageName,
+    RefPtr<ServiceWorkerCloneData>&& aMessageData) {
+  // ServiceWorkerParentInterceptEnabled() is default to true in 73.0b2., which
+  // whether the ServiceWorker is registered on parent processes or content
+  // processes, its ServiceWorker will be spawned and executed on a content
+  // process (This behavior is more secured as well).
+  // As a result, we don't need to consider whether the SystemMessage.subscribe
+  // is called on a content process or a parent process, and since this
+  // SystemMessageService is for used on chrome process only, we can use
+  // ServiceWorkerManager to send SystemMessageEvent directly.
   RefPtr<ServiceWorkerManager> swm = ServiceWorkerManager::GetInstance();
   if (NS_WARN_IF(!swm)) {
     return NS_ERROR_FAILURE;
   }
 
-  AcquireWakeLock();
-  NS_NewTimerWithFuncCallback(getter_AddRefs(mWakeLockTimer),
-                              WakeLockTimerCallback, this, kWakeLockHoldTime,
-                              nsITimer::TYPE_ONE_SHOT,
-                              "SystemMessageService::BroadcastMessage");
+  nsAutoCString key(aInfo.mOriginSuffix);
+  key.Append(aInfo.mScope);
 
-  for (auto iter = table->Iter(); !iter.Done(); iter.Next()) {
-    auto& info = iter.Data();
+  if (AppQueue* queue = mAppQueues.Get(key)) {
+    LOG("Queueing message %s for %s",
+        NS_LossyConvertUTF16toASCII(aMessageName).get(), aInfo.mScope.get());
+    queue->mMessages.AppendElement(
+        QueuedMessage{nsString(aMessageName), std::move(aMessageData)});
+    return NS_OK;
+  }
 
+  if (!StaticPrefs::dom_systemMessage_coldStart_max() ||
+      swm->IsWorkerRunningForScope(aInfo.mOriginSuffix, aInfo.mScope)) {
     LOG("Sending message %s to %s",
-        NS_LossyConvertUTF16toASCII(aMessageName).get(), (info->mScope).get());
-
-    Unused << swm->SendSystemMessageEvent(info->mOriginSuffix, info->mScope,
-                                          aMessageName, std::move(messageData));
+        NS_LossyConvertUTF16toASCII(aMessageName).get(), aInfo.mScope.get());
+    return swm->SendSystemMessageEvent(aInfo.mOriginSuffix, aInfo.mScope,
+                                       aMessageName, std::move(aMessageData));
   }
 
+  AppQueue* queue = mAppQueues.GetOrInsertNew(key);
+  queue->mScope = aInfo.mScope;
+  queue->mOriginSuffix = aInfo.mOriginSuffix;
+  queue->mMessages.AppendElement(
+      QueuedMessage{nsString(aMessageName), std::move(aMessageData)});
+  mWaitingApps.AppendElement(key);
+
+  MaybeStartQueuedApps();
   return NS_OK;
 }
 
+void SystemMessageService::MaybeStartQueuedApps() {
+  RefPtr<ServiceWorkerManager> swm = ServiceWorkerManager::GetInstance();
+  if (NS_WARN_IF(!swm)) {
+    return;
+  }
+
+  uint32_t maxColdStarts = MaxColdStarts();
+  while (mColdStarts < maxColdStarts && !mWaitingApps.IsEmpty()) {
+    nsCString key = mWaitingApps[0];
+    mWaitingApps.RemoveElementAt(0);
+
+    AppQueue* queue = mAppQueues.Get(key);
+    if (!queue || queue->mMessages.IsEmpty()) {
+      mAppQueues.Remove(key);
+      continue;
+    }
+
+    // The first message starts the worker. The others wait until it is up
+    // and then go out together.
+    QueuedMessage first = std::move(queue->mMessages[0]);
+    queue->mMessages.RemoveElementAt(0);
+
+    LOG("Starting %s for message %s, %u other start(s) in progress",
+        queue->mScope.get(), NS_LossyConvertUTF16toASCII(first.mName).get(),
+        mColdStarts);
+    nsresult rv =
+        swm->SendSystemMessageEvent(queue->mOriginSuffix, queue->mScope,
+                                    first.mName, std::move(first.mData));
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      // No active worker to send anything to.
+      mAppQueues.Remove(key);
+      continue;
+    }
+
+    HoldWakeLock();
+    mColdStarts++;
+
+    RefPtr<SystemMessageService> self = this;
+    rv = NS_NewTimerWithCallback(
+        getter_AddRefs(queue->mStartTimer),
+        [self, key](nsITimer*) { self->ColdStartDone(key); },
+        StaticPrefs::dom_systemMessage_coldStart_durationMs(),
+        nsITimer::TYPE_ONE_SHOT, "SystemMessageService::ColdStartDone");
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      ColdStartDone(key);
+      return;
+    }
+  }
+
+  if (!mWaitingApps.IsEmpty()) {
+    LOG("%zu app(s) waiting to be started", mWaitingApps.Length());
+  }
+}
+
+void SystemMessageService::ColdStartDone(const nsACString& aKey) {
+  MOZ_ASSERT(mColdStarts > 0);
+  mColdStarts--;
+
+  UniquePtr<AppQueue> queue;
+  mAppQueues.Remove(aKey, &queue);
+
+  RefPtr<ServiceWorkerManager> swm = ServiceWorkerManager::GetInstance();
+  if (queue && !queue->mMessages.IsEmpty() && swm) {
+    LOG("Sending %zu queued message(s) to %s", queue->mMessages.Length(),
+        queue->mScope.get());
+    HoldWakeLock();
+    for (QueuedMessage& message : queue->mMessages) {
+      Unused << swm->SendSystemMessageEvent(queue->mOriginSuffix,
+                                            queue->mScope, message.mName,
+                                            std::move(message.mData));
+    }
+  }
+
+  MaybeStartQueuedApps();
+}
+
+uint32_t SystemMessageService::MaxColdStarts() {
+  uint32_t maxColdStarts =
+      std::max(1u, StaticPrefs::dom_systemMessage_coldStart_max());
+
+#ifdef XP_LINUX
+  // Two processes starting at once is what gets the low memory killer going
+  // when memory is already short, so start them one by one.
+  int64_t available = GetAvailableMemoryMB();
+  if (available >= 0 &&
+      available <
+          StaticPrefs::dom_systemMessage_coldStart_minAvailableMB()) {
+    return 1;
+  }
+#endif
+
+  return maxColdStarts;
+}
+
 void SystemMessageService::DoSubscribe(const nsAString& aMessageName,
                                        const nsACString& aOrigin,
                                        const nsACString& aScope,
@@ -352,6 +481,14 @@ bool SystemMessageService::HasPermission(const nsAString& aMessageName,
   return true;
 }
 
+void SystemMessageService::HoldWakeLock() {
+  AcquireWakeLock();
+  NS_NewTimerWithFuncCallback(getter_AddRefs(mWakeLockTimer),
+                              WakeLockTimerCallback, this, kWakeLockHoldTime,
+                              nsITimer::TYPE_ONE_SHOT,
+                              "SystemMessageService::HoldWakeLock");
+}
+
 void SystemMessageService::AcquireWakeLock() {
   if (!mMessageWakeLock) {
     RefPtr<power::PowerManagerService> pmService =
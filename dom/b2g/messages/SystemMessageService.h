@@ -18,6 +18,7 @@ namespace mozilla {
 namespace dom {
 
 class ContentParent;
+class ServiceWorkerCloneData;
 class WakeLock;
 
 class SystemMessageService final : public nsISystemMessageService {
@@ -37,6 +38,7 @@ class SystemMessageService final : public nsISystemMessageService {
 
   bool HasPermission(const nsAString& aMessageName, const nsACString& aOrigin);
 
+  void HoldWakeLock();
   void AcquireWakeLock();
   void ReleaseWakeLock();
   static void WakeLockTimerCallback(nsITimer* aTimer, void* aClosure);
@@ -52,7 +54,36 @@ class SystemMessageService final : public nsISystemMessageService {
   };
   typedef nsClassHashtable<nsCStringHashKey, SubscriberInfo> SubscriberTable;
 
+  // An app whose service worker is being started, or waiting for its turn
+  // to be started, and the messages it will be sent once it's up.
+  struct QueuedMessage {
+    nsString mName;
+    RefPtr<ServiceWorkerCloneData> mData;
+  };
+  struct AppQueue {
+    nsCString mScope;
+    nsCString mOriginSuffix;
+    nsTArray<QueuedMessage> mMessages;
+    // Set while the app is starting.
+    nsCOMPtr<nsITimer> mStartTimer;
+  };
+
+  // Sends a message to the service worker of an app. When its worker isn't
+  // running the message is queued instead, and only a few apps are started
+  // at a time, so that a broadcast doesn't launch a process for every
+  // subscriber at once.
+  nsresult Deliver(const SubscriberInfo& aInfo, const nsAString& aMessageName,
+                   RefPtr<ServiceWorkerCloneData>&& aMessageData);
+  void MaybeStartQueuedApps();
+  void ColdStartDone(const nsACString& aKey);
+  uint32_t MaxColdStarts();
+
   nsClassHashtable<nsStringHashKey, SubscriberTable> mSubscribers;
+  // Keyed by origin suffix and scope.
+  nsClassHashtable<nsCStringHashKey, AppQueue> mAppQueues;
+  // Keys of mAppQueues not started yet, in the order they were queued.
+  nsTArray<nsCString> mWaitingApps;
+  uint32_t mColdStarts;
   RefPtr<WakeLock> mMessageWakeLock;
   nsCOMPtr<nsITimer> mWakeLockTimer;
 };
@@ -7,6 +7,10 @@
 #include "mozilla/Preferences.h"
 #include "VirtualCursorService.h"
 #include "CursorSimulator.h"
+#include "nsThreadUtils.h"
+#ifdef MOZ_WIDGET_GONK
+#  include "nsWindow.h"
+#endif
 
 using namespace mozilla;
 using namespace mozilla::dom;
@@ -158,6 +162,34 @@ void VirtualCursorService::UpdatePos(const LayoutDeviceIntPoint& aPoint) {
       presContext->DevPixelsToFloatCSSPixels(aPoint.x) / resolution;
   mCSSCursorPoint.y =
       presContext->DevPixelsToFloatCSSPixels(aPoint.y) / resolution;
+  MoveOverlay(aPoint);
+
+  // Holding a direction key sends a burst of positions. Only the latest one
+  // needs to be hit-tested and delivered to content.
+  if (!mMovePending) {
+    mMovePending = true;
+    NS_DispatchToCurrentThread(
+        NewRunnableMethod("VirtualCursorService::FlushPendingMove", this,
+                          &VirtualCursorService::FlushPendingMove));
+  }
+}
+
+void VirtualCursorService::MoveOverlay(const LayoutDeviceIntPoint& aPoint) {
+#ifdef MOZ_WIDGET_GONK
+  nsCOMPtr<nsIWidget> widget =
+      nsGlobalWindowOuter::Cast(mWindow)->GetMainWidget();
+  if (widget) {
+    static_cast<nsWindow*>(widget.get())
+        ->SetMouseCursorPosition(ScreenIntPoint(aPoint.x, aPoint.y));
+  }
+#endif
+}
+
+void VirtualCursorService::FlushPendingMove() {
+  if (!mMovePending) {
+    return;
+  }
+  mMovePending = false;
   CursorMove();
 }
 
@@ -171,6 +203,7 @@ void VirtualCursorService::CursorClick() {
 void VirtualCursorService::CursorDown() {
   MOZ_LOG(gVirtualCursorLog, LogLevel::Debug,
           ("VirtualCursorService::CursorDown"));
+  FlushPendingMove();
   SendCursorEvent(NS_LITERAL_STRING_FROM_CSTRING("mousedown"), 0, 1);
 }
 
@@ -183,6 +216,7 @@ void VirtualCursorService::CursorUp() {
 void VirtualCursorService::CursorMove() {
   MOZ_LOG(gVirtualCursorLog, LogLevel::Debug,
           ("VirtualCursorService::CursorMove"));
+  mMovePending = false;
   if (IsPanning()) {
     // There may be a timing that we already start panning on the b2g process
     // then receive the move requests from content. Ignore the request.
@@ -195,11 +229,13 @@ void VirtualCursorService::CursorOut(bool aCheckActive) {
   MOZ_LOG(gVirtualCursorLog, LogLevel::Debug,
           ("VirtualCursorService::CursorOut"));
   mCurFrameLoader = nullptr;
+  mMovePending = false;
   SendCursorEvent(NS_LITERAL_STRING_FROM_CSTRING("mouseout"), 0, 0);
 }
 
 void VirtualCursorService::ShowContextMenu() {
   NS_ENSURE_TRUE_VOID(mWindowUtils);
+  FlushPendingMove();
   bool preventDefault;
   mWindowUtils->SendMouseEvent(NS_LITERAL_STRING_FROM_CSTRING("contextmenu"),
                                mCSSCursorPoint.x, mCSSCursorPoint.y, 2, 1, 0,
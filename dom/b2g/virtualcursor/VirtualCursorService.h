@@ -57,11 +57,17 @@ class VirtualCursorService final : public nsIVirtualCursor,
   VirtualCursorService() = default;
   virtual ~VirtualCursorService();
 
+  // Moves the cursor overlay on the widget right away and coalesces the
+  // mousemove into a single event per main thread turn.
+  void MoveOverlay(const LayoutDeviceIntPoint& aPoint);
+  void FlushPendingMove();
+
   nsCOMPtr<nsPIDOMWindowOuter> mWindow;
   nsCOMPtr<nsIDOMWindowUtils> mWindowUtils;
   RefPtr<PanSimulator> mPanSimulator;
   CSSPoint mCSSCursorPoint;
   RefPtr<nsFrameLoader> mCurFrameLoader;
+  bool mMovePending = false;
 
   // A table to map outer window to the VirtualCursorProxy
   nsTHashMap<nsPtrHashKey<nsPIDOMWindowOuter>, RefPtr<VirtualCursorProxy>>
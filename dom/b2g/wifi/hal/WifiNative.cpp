@@ -10,6 +10,7 @@
 #include <cutils/properties.h>
 #include <string.h>
 #include "js/CharacterEncoding.h"
+#include "nsTHashMap.h"
 
 using namespace mozilla::dom;
 using namespace mozilla::dom::wifi;
@@ -562,22 +563,38 @@ Result_t WifiNative::GetScanResults(int32_t aScanType, nsWifiResult* aResult) {
     return result;
   }
 
+  // A BSSID may be reported more than once, e.g. when it was seen on several
+  // channels. Keep only the most recent sighting, the one with the largest
+  // TSF, so that callers don't have to compare every pair of results.
   nsTArray<RefPtr<nsScanResult>> scanResults(nativeScanResults.size());
-  for (auto nativeResult : nativeScanResults) {
-    std::string ssidStr(nativeResult.ssid.begin(), nativeResult.ssid.end());
+  nsTArray<uint64_t> scanTsfs(nativeScanResults.size());
+  nsTHashMap<nsCStringHashKey, size_t> bssidIndex(nativeScanResults.size());
+  for (const auto& nativeResult : nativeScanResults) {
     std::string bssidStr = ConvertMacToString(nativeResult.bssid);
+    size_t index = bssidIndex.LookupOrInsert(
+        nsDependentCString(bssidStr.c_str()), scanResults.Length());
+    if (index < scanResults.Length() && nativeResult.tsf <= scanTsfs[index]) {
+      continue;
+    }
+
+    std::string ssidStr(nativeResult.ssid.begin(), nativeResult.ssid.end());
     nsString ssid(NS_ConvertUTF8toUTF16(ssidStr.c_str()));
     nsString bssid(NS_ConvertUTF8toUTF16(bssidStr.c_str()));
 
-    nsTArray<uint8_t> infoElement(nativeResult.info_element.size());
-    for (auto& element : nativeResult.info_element) {
-      infoElement.AppendElement(element);
-    }
+    nsTArray<uint8_t> infoElement;
+    infoElement.AppendElements(nativeResult.info_element.data(),
+                               nativeResult.info_element.size());
     RefPtr<nsScanResult> scanResult =
         new nsScanResult(ssid, bssid, infoElement, nativeResult.frequency,
                          nativeResult.tsf, nativeResult.capability,
                          nativeResult.signal_mbm, nativeResult.associated);
-    scanResults.AppendElement(scanResult);
+    if (index < scanResults.Length()) {
+      scanResults[index] = std::move(scanResult);
+      scanTsfs[index] = nativeResult.tsf;
+    } else {
+      scanResults.AppendElement(std::move(scanResult));
+      scanTsfs.AppendElement(nativeResult.tsf);
+    }
   }
   aResult->updateScanResults(scanResults);
   return nsIWifiResult::SUCCESS;
@@ -4921,6 +4921,30 @@ Storage* nsGlobalWindowInner::GetLocalStorage(ErrorResult& aError) {
   return mLocalStorage;
 }
 
+void nsGlobalWindowInner::PrefetchLocalStorage() {
+  if (!StaticPrefs::dom_storage_prefetch_datastore() ||
+      !NextGenLocalStorageEnabled() || XRE_IsParentProcess()) {
+    return;
+  }
+
+  if (!mDoc || !GetBrowsingContext() || !GetBrowsingContext()->IsTop()) {
+    return;
+  }
+
+  nsIPrincipal* principal = GetPrincipal();
+  if (!principal || !principal->GetIsContentPrincipal()) {
+    return;
+  }
+
+  IgnoredErrorResult rv;
+  Storage* storage = GetLocalStorage(rv);
+  if (rv.Failed() || !storage || storage->Type() != Storage::eLocalStorage) {
+    return;
+  }
+
+  static_cast<LSObject*>(storage)->Prefetch();
+}
+
 IDBFactory* nsGlobalWindowInner::GetIndexedDB(ErrorResult& aError) {
   if (!mIndexedDB) {
     // This may keep mIndexedDB null without setting an error.
@@ -2497,6 +2497,8 @@ nsresult nsGlobalWindowOuter::SetNewDocument(Document* aDocument,
   mStorageAccessPermissionGranted = ContentBlocking::ShouldAllowAccessFor(
       newInnerWindow, aDocument->GetDocumentURI(), nullptr);
 
+  newInnerWindow->PrefetchLocalStorage();
+
   // Do this here rather than in say the Document constructor, since
   // we need a WindowContext available.
   mDoc->InitUseCounters();
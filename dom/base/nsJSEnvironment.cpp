@@ -72,6 +72,8 @@
 
 #include "mozilla/Preferences.h"
 #include "mozilla/Telemetry.h"
+#include "mozilla/HalTypes.h"
+#include "nsIPropertyBag2.h"
 #include "mozilla/dom/BindingUtils.h"
 #include "mozilla/Attributes.h"
 #include "mozilla/dom/CanvasRenderingContext2DBinding.h"
@@ -112,6 +114,15 @@ static bool sShuttingDown;
 static bool sIsCompactingOnUserInactive = false;
 static bool sUserIsActive = true;
 
+// Set while the content process has a background priority, in which case
+// javascript.options.mem.nursery.background_max_kb caps the nursery.
+static bool sIsInBackground = false;
+static bool sIsCompactingForBackground = false;
+// The size of the GC heap when the current background compaction started.
+static uint32_t sBackgroundCompactionStartBytes = 0;
+
+static void UpdateNurseryMaxBytes();
+
 static TimeDuration sGCUnnotifiedTotalTime;
 
 static CCGCScheduler sScheduler;
@@ -346,6 +357,34 @@ nsJSEnvironmentObserver::Observe(nsISupports* aSubject, const char* aTopic,
       JS::AbortIncrementalGC(jsapi.cx());
     }
     MOZ_ASSERT(!sIsCompactingOnUserInactive);
+  } else if (!nsCRT::strcmp(aTopic, "ipc:process-priority-changed")) {
+    nsCOMPtr<nsIPropertyBag2> props = do_QueryInterface(aSubject);
+    int32_t priority = hal::PROCESS_PRIORITY_UNKNOWN;
+    if (props) {
+      props->GetPropertyAsInt32(u"priority"_ns, &priority);
+    }
+    bool inBackground =
+        priority == hal::PROCESS_PRIORITY_BACKGROUND ||
+        priority == hal::PROCESS_PRIORITY_BACKGROUND_PERCEIVABLE;
+    if (inBackground == sIsInBackground || sShuttingDown) {
+      return NS_OK;
+    }
+    sIsInBackground = inBackground;
+    UpdateNurseryMaxBytes();
+    AutoJSAPI jsapi;
+    jsapi.Init();
+    if (inBackground) {
+      // Whatever the nursery grew to while we were in the foreground is
+      // mostly empty from now on, so give it back right away rather than
+      // waiting for the idle heuristics to get around to it.
+      JS::ShrinkNursery(jsapi.cx(), JS::GCReason::DOM_IPC);
+      if (StaticPrefs::javascript_options_compact_on_background()) {
+        nsJSContext::CompactForBackground();
+      }
+    } else if (sIsCompactingForBackground) {
+      // Compacting would get in the way of the app now that it is visible.
+      JS::AbortIncrementalGC(jsapi.cx());
+    }
   } else if (!nsCRT::strcmp(aTopic, "quit-application") ||
              !nsCRT::strcmp(aTopic, NS_XPCOM_SHUTDOWN_OBSERVER_ID) ||
              !nsCRT::strcmp(aTopic, "content-child-will-shutdown")) {
@@ -1073,6 +1112,7 @@ static RefPtr<MayGCPromise> MayGCNow(JS::GCReason reason) {
     case JS::GCReason::PAGE_HIDE:
     case JS::GCReason::MEM_PRESSURE:
     case JS::GCReason::USER_INACTIVE:
+    case JS::GCReason::BACKGROUND_COMPACTION:
     case JS::GCReason::FULL_GC_TIMER:
     case JS::GCReason::CC_FINISHED: {
       if (XRE_IsContentProcess()) {
@@ -1712,6 +1752,37 @@ void ShrinkingGCTimerFired(nsITimer* aTimer, void* aClosure) {
   }
 }
 
+// static
+void nsJSContext::CompactForBackground() {
+  if (sShuttingDown) {
+    return;
+  }
+
+  RefPtr<MayGCPromise> mbPromise =
+      MayGCNow(JS::GCReason::BACKGROUND_COMPACTION);
+  if (mbPromise) {
+    mbPromise->Then(
+        GetMainThreadSerialEventTarget(), __func__,
+        [](bool aIgnored) {
+          if (sIsInBackground && !sShuttingDown) {
+            sIsCompactingForBackground = true;
+            sScheduler.SetNeedsFullGC();
+            nsJSContext::GarbageCollectNow(JS::GCReason::BACKGROUND_COMPACTION,
+                                           nsJSContext::IncrementalGC,
+                                           nsJSContext::ShrinkingGC);
+          } else {
+            using mozilla::ipc::IdleSchedulerChild;
+            IdleSchedulerChild* child =
+                IdleSchedulerChild::GetMainThreadIdleScheduler();
+            if (child) {
+              child->DoneGC();
+            }
+          }
+        },
+        [](mozilla::ipc::ResponseRejectReason r) {});
+  }
+}
+
 static bool CCRunnerFired(TimeStamp aDeadline) {
   bool didDoWork = false;
 
@@ -2007,6 +2078,9 @@ static void DOMGCSliceCallback(JSContext* aCx, JS::GCProgress aProgress,
       // Prevent cycle collections and shrinking during incremental GC.
       sScheduler.NoteGCBegin();
       sCurrentGCStartTime = TimeStamp::Now();
+      if (aDesc.reason_ == JS::GCReason::BACKGROUND_COMPACTION) {
+        sBackgroundCompactionStartBytes = JS_GetGCParameter(aCx, JSGC_BYTES);
+      }
       break;
     }
 
@@ -2028,8 +2102,19 @@ static void DOMGCSliceCallback(JSContext* aCx, JS::GCProgress aProgress,
         }
       }
 
+      if (aDesc.reason_ == JS::GCReason::BACKGROUND_COMPACTION &&
+          aDesc.isComplete_) {
+        uint32_t endBytes = JS_GetGCParameter(aCx, JSGC_BYTES);
+        uint32_t reclaimed = sBackgroundCompactionStartBytes > endBytes
+                                 ? sBackgroundCompactionStartBytes - endBytes
+                                 : 0;
+        Telemetry::Accumulate(Telemetry::GC_BACKGROUND_COMPACTION_RECLAIMED_KB,
+                              reclaimed / 1024);
+      }
+
       sScheduler.NoteGCEnd();
       sIsCompactingOnUserInactive = false;
+      sIsCompactingForBackground = false;
 
       using mozilla::ipc::IdleSchedulerChild;
       IdleSchedulerChild* child =
@@ -2175,6 +2260,32 @@ static void SetMemoryNurseryPrefChangedCallback(const char* aPrefName,
   }
 }
 
+// The nursery max comes from javascript.options.mem.nursery.max_kb, or from
+// javascript.options.mem.nursery.background_max_kb while we are in the
+// background and that is set.
+static void UpdateNurseryMaxBytes() {
+  int32_t prefKB = -1;
+  if (sIsInBackground) {
+    prefKB = Preferences::GetInt(
+        "javascript.options.mem.nursery.background_max_kb", -1);
+  }
+  if (prefKB < 0) {
+    prefKB = Preferences::GetInt("javascript.options.mem.nursery.max_kb", -1);
+  }
+  // handle overflow and negative pref values
+  CheckedInt<int32_t> prefB = CheckedInt<int32_t>(prefKB) * 1024;
+  if (prefB.isValid() && prefB.value() >= 0) {
+    SetGCParameter(JSGC_MAX_NURSERY_BYTES, prefB.value());
+  } else {
+    ResetGCParameter(JSGC_MAX_NURSERY_BYTES);
+  }
+}
+
+static void SetMemoryNurseryMaxPrefChangedCallback(const char* aPrefName,
+                                                   void* aClosure) {
+  UpdateNurseryMaxBytes();
+}
+
 static void SetMemoryPrefChangedCallbackInt(const char* aPrefName,
                                             void* aClosure) {
   int32_t pref = Preferences::GetInt(aPrefName, -1);
@@ -2295,9 +2406,12 @@ void nsJSContext::EnsureStatics() {
   Preferences::RegisterCallbackAndCall(SetMemoryNurseryPrefChangedCallback,
                                        "javascript.options.mem.nursery.min_kb",
                                        (void*)JSGC_MIN_NURSERY_BYTES);
-  Preferences::RegisterCallbackAndCall(SetMemoryNurseryPrefChangedCallback,
-                                       "javascript.options.mem.nursery.max_kb",
-                                       (void*)JSGC_MAX_NURSERY_BYTES);
+  Preferences::RegisterCallbackAndCall(
+      SetMemoryNurseryMaxPrefChangedCallback,
+      "javascript.options.mem.nursery.max_kb");
+  Preferences::RegisterCallback(
+      SetMemoryNurseryMaxPrefChangedCallback,
+      "javascript.options.mem.nursery.background_max_kb");
 
   Preferences::RegisterCallbackAndCall(SetMemoryPrefChangedCallbackBool,
                                        "javascript.options.mem.gc_per_zone",
@@ -2399,6 +2513,9 @@ void nsJSContext::EnsureStatics() {
   obs->AddObserver(observer, "quit-application", false);
   obs->AddObserver(observer, NS_XPCOM_SHUTDOWN_OBSERVER_ID, false);
   obs->AddObserver(observer, "content-child-will-shutdown", false);
+  if (XRE_IsContentProcess()) {
+    obs->AddObserver(observer, "ipc:process-priority-changed", false);
+  }
 
   sIsInitialized = true;
 }
@@ -107,6 +107,10 @@ class nsJSContext : public nsIScriptContext {
   static void PokeShrinkingGC();
   static void KillShrinkingGCTimer();
 
+  // Starts an incremental shrinking GC of the whole heap, once the parent lets
+  // us, because the process has just been moved to the background.
+  static void CompactForBackground();
+
   static void MaybePokeCC();
   static void EnsureCCRunner(mozilla::TimeDuration aDelay,
                              mozilla::TimeDuration aBudget);
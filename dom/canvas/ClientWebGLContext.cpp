@@ -16,7 +16,9 @@
 #include "mozilla/dom/WebGLContextEvent.h"
 #include "mozilla/dom/WorkerCommon.h"
 #include "mozilla/EnumeratedRange.h"
+#include "mozilla/EventListenerManager.h"
 #include "mozilla/gfx/gfxVars.h"
+#include "mozilla/HalTypes.h"
 #include "mozilla/ipc/Shmem.h"
 #include "mozilla/layers/CompositorBridgeChild.h"
 #include "mozilla/layers/ImageBridgeChild.h"
@@ -27,9 +29,14 @@
 #include "mozilla/layers/WebRenderCanvasRenderer.h"
 #include "mozilla/Preferences.h"
 #include "mozilla/ScopeExit.h"
+#include "mozilla/Services.h"
 #include "mozilla/StaticPrefs_webgl.h"
 #include "nsContentUtils.h"
 #include "nsDisplayList.h"
+#include "nsIObserver.h"
+#include "nsIObserverService.h"
+#include "nsIPropertyBag2.h"
+#include "nsXULAppAPI.h"
 #include "TexUnpackBlob.h"
 #include "WebGLMethodDispatcher.h"
 #include "WebGLChild.h"
@@ -112,11 +119,65 @@ static bool GetJSScalarFromGLType(GLenum type,
   }
 }
 
+// Main-thread contexts of this process, for OnProcessBackgroundChanged().
+static std::unordered_set<ClientWebGLContext*>& MainThreadContexts() {
+  MOZ_ASSERT(NS_IsMainThread());
+  static auto* sContexts = new std::unordered_set<ClientWebGLContext*>();
+  return *sContexts;
+}
+
+class WebGLProcessPriorityObserver final : public nsIObserver {
+ public:
+  NS_DECL_ISUPPORTS
+
+  static void EnsureRegistered() {
+    static bool sRegistered = false;
+    if (sRegistered || !XRE_IsContentProcess()) {
+      return;
+    }
+    sRegistered = true;
+
+    nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+    if (obs) {
+      obs->AddObserver(new WebGLProcessPriorityObserver(),
+                       "ipc:process-priority-changed", false);
+    }
+  }
+
+  NS_IMETHOD Observe(nsISupports* aSubject, const char* aTopic,
+                     const char16_t*) override {
+    MOZ_ASSERT(!strcmp(aTopic, "ipc:process-priority-changed"));
+    nsCOMPtr<nsIPropertyBag2> props = do_QueryInterface(aSubject);
+    int32_t priority = hal::PROCESS_PRIORITY_UNKNOWN;
+    if (props) {
+      props->GetPropertyAsInt32(u"priority"_ns, &priority);
+    }
+    ClientWebGLContext::OnProcessBackgroundChanged(
+        priority == hal::PROCESS_PRIORITY_BACKGROUND);
+    return NS_OK;
+  }
+
+ private:
+  ~WebGLProcessPriorityObserver() = default;
+};
+
+NS_IMPL_ISUPPORTS(WebGLProcessPriorityObserver, nsIObserver)
+
 ClientWebGLContext::ClientWebGLContext(const bool webgl2)
     : mIsWebGL2(webgl2),
-      mExtLoseContext(new ClientWebGLExtensionLoseContext(*this)) {}
+      mExtLoseContext(new ClientWebGLExtensionLoseContext(*this)) {
+  if (NS_IsMainThread()) {
+    MainThreadContexts().insert(this);
+    WebGLProcessPriorityObserver::EnsureRegistered();
+  }
+}
 
-ClientWebGLContext::~ClientWebGLContext() { RemovePostRefreshObserver(); }
+ClientWebGLContext::~ClientWebGLContext() {
+  if (NS_IsMainThread()) {
+    MainThreadContexts().erase(this);
+  }
+  RemovePostRefreshObserver();
+}
 
 void ClientWebGLContext::JsWarning(const std::string& utf8) const {
   if (!mCanvasElement) {
@@ -217,6 +278,51 @@ void ClientWebGLContext::Event_webglcontextlost() const {
     mLossStatus = webgl::LossStatus::LostForever;
   }
 
+  if (mLossStatus == webgl::LossStatus::Lost && !mLostForBackground) {
+    RestoreContext(webgl::LossStatus::Lost);
+  }
+}
+
+/* static */
+void ClientWebGLContext::OnProcessBackgroundChanged(const bool background) {
+  MOZ_ASSERT(NS_IsMainThread());
+  if (!StaticPrefs::webgl_lose_context_in_background()) {
+    return;
+  }
+
+  for (const auto& context : MainThreadContexts()) {
+    if (background) {
+      context->LoseForBackground();
+    } else {
+      context->RestoreFromBackground();
+    }
+  }
+}
+
+void ClientWebGLContext::LoseForBackground() const {
+  if (mLossStatus != webgl::LossStatus::Ready || !mCanvasElement) {
+    return;
+  }
+
+  // A page that doesn't handle webglcontextlost would never get its context
+  // back, so only contexts that are ready to be restored are released.
+  EventListenerManager* elm = mCanvasElement->GetExistingListenerManager();
+  if (!elm || !elm->HasListenersFor(u"webglcontextlost"_ns)) {
+    return;
+  }
+
+  mLostForBackground = true;
+  OnContextLoss(webgl::ContextLossReason::None);
+}
+
+void ClientWebGLContext::RestoreFromBackground() const {
+  if (!mLostForBackground) {
+    return;
+  }
+  mLostForBackground = false;
+
+  // If the page declined the restore in its webglcontextlost handler the
+  // context is lost for good and stays that way.
   if (mLossStatus == webgl::LossStatus::Lost) {
     RestoreContext(webgl::LossStatus::Lost);
   }
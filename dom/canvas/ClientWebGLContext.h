@@ -728,6 +728,8 @@ class ClientWebGLContext final : public nsICanvasRenderingContextInternal,
   mutable GLenum mNextError = 0;
   mutable webgl::LossStatus mLossStatus = webgl::LossStatus::Ready;
   mutable bool mAwaitingRestore = false;
+  // Set while the context is lost because the process is in the background.
+  mutable bool mLostForBackground = false;
 
   // -
 
@@ -759,6 +761,14 @@ class ClientWebGLContext final : public nsICanvasRenderingContextInternal,
   void OnContextLoss(webgl::ContextLossReason) const;
   void RestoreContext(webgl::LossStatus requiredStatus) const;
 
+  // Releases the GL resources of main-thread contexts when the process goes
+  // to the background, and restores them when it comes back.
+  static void OnProcessBackgroundChanged(bool background);
+
+ private:
+  void LoseForBackground() const;
+  void RestoreFromBackground() const;
+
  private:
   bool DispatchEvent(const nsAString&) const;
   void Event_webglcontextlost() const;
@@ -6,14 +6,23 @@
 
 #include "FetchUtil.h"
 
+#include "js/BuildId.h"               // JS::BuildIdCharVector
 #include "js/friend/ErrorMessages.h"  // JSMSG_*
 #include "nsCRT.h"
 #include "nsError.h"
 #include "nsIAsyncInputStream.h"
+#include "nsIAsyncOutputStream.h"
+#include "nsICacheInfoChannel.h"
 #include "nsIHttpChannel.h"
 #include "nsNetUtil.h"
+#include "nsProxyRelease.h"
 #include "nsStreamUtils.h"
 #include "nsString.h"
+#include "mozilla/ClearOnShutdown.h"
+#include "mozilla/ScopeExit.h"
+#include "mozilla/StaticPrefs_javascript.h"
+#include "mozilla/StaticPtr.h"
+#include "mozilla/Vector.h"
 #include "mozilla/dom/Document.h"
 
 #include "mozilla/dom/DOMException.h"
@@ -53,6 +62,25 @@ nsresult FetchUtil::GetValidRequestMethod(const nsACString& aMethod,
   return NS_OK;
 }
 
+static StaticAutoPtr<nsCString> sWasmAltDataType;
+
+// static
+const nsCString& FetchUtil::WasmAltDataType() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (!sWasmAltDataType) {
+    sWasmAltDataType = new nsCString(WASM_ALT_DATA_TYPE_V1 "-");
+    ClearOnShutdown(&sWasmAltDataType);
+
+    JS::BuildIdCharVector buildId;
+    if (!JS::GetOptimizedEncodingBuildId(&buildId)) {
+      MOZ_CRASH("build id oom");
+    }
+    sWasmAltDataType->Append(buildId.begin(), buildId.length());
+  }
+  return *sWasmAltDataType;
+}
+
 static bool FindCRLF(nsACString::const_iterator& aStart,
                      nsACString::const_iterator& aEnd) {
   nsACString::const_iterator end(aEnd);
@@ -302,17 +330,29 @@ class WorkerStreamOwner final {
   RefPtr<WeakWorkerRef> mWorkerRef;
 };
 
-class JSStreamConsumer final : public nsIInputStreamCallback {
+class JSStreamConsumer final : public nsIInputStreamCallback,
+                               public JS::OptimizedEncodingListener {
   nsCOMPtr<nsIEventTarget> mOwningEventTarget;
   RefPtr<WindowStreamOwner> mWindowStreamOwner;
   RefPtr<WorkerStreamOwner> mWorkerStreamOwner;
+  // The cache entry of the response, if the compiled module should be saved
+  // to it once it is ready.
+  nsMainThreadPtrHandle<nsICacheInfoChannel> mCache;
+  // Whether the stream is a previously saved compiled module rather than
+  // the response body.
+  const bool mOptimizedEncoding;
+  Vector<uint8_t> mOptimizedEncodingBytes;
   JS::StreamConsumer* mConsumer;
   bool mConsumerAborted;
 
   JSStreamConsumer(already_AddRefed<WindowStreamOwner> aWindowStreamOwner,
-                   nsIGlobalObject* aGlobal, JS::StreamConsumer* aConsumer)
+                   nsIGlobalObject* aGlobal, JS::StreamConsumer* aConsumer,
+                   nsMainThreadPtrHandle<nsICacheInfoChannel>&& aCache,
+                   bool aOptimizedEncoding)
       : mOwningEventTarget(aGlobal->EventTargetFor(TaskCategory::Other)),
         mWindowStreamOwner(aWindowStreamOwner),
+        mCache(std::move(aCache)),
+        mOptimizedEncoding(aOptimizedEncoding),
         mConsumer(aConsumer),
         mConsumerAborted(false) {
     MOZ_DIAGNOSTIC_ASSERT(mWindowStreamOwner);
@@ -323,6 +363,7 @@ class JSStreamConsumer final : public nsIInputStreamCallback {
                    nsIGlobalObject* aGlobal, JS::StreamConsumer* aConsumer)
       : mOwningEventTarget(aGlobal->EventTargetFor(TaskCategory::Other)),
         mWorkerStreamOwner(std::move(aWorkerStreamOwner)),
+        mOptimizedEncoding(false),
         mConsumer(aConsumer),
         mConsumerAborted(false) {
     MOZ_DIAGNOSTIC_ASSERT(mWorkerStreamOwner);
@@ -354,7 +395,14 @@ class JSStreamConsumer final : public nsIInputStreamCallback {
 
     // This callback can be called on any thread which is explicitly allowed by
     // this particular JS API call.
-    if (!self->mConsumer->consumeChunk((const uint8_t*)aFromSegment, aCount)) {
+    if (self->mOptimizedEncoding) {
+      // The saved module is deserialized in one go once it is all here.
+      if (!self->mOptimizedEncodingBytes.append(
+              (const uint8_t*)aFromSegment, aCount)) {
+        return NS_ERROR_OUT_OF_MEMORY;
+      }
+    } else if (!self->mConsumer->consumeChunk((const uint8_t*)aFromSegment,
+                                              aCount)) {
       self->mConsumerAborted = true;
       return NS_ERROR_UNEXPECTED;
     }
@@ -366,9 +414,14 @@ class JSStreamConsumer final : public nsIInputStreamCallback {
  public:
   NS_DECL_THREADSAFE_ISUPPORTS
 
-  static bool Start(nsCOMPtr<nsIInputStream>&& aStream,
-                    JS::StreamConsumer* aConsumer, nsIGlobalObject* aGlobal,
-                    WorkerPrivate* aMaybeWorker) {
+  static bool Start(
+      nsCOMPtr<nsIInputStream>&& aStream, JS::StreamConsumer* aConsumer,
+      nsIGlobalObject* aGlobal, WorkerPrivate* aMaybeWorker,
+      nsMainThreadPtrHandle<nsICacheInfoChannel>&& aCache = nullptr,
+      bool aOptimizedEncoding = false) {
+    // The cache entry is main thread only.
+    MOZ_ASSERT_IF(aCache != nullptr || aOptimizedEncoding, !aMaybeWorker);
+
     nsCOMPtr<nsIAsyncInputStream> asyncStream;
     nsresult rv = NS_MakeAsyncNonBlockingInputStream(
         aStream.forget(), getter_AddRefs(asyncStream));
@@ -392,7 +445,8 @@ class JSStreamConsumer final : public nsIInputStreamCallback {
         return false;
       }
 
-      consumer = new JSStreamConsumer(owner.forget(), aGlobal, aConsumer);
+      consumer = new JSStreamConsumer(owner.forget(), aGlobal, aConsumer,
+                                      std::move(aCache), aOptimizedEncoding);
     }
 
     // This AsyncWait() creates a ref-cycle between asyncStream and consumer:
@@ -421,7 +475,15 @@ class JSStreamConsumer final : public nsIInputStreamCallback {
     }
 
     if (rv == NS_BASE_STREAM_CLOSED) {
-      mConsumer->streamEnd();
+      if (mOptimizedEncoding) {
+        mConsumer->consumeOptimizedEncoding(mOptimizedEncodingBytes.begin(),
+                                            mOptimizedEncodingBytes.length());
+      } else {
+        // If we have the response's cache entry, listen for the compiled
+        // module so we can save it there. The compilation holds a reference
+        // to 'this' until it has called storeOptimizedEncoding(), if ever.
+        mConsumer->streamEnd(mCache != nullptr ? this : nullptr);
+      }
       return NS_OK;
     }
 
@@ -450,10 +512,93 @@ class JSStreamConsumer final : public nsIInputStreamCallback {
 
     return NS_OK;
   }
+
+  // JS::OptimizedEncodingListener:
+
+  void storeOptimizedEncoding(
+      JS::UniqueOptimizedEncodingBytes aBytes) override {
+    MOZ_ASSERT(mCache != nullptr,
+               "we only listen if there's a cache entry");
+
+    // Called on a compilation helper thread.
+    RefPtr<JSStreamConsumer> self = this;
+    NS_DispatchToMainThread(NS_NewRunnableFunction(
+        "JSStreamConsumer::storeOptimizedEncoding",
+        [self, bytes = std::move(aBytes)]() {
+          self->StoreOptimizedEncoding(*bytes);
+        }));
+  }
+
+ private:
+  void StoreOptimizedEncoding(const JS::OptimizedEncodingBytes& aBytes) {
+    MOZ_ASSERT(NS_IsMainThread());
+
+    nsCOMPtr<nsIAsyncOutputStream> stream;
+    nsresult rv = mCache->OpenAlternativeOutputStream(
+        FetchUtil::WasmAltDataType(), int64_t(aBytes.length()),
+        getter_AddRefs(stream));
+    if (NS_FAILED(rv)) {
+      // Too big for the cache, or someone is reading the old one.
+      return;
+    }
+
+    auto closeStream = MakeScopeExit([&]() { stream->CloseWithStatus(rv); });
+
+    uint32_t written;
+    rv = stream->Write((const char*)aBytes.begin(), aBytes.length(), &written);
+    if (NS_SUCCEEDED(rv) && written != aBytes.length()) {
+      rv = NS_ERROR_FAILURE;
+    }
+  }
 };
 
 NS_IMPL_ISUPPORTS(JSStreamConsumer, nsIInputStreamCallback)
 
+// Waits for the compiled module saved with the response's cache entry, and
+// streams either that or, if there is none, the response body to the JS
+// consumer.
+class WasmAltDataReceiver final : public nsIInputStreamReceiver {
+ public:
+  NS_DECL_ISUPPORTS
+
+  WasmAltDataReceiver(nsCOMPtr<nsIInputStream>&& aBody,
+                      JS::StreamConsumer* aConsumer, nsIGlobalObject* aGlobal,
+                      const nsMainThreadPtrHandle<nsICacheInfoChannel>& aCache)
+      : mBody(std::move(aBody)),
+        mConsumer(aConsumer),
+        mGlobal(aGlobal),
+        mCache(aCache) {}
+
+  NS_IMETHOD OnInputStreamReady(nsIInputStream* aAltDataStream) override {
+    MOZ_ASSERT(NS_IsMainThread());
+
+    if (aAltDataStream) {
+      nsCOMPtr<nsIInputStream> altData = aAltDataStream;
+      if (JSStreamConsumer::Start(std::move(altData), mConsumer, mGlobal,
+                                  nullptr, nullptr,
+                                  /* aOptimizedEncoding */ true)) {
+        return NS_OK;
+      }
+    }
+
+    if (!JSStreamConsumer::Start(std::move(mBody), mConsumer, mGlobal, nullptr,
+                                 std::move(mCache))) {
+      mConsumer->streamError(size_t(NS_ERROR_OUT_OF_MEMORY));
+    }
+    return NS_OK;
+  }
+
+ private:
+  ~WasmAltDataReceiver() = default;
+
+  nsCOMPtr<nsIInputStream> mBody;
+  JS::StreamConsumer* mConsumer;
+  nsCOMPtr<nsIGlobalObject> mGlobal;
+  nsMainThreadPtrHandle<nsICacheInfoChannel> mCache;
+};
+
+NS_IMPL_ISUPPORTS(WasmAltDataReceiver, nsIInputStreamReceiver)
+
 static bool ThrowException(JSContext* aCx, unsigned errorNumber) {
   JS_ReportErrorNumberASCII(aCx, js::GetErrorMessage, nullptr, errorNumber);
   return false;
@@ -544,6 +689,27 @@ bool FetchUtil::StreamResponseToJS(JSContext* aCx, JS::HandleObject aObj,
 
   nsIGlobalObject* global = xpc::NativeGlobal(js::UncheckedUnwrap(aObj));
 
+  // Responses from the HTTP cache can have the module compiled from them by
+  // an earlier streaming compilation saved with them, in which case we can
+  // skip compiling it again.
+  nsMainThreadPtrHandle<nsICacheInfoChannel> cache;
+  if (!aMaybeWorker && StaticPrefs::javascript_options_wasm_caching() &&
+      aMimeType == JS::MimeType::Wasm) {
+    cache = ir->TakeCacheInfoChannel();
+  }
+  if (cache) {
+    RefPtr<WasmAltDataReceiver> receiver =
+        new WasmAltDataReceiver(std::move(body), aConsumer, global, cache);
+    if (NS_SUCCEEDED(cache->GetAltDataInputStream(
+            FetchUtil::WasmAltDataType(), receiver))) {
+      return true;
+    }
+    // No saved module; the receiver hasn't been called and still has the
+    // body.
+    receiver->OnInputStreamReady(nullptr);
+    return true;
+  }
+
   if (!JSStreamConsumer::Start(std::move(body), aConsumer, global,
                                aMaybeWorker)) {
     return ThrowException(aCx, JSMSG_OUT_OF_MEMORY);
@@ -48,6 +48,13 @@ class FetchUtil final {
                             nsCString& aHeaderName, nsCString& aHeaderValue,
                             bool* aWasEmptyHeader);
 
+  /**
+   * The alternative data type wasm modules compiled from a response are saved
+   * under in the HTTP cache. It includes the JS build id, so that modules
+   * compiled by another build are never used.
+   */
+  static const nsCString& WasmAltDataType();
+
   static nsresult SetRequestReferrer(nsIPrincipal* aPrincipal, Document* aDoc,
                                      nsIHttpChannel* aChannel,
                                      InternalRequest& aRequest);
@@ -5,17 +5,38 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "MemoryBlobImpl.h"
+#include "mozilla/dom/ContentChild.h"
+#include "mozilla/ipc/FileDescriptor.h"
+#include "mozilla/ipc/InputStreamParams.h"
+#include "mozilla/ipc/InputStreamUtils.h"
 #include "mozilla/IntegerPrintfMacros.h"
+#include "mozilla/Services.h"
 #include "mozilla/SHA1.h"
+#include "mozilla/StaticPrefs_dom.h"
+#include "nsAnonymousTemporaryFile.h"
 #include "nsIMemoryReporter.h"
+#include "nsIObserver.h"
+#include "nsIObserverService.h"
 #include "nsMemory.h"
 #include "nsPrintfCString.h"
 #include "nsRFPService.h"
 #include "nsStringStream.h"
+#include "nsThreadUtils.h"
+#include "nsXULAppAPI.h"
+#include "prio.h"
 #include "prtime.h"
 
+#include <algorithm>
+
+#ifdef XP_LINUX
+#  include <fcntl.h>
+#  include "private/pprio.h"
+#endif
+
 namespace mozilla::dom {
 
+using namespace mozilla::ipc;
+
 NS_IMPL_ADDREF(MemoryBlobImpl::DataOwnerAdapter)
 NS_IMPL_RELEASE(MemoryBlobImpl::DataOwnerAdapter)
 
@@ -49,6 +70,37 @@ already_AddRefed<MemoryBlobImpl> MemoryBlobImpl::CreateWithLastModifiedNow(
                                       aContentType, lastModificationDate);
 }
 
+// static
+already_AddRefed<MemoryBlobImpl> MemoryBlobImpl::CreateFromFileDescriptor(
+    PRFileDesc* aFD, uint64_t aLength, const nsAString& aName,
+    const nsAString& aContentType, int64_t aLastModifiedDate) {
+  MOZ_ASSERT(aFD);
+
+  // PR_MemMap() can't map more than 4GB, nor an empty file.
+  PRFileMap* fileMap = nullptr;
+  void* mapping = nullptr;
+  if (aLength && aLength <= UINT32_MAX) {
+    fileMap = PR_CreateFileMap(aFD, aLength, PR_PROT_READONLY);
+    if (fileMap) {
+      mapping = PR_MemMap(fileMap, 0, uint32_t(aLength));
+    }
+  }
+
+  if (!mapping) {
+    NS_WARNING("Failed to map a file for a memory blob");
+    if (fileMap) {
+      PR_CloseFileMap(fileMap);
+    }
+    PR_Close(aFD);
+    return nullptr;
+  }
+
+  RefPtr<DataOwner> owner = new DataOwner(aFD, fileMap, mapping, aLength);
+  RefPtr<MemoryBlobImpl> blobImpl =
+      new MemoryBlobImpl(owner, aName, aContentType, aLastModifiedDate);
+  return blobImpl.forget();
+}
+
 nsresult MemoryBlobImpl::DataOwnerAdapter::Create(DataOwner* aDataOwner,
                                                   uint32_t aStart,
                                                   uint32_t aLength,
@@ -58,18 +110,84 @@ nsresult MemoryBlobImpl::DataOwnerAdapter::Create(DataOwner* aDataOwner,
 
   nsCOMPtr<nsIInputStream> stream;
 
-  rv = NS_NewByteInputStream(
-      getter_AddRefs(stream),
-      Span(static_cast<const char*>(aDataOwner->mData) + aStart, aLength),
-      NS_ASSIGNMENT_DEPEND);
-  NS_ENSURE_SUCCESS(rv, rv);
+  const char* data = aDataOwner->AcquireData();
+  rv = NS_NewByteInputStream(getter_AddRefs(stream),
+                             Span(data + aStart, aLength),
+                             NS_ASSIGNMENT_DEPEND);
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    aDataOwner->ReleaseData();
+    return rv;
+  }
 
-  NS_ADDREF(*_retval =
-                new MemoryBlobImpl::DataOwnerAdapter(aDataOwner, stream));
+  NS_ADDREF(*_retval = new MemoryBlobImpl::DataOwnerAdapter(
+                aDataOwner, stream, aStart, aLength));
 
   return NS_OK;
 }
 
+void MemoryBlobImpl::DataOwnerAdapter::Serialize(
+    InputStreamParams& aParams, FileDescriptorArray& aFileDescriptors,
+    bool aDelayedStart, uint32_t aMaxSize, uint32_t* aSizeUsed,
+    ParentToChildStreamActorManager* aManager) {
+  SerializeInternal(aParams, aFileDescriptors, aDelayedStart, aMaxSize,
+                    aSizeUsed, aManager);
+}
+
+void MemoryBlobImpl::DataOwnerAdapter::Serialize(
+    InputStreamParams& aParams, FileDescriptorArray& aFileDescriptors,
+    bool aDelayedStart, uint32_t aMaxSize, uint32_t* aSizeUsed,
+    ChildToParentStreamActorManager* aManager) {
+  SerializeInternal(aParams, aFileDescriptors, aDelayedStart, aMaxSize,
+                    aSizeUsed, aManager);
+}
+
+template <typename M>
+void MemoryBlobImpl::DataOwnerAdapter::SerializeInternal(
+    InputStreamParams& aParams, FileDescriptorArray& aFileDescriptors,
+    bool aDelayedStart, uint32_t aMaxSize, uint32_t* aSizeUsed,
+    M* aManager) {
+  MOZ_ASSERT(aSizeUsed);
+
+  int64_t pos = 0;
+  UniqueFileHandle file;
+  if (NS_SUCCEEDED(mSeekableStream->Tell(&pos)) && pos >= 0 &&
+      uint64_t(pos) <= mLength) {
+    file = mDataOwner->OpenFile();
+  }
+  if (!file) {
+    mSerializableInputStream->Serialize(aParams, aFileDescriptors,
+                                        aDelayedStart, aMaxSize, aSizeUsed,
+                                        aManager);
+    return;
+  }
+
+  // The other side reads the unread part of the slice straight from the
+  // temporary file, nothing is copied.
+  *aSizeUsed = 0;
+
+  FileInputStreamParams fileParams;
+  aFileDescriptors.AppendElement(FileDescriptor(std::move(file)));
+  fileParams.fileDescriptorIndex() = aFileDescriptors.Length() - 1;
+  fileParams.behaviorFlags() = 0;
+  fileParams.ioFlags() = PR_RDONLY;
+
+  SlicedInputStreamParams params;
+  params.stream() = fileParams;
+  params.start() = mStart + pos;
+  params.length() = mLength - pos;
+  params.curPos() = 0;
+  params.closed() = false;
+
+  aParams = params;
+}
+
+bool MemoryBlobImpl::DataOwnerAdapter::Deserialize(
+    const InputStreamParams& aParams,
+    const FileDescriptorArray& aFileDescriptors) {
+  MOZ_CRASH("This should never be called!");
+  return false;
+}
+
 already_AddRefed<BlobImpl> MemoryBlobImpl::CreateSlice(
     uint64_t aStart, uint64_t aLength, const nsAString& aContentType,
     ErrorResult& aRv) {
@@ -98,6 +216,260 @@ StaticMutex MemoryBlobImpl::DataOwner::sDataOwnerMutex;
 /* static */
 bool MemoryBlobImpl::DataOwner::sMemoryReporterRegistered = false;
 
+MemoryBlobImpl::DataOwner::~DataOwner() {
+  mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
+
+  remove();
+  if (sDataOwners->isEmpty()) {
+    // Free the linked list if it's empty.
+    sDataOwners = nullptr;
+  }
+
+  if (mMapping) {
+    PR_MemUnmap(mMapping, mLength);
+    PR_CloseFileMap(mFileMap);
+  }
+  if (mFD) {
+    PR_Close(mFD);
+  }
+  if (mState != SpillState::Spilled) {
+    free(mData);
+  }
+}
+
+bool MemoryBlobImpl::DataOwner::TryAddRef() {
+  sDataOwnerMutex.AssertCurrentThreadOwns();
+
+  // An owner whose count dropped to 0 is waiting for sDataOwnerMutex in its
+  // destructor and must not be retained again.
+  nsrefcnt count = mRefCnt;
+  while (count > 0) {
+    if (mRefCnt.compareExchange(count, count + 1)) {
+      NS_LOG_ADDREF(this, count + 1, "DataOwner", sizeof(*this));
+      return true;
+    }
+    count = mRefCnt;
+  }
+  return false;
+}
+
+const char* MemoryBlobImpl::DataOwner::AcquireData() {
+  mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
+  ++mStreams;
+  return static_cast<const char*>(mData);
+}
+
+void MemoryBlobImpl::DataOwner::ReleaseData() {
+  mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
+  MOZ_ASSERT(mStreams > 0);
+  if (--mStreams == 0 && mState == SpillState::Mapped) {
+    SwapToMapping();
+  }
+}
+
+bool MemoryBlobImpl::DataOwner::IsSpilled() const {
+  mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
+  return mState == SpillState::Spilled;
+}
+
+void MemoryBlobImpl::DataOwner::SwapToMapping() {
+  sDataOwnerMutex.AssertCurrentThreadOwns();
+  MOZ_ASSERT(mState == SpillState::Mapped);
+  MOZ_ASSERT(!mStreams);
+
+  free(mData);
+  mData = mMapping;
+  mState = SpillState::Spilled;
+}
+
+void MemoryBlobImpl::DataOwner::MaybeSpillLarge() {
+  uint32_t threshold = StaticPrefs::dom_blob_spill_threshold();
+  if (threshold && mLength >= threshold) {
+    Spill();
+  }
+}
+
+/* static */
+void MemoryBlobImpl::DataOwner::SpillAll() {
+  nsTArray<RefPtr<DataOwner>> owners;
+  {
+    mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
+    if (!sDataOwners) {
+      return;
+    }
+
+    uint32_t minSize = StaticPrefs::dom_blob_spill_min_size();
+    for (DataOwner* owner = sDataOwners->getFirst(); owner;
+         owner = owner->getNext()) {
+      if (owner->mState == SpillState::Memory && owner->mLength >= minSize &&
+          owner->TryAddRef()) {
+        owners.AppendElement(dont_AddRef(owner));
+      }
+    }
+  }
+
+  for (auto& owner : owners) {
+    owner->Spill();
+  }
+}
+
+void MemoryBlobImpl::DataOwner::Spill() {
+  {
+    mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
+    // PR_MemMap() can't map more than 4GB at once.
+    if (mState != SpillState::Memory || !mLength || mLength > UINT32_MAX) {
+      return;
+    }
+    mState = SpillState::Spilling;
+  }
+
+  RefPtr<DataOwner> self = this;
+  auto failed = [self]() {
+    mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
+    self->mState = SpillState::Failed;
+  };
+
+  if (XRE_IsParentProcess()) {
+    nsresult rv = NS_DispatchBackgroundTask(
+        NS_NewRunnableFunction("MemoryBlobImpl::DataOwner::Spill", [self]() {
+          PRFileDesc* fd = nullptr;
+          if (NS_FAILED(NS_OpenAnonymousTemporaryFile(&fd))) {
+            fd = nullptr;
+          }
+          self->WriteAndMap(fd);
+        }),
+        NS_DISPATCH_EVENT_MAY_BLOCK);
+    if (NS_FAILED(rv)) {
+      failed();
+    }
+    return;
+  }
+
+  if (!XRE_IsContentProcess()) {
+    failed();
+    return;
+  }
+
+  // Content processes can't create files, the parent opens one for us.
+  nsresult rv = NS_DispatchToMainThread(NS_NewRunnableFunction(
+      "MemoryBlobImpl::DataOwner::Spill", [self, failed]() {
+        ContentChild* child = ContentChild::GetSingleton();
+        nsresult rv = NS_ERROR_FAILURE;
+        if (child) {
+          rv = child->AsyncOpenAnonymousTemporaryFile([self](PRFileDesc* aFD) {
+            nsresult dispatched = NS_DispatchBackgroundTask(
+                NS_NewRunnableFunction(
+                    "MemoryBlobImpl::DataOwner::WriteAndMap",
+                    [self, aFD]() { self->WriteAndMap(aFD); }),
+                NS_DISPATCH_EVENT_MAY_BLOCK);
+            if (NS_FAILED(dispatched)) {
+              if (aFD) {
+                PR_Close(aFD);
+              }
+              mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
+              self->mState = SpillState::Failed;
+            }
+          });
+        }
+        if (NS_FAILED(rv)) {
+          failed();
+        }
+      }));
+  if (NS_FAILED(rv)) {
+    failed();
+  }
+}
+
+void MemoryBlobImpl::DataOwner::WriteAndMap(PRFileDesc* aFD) {
+  MOZ_ASSERT(!NS_IsMainThread());
+
+  // Nothing frees the heap buffer while we're Spilling, it can be read
+  // without the lock.
+  PRFileMap* fileMap = nullptr;
+  void* mapping = nullptr;
+  if (aFD) {
+    const char* data = static_cast<const char*>(mData);
+    uint64_t written = 0;
+    while (written < mLength) {
+      int32_t chunk = int32_t(std::min<uint64_t>(mLength - written, INT32_MAX));
+      int32_t rv = PR_Write(aFD, data + written, chunk);
+      if (rv <= 0) {
+        break;
+      }
+      written += rv;
+    }
+
+    if (written == mLength) {
+      fileMap = PR_CreateFileMap(aFD, mLength, PR_PROT_READONLY);
+      if (fileMap) {
+        mapping = PR_MemMap(fileMap, 0, uint32_t(mLength));
+      }
+    }
+  }
+
+  mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
+  MOZ_ASSERT(mState == SpillState::Spilling);
+
+  if (!mapping) {
+    NS_WARNING("Failed to spill a memory blob to a temporary file");
+    if (fileMap) {
+      PR_CloseFileMap(fileMap);
+    }
+    if (aFD) {
+      PR_Close(aFD);
+    }
+    mState = SpillState::Failed;
+    return;
+  }
+
+  mFD = aFD;
+  mFileMap = fileMap;
+  mMapping = mapping;
+  mState = SpillState::Mapped;
+
+  // Streams created before the spill keep reading the heap buffer, the last
+  // one to go away swaps it for the mapping.
+  if (!mStreams) {
+    SwapToMapping();
+  }
+}
+
+UniqueFileHandle MemoryBlobImpl::DataOwner::OpenFile() {
+#ifdef XP_LINUX
+  mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
+  if (mState != SpillState::Mapped && mState != SpillState::Spilled) {
+    return nullptr;
+  }
+
+  // The file is already unlinked. Reopening it through /proc gives the
+  // receiver an offset of its own, a dup() would share ours with every
+  // other process the blob was sent to.
+  nsPrintfCString path("/proc/self/fd/%d",
+                       int(PR_FileDesc2NativeHandle(mFD)));
+  return UniqueFileHandle(open(path.get(), O_RDONLY | O_CLOEXEC));
+#else
+  return nullptr;
+#endif
+}
+
+class MemoryBlobImplMemoryPressureObserver final : public nsIObserver {
+  ~MemoryBlobImplMemoryPressureObserver() = default;
+
+ public:
+  NS_DECL_ISUPPORTS
+
+  NS_IMETHOD Observe(nsISupports* aSubject, const char* aTopic,
+                     const char16_t* aData) override {
+    MOZ_ASSERT(!strcmp(aTopic, "memory-pressure"));
+    if (StaticPrefs::dom_blob_spill_on_memory_pressure()) {
+      MemoryBlobImpl::DataOwner::SpillAll();
+    }
+    return NS_OK;
+  }
+};
+
+NS_IMPL_ISUPPORTS(MemoryBlobImplMemoryPressureObserver, nsIObserver)
+
 MOZ_DEFINE_MALLOC_SIZE_OF(MemoryFileDataOwnerMallocSizeOf)
 
 class MemoryBlobImplDataOwnerMemoryReporter final : public nsIMemoryReporter {
@@ -121,6 +493,11 @@ class MemoryBlobImplDataOwnerMemoryReporter final : public nsIMemoryReporter {
 
     for (DataOwner* owner = DataOwner::sDataOwners->getFirst(); owner;
          owner = owner->getNext()) {
+      // Spilled data lives in the page cache, it can be evicted.
+      if (owner->mState == DataOwner::SpillState::Spilled) {
+        continue;
+      }
+
       size_t size = MemoryFileDataOwnerMallocSizeOf(owner->mData);
 
       if (size < LARGE_OBJECT_MIN_SIZE) {
@@ -188,6 +565,17 @@ void MemoryBlobImpl::DataOwner::EnsureMemoryReporterRegistered() {
 
   RegisterStrongMemoryReporter(new MemoryBlobImplDataOwnerMemoryReporter());
 
+  if (XRE_IsParentProcess() || XRE_IsContentProcess()) {
+    NS_DispatchToMainThread(NS_NewRunnableFunction(
+        "MemoryBlobImpl::DataOwner::EnsureMemoryReporterRegistered", []() {
+          nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+          if (obs) {
+            obs->AddObserver(new MemoryBlobImplMemoryPressureObserver(),
+                             "memory-pressure", false);
+          }
+        }));
+  }
+
   sMemoryReporterRegistered = true;
 }
 
@@ -8,14 +8,17 @@
 #define mozilla_dom_MemoryBlobImpl_h
 
 #include "mozilla/dom/BaseBlobImpl.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/LinkedList.h"
 #include "mozilla/StaticMutex.h"
 #include "mozilla/StaticPtr.h"
+#include "mozilla/UniquePtrExtensions.h"
 #include "nsCOMPtr.h"
 #include "nsICloneableInputStream.h"
 #include "nsIInputStream.h"
 #include "nsIIPCSerializableInputStream.h"
 #include "nsISeekableStream.h"
+#include "prio.h"
 
 namespace mozilla {
 namespace dom {
@@ -35,12 +38,19 @@ class MemoryBlobImpl final : public BaseBlobImpl {
       void* aMemoryBuffer, uint64_t aLength, const nsAString& aName,
       const nsAString& aContentType, int64_t aLastModifiedDate);
 
+  // File constructor reading from a read-only mapping of aFD, which it takes
+  // ownership of. Returns nullptr if aFD can't be mapped.
+  static already_AddRefed<MemoryBlobImpl> CreateFromFileDescriptor(
+      PRFileDesc* aFD, uint64_t aLength, const nsAString& aName,
+      const nsAString& aContentType, int64_t aLastModifiedDate);
+
   // Blob constructor.
   MemoryBlobImpl(void* aMemoryBuffer, uint64_t aLength,
                  const nsAString& aContentType)
       : BaseBlobImpl(aContentType, aLength),
         mDataOwner(new DataOwner(aMemoryBuffer, aLength)) {
     MOZ_ASSERT(mDataOwner && mDataOwner->mData, "must have data");
+    mDataOwner->MaybeSpillLarge();
   }
 
   void CreateInputStream(nsIInputStream** aStream, ErrorResult& aRv) override;
@@ -51,7 +61,10 @@ class MemoryBlobImpl final : public BaseBlobImpl {
 
   bool IsMemoryFile() const override { return true; }
 
-  size_t GetAllocationSize() const override { return mLength; }
+  // Data in a file mapping isn't on the heap.
+  size_t GetAllocationSize() const override {
+    return mDataOwner->IsSpilled() ? 0 : mLength;
+  }
 
   size_t GetAllocationSize(
       FallibleTArray<BlobImpl*>& aVisitedBlobImpls) const override {
@@ -64,7 +77,6 @@ class MemoryBlobImpl final : public BaseBlobImpl {
 
   class DataOwner final : public mozilla::LinkedListElement<DataOwner> {
    public:
-    NS_INLINE_DECL_THREADSAFE_REFCOUNTING(DataOwner)
     DataOwner(void* aMemoryBuffer, uint64_t aLength)
         : mData(aMemoryBuffer), mLength(aLength) {
       mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
@@ -76,23 +88,72 @@ class MemoryBlobImpl final : public BaseBlobImpl {
       sDataOwners->insertBack(this);
     }
 
-   private:
-    // Private destructor, to discourage deletion outside of Release():
-    ~DataOwner() {
+    // An owner of data that is already mapped from aFD.
+    DataOwner(PRFileDesc* aFD, PRFileMap* aFileMap, void* aMapping,
+              uint64_t aLength)
+        : mData(aMapping),
+          mLength(aLength),
+          mState(SpillState::Spilled),
+          mFD(aFD),
+          mFileMap(aFileMap),
+          mMapping(aMapping) {
       mozilla::StaticMutexAutoLock lock(sDataOwnerMutex);
 
-      remove();
-      if (sDataOwners->isEmpty()) {
-        // Free the linked list if it's empty.
-        sDataOwners = nullptr;
+      if (!sDataOwners) {
+        sDataOwners = new mozilla::LinkedList<DataOwner>();
+        EnsureMemoryReporterRegistered();
       }
+      sDataOwners->insertBack(this);
+    }
 
-      free(mData);
+    // Thread-safe refcounting by hand, so that owners found in sDataOwners
+    // can be retained without resurrecting one that is being destroyed.
+    MozExternalRefCountType AddRef() {
+      nsrefcnt count = ++mRefCnt;
+      NS_LOG_ADDREF(this, count, "DataOwner", sizeof(*this));
+      return count;
     }
 
+    MozExternalRefCountType Release() {
+      nsrefcnt count = --mRefCnt;
+      NS_LOG_RELEASE(this, count, "DataOwner");
+      if (count == 0) {
+        delete this;
+      }
+      return count;
+    }
+
+   private:
+    // Private destructor, to discourage deletion outside of Release():
+    ~DataOwner();
+
+    bool TryAddRef();
+
+    void Spill();
+    void WriteAndMap(PRFileDesc* aFD);
+    void SwapToMapping();
+
    public:
     static void EnsureMemoryReporterRegistered();
 
+    // Moves the data to a temporary file in the background if it's at least
+    // dom.blob.spill_threshold bytes long.
+    void MaybeSpillLarge();
+
+    // Moves the data of every owner of at least dom.blob.spill_min_size bytes
+    // to temporary files, on memory pressure.
+    static void SpillAll();
+
+    // Returns mData and keeps it valid until the matching ReleaseData().
+    const char* AcquireData();
+    void ReleaseData();
+
+    bool IsSpilled() const;
+
+    // Returns a new read-only descriptor of the temporary file, with its own
+    // offset, or an invalid handle if the data isn't in a file (yet).
+    UniqueFileHandle OpenFile();
+
     // sDataOwners and sMemoryReporterRegistered may only be accessed while
     // holding sDataOwnerMutex!  You also must hold the mutex while touching
     // elements of the linked list that DataOwner inherits from.
@@ -100,8 +161,32 @@ class MemoryBlobImpl final : public BaseBlobImpl {
     static mozilla::StaticAutoPtr<mozilla::LinkedList<DataOwner> > sDataOwners;
     static bool sMemoryReporterRegistered;
 
+    enum class SpillState : uint8_t {
+      // mData is the heap buffer.
+      Memory,
+      // The heap buffer is being written to mFD.
+      Spilling,
+      // mMapping is ready, but streams still read from the heap buffer.
+      Mapped,
+      // mData is mMapping, the heap buffer is gone.
+      Spilled,
+      // Writing or mapping failed, the data stays in memory.
+      Failed,
+    };
+
+    // mData, mState, mStreams, mFD, mFileMap and mMapping are protected by
+    // sDataOwnerMutex.
     void* mData;
-    uint64_t mLength;
+    const uint64_t mLength;
+    SpillState mState = SpillState::Memory;
+    // Number of DataOwnerAdapters reading from mData.
+    uint32_t mStreams = 0;
+    PRFileDesc* mFD = nullptr;
+    PRFileMap* mFileMap = nullptr;
+    void* mMapping = nullptr;
+
+   private:
+    mozilla::Atomic<nsrefcnt> mRefCnt{0};
   };
 
   class DataOwnerAdapter final : public nsIInputStream,
@@ -123,14 +208,19 @@ class MemoryBlobImpl final : public BaseBlobImpl {
     NS_FORWARD_NSICLONEABLEINPUTSTREAM(mCloneableInputStream->)
 
     // This is optional. We use a conditional QI to keep it from being called
-    // if the underlying stream doesn't support it.
-    NS_FORWARD_NSIIPCSERIALIZABLEINPUTSTREAM(mSerializableInputStream->)
+    // if the underlying stream doesn't support it. Data that was spilled to
+    // a file is sent as a descriptor of that file instead of a copy.
+    NS_DECL_NSIIPCSERIALIZABLEINPUTSTREAM
 
    private:
-    ~DataOwnerAdapter() = default;
+    ~DataOwnerAdapter() { mDataOwner->ReleaseData(); }
 
-    DataOwnerAdapter(DataOwner* aDataOwner, nsIInputStream* aStream)
+    // aDataOwner->AcquireData() must have been called for this adapter.
+    DataOwnerAdapter(DataOwner* aDataOwner, nsIInputStream* aStream,
+                     uint32_t aStart, uint32_t aLength)
         : mDataOwner(aDataOwner),
+          mStart(aStart),
+          mLength(aLength),
           mStream(aStream),
           mSeekableStream(do_QueryInterface(aStream)),
           mSerializableInputStream(do_QueryInterface(aStream)),
@@ -138,7 +228,15 @@ class MemoryBlobImpl final : public BaseBlobImpl {
       MOZ_ASSERT(mSeekableStream, "Somebody gave us the wrong stream!");
     }
 
+    template <typename M>
+    void SerializeInternal(mozilla::ipc::InputStreamParams& aParams,
+                           FileDescriptorArray& aFileDescriptors,
+                           bool aDelayedStart, uint32_t aMaxSize,
+                           uint32_t* aSizeUsed, M* aManager);
+
     RefPtr<DataOwner> mDataOwner;
+    const uint32_t mStart;
+    const uint32_t mLength;
     nsCOMPtr<nsIInputStream> mStream;
     nsCOMPtr<nsISeekableStream> mSeekableStream;
     nsCOMPtr<nsIIPCSerializableInputStream> mSerializableInputStream;
@@ -152,8 +250,16 @@ class MemoryBlobImpl final : public BaseBlobImpl {
       : BaseBlobImpl(aName, aContentType, aLength, aLastModifiedDate),
         mDataOwner(new DataOwner(aMemoryBuffer, aLength)) {
     MOZ_ASSERT(mDataOwner && mDataOwner->mData, "must have data");
+    mDataOwner->MaybeSpillLarge();
   }
 
+  // File constructor for data that is already mapped.
+  MemoryBlobImpl(DataOwner* aDataOwner, const nsAString& aName,
+                 const nsAString& aContentType, int64_t aLastModifiedDate)
+      : BaseBlobImpl(aName, aContentType, aDataOwner->mLength,
+                     aLastModifiedDate),
+        mDataOwner(aDataOwner) {}
+
   // Create slice
   MemoryBlobImpl(const MemoryBlobImpl* aOther, uint64_t aStart,
                  uint64_t aLength, const nsAString& aContentType)
@@ -341,6 +341,10 @@ class HTMLMediaElement : public nsGenericHTMLElement,
   // http://www.whatwg.org/specs/web-apps/current-work/#ended
   bool IsPlaybackEnded() const;
 
+  // True while our tracks are captured into a MediaTrackGraph, by
+  // captureStream() or a MediaElementAudioSourceNode.
+  bool AreTracksCaptured() const { return !!mTracksCaptured.Ref(); }
+
   // principal of the currently playing resource. Anything accessing the
   // contents of this element must have a principal that subsumes this
   // principal. Returns null if nothing is playing.
@@ -20814,6 +20814,9 @@ void CursorOpBaseHelperBase<CursorType>::PopulateExtraResponses(
 
   const auto extraCount = [&]() -> uint32_t {
     auto accumulatedResponseSize = aInitialResponseSize;
+    const size_t maxResponseSize = std::min<size_t>(
+        aInitialResponseSize + IndexedDatabaseManager::MaxPreloadBytes(),
+        IPC::Channel::kMaximumMessageSize / 2);
     uint32_t extraCount = 0;
 
     do {
@@ -20850,9 +20853,9 @@ void CursorOpBaseHelperBase<CursorType>::PopulateExtraResponses(
 
       // Check accumulated size of individual responses and maybe break early.
       accumulatedResponseSize += responseSize;
-      if (accumulatedResponseSize > IPC::Channel::kMaximumMessageSize / 2) {
+      if (accumulatedResponseSize > maxResponseSize) {
         IDB_LOG_MARK_PARENT_TRANSACTION_REQUEST(
-            "PRELOAD: %s: Dropping entries because maximum message size is "
+            "PRELOAD: %s: Dropping entries because maximum preload size is "
             "exceeded: %" PRIu32 "/%zu bytes",
             "%.0s Dropping too large (%" PRIu32 "/%zu)",
             IDB_LOG_ID_STRING(mOp.mBackgroundChildLoggingId),
@@ -6,6 +6,7 @@
 
 #include "IndexedDatabaseManager.h"
 
+#include <algorithm>
 #include "chrome/common/ipc_channel.h"  // for IPC::Channel::kMaximumMessageSize
 #include "nsIDiskSpaceWatcher.h"
 #include "nsIObserverService.h"
@@ -128,6 +129,11 @@ const int32_t kDefaultMaxSerializedMsgSize = IPC::Channel::kMaximumMessageSize;
 // overwhelming majority of cases.
 const int32_t kDefaultMaxPreloadExtraRecords = 64;
 
+// The maximum size of the records preloaded by a cursor, on top of the one
+// requested. They are held in the parent and then in the child until the
+// cursor gets to them.
+const int32_t kDefaultMaxPreloadBytes = IPC::Channel::kMaximumMessageSize / 2;
+
 #define IDB_PREF_BRANCH_ROOT "dom.indexedDB."
 
 const char kTestingPref[] = IDB_PREF_BRANCH_ROOT "testing";
@@ -141,6 +147,7 @@ const char kPrefErrorEventToSelfError[] =
 const char kPreprocessingPref[] = IDB_PREF_BRANCH_ROOT "preprocessing";
 const char kPrefMaxPreloadExtraRecords[] =
     IDB_PREF_BRANCH_ROOT "maxPreloadExtraRecords";
+const char kPrefMaxPreloadBytes[] = IDB_PREF_BRANCH_ROOT "maxPreloadBytes";
 
 #define IDB_PREF_LOGGING_BRANCH_ROOT IDB_PREF_BRANCH_ROOT "logging."
 
@@ -165,6 +172,7 @@ Atomic<int32_t> gDataThresholdBytes(0);
 Atomic<int32_t> gMaxSerializedMsgSize(0);
 Atomic<bool> gPreprocessingEnabled(false);
 Atomic<int32_t> gMaxPreloadExtraRecords(0);
+Atomic<int32_t> gMaxPreloadBytes(0);
 
 void AtomicBoolPrefChangedCallback(const char* aPrefName, void* aBool) {
   MOZ_ASSERT(NS_IsMainThread());
@@ -215,6 +223,16 @@ void MaxPreloadExtraRecordsPrefChangeCallback(const char* aPrefName,
   // require adaptations in ActorsParent.cpp
 }
 
+void MaxPreloadBytesPrefChangeCallback(const char* aPrefName, void* aClosure) {
+  MOZ_ASSERT(NS_IsMainThread());
+  MOZ_ASSERT(!strcmp(aPrefName, kPrefMaxPreloadBytes));
+  MOZ_ASSERT(!aClosure);
+
+  gMaxPreloadBytes = std::clamp(
+      Preferences::GetInt(aPrefName, kDefaultMaxPreloadBytes), 0,
+      kDefaultMaxPreloadBytes);
+}
+
 auto DatabaseNameMatchPredicate(const nsAString* const aName) {
   MOZ_ASSERT(aName);
   return [aName](const auto& fileManager) {
@@ -354,6 +372,9 @@ nsresult IndexedDatabaseManager::Init() {
   Preferences::RegisterCallbackAndCall(MaxPreloadExtraRecordsPrefChangeCallback,
                                        kPrefMaxPreloadExtraRecords);
 
+  Preferences::RegisterCallbackAndCall(MaxPreloadBytesPrefChangeCallback,
+                                       kPrefMaxPreloadBytes);
+
   nsAutoCString acceptLang;
   Preferences::GetLocalizedCString("intl.accept_languages", acceptLang);
 
@@ -412,6 +433,9 @@ void IndexedDatabaseManager::Destroy() {
   Preferences::UnregisterCallback(AtomicBoolPrefChangedCallback,
                                   kPreprocessingPref, &gPreprocessingEnabled);
 
+  Preferences::UnregisterCallback(MaxPreloadBytesPrefChangeCallback,
+                                  kPrefMaxPreloadBytes);
+
   delete this;
 }
 
@@ -713,6 +737,14 @@ int32_t IndexedDatabaseManager::MaxPreloadExtraRecords() {
   return gMaxPreloadExtraRecords;
 }
 
+// static
+uint32_t IndexedDatabaseManager::MaxPreloadBytes() {
+  MOZ_ASSERT(gDBManager,
+             "MaxPreloadBytes() called before indexedDB has been initialized!");
+
+  return gMaxPreloadBytes;
+}
+
 void IndexedDatabaseManager::ClearBackgroundActor() {
   MOZ_ASSERT(NS_IsMainThread());
 
@@ -115,6 +115,10 @@ class IndexedDatabaseManager final : public nsIObserver {
   // Cursor::ContinueOp.
   static int32_t MaxPreloadExtraRecords();
 
+  // The maximum size in bytes of the extra entries preloaded in one go, which
+  // bounds the memory a cursor holds ahead of the application.
+  static uint32_t MaxPreloadBytes();
+
   void ClearBackgroundActor();
 
   [[nodiscard]] SafeRefPtr<FileManager> GetFileManager(
@@ -8,6 +8,7 @@
 #  include "AndroidDecoderModule.h"
 #endif
 
+#include "AudioChannelService.h"
 #include "BrowserChild.h"
 #include "nsNSSComponent.h"
 #include "ContentChild.h"
@@ -105,8 +106,10 @@
 #include "mozilla/ipc/PChildToParentStreamChild.h"
 #include "mozilla/ipc/PParentToChildStreamChild.h"
 #include "mozilla/ipc/ProcessChild.h"
+#include "mozilla/ipc/SharedMemory.h"
 #include "mozilla/ipc/TestShellChild.h"
 #include "mozilla/layers/APZChild.h"
+#include "mozilla/layers/CompositorBridgeChild.h"
 #include "mozilla/layers/CompositorManagerChild.h"
 #include "mozilla/layers/ContentProcessController.h"
 #include "mozilla/layers/ImageBridgeChild.h"
@@ -120,6 +123,7 @@
 #include "mozilla/widget/RemoteLookAndFeel.h"
 #include "mozilla/widget/ScreenManager.h"
 #include "mozilla/widget/WidgetMessageUtils.h"
+#include "mozmemory.h"
 #include "nsBaseDragService.h"
 #include "nsDocShellLoadTypes.h"
 #include "nsFocusManager.h"
@@ -174,10 +178,12 @@
 
 #include "SandboxHal.h"
 #include "mozInlineSpellChecker.h"
+#include "mozJSComponentLoader.h"
 #include "mozilla/GlobalStyleSheetCache.h"
 #include "mozilla/Unused.h"
 #include "nsAnonymousTemporaryFile.h"
 #include "nsClipboardProxy.h"
+#include "nsCharSeparatedTokenizer.h"
 #include "nsContentPermissionHelper.h"
 #include "nsDebugImpl.h"
 #include "nsDirectoryService.h"
@@ -309,6 +315,7 @@
 #include "VRManagerChild.h"
 #include "gfxPlatform.h"
 #include "gfxPlatformFontList.h"
+#include "gfxShapedWordStore.h"
 #include "mozilla/RemoteSpellCheckEngineChild.h"
 #include "mozilla/dom/TabContext.h"
 #include "mozilla/dom/ipc/StructuredCloneData.h"
@@ -1380,6 +1387,9 @@ void ContentChild::InitXPCOM(
   // Set the dynamic scalar definitions for this process.
   TelemetryIPC::AddDynamicScalarDefinitions(aXPCOMInit.dynamicScalarDefs());
 
+  gfxShapedWordStore::InitChild(aXPCOMInit.shapedWordStore(),
+                                aXPCOMInit.shapedWordStoreSize());
+
 #ifdef MOZ_WIDGET_GONK
   DateCacheCleaner::InitializeSingleton();
 #endif
@@ -1641,6 +1651,15 @@ mozilla::ipc::IPCResult ContentChild::RecvSpeakerManagerNotify() {
 #endif
 }
 
+mozilla::ipc::IPCResult ContentChild::RecvActiveAudioChannelsChanged(
+    const uint32_t& aActiveChannels) {
+  RefPtr<AudioChannelService> service = AudioChannelService::GetOrCreate();
+  if (service) {
+    service->ActiveChannelsReceived(aActiveChannels);
+  }
+  return IPC_OK();
+}
+
 mozilla::ipc::IPCResult ContentChild::RecvReinitRenderingForDeviceReset() {
   gfxPlatform::GetPlatform()->CompositorUpdated();
 
@@ -2495,6 +2514,14 @@ mozilla::ipc::IPCResult ContentChild::RecvPreferenceUpdate(const Pref& aPref) {
   return IPC_OK();
 }
 
+mozilla::ipc::IPCResult ContentChild::RecvPreferenceUpdates(
+    nsTArray<Pref>&& aPrefs) {
+  for (const Pref& pref : aPrefs) {
+    Preferences::SetPreference(pref);
+  }
+  return IPC_OK();
+}
+
 mozilla::ipc::IPCResult ContentChild::RecvVarUpdate(const GfxVarUpdate& aVar) {
   gfx::gfxVars::ApplyUpdate(aVar);
   return IPC_OK();
@@ -2957,6 +2984,71 @@ void ContentChild::PreallocInit() {
   // SetAcceptLanguages() needs to read localized strings (file access),
   // which is slow, so do this in prealloc
   nsHttpHandler::PresetAcceptLanguages();
+
+  // Import the JS modules nearly every app process ends up loading, so that
+  // their scripts are compiled (out of the ScriptPreloader cache) while the
+  // process is still a spare instead of on the app launch path. Do it on
+  // idle, so it doesn't compete with whatever launched us.
+  nsAutoCString modules;
+  Preferences::GetCString("dom.ipc.processPrelaunch.preloadModules", modules);
+  if (!modules.IsEmpty()) {
+    NS_DispatchToCurrentThreadQueue(
+        NS_NewRunnableFunction(
+            "ContentChild::PreallocInit::PreloadModules",
+            [modules]() {
+              AutoJSAPI jsapi;
+              if (!jsapi.Init()) {
+                return;
+              }
+              JSContext* cx = jsapi.cx();
+              for (const nsACString& module : modules.Split(',')) {
+                nsAutoCString uri(module);
+                uri.Trim(" ");
+                if (uri.IsEmpty()) {
+                  continue;
+                }
+                JS::RootedObject global(cx);
+                JS::RootedObject exports(cx);
+                nsresult rv = mozJSComponentLoader::Get()->Import(
+                    cx, uri, &global, &exports, /* aIgnoreExports = */ true);
+                if (NS_FAILED(rv)) {
+                  jsapi.ClearException();
+                  MOZ_LOG(ContentParent::GetLog(), LogLevel::Debug,
+                          ("Failed to preload %s", uri.get()));
+                }
+              }
+            }),
+        EventQueuePriority::Idle);
+  }
+
+  // Likewise for the style sheets apps link from the shared origins, which
+  // the SharedStyleSheetCache keeps for any document of the process.
+  nsAutoCString sheets;
+  Preferences::GetCString("dom.ipc.processPrelaunch.preloadStyleSheets",
+                          sheets);
+  if (!sheets.IsEmpty()) {
+    NS_DispatchToCurrentThreadQueue(
+        NS_NewRunnableFunction(
+            "ContentChild::PreallocInit::PreloadStyleSheets",
+            [sheets]() {
+              for (const nsACString& sheet :
+                   nsCCharSeparatedTokenizer(sheets, ',').ToRange()) {
+                nsCOMPtr<nsIURI> uri;
+                if (sheet.IsEmpty() ||
+                    NS_FAILED(NS_NewURI(getter_AddRefs(uri), sheet))) {
+                  continue;
+                }
+                SharedStyleSheetCache::PreloadSharedOriginSheet(uri);
+              }
+            }),
+        EventQueuePriority::Idle);
+  }
+
+  // And for the glyphs of the system font every app draws its UI with.
+  NS_DispatchToCurrentThreadQueue(
+      NS_NewRunnableFunction("ContentChild::PreallocInit::PrerenderGlyphs",
+                             []() { gfxPlatform::PrerenderCommonGlyphs(); }),
+      EventQueuePriority::Idle);
 }
 
 // Call RemoteTypePrefix() on the result to remove URIs if you want to use this
@@ -3103,6 +3195,34 @@ mozilla::ipc::IPCResult ContentChild::RecvFilePathUpdate(
 
 mozilla::ipc::IPCResult ContentChild::RecvNotifyProcessPriorityChanged(
     const hal::ProcessPriority& aPriority) {
+  if (layers::CompositorBridgeChild* compositor =
+          layers::CompositorBridgeChild::Get()) {
+    compositor->SetTexturePoolsBackground(
+        aPriority == hal::PROCESS_PRIORITY_BACKGROUND ||
+        aPriority == hal::PROCESS_PRIORITY_BACKGROUND_PERCEIVABLE);
+  }
+
+  NS_SetTimerCoalescing(aPriority == hal::PROCESS_PRIORITY_BACKGROUND);
+
+  // Glyphs are cheap to rasterize again, and a backgrounded app's font cache
+  // is pure overhead until it comes back.
+  if (aPriority == hal::PROCESS_PRIORITY_BACKGROUND &&
+      gfxPlatform::Initialized()) {
+    gfxPlatform::PurgeSkiaFontCache();
+  }
+
+#ifdef MOZ_MEMORY
+  if (int32_t modifier = StaticPrefs::
+          dom_ipc_processPriorityManager_backgroundDirtyPageModifier()) {
+    if (aPriority == hal::PROCESS_PRIORITY_BACKGROUND) {
+      jemalloc_free_dirty_pages();
+      moz_set_max_dirty_page_modifier(modifier);
+    } else {
+      moz_set_max_dirty_page_modifier(0);
+    }
+  }
+#endif
+
   nsCOMPtr<nsIObserverService> os = services::GetObserverService();
   NS_ENSURE_TRUE(os, IPC_OK());
 
@@ -3123,6 +3243,21 @@ mozilla::ipc::IPCResult ContentChild::RecvMinimizeMemoryUsage() {
   return IPC_OK();
 }
 
+mozilla::ipc::IPCResult ContentChild::RecvGetMemoryCounters(
+    GetMemoryCountersResolver&& aResolver) {
+  MemoryCounters counters(0, 0, 0, 0);
+  // These are the cheap distinguished amounts, unlike a memory report.
+  if (nsCOMPtr<nsIMemoryReporterManager> mgr =
+          do_GetService("@mozilla.org/memory-reporter-manager;1")) {
+    Unused << mgr->GetJSMainRuntimeGCHeap(&counters.jsHeap());
+    Unused << mgr->GetImagesContentUsedUncompressed(&counters.images());
+    Unused << mgr->GetHeapAllocated(&counters.heapAllocated());
+  }
+  counters.layers() = int64_t(ipc::SharedMemory::TotalMapped());
+  aResolver(counters);
+  return IPC_OK();
+}
+
 mozilla::ipc::IPCResult ContentChild::RecvNotifyPhoneStateChange(
     const nsString& aState) {
   nsCOMPtr<nsIObserverService> os = services::GetObserverService();
@@ -3132,6 +3267,15 @@ mozilla::ipc::IPCResult ContentChild::RecvNotifyPhoneStateChange(
   return IPC_OK();
 }
 
+mozilla::ipc::IPCResult ContentChild::RecvNotifyScreenStateChange(
+    const nsString& aState) {
+  nsCOMPtr<nsIObserverService> os = services::GetObserverService();
+  if (os) {
+    os->NotifyObservers(nullptr, "screen-state-changed", aState.get());
+  }
+  return IPC_OK();
+}
+
 void ContentChild::AddIdleObserver(nsIObserver* aObserver,
                                    uint32_t aIdleTimeInS) {
   MOZ_ASSERT(aObserver, "null idle observer");
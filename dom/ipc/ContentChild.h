@@ -200,6 +200,9 @@ class ContentChild final : public PContentChild,
 
   mozilla::ipc::IPCResult RecvSpeakerManagerNotify();
 
+  mozilla::ipc::IPCResult RecvActiveAudioChannelsChanged(
+      const uint32_t& aActiveChannels);
+
   mozilla::ipc::IPCResult RecvReinitRenderingForDeviceReset();
 
   mozilla::ipc::IPCResult RecvSetProcessSandbox(
@@ -347,6 +350,7 @@ class ContentChild final : public PContentChild,
                                   nsIObserver* aObserver);
 
   mozilla::ipc::IPCResult RecvPreferenceUpdate(const Pref& aPref);
+  mozilla::ipc::IPCResult RecvPreferenceUpdates(nsTArray<Pref>&& aPrefs);
   mozilla::ipc::IPCResult RecvVarUpdate(const GfxVarUpdate& pref);
 
   mozilla::ipc::IPCResult RecvUpdatePerfStatsCollectionMask(
@@ -467,6 +471,9 @@ class ContentChild final : public PContentChild,
 
   mozilla::ipc::IPCResult RecvMinimizeMemoryUsage();
 
+  mozilla::ipc::IPCResult RecvGetMemoryCounters(
+      GetMemoryCountersResolver&& aResolver);
+
   mozilla::ipc::IPCResult RecvLoadAndRegisterSheet(nsIURI* aURI,
                                                    const uint32_t& aType);
 
@@ -475,6 +482,8 @@ class ContentChild final : public PContentChild,
 
   mozilla::ipc::IPCResult RecvNotifyPhoneStateChange(const nsString& aState);
 
+  mozilla::ipc::IPCResult RecvNotifyScreenStateChange(const nsString& aState);
+
   void AddIdleObserver(nsIObserver* aObserver, uint32_t aIdleTimeInS);
 
   void RemoveIdleObserver(nsIObserver* aObserver, uint32_t aIdleTimeInS);
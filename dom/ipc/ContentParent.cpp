@@ -60,6 +60,7 @@
 #include "URIUtils.h"
 #include "gfxPlatform.h"
 #include "gfxPlatformFontList.h"
+#include "gfxShapedWordStore.h"
 #include "mozilla/AutoRestore.h"
 #include "mozilla/ContentBlocking.h"
 #include "mozilla/BasePrincipal.h"
@@ -69,6 +70,7 @@
 #include "mozilla/DataStorage.h"
 #include "mozilla/FOGIPC.h"
 #include "mozilla/GlobalStyleSheetCache.h"
+#include "mozilla/Hal.h"
 #include "mozilla/HangDetails.h"
 #include "mozilla/LoginReputationIPC.h"
 #include "mozilla/LookAndFeel.h"
@@ -287,9 +289,6 @@
 #  include "nsSystemInfo.h"
 #endif
 
-#if defined(XP_LINUX)
-#  include "mozilla/Hal.h"
-#endif
 
 #ifdef ANDROID
 #  include "gfxAndroidPlatform.h"
@@ -728,6 +727,7 @@ static const char* sObserverTopics[] = {
     NS_VOLUME_STATE_CHANGED,
     NS_VOLUME_REMOVED,
     "phone-state-changed",
+    "screen-state-changed",
 #endif
 #ifdef ACCESSIBILITY
     "a11y-init-or-shutdown",
@@ -1839,8 +1839,19 @@ void ContentParent::Init() {
 
   // Flush any pref updates that happened during launch and weren't
   // included in the blobs set up in BeginSubprocessLaunch.
-  for (const Pref& pref : mQueuedPrefs) {
-    Unused << NS_WARN_IF(!SendPreferenceUpdate(pref));
+  FlushQueuedPrefs();
+}
+
+void ContentParent::FlushQueuedPrefs() {
+  mQueuedPrefsFlushPending = false;
+  if (mQueuedPrefs.IsEmpty() || !IsInitialized() || IsDead()) {
+    return;
+  }
+
+  if (mQueuedPrefs.Length() == 1) {
+    Unused << NS_WARN_IF(!SendPreferenceUpdate(mQueuedPrefs[0]));
+  } else {
+    Unused << NS_WARN_IF(!SendPreferenceUpdates(mQueuedPrefs));
   }
   mQueuedPrefs.Clear();
 }
@@ -2693,6 +2704,14 @@ bool ContentParent::BeginSubprocessLaunch(ProcessPriority aPriority) {
   extraArgs.push_back("-parentBuildID");
   extraArgs.push_back(parentBuildID.get());
 
+  // A process launched straight into the foreground, rather than taken from
+  // the preallocated ones, has the user waiting for it.
+  if (aPriority >= PROCESS_PRIORITY_FOREGROUND) {
+    hal::NotifyPerformanceHint(
+        hal::PERFORMANCE_HINT_APP_LAUNCH,
+        StaticPrefs::dom_ipc_processPriorityManager_launchBoostMS());
+  }
+
   // See also ActorDealloc.
   mSelfRef = this;
   mLaunchYieldTS = TimeStamp::Now();
@@ -2799,6 +2818,10 @@ bool ContentParent::LaunchSubprocessResolve(bool aIsSync,
   } else {
     Telemetry::AccumulateTimeDelta(Telemetry::CONTENT_PROCESS_LAUNCH_TOTAL_MS,
                                    mLaunchTS);
+    Telemetry::AccumulateTimeDelta(
+        Telemetry::CONTENT_PROCESS_LAUNCH_TOTAL_BY_PATH_MS,
+        mSubprocess->UsesForkServer() ? "forkserver"_ns : "exec"_ns,
+        mLaunchTS);
 
     Telemetry::Accumulate(
         Telemetry::CONTENT_PROCESS_LAUNCH_MAINTHREAD_MS,
@@ -3084,6 +3107,12 @@ bool ContentParent::InitInternal(ProcessPriority aInitialPriority) {
   // Send the dynamic scalar definitions to the new process.
   TelemetryIPC::GetDynamicScalarDefinitions(xpcomInit.dynamicScalarDefs());
 
+  xpcomInit.shapedWordStoreSize() = 0;
+  if (gfxShapedWordStore* store = gfxShapedWordStore::Get()) {
+    store->GetFileForChild(&xpcomInit.shapedWordStore(),
+                           &xpcomInit.shapedWordStoreSize());
+  }
+
   for (auto const& [location, supported] : sCodecsSupported) {
     Unused << SendUpdateMediaCodecsSupported(location, supported);
   }
@@ -3610,12 +3639,13 @@ mozilla::ipc::IPCResult ContentParent::RecvAudioChannelChangeDefVolChannel(
 
 mozilla::ipc::IPCResult ContentParent::RecvAudioChannelServiceStatus(
     const bool& aTelephonyChannel, const bool& aContentOrNormalChannel,
-    const bool& aAnyChannel) {
+    const bool& aAnyChannel, const uint32_t& aActiveChannels) {
   RefPtr<AudioChannelService> service = AudioChannelService::GetOrCreate();
   MOZ_ASSERT(service);
 
   service->ChildStatusReceived(mChildID, aTelephonyChannel,
-                               aContentOrNormalChannel, aAnyChannel);
+                               aContentOrNormalChannel, aAnyChannel,
+                               aActiveChannels);
   return IPC_OK();
 }
 
@@ -3755,14 +3785,23 @@ ContentParent::Observe(nsISupports* aSubject, const char* aTopic,
 
     Pref pref(strData, /* isLocked */ false, Nothing(), Nothing());
     Preferences::GetPreference(&pref);
-    if (IsInitialized()) {
-      MOZ_ASSERT(mQueuedPrefs.IsEmpty());
+    if (!IsInitialized()) {
+      MOZ_ASSERT(!IsDead());
+      mQueuedPrefs.AppendElement(pref);
+    } else if (StaticPrefs::dom_ipc_batchPreferenceUpdates()) {
+      // Gaia changes prefs in bursts; send each burst as one message.
+      mQueuedPrefs.AppendElement(pref);
+      if (!mQueuedPrefsFlushPending) {
+        mQueuedPrefsFlushPending = true;
+        NS_DispatchToCurrentThread(
+            NewRunnableMethod("dom::ContentParent::FlushQueuedPrefs", this,
+                              &ContentParent::FlushQueuedPrefs));
+      }
+    } else {
+      FlushQueuedPrefs();
       if (!SendPreferenceUpdate(pref)) {
         return NS_ERROR_NOT_AVAILABLE;
       }
-    } else {
-      MOZ_ASSERT(!IsDead());
-      mQueuedPrefs.AppendElement(pref);
     }
   }
 
@@ -3862,6 +3901,8 @@ ContentParent::Observe(nsISupports* aSubject, const char* aTopic,
   } else if (!strcmp(aTopic, "phone-state-changed")) {
     nsString state(aData);
     Unused << SendNotifyPhoneStateChange(state);
+  } else if (!strcmp(aTopic, "screen-state-changed")) {
+    Unused << SendNotifyScreenStateChange(nsString(aData));
   } else if (!strcmp(aTopic, NS_VOLUME_REMOVED)) {
     nsString volName(aData);
     Unused << SendVolumeRemoved(volName);
@@ -5122,6 +5163,13 @@ mozilla::ipc::IPCResult ContentParent::RecvFilePathUpdateNotify(
   RefPtr<DeviceStorageFile> dsf =
       new DeviceStorageFile(aType, aStorageName, aFilePath);
 
+  // The child wrote through a file descriptor we handed out, so our used
+  // space total for the volume no longer holds.
+  DeviceStorageUsedSpaceCache* usedSpaceCache =
+      DeviceStorageUsedSpaceCache::CreateOrGet();
+  MOZ_ASSERT(usedSpaceCache);
+  usedSpaceCache->Invalidate(aStorageName);
+
   nsCOMPtr<nsIObserverService> obs = mozilla::services::GetObserverService();
   if (!obs) {
     return IPC_FAIL_NO_REASON(this);
@@ -6214,6 +6262,21 @@ mozilla::ipc::IPCResult ContentParent::RecvSetupFamilyCharMap(
   return IPC_OK();
 }
 
+mozilla::ipc::IPCResult ContentParent::RecvShapeWordsForStore(
+    const ShapedWordFont& aFont, nsTArray<ShapedWordText>&& aWords) {
+  // Shaping can take a while, and nothing is waiting for these words.
+  NS_DispatchToCurrentThreadQueue(
+      NS_NewRunnableFunction("ContentParent::RecvShapeWordsForStore",
+                             [font = aFont, words = std::move(aWords)]() {
+                               if (gfxShapedWordStore* store =
+                                       gfxShapedWordStore::Get()) {
+                                 store->ShapeWordsForChild(font, words);
+                               }
+                             }),
+      EventQueuePriority::Idle);
+  return IPC_OK();
+}
+
 mozilla::ipc::IPCResult ContentParent::RecvStartCmapLoading(
     const uint32_t& aGeneration, const uint32_t& aStartIndex) {
   auto* fontList = gfxPlatformFontList::PlatformFontList();
@@ -820,6 +820,8 @@ class ContentParent final
   // called after the process has been transformed to browser.
   void ForwardKnownInfo();
 
+  void FlushQueuedPrefs();
+
   /**
    * We might want to reuse barely used content processes if certain criteria
    * are met.
@@ -1255,7 +1257,7 @@ class ContentParent final
 
   mozilla::ipc::IPCResult RecvAudioChannelServiceStatus(
       const bool& aTelephonyChannel, const bool& aContentOrNormalChannel,
-      const bool& aAnyChannel);
+      const bool& aAnyChannel, const uint32_t& aActiveChannels);
 
   mozilla::ipc::IPCResult RecvSpeakerManagerGetSpeakerStatus(bool* aValue);
 
@@ -1319,6 +1321,9 @@ class ContentParent final
       const uint32_t& aGeneration,
       const mozilla::fontlist::Pointer& aFamilyPtr);
 
+  mozilla::ipc::IPCResult RecvShapeWordsForStore(
+      const ShapedWordFont& aFont, nsTArray<ShapedWordText>&& aWords);
+
   mozilla::ipc::IPCResult RecvGetDeviceStorageLocation(const nsString& aType,
                                                        nsString* aPath);
 
@@ -1726,8 +1731,11 @@ class ContentParent final
 
   // Collects any pref changes that occur during process launch (after
   // the initial map is passed in command-line arguments) to be sent
-  // when the process can receive IPC messages.
+  // when the process can receive IPC messages. With
+  // dom.ipc.batchPreferenceUpdates, it also collects the changes made during
+  // the current event loop turn, which FlushQueuedPrefs() sends together.
   nsTArray<Pref> mQueuedPrefs;
+  bool mQueuedPrefsFlushPending = false;
 
   RefPtr<mozilla::dom::ProcessMessageManager> mMessageManager;
 
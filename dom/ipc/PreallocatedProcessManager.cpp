@@ -7,17 +7,23 @@
 #include "mozilla/PreallocatedProcessManager.h"
 
 #include "mozilla/ClearOnShutdown.h"
+#include "mozilla/IntegerPrintfMacros.h"
 #include "mozilla/Preferences.h"
 #include "mozilla/ProfilerMarkers.h"
 #include "mozilla/Unused.h"
 #include "mozilla/dom/ContentParent.h"
 #include "mozilla/dom/ScriptSettings.h"
 #include "mozilla/StaticPrefs_dom.h"
+#include "mozilla/Telemetry.h"
 #include "nsIPropertyBag2.h"
 #include "ProcessPriorityManager.h"
 #include "nsServiceManagerUtils.h"
 #include "nsIXULRuntime.h"
+#include <algorithm>
 #include <deque>
+#ifdef XP_LINUX
+#  include <stdio.h>
+#endif
 
 using namespace mozilla::hal;
 using namespace mozilla::dom;
@@ -66,6 +72,16 @@ class PreallocatedProcessManagerImpl final : public nsIObserver {
   void Enable(uint32_t aProcesses);
   void Disable();
   void CloseProcesses();
+  void TrimProcesses(uint32_t aKeep);
+
+  /**
+   * The number of spare processes we want right now. Without
+   * dom.ipc.processPrelaunch.adaptive.enabled this is just the configured
+   * number; otherwise it grows with the recent launch rate and drops to zero
+   * under memory pressure or when memory is short.
+   */
+  uint32_t TargetPoolSize();
+  void NoteLaunchRequest();
 
   bool IsEmpty() const {
     return mPreallocatedProcesses.empty() && !mLaunchInProgress;
@@ -76,6 +92,10 @@ class PreallocatedProcessManagerImpl final : public nsIObserver {
   bool mLaunchInProgress;
   uint32_t mNumberPreallocs;
   std::deque<RefPtr<ContentParent>> mPreallocatedProcesses;
+  // Times of recent Take() calls, oldest first, for adaptive sizing.
+  std::deque<TimeStamp> mLaunchRequests;
+  // No preallocation until then, after a low-memory notification.
+  TimeStamp mPressureCooldownEnd;
   // Even if we have multiple PreallocatedProcessManagerImpls, we'll have
   // one blocker counter
   static uint32_t sNumBlockers;
@@ -162,7 +182,25 @@ PreallocatedProcessManagerImpl::Observe(nsISupports* aSubject,
     // of the manager singleton.
     sShutdown = true;
   } else if (!strcmp("memory-pressure", aTopic)) {
-    CloseProcesses();
+    if (StaticPrefs::dom_ipc_processPrelaunch_adaptive_enabled() &&
+        aData && u"heap-minimize"_ns.Equals(aData)) {
+      // Mild pressure: a single spare still pays for itself on the next
+      // launch, anything beyond that goes.
+      TrimProcesses(1);
+    } else {
+      CloseProcesses();
+      if (StaticPrefs::dom_ipc_processPrelaunch_adaptive_enabled()) {
+        uint32_t cooldown =
+            StaticPrefs::dom_ipc_processPrelaunch_adaptive_pressureCooldownMs();
+        mPressureCooldownEnd =
+            TimeStamp::Now() + TimeDuration::FromMilliseconds(cooldown);
+        NS_DelayedDispatchToCurrentThread(
+            NewRunnableMethod("PreallocatedProcessManagerImpl::AllocateOnIdle",
+                              this,
+                              &PreallocatedProcessManagerImpl::AllocateOnIdle),
+            cooldown);
+      }
+    }
   } else {
     MOZ_ASSERT_UNREACHABLE("Unknown topic");
   }
@@ -194,7 +232,10 @@ already_AddRefed<ContentParent> PreallocatedProcessManagerImpl::Take(
   if (!mEnabled || sShutdown) {
     return nullptr;
   }
+  NoteLaunchRequest();
   RefPtr<ContentParent> process;
+  Telemetry::Accumulate(Telemetry::CONTENT_PROCESS_PREALLOC_HIT,
+                        !mPreallocatedProcesses.empty());
   if (!mPreallocatedProcesses.empty()) {
     process = mPreallocatedProcesses.front().forget();
     mPreallocatedProcesses.pop_front();  // holds a nullptr
@@ -207,10 +248,81 @@ already_AddRefed<ContentParent> PreallocatedProcessManagerImpl::Take(
     AllocateAfterDelay();
     MOZ_LOG(ContentParent::GetLog(), LogLevel::Debug,
             ("Use prealloc process %p", process.get()));
+  } else if (StaticPrefs::dom_ipc_processPrelaunch_adaptive_enabled()) {
+    // We missed, so launches are coming faster than we refill. Start on the
+    // next spare now rather than waiting for the next hit.
+    AllocateAfterDelay();
   }
   return process.forget();
 }
 
+void PreallocatedProcessManagerImpl::NoteLaunchRequest() {
+  if (!StaticPrefs::dom_ipc_processPrelaunch_adaptive_enabled()) {
+    return;
+  }
+  // The window only bounds what we look at; cap the length too so a burst
+  // can't grow it without limit.
+  static const size_t kMaxLaunchRequests = 64;
+  mLaunchRequests.push_back(TimeStamp::Now());
+  if (mLaunchRequests.size() > kMaxLaunchRequests) {
+    mLaunchRequests.pop_front();
+  }
+}
+
+#ifdef XP_LINUX
+// Returns MemAvailable from /proc/meminfo in MB, or -1 if unknown.
+static int64_t GetAvailableMemoryMB() {
+  FILE* fp = fopen("/proc/meminfo", "r");
+  if (!fp) {
+    return -1;
+  }
+  int64_t result = -1;
+  char line[128];
+  while (fgets(line, sizeof(line), fp)) {
+    long long kb;
+    if (sscanf(line, "MemAvailable: %lld kB", &kb) == 1) {
+      result = kb / 1024;
+      break;
+    }
+  }
+  fclose(fp);
+  return result;
+}
+#endif
+
+uint32_t PreallocatedProcessManagerImpl::TargetPoolSize() {
+  if (!StaticPrefs::dom_ipc_processPrelaunch_adaptive_enabled()) {
+    return mNumberPreallocs;
+  }
+
+  TimeStamp now = TimeStamp::Now();
+  if (!mPressureCooldownEnd.IsNull() && now < mPressureCooldownEnd) {
+    return 0;
+  }
+
+#ifdef XP_LINUX
+  int64_t available = GetAvailableMemoryMB();
+  if (available >= 0 &&
+      available <
+          StaticPrefs::dom_ipc_processPrelaunch_adaptive_minAvailableMB()) {
+    MOZ_LOG(ContentParent::GetLog(), LogLevel::Debug,
+            ("Not preallocating, only %" PRId64 "MB available", available));
+    return 0;
+  }
+#endif
+
+  TimeDuration window = TimeDuration::FromSeconds(
+      StaticPrefs::dom_ipc_processPrelaunch_adaptive_windowSec());
+  while (!mLaunchRequests.empty() && now - mLaunchRequests.front() > window) {
+    mLaunchRequests.pop_front();
+  }
+
+  uint32_t perSpare = std::max<uint32_t>(
+      1, StaticPrefs::dom_ipc_processPrelaunch_adaptive_launchesPerSpare());
+  uint32_t target = 1 + mLaunchRequests.size() / perSpare;
+  return std::min(target, StaticPrefs::dom_ipc_processPrelaunch_adaptive_max());
+}
+
 void PreallocatedProcessManagerImpl::Erase(ContentParent* aParent) {
   // Ensure this ContentParent isn't cached
   for (auto it = mPreallocatedProcesses.begin();
@@ -264,7 +376,7 @@ void PreallocatedProcessManagerImpl::RemoveBlocker(ContentParent* aParent) {
 
 bool PreallocatedProcessManagerImpl::CanAllocate() {
   return mEnabled && sNumBlockers == 0 &&
-         mPreallocatedProcesses.size() < mNumberPreallocs && !sShutdown &&
+         mPreallocatedProcesses.size() < TargetPoolSize() && !sShutdown &&
          (FissionAutostart() ||
           !ContentParent::IsMaxProcessCountReached(DEFAULT_REMOTE_TYPE));
 }
@@ -309,12 +421,15 @@ void PreallocatedProcessManagerImpl::AllocateNow() {
 
   RefPtr<PreallocatedProcessManagerImpl> self(this);
   mLaunchInProgress = true;
+  TimeStamp launchStart = TimeStamp::Now();
 
   ContentParent::PreallocateProcess()->Then(
       GetCurrentSerialEventTarget(), __func__,
 
-      [self, this](const RefPtr<ContentParent>& process) {
+      [self, this, launchStart](const RefPtr<ContentParent>& process) {
         mLaunchInProgress = false;
+        Telemetry::AccumulateTimeDelta(
+            Telemetry::CONTENT_PROCESS_PREALLOC_LAUNCH_MS, launchStart);
         if (process->IsDead()) {
           // Process died in startup (before we could add it).  If it
           // dies after this, MarkAsDead() will Erase() this entry.
@@ -332,13 +447,13 @@ void PreallocatedProcessManagerImpl::AllocateNow() {
             // could push_front it, but that would require a bunch more
             // logic.
             mPreallocatedProcesses.push_back(process);
+            uint32_t target = TargetPoolSize();
             MOZ_LOG(ContentParent::GetLog(), LogLevel::Debug,
                     ("Preallocated = %lu of %d processes",
-                     (unsigned long)mPreallocatedProcesses.size(),
-                     mNumberPreallocs));
+                     (unsigned long)mPreallocatedProcesses.size(), target));
 
             // Continue prestarting processes if needed
-            if (mPreallocatedProcesses.size() < mNumberPreallocs) {
+            if (mPreallocatedProcesses.size() < target) {
               AllocateOnIdle();
             }
           } else {
@@ -361,13 +476,19 @@ void PreallocatedProcessManagerImpl::Disable() {
   CloseProcesses();
 }
 
-void PreallocatedProcessManagerImpl::CloseProcesses() {
-  while (!mPreallocatedProcesses.empty()) {
-    RefPtr<ContentParent> process(mPreallocatedProcesses.front().forget());
-    mPreallocatedProcesses.pop_front();
+void PreallocatedProcessManagerImpl::TrimProcesses(uint32_t aKeep) {
+  // Close the newest ones first; the oldest have most likely finished
+  // starting up and are the cheapest to hand out.
+  while (mPreallocatedProcesses.size() > aKeep) {
+    RefPtr<ContentParent> process(mPreallocatedProcesses.back().forget());
+    mPreallocatedProcesses.pop_back();
     process->ShutDownProcess(ContentParent::SEND_SHUTDOWN_MESSAGE);
     // drop ref and let it free
   }
+}
+
+void PreallocatedProcessManagerImpl::CloseProcesses() {
+  TrimProcesses(0);
 
   // Make sure to also clear out the recycled E10S process cache, as it's also
   // controlled by the same preference, and can be cleaned up due to memory
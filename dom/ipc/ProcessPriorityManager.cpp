@@ -17,6 +17,7 @@
 #include "mozilla/Services.h"
 #include "mozilla/StaticPrefs_dom.h"
 #include "mozilla/Telemetry.h"
+#include "mozilla/TimeStamp.h"
 #include "mozilla/Unused.h"
 #include "AudioChannelService.h"
 #include "mozilla/Logging.h"
@@ -34,6 +35,13 @@
 #include "nsTHashSet.h"
 #include "nsQueryObject.h"
 #include "nsTHashMap.h"
+#include "nsHashPropertyBag.h"
+#include "nsThreadUtils.h"
+
+#ifdef MOZ_WIDGET_GONK
+#  include <signal.h>
+#  include "GonkMemoryPressureMonitoring.h"
+#endif
 
 using namespace mozilla;
 using namespace mozilla::dom;
@@ -96,6 +104,51 @@ namespace {
 
 class ParticularProcessPriorityManager;
 
+/**
+ * What the kernel says a process uses, in bytes. USS is the memory we would
+ * get back by killing it.
+ */
+struct ProcessMemoryRollup {
+  int64_t mUss = 0;
+  int64_t mPss = 0;
+  int64_t mSwap = 0;
+};
+
+#ifdef XP_LINUX
+/**
+ * Reads /proc/<pid>/smaps_rollup, which the kernel sums up for us, unlike
+ * smaps, which has every mapping and is what makes memory reports slow.
+ * Kernels older than 4.14 don't have it, and we report nothing.
+ */
+static bool ReadSmapsRollup(int32_t aPid, ProcessMemoryRollup* aRollup) {
+  nsPrintfCString path("/proc/%d/smaps_rollup", aPid);
+  FILE* f = fopen(path.get(), "r");
+  if (!f) {
+    return false;
+  }
+
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    char field[64];
+    long long kb;
+    if (sscanf(line, "%63[^:]: %lld kB", field, &kb) != 2) {
+      continue;
+    }
+    int64_t bytes = int64_t(kb) * 1024;
+    if (!strcmp(field, "Pss")) {
+      aRollup->mPss = bytes;
+    } else if (!strcmp(field, "Private_Clean") ||
+               !strcmp(field, "Private_Dirty")) {
+      aRollup->mUss += bytes;
+    } else if (!strcmp(field, "Swap")) {
+      aRollup->mSwap = bytes;
+    }
+  }
+  fclose(f);
+  return true;
+}
+#endif
+
 /**
  * This singleton class does the work to implement the process priority manager
  * in the main process.  This class may not be used in child processes.  (You
@@ -149,7 +202,30 @@ class ProcessPriorityManagerImpl final : public nsIObserver,
 
   void ResetPriority(ContentParent* aContentParent);
 
+  void OnMemorySampled(const nsTArray<uint64_t>& aChildIDs,
+                       const nsTArray<ProcessMemoryRollup>& aRollups);
+
  private:
+  /**
+   * Cheap, continuous memory accounting, as opposed to memory reports. Every
+   * dom.ipc.processPriorityManager.memorySampleIntervalMS, read what each
+   * content process uses from /proc, off the main thread, then ask each
+   * process for a few counters of its own. Each process's sample is then
+   * published as a "process-memory-sample" notification, whose subject is a
+   * property bag with childID, pid, uss, pss, swap, jsHeap, images, layers and
+   * heapAllocated, all in bytes.
+   */
+  void SampleMemory();
+
+#ifdef MOZ_WIDGET_GONK
+  /**
+   * Kill the background process that has been in the background the
+   * longest, to free memory before the LMK has to pick a victim on its own,
+   * possibly the foreground app.
+   */
+  void KillOldestBackgroundProcess();
+#endif
+
   static bool sPrefListenersRegistered;
   static bool sInitialized;
   static StaticRefPtr<ProcessPriorityManagerImpl> sSingleton;
@@ -175,6 +251,8 @@ class ProcessPriorityManagerImpl final : public nsIObserver,
 
   /** Contains the PIDs of child processes holding high-priority wakelocks */
   nsTHashSet<uint64_t> mHighPriorityChildIDs;
+
+  nsCOMPtr<nsITimer> mMemorySampleTimer;
 };
 
 /**
@@ -242,6 +320,12 @@ class ParticularProcessPriorityManager final : public WakeLockObserver,
   ProcessPriority CurrentPriority();
   ProcessPriority ComputePriority();
 
+  /**
+   * When this process last dropped to PROCESS_PRIORITY_BACKGROUND. Null if
+   * it is not in the background.
+   */
+  TimeStamp BackgroundSince() const { return mBackgroundSince; }
+
   enum TimeoutPref {
     BACKGROUND_PERCEIVABLE_GRACE_PERIOD,
     BACKGROUND_GRACE_PERIOD,
@@ -254,6 +338,24 @@ class ParticularProcessPriorityManager final : public WakeLockObserver,
 
   void ActivityChanged(BrowserParent* aBrowserParent, bool aIsActive);
 
+  /**
+   * Records what /proc said about this process, and asks it for its
+   * counters to complete the sample.
+   */
+  void SampleMemory(const ProcessMemoryRollup& aRollup);
+
+  /** The USS of the process at the last memory sample, 0 if none. */
+  int64_t LastUss() const { return mRollup.mUss; }
+
+  /**
+   * Once the process has stayed in the background for
+   * dom.ipc.processPriorityManager.backgroundPageOutMS, moves its heap out to
+   * zram, see hal::PageOutProcess(). It is then cheap to keep around, and
+   * comes back page by page when the process runs again.
+   */
+  void SchedulePageOut();
+  void PageOut();
+
   void ShutDown();
 
   NS_IMETHOD GetName(nsACString& aName) override {
@@ -280,6 +382,11 @@ class ParticularProcessPriorityManager final : public WakeLockObserver,
   nsAutoCString mNameWithComma;
 
   nsCOMPtr<nsITimer> mResetPriorityTimer;
+  nsCOMPtr<nsITimer> mPageOutTimer;
+
+  TimeStamp mBackgroundSince;
+
+  ProcessMemoryRollup mRollup;
 
   // This hashtable contains the list of active TabId for this process.
   nsTHashSet<uint64_t> mActiveBrowserParents;
@@ -364,7 +471,11 @@ ProcessPriorityManagerImpl::ProcessPriorityManagerImpl() {
   MOZ_ASSERT(XRE_IsParentProcess());
 }
 
-ProcessPriorityManagerImpl::~ProcessPriorityManagerImpl() = default;
+ProcessPriorityManagerImpl::~ProcessPriorityManagerImpl() {
+  if (mMemorySampleTimer) {
+    mMemorySampleTimer->Cancel();
+  }
+}
 
 void ProcessPriorityManagerImpl::Init() {
   LOG("Starting up.  This is the parent process.");
@@ -377,6 +488,71 @@ void ProcessPriorityManagerImpl::Init() {
   nsCOMPtr<nsIObserverService> os = services::GetObserverService();
   if (os) {
     os->AddObserver(this, "ipc:content-shutdown", /* ownsWeak */ true);
+#ifdef MOZ_WIDGET_GONK
+    os->AddObserver(this, GONK_MEMORY_PRESSURE_CRITICAL_TOPIC,
+                    /* ownsWeak */ true);
+#endif
+  }
+
+#ifdef XP_LINUX
+  if (uint32_t interval = StaticPrefs::
+          dom_ipc_processPriorityManager_memorySampleIntervalMS()) {
+    NS_NewTimerWithFuncCallback(
+        getter_AddRefs(mMemorySampleTimer),
+        [](nsITimer*, void* aClosure) {
+          static_cast<ProcessPriorityManagerImpl*>(aClosure)->SampleMemory();
+        },
+        this, interval, nsITimer::TYPE_REPEATING_SLACK,
+        "ProcessPriorityManagerImpl::SampleMemory");
+  }
+#endif
+}
+
+void ProcessPriorityManagerImpl::SampleMemory() {
+#ifdef XP_LINUX
+  nsTArray<uint64_t> childIDs;
+  nsTArray<int32_t> pids;
+  for (const auto& pppm : mParticularManagers.Values()) {
+    if (pppm->Pid() > 0) {
+      childIDs.AppendElement(pppm->ChildID());
+      pids.AppendElement(pppm->Pid());
+    }
+  }
+  if (pids.IsEmpty()) {
+    return;
+  }
+
+  NS_DispatchBackgroundTask(
+      NS_NewRunnableFunction(
+          "ProcessPriorityManagerImpl::SampleMemory",
+          [childIDs = std::move(childIDs), pids = std::move(pids)]() {
+            nsTArray<ProcessMemoryRollup> rollups(pids.Length());
+            for (int32_t pid : pids) {
+              ReadSmapsRollup(pid, rollups.AppendElement());
+            }
+            NS_DispatchToMainThread(NS_NewRunnableFunction(
+                "ProcessPriorityManagerImpl::OnMemorySampled",
+                [childIDs = std::move(childIDs),
+                 rollups = std::move(rollups)]() {
+                  if (sSingleton) {
+                    sSingleton->OnMemorySampled(childIDs, rollups);
+                  }
+                }));
+          }),
+      NS_DISPATCH_EVENT_MAY_BLOCK);
+#endif
+}
+
+void ProcessPriorityManagerImpl::OnMemorySampled(
+    const nsTArray<uint64_t>& aChildIDs,
+    const nsTArray<ProcessMemoryRollup>& aRollups) {
+  MOZ_ASSERT(aChildIDs.Length() == aRollups.Length());
+  for (size_t i = 0; i < aChildIDs.Length(); i++) {
+    // The process may have gone away while we were reading.
+    if (auto entry = mParticularManagers.Lookup(aChildIDs[i])) {
+      RefPtr<ParticularProcessPriorityManager> pppm = entry.Data();
+      pppm->SampleMemory(aRollups[i]);
+    }
   }
 }
 
@@ -386,6 +562,10 @@ ProcessPriorityManagerImpl::Observe(nsISupports* aSubject, const char* aTopic,
   nsDependentCString topic(aTopic);
   if (topic.EqualsLiteral("ipc:content-shutdown")) {
     ObserveContentParentDestroyed(aSubject);
+#ifdef MOZ_WIDGET_GONK
+  } else if (topic.EqualsLiteral(GONK_MEMORY_PRESSURE_CRITICAL_TOPIC)) {
+    KillOldestBackgroundProcess();
+#endif
   } else {
     MOZ_ASSERT(false);
   }
@@ -430,6 +610,35 @@ void ProcessPriorityManagerImpl::ObserveContentParentDestroyed(
   }
 }
 
+#ifdef MOZ_WIDGET_GONK
+void ProcessPriorityManagerImpl::KillOldestBackgroundProcess() {
+  RefPtr<ParticularProcessPriorityManager> victim;
+  for (const auto& pppm : mParticularManagers.Values()) {
+    if (pppm->CurrentPriority() != PROCESS_PRIORITY_BACKGROUND ||
+        pppm->Pid() <= 0) {
+      continue;
+    }
+    if (!victim || pppm->BackgroundSince() < victim->BackgroundSince()) {
+      victim = pppm;
+    }
+  }
+
+  if (!victim) {
+    LOG("Critical memory pressure, but no background process to kill.");
+    return;
+  }
+
+  // Don't go through ContentParent::KillHard(): it writes a paired minidump,
+  // which is the last thing we want to do when memory is this tight. This is
+  // what the LMK would do to the process anyway; the usual abnormal shutdown
+  // handling cleans up after it.
+  LOG("Critical memory pressure, killing background process %d (%" PRId64
+      " bytes unique).",
+      victim->Pid(), victim->LastUss());
+  kill(victim->Pid(), SIGKILL);
+}
+#endif
+
 void ProcessPriorityManagerImpl::NotifyProcessPriorityChanged(
     ParticularProcessPriorityManager* aParticularManager,
     ProcessPriority aOldPriority) {
@@ -697,6 +906,17 @@ void ParticularProcessPriorityManager::SetPriorityNow(
 
   mPriority = aPriority;
 
+  if (mPriority == PROCESS_PRIORITY_BACKGROUND) {
+    mBackgroundSince = TimeStamp::Now();
+    SchedulePageOut();
+  } else {
+    mBackgroundSince = TimeStamp();
+    if (mPageOutTimer) {
+      mPageOutTimer->Cancel();
+      mPageOutTimer = nullptr;
+    }
+  }
+
   // We skip incrementing the DOM_CONTENTPROCESS_OS_PRIORITY_RAISED if we're
   // transitioning from the PROCESS_PRIORITY_UNKNOWN level, which is where
   // we initialize at.
@@ -710,6 +930,17 @@ void ParticularProcessPriorityManager::SetPriorityNow(
 
   hal::SetProcessPriority(Pid(), mPriority);
 
+  // Coming to the foreground, e.g. an app being launched or switched to, is
+  // when the user waits for the process most, so give it the CPU it needs to
+  // get its first frames out.
+  if (mPriority >= PROCESS_PRIORITY_FOREGROUND &&
+      oldPriority < PROCESS_PRIORITY_FOREGROUND) {
+    uint32_t boostMs =
+        StaticPrefs::dom_ipc_processPriorityManager_launchBoostMS();
+    hal::BoostForegroundProcesses(boostMs);
+    hal::NotifyPerformanceHint(hal::PERFORMANCE_HINT_APP_LAUNCH, boostMs);
+  }
+
   if (oldPriority != mPriority) {
     ProcessPriorityManagerImpl::GetSingleton()->NotifyProcessPriorityChanged(
         this, oldPriority);
@@ -734,6 +965,67 @@ void ParticularProcessPriorityManager::ActivityChanged(
   ResetPriority();
 }
 
+void ParticularProcessPriorityManager::SampleMemory(
+    const ProcessMemoryRollup& aRollup) {
+  if (!mContentParent) {
+    return;
+  }
+  mRollup = aRollup;
+
+  RefPtr<ParticularProcessPriorityManager> self = this;
+  int32_t pid = Pid();
+  mContentParent->SendGetMemoryCounters(
+      [self, pid](const MemoryCounters& aCounters) {
+        nsCOMPtr<nsIObserverService> os = services::GetObserverService();
+        if (!os || !self->mContentParent) {
+          return;
+        }
+        RefPtr<nsHashPropertyBag> props = new nsHashPropertyBag();
+        props->SetPropertyAsUint64(u"childID"_ns, self->ChildID());
+        props->SetPropertyAsInt32(u"pid"_ns, pid);
+        props->SetPropertyAsInt64(u"uss"_ns, self->mRollup.mUss);
+        props->SetPropertyAsInt64(u"pss"_ns, self->mRollup.mPss);
+        props->SetPropertyAsInt64(u"swap"_ns, self->mRollup.mSwap);
+        props->SetPropertyAsInt64(u"jsHeap"_ns, aCounters.jsHeap());
+        props->SetPropertyAsInt64(u"images"_ns, aCounters.images());
+        props->SetPropertyAsInt64(u"layers"_ns, aCounters.layers());
+        props->SetPropertyAsInt64(u"heapAllocated"_ns,
+                                  aCounters.heapAllocated());
+        os->NotifyObservers(static_cast<nsIPropertyBag2*>(props),
+                            "process-memory-sample", nullptr);
+      },
+      // The process is going away, there is nothing to report.
+      [](mozilla::ipc::ResponseRejectReason) {});
+}
+
+void ParticularProcessPriorityManager::SchedulePageOut() {
+  uint32_t delay =
+      StaticPrefs::dom_ipc_processPriorityManager_backgroundPageOutMS();
+  if (!delay || mPageOutTimer) {
+    return;
+  }
+
+  NS_NewTimerWithFuncCallback(
+      getter_AddRefs(mPageOutTimer),
+      [](nsITimer* aTimer, void* aClosure) {
+        static_cast<ParticularProcessPriorityManager*>(aClosure)->PageOut();
+      },
+      this, delay, nsITimer::TYPE_ONE_SHOT,
+      "ParticularProcessPriorityManager::PageOut");
+}
+
+void ParticularProcessPriorityManager::PageOut() {
+  mPageOutTimer = nullptr;
+  if (!mContentParent || mPriority != PROCESS_PRIORITY_BACKGROUND ||
+      Pid() <= 0) {
+    return;
+  }
+
+  LOGP("Paging out after %dms in the background.",
+       int((TimeStamp::Now() - mBackgroundSince).ToMilliseconds()));
+  hal::PageOutProcess(Pid());
+}
+
 void ParticularProcessPriorityManager::ShutDown() {
   LOGP("shutdown for %p (mContentParent %p)", this, mContentParent);
 
@@ -750,6 +1042,11 @@ void ParticularProcessPriorityManager::ShutDown() {
     mResetPriorityTimer = nullptr;
   }
 
+  if (mPageOutTimer) {
+    mPageOutTimer->Cancel();
+    mPageOutTimer = nullptr;
+  }
+
   mContentParent = nullptr;
 }
 
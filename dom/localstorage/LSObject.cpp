@@ -231,13 +231,47 @@ class RequestHelper final : public Runnable, public LSRequestChildCallback {
   void OnResponse(const LSRequestResponse& aResponse) override;
 };
 
+/**
+ * Helper for LSObject::Prefetch.  Like RequestHelper, it starts the request on
+ * the RemoteLazyInputStream thread, so that the Ready message can be answered
+ * even if the main thread is blocked by a synchronous request for the same
+ * origin.  Nothing waits for it though; the response is simply dispatched back
+ * to the main thread.
+ */
+class PrefetchHelper final : public Runnable, public LSRequestChildCallback {
+  // Dropped on return to the main thread.
+  RefPtr<LSObject> mObject;
+  const LSRequestParams mParams;
+  LSRequestResponse mResponse;
+  bool mFinishing;
+
+ public:
+  PrefetchHelper(LSObject* aObject, const LSRequestParams& aParams)
+      : Runnable("dom::PrefetchHelper"),
+        mObject(aObject),
+        mParams(aParams),
+        mResponse(NS_ERROR_FAILURE),
+        mFinishing(false) {}
+
+ private:
+  ~PrefetchHelper() = default;
+
+  NS_DECL_ISUPPORTS_INHERITED
+
+  NS_DECL_NSIRUNNABLE
+
+  // LSRequestChildCallback
+  void OnResponse(const LSRequestResponse& aResponse) override;
+};
+
 }  // namespace
 
 LSObject::LSObject(nsPIDOMWindowInner* aWindow, nsIPrincipal* aPrincipal,
                    nsIPrincipal* aStoragePrincipal)
     : Storage(aWindow, aPrincipal, aStoragePrincipal),
       mPrivateBrowsingId(0),
-      mInExplicitSnapshot(false) {
+      mInExplicitSnapshot(false),
+      mPrefetching(false) {
   AssertIsOnOwningThread();
   MOZ_ASSERT(NextGenLocalStorageEnabled());
 }
@@ -936,7 +970,15 @@ nsresult LSObject::EnsureDatabase() {
   const LSRequestPrepareDatastoreResponse& prepareDatastoreResponse =
       response.get_LSRequestPrepareDatastoreResponse();
 
-  uint64_t datastoreId = prepareDatastoreResponse.datastoreId();
+  ConnectDatabase(backgroundActor, prepareDatastoreResponse.datastoreId());
+
+  return NS_OK;
+}
+
+void LSObject::ConnectDatabase(
+    mozilla::ipc::PBackgroundChild* aBackgroundActor, uint64_t aDatastoreId) {
+  AssertIsOnOwningThread();
+  MOZ_ASSERT(aBackgroundActor);
 
   // The datastore is now ready on the parent side (prepared by the asynchronous
   // request on the RemoteLazyInputStream thread).
@@ -949,14 +991,83 @@ nsresult LSObject::EnsureDatabase() {
 
   LSDatabaseChild* actor = new LSDatabaseChild(database);
 
-  MOZ_ALWAYS_TRUE(backgroundActor->SendPBackgroundLSDatabaseConstructor(
-      actor, *mStoragePrincipalInfo, mPrivateBrowsingId, datastoreId));
+  MOZ_ALWAYS_TRUE(aBackgroundActor->SendPBackgroundLSDatabaseConstructor(
+      actor, *mStoragePrincipalInfo, mPrivateBrowsingId, aDatastoreId));
 
   database->SetActor(actor);
 
   mDatabase = std::move(database);
+}
 
-  return NS_OK;
+void LSObject::Prefetch() {
+  AssertIsOnOwningThread();
+
+  if (mPrefetching || (mDatabase && !mDatabase->IsAllowedToClose()) ||
+      LSDatabase::Get(mOrigin)) {
+    return;
+  }
+
+  // Make sure the response can be handled, see EnsureDatabase.
+  mozilla::ipc::PBackgroundChild* backgroundActor =
+      mozilla::ipc::BackgroundChild::GetOrCreateForCurrentThread();
+  if (NS_WARN_IF(!backgroundActor)) {
+    return;
+  }
+
+  nsCOMPtr<nsIEventTarget> domFileThread =
+      XRE_IsParentProcess() ? RemoteLazyInputStreamThread::GetOrCreate()
+                            : RemoteLazyInputStreamThread::Get();
+  if (NS_WARN_IF(!domFileThread)) {
+    return;
+  }
+
+  LSRequestCommonParams commonParams;
+  commonParams.principalInfo() = *mPrincipalInfo;
+  commonParams.storagePrincipalInfo() = *mStoragePrincipalInfo;
+  commonParams.originKey() = mOriginKey;
+
+  LSRequestPrepareDatastoreParams params;
+  params.commonParams() = commonParams;
+  params.clientId() = mClientId;
+
+  RefPtr<PrefetchHelper> helper = new PrefetchHelper(this, params);
+
+  if (NS_WARN_IF(
+          NS_FAILED(domFileThread->Dispatch(helper, NS_DISPATCH_NORMAL)))) {
+    return;
+  }
+
+  mPrefetching = true;
+}
+
+void LSObject::OnPrefetchResponse(const LSRequestResponse& aResponse) {
+  AssertIsOnOwningThread();
+  MOZ_ASSERT(mPrefetching);
+
+  mPrefetching = false;
+
+  // On failure, the first access just tries again.
+  if (aResponse.type() !=
+      LSRequestResponse::TLSRequestPrepareDatastoreResponse) {
+    return;
+  }
+
+  // The first access may have been quicker and done its own request.  The
+  // datastore prepared for us is then released by the parent after a while.
+  if ((mDatabase && !mDatabase->IsAllowedToClose()) ||
+      LSDatabase::Get(mOrigin)) {
+    return;
+  }
+
+  mozilla::ipc::PBackgroundChild* backgroundActor =
+      mozilla::ipc::BackgroundChild::GetForCurrentThread();
+  if (NS_WARN_IF(!backgroundActor)) {
+    return;
+  }
+
+  ConnectDatabase(
+      backgroundActor,
+      aResponse.get_LSRequestPrepareDatastoreResponse().datastoreId());
 }
 
 void LSObject::DropDatabase() {
@@ -1367,4 +1478,42 @@ void RequestHelper::OnResponse(const LSRequestResponse& aResponse) {
       mNestedEventTargetWrapper->Dispatch(this, NS_DISPATCH_NORMAL));
 }
 
+NS_IMPL_ISUPPORTS_INHERITED0(PrefetchHelper, Runnable)
+
+NS_IMETHODIMP
+PrefetchHelper::Run() {
+  if (!mFinishing) {
+    AssertIsOnDOMFileThread();
+
+    // The main event target is only used in the parent process, for creating
+    // PBackground, and nothing blocks the main thread here.
+    if (NS_WARN_IF(!mObject->StartRequest(GetMainThreadSerialEventTarget(),
+                                          mParams, this))) {
+      mFinishing = true;
+
+      MOZ_ALWAYS_SUCCEEDS(NS_DispatchToMainThread(this));
+    }
+
+    return NS_OK;
+  }
+
+  MOZ_ASSERT(NS_IsMainThread());
+
+  RefPtr<LSObject> object = std::move(mObject);
+  object->OnPrefetchResponse(mResponse);
+
+  return NS_OK;
+}
+
+void PrefetchHelper::OnResponse(const LSRequestResponse& aResponse) {
+  AssertIsOnDOMFileThread();
+  MOZ_ASSERT(!mFinishing);
+
+  mResponse = aResponse;
+
+  mFinishing = true;
+
+  MOZ_ALWAYS_SUCCEEDS(NS_DispatchToMainThread(this));
+}
+
 }  // namespace mozilla::dom
@@ -33,6 +33,7 @@ class ErrorResult;
 
 namespace ipc {
 
+class PBackgroundChild;
 class PrincipalInfo;
 
 }  // namespace ipc
@@ -87,6 +88,7 @@ class LSObject final : public Storage {
   nsString mDocumentURI;
 
   bool mInExplicitSnapshot;
+  bool mPrefetching;
 
  public:
   static void Initialize();
@@ -142,6 +144,22 @@ class LSObject final : public Storage {
                                const LSRequestParams& aParams,
                                LSRequestChildCallback* aCallback);
 
+  /**
+   * Asynchronously prepares the datastore and connects to it, so that the
+   * first access doesn't have to wait for the synchronous prepare datastore
+   * request done by EnsureDatabase.  Invoked by nsGlobalWindowInner when a
+   * document is loaded, see dom.storage.prefetch_datastore.  The datastore
+   * itself is usually preloaded already by the parent process at that point,
+   * in ContentParent::AboutToLoadHttpFtpDocumentForChild.
+   */
+  void Prefetch();
+
+  /**
+   * Invoked on the owning thread with the response to the request started by
+   * Prefetch.
+   */
+  void OnPrefetchResponse(const LSRequestResponse& aResponse);
+
   // Storage overrides.
   StorageType Type() const override;
 
@@ -199,6 +217,9 @@ class LSObject final : public Storage {
 
   nsresult EnsureDatabase();
 
+  void ConnectDatabase(mozilla::ipc::PBackgroundChild* aBackgroundActor,
+                       uint64_t aDatastoreId);
+
   void DropDatabase();
 
   /**
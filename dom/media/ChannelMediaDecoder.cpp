@@ -19,6 +19,8 @@
 #  include "MediaDecoderStateMachineProxy.h"
 #  include "MediaFormatReaderProxy.h"
 #  include "MediaOffloadPlayer.h"
+#  include "mozilla/dom/HTMLMediaElement.h"
+#  include "mozilla/Telemetry.h"
 #endif
 
 namespace mozilla {
@@ -232,34 +234,43 @@ static bool CheckOffloadAllowlist(const MediaMIMEType& aMimeType) {
   return false;
 }
 
-static bool CanOffloadMedia(nsIURI* aURI, const MediaMIMEType& aMimeType,
-                            bool aIsVideo, bool aIsTransportSeekable) {
+using OffloadEligibility = Telemetry::LABELS_MEDIA_OFFLOAD_PLAYER_ELIGIBILITY;
+
+static OffloadEligibility CheckOffloadEligibility(
+    nsIURI* aURI, const MediaMIMEType& aMimeType, bool aIsVideo,
+    bool aIsTransportSeekable, bool aIsCaptured) {
   if (!aIsTransportSeekable) {
-    return false;
+    return OffloadEligibility::NotSeekable;
   }
 
   if (!CheckOffloadAllowlist(aMimeType)) {
-    return false;
+    return OffloadEligibility::MimeType;
   }
 
   if (!aIsVideo && !StaticPrefs::media_offloadplayer_audio_enabled()) {
-    return false;
+    return OffloadEligibility::Disabled;
   }
 
   if (aIsVideo && !StaticPrefs::media_offloadplayer_video_enabled()) {
-    return false;
+    return OffloadEligibility::Disabled;
+  }
+
+  // The offload player renders straight to the audio HAL and has nothing to
+  // feed a MediaTrackGraph, so Web Audio and captureStream() need decoded PCM.
+  if (aIsCaptured) {
+    return OffloadEligibility::Captured;
   }
 
   if ((aURI->SchemeIs("http") || aURI->SchemeIs("https")) &&
       StaticPrefs::media_offloadplayer_http_enabled()) {
-    return true;
+    return OffloadEligibility::Offloaded;
   }
 
   if (aURI->SchemeIs("file") || aURI->SchemeIs("blob")) {
-    return true;
+    return OffloadEligibility::Offloaded;
   }
 
-  return false;
+  return OffloadEligibility::Scheme;
 }
 
 MediaDecoderStateMachineProxy* ChannelMediaDecoder::CreateStateMachine() {
@@ -275,10 +286,16 @@ MediaDecoderStateMachineProxy* ChannelMediaDecoder::CreateStateMachine() {
   nsCOMPtr<nsIURI> uri = mResource->GetURI();
   MOZ_ASSERT(uri);
 
+  dom::HTMLMediaElement* element = GetOwner()->GetMediaElement();
+  OffloadEligibility eligibility = CheckOffloadEligibility(
+      uri, ContainerType().Type(),
+      /* aIsVideo = */ GetVideoFrameContainer(),
+      mResource->IsTransportSeekable(),
+      /* aIsCaptured = */ element && element->AreTracksCaptured());
+  Telemetry::AccumulateCategorical(eligibility);
+
   // Offload path uses MediaOffloadPlayer.
-  if (CanOffloadMedia(uri, ContainerType().Type(),
-                      /* aIsVideo = */ GetVideoFrameContainer(),
-                      mResource->IsTransportSeekable())) {
+  if (eligibility == OffloadEligibility::Offloaded) {
     RefPtr<MediaOffloadPlayer> player = MediaOffloadPlayer::Create(init, uri);
     mReader = new MediaFormatReaderProxy(player);
     return new MediaDecoderStateMachineProxy(player);
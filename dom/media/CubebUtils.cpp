@@ -573,6 +573,13 @@ uint32_t GetCubebMTGLatencyInFrames(cubeb_stream_params* params) {
 #ifdef MOZ_WIDGET_ANDROID
   return AndroidGetAudioOutputFramesPerBuffer();
 #else
+#  ifdef MOZ_WIDGET_GONK
+  // The OpenSL backend has no get_min_latency, and picks a fast mixer track
+  // when the buffer is small enough.
+  if (uint32_t fastFrames = StaticPrefs::media_cubeb_gonk_fast_track_frames()) {
+    return fastFrames;
+  }
+#  endif
   cubeb* context = GetCubebContextUnlocked();
   if (!context) {
     return sCubebMTGLatencyInFrames;  // default 512
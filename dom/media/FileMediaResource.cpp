@@ -5,7 +5,11 @@
 
 #include "FileMediaResource.h"
 
+#include "VideoUtils.h"
 #include "mozilla/AbstractThread.h"
+#include "mozilla/Logging.h"
+#include "mozilla/StaticPrefs_media.h"
+#include "mozilla/TaskQueue.h"
 #include "mozilla/dom/BlobImpl.h"
 #include "mozilla/dom/BlobURLProtocolHandler.h"
 #include "nsContentUtils.h"
@@ -14,9 +18,19 @@
 #include "nsIFileStreams.h"
 #include "nsITimedChannel.h"
 #include "nsNetUtil.h"
+#include "nsPrintfCString.h"
 
 namespace mozilla {
 
+static LazyLogModule gFileMediaResourceLog("FileMediaResource");
+#undef LOG
+#define LOG(msg, ...)                                      \
+  MOZ_LOG(gFileMediaResourceLog, mozilla::LogLevel::Debug, \
+          ("%p " msg, this, ##__VA_ARGS__))
+
+// The most the read-ahead window grows to while the storage stalls.
+static const uint32_t kMaxWindowScale = 8;
+
 void FileMediaResource::EnsureSizeInitialized() {
   mLock.AssertCurrentThreadOwns();
   NS_ASSERTION(mInput, "Must have file input stream");
@@ -71,6 +85,18 @@ nsresult FileMediaResource::Open(nsIStreamListener** aStreamListener) {
     rv = NS_NewLocalFileInputStream(getter_AddRefs(mInput), file, -1, -1,
                                     nsIFileInputStream::SHARE_DELETE);
     NS_ENSURE_SUCCESS(rv, rv);
+
+    if (StaticPrefs::media_file_readahead_window_ms() &&
+        NS_SUCCEEDED(NS_NewLocalFileInputStream(
+            getter_AddRefs(mPrefetchInput), file, -1, -1,
+            nsIFileInputStream::SHARE_DELETE))) {
+      mPrefetchSeekable = do_QueryInterface(mPrefetchInput);
+      if (mPrefetchSeekable) {
+        mPrefetchQueue =
+            new TaskQueue(GetMediaThreadPool(MediaThreadType::SUPERVISOR),
+                          "FileMediaResource::mPrefetchQueue");
+      }
+    }
   } else if (dom::IsBlobURI(mURI)) {
     RefPtr<dom::BlobImpl> blobImpl;
     rv = NS_GetBlobForBlobURI(mURI, getter_AddRefs(blobImpl));
@@ -106,6 +132,20 @@ RefPtr<GenericPromise> FileMediaResource::Close() {
     mChannel = nullptr;
   }
 
+  RefPtr<TaskQueue> prefetchQueue;
+  {
+    MutexAutoLock lock(mLock);
+    prefetchQueue = std::move(mPrefetchQueue);
+    if (mStallCount) {
+      LOG("Demuxer waited on storage %u times, %.0fms in all, at most %.0fms",
+          mStallCount, mStallTime.ToMilliseconds(),
+          mMaxStall.ToMilliseconds());
+    }
+  }
+  if (prefetchQueue) {
+    prefetchQueue->BeginShutdown();
+  }
+
   return GenericPromise::CreateAndResolve(true, __func__);
 }
 
@@ -181,13 +221,165 @@ nsresult FileMediaResource::ReadAt(int64_t aOffset, char* aBuffer,
   nsresult rv;
   {
     MutexAutoLock lock(mLock);
-    rv = UnsafeSeek(nsISeekableStream::NS_SEEK_SET, aOffset);
-    if (NS_FAILED(rv)) return rv;
-    rv = UnsafeRead(aBuffer, aCount, aBytes);
+    if (!mPrefetchQueue) {
+      rv = UnsafeSeek(nsISeekableStream::NS_SEEK_SET, aOffset);
+      if (NS_FAILED(rv)) return rv;
+      return UnsafeRead(aBuffer, aCount, aBytes);
+    }
+
+    bool sequential = aOffset == mLastReadEnd;
+    TimeStamp start = TimeStamp::Now();
+    // Rather than reading the same data a second time, wait for a prefetch
+    // that is already reading it.
+    if (mPrefetching && aOffset >= mPrefetchOffset && aOffset < mPrefetchEnd) {
+      while (mPrefetching) {
+        mPrefetchDone.Wait();
+      }
+    }
+    if (ReadFromReadAhead(aOffset, aBuffer, aCount, aBytes)) {
+      rv = NS_OK;
+      sequential = true;
+    } else {
+      rv = UnsafeSeek(nsISeekableStream::NS_SEEK_SET, aOffset);
+      if (NS_FAILED(rv)) return rv;
+      rv = UnsafeRead(aBuffer, aCount, aBytes);
+      NS_ENSURE_SUCCESS(rv, rv);
+    }
+    RecordDemuxerWait(TimeStamp::Now() - start);
+
+    mLastReadEnd = aOffset + *aBytes;
+    if (sequential) {
+      MaybePrefetch(mLastReadEnd);
+    }
   }
   return rv;
 }
 
+bool FileMediaResource::ReadFromReadAhead(int64_t aOffset, char* aBuffer,
+                                          uint32_t aCount, uint32_t* aBytes) {
+  mLock.AssertCurrentThreadOwns();
+  if (!mReadAhead || aOffset < mReadAheadOffset ||
+      aOffset >= mReadAheadOffset + int64_t(mReadAhead->Length())) {
+    return false;
+  }
+  // Short reads are fine, callers come back for the rest.
+  size_t start = size_t(aOffset - mReadAheadOffset);
+  uint32_t count =
+      uint32_t(std::min<size_t>(aCount, mReadAhead->Length() - start));
+  memcpy(aBuffer, mReadAhead->Elements() + start, count);
+  *aBytes = count;
+  return true;
+}
+
+uint32_t FileMediaResource::ReadAheadBlockSize() const {
+  mLock.AssertCurrentThreadOwns();
+  uint64_t minBlock =
+      uint64_t(StaticPrefs::media_file_readahead_min_block_kb()) * 1024;
+  uint64_t maxBlock = std::max<uint64_t>(
+      uint64_t(StaticPrefs::media_file_readahead_max_block_kb()) * 1024,
+      minBlock);
+  // Until the decoder knows the bitrate, read the smallest blocks.
+  uint64_t block = uint64_t(mPlaybackRate) *
+                   StaticPrefs::media_file_readahead_window_ms() / 1000 *
+                   mWindowScale;
+  return uint32_t(std::min(std::max(block, minBlock), maxBlock));
+}
+
+void FileMediaResource::MaybePrefetch(int64_t aOffset) {
+  mLock.AssertCurrentThreadOwns();
+  if (!mPrefetchQueue || mPrefetching || (mSize >= 0 && aOffset >= mSize)) {
+    return;
+  }
+  uint32_t block = ReadAheadBlockSize();
+  if (!block) {
+    return;
+  }
+  // Keep at least half a block ahead of the demuxer. The next block starts
+  // where the demuxer is, so the data still ahead of it is read again, but
+  // one buffer always covers everything from there.
+  if (mReadAhead && aOffset >= mReadAheadOffset) {
+    int64_t ahead = mReadAheadOffset + int64_t(mReadAhead->Length()) - aOffset;
+    if (ahead > int64_t(block / 2)) {
+      return;
+    }
+  }
+
+  mPrefetching = true;
+  mPrefetchOffset = aOffset;
+  mPrefetchEnd = aOffset + block;
+  RefPtr<FileMediaResource> self = this;
+  nsresult rv = mPrefetchQueue->Dispatch(NS_NewRunnableFunction(
+      "FileMediaResource::Prefetch",
+      [self, aOffset, block]() { self->Prefetch(aOffset, block); }));
+  if (NS_FAILED(rv)) {
+    mPrefetching = false;
+  }
+}
+
+void FileMediaResource::Prefetch(int64_t aOffset, uint32_t aCount) {
+  RefPtr<MediaByteBuffer> bytes = new MediaByteBuffer();
+  TimeStamp start = TimeStamp::Now();
+  uint32_t filled = 0;
+  if (bytes->SetLength(aCount, fallible) &&
+      NS_SUCCEEDED(
+          mPrefetchSeekable->Seek(nsISeekableStream::NS_SEEK_SET, aOffset))) {
+    char* data = reinterpret_cast<char*>(bytes->Elements());
+    while (filled < aCount) {
+      uint32_t read = 0;
+      if (NS_FAILED(mPrefetchInput->Read(data + filled, aCount - filled,
+                                         &read)) ||
+          !read) {
+        break;
+      }
+      filled += read;
+    }
+  }
+  TimeDuration latency = TimeStamp::Now() - start;
+
+  MutexAutoLock lock(mLock);
+  mPrefetching = false;
+  mPrefetchDone.NotifyAll();
+  if (!filled) {
+    return;
+  }
+  bytes->SetLength(filled);
+  mReadAhead = std::move(bytes);
+  mReadAheadOffset = aOffset;
+  AdaptReadAhead(latency);
+}
+
+void FileMediaResource::AdaptReadAhead(const TimeDuration& aLatency) {
+  mLock.AssertCurrentThreadOwns();
+  double threshold = StaticPrefs::media_file_readahead_stall_threshold_ms();
+  double latency = aLatency.ToMilliseconds();
+  if (latency > threshold && mWindowScale < kMaxWindowScale) {
+    mWindowScale *= 2;
+    LOG("Prefetch took %.0fms, reading ahead %u windows", latency,
+        mWindowScale);
+  } else if (latency < threshold / 4 && mWindowScale > 1) {
+    mWindowScale /= 2;
+  }
+}
+
+void FileMediaResource::RecordDemuxerWait(const TimeDuration& aWait) {
+  mLock.AssertCurrentThreadOwns();
+  if (aWait.ToMilliseconds() <=
+      StaticPrefs::media_file_readahead_stall_threshold_ms()) {
+    return;
+  }
+  mStallCount++;
+  mStallTime += aWait;
+  mMaxStall = std::max(mMaxStall, aWait);
+  // A stall of the demuxer itself is as bad as prefetching gets.
+  AdaptReadAhead(aWait);
+  LOG("Demuxer waited %.0fms on storage", aWait.ToMilliseconds());
+  DDLOG(DDLogCategory::Log, "storage_stall",
+        nsCString(nsPrintfCString(
+            "%.0fms, %u stalls, %.0fms in all, at most %.0fms",
+            aWait.ToMilliseconds(), mStallCount, mStallTime.ToMilliseconds(),
+            mMaxStall.ToMilliseconds())));
+}
+
 already_AddRefed<MediaByteBuffer> FileMediaResource::UnsafeMediaReadAt(
     int64_t aOffset, uint32_t aCount) {
   RefPtr<MediaByteBuffer> bytes = new MediaByteBuffer();
@@ -219,4 +411,6 @@ nsresult FileMediaResource::UnsafeSeek(int32_t aWhence, int64_t aOffset) {
   return mSeekable->Seek(aWhence, aOffset);
 }
 
+#undef LOG
+
 }  // namespace mozilla
@@ -7,17 +7,26 @@
 #define mozilla_dom_media_FileMediaResource_h
 
 #include "BaseMediaResource.h"
+#include "mozilla/Atomics.h"
+#include "mozilla/CondVar.h"
 #include "mozilla/Mutex.h"
+#include "mozilla/TimeStamp.h"
 
 namespace mozilla {
 
-class FileMediaResource : public BaseMediaResource {
+class TaskQueue;
+
+DDLoggedTypeDeclNameAndBase(FileMediaResource, BaseMediaResource);
+
+class FileMediaResource : public BaseMediaResource,
+                          public DecoderDoctorLifeLogger<FileMediaResource> {
  public:
   FileMediaResource(MediaResourceCallback* aCallback, nsIChannel* aChannel,
                     nsIURI* aURI, int64_t aSize = -1 /* unknown size */)
       : BaseMediaResource(aCallback, aChannel, aURI),
         mSize(aSize),
         mLock("FileMediaResource.mLock"),
+        mPrefetchDone(mLock, "FileMediaResource.mPrefetchDone"),
         mSizeInitialized(aSize != -1) {}
   ~FileMediaResource() = default;
 
@@ -35,7 +44,9 @@ class FileMediaResource : public BaseMediaResource {
 
   // Other thread
   void SetReadMode(MediaCacheStream::ReadMode aMode) override {}
-  void SetPlaybackRate(uint32_t aBytesPerSecond) override {}
+  void SetPlaybackRate(uint32_t aBytesPerSecond) override {
+    mPlaybackRate = aBytesPerSecond;
+  }
   nsresult ReadAt(int64_t aOffset, char* aBuffer, uint32_t aCount,
                   uint32_t* aBytes) override;
   // (Probably) file-based, caching recommended.
@@ -100,6 +111,18 @@ class FileMediaResource : public BaseMediaResource {
   already_AddRefed<MediaByteBuffer> UnsafeMediaReadAt(int64_t aOffset,
                                                       uint32_t aCount);
 
+  // Reading ahead, see media.file.readahead.window-ms. A block of the file
+  // past the last sequential read is read on mPrefetchQueue, through a
+  // stream of its own, so a slow card stalls the prefetch rather than the
+  // demuxer. mLock must be held for all but Prefetch().
+  bool ReadFromReadAhead(int64_t aOffset, char* aBuffer, uint32_t aCount,
+                         uint32_t* aBytes);
+  void MaybePrefetch(int64_t aOffset);
+  void Prefetch(int64_t aOffset, uint32_t aCount);
+  uint32_t ReadAheadBlockSize() const;
+  void AdaptReadAhead(const TimeDuration& aLatency);
+  void RecordDemuxerWait(const TimeDuration& aWait);
+
   // The file size, or -1 if not known. Immutable after Open().
   // Can be used from any thread.
   int64_t mSize;
@@ -126,7 +149,33 @@ class FileMediaResource : public BaseMediaResource {
   // Set to true if NotifyDataEnded callback has been processed (which only
   // occurs if resource size is known)
   bool mNotifyDataEndedProcessed = false;
-};
+
+  // Null when not reading ahead. Set in Open(), cleared in Close() under
+  // mLock.
+  RefPtr<TaskQueue> mPrefetchQueue;
+  // The prefetch stream, only used on mPrefetchQueue.
+  nsCOMPtr<nsIInputStream> mPrefetchInput;
+  nsCOMPtr<nsISeekableStream> mPrefetchSeekable;
+
+  // The rest is protected by mLock.
+  CondVar mPrefetchDone;
+  RefPtr<MediaByteBuffer> mReadAhead;
+  int64_t mReadAheadOffset = 0;
+  // Where the last read from the demuxer ended, to tell sequential reads.
+  int64_t mLastReadEnd = -1;
+  // The range being prefetched, if mPrefetching.
+  bool mPrefetching = false;
+  int64_t mPrefetchOffset = 0;
+  int64_t mPrefetchEnd = 0;
+  // The read-ahead window is scaled by this, doubling while the storage
+  // stalls and halving while it keeps up.
+  uint32_t mWindowScale = 1;
+  // How often and how long the demuxer waited on the storage.
+  uint32_t mStallCount = 0;
+  TimeDuration mStallTime;
+  TimeDuration mMaxStall;
+
+  Atomic<uint32_t> mPlaybackRate{0};
 
 }  // namespace mozilla
 
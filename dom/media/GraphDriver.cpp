@@ -12,6 +12,7 @@
 #include "mozilla/dom/BaseAudioContextBinding.h"
 #include "mozilla/SchedulerGroup.h"
 #include "mozilla/SharedThreadPool.h"
+#include "mozilla/StaticPrefs_media.h"
 #include "mozilla/ClearOnShutdown.h"
 #include "mozilla/Unused.h"
 #include "mozilla/MathAlgorithms.h"
@@ -495,7 +496,8 @@ AudioCallbackDriver::AudioCallbackDriver(
     GraphInterface* aGraphInterface, GraphDriver* aPreviousDriver,
     uint32_t aSampleRate, uint32_t aOutputChannelCount,
     uint32_t aInputChannelCount, CubebUtils::AudioDeviceID aOutputDeviceID,
-    CubebUtils::AudioDeviceID aInputDeviceID, AudioInputType aAudioInputType)
+    CubebUtils::AudioDeviceID aInputDeviceID, AudioInputType aAudioInputType,
+    bool aLowPower)
     : GraphDriver(aGraphInterface, aPreviousDriver, aSampleRate),
       mOutputChannelCount(aOutputChannelCount),
       mInputChannelCount(aInputChannelCount),
@@ -504,6 +506,7 @@ AudioCallbackDriver::AudioCallbackDriver(
       mIterationDurationMS(MEDIA_GRAPH_TARGET_PERIOD_MS),
       mStarted(false),
       mInitShutdownThread(SharedThreadPool::Get("CubebOperation"_ns, 1)),
+      mLowPower(aLowPower),
       mAudioChannel(aGraphInterface->AudioChannel()),
       mAudioThreadId(0),
       mAudioThreadIdInCb(std::thread::id()),
@@ -672,7 +675,14 @@ void AudioCallbackDriver::Init() {
     }
   }
 #endif
-  LOG(LogLevel::Debug, ("Effective latency in frames: %d", latencyFrames));
+  // Nobody is listening for low latency: let the audio thread render many
+  // graph iterations per wakeup.
+  if (mLowPower) {
+    latencyFrames = std::max(
+        latencyFrames, StaticPrefs::media_audiograph_low_power_latency_frames());
+  }
+  LOG(LogLevel::Debug, ("Effective latency in frames: %d%s", latencyFrames,
+                        mLowPower ? " (low power)" : ""));
 
   input = output;
   input.channels = mInputChannelCount;
@@ -576,13 +576,15 @@ class AudioCallbackDriver : public GraphDriver, public MixerCallbackReceiver {
  public:
   NS_INLINE_DECL_THREADSAFE_REFCOUNTING(AudioCallbackDriver, override);
 
-  /** If aInputChannelCount is zero, then this driver is output-only. */
+  /** If aInputChannelCount is zero, then this driver is output-only.
+   * If aLowPower is true, the stream is opened with a larger buffer so that
+   * each callback renders several graph iterations. */
   AudioCallbackDriver(GraphInterface* aGraphInterface,
                       GraphDriver* aPreviousDriver, uint32_t aSampleRate,
                       uint32_t aOutputChannelCount, uint32_t aInputChannelCount,
                       CubebUtils::AudioDeviceID aOutputDeviceID,
                       CubebUtils::AudioDeviceID aInputDeviceID,
-                      AudioInputType aAudioInputType);
+                      AudioInputType aAudioInputType, bool aLowPower = false);
 
   void Start() override;
   MOZ_CAN_RUN_SCRIPT void Shutdown() override;
@@ -628,6 +630,8 @@ class AudioCallbackDriver : public GraphDriver, public MixerCallbackReceiver {
 
   uint32_t InputChannelCount() { return mInputChannelCount; }
 
+  bool IsLowPower() const { return mLowPower; }
+
   AudioInputType InputDevicePreference() {
     if (mInputDevicePreference == CUBEB_DEVICE_PREF_VOICE) {
       return AudioInputType::Voice;
@@ -762,6 +766,8 @@ class AudioCallbackDriver : public GraphDriver, public MixerCallbackReceiver {
    * initialization and shutdown of the audio stream via AsyncCubebTask. */
   const RefPtr<SharedThreadPool> mInitShutdownThread;
   cubeb_device_pref mInputDevicePreference;
+  /* Whether the stream trades latency for fewer wakeups. */
+  const bool mLowPower;
   /* This is set during initialization, and can be read safely afterwards. */
   dom::AudioChannel mAudioChannel;
 #ifdef B2G_VOICE_PROCESSING
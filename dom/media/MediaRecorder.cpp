@@ -272,7 +272,8 @@ TypeSupport CanRecordAudioTrackWith(const Maybe<MediaContainerType>& aMimeType,
     return TypeSupport::MediaTypeInvalid;
   }
 
-  if (aMimeType->Type() == MEDIAMIMETYPE(AUDIO_3GPP) &&
+  if ((aMimeType->Type() == MEDIAMIMETYPE(AUDIO_3GPP) ||
+       aMimeType->Type() == MEDIAMIMETYPE(VIDEO_3GPP)) &&
       MediaEncoder::IsOMXEncoderEnabled()) {
     return TypeSupport::Supported;
   }
@@ -367,6 +368,30 @@ TypeSupport CanRecordVideoTrackWith(const Maybe<MediaContainerType>& aMimeType,
     return TypeSupport::NoVideoWithAudioType;
   }
 
+  if (aMimeType->Type() == MEDIAMIMETYPE(VIDEO_3GPP) &&
+      MediaEncoder::IsOMXEncoderEnabled()) {
+    // 3GPP video goes to the hardware AVC encoder.
+    size_t avc = 0;
+    for (const auto& codec : aMimeType->ExtendedType().Codecs().Range()) {
+      if (codec.EqualsLiteral("amr")) {
+        // Ignore audio codecs.
+        continue;
+      }
+      if (codec.EqualsLiteral("avc1")) {
+        avc++;
+        continue;
+      }
+      return TypeSupport::CodecUnsupported;
+    }
+    if (avc > 1) {
+      return TypeSupport::CodecDuplicated;
+    }
+    if (avc == 0 && aMimeType->ExtendedType().HaveCodecs()) {
+      return TypeSupport::CodecUnsupported;
+    }
+    return TypeSupport::Supported;
+  }
+
   if (aMimeType->Type() != MEDIAMIMETYPE(VIDEO_WEBM)) {
     return TypeSupport::ContainerUnsupported;
   }
@@ -487,12 +512,17 @@ nsString SelectMimeType(bool aHasVideo, bool aHasAudio,
 
     nsCString codecs;
     {
-      if (aHasVideo && aHasAudio) {
+      if (aHasVideo && majorType.EqualsLiteral(VIDEO_3GPP) &&
+          MediaEncoder::IsOMXEncoderEnabled()) {
+        codecs = aHasAudio ? "\"avc1, amr\""_ns : "avc1"_ns;
+      } else if (aHasVideo && aHasAudio) {
         codecs = "\"vp8, opus\""_ns;
       } else if (aHasVideo) {
         codecs = "vp8"_ns;
       } else {
-        if (majorType.EqualsLiteral(AUDIO_3GPP) && MediaEncoder::IsOMXEncoderEnabled()) {
+        if ((majorType.EqualsLiteral(AUDIO_3GPP) ||
+             majorType.EqualsLiteral(VIDEO_3GPP)) &&
+            MediaEncoder::IsOMXEncoderEnabled()) {
           codecs = "amr"_ns;
         } else {
           codecs = "opus"_ns;
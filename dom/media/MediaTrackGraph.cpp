@@ -31,6 +31,9 @@
 #include "VideoFrameContainer.h"
 #include "mozilla/AbstractThread.h"
 #include "mozilla/StaticPrefs_dom.h"
+#include "mozilla/StaticPrefs_media.h"
+#include "mozilla/Services.h"
+#include "nsIObserverService.h"
 #include "mozilla/Unused.h"
 #include "transport/runnable_utils.h"
 #include "VideoUtils.h"
@@ -63,6 +66,43 @@ LazyLogModule gMediaTrackGraphLog("MediaTrackGraph");
  */
 static nsTHashMap<nsUint32HashKey, MediaTrackGraphImpl*> gGraphs;
 
+/**
+ * Whether the screen is off, read by graphs on their own threads.
+ */
+static Atomic<bool, Relaxed> sScreenOff(false);
+
+class ScreenStateObserver final : public nsIObserver {
+ public:
+  NS_DECL_ISUPPORTS
+
+  static void EnsureRegistered() {
+    MOZ_ASSERT(NS_IsMainThread());
+    static bool sRegistered = false;
+    if (sRegistered) {
+      return;
+    }
+    sRegistered = true;
+    if (nsCOMPtr<nsIObserverService> obs = services::GetObserverService()) {
+      // The parent forwards the notification to content processes.
+      obs->AddObserver(new ScreenStateObserver(), "screen-state-changed",
+                       false);
+    }
+  }
+
+  NS_IMETHOD Observe(nsISupports* aSubject, const char* aTopic,
+                     const char16_t* aData) override {
+    MOZ_ASSERT(!strcmp(aTopic, "screen-state-changed"));
+    sScreenOff = u"off"_ns.Equals(aData);
+    LOG(LogLevel::Debug, ("Screen is %s", sScreenOff ? "off" : "on"));
+    return NS_OK;
+  }
+
+ private:
+  ~ScreenStateObserver() = default;
+};
+
+NS_IMPL_ISUPPORTS(ScreenStateObserver, nsIObserver)
+
 MediaTrackGraphImpl::~MediaTrackGraphImpl() {
   MOZ_ASSERT(mTracks.IsEmpty() && mSuspendedTracks.IsEmpty(),
              "All tracks should have been destroyed by messages from the main "
@@ -323,12 +363,13 @@ void MediaTrackGraphImpl::CheckDriver() {
   }
 
   uint32_t graphOutputChannelCount = AudioOutputChannelCount();
+  bool lowPower = WantsLowPowerAudio();
   if (!audioCallbackDriver) {
     if (graphOutputChannelCount > 0) {
       AudioCallbackDriver* driver = new AudioCallbackDriver(
           this, CurrentDriver(), mSampleRate, graphOutputChannelCount,
           AudioInputChannelCount(), mOutputDeviceID, mInputDeviceID,
-          AudioInputDevicePreference());
+          AudioInputDevicePreference(), lowPower);
       SwitchAtNextIteration(driver);
     }
     return;
@@ -340,15 +381,30 @@ void MediaTrackGraphImpl::CheckDriver() {
   // directly playing back via another HTMLMediaElement, the number of channels
   // of the media determines how many channels to output, and it can change
   // dynamically.
-  if (graphOutputChannelCount != audioCallbackDriver->OutputChannelCount()) {
+  //
+  // Likewise, reopen the stream with the other buffer size when the screen
+  // turns on or off. The graph keeps running on the old stream until the new
+  // one has started.
+  if (graphOutputChannelCount != audioCallbackDriver->OutputChannelCount() ||
+      (lowPower != audioCallbackDriver->IsLowPower() &&
+       audioCallbackDriver->IsStarted())) {
+    LOG(LogLevel::Debug,
+        ("%p: Switching to a new AudioCallbackDriver, %u channels%s", this,
+         graphOutputChannelCount, lowPower ? ", low power" : ""));
     AudioCallbackDriver* driver = new AudioCallbackDriver(
         this, CurrentDriver(), mSampleRate, graphOutputChannelCount,
         AudioInputChannelCount(), mOutputDeviceID, mInputDeviceID,
-        AudioInputDevicePreference());
+        AudioInputDevicePreference(), lowPower);
     SwitchAtNextIteration(driver);
   }
 }
 
+bool MediaTrackGraphImpl::WantsLowPowerAudio() {
+  MOZ_ASSERT(OnGraphThread());
+  return StaticPrefs::media_audiograph_low_power_enabled() && sScreenOff &&
+         AudioInputChannelCount() == 0;
+}
+
 void MediaTrackGraphImpl::UpdateTrackOrder() {
   if (!mTrackOrderDirty) {
     return;
@@ -3173,6 +3229,8 @@ MediaTrackGraph* MediaTrackGraph::GetInstance(
       GetInstanceIfExists(aChannel, aWindow, sampleRate, aOutputDeviceID));
 
   if (!graph) {
+    ScreenStateObserver::EnsureRegistered();
+
     nsISerialEventTarget* mainThread;
     if (aWindow) {
       mainThread =
@@ -335,6 +335,12 @@ class MediaTrackGraphImpl : public MediaTrackGraph,
    */
   void CheckDriver();
 
+  /**
+   * True if this graph's AudioCallbackDriver should favour fewer wakeups over
+   * latency: the screen is off and there is no audio input. Graph thread only.
+   */
+  bool WantsLowPowerAudio();
+
   /**
    * Sort mTracks so that every track not in a cycle is after any tracks
    * it depends on, and every track in a cycle is marked as being in a cycle.
@@ -704,6 +704,13 @@ already_AddRefed<MediaEncoder> MediaEncoder::CreateEncoder(
                                                    FrameDroppingMode::DISALLOW);
       }
 #ifdef MOZ_WIDGET_GONK
+    } else if (codec.EqualsLiteral("avc1")) {
+      MOZ_ASSERT(!videoEncoder);
+      videoEncoder = MakeUnique<OmxVideoTrackEncoder>(
+          driftCompensator, aTrackRate, *encodedVideoQueue,
+          Preferences::GetBool("media.recorder.video.frame_drops", true)
+              ? FrameDroppingMode::ALLOW
+              : FrameDroppingMode::DISALLOW);
     } else if (codec.EqualsLiteral("amr")) {
       audioEncoder =
           MakeUnique<OmxAMRAudioTrackEncoder>(aTrackRate, *encodedAudioQueue);
@@ -727,7 +734,8 @@ already_AddRefed<MediaEncoder> MediaEncoder::CreateEncoder(
     MOZ_ASSERT(!videoEncoder);
     writer = MakeUnique<OggWriter>();
 #ifdef MOZ_WIDGET_GONK
-  } else if (mimeType->Type() == MEDIAMIMETYPE(AUDIO_3GPP)) {
+  } else if (mimeType->Type() == MEDIAMIMETYPE(AUDIO_3GPP) ||
+             mimeType->Type() == MEDIAMIMETYPE(VIDEO_3GPP)) {
     writer =
         MakeUnique<ISOMediaWriter>(aTrackTypes, ISOMediaWriter::TYPE_FRAG_3GP);
 #endif
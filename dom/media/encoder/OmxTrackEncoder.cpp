@@ -4,7 +4,11 @@
  * You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "OmxTrackEncoder.h"
+
+#include <algorithm>
+
 #include "OMXCodecWrapper.h"
+#include "VideoSegment.h"
 #include "VideoUtils.h"
 #include "ISOTrackMetadata.h"
 #include "GeckoProfiler.h"
@@ -25,6 +29,195 @@ namespace mozilla {
 
 #define ENCODER_CONFIG_FRAME_RATE 30            // fps
 #define GET_ENCODED_VIDEO_FRAME_TIMEOUT 100000  // microseconds
+#define MAX_EOS_TRIES 10
+
+OmxVideoTrackEncoder::OmxVideoTrackEncoder(
+    RefPtr<DriftCompensator> aDriftCompensator, TrackRate aTrackRate,
+    MediaQueue<EncodedFrame>& aEncodedDataQueue,
+    FrameDroppingMode aFrameDroppingMode)
+    : VideoTrackEncoder(std::move(aDriftCompensator), aTrackRate,
+                        aEncodedDataQueue, aFrameDroppingMode) {}
+
+OmxVideoTrackEncoder::~OmxVideoTrackEncoder() {
+  mEncoder = nullptr;
+  if (mReservation) {
+    mReservation->ReleaseOMXCodec();
+  }
+}
+
+nsresult OmxVideoTrackEncoder::Init(int32_t aWidth, int32_t aHeight,
+                                    int32_t aDisplayWidth,
+                                    int32_t aDisplayHeight,
+                                    float aEstimatedFrameRate) {
+  if (aWidth < 1 || aHeight < 1 || aDisplayWidth < 1 || aDisplayHeight < 1) {
+    return NS_ERROR_FAILURE;
+  }
+
+  // The codec is shared with WebRTC and the camera app; don't take it from
+  // under them.
+  mReservation = new OMXCodecReservation(true);
+  if (!mReservation->ReserveOMXCodec()) {
+    OMX_LOG("video encoder in use");
+    mReservation = nullptr;
+    return NS_ERROR_FAILURE;
+  }
+
+  mEncoder.reset(OMXCodecWrapper::CreateAVCEncoder());
+  NS_ENSURE_TRUE(mEncoder, NS_ERROR_FAILURE);
+
+  int frameRate = aEstimatedFrameRate > 0
+                      ? std::max(1, int(aEstimatedFrameRate + 0.5f))
+                      : ENCODER_CONFIG_FRAME_RATE;
+  // AVC_MP4 gives us the avcC box as codec specific data and length prefixed
+  // NALUs, which is what the ISO muxer writes.
+  nsresult rv = mEncoder->Configure(aWidth, aHeight, frameRate,
+                                    OMXVideoEncoder::BlobFormat::AVC_MP4);
+  NS_ENSURE_SUCCESS(rv, rv);
+  if (mVideoBitrate) {
+    mEncoder->SetBitrate(mVideoBitrate / 1000);
+  }
+
+  mFrameWidth = aWidth;
+  mFrameHeight = aHeight;
+
+  mMeta = new AVCTrackMetadata();
+  mMeta->mWidth = aWidth;
+  mMeta->mHeight = aHeight;
+  mMeta->mDisplayWidth = aDisplayWidth;
+  mMeta->mDisplayHeight = aDisplayHeight;
+  mMeta->mFrameRate = frameRate;
+
+  OMX_LOG("video %dx%d @ %d fps, %u bps", aWidth, aHeight, frameRate,
+          mVideoBitrate);
+  SetInitialized();
+  return NS_OK;
+}
+
+already_AddRefed<TrackMetadataBase> OmxVideoTrackEncoder::GetMetadata() {
+  AUTO_PROFILER_LABEL("OmxVideoTrackEncoder::GetMetadata", OTHER);
+
+  if (!mInitialized) {
+    return nullptr;
+  }
+
+  RefPtr<AVCTrackMetadata> meta = mMeta;
+  return meta.forget();
+}
+
+nsresult OmxVideoTrackEncoder::Encode(VideoSegment* aSegment) {
+  MOZ_ASSERT(mInitialized);
+  MOZ_ASSERT(!IsEncodingComplete());
+
+  AUTO_PROFILER_LABEL("OmxVideoTrackEncoder::Encode", OTHER);
+
+  nsresult rv;
+  for (VideoSegment::ChunkIterator iter(*aSegment); !iter.IsEnded();
+       iter.Next()) {
+    VideoChunk& chunk = *iter;
+
+    // A null image makes the codec wrapper write a black frame.
+    layers::Image* img = nullptr;
+    if (!chunk.IsNull() && !chunk.mFrame.GetForceBlack()) {
+      img = chunk.mFrame.GetImage();
+    }
+
+    int64_t timeUs =
+        FramesToTimeUnit(mEncodedTimestamp, mTrackRate).ToMicroseconds();
+    mEncodedTimestamp += chunk.GetDuration();
+    mLastFrameDurationUs =
+        FramesToTimeUnit(mEncodedTimestamp, mTrackRate).ToMicroseconds() -
+        timeUs;
+
+    if (img && img->GetSize() != gfx::IntSize(mFrameWidth, mFrameHeight)) {
+      // The codec can't be reconfigured mid-stream without breaking the
+      // avcC already written to the moov. The previous frame lasts longer
+      // instead.
+      OMX_LOG("dropping %dx%d frame", img->GetSize().width,
+              img->GetSize().height);
+      continue;
+    }
+
+    rv = mEncoder->Encode(img, mFrameWidth, mFrameHeight, timeUs);
+    NS_ENSURE_SUCCESS(rv, rv);
+    mLastImage = img;
+
+    rv = AppendEncodedFrames(0);
+    NS_ENSURE_SUCCESS(rv, rv);
+  }
+
+  // Remove the chunks we have processed.
+  aSegment->Clear();
+
+  if (mEndOfStream) {
+    // The codec takes end of stream with a frame; repeat the last one rather
+    // than ending on a black frame.
+    int64_t timeUs =
+        FramesToTimeUnit(mEncodedTimestamp, mTrackRate).ToMicroseconds();
+    bool sentEOS = false;
+    for (int i = 0; !sentEOS && i < MAX_EOS_TRIES; i++) {
+      // The input queue may be full; the codec frees input buffers as we take
+      // its output.
+      rv = mEncoder->Encode(mLastImage, mFrameWidth, mFrameHeight, timeUs,
+                            OMXCodecWrapper::BUFFER_EOS, &sentEOS);
+      NS_ENSURE_SUCCESS(rv, rv);
+      rv = AppendEncodedFrames(GET_ENCODED_VIDEO_FRAME_TIMEOUT);
+      NS_ENSURE_SUCCESS(rv, rv);
+    }
+    // Some codecs never return the EOS flag; stop once nothing comes out.
+    size_t queued;
+    do {
+      queued = mEncodedDataQueue.GetSize();
+      rv = AppendEncodedFrames(GET_ENCODED_VIDEO_FRAME_TIMEOUT);
+      NS_ENSURE_SUCCESS(rv, rv);
+    } while (!mEOSReceived && mEncodedDataQueue.GetSize() > queued);
+
+    mLastImage = nullptr;
+    mEncoder = nullptr;
+    mReservation->ReleaseOMXCodec();
+    mReservation = nullptr;
+    mEncodedDataQueue.Finish();
+  }
+
+  return NS_OK;
+}
+
+nsresult OmxVideoTrackEncoder::AppendEncodedFrames(int64_t aTimeoutUs) {
+  nsTArray<uint8_t> buffer;
+  while (!mEOSReceived) {
+    int outFlags = 0;
+    int64_t outTimeUs = -1;
+    buffer.Clear();
+    nsresult rv = mEncoder->GetNextEncodedFrame(&buffer, &outTimeUs,
+                                                &outFlags, aTimeoutUs);
+    NS_ENSURE_SUCCESS(rv, rv);
+    // Only wait for the first frame.
+    aTimeoutUs = 0;
+
+    if (outFlags & OMXCodecWrapper::BUFFER_EOS) {
+      mEOSReceived = true;
+    }
+    if (buffer.IsEmpty()) {
+      // Nothing ready, or an empty EOS buffer.
+      break;
+    }
+
+    EncodedFrame::FrameType type = EncodedFrame::AVC_P_FRAME;
+    if (outFlags & OMXCodecWrapper::BUFFER_CODEC_CONFIG) {
+      type = EncodedFrame::AVC_CSD;
+    } else if (outFlags & OMXCodecWrapper::BUFFER_SYNC_FRAME) {
+      type = EncodedFrame::AVC_I_FRAME;
+    }
+
+    auto frameData = MakeRefPtr<EncodedFrame::FrameData>();
+    frameData->SwapElements(buffer);
+    mEncodedDataQueue.Push(MakeAndAddRef<EncodedFrame>(
+        media::TimeUnit::FromMicroseconds(outTimeUs),
+        type == EncodedFrame::AVC_CSD ? 0 : mLastFrameDurationUs,
+        PR_USEC_PER_SEC, type, std::move(frameData)));
+  }
+
+  return NS_OK;
+}
 
 OmxAudioTrackEncoder::OmxAudioTrackEncoder(
     TrackRate aTrackRate, MediaQueue<EncodedFrame>& aEncodedDataQueue)
@@ -6,9 +6,13 @@
 #ifndef OmxTrackEncoder_h_
 #define OmxTrackEncoder_h_
 
+#include <utils/RefBase.h>
+
 #include "TrackEncoder.h"
+#include "mozilla/UniquePtr.h"
 
 namespace android {
+class OMXCodecReservation;
 class OMXVideoEncoder;
 class OMXAudioEncoder;
 }  // namespace android
@@ -23,6 +27,51 @@ class OMXAudioEncoder;
 
 namespace mozilla {
 
+class AVCTrackMetadata;
+
+class OmxVideoTrackEncoder final : public VideoTrackEncoder {
+ public:
+  OmxVideoTrackEncoder(RefPtr<DriftCompensator> aDriftCompensator,
+                       TrackRate aTrackRate,
+                       MediaQueue<EncodedFrame>& aEncodedDataQueue,
+                       FrameDroppingMode aFrameDroppingMode);
+  ~OmxVideoTrackEncoder();
+
+  already_AddRefed<TrackMetadataBase> GetMetadata() override;
+
+ protected:
+  nsresult Init(int32_t aWidth, int32_t aHeight, int32_t aDisplayWidth,
+                int32_t aDisplayHeight, float aEstimatedFrameRate) override;
+
+  // Hands the frames of aSegment to the codec as they are (gralloc-ed camera
+  // buffers are not mapped here) and pushes what it has finished to
+  // mEncodedDataQueue.
+  nsresult Encode(VideoSegment* aSegment) override;
+
+ private:
+  // Moves the frames the codec has finished to mEncodedDataQueue. Waits up to
+  // aTimeoutUs for the first one.
+  nsresult AppendEncodedFrames(int64_t aTimeoutUs);
+
+  android::sp<android::OMXCodecReservation> mReservation;
+  UniquePtr<android::OMXVideoEncoder> mEncoder;
+  RefPtr<AVCTrackMetadata> mMeta;
+  // The last frame given to the codec, sent again with end of stream.
+  RefPtr<layers::Image> mLastImage;
+
+  // The size the codec is configured with.
+  int32_t mFrameWidth = 0;
+  int32_t mFrameHeight = 0;
+
+  // Start time of the next frame, in mTrackRate.
+  TrackTime mEncodedTimestamp = 0;
+  // Duration of the frame most recently given to the codec, in microseconds.
+  int64_t mLastFrameDurationUs = 0;
+
+  // True once the codec has returned its last frame.
+  bool mEOSReceived = false;
+};
+
 class OmxAudioTrackEncoder : public AudioTrackEncoder {
  public:
   OmxAudioTrackEncoder(TrackRate aRate,
@@ -8,6 +8,7 @@
 
 #include "GonkOffloadPlayer.h"
 #include "MediaTrackGraph.h"
+#include "mozilla/Telemetry.h"
 
 namespace mozilla {
 
@@ -119,6 +120,17 @@ RefPtr<ShutdownPromise> MediaOffloadPlayer::Shutdown() {
   mDormantTimer.Reset();
   ResetInternal();
 
+  // Playback time the application processor could spend asleep, since
+  // decoding and mixing happened on the DSP.
+  if (!mPlayingStartTime.IsNull()) {
+    mPlayingTime += TimeStamp::Now() - mPlayingStartTime;
+    mPlayingStartTime = TimeStamp();
+  }
+  if (mPlayingTime > TimeDuration()) {
+    Telemetry::Accumulate(Telemetry::MEDIA_OFFLOAD_PLAYER_PLAYBACK_TIME_S,
+                          uint32_t(mPlayingTime.ToSeconds()));
+  }
+
   // Disconnect canonicals and mirrors before shutting down our task queue.
   mPlayState.DisconnectIfConnected();
   mVolume.DisconnectIfConnected();
@@ -332,6 +344,15 @@ void MediaOffloadPlayer::ExitDormant() {
 void MediaOffloadPlayer::PlayStateChanged() {
   MOZ_ASSERT(OnTaskQueue());
   LOG("MediaOffloadPlayer::PlayStateChanged, %d", mPlayState.Ref());
+  if (mPlayState == MediaDecoder::PLAY_STATE_PLAYING) {
+    if (mPlayingStartTime.IsNull()) {
+      mPlayingStartTime = TimeStamp::Now();
+    }
+  } else if (!mPlayingStartTime.IsNull()) {
+    mPlayingTime += TimeStamp::Now() - mPlayingStartTime;
+    mPlayingStartTime = TimeStamp();
+  }
+
   if (mPlayState == MediaDecoder::PLAY_STATE_PAUSED) {
     StartDormantTimer();
   } else if (mPlayState == MediaDecoder::PLAY_STATE_PLAYING) {
@@ -339,6 +360,17 @@ void MediaOffloadPlayer::PlayStateChanged() {
   }
 }
 
+void MediaOffloadPlayer::UpdateOutputCaptureState() {
+  MOZ_ASSERT(OnTaskQueue());
+  // Offloading is only chosen for elements that aren't captured, but a page
+  // may still capture one later. We can't switch decoders mid-stream, so
+  // say why the graph stays silent.
+  if (mOutputCaptureState == MediaDecoder::OutputCaptureState::Capture) {
+    NS_WARNING("MediaOffloadPlayer cannot provide captured output");
+    LOG("MediaOffloadPlayer::UpdateOutputCaptureState, capture unsupported");
+  }
+}
+
 void MediaOffloadPlayer::NotifyMediaNotSeekable() {
   LOG("MediaOffloadPlayer::NotifyMediaNotSeekable");
   mOnMediaNotSeekable.Notify();
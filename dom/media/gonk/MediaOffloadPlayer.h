@@ -131,6 +131,9 @@ class MediaOffloadPlayer : public DecoderDoctorLifeLogger<MediaOffloadPlayer> {
   SeekObject mCurrentSeek;
   SeekObject mPendingSeek;
   bool mInDormant = false;
+  // Time spent in the playing state, for telemetry.
+  TimeStamp mPlayingStartTime;
+  TimeDuration mPlayingTime;
 
  protected:
   MediaOffloadPlayer(MediaFormatReaderInit& aInit);
@@ -202,7 +205,7 @@ class MediaOffloadPlayer : public DecoderDoctorLifeLogger<MediaOffloadPlayer> {
   virtual void PreservesPitchChanged() {}
   virtual void LoopingChanged() {}
   virtual void UpdateSecondaryVideoContainer() {}
-  virtual void UpdateOutputCaptureState() {}
+  virtual void UpdateOutputCaptureState();
   virtual void OutputTracksChanged() {}
   virtual void OutputPrincipalChanged() {}
   virtual void PlaybackRateChanged() {}
@@ -18,6 +18,10 @@
 #  include "WMFEncoderModule.h"
 #endif
 
+#ifdef MOZ_WIDGET_GONK
+#  include "GonkEncoderModule.h"
+#endif
+
 namespace mozilla {
 
 LazyLogModule sPEMLog("PlatformEncoderModule");
@@ -35,6 +39,10 @@ PEMFactory::PEMFactory() {
 #ifdef XP_WIN
   mModules.AppendElement(new WMFEncoderModule());
 #endif
+
+#ifdef MOZ_WIDGET_GONK
+  mModules.AppendElement(new GonkEncoderModule());
+#endif
 }
 
 bool PEMFactory::SupportsMimeType(const nsACString& aMimeType) const {
@@ -0,0 +1,319 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "GonkDataEncoder.h"
+
+#include <algorithm>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/MediaDefs.h>
+#include <OMX_Component.h>
+
+#include "ImageContainer.h"
+#include "MediaInfo.h"
+#include "OMXCodecWrapper.h"
+
+#include "mozilla/Logging.h"
+
+namespace mozilla {
+
+extern LazyLogModule sPEMLog;
+#define GONK_ENC_LOG(arg, ...)               \
+  MOZ_LOG(sPEMLog, mozilla::LogLevel::Debug, \
+          ("GonkDataEncoder(%p)::%s: " arg, this, __func__, ##__VA_ARGS__))
+#define GONK_ENC_LOGE(arg, ...)              \
+  MOZ_LOG(sPEMLog, mozilla::LogLevel::Error, \
+          ("GonkDataEncoder(%p)::%s: " arg, this, __func__, ##__VA_ARGS__))
+
+using android::OMXCodecReservation;
+using android::OMXCodecWrapper;
+using android::OMXVideoEncoder;
+using android::sp;
+
+// How long Drain() waits for each frame still in the codec.
+#define DRAIN_OUTPUT_TIMEOUT_US 100000
+// Per Encode(), bounds the number of frames taken from the codec so that a
+// misbehaving codec can't keep us looping.
+#define MAX_OUTPUT_FRAMES_PER_POLL 8
+
+static const uint8_t kNALStartCode[] = {0x00, 0x00, 0x00, 0x01};
+static const uint8_t kNALTypeSPS = 7;
+
+GonkDataEncoder::GonkDataEncoder(const Config& aConfig,
+                                 RefPtr<TaskQueue> aTaskQueue)
+    : mConfig(aConfig), mTaskQueue(aTaskQueue), mSentFirstFrame(false) {
+  MOZ_ASSERT(mConfig.mSize.width > 0 && mConfig.mSize.height > 0);
+  MOZ_ASSERT(mTaskQueue);
+}
+
+GonkDataEncoder::~GonkDataEncoder() { MOZ_ASSERT(!mEncoder); }
+
+RefPtr<MediaDataEncoder::InitPromise> GonkDataEncoder::Init() {
+  if (mConfig.mSize.width == 0 || mConfig.mSize.height == 0 ||
+      mConfig.mFramerate == 0) {
+    return InitPromise::CreateAndReject(NS_ERROR_ILLEGAL_VALUE, __func__);
+  }
+
+  return InvokeAsync(mTaskQueue, this, __func__,
+                     &GonkDataEncoder::ProcessInit);
+}
+
+static sp<android::AMessage> ToOMXFormat(
+    const GonkDataEncoder::Config& aConfig) {
+  // Without codec specific data, ask for a key frame every few seconds like
+  // the WebRTC OMX encoder does.
+  int32_t intervalInSec = 4;
+  OMX_VIDEO_AVCPROFILETYPE profile = OMX_VIDEO_AVCProfileBaseline;
+  if (aConfig.mCodecSpecific) {
+    intervalInSec = std::max<size_t>(
+        1, aConfig.mCodecSpecific.value().mKeyframeInterval /
+               aConfig.mFramerate);
+    if (aConfig.mCodecSpecific.value().mProfileLevel ==
+        MediaDataEncoder::H264Specific::ProfileLevel::MainAutoLevel) {
+      profile = OMX_VIDEO_AVCProfileMain;
+    }
+  }
+
+  sp<android::AMessage> format = new android::AMessage;
+  format->setString("mime", android::MEDIA_MIMETYPE_VIDEO_AVC);
+  format->setInt32("bitrate", aConfig.mBitsPerSec);
+  format->setInt32("bitrate-mode", OMX_Video_ControlRateConstant);
+  format->setInt32("i-frame-interval", intervalInSec);
+  // OMXVideoEncoder::Encode() writes every kind of image it takes as NV12.
+  format->setInt32("color-format", OMX_COLOR_FormatYUV420SemiPlanar);
+  format->setInt32("profile", profile);
+  format->setInt32("level", OMX_VIDEO_AVCLevel3);
+  format->setInt32("store-metadata-in-buffers", 0);
+  // We put them in front of key frames ourselves, not all codecs do it.
+  format->setInt32("prepend-sps-pps-to-idr-frames", 0);
+  format->setInt32("width", aConfig.mSize.width);
+  format->setInt32("height", aConfig.mSize.height);
+  format->setInt32("stride", aConfig.mSize.width);
+  format->setInt32("slice-height", aConfig.mSize.height);
+  format->setInt32("frame-rate", aConfig.mFramerate);
+  return format;
+}
+
+RefPtr<MediaDataEncoder::InitPromise> GonkDataEncoder::ProcessInit() {
+  AssertOnTaskQueue();
+  MOZ_ASSERT(!mEncoder);
+
+  mReservation = new OMXCodecReservation(true);
+  if (!mReservation->ReserveOMXCodec()) {
+    mReservation = nullptr;
+    return InitPromise::CreateAndReject(
+        MediaResult(NS_ERROR_DOM_MEDIA_FATAL_ERR, "video encoder in use"),
+        __func__);
+  }
+
+  UniquePtr<OMXVideoEncoder> encoder(OMXCodecWrapper::CreateAVCEncoder());
+  if (!encoder) {
+    ProcessShutdown();
+    return InitPromise::CreateAndReject(
+        MediaResult(NS_ERROR_DOM_MEDIA_FATAL_ERR, "cannot create OMX encoder"),
+        __func__);
+  }
+
+  sp<android::AMessage> format = ToOMXFormat(mConfig);
+  nsresult rv = encoder->ConfigureDirect(
+      format, mConfig.mUsage == Usage::Realtime
+                  ? OMXVideoEncoder::BlobFormat::AVC_NAL
+                  : OMXVideoEncoder::BlobFormat::AVC_MP4);
+  if (NS_FAILED(rv)) {
+    ProcessShutdown();
+    return InitPromise::CreateAndReject(
+        MediaResult(NS_ERROR_DOM_MEDIA_FATAL_ERR,
+                    "cannot configure OMX encoder"),
+        __func__);
+  }
+  mEncoder = std::move(encoder);
+
+  GONK_ENC_LOG("configured %dx%d @ %u fps, %u bps, %s", mConfig.mSize.width,
+               mConfig.mSize.height, mConfig.mFramerate, mConfig.mBitsPerSec,
+               mConfig.mUsage == Usage::Realtime ? "realtime" : "record");
+  return InitPromise::CreateAndResolve(TrackInfo::kVideoTrack, __func__);
+}
+
+RefPtr<MediaDataEncoder::EncodePromise> GonkDataEncoder::Encode(
+    const MediaData* aSample) {
+  RefPtr<GonkDataEncoder> self = this;
+  MOZ_ASSERT(aSample != nullptr);
+
+  RefPtr<const MediaData> sample(aSample);
+  return InvokeAsync(mTaskQueue, __func__, [self, sample]() {
+    return self->ProcessEncode(std::move(sample));
+  });
+}
+
+RefPtr<MediaDataEncoder::EncodePromise> GonkDataEncoder::ProcessEncode(
+    RefPtr<const MediaData> aSample) {
+  AssertOnTaskQueue();
+
+  if (!mEncoder) {
+    return EncodePromise::CreateAndReject(NS_ERROR_DOM_MEDIA_CANCELED,
+                                          __func__);
+  }
+
+  RefPtr<const VideoData> sample(aSample->As<const VideoData>());
+  MOZ_ASSERT(sample);
+
+  // The codec starts with a key frame by itself.
+  if (sample->mKeyframe && mSentFirstFrame) {
+    mEncoder->RequestIDRFrame();
+  }
+  mSentFirstFrame = true;
+
+  // Gralloc-ed images go to the codec without being mapped here; see
+  // OMXVideoEncoder::Encode().
+  nsresult rv =
+      mEncoder->Encode(sample->mImage, mConfig.mSize.width,
+                       mConfig.mSize.height, sample->mTime.ToMicroseconds(), 0);
+  if (NS_FAILED(rv)) {
+    GONK_ENC_LOGE("fail to queue input, rv=0x%08" PRIx32, uint32_t(rv));
+    return EncodePromise::CreateAndReject(NS_ERROR_ILLEGAL_INPUT, __func__);
+  }
+
+  rv = DrainOutput(0);
+  if (NS_FAILED(rv)) {
+    return EncodePromise::CreateAndReject(
+        MediaResult(NS_ERROR_DOM_MEDIA_FATAL_ERR, "fail to get output"),
+        __func__);
+  }
+
+  EncodedData pending = std::move(mEncodedData);
+  return EncodePromise::CreateAndResolve(std::move(pending), __func__);
+}
+
+nsresult GonkDataEncoder::DrainOutput(int64_t aTimeoutUs) {
+  AssertOnTaskQueue();
+
+  nsTArray<uint8_t> buffer;
+  for (int i = 0; i < MAX_OUTPUT_FRAMES_PER_POLL; i++) {
+    int64_t timeUs = 0;
+    int flags = 0;
+    buffer.Clear();
+    nsresult rv = mEncoder->GetNextEncodedFrame(&buffer, &timeUs, &flags,
+                                                i == 0 ? aTimeoutUs : 0);
+    NS_ENSURE_SUCCESS(rv, rv);
+    if (buffer.IsEmpty()) {
+      break;
+    }
+
+    if (flags & OMXCodecWrapper::BUFFER_CODEC_CONFIG) {
+      mConfigData = MakeRefPtr<MediaByteBuffer>(buffer.Length());
+      mConfigData->AppendElements(buffer);
+      continue;
+    }
+
+    RefPtr<MediaRawData> output = GetOutputData(
+        buffer, !!(flags & OMXCodecWrapper::BUFFER_SYNC_FRAME));
+    if (!output) {
+      return NS_ERROR_OUT_OF_MEMORY;
+    }
+    output->mTime = media::TimeUnit::FromMicroseconds(timeUs);
+    mEncodedData.AppendElement(std::move(output));
+  }
+  return NS_OK;
+}
+
+static bool StartsWithSPS(const nsTArray<uint8_t>& aBuffer) {
+  return aBuffer.Length() > sizeof(kNALStartCode) &&
+         !memcmp(aBuffer.Elements(), kNALStartCode, sizeof(kNALStartCode)) &&
+         (aBuffer[sizeof(kNALStartCode)] & 0x1f) == kNALTypeSPS;
+}
+
+RefPtr<MediaRawData> GonkDataEncoder::GetOutputData(nsTArray<uint8_t>& aBuffer,
+                                                    const bool aIsKeyFrame) {
+  auto output = MakeRefPtr<MediaRawData>();
+
+  size_t prependSize = 0;
+  if (aIsKeyFrame && mConfigData) {
+    if (mConfig.mUsage == Usage::Realtime) {
+      // Some codecs prepend the parameter sets anyway.
+      if (!StartsWithSPS(aBuffer)) {
+        prependSize = mConfigData->Length();
+      }
+    } else {
+      // OMXVideoEncoder already wrote the sample as AVCC.
+      output->mExtraData = mConfigData;
+    }
+  }
+
+  UniquePtr<MediaRawDataWriter> writer(output->CreateWriter());
+  if (!writer->SetSize(prependSize + aBuffer.Length())) {
+    GONK_ENC_LOGE("fail to allocate output buffer");
+    return nullptr;
+  }
+
+  if (prependSize > 0) {
+    PodCopy(writer->Data(), mConfigData->Elements(), prependSize);
+  }
+  PodCopy(writer->Data() + prependSize, aBuffer.Elements(), aBuffer.Length());
+
+  output->mKeyframe = aIsKeyFrame;
+
+  return output;
+}
+
+RefPtr<MediaDataEncoder::EncodePromise> GonkDataEncoder::Drain() {
+  return InvokeAsync(mTaskQueue, this, __func__,
+                     &GonkDataEncoder::ProcessDrain);
+}
+
+RefPtr<MediaDataEncoder::EncodePromise> GonkDataEncoder::ProcessDrain() {
+  AssertOnTaskQueue();
+
+  if (!mEncoder) {
+    return EncodePromise::CreateAndResolve(EncodedData(), __func__);
+  }
+
+  // Rather than ending the stream, which would need a frame to carry the EOS
+  // flag, wait for what's left in the codec. Once a wait times out with
+  // nothing, the next Drain() resolves empty and the client stops.
+  nsresult rv = DrainOutput(DRAIN_OUTPUT_TIMEOUT_US);
+  if (NS_FAILED(rv)) {
+    return EncodePromise::CreateAndReject(
+        MediaResult(NS_ERROR_DOM_MEDIA_FATAL_ERR, "fail to drain"), __func__);
+  }
+
+  EncodedData pending = std::move(mEncodedData);
+  return EncodePromise::CreateAndResolve(std::move(pending), __func__);
+}
+
+RefPtr<ShutdownPromise> GonkDataEncoder::Shutdown() {
+  return InvokeAsync(mTaskQueue, this, __func__,
+                     &GonkDataEncoder::ProcessShutdown);
+}
+
+RefPtr<ShutdownPromise> GonkDataEncoder::ProcessShutdown() {
+  AssertOnTaskQueue();
+
+  mEncoder = nullptr;
+  if (mReservation) {
+    mReservation->ReleaseOMXCodec();
+    mReservation = nullptr;
+  }
+  mEncodedData.Clear();
+  mConfigData = nullptr;
+
+  return ShutdownPromise::CreateAndResolve(true, __func__);
+}
+
+RefPtr<GenericPromise> GonkDataEncoder::SetBitrate(
+    const MediaDataEncoder::Rate aBitsPerSec) {
+  RefPtr<GonkDataEncoder> self(this);
+  return InvokeAsync(mTaskQueue, __func__, [self, aBitsPerSec]() {
+    if (!self->mEncoder ||
+        NS_FAILED(self->mEncoder->SetBitrate(aBitsPerSec / 1000))) {
+      return GenericPromise::CreateAndReject(NS_ERROR_FAILURE, __func__);
+    }
+    return GenericPromise::CreateAndResolve(true, __func__);
+  });
+}
+
+}  // namespace mozilla
+
+#undef GONK_ENC_LOG
+#undef GONK_ENC_LOGE
@@ -0,0 +1,87 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef DOM_MEDIA_PLATFORMS_GONK_GONKDATAENCODER_H_
+#define DOM_MEDIA_PLATFORMS_GONK_GONKDATAENCODER_H_
+
+#include <utils/RefBase.h>
+
+#include "MediaData.h"
+#include "PlatformEncoderModule.h"
+
+#include "mozilla/UniquePtr.h"
+
+namespace android {
+class OMXCodecReservation;
+class OMXVideoEncoder;
+}  // namespace android
+
+namespace mozilla {
+
+/**
+ * MediaDataEncoder over the OMX AVC/H.264 encoder wrapped by
+ * android::OMXVideoEncoder. Gralloc-ed images (camera preview buffers and
+ * decoded gralloc frames) are handed to the codec as they are, so the only
+ * pass over the pixels is the copy into the codec's input buffer; other
+ * PlanarYCbCr images are converted to NV12 in the same pass.
+ *
+ * Output is Annex B with SPS/PPS in front of every key frame for realtime
+ * usage, and AVCC with the avcC box as extra data on key frames otherwise.
+ */
+class GonkDataEncoder final : public MediaDataEncoder {
+ public:
+  using Config = H264Config;
+
+  GonkDataEncoder(const Config& aConfig, RefPtr<TaskQueue> aTaskQueue);
+
+  RefPtr<InitPromise> Init() override;
+  RefPtr<EncodePromise> Encode(const MediaData* aSample) override;
+  RefPtr<EncodePromise> Drain() override;
+  RefPtr<ShutdownPromise> Shutdown() override;
+  RefPtr<GenericPromise> SetBitrate(const Rate aBitsPerSec) override;
+
+  bool IsHardwareAccelerated(nsACString& aFailureReason) const override {
+    return true;
+  }
+
+  nsCString GetDescriptionName() const override {
+    return "Gonk OMX Encoder"_ns;
+  }
+
+ private:
+  ~GonkDataEncoder();
+
+  // Methods only called on mTaskQueue.
+  RefPtr<InitPromise> ProcessInit();
+  RefPtr<EncodePromise> ProcessEncode(RefPtr<const MediaData> aSample);
+  RefPtr<EncodePromise> ProcessDrain();
+  RefPtr<ShutdownPromise> ProcessShutdown();
+  // Moves the frames the codec has finished into mEncodedData, waiting up to
+  // aTimeoutUs for the first one.
+  nsresult DrainOutput(int64_t aTimeoutUs);
+  RefPtr<MediaRawData> GetOutputData(nsTArray<uint8_t>& aBuffer,
+                                     const bool aIsKeyFrame);
+
+  void AssertOnTaskQueue() const {
+    MOZ_ASSERT(mTaskQueue->IsCurrentThreadIn());
+  }
+
+  Config mConfig;
+
+  RefPtr<TaskQueue> mTaskQueue;
+
+  // Accessed on mTaskQueue only.
+  android::sp<android::OMXCodecReservation> mReservation;
+  UniquePtr<android::OMXVideoEncoder> mEncoder;
+  EncodedData mEncodedData;
+  // SPS/PPS NALUs for realtime usage, avcC otherwise.
+  RefPtr<MediaByteBuffer> mConfigData;
+  bool mSentFirstFrame;
+};
+
+}  // namespace mozilla
+
+#endif
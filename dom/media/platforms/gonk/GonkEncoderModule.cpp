@@ -0,0 +1,26 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "GonkEncoderModule.h"
+
+#include "GonkDataEncoder.h"
+#include "MP4Decoder.h"
+
+namespace mozilla {
+
+bool GonkEncoderModule::SupportsMimeType(const nsACString& aMimeType) const {
+  // OMXCodecWrapper only wraps the AVC/H.264 video encoder.
+  return MP4Decoder::IsH264(aMimeType);
+}
+
+already_AddRefed<MediaDataEncoder> GonkEncoderModule::CreateVideoEncoder(
+    const CreateEncoderParams& aParams) const {
+  RefPtr<MediaDataEncoder> encoder =
+      new GonkDataEncoder(aParams.ToH264Config(), aParams.mTaskQueue);
+  return encoder.forget();
+}
+
+}  // namespace mozilla
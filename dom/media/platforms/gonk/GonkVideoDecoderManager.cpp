@@ -23,8 +23,14 @@
 #include "mozilla/layers/ImageBridgeChild.h"
 #include "mozilla/layers/TextureClient.h"
 #include "mozilla/layers/TextureClientRecycleAllocator.h"
+#include "mozilla/GonkColorConvert.h"
+#include "mozilla/Services.h"
+#include "mozilla/StaticMutex.h"
 #include "mozilla/StaticPrefs_media.h"
+#include "mozilla/StaticPtr.h"
 #include "mozilla/ScopeExit.h"
+#include "nsIObserver.h"
+#include "nsIObserverService.h"
 
 #define CODECCONFIG_TIMEOUT_US 40000LL
 #define READ_OUTPUT_BUFFER_TIMEOUT_US 0LL
@@ -101,10 +107,145 @@ class GonkTextureClientAllocationHelper
   uint32_t mGrallocFormat;
 };
 
+// Gralloc buffers for decoded frames that have to be copied out of the codec's
+// own buffers, shared by all the video decoders of the process. Seeking, a
+// resolution change or a new element would otherwise each allocate a fresh set
+// with a new decoder, so the allocators are kept by format and size, for the
+// last few of those. Under memory pressure the unused buffers are freed and
+// the pool forgets its allocators; decoders keep the ones they hold.
+class GonkVideoBufferPool final : public nsIObserver {
+ public:
+  NS_DECL_THREADSAFE_ISUPPORTS
+  NS_DECL_NSIOBSERVER
+
+  // Any thread.
+  static already_AddRefed<TextureClientRecycleAllocator> GetAllocator(
+      uint32_t aGrallocFormat, const gfx::IntSize& aSize);
+
+ private:
+  GonkVideoBufferPool() = default;
+  ~GonkVideoBufferPool() = default;
+
+  void RegisterObservers();
+  static void Clear();
+
+  struct Entry {
+    uint32_t mGrallocFormat;
+    gfx::IntSize mSize;
+    RefPtr<TextureClientRecycleAllocator> mAllocator;
+  };
+
+  // A few sizes in use at once: a video and its previews, or the sizes on
+  // both sides of a resolution change.
+  static const size_t kMaxEntries = 3;
+  static const uint32_t kMaxPooledBuffers = 3;
+
+  static StaticMutex sMutex;
+  static StaticRefPtr<GonkVideoBufferPool> sInstance;
+  // Most recently used last.
+  static StaticAutoPtr<nsTArray<Entry>> sEntries;
+};
+
+StaticMutex GonkVideoBufferPool::sMutex;
+StaticRefPtr<GonkVideoBufferPool> GonkVideoBufferPool::sInstance;
+StaticAutoPtr<nsTArray<GonkVideoBufferPool::Entry>>
+    GonkVideoBufferPool::sEntries;
+
+NS_IMPL_ISUPPORTS(GonkVideoBufferPool, nsIObserver)
+
+/* static */
+already_AddRefed<TextureClientRecycleAllocator>
+GonkVideoBufferPool::GetAllocator(uint32_t aGrallocFormat,
+                                  const gfx::IntSize& aSize) {
+  RefPtr<ImageBridgeChild> imageBridge = ImageBridgeChild::GetSingleton();
+  if (!imageBridge) {
+    return nullptr;
+  }
+
+  StaticMutexAutoLock lock(sMutex);
+  if (!sInstance) {
+    sInstance = new GonkVideoBufferPool();
+    sEntries = new nsTArray<Entry>();
+    RefPtr<GonkVideoBufferPool> pool = sInstance.get();
+    NS_DispatchToMainThread(
+        NS_NewRunnableFunction("GonkVideoBufferPool::RegisterObservers",
+                               [pool]() { pool->RegisterObservers(); }));
+  }
+
+  for (size_t i = 0; i < sEntries->Length(); i++) {
+    Entry& entry = (*sEntries)[i];
+    if (entry.mGrallocFormat != aGrallocFormat || entry.mSize != aSize) {
+      continue;
+    }
+    RefPtr<TextureClientRecycleAllocator> allocator = entry.mAllocator;
+    sEntries->RemoveElementAt(i);
+    // An allocator for an image bridge that went away is of no use.
+    if (allocator->GetKnowsCompositor() == imageBridge) {
+      sEntries->AppendElement(Entry{aGrallocFormat, aSize, allocator});
+      return allocator.forget();
+    }
+    break;
+  }
+
+  if (sEntries->Length() == kMaxEntries) {
+    (*sEntries)[0].mAllocator->ShrinkToMinimumSize();
+    sEntries->RemoveElementAt(0);
+  }
+  RefPtr<TextureClientRecycleAllocator> allocator =
+      new TextureClientRecycleAllocator(imageBridge);
+  allocator->SetMaxPoolSize(kMaxPooledBuffers);
+  sEntries->AppendElement(Entry{aGrallocFormat, aSize, allocator});
+  MOZ_LOG(gGonkVideoDecoderManagerLog, LogLevel::Debug,
+          ("New video buffer pool for format 0x%x, %dx%d", aGrallocFormat,
+           aSize.width, aSize.height));
+  return allocator.forget();
+}
+
+void GonkVideoBufferPool::RegisterObservers() {
+  MOZ_ASSERT(NS_IsMainThread());
+  nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+  if (!obs) {
+    Clear();
+    return;
+  }
+  obs->AddObserver(this, "memory-pressure", false);
+  obs->AddObserver(this, "xpcom-shutdown", false);
+}
+
+/* static */
+void GonkVideoBufferPool::Clear() {
+  StaticMutexAutoLock lock(sMutex);
+  if (!sEntries) {
+    return;
+  }
+  for (Entry& entry : *sEntries) {
+    entry.mAllocator->ShrinkToMinimumSize();
+  }
+  sEntries->Clear();
+}
+
+NS_IMETHODIMP
+GonkVideoBufferPool::Observe(nsISupports* aSubject, const char* aTopic,
+                             const char16_t* aData) {
+  Clear();
+  if (!strcmp(aTopic, "xpcom-shutdown")) {
+    nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+    if (obs) {
+      obs->RemoveObserver(this, "memory-pressure");
+      obs->RemoveObserver(this, "xpcom-shutdown");
+    }
+    StaticMutexAutoLock lock(sMutex);
+    sEntries = nullptr;
+    sInstance = nullptr;
+  }
+  return NS_OK;
+}
+
 GonkVideoDecoderManager::GonkVideoDecoderManager(
     const VideoInfo& aConfig, mozilla::layers::ImageContainer* aImageContainer)
     : mConfig(aConfig),
       mImageContainer(aImageContainer),
+      mCopyFormat(0),
       mColorConverterBufferSize(0),
       mPendingReleaseItemsLock(
           "GonkVideoDecoderManager::mPendingReleaseItemsLock"),
@@ -416,17 +557,19 @@ GonkVideoDecoderManager::CreateVideoDataFromGraphicBuffer(
 
   if (mNeedsCopyBuffer) {
     // Copy buffer contents for bug 1199809.
-    if (!mCopyAllocator) {
-      mCopyAllocator = new TextureClientRecycleAllocator(
-          ImageBridgeChild::GetSingleton().get());
+    uint32_t format = srcBuffer->getPixelFormat();
+    gfx::IntSize size(srcBuffer->getWidth(), srcBuffer->getHeight());
+    if (!mCopyAllocator || format != mCopyFormat || size != mCopySize) {
+      mCopyAllocator = GonkVideoBufferPool::GetAllocator(format, size);
+      mCopyFormat = format;
+      mCopySize = size;
     }
     if (!mCopyAllocator) {
       LOGE("Create buffer allocator failed!");
       return nullptr;
     }
 
-    gfx::IntSize size(srcBuffer->getWidth(), srcBuffer->getHeight());
-    GonkTextureClientAllocationHelper helper(srcBuffer->getPixelFormat(), size);
+    GonkTextureClientAllocationHelper helper(format, size);
     textureClient = mCopyAllocator->CreateOrRecycle(helper);
     if (!textureClient) {
       LOGE("Copy buffer allocation failed!");
@@ -471,8 +614,26 @@ GonkVideoDecoderManager::CreateVideoDataFromDataBuffer(
   int32_t stride = mFrameInfo.mStride;
   int32_t slice_height = mFrameInfo.mSliceHeight;
 
-  // Converts to OMX_COLOR_FormatYUV420Planar
-  if (mFrameInfo.mColorFormat != OMX_COLOR_FormatYUV420Planar) {
+  // Converts to OMX_COLOR_FormatYUV420Planar. Plain NV12 is handled by our
+  // own SIMD converter; only vendor specific layouts need the vendor library.
+  if (mFrameInfo.mColorFormat == OMX_COLOR_FormatYUV420SemiPlanar) {
+    int32_t width = mFrameInfo.mWidth;
+    int32_t height = mFrameInfo.mHeight;
+    int32_t chromaStride = (width + 1) / 2;
+    uint8_t* src = aSource->Data();
+    yuv420p_buffer = GetColorConverterBuffer(width, height);
+    uint8_t* dstY = yuv420p_buffer;
+    uint8_t* dstU = dstY + width * height;
+    uint8_t* dstV = dstU + chromaStride * ((height + 1) / 2);
+    if (!gonk::ConvertNV12ToI420(src, stride, src + stride * slice_height,
+                                 stride, dstY, width, dstU, chromaStride, dstV,
+                                 chromaStride, width, height)) {
+      LOGE("NV12 color conversion failed!");
+      return nullptr;
+    }
+    stride = width;
+    slice_height = height;
+  } else if (mFrameInfo.mColorFormat != OMX_COLOR_FormatYUV420Planar) {
     ARect crop;
     crop.top = 0;
     crop.bottom = mFrameInfo.mHeight;
@@ -103,7 +103,10 @@ class GonkVideoDecoderManager : public GonkDecoderManager {
   VideoInfo mConfig;
 
   RefPtr<layers::ImageContainer> mImageContainer;
+  // From the process-wide pool, for the format and size of the last copy.
   RefPtr<layers::TextureClientRecycleAllocator> mCopyAllocator;
+  uint32_t mCopyFormat;
+  gfx::IntSize mCopySize;
 
   MozPromiseRequestHolder<android::MediaCodecProxy::CodecPromise>
       mVideoCodecRequest;
@@ -12,6 +12,9 @@
 #include "mozilla/layers/GrallocTextureClient.h"
 #include "mozilla/layers/ImageBridgeChild.h"
 #include "mozilla/ReentrantMonitor.h"
+#include "mozilla/StaticPrefs_dom.h"
+#include "mozilla/StaticPrefs_media.h"
+#include "nsIPowerManagerService.h"
 #include "ScreenOrientation.h"
 
 namespace mozilla {
@@ -843,13 +846,47 @@ already_AddRefed<layers::Image> MediaEngineGonkVideoSource::RotateImage(
   return image.forget();
 }
 
+bool MediaEngineGonkVideoSource::CanPassThrough(layers::Image* aImage) const {
+  if (!StaticPrefs::media_getusermedia_camera_passthrough_enabled() ||
+      mRotation != 0 || !aImage->AsGrallocImage()) {
+    return false;
+  }
+  // YV12 is I420 with the chroma planes swapped, which the hardware encoders
+  // take as is and which ImageBuffer wraps for the software ones.
+  sp<GraphicBuffer> buffer = aImage->AsGrallocImage()->GetGraphicBuffer();
+  return buffer && buffer->getPixelFormat() == HAL_PIXEL_FORMAT_YV12;
+}
+
+bool MediaEngineGonkVideoSource::ShouldDropFrameForThermalState() {
+  uint32_t tier = StaticPrefs::dom_thermal_governor_tier();
+  if (!StaticPrefs::media_getusermedia_camera_thermal_throttling_enabled() ||
+      tier < nsIPowerManagerService::THERMAL_TIER_SERIOUS) {
+    mThermalFrameCount = 0;
+    return false;
+  }
+  // Keep one frame out of two at the serious tier and one out of three at
+  // the critical tier, which the encoder adapts its bitrate to.
+  uint32_t keepOneOf = tier - nsIPowerManagerService::THERMAL_TIER_FAIR + 1;
+  return mThermalFrameCount++ % keepOneOf != 0;
+}
+
 // CameraControlWrapper is holding mMonitor, so be careful with mutex locking.
 bool MediaEngineGonkVideoSource::OnNewPreviewFrame(layers::Image* aImage,
                                                    uint32_t aWidth,
                                                    uint32_t aHeight) {
-  // Bug XXX we'd prefer to avoid converting if mRotation == 0, but that causes
-  // problems in UpdateImage()
-  RefPtr<layers::Image> rotatedImage = RotateImage(aImage, aWidth, aHeight);
+  if (ShouldDropFrameForThermalState()) {
+    return true;
+  }
+
+  // Without rotation, a YV12 preview frame is delivered without a copy, all
+  // the way to the encoder.
+  RefPtr<layers::Image> rotatedImage = aImage;
+  if (!CanPassThrough(aImage)) {
+    rotatedImage = RotateImage(aImage, aWidth, aHeight);
+  }
+  if (!rotatedImage) {
+    return false;
+  }
   IntSize rotatedSize = rotatedImage->GetSize();
 
   if (mImageSize != rotatedSize) {
@@ -53,6 +53,14 @@ class MediaEngineGonkVideoSource : public MediaEngineCameraVideoSource,
                                               uint32_t aWidth,
                                               uint32_t aHeight);
 
+  // Whether the preview frame can be delivered as is, without rotating or
+  // converting it. Camera thread only.
+  bool CanPassThrough(layers::Image* aImage) const;
+
+  // Whether the preview frame should be dropped to lower the frame rate
+  // while the device is hot. Camera thread only.
+  bool ShouldDropFrameForThermalState();
+
   int mCaptureIndex;
 
   // mMutex protects certain members on 3 threads:
@@ -91,6 +99,10 @@ class MediaEngineGonkVideoSource : public MediaEngineCameraVideoSource,
 
   int mRotation = 0;
 
+  // Counts the preview frames while frames are being dropped for the thermal
+  // state. Camera thread only.
+  uint32_t mThermalFrameCount = 0;
+
   mutable nsTArray<webrtc::CaptureCapability> mHardcodedCapabilities;
 
   RefPtr<layers::TextureClientRecycleAllocator> mTextureClientAllocator;
@@ -15,7 +15,8 @@ namespace mozilla {
 /* static */
 WebrtcVideoEncoder* MediaDataCodec::CreateEncoder(
     webrtc::VideoCodecType aCodecType) {
-#if defined(MOZ_APPLEMEDIA) || defined(MOZ_WIDGET_ANDROID) || defined(MOZ_WMF)
+#if defined(MOZ_APPLEMEDIA) || defined(MOZ_WIDGET_ANDROID) || \
+    defined(MOZ_WMF) || defined(MOZ_WIDGET_GONK)
   if (aCodecType == webrtc::VideoCodecType::kVideoCodecH264) {
     return new WebrtcVideoEncoderProxy(new WebrtcMediaDataEncoder());
   }
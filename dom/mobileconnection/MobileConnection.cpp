@@ -27,6 +27,7 @@
 #include "nsJSUtils.h"
 #include "nsServiceManagerUtils.h"
 #include "nsContentUtils.h"
+#include "nsITimer.h"
 
 #define MOBILECONN_ERROR_INVALID_PARAMETER u"InvalidParameter"_ns
 #define MOBILECONN_ERROR_INVALID_PASSWORD u"InvalidPassword"_ns
@@ -183,6 +184,12 @@ void MobileConnection::Shutdown() {
     mImsHandler->Shutdown();
     mImsHandler = nullptr;
   }
+
+  if (mStateChangeTimer) {
+    mStateChangeTimer->Cancel();
+    mStateChangeTimer = nullptr;
+  }
+  mPendingStateChanges = 0;
 }
 
 MobileConnection::~MobileConnection() { Shutdown(); }
@@ -259,6 +266,52 @@ void MobileConnection::UpdateSignalStrength() {
   mSignalStrength->Update(ss);
 }
 
+// Voice, data and signal strength changes are coalesced over about one frame
+// so that a burst of them wakes the app's handlers once. The cached voice,
+// data and signal strength objects are updated right away; only the events
+// wait. Any other event fires the collected ones first so that the order
+// between events is kept.
+void MobileConnection::ScheduleStateChangeEvent(uint32_t aChange) {
+  bool scheduled = mPendingStateChanges != 0;
+  mPendingStateChanges |= aChange;
+  if (scheduled) {
+    return;
+  }
+
+  if (!mStateChangeTimer) {
+    mStateChangeTimer = NS_NewTimer();
+  }
+  if (!mStateChangeTimer ||
+      NS_FAILED(mStateChangeTimer->InitWithNamedFuncCallback(
+          StateChangeTimerCallback, this, kStateChangeCoalescingMs,
+          nsITimer::TYPE_ONE_SHOT,
+          "MobileConnection::StateChangeTimerCallback"))) {
+    FireStateChangeEvents();
+  }
+}
+
+/* static */
+void MobileConnection::StateChangeTimerCallback(nsITimer* aTimer,
+                                                void* aClosure) {
+  RefPtr<MobileConnection> self = static_cast<MobileConnection*>(aClosure);
+  self->FireStateChangeEvents();
+}
+
+void MobileConnection::FireStateChangeEvents() {
+  uint32_t changes = mPendingStateChanges;
+  mPendingStateChanges = 0;
+
+  if (changes & kVoiceChanged) {
+    DispatchTrustedEvent(u"voicechange"_ns);
+  }
+  if (changes & kDataChanged) {
+    DispatchTrustedEvent(u"datachange"_ns);
+  }
+  if (changes & kSignalStrengthChanged) {
+    DispatchTrustedEvent(u"signalstrengthchange"_ns);
+  }
+}
+
 nsresult MobileConnection::NotifyError(DOMRequest* aRequest,
                                        const nsAString& aMessage) {
   nsCOMPtr<nsIDOMRequestService> rs =
@@ -1041,7 +1094,8 @@ MobileConnection::NotifyVoiceChanged() {
 
   UpdateVoice();
 
-  return DispatchTrustedEvent(u"voicechange"_ns);
+  ScheduleStateChangeEvent(kVoiceChanged);
+  return NS_OK;
 }
 
 NS_IMETHODIMP
@@ -1052,7 +1106,8 @@ MobileConnection::NotifyDataChanged() {
 
   UpdateData();
 
-  return DispatchTrustedEvent(u"datachange"_ns);
+  ScheduleStateChangeEvent(kDataChanged);
+  return NS_OK;
 }
 
 NS_IMETHODIMP
@@ -1069,6 +1124,7 @@ MobileConnection::NotifyDataError(const nsAString& aMessage) {
   RefPtr<DataErrorEvent> event =
       DataErrorEvent::Constructor(this, u"dataerror"_ns, init);
 
+  FireStateChangeEvents();
   return DispatchTrustedEvent(event);
 }
 
@@ -1094,6 +1150,7 @@ MobileConnection::NotifyCFStateChanged(unsigned short aAction,
   RefPtr<CFStateChangeEvent> event = CFStateChangeEvent::Constructor(
       this, u"cfstatechange"_ns, init);
 
+  FireStateChangeEvents();
   return DispatchTrustedEvent(event);
 }
 
@@ -1113,6 +1170,7 @@ MobileConnection::NotifyEmergencyCbModeChanged(bool aActive,
   RefPtr<EmergencyCbModeEvent> event = EmergencyCbModeEvent::Constructor(
       this, u"emergencycbmodechange"_ns, init);
 
+  FireStateChangeEvents();
   return DispatchTrustedEvent(event);
 }
 
@@ -1129,6 +1187,7 @@ MobileConnection::NotifyOtaStatusChanged(const nsAString& aStatus) {
   RefPtr<OtaStatusEvent> event = OtaStatusEvent::Constructor(
       this, u"otastatuschange"_ns, init);
 
+  FireStateChangeEvents();
   return DispatchTrustedEvent(event);
 }
 
@@ -1138,6 +1197,7 @@ MobileConnection::NotifyRadioStateChanged() {
     return NS_OK;
   }
 
+  FireStateChangeEvents();
   return DispatchTrustedEvent(u"radiostatechange"_ns);
 }
 
@@ -1155,6 +1215,7 @@ MobileConnection::NotifyClirModeChanged(uint32_t aMode) {
   RefPtr<ClirModeEvent> event = ClirModeEvent::Constructor(
       this, u"clirmodechange"_ns, init);
 
+  FireStateChangeEvents();
   return DispatchTrustedEvent(event);
 }
 
@@ -1170,6 +1231,7 @@ MobileConnection::NotifyNetworkSelectionModeChanged() {
     return NS_OK;
   }
 
+  FireStateChangeEvents();
   return DispatchTrustedEvent(u"networkselectionmodechange"_ns);
 }
 
@@ -1187,7 +1249,8 @@ MobileConnection::NotifySignalStrengthChanged() {
 
   UpdateSignalStrength();
 
-  return DispatchTrustedEvent(u"signalstrengthchange"_ns);
+  ScheduleStateChangeEvent(kSignalStrengthChanged);
+  return NS_OK;
 }
 
 NS_IMETHODIMP
@@ -1202,6 +1265,7 @@ MobileConnection::NotifyModemRestart(const nsAString& aReason) {
   RefPtr<ModemRestartEvent> event = ModemRestartEvent::Constructor(
       this, u"modemrestart"_ns, init);
 
+  FireStateChangeEvents();
   return DispatchTrustedEvent(event);
 }
 
@@ -1228,6 +1292,8 @@ MobileConnection::NotifyIccInfoChanged() {
     return NS_OK;
   }
 
+  FireStateChangeEvents();
+
   RefPtr<AsyncEventDispatcher> asyncDispatcher = new AsyncEventDispatcher(
       this, u"iccchange"_ns, CanBubble::eNo);
 
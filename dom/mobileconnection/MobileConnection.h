@@ -20,6 +20,8 @@
 #include "nsIMobileConnectionService.h"
 //#include "nsWeakPtr.h"
 
+class nsITimer;
+
 namespace mozilla {
 namespace dom {
 
@@ -169,6 +171,16 @@ class MobileConnection final : public DOMEventTargetHelper,
   // mutable for lazy initialization in GetImsRegHandler() const.
   mutable RefPtr<ImsRegHandler> mImsHandler;
 
+  static const uint32_t kVoiceChanged = 1 << 0;
+  static const uint32_t kDataChanged = 1 << 1;
+  static const uint32_t kSignalStrengthChanged = 1 << 2;
+  // About one frame.
+  static const uint32_t kStateChangeCoalescingMs = 16;
+
+  // Change events waiting for mStateChangeTimer.
+  uint32_t mPendingStateChanges = 0;
+  nsCOMPtr<nsITimer> mStateChangeTimer;
+
   bool CheckPermission(const char* aType) const;
 
   void UpdateVoice();
@@ -179,6 +191,12 @@ class MobileConnection final : public DOMEventTargetHelper,
 
   void UpdateSignalStrength();
 
+  void ScheduleStateChangeEvent(uint32_t aChange);
+
+  static void StateChangeTimerCallback(nsITimer* aTimer, void* aClosure);
+
+  void FireStateChangeEvents();
+
   nsresult NotifyError(DOMRequest* aRequest, const nsAString& aMessage);
 
   bool IsValidPassword(const nsAString& aPassword);
@@ -11,15 +11,17 @@
 #include "mozilla/dom/mobileconnection/MobileConnectionIPCSerializer.h"
 #include "mozilla/dom/MobileConnectionBinding.h"
 #include "mozilla/dom/ToJSValue.h"
+#include "mozilla/Unused.h"
 #include "nsIVariant.h"
 #include "nsJSUtils.h"
+#include "nsThreadUtils.h"
 
 using namespace mozilla;
 using namespace mozilla::dom;
 using namespace mozilla::dom::mobileconnection;
 
 MobileConnectionParent::MobileConnectionParent(uint32_t aClientId)
-    : mLive(true) {
+    : mLive(true), mPendingStateChanges(0) {
   nsCOMPtr<nsIMobileConnectionService> service =
       do_GetService(NS_MOBILE_CONNECTION_SERVICE_CONTRACTID);
   NS_ASSERTION(service, "This shouldn't fail!");
@@ -232,39 +234,69 @@ mozilla::ipc::IPCResult MobileConnectionParent::RecvGetSupportedNetworkTypes(
 
 NS_IMPL_ISUPPORTS(MobileConnectionParent, nsIMobileConnectionListener)
 
+// Voice, data and signal strength changes often come in bursts, e.g. when the
+// registration state is polled. They are collected for the current event loop
+// turn and sent once, with the state as it is then. Any other notification
+// sends the collected ones first so that the child sees them in order.
+void MobileConnectionParent::ScheduleStateChange(uint32_t aChange) {
+  if (!mPendingStateChanges) {
+    NS_DispatchToCurrentThread(NewRunnableMethod(
+        "MobileConnectionParent::SendPendingStateChanges", this,
+        &MobileConnectionParent::SendPendingStateChanges));
+  }
+  mPendingStateChanges |= aChange;
+}
+
+void MobileConnectionParent::SendPendingStateChanges() {
+  uint32_t changes = mPendingStateChanges;
+  mPendingStateChanges = 0;
+  if (!changes || !mLive || !mMobileConnection) {
+    return;
+  }
+
+  // We release the refs after serializing process is finished in
+  // MobileConnectionIPCSerializer.
+  if (changes & kVoiceChanged) {
+    nsCOMPtr<nsIMobileConnectionInfo> info;
+    if (NS_SUCCEEDED(mMobileConnection->GetVoice(getter_AddRefs(info)))) {
+      Unused << SendNotifyVoiceInfoChanged(info.forget().take());
+    }
+  }
+  if (changes & kDataChanged) {
+    nsCOMPtr<nsIMobileConnectionInfo> info;
+    if (NS_SUCCEEDED(mMobileConnection->GetData(getter_AddRefs(info)))) {
+      Unused << SendNotifyDataInfoChanged(info.forget().take());
+    }
+  }
+  if (changes & kSignalStrengthChanged) {
+    nsCOMPtr<nsIMobileSignalStrength> signalStrength;
+    if (NS_SUCCEEDED(mMobileConnection->GetSignalStrength(
+            getter_AddRefs(signalStrength)))) {
+      Unused << SendNotifySignalStrengthChanged(signalStrength.forget().take());
+    }
+  }
+}
+
 NS_IMETHODIMP
 MobileConnectionParent::NotifyVoiceChanged() {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
 
-  nsresult rv;
-  nsCOMPtr<nsIMobileConnectionInfo> info;
-  rv = mMobileConnection->GetVoice(getter_AddRefs(info));
-  NS_ENSURE_SUCCESS(rv, NS_ERROR_FAILURE);
-
-  // We release the ref after serializing process is finished in
-  // MobileConnectionIPCSerializer.
-  return SendNotifyVoiceInfoChanged(info.forget().take()) ? NS_OK
-                                                          : NS_ERROR_FAILURE;
+  ScheduleStateChange(kVoiceChanged);
+  return NS_OK;
 }
 
 NS_IMETHODIMP
 MobileConnectionParent::NotifyDataChanged() {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
 
-  nsresult rv;
-  nsCOMPtr<nsIMobileConnectionInfo> info;
-  rv = mMobileConnection->GetData(getter_AddRefs(info));
-  NS_ENSURE_SUCCESS(rv, NS_ERROR_FAILURE);
-
-  // We release the ref after serializing process is finished in
-  // MobileConnectionIPCSerializer.
-  return SendNotifyDataInfoChanged(info.forget().take()) ? NS_OK
-                                                         : NS_ERROR_FAILURE;
+  ScheduleStateChange(kDataChanged);
+  return NS_OK;
 }
 
 NS_IMETHODIMP
 MobileConnectionParent::NotifyDataError(const nsAString& aMessage) {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
+  SendPendingStateChanges();
 
   return SendNotifyDataError(nsAutoString(aMessage)) ? NS_OK : NS_ERROR_FAILURE;
 }
@@ -275,6 +307,7 @@ MobileConnectionParent::NotifyCFStateChanged(uint16_t aAction, uint16_t aReason,
                                              uint16_t aTimeSeconds,
                                              uint16_t aServiceClass) {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
+  SendPendingStateChanges();
 
   return SendNotifyCFStateChanged(aAction, aReason, nsAutoString(aNumber),
                                   aTimeSeconds, aServiceClass)
@@ -286,6 +319,7 @@ NS_IMETHODIMP
 MobileConnectionParent::NotifyEmergencyCbModeChanged(bool aActive,
                                                      uint32_t aTimeoutMs) {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
+  SendPendingStateChanges();
 
   return SendNotifyEmergencyCbModeChanged(aActive, aTimeoutMs)
              ? NS_OK
@@ -295,6 +329,7 @@ MobileConnectionParent::NotifyEmergencyCbModeChanged(bool aActive,
 NS_IMETHODIMP
 MobileConnectionParent::NotifyOtaStatusChanged(const nsAString& aStatus) {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
+  SendPendingStateChanges();
 
   return SendNotifyOtaStatusChanged(nsAutoString(aStatus)) ? NS_OK
                                                            : NS_ERROR_FAILURE;
@@ -303,6 +338,7 @@ MobileConnectionParent::NotifyOtaStatusChanged(const nsAString& aStatus) {
 NS_IMETHODIMP
 MobileConnectionParent::NotifyRadioStateChanged() {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
+  SendPendingStateChanges();
 
   nsresult rv;
   int32_t radioState;
@@ -315,6 +351,7 @@ MobileConnectionParent::NotifyRadioStateChanged() {
 NS_IMETHODIMP
 MobileConnectionParent::NotifyClirModeChanged(uint32_t aMode) {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
+  SendPendingStateChanges();
 
   return SendNotifyClirModeChanged(aMode) ? NS_OK : NS_ERROR_FAILURE;
 }
@@ -322,6 +359,7 @@ MobileConnectionParent::NotifyClirModeChanged(uint32_t aMode) {
 NS_IMETHODIMP
 MobileConnectionParent::NotifyLastKnownNetworkChanged() {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
+  SendPendingStateChanges();
 
   nsresult rv;
   nsAutoString network;
@@ -334,6 +372,7 @@ MobileConnectionParent::NotifyLastKnownNetworkChanged() {
 NS_IMETHODIMP
 MobileConnectionParent::NotifyLastKnownHomeNetworkChanged() {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
+  SendPendingStateChanges();
 
   nsresult rv;
   nsAutoString network;
@@ -346,6 +385,7 @@ MobileConnectionParent::NotifyLastKnownHomeNetworkChanged() {
 NS_IMETHODIMP
 MobileConnectionParent::NotifyNetworkSelectionModeChanged() {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
+  SendPendingStateChanges();
 
   nsresult rv;
   int32_t mode;
@@ -358,6 +398,7 @@ MobileConnectionParent::NotifyNetworkSelectionModeChanged() {
 NS_IMETHODIMP
 MobileConnectionParent::NotifyDeviceIdentitiesChanged() {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
+  SendPendingStateChanges();
   nsresult rv;
   nsCOMPtr<nsIMobileDeviceIdentities> deviceIdentities;
   rv = mMobileConnection->GetDeviceIdentities(getter_AddRefs(deviceIdentities));
@@ -373,20 +414,14 @@ NS_IMETHODIMP
 MobileConnectionParent::NotifySignalStrengthChanged() {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
 
-  nsresult rv;
-  nsCOMPtr<nsIMobileSignalStrength> singalStrength;
-  rv = mMobileConnection->GetSignalStrength(getter_AddRefs(singalStrength));
-
-  NS_ENSURE_SUCCESS(rv, rv);
-
-  return SendNotifySignalStrengthChanged(singalStrength.forget().take())
-             ? NS_OK
-             : NS_ERROR_FAILURE;
+  ScheduleStateChange(kSignalStrengthChanged);
+  return NS_OK;
 }
 
 NS_IMETHODIMP
 MobileConnectionParent::NotifyModemRestart(const nsAString& aReason) {
   NS_ENSURE_TRUE(mLive, NS_ERROR_FAILURE);
+  SendPendingStateChanges();
 
   return SendNotifyModemRestart(nsAutoString(aReason)) ? NS_OK
                                                        : NS_ERROR_FAILURE;
@@ -59,8 +59,18 @@ class MobileConnectionParent : public PMobileConnectionParent,
       nsTArray<int32_t>* aSupportedNetworkTypes);
 
  private:
+  static const uint32_t kVoiceChanged = 1 << 0;
+  static const uint32_t kDataChanged = 1 << 1;
+  static const uint32_t kSignalStrengthChanged = 1 << 2;
+
+  void ScheduleStateChange(uint32_t aChange);
+  void SendPendingStateChanges();
+
   nsCOMPtr<nsIMobileConnection> mMobileConnection;
   bool mLive;
+  // kVoiceChanged, kDataChanged and kSignalStrengthChanged bits waiting to be
+  // sent by SendPendingStateChanges().
+  uint32_t mPendingStateChanges;
 };
 
 /******************************************************************************
@@ -21,6 +21,7 @@
 #include "mozilla/dom/IPCBlobUtils.h"
 #include "mozilla/dom/ToJSValue.h"
 #include "mozilla/dom/mobilemessage/Constants.h"  // For MessageType
+#include "mozilla/StaticPrefs_dom.h"
 #include "mozilla/UniquePtr.h"
 #include "nsContentUtils.h"
 #include "xpcpublic.h"
@@ -778,14 +779,15 @@ void MobileMessageCursorParent::ActorDestroy(ActorDestroyReason aWhy) {
   // 2) When parent dies normally, mContinueCallback should have been cleared in
   //    NotifyCursorError(), but just ensure this again.
   mContinueCallback = nullptr;
+  mResults.Clear();
 }
 
 bool MobileMessageCursorParent::RecvContinue() {
   MOZ_ASSERT(mContinueCallback);
 
-  if (NS_FAILED(mContinueCallback->HandleContinue())) {
-    return NS_SUCCEEDED(
-        NotifyCursorError(nsIMobileMessageCallback::INTERNAL_ERROR));
+  mPagesRequested++;
+  if (NS_SUCCEEDED(MaybeSendPage())) {
+    MaybeFetch();
   }
 
   return true;
@@ -855,9 +857,12 @@ MobileMessageCursorParent::NotifyCursorError(int32_t aError) {
   // error here to avoid sending a message to the dead process.
   NS_ENSURE_TRUE(mContinueCallback, NS_ERROR_FAILURE);
 
-  mContinueCallback = nullptr;
+  mFetching = false;
+  mFinished = true;
+  mError = aError;
 
-  return Send__delete__(this, aError) ? NS_OK : NS_ERROR_FAILURE;
+  // Anything read before the error still goes to the child first.
+  return MaybeSendPage();
 }
 
 NS_IMETHODIMP
@@ -870,18 +875,83 @@ MobileMessageCursorParent::NotifyCursorResult(nsISupports** aResults,
   // error here to avoid sending a message to the dead process.
   NS_ENSURE_TRUE(mContinueCallback, NS_ERROR_FAILURE);
 
-  nsCOMPtr<nsIMobileMessageThread> iThread = do_QueryInterface(aResults[0]);
+  mFetching = false;
+  mResults.SetCapacity(mResults.Length() + aSize);
+  for (uint32_t i = 0; i < aSize; i++) {
+    mResults.AppendElement(aResults[i]);
+  }
+
+  nsresult rv = MaybeSendPage();
+  NS_ENSURE_SUCCESS(rv, rv);
+
+  MaybeFetch();
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+MobileMessageCursorParent::NotifyCursorDone() {
+  return NotifyCursorError(nsIMobileMessageCallback::SUCCESS_NO_ERROR);
+}
+
+static uint32_t CursorPageSize() {
+  return std::max(StaticPrefs::dom_sms_cursor_page_size(), 1u);
+}
+
+nsresult MobileMessageCursorParent::MaybeSendPage() {
+  const uint32_t pageSize = CursorPageSize();
+  while (mPagesRequested &&
+         (mResults.Length() >= pageSize || (mFinished && !mResults.IsEmpty()))) {
+    mPagesRequested--;
+    nsresult rv = SendPage(std::min<uint32_t>(mResults.Length(), pageSize));
+    NS_ENSURE_SUCCESS(rv, rv);
+  }
+
+  if (mPagesRequested && mFinished) {
+    mPagesRequested = 0;
+    mContinueCallback = nullptr;
+    return Send__delete__(this, mError) ? NS_OK : NS_ERROR_FAILURE;
+  }
+
+  // Otherwise the page is still being read and goes out once full.
+  return NS_OK;
+}
+
+void MobileMessageCursorParent::MaybeFetch() {
+  // The database may answer from within HandleContinue(), which lands back
+  // here through NotifyCursorResult(); the loop below picks that up.
+  if (mInFetchLoop) {
+    return;
+  }
+  mInFetchLoop = true;
+
+  const uint32_t pageSize = CursorPageSize();
+  while (mContinueCallback && !mFetching && !mFinished &&
+         mResults.Length() < pageSize) {
+    mFetching = true;
+    if (NS_FAILED(mContinueCallback->HandleContinue())) {
+      NotifyCursorError(nsIMobileMessageCallback::INTERNAL_ERROR);
+    }
+  }
+
+  mInFetchLoop = false;
+}
+
+nsresult MobileMessageCursorParent::SendPage(uint32_t aCount) {
+  MOZ_ASSERT(aCount && aCount <= mResults.Length());
+
+  nsCOMPtr<nsIMobileMessageThread> iThread = do_QueryInterface(mResults[0]);
   if (iThread) {
-    nsTArray<ThreadData> threads;
+    nsTArray<ThreadData> threads(aCount);
 
-    for (uint32_t i = 0; i < aSize; i++) {
-      nsCOMPtr<nsIMobileMessageThread> iThread = do_QueryInterface(aResults[i]);
+    for (uint32_t i = 0; i < aCount; i++) {
+      nsCOMPtr<nsIMobileMessageThread> iThread = do_QueryInterface(mResults[i]);
       NS_ENSURE_TRUE(iThread, NS_ERROR_FAILURE);
 
       MobileMessageThreadInternal* thread =
           static_cast<MobileMessageThreadInternal*>(iThread.get());
       threads.AppendElement(thread->GetData());
     }
+    mResults.RemoveElementsAt(0, aCount);
 
     return SendNotifyResult(MobileMessageCursorData(ThreadArrayData(threads)))
                ? NS_OK
@@ -889,16 +959,16 @@ MobileMessageCursorParent::NotifyCursorResult(nsISupports** aResults,
   }
 
   ContentParent* parent = static_cast<ContentParent*>(Manager()->Manager());
-  nsTArray<MobileMessageData> messages;
-  for (uint32_t i = 0; i < aSize; i++) {
-    nsCOMPtr<nsISmsMessage> sms = do_QueryInterface(aResults[i]);
+  nsTArray<MobileMessageData> messages(aCount);
+  for (uint32_t i = 0; i < aCount; i++) {
+    nsCOMPtr<nsISmsMessage> sms = do_QueryInterface(mResults[i]);
     if (sms) {
       messages.AppendElement(
           static_cast<SmsMessageInternal*>(sms.get())->GetData());
       continue;
     }
 
-    nsCOMPtr<nsIMmsMessage> mms = do_QueryInterface(aResults[i]);
+    nsCOMPtr<nsIMmsMessage> mms = do_QueryInterface(mResults[i]);
     if (mms) {
       MmsMessageData mmsData;
       NS_ENSURE_TRUE(
@@ -910,6 +980,7 @@ MobileMessageCursorParent::NotifyCursorResult(nsISupports** aResults,
 
     return NS_ERROR_FAILURE;
   }
+  mResults.RemoveElementsAt(0, aCount);
 
   return SendNotifyResult(
              MobileMessageCursorData(MobileMessageArrayData(messages)))
@@ -917,11 +988,6 @@ MobileMessageCursorParent::NotifyCursorResult(nsISupports** aResults,
              : NS_ERROR_FAILURE;
 }
 
-NS_IMETHODIMP
-MobileMessageCursorParent::NotifyCursorDone() {
-  return NotifyCursorError(nsIMobileMessageCallback::SUCCESS_NO_ERROR);
-}
-
 }  // namespace mobilemessage
 }  // namespace dom
 }  // namespace mozilla
@@ -103,12 +103,31 @@ class MobileMessageCursorParent : public PMobileMessageCursorParent,
   friend class PMobileMessageCursorParent;
   nsCOMPtr<nsICursorContinueCallback> mContinueCallback;
 
+  // Results read from the database but not sent yet. They go to the child
+  // in pages of dom.sms.cursor_page_size, and the next page is read while
+  // the child works through the previous one.
+  nsTArray<nsCOMPtr<nsISupports>> mResults;
+  // Pages the child has asked for and not received yet. The database sends
+  // its first results unasked, so the child counts on one page up front.
+  uint32_t mPagesRequested;
+  // A read from the database is in progress.
+  bool mFetching;
+  bool mInFetchLoop;
+  // The database has no more results; mError is what to finish with.
+  bool mFinished;
+  int32_t mError;
+
  public:
   NS_DECL_ISUPPORTS
   NS_DECL_NSIMOBILEMESSAGECURSORCALLBACK
 
  protected:
-  MobileMessageCursorParent() {}
+  MobileMessageCursorParent()
+      : mPagesRequested(1),
+        mFetching(true),
+        mInFetchLoop(false),
+        mFinished(false),
+        mError(nsIMobileMessageCallback::SUCCESS_NO_ERROR) {}
 
   virtual ~MobileMessageCursorParent() {}
 
@@ -119,6 +138,11 @@ class MobileMessageCursorParent : public PMobileMessageCursorParent,
   bool DoRequest(const CreateMessageCursorRequest& aRequest);
 
   bool DoRequest(const CreateThreadCursorRequest& aRequest);
+
+ private:
+  nsresult MaybeSendPage();
+  nsresult SendPage(uint32_t aCount);
+  void MaybeFetch();
 };
 
 }  // namespace mobilemessage
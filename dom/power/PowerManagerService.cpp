@@ -10,6 +10,7 @@
 #include "mozilla/ClearOnShutdown.h"
 #include "mozilla/ModuleUtils.h"
 #include "mozilla/Preferences.h"
+#include "mozilla/StaticPrefs_dom.h"
 #include "nsIDOMWakeLockListener.h"
 #include "PowerManagerService.h"
 #include "WakeLock.h"
@@ -135,6 +136,13 @@ PowerManagerService::NewWakeLock(const nsAString& aTopic,
   return NS_OK;
 }
 
+NS_IMETHODIMP
+PowerManagerService::GetThermalTier(uint16_t* aThermalTier) {
+  // Published by the ThermalGovernor of the parent process.
+  *aThermalTier = StaticPrefs::dom_thermal_governor_tier();
+  return NS_OK;
+}
+
 }  // namespace mozilla::dom::power
 
 NS_DEFINE_NAMED_CID(NS_POWERMANAGERSERVICE_CID);
@@ -0,0 +1,225 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "ThermalGovernor.h"
+
+#include <errno.h>
+#include <algorithm>
+
+#include "mozilla/FileUtils.h"
+#include "mozilla/Preferences.h"
+#include "mozilla/Services.h"
+#include "mozilla/StaticPrefs_dom.h"
+#include "nsIObserverService.h"
+#include "nsIPowerManagerService.h"
+#include "nsPrintfCString.h"
+#include "nsThreadUtils.h"
+#include "nsXULAppAPI.h"
+
+namespace mozilla::dom::power {
+
+static const char kThermalTierChangedTopic[] = "thermal-tier-changed";
+
+static const char16_t* const kTierNames[] = {u"nominal", u"fair", u"serious",
+                                             u"critical"};
+
+// Default values applied for the fair, serious and critical tiers.
+struct ThermalPrefOverride {
+  const char* mName;
+  int32_t mValues[3];
+};
+
+static const ThermalPrefOverride kPrefOverrides[] = {
+    // Composite on every 1st, 2nd or 3rd vsync.
+    {"gfx.vsync.compositor.divisor", {1, 2, 3}},
+    {"dom.min_background_timeout_value", {2000, 10000, 30000}},
+    {"javascript.options.mem.gc_max_helper_threads", {4, 2, 1}},
+};
+
+// The defaults of kPrefOverrides, restored at the nominal tier.
+static int32_t sOriginalValues[MOZ_ARRAY_LENGTH(kPrefOverrides)];
+
+// Thermal zones are numbered from 0 and there are rarely more than a few
+// dozen of them.
+static const int kMaxThermalZones = 64;
+
+NS_IMPL_ISUPPORTS(ThermalGovernor, nsIObserver, nsITimerCallback, nsINamed)
+
+ThermalGovernor::ThermalGovernor()
+    : mTier(nsIPowerManagerService::THERMAL_TIER_NOMINAL),
+      mReadPending(false) {}
+
+/* static */
+already_AddRefed<ThermalGovernor> ThermalGovernor::FactoryCreate() {
+  if (!XRE_IsParentProcess() || !StaticPrefs::dom_thermal_governor_enabled()) {
+    return nullptr;
+  }
+
+  RefPtr<ThermalGovernor> governor = new ThermalGovernor();
+  return governor.forget();
+}
+
+NS_IMETHODIMP
+ThermalGovernor::Observe(nsISupports* aSubject, const char* aTopic,
+                         const char16_t* aData) {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (!strcmp(aTopic, "profile-after-change")) {
+    Start();
+    return NS_OK;
+  }
+
+  if (!strcmp(aTopic, "xpcom-shutdown")) {
+    Shutdown();
+    return NS_OK;
+  }
+
+  MOZ_ASSERT_UNREACHABLE("Unexpected topic");
+  return NS_OK;
+}
+
+void ThermalGovernor::Start() {
+  if (mTimer) {
+    return;
+  }
+
+  for (size_t i = 0; i < MOZ_ARRAY_LENGTH(kPrefOverrides); i++) {
+    sOriginalValues[i] =
+        Preferences::GetInt(kPrefOverrides[i].mName, 0, PrefValueKind::Default);
+  }
+
+  nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+  if (obs) {
+    obs->AddObserver(this, "xpcom-shutdown", false);
+  }
+
+  NS_NewTimerWithCallback(getter_AddRefs(mTimer), this,
+                          StaticPrefs::dom_thermal_governor_interval_ms(),
+                          nsITimer::TYPE_REPEATING_SLACK);
+  ScheduleRead();
+}
+
+void ThermalGovernor::Shutdown() {
+  if (mTimer) {
+    mTimer->Cancel();
+    mTimer = nullptr;
+  }
+
+  nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+  if (obs) {
+    obs->RemoveObserver(this, "xpcom-shutdown");
+  }
+}
+
+NS_IMETHODIMP
+ThermalGovernor::Notify(nsITimer* aTimer) {
+  ScheduleRead();
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+ThermalGovernor::GetName(nsACString& aName) {
+  aName.AssignLiteral("ThermalGovernor");
+  return NS_OK;
+}
+
+void ThermalGovernor::ScheduleRead() {
+  if (mReadPending) {
+    return;
+  }
+  mReadPending = true;
+
+  RefPtr<ThermalGovernor> self = this;
+  NS_DispatchBackgroundTask(NS_NewRunnableFunction(
+      "ThermalGovernor::ReadHottestZone", [self]() {
+        int32_t temperature = ReadHottestZone();
+        NS_DispatchToMainThread(NewRunnableMethod<int32_t>(
+            "ThermalGovernor::OnTemperature", self,
+            &ThermalGovernor::OnTemperature, temperature));
+      }));
+}
+
+/* static */
+int32_t ThermalGovernor::ReadHottestZone() {
+  int32_t hottest = INT32_MIN;
+#ifdef ReadSysFile_PRESENT
+  for (int i = 0; i < kMaxThermalZones; i++) {
+    nsPrintfCString path("/sys/class/thermal/thermal_zone%d/temp", i);
+    int temperature;
+    if (!ReadSysFile(path.get(), &temperature)) {
+      if (errno == ENOENT) {
+        break;
+      }
+      continue;
+    }
+    // Some drivers report whole degrees rather than millidegrees.
+    if (temperature > -1000 && temperature < 1000) {
+      temperature *= 1000;
+    }
+    hottest = std::max(hottest, temperature);
+  }
+#endif
+  return hottest;
+}
+
+void ThermalGovernor::OnTemperature(int32_t aMilliCelsius) {
+  MOZ_ASSERT(NS_IsMainThread());
+  mReadPending = false;
+
+  if (!mTimer || aMilliCelsius == INT32_MIN) {
+    return;
+  }
+
+  SetTier(ComputeTier(aMilliCelsius));
+}
+
+uint16_t ThermalGovernor::ComputeTier(int32_t aMilliCelsius) const {
+  const int32_t thresholds[] = {
+      INT32_MIN,
+      StaticPrefs::dom_thermal_governor_fair_threshold(),
+      StaticPrefs::dom_thermal_governor_serious_threshold(),
+      StaticPrefs::dom_thermal_governor_critical_threshold(),
+  };
+  int32_t hysteresis = StaticPrefs::dom_thermal_governor_hysteresis();
+
+  // A tier is entered at its threshold and only left once the temperature is
+  // below it by the hysteresis, so that a device hovering around a threshold
+  // doesn't keep switching.
+  uint16_t tier = mTier;
+  while (tier < nsIPowerManagerService::THERMAL_TIER_CRITICAL &&
+         aMilliCelsius >= thresholds[tier + 1]) {
+    tier++;
+  }
+  while (tier > nsIPowerManagerService::THERMAL_TIER_NOMINAL &&
+         aMilliCelsius < thresholds[tier] - hysteresis) {
+    tier--;
+  }
+  return tier;
+}
+
+void ThermalGovernor::SetTier(uint16_t aTier) {
+  if (aTier == mTier) {
+    return;
+  }
+  mTier = aTier;
+
+  for (size_t i = 0; i < MOZ_ARRAY_LENGTH(kPrefOverrides); i++) {
+    int32_t value = mTier == nsIPowerManagerService::THERMAL_TIER_NOMINAL
+                        ? sOriginalValues[i]
+                        : kPrefOverrides[i].mValues[mTier - 1];
+    Preferences::SetInt(kPrefOverrides[i].mName, value,
+                        PrefValueKind::Default);
+  }
+  Preferences::SetUint("dom.thermal_governor.tier", mTier,
+                       PrefValueKind::Default);
+
+  nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+  if (obs) {
+    obs->NotifyObservers(nullptr, kThermalTierChangedTopic, kTierNames[mTier]);
+  }
+}
+
+}  // namespace mozilla::dom::power
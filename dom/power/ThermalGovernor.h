@@ -0,0 +1,69 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#ifndef mozilla_dom_power_ThermalGovernor_h
+#define mozilla_dom_power_ThermalGovernor_h
+
+#include "nsCOMPtr.h"
+#include "nsINamed.h"
+#include "nsIObserver.h"
+#include "nsITimer.h"
+
+namespace mozilla {
+namespace dom {
+namespace power {
+
+/**
+ * ThermalGovernor reads the temperature of the device's thermal zones and
+ * gives up performance gradually before the kernel throttles the CPU and
+ * frames start to drop erratically.
+ *
+ * The hottest zone is mapped to one of the nsIPowerManagerService
+ * THERMAL_TIER_* values, with hysteresis. For each tier above nominal the
+ * governor overrides the default value of a few prefs, which lowers the
+ * composition rate, clamps background timers harder and caps the JS helper
+ * threads. Default values reach the content processes like any other pref
+ * and are never written to the profile. The tier itself is published in
+ * dom.thermal_governor.tier and notified as "thermal-tier-changed".
+ *
+ * Only runs in the parent process, when dom.thermal_governor.enabled is set.
+ */
+class ThermalGovernor final : public nsIObserver,
+                              public nsITimerCallback,
+                              public nsINamed {
+ public:
+  NS_DECL_ISUPPORTS
+  NS_DECL_NSIOBSERVER
+  NS_DECL_NSITIMERCALLBACK
+  NS_DECL_NSINAMED
+
+  static already_AddRefed<ThermalGovernor> FactoryCreate();
+
+ private:
+  ThermalGovernor();
+  ~ThermalGovernor() = default;
+
+  void Start();
+  void Shutdown();
+  void ScheduleRead();
+
+  // Returns the temperature of the hottest thermal zone in millidegrees
+  // Celsius, or INT32_MIN if none could be read. Does file I/O.
+  static int32_t ReadHottestZone();
+
+  void OnTemperature(int32_t aMilliCelsius);
+  uint16_t ComputeTier(int32_t aMilliCelsius) const;
+  void SetTier(uint16_t aTier);
+
+  nsCOMPtr<nsITimer> mTimer;
+  uint16_t mTier;
+  bool mReadPending;
+};
+
+}  // namespace power
+}  // namespace dom
+}  // namespace mozilla
+
+#endif  // mozilla_dom_power_ThermalGovernor_h
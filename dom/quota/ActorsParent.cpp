@@ -424,6 +424,11 @@ nsresult CreateCacheTables(mozIStorageConnection& aConnection) {
   return NS_OK;
 }
 
+// The value of cache.valid for a cache written when temporary storage was
+// initialized and journaled since, rather than written at a clean shutdown.
+// Origins may have been removed since then, so they have to be checked.
+constexpr int32_t kCacheJournaled = 2;
+
 nsresult InvalidateCache(mozIStorageConnection& aConnection) {
   AssertIsOnIOThread();
 
@@ -861,6 +866,9 @@ class OriginInfo final {
   int64_t mAccessTime;
   bool mAccessed;
   bool mPersisted;
+  // Whether the cache has the origin marked as accessed, see
+  // QuotaManager::JournalOrigin.
+  bool mJournaled;
   /**
    * In some special cases like the LocalStorage client where it's possible to
    * create a Quota-using representation but not actually write any data, we
@@ -3219,7 +3227,8 @@ QuotaManager::QuotaManager(const nsAString& aBasePath,
       mTemporaryStorageUsage(0),
       mNextDirectoryLockId(0),
       mTemporaryStorageInitialized(false),
-      mCacheUsable(false) {
+      mCacheUsable(false),
+      mCacheJournaled(false) {
   AssertIsOnOwningThread();
   MOZ_ASSERT(!gInstance);
 }
@@ -3893,6 +3902,54 @@ int64_t QuotaManager::NoteOriginDirectoryCreated(
   return timestamp;
 }
 
+void QuotaManager::JournalOrigin(PersistenceType aPersistenceType,
+                                 const OriginMetadata& aOriginMetadata) {
+  AssertIsOnIOThread();
+  MOZ_ASSERT(aPersistenceType != PERSISTENCE_TYPE_PERSISTENT);
+
+  if (!mCacheJournaled) {
+    return;
+  }
+
+  MutexAutoLock lock(mQuotaMutex);
+
+  RefPtr<OriginInfo> originInfo =
+      LockedGetOriginInfo(aPersistenceType, aOriginMetadata);
+  if (!originInfo || originInfo->mJournaled ||
+      !originInfo->mDirectoryExists) {
+    return;
+  }
+
+  // The usage written here doesn't matter, accessed origins are scanned when
+  // the cache is loaded.
+  QM_TRY(([&]() -> Result<Ok, nsresult> {
+           QM_TRY_INSPECT(
+               const auto& stmt,
+               MOZ_TO_RESULT_INVOKE_TYPED(
+                   nsCOMPtr<mozIStorageStatement>, mStorageConnection,
+                   CreateStatement,
+                   "INSERT OR REPLACE INTO origin (repository_id, suffix, "
+                   "group_, origin, client_usages, usage, last_access_time, "
+                   "accessed, persisted) "
+                   "VALUES (:repository_id, :suffix, :group_, :origin, "
+                   ":client_usages, :usage, :last_access_time, :accessed, "
+                   ":persisted)"_ns));
+
+           QM_TRY(originInfo->LockedBindToStatement(stmt));
+           QM_TRY(stmt->BindInt32ByName("accessed"_ns, 1));
+           QM_TRY(stmt->Execute());
+
+           return Ok{};
+         }()),
+         QM_VOID, [this](const auto&) {
+           // Without the journal, the cache can't be trusted anymore.
+           mCacheJournaled = false;
+           QM_WARNONLY_TRY(InvalidateCache(*mStorageConnection));
+         });
+
+  originInfo->mJournaled = true;
+}
+
 void QuotaManager::DecreaseUsageForClient(const ClientMetadata& aClientMetadata,
                                           int64_t aSize) {
   MOZ_ASSERT(!NS_IsMainThread());
@@ -4041,6 +4098,8 @@ nsresult QuotaManager::LoadQuota() {
       MakeRefPtr<RecordQuotaInfoLoadTimeHelper>();
   recordQuotaInfoLoadTimeHelper->Start();
 
+  bool cacheJournaled = false;
+
   auto LoadQuotaFromCache = [&]() -> nsresult {
     QM_TRY_INSPECT(
         const auto& stmt,
@@ -4054,7 +4113,7 @@ nsresult QuotaManager::LoadQuota() {
     auto autoRemoveQuota = MakeScopeExit([&] { RemoveQuota(); });
 
     QM_TRY(quota::CollectWhileHasResult(
-        *stmt, [this](auto& stmt) -> Result<Ok, nsresult> {
+        *stmt, [this, cacheJournaled](auto& stmt) -> Result<Ok, nsresult> {
           QM_TRY_INSPECT(const int32_t& repositoryId,
                          MOZ_TO_RESULT_INVOKE(stmt, GetInt32, 0));
 
@@ -4107,6 +4166,21 @@ nsresult QuotaManager::LoadQuota() {
           QM_TRY_UNWRAP(fullOriginMetadata.mPersisted,
                         MOZ_TO_RESULT_INVOKE(stmt, GetInt32, 8));
 
+          if (cacheJournaled) {
+            QM_TRY_INSPECT(
+                const auto& directory,
+                GetDirectoryForOrigin(fullOriginMetadata.mPersistenceType,
+                                      fullOriginMetadata.mOrigin));
+
+            QM_TRY_INSPECT(const bool& exists,
+                           MOZ_TO_RESULT_INVOKE(directory, Exists));
+
+            // The origin was removed after the cache was written.
+            if (!exists) {
+              return Ok{};
+            }
+          }
+
           if (accessed) {
             QM_TRY_INSPECT(
                 const auto& directory,
@@ -4130,6 +4204,13 @@ nsresult QuotaManager::LoadQuota() {
             QM_TRY_INSPECT(const auto& metadata,
                            LoadFullOriginMetadataWithRestore(directory));
 
+            // The journal only records that the origin was accessed, the
+            // access time and the persisted flag may have changed since.
+            if (cacheJournaled) {
+              fullOriginMetadata.mLastAccessTime = metadata.mLastAccessTime;
+              fullOriginMetadata.mPersisted = metadata.mPersisted;
+            }
+
             QM_TRY(OkIf(fullOriginMetadata.mLastAccessTime ==
                         metadata.mLastAccessTime),
                    Err(NS_ERROR_FAILURE));
@@ -4167,7 +4248,8 @@ nsresult QuotaManager::LoadQuota() {
   };
 
   QM_TRY_INSPECT(
-      const bool& loadQuotaFromCache, ([this]() -> Result<bool, nsresult> {
+      const bool& loadQuotaFromCache,
+      ([this, &cacheJournaled]() -> Result<bool, nsresult> {
         if (mCacheUsable) {
           QM_TRY_INSPECT(
               const auto& stmt,
@@ -4181,6 +4263,8 @@ nsresult QuotaManager::LoadQuota() {
                          MOZ_TO_RESULT_INVOKE(stmt, GetInt32, 0));
 
           if (valid) {
+            cacheJournaled = valid == kCacheJournaled;
+
             if (!StaticPrefs::dom_quotaManager_caching_checkBuildId()) {
               return true;
             }
@@ -4331,6 +4415,74 @@ void QuotaManager::UnloadQuota() {
   QM_TRY(transaction.Commit(), QM_VOID);
 }
 
+nsresult QuotaManager::CheckpointCache() {
+  AssertIsOnIOThread();
+  MOZ_ASSERT(mStorageConnection);
+  MOZ_ASSERT(mTemporaryStorageInitialized);
+  MOZ_ASSERT(mCacheUsable);
+
+  mozStorageTransaction transaction(
+      mStorageConnection, false, mozIStorageConnection::TRANSACTION_IMMEDIATE);
+
+  QM_TRY(transaction.Start());
+
+  QM_TRY(mStorageConnection->ExecuteSimpleSQL("DELETE FROM origin;"_ns));
+
+  {
+    QM_TRY_INSPECT(
+        const auto& insertStmt,
+        MOZ_TO_RESULT_INVOKE_TYPED(
+            nsCOMPtr<mozIStorageStatement>, mStorageConnection,
+            CreateStatement,
+            "INSERT INTO origin (repository_id, suffix, group_, "
+            "origin, client_usages, usage, last_access_time, "
+            "accessed, persisted) "
+            "VALUES (:repository_id, :suffix, :group_, :origin, "
+            ":client_usages, :usage, :last_access_time, :accessed, "
+            ":persisted)"_ns));
+
+    MutexAutoLock lock(mQuotaMutex);
+
+    for (const auto& entry : mGroupInfoPairs) {
+      const auto& pair = entry.GetData();
+
+      for (const PersistenceType type : kBestEffortPersistenceTypes) {
+        RefPtr<GroupInfo> groupInfo = pair->LockedGetGroupInfo(type);
+        if (!groupInfo) {
+          continue;
+        }
+
+        for (const auto& originInfo : groupInfo->mOriginInfos) {
+          if (!originInfo->mDirectoryExists) {
+            continue;
+          }
+
+          MOZ_ALWAYS_SUCCEEDS(insertStmt->Reset());
+
+          QM_TRY(originInfo->LockedBindToStatement(insertStmt));
+
+          QM_TRY(insertStmt->Execute());
+
+          originInfo->mJournaled = originInfo->mAccessed;
+        }
+      }
+    }
+  }
+
+  QM_TRY_INSPECT(
+      const auto& stmt,
+      MOZ_TO_RESULT_INVOKE_TYPED(
+          nsCOMPtr<mozIStorageStatement>, mStorageConnection, CreateStatement,
+          "UPDATE cache SET valid = :valid, build_id = :buildId;"_ns));
+
+  QM_TRY(stmt->BindInt32ByName("valid"_ns, kCacheJournaled));
+  QM_TRY(stmt->BindUTF8StringByName("buildId"_ns, *gBuildId));
+  QM_TRY(stmt->Execute());
+  QM_TRY(transaction.Commit());
+
+  return NS_OK;
+}
+
 already_AddRefed<QuotaObject> QuotaManager::GetQuotaObject(
     PersistenceType aPersistenceType, const OriginMetadata& aOriginMetadata,
     Client::Type aClientType, nsIFile* aFile, int64_t aFileSize,
@@ -6166,6 +6318,8 @@ QuotaManager::EnsureTemporaryOriginIsInitialized(
                                       /* aPersisted */ false, aOriginMetadata));
     }
 
+    JournalOrigin(aPersistenceType, aOriginMetadata);
+
     // TODO: If the metadata file exists and we didn't call
     //       LoadFullOriginMetadataWithRestore for it (because the quota info
     //       was loaded from the cache), then the group in the metadata file
@@ -6245,7 +6399,15 @@ nsresult QuotaManager::EnsureTemporaryStorageIsInitialized() {
   CleanupTemporaryStorage();
 
   if (mCacheUsable) {
-    QM_TRY(InvalidateCache(*mStorageConnection));
+    mCacheJournaled =
+        StaticPrefs::dom_quotaManager_caching_journaled() && [this] {
+          QM_WARNONLY_TRY_UNWRAP(auto res, ToResult(CheckpointCache()));
+          return static_cast<bool>(res);
+        }();
+
+    if (!mCacheJournaled) {
+      QM_TRY(InvalidateCache(*mStorageConnection));
+    }
   }
 
   return NS_OK;
@@ -6272,6 +6434,7 @@ void QuotaManager::ShutdownStorage() {
 
     mStorageConnection = nullptr;
     mCacheUsable = false;
+    mCacheJournaled = false;
   }
 
   mInitializationInfo.ResetInitializationAttempts();
@@ -7109,6 +7272,7 @@ OriginInfo::OriginInfo(GroupInfo* aGroupInfo, const nsACString& aOrigin,
       mAccessTime(aAccessTime),
       mAccessed(false),
       mPersisted(aPersisted),
+      mJournaled(false),
       mDirectoryExists(aDirectoryExists) {
   MOZ_ASSERT(aGroupInfo);
   MOZ_ASSERT(aClientUsages.Length() == Client::TypeMax());
@@ -9030,6 +9194,7 @@ void ClearRequestBase::DeleteFiles(QuotaManager& aQuotaManager,
                      } else {
                        aQuotaManager.ResetUsageForClient(
                            ClientMetadata{metadata, mClientType.Value()});
+                       aQuotaManager.JournalOrigin(aPersistenceType, metadata);
                      }
                    }
 
@@ -9357,6 +9522,10 @@ nsresult PersistOp::DoDirectoryWork(QuotaManager& aQuotaManager) {
     }
   }
 
+  if (aQuotaManager.IsTemporaryStorageInitialized()) {
+    aQuotaManager.JournalOrigin(mPersistenceType.Value(), originMetadata);
+  }
+
   return NS_OK;
 }
 
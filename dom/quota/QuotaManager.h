@@ -168,6 +168,15 @@ class QuotaManager final : public BackgroundThreadObject {
   int64_t NoteOriginDirectoryCreated(const OriginMetadata& aOriginMetadata,
                                      bool aPersisted);
 
+  /**
+   * Marks the origin as accessed in the cache, once per session, so that it is
+   * scanned again if the cache is loaded after an unclean shutdown. Does
+   * nothing unless the cache is journaled, see
+   * dom.quotaManager.caching.journaled.
+   */
+  void JournalOrigin(PersistenceType aPersistenceType,
+                     const OriginMetadata& aOriginMetadata);
+
   // XXX clients can use QuotaObject instead of calling this method directly.
   void DecreaseUsageForClient(const ClientMetadata& aClientMetadata,
                               int64_t aSize);
@@ -193,6 +202,8 @@ class QuotaManager final : public BackgroundThreadObject {
 
   void UnloadQuota();
 
+  nsresult CheckpointCache();
+
   already_AddRefed<QuotaObject> GetQuotaObject(
       PersistenceType aPersistenceType, const OriginMetadata& aOriginMetadata,
       Client::Type aClientType, nsIFile* aFile, int64_t aFileSize = -1,
@@ -628,6 +639,7 @@ class QuotaManager final : public BackgroundThreadObject {
   int64_t mNextDirectoryLockId;
   bool mTemporaryStorageInitialized;
   bool mCacheUsable;
+  bool mCacheJournaled;
 };
 
 }  // namespace mozilla::dom::quota
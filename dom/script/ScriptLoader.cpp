@@ -2969,6 +2969,18 @@ nsresult ScriptLoader::FillCompileOptionsForRequest(
   return NS_OK;
 }
 
+#ifdef MOZ_B2G
+// Packaged apps are served by the api-daemon from http://<app>.localhost/.
+static bool IsPackagedAppURI(nsIURI* aURI) {
+  if (!aURI->SchemeIs("http") && !aURI->SchemeIs("https")) {
+    return false;
+  }
+  nsAutoCString host;
+  return NS_SUCCEEDED(aURI->GetHost(host)) &&
+         StringEndsWith(host, ".localhost"_ns);
+}
+#endif
+
 /* static */
 bool ScriptLoader::ShouldCacheBytecode(ScriptLoadRequest* aRequest) {
   using mozilla::TimeDuration;
@@ -2987,6 +2999,20 @@ bool ScriptLoader::ShouldCacheBytecode(ScriptLoadRequest* aRequest) {
   // when the bytecode cache is enabled.
   int32_t strategy = StaticPrefs::dom_script_loader_bytecode_cache_strategy();
 
+#ifdef MOZ_B2G
+  // The scripts of a packaged app only change when the app is updated, and
+  // the update replaces their cache entries along with the bytecode. So save
+  // the bytecode on the first launch rather than waiting to see the script
+  // a few times, and every launch after that skips the parse.
+  if (strategy == 0 &&
+      StaticPrefs::dom_script_loader_bytecode_cache_packaged_apps_eager() &&
+      IsPackagedAppURI(aRequest->mURI)) {
+    LOG(("ScriptLoadRequest (%p): Bytecode-cache: Packaged app script.",
+         aRequest));
+    strategy = -1;
+  }
+#endif
+
   // List of parameters used by the strategies.
   bool hasSourceLengthMin = false;
   bool hasFetchCountMin = false;
@@ -59,7 +59,9 @@
 #include "mozilla/ipc/PBackgroundSharedTypes.h"
 #include "mozilla/dom/ScriptLoader.h"
 #include "mozilla/PermissionManager.h"
+#include "mozilla/Preferences.h"
 #include "mozilla/ScopeExit.h"
+#include "mozilla/StaticPrefs_dom.h"
 #include "mozilla/StaticPrefs_extensions.h"
 #include "mozilla/Unused.h"
 #include "mozilla/EnumSet.h"
@@ -241,6 +243,17 @@ class TeardownRunnable final : public Runnable {
 };
 
 constexpr char kFinishShutdownTopic[] = "profile-before-change-qm";
+constexpr char kRegistrationsRestoredTopic[] = "b2g-sw-registration-done";
+
+// Prelaunching only needs the worker to be up; the outcome of the script
+// evaluation is reported the usual way if the worker fails to start.
+class PrelaunchCallback final : public LifeCycleEventCallback {
+ public:
+  void SetResult(bool aResult) override {}
+
+  NS_IMETHOD
+  Run() override { return NS_OK; }
+};
 
 already_AddRefed<nsIAsyncShutdownClient> GetAsyncShutdownBarrier() {
   AssertIsOnMainThread();
@@ -481,6 +494,13 @@ void ServiceWorkerManager::Init(ServiceWorkerRegistrar* aRegistrar) {
   }
 
   mActor = static_cast<ServiceWorkerManagerChild*>(actor);
+
+  if (StaticPrefs::dom_serviceWorkers_prelaunch_max()) {
+    nsCOMPtr<nsIObserverService> obs = mozilla::services::GetObserverService();
+    if (obs) {
+      obs->AddObserver(this, kRegistrationsRestoredTopic, false);
+    }
+  }
 }
 
 RefPtr<GenericErrorResultPromise> ServiceWorkerManager::StartControllingClient(
@@ -632,6 +652,7 @@ void ServiceWorkerManager::MaybeStartShutdown() {
 
   nsCOMPtr<nsIObserverService> obs = mozilla::services::GetObserverService();
   if (obs) {
+    obs->RemoveObserver(this, kRegistrationsRestoredTopic);
     obs->AddObserver(this, kFinishShutdownTopic, false);
     return;
   }
@@ -657,6 +678,47 @@ void ServiceWorkerManager::MaybeFinishShutdown() {
   mActor = nullptr;
 }
 
+void ServiceWorkerManager::PrelaunchWorkers() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (mShuttingDown) {
+    return;
+  }
+
+  nsAutoCString scopes;
+  Preferences::GetCString("dom.serviceWorkers.prelaunch.scopes", scopes);
+
+  uint32_t remaining = StaticPrefs::dom_serviceWorkers_prelaunch_max();
+  for (const nsACString& token : scopes.Split(',')) {
+    if (!remaining) {
+      break;
+    }
+
+    nsAutoCString scope(token);
+    scope.Trim(" \t");
+    if (scope.IsEmpty()) {
+      continue;
+    }
+
+    ServiceWorkerInfo* info =
+        GetActiveWorkerInfoForScope(OriginAttributes(), scope);
+    if (!info) {
+      continue;
+    }
+
+    --remaining;
+
+    ServiceWorkerPrivate* workerPrivate = info->WorkerPrivate();
+    if (workerPrivate->IsWorkerRunning()) {
+      continue;
+    }
+
+    RefPtr<LifeCycleEventCallback> callback = new PrelaunchCallback();
+    nsresult rv = workerPrivate->CheckScriptEvaluation(callback);
+    Unused << NS_WARN_IF(NS_FAILED(rv));
+  }
+}
+
 class ServiceWorkerResolveWindowPromiseOnRegisterCallback final
     : public ServiceWorkerJob::Callback {
  public:
@@ -1349,6 +1411,17 @@ nsresult ServiceWorkerManager::SendSystemMessageEvent(
       aMessageName, std::move(aMessageData), registration);
 }
 
+bool ServiceWorkerManager::IsWorkerRunningForScope(
+    const nsACString& aOriginAttributes, const nsACString& aScope) {
+  OriginAttributes attrs;
+  if (!attrs.PopulateFromSuffix(aOriginAttributes)) {
+    return false;
+  }
+
+  ServiceWorkerInfo* info = GetActiveWorkerInfoForScope(attrs, aScope);
+  return info && info->WorkerPrivate()->IsWorkerRunning();
+}
+
 nsresult ServiceWorkerManager::SendNotificationEvent(
     const nsAString& aEventName, const nsACString& aOriginSuffix,
     const nsACString& aScope, const nsAString& aID, const nsAString& aTitle,
@@ -3225,6 +3298,21 @@ ServiceWorkerManager::Observe(nsISupports* aSubject, const char* aTopic,
     return NS_OK;
   }
 
+  if (strcmp(aTopic, kRegistrationsRestoredTopic) == 0) {
+    nsCOMPtr<nsIObserverService> obs = mozilla::services::GetObserverService();
+    if (obs) {
+      obs->RemoveObserver(this, kRegistrationsRestoredTopic);
+    }
+
+    nsresult rv = NS_DispatchToCurrentThreadQueue(
+        NewRunnableMethod("dom::ServiceWorkerManager::PrelaunchWorkers", this,
+                          &ServiceWorkerManager::PrelaunchWorkers),
+        StaticPrefs::dom_serviceWorkers_prelaunch_idle_timeout(),
+        EventQueuePriority::Idle);
+    Unused << NS_WARN_IF(NS_FAILED(rv));
+    return NS_OK;
+  }
+
   MOZ_CRASH("Received message we aren't supposed to be registered for!");
   return NS_OK;
 }
@@ -247,6 +247,11 @@ class ServiceWorkerManager final : public nsIServiceWorkerManager,
       const nsAString& aMessageName,
       RefPtr<ServiceWorkerCloneData>&& aMessageData);
 
+  // Whether the active worker for aScope is already running, so that an
+  // event sent to it won't start it (and possibly a process for it).
+  bool IsWorkerRunningForScope(const nsACString& aOriginAttributes,
+                               const nsACString& aScope);
+
   nsresult NotifyUnregister(nsIPrincipal* aPrincipal, const nsAString& aScope);
 
   void WorkerIsIdle(ServiceWorkerInfo* aWorker);
@@ -300,6 +305,11 @@ class ServiceWorkerManager final : public nsIServiceWorkerManager,
 
   void MaybeFinishShutdown();
 
+  // Starts the active workers of the scopes listed in
+  // dom.serviceWorkers.prelaunch.scopes so the first event they receive does
+  // not pay for spawning the worker and evaluating its script.
+  void PrelaunchWorkers();
+
   already_AddRefed<ServiceWorkerJobQueue> GetOrCreateJobQueue(
       const nsACString& aOriginSuffix, const nsACString& aScope);
 
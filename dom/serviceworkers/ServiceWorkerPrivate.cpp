@@ -2089,6 +2089,14 @@ bool ServiceWorkerPrivate::IsIdle() const {
   return mTokenCount == 0 || (mTokenCount == 1 && mIdleKeepAliveToken);
 }
 
+bool ServiceWorkerPrivate::IsWorkerRunning() const {
+  MOZ_ASSERT(NS_IsMainThread());
+  if (mInner) {
+    return !mInner->WorkerIsDead();
+  }
+  return !!mWorkerPrivate;
+}
+
 RefPtr<GenericPromise> ServiceWorkerPrivate::GetIdlePromise() {
 #ifdef DEBUG
   MOZ_ASSERT(NS_IsMainThread());
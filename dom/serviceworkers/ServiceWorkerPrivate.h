@@ -218,6 +218,10 @@ class ServiceWorkerPrivate final {
 
   bool IsIdle() const;
 
+  // Whether a worker is running or being spawned for this service worker,
+  // i.e. whether an event sent now won't have to start it.
+  bool IsWorkerRunning() const;
+
   // This promise is used schedule clearing of the owning registrations and its
   // associated Service Workers if that registration becomes "unreachable" by
   // the ServiceWorkerManager. This occurs under two conditions, which are the
@@ -26,6 +26,7 @@
 #include "mozilla/Result.h"
 #include "mozilla/ResultExtensions.h"
 #include "mozilla/SpinEventLoopUntil.h"
+#include "mozilla/StaticPrefs_dom.h"
 #include "mozilla/StaticPtr.h"
 #include "mozilla/Unused.h"
 #include "mozilla/Variant.h"
@@ -59,6 +60,7 @@
 #include "nsISeekableStream.h"
 #include "nsISupports.h"
 #include "nsIThread.h"
+#include "nsITimer.h"
 #include "nsLiteralString.h"
 #include "nsString.h"
 #include "nsStringFwd.h"
@@ -95,6 +97,58 @@ const uint32_t kCopyBufferSize = 32768;
 
 constexpr auto kSDBSuffix = u".sdb"_ns;
 
+/*******************************************************************************
+ * Write-behind
+ ******************************************************************************/
+
+// Keeps small writes in memory for up to dom.simpledb.write_behind.delay_ms
+// and then writes those of every connection out in one pass, so that apps
+// doing many small writes cause a few larger ones. Connections only run one
+// request at a time, so consecutive writes of a connection are contiguous
+// and can be appended to each other. Every other request and closing the
+// stream write out the pending data first.
+//
+// A write that fails in the background is reported by the next request of
+// its connection, like a deferred error from close().
+//
+// Only used on the QuotaManager IO thread.
+class WriteBehind final {
+  struct Entry {
+    nsCOMPtr<nsIFileStream> mFileStream;
+    int64_t mOffset;
+    nsCString mData;
+    nsresult mResult;
+  };
+
+  nsTArray<Entry> mEntries;
+  nsCOMPtr<nsITimer> mTimer;
+
+  static StaticAutoPtr<WriteBehind> sInstance;
+
+ public:
+  static bool Enabled(uint64_t aSize) {
+    return StaticPrefs::dom_simpledb_write_behind_delay_ms() &&
+           aSize <= StaticPrefs::dom_simpledb_write_behind_max_size();
+  }
+
+  // Appends aData at the current position of aFileStream.
+  static nsresult Append(nsIFileStream* aFileStream, const nsACString& aData);
+
+  // Writes out the pending data of aFileStream, if any.
+  static nsresult Flush(nsIFileStream* aFileStream);
+
+ private:
+  Entry* Find(nsIFileStream* aFileStream);
+
+  void Remove(nsIFileStream* aFileStream);
+
+  static nsresult Write(Entry& aEntry);
+
+  static void FlushAll(nsITimer* aTimer, void* aClosure);
+};
+
+StaticAutoPtr<WriteBehind> WriteBehind::sInstance;
+
 /*******************************************************************************
  * Actor class declarations
  ******************************************************************************/
@@ -300,6 +354,9 @@ class ConnectionOperationBase : public Runnable,
   // A method that subclasses may implement.
   virtual void OnSuccess();
 
+  // Whether DoDatabaseWork() may leave its data in WriteBehind.
+  virtual bool MayWriteBehind() const { return false; }
+
  private:
   NS_IMETHOD
   Run() override;
@@ -432,6 +489,8 @@ class WriteOp final : public ConnectionOperationBase {
 
   uint64_t mSize;
 
+  bool mWriteBehind;
+
  public:
   WriteOp(Connection* aConnection, const SDBRequestParams& aParams);
 
@@ -442,6 +501,8 @@ class WriteOp final : public ConnectionOperationBase {
 
   nsresult DoDatabaseWork(nsIFileStream* aFileStream) override;
 
+  bool MayWriteBehind() const override { return mWriteBehind; }
+
   void GetResponse(SDBRequestResponse& aResponse) override;
 };
 
@@ -622,6 +683,160 @@ already_AddRefed<mozilla::dom::quota::Client> CreateQuotaClient() {
 
 }  // namespace simpledb
 
+/*******************************************************************************
+ * WriteBehind
+ ******************************************************************************/
+
+// static
+nsresult WriteBehind::Append(nsIFileStream* aFileStream,
+                             const nsACString& aData) {
+  AssertIsOnIOThread();
+  MOZ_ASSERT(aFileStream);
+
+  if (!sInstance) {
+    sInstance = new WriteBehind();
+  }
+
+  Entry* entry = sInstance->Find(aFileStream);
+  if (entry && (NS_FAILED(entry->mResult) ||
+                entry->mData.Length() + aData.Length() >
+                    StaticPrefs::dom_simpledb_write_behind_max_size())) {
+    QM_TRY(Flush(aFileStream));
+    entry = nullptr;
+
+    // Flushing the last entry deleted the instance.
+    if (!sInstance) {
+      sInstance = new WriteBehind();
+    }
+  }
+
+  if (!entry) {
+    nsCOMPtr<nsISeekableStream> seekableStream =
+        do_QueryInterface(aFileStream);
+    MOZ_ASSERT(seekableStream);
+
+    int64_t offset;
+    QM_TRY(seekableStream->Tell(&offset));
+
+    entry = sInstance->mEntries.AppendElement(
+        Entry{aFileStream, offset, nsCString(), NS_OK});
+  }
+
+  if (NS_WARN_IF(!entry->mData.Append(aData, fallible))) {
+    Unused << Flush(aFileStream);
+    return NS_ERROR_OUT_OF_MEMORY;
+  }
+
+  if (!sInstance->mTimer) {
+    QM_TRY(NS_NewTimerWithFuncCallback(
+        getter_AddRefs(sInstance->mTimer), FlushAll, nullptr,
+        StaticPrefs::dom_simpledb_write_behind_delay_ms(),
+        nsITimer::TYPE_ONE_SHOT, "dom::WriteBehind::FlushAll",
+        GetCurrentEventTarget()));
+  }
+
+  return NS_OK;
+}
+
+// static
+nsresult WriteBehind::Flush(nsIFileStream* aFileStream) {
+  AssertIsOnIOThread();
+  MOZ_ASSERT(aFileStream);
+
+  if (!sInstance) {
+    return NS_OK;
+  }
+
+  Entry* entry = sInstance->Find(aFileStream);
+  if (!entry) {
+    return NS_OK;
+  }
+
+  nsresult rv = NS_SUCCEEDED(entry->mResult) ? Write(*entry) : entry->mResult;
+  sInstance->Remove(aFileStream);
+  return rv;
+}
+
+WriteBehind::Entry* WriteBehind::Find(nsIFileStream* aFileStream) {
+  for (auto& entry : mEntries) {
+    if (entry.mFileStream == aFileStream) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void WriteBehind::Remove(nsIFileStream* aFileStream) {
+  mEntries.RemoveElementsBy([aFileStream](const Entry& aEntry) {
+    return aEntry.mFileStream == aFileStream;
+  });
+
+  if (mEntries.IsEmpty()) {
+    if (mTimer) {
+      mTimer->Cancel();
+    }
+    // Deletes this.
+    sInstance = nullptr;
+  }
+}
+
+// static
+nsresult WriteBehind::Write(Entry& aEntry) {
+  nsCOMPtr<nsISeekableStream> seekableStream =
+      do_QueryInterface(aEntry.mFileStream);
+  MOZ_ASSERT(seekableStream);
+
+  nsCOMPtr<nsIOutputStream> outputStream =
+      do_QueryInterface(aEntry.mFileStream);
+  MOZ_ASSERT(outputStream);
+
+  QM_TRY(seekableStream->Seek(nsISeekableStream::NS_SEEK_SET, aEntry.mOffset));
+
+  const char* data = aEntry.mData.BeginReading();
+  uint32_t remaining = aEntry.mData.Length();
+  while (remaining) {
+    uint32_t numWrite;
+    QM_TRY(outputStream->Write(data, remaining, &numWrite));
+    QM_TRY(OkIf(numWrite), NS_ERROR_FAILURE);
+
+    data += numWrite;
+    remaining -= numWrite;
+  }
+
+  return NS_OK;
+}
+
+// static
+void WriteBehind::FlushAll(nsITimer* aTimer, void* aClosure) {
+  AssertIsOnIOThread();
+
+  if (!sInstance) {
+    return;
+  }
+
+  sInstance->mTimer = nullptr;
+
+  // Failed entries stay around until their connection runs its next
+  // request, to report the error.
+  bool failed = false;
+  for (auto& entry : sInstance->mEntries) {
+    if (NS_SUCCEEDED(entry.mResult)) {
+      entry.mResult = Write(entry);
+      entry.mData.Truncate();
+      failed |= NS_FAILED(entry.mResult);
+    }
+  }
+
+  if (!failed) {
+    sInstance->mEntries.Clear();
+    sInstance = nullptr;
+    return;
+  }
+
+  sInstance->mEntries.RemoveElementsBy(
+      [](const Entry& aEntry) { return NS_SUCCEEDED(aEntry.mResult); });
+}
+
 /*******************************************************************************
  * StreamHelper
  ******************************************************************************/
@@ -670,7 +885,10 @@ void StreamHelper::RunOnIOThread() {
   nsCOMPtr<nsIInputStream> inputStream = do_QueryInterface(mFileStream);
   MOZ_ASSERT(inputStream);
 
-  nsresult rv = inputStream->Close();
+  nsresult rv = WriteBehind::Flush(mFileStream);
+  Unused << NS_WARN_IF(NS_FAILED(rv));
+
+  rv = inputStream->Close();
   Unused << NS_WARN_IF(NS_FAILED(rv));
 
   MOZ_ALWAYS_SUCCEEDS(mOwningEventTarget->Dispatch(this, NS_DISPATCH_NORMAL));
@@ -1045,7 +1263,12 @@ void ConnectionOperationBase::DatabaseWork() {
     nsIFileStream* fileStream = mConnection->GetFileStream();
     MOZ_ASSERT(fileStream);
 
-    nsresult rv = DoDatabaseWork(fileStream);
+    // Writes that may stay in memory take care of the pending data
+    // themselves.
+    nsresult rv = MayWriteBehind() ? NS_OK : WriteBehind::Flush(fileStream);
+    if (NS_SUCCEEDED(rv)) {
+      rv = DoDatabaseWork(fileStream);
+    }
     if (NS_FAILED(rv)) {
       mResultCode = rv;
     }
@@ -1588,7 +1811,8 @@ void ReadOp::GetResponse(SDBRequestResponse& aResponse) {
 WriteOp::WriteOp(Connection* aConnection, const SDBRequestParams& aParams)
     : ConnectionOperationBase(aConnection),
       mParams(aParams.get_SDBRequestWriteParams()),
-      mSize(0) {
+      mSize(0),
+      mWriteBehind(false) {
   MOZ_ASSERT(aParams.type() == SDBRequestParams::TSDBRequestWriteParams);
 }
 
@@ -1609,6 +1833,7 @@ bool WriteOp::Init() {
 
   mInputStream = std::move(inputStream);
   mSize = string.Length();
+  mWriteBehind = WriteBehind::Enabled(mSize);
 
   return true;
 }
@@ -1617,6 +1842,11 @@ nsresult WriteOp::DoDatabaseWork(nsIFileStream* aFileStream) {
   AssertIsOnIOThread();
   MOZ_ASSERT(aFileStream);
 
+  if (MayWriteBehind()) {
+    MOZ_ALWAYS_SUCCEEDS(mInputStream->Close());
+    return WriteBehind::Append(aFileStream, mParams.data());
+  }
+
   nsCOMPtr<nsIOutputStream> outputStream = do_QueryInterface(aFileStream);
   MOZ_ASSERT(outputStream);
 
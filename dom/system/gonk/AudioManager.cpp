@@ -1049,6 +1049,23 @@ already_AddRefed<AudioManager> AudioManager::GetInstance() {
   return audioMgr.forget();
 }
 
+/* static */
+void AudioManager::NotifyVoiceCallStarted() {
+  // The audio policy service ignores a mode it is already in, so this is
+  // harmless if the telephony service got there first.
+  AudioSystem::setPhoneState(AUDIO_MODE_IN_CALL);
+
+  // Bring mPhoneState and its observers up to date. This is queued ahead of
+  // the call state result the telephony service acts on, so it can't undo a
+  // later change back to normal.
+  NS_DispatchToMainThread(
+      NS_NewRunnableFunction("AudioManager::NotifyVoiceCallStarted", []() {
+        if (sAudioManager) {
+          sAudioManager->SetPhoneState(nsIAudioManager::PHONE_STATE_IN_CALL);
+        }
+      }));
+}
+
 NS_IMETHODIMP
 AudioManager::GetMicrophoneMuted(bool* aMicrophoneMuted) {
 #ifdef MOZ_B2G_RIL
@@ -53,6 +53,11 @@ class AudioManager final : public nsIAudioManager, public nsIObserver {
   // Validate whether the volume index is within the range
   nsresult ValidateVolumeIndex(int32_t aStream, uint32_t aIndex) const;
 
+  // Called by the RIL worker, on a binder thread, when the modem first reports
+  // a voice call in progress. Audio is switched to the call right away rather
+  // than once the telephony service gets to it on the main thread.
+  static void NotifyVoiceCallStarted();
+
   // Called when android AudioFlinger in mediaserver is died
   void HandleAudioFlingerDied();
 
@@ -1089,14 +1089,16 @@ void AutoMounter::UpdateState() {
                    // completes
         }
         case nsIVolume::STATE_IDLE: {
-          if (!vol->IsUnmountRequested()) {
+          if (!vol->IsUnmountRequested() && !vol->IsMountPending()) {
             // Volume is unmounted and mount-requested, try to mount.
 
             LOG("UpdateState: Mounting %s", vol->NameStr());
             vol->StartMount();
           }
-          return;  // UpdateState will be called again when Mount command
-                   // completes
+          // Mounts run in the background, so carry on with the other
+          // volumes rather than waiting for this one. UpdateState will be
+          // called again as each mount completes.
+          break;
         }
         default: {
           // Not in a state that we can do anything about.
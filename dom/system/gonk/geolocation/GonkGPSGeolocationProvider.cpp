@@ -21,6 +21,7 @@
 #include "mozilla/dom/GeolocationPosition.h"
 #include "mozilla/Preferences.h"
 #include "mozilla/Services.h"
+#include "mozilla/TimeStamp.h"
 #include "nsComponentManagerUtils.h"
 #include "nsIRunnable.h"
 #include "nsThreadUtils.h"
@@ -138,6 +139,11 @@ struct GnssVisibilityControlCallback : public IGnssVisibilityControlCallback {
 static android::sp<IGnssVisibilityControlCallback> gnssVcCbIface = nullptr;
 
 static const int kDefaultPeriod = 1000;  // ms
+// Used unless somebody asks for high accuracy.
+static const int kLowAccuracyPeriod = 10000;  // ms
+// Below this, restarting the engine for every fix costs more than leaving it
+// running.
+static const int kMinPausePeriod = 5000;  // ms
 
 static bool gGeolocationEnabled = false;
 static bool gDebug_isLoggingEnabled = false;
@@ -479,6 +485,7 @@ GonkGPSGeolocationProvider::Shutdown() {
   }
 
   mStarted = false;
+  CancelPauseGPS();
 
   if (mNetworkLocationProvider) {
     mNetworkLocationProvider->Shutdown();
@@ -505,6 +512,12 @@ GonkGPSGeolocationProvider::Watch(nsIGeolocationUpdate* aCallback) {
 NS_IMETHODIMP
 GonkGPSGeolocationProvider::SetHighAccuracy(bool enableHighAccuracy) {
   if (mEnableHighAccuracy != enableHighAccuracy) {
+    if (enableHighAccuracy && mPauseTimer) {
+      // Don't wait for the end of the pause.
+      mEnableHighAccuracy = enableHighAccuracy;
+      StartGPS();
+      return NS_OK;
+    }
     SetPositionMode(enableHighAccuracy);
   }
 
@@ -636,6 +649,8 @@ void GonkGPSGeolocationProvider::StartGPS() {
   MOZ_ASSERT(NS_IsMainThread());
   LOG("Starts GPS");
 
+  CancelPauseGPS();
+
 #ifdef MOZ_B2G_RIL
   SetupAGPS();
 #endif
@@ -668,6 +683,52 @@ void GonkGPSGeolocationProvider::ShutdownGPS() {
   }
 }
 
+void GonkGPSGeolocationProvider::MaybePauseGPS() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (!mStarted || mEnableHighAccuracy || mSupportsScheduling || mPauseTimer ||
+      mGnssHal == nullptr) {
+    return;
+  }
+
+  int32_t period = GetUpdatePeriod(false);
+  if (period < kMinPausePeriod) {
+    return;
+  }
+
+  DBG("mGnssHal->stop for %d ms", period);
+  auto result = mGnssHal->stop();
+  if (!result.isOk() || !result) {
+    ERR("failed to stop IGnss HAL");
+    return;
+  }
+
+  RefPtr<GonkGPSGeolocationProvider> self = this;
+  nsresult rv = NS_NewTimerWithCallback(
+      getter_AddRefs(mPauseTimer),
+      [self](nsITimer*) {
+        self->mPauseTimer = nullptr;
+        if (self->mStarted && self->mGnssHalReady) {
+          self->StartGPS();
+        }
+      },
+      period, nsITimer::TYPE_ONE_SHOT, "GonkGPSGeolocationProvider::PauseGPS");
+  if (NS_FAILED(rv)) {
+    ERR("failed to schedule GPS restart");
+    mPauseTimer = nullptr;
+    StartGPS();
+  }
+}
+
+void GonkGPSGeolocationProvider::CancelPauseGPS() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (mPauseTimer) {
+    mPauseTimer->Cancel();
+    mPauseTimer = nullptr;
+  }
+}
+
 void GonkGPSGeolocationProvider::InjectLocation(double latitude,
                                                 double longitude,
                                                 float accuracy) {
@@ -690,8 +751,9 @@ bool GonkGPSGeolocationProvider::SetPositionMode(bool enableHighAccuracy) {
     return false;
   }
 
-  int32_t update = Preferences::GetInt("geo.default.update", kDefaultPeriod);
+  int32_t update = GetUpdatePeriod(enableHighAccuracy);
   if (!mSupportsScheduling) {
+    // Longer periods are implemented by MaybePauseGPS() instead.
     update = kDefaultPeriod;
   }
 
@@ -706,8 +768,8 @@ bool GonkGPSGeolocationProvider::SetPositionMode(bool enableHighAccuracy) {
     result = mGnssHal_V1_1->setPositionMode_1_1(
         positionMode, IGnss_V1_1::GnssPositionRecurrence::RECURRENCE_PERIODIC,
         update, preferredAccuracy,
-        0,       // preferred time
-        false);  // low power mode
+        0,                     // preferred time
+        !enableHighAccuracy);  // low power mode
   } else if (mGnssHal != nullptr) {
     auto positionMode = mSupportsMSB ? IGnss_V1_1::GnssPositionMode::MS_BASED
                                      : IGnss_V1_1::GnssPositionMode::STANDALONE;
@@ -725,6 +787,18 @@ bool GonkGPSGeolocationProvider::SetPositionMode(bool enableHighAccuracy) {
   return true;
 }
 
+int32_t GonkGPSGeolocationProvider::GetUpdatePeriod(bool enableHighAccuracy) {
+  int32_t update = Preferences::GetInt("geo.default.update", kDefaultPeriod);
+  if (!enableHighAccuracy) {
+    // Nobody needs real-time tracking, so fix less often and let the
+    // chipset duty-cycle the receiver in between.
+    update = std::max(update,
+                      Preferences::GetInt("geo.gonk.low_accuracy_update",
+                                          kLowAccuracyPeriod));
+  }
+  return update;
+}
+
 class GonkGPSGeolocationProvider::UpdateLocationEvent final
     : public mozilla::Runnable {
  public:
@@ -738,6 +812,7 @@ class GonkGPSGeolocationProvider::UpdateLocationEvent final
     if (callback) {
       callback->Update(mPosition);
     }
+    provider->MaybePauseGPS();
     return NS_OK;
   }
 
@@ -771,6 +846,35 @@ class GonkGPSGeolocationProvider::UpdateCapabilitiesEvent final
   uint32_t mCapabilities;
 };
 
+#ifdef MOZ_B2G_RIL
+// Tells NetworkTimeService how far the system clock is from the UTC time of
+// a fix, so that it doesn't need SNTP meanwhile. At most once a minute, as
+// fixes come every second while navigating.
+static void NotifyGnssTimeOffset(int64_t aUtcTimeMs) {
+  static const double kNotificationInterval_s = 60;
+  static TimeStamp sLastNotification;
+
+  TimeStamp now = TimeStamp::Now();
+  if (aUtcTimeMs <= 0 ||
+      (!sLastNotification.IsNull() &&
+       (now - sLastNotification).ToSeconds() < kNotificationInterval_s)) {
+    return;
+  }
+  sLastNotification = now;
+
+  int64_t offset = aUtcTimeMs - PR_Now() / PR_USEC_PER_MSEC;
+  NS_DispatchToMainThread(
+      NS_NewRunnableFunction("NotifyGnssTimeOffset", [offset]() {
+        nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+        if (obs) {
+          nsAutoString data;
+          data.AppendInt(offset);
+          obs->NotifyObservers(nullptr, "gnss-time-offset", data.get());
+        }
+      }));
+}
+#endif
+
 Return<void> GnssCallback::gnssLocationCb(const GnssLocation_V1_0& location) {
   if (gDebug_isGPSLocationIgnored) {
     LOG("gnssLocationCb is ignored due to the developer setting");
@@ -783,6 +887,10 @@ Return<void> GnssCallback::gnssLocationCb(const GnssLocation_V1_0& location) {
     return Void();
   }
 
+#ifdef MOZ_B2G_RIL
+  NotifyGnssTimeOffset(location.timestamp);
+#endif
+
   RefPtr<nsGeoPosition> somewhere = new nsGeoPosition(
       location.latitudeDegrees, location.longitudeDegrees,
       location.altitudeMeters, location.horizontalAccuracyMeters,
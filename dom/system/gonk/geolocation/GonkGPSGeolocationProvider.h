@@ -28,6 +28,7 @@
 #include "nsIDOMGeoPosition.h"
 #include "nsIGeolocationProvider.h"
 #include "nsISettings.h"
+#include "nsITimer.h"
 #ifdef MOZ_B2G_RIL
 #  include "nsIObserver.h"
 #  include "nsIRadioInterfaceLayer.h"
@@ -99,10 +100,16 @@ class GonkGPSGeolocationProvider : public nsIGeolocationProvider,
   void CleanupGnssHal();
   void StartGPS();
   void ShutdownGPS();
+  // Stops the engine until the next fix is due, if nobody needs real-time
+  // tracking and the engine can't schedule fixes by itself.
+  void MaybePauseGPS();
+  void CancelPauseGPS();
 
   void InjectLocation(double latitude, double longitude, float accuracy);
   // Set the GnssPositionMode to HAL, return true on success.
   bool SetPositionMode(bool enableHighAccuracy);
+  // Interval in ms between fixes for the given accuracy.
+  int32_t GetUpdatePeriod(bool enableHighAccuracy);
 
   NS_IMETHOD HandleSettings(nsISettingInfo* const info, bool isObserved);
 
@@ -205,6 +212,8 @@ class GonkGPSGeolocationProvider : public nsIGeolocationProvider,
   uint16_t mActiveCapabilities;
 #endif
   bool mEnableHighAccuracy;
+  // Pending while the engine is stopped between two duty-cycled fixes.
+  nsCOMPtr<nsITimer> mPauseTimer;
 
   struct GnssDeathRecipient
       : virtual public android::hardware::hidl_death_recipient {
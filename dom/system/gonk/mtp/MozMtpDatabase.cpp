@@ -11,6 +11,7 @@
 #include "DeviceStorage.h"
 #include "mozilla/ArrayUtils.h"
 #include "mozilla/AutoRestore.h"
+#include "mozilla/Maybe.h"
 #include "mozilla/Scoped.h"
 #include "mozilla/Services.h"
 #include "nsIFile.h"
@@ -108,6 +109,7 @@ MozMtpDatabase::MozMtpDatabase()
     : mMutex("MozMtpDatabase::mMutex"),
       mDb(mMutex),
       mStorage(mMutex),
+      mEventCoalescer(new MozMtpEventCoalescer()),
       mBeginSendObjectCalled(false),
       mMtpConnectedStatus(true) {
   MOZ_ASSERT(MessageLoop::current() == XRE_GetIOMessageLoop());
@@ -128,11 +130,18 @@ MozMtpDatabase::~MozMtpDatabase() {
 
 void MozMtpDatabase::AddEntry(DbEntry* entry) {
   MutexAutoLock lock(mMutex);
+  AddEntryLocked(entry);
+}
 
+void MozMtpDatabase::AddEntryLocked(DbEntry* entry) {
   entry->mHandle = GetNextHandle();
   MOZ_ASSERT(mDb.Length() == entry->mHandle);
   mDb.AppendElement(entry);
 
+  // Handles only ever grow, so appending keeps the child list sorted.
+  mChildren.LookupOrInsert(entry->mParent).AppendElement(entry->mHandle);
+  mPathIndex.InsertOrUpdate(entry->mPath, entry->mHandle);
+
   MTP_DBG("Handle: 0x%08x Parent: 0x%08x Path:'%s'", entry->mHandle,
           entry->mParent, entry->mPath.get());
 }
@@ -140,13 +149,12 @@ void MozMtpDatabase::AddEntry(DbEntry* entry) {
 void MozMtpDatabase::AddEntryAndNotify(DbEntry* entry,
                                        RefCountedMtpServer* aMtpServer) {
   AddEntry(entry);
-  aMtpServer->sendObjectAdded(entry->mHandle);
+  mEventCoalescer->ObjectAdded(aMtpServer, entry->mHandle, entry->mParent);
 }
 
 void MozMtpDatabase::AddEntryAndNotify(DbEntry* entry) {
-  AddEntry(entry);
   RefPtr<RefCountedMtpServer> server = sMozMtpServer->GetMtpServer();
-  server->sendObjectAdded(entry->mHandle);
+  AddEntryAndNotify(entry, server);
 }
 
 void MozMtpDatabase::DumpEntries(const char* aLabel) {
@@ -171,16 +179,7 @@ void MozMtpDatabase::DumpEntries(const char* aLabel) {
 
 MtpObjectHandle MozMtpDatabase::FindEntryByPath(const nsACString& aPath) {
   MutexAutoLock lock(mMutex);
-
-  ProtectedDbArray::size_type numEntries = mDb.Length();
-  ProtectedDbArray::index_type entryIndex;
-  for (entryIndex = 1; entryIndex < numEntries; entryIndex++) {
-    RefPtr<DbEntry> entry = mDb[entryIndex];
-    if (entry && entry->mPath.Equals(aPath)) {
-      return entryIndex;
-    }
-  }
-  return 0;
+  return mPathIndex.Get(aPath);
 }
 
 already_AddRefed<MozMtpDatabase::DbEntry> MozMtpDatabase::GetEntry(
@@ -197,52 +196,82 @@ already_AddRefed<MozMtpDatabase::DbEntry> MozMtpDatabase::GetEntry(
 
 void MozMtpDatabase::RemoveEntry(MtpObjectHandle aHandle) {
   MutexAutoLock lock(mMutex);
+  RemoveEntryLocked(aHandle);
+}
+
+void MozMtpDatabase::RemoveEntryLocked(MtpObjectHandle aHandle) {
   if (!IsValidHandle(aHandle)) {
     return;
   }
 
   RefPtr<DbEntry> removedEntry = mDb[aHandle];
   mDb[aHandle] = nullptr;
-  MTP_DBG("0x%08x removed", aHandle);
-  // if the entry is not a folder, just return.
-  if (removedEntry && (removedEntry->mObjectFormat != MTP_FORMAT_ASSOCIATION)) {
+  if (!removedEntry) {
     return;
   }
+  MTP_DBG("0x%08x removed", aHandle);
 
-  // Find out and remove the children of aHandle.
-  // Since the index for a directory will always be less than the index of any
-  // of its children, we can remove the entire subtree in one pass.
-  ProtectedDbArray::size_type numEntries = mDb.Length();
-  ProtectedDbArray::index_type entryIndex;
-  for (entryIndex = aHandle + 1; entryIndex < numEntries; entryIndex++) {
-    RefPtr<DbEntry> entry = mDb[entryIndex];
-    if (entry && IsValidHandle(entry->mParent) && !mDb[entry->mParent]) {
-      MTP_DBG(
-          "Parent 0x%08x removed, child removing,  path: %s, child handle: "
-          "0x%08x",
-          aHandle, entry->mPath.get(), entry->mHandle);
-      mDb[entryIndex] = nullptr;
+  if (auto siblings = mChildren.Lookup(removedEntry->mParent)) {
+    siblings->RemoveElementSorted(aHandle);
+  }
+  if (mPathIndex.Get(removedEntry->mPath) == aHandle) {
+    mPathIndex.Remove(removedEntry->mPath);
+  }
+
+  // Remove the whole subtree along with a folder.
+  Maybe<nsTArray<MtpObjectHandle>> children = mChildren.Extract(aHandle);
+  if (children) {
+    for (MtpObjectHandle child : *children) {
+      MTP_DBG("Parent 0x%08x removed, child removing, child handle: 0x%08x",
+              aHandle, child);
+      RemoveEntryLocked(child);
     }
   }
 }
 
+void MozMtpDatabase::SetEntryPath(DbEntry* aEntry, const nsACString& aPath) {
+  MutexAutoLock lock(mMutex);
+
+  if (mPathIndex.Get(aEntry->mPath) == aEntry->mHandle) {
+    mPathIndex.Remove(aEntry->mPath);
+  }
+  aEntry->mPath = aPath;
+  mPathIndex.InsertOrUpdate(aEntry->mPath, aEntry->mHandle);
+}
+
+void MozMtpDatabase::SetEntryParent(DbEntry* aEntry, MtpObjectHandle aParent) {
+  MutexAutoLock lock(mMutex);
+
+  if (aEntry->mParent == aParent) {
+    return;
+  }
+  if (auto siblings = mChildren.Lookup(aEntry->mParent)) {
+    siblings->RemoveElementSorted(aEntry->mHandle);
+  }
+  aEntry->mParent = aParent;
+  mChildren.LookupOrInsert(aParent).InsertElementSorted(aEntry->mHandle);
+}
+
 void MozMtpDatabase::RemoveEntryAndNotify(MtpObjectHandle aHandle,
                                           RefCountedMtpServer* aMtpServer) {
+  RefPtr<DbEntry> entry = GetEntry(aHandle);
+  MtpObjectHandle parent = entry ? entry->mParent : MTP_PARENT_ROOT;
   RemoveEntry(aHandle);
-  aMtpServer->sendObjectRemoved(aHandle);
+  mEventCoalescer->ObjectRemoved(aMtpServer, aHandle, parent);
 }
 
 void MozMtpDatabase::RemoveEntryAndNotify(MtpObjectHandle aHandle) {
-  RemoveEntry(aHandle);
   RefPtr<RefCountedMtpServer> server = sMozMtpServer->GetMtpServer();
-  server->sendObjectRemoved(aHandle);
+  RemoveEntryAndNotify(aHandle, server);
 }
 
 void MozMtpDatabase::UpdateEntryAndNotify(MtpObjectHandle aHandle,
                                           DeviceStorageFile* aFile,
                                           RefCountedMtpServer* aMtpServer) {
   UpdateEntry(aHandle, aFile);
-  aMtpServer->sendObjectAdded(aHandle);
+  RefPtr<DbEntry> entry = GetEntry(aHandle);
+  mEventCoalescer->ObjectChanged(aMtpServer, aHandle,
+                                 entry ? entry->mParent : MTP_PARENT_ROOT);
 }
 
 void MozMtpDatabase::UpdateEntry(MtpObjectHandle aHandle,
@@ -454,7 +483,12 @@ void MozMtpDatabase::CreateEntryForFileAndNotify(
     if (doFind) {
       MtpObjectHandle entryHandle = FindEntryByPath(component);
       if (entryHandle != 0) {
-        // We found an entry.
+        // We found an entry. If it's a directory we haven't listed yet, do
+        // so now, so that we don't add a second entry for something that's
+        // already on disk.
+        if (slash != kNotFound) {
+          EnsureChildrenLoaded(entryHandle);
+        }
         parent = entryHandle;
         offset = slash + 1;
         continue;
@@ -509,21 +543,30 @@ void MozMtpDatabase::CreateEntryForFileAndNotify(
   return;
 }
 
-void MozMtpDatabase::AddDirectory(MtpStorageID aStorageID, const char* aPath,
-                                  MtpObjectHandle aParent) {
-  MOZ_ASSERT(MessageLoop::current() == XRE_GetIOMessageLoop());
+bool MozMtpDatabase::AddDirectoryLocked(MtpStorageID aStorageID,
+                                        const nsACString& aPath,
+                                        MtpObjectHandle aParent) {
+  mMutex.AssertCurrentThreadOwns();
 
+  const nsCString path(aPath);
   ScopedCloseDir dir;
 
-  if (!(dir = PR_OpenDir(aPath))) {
-    MTP_ERR("Unable to open directory '%s'", aPath);
-    return;
+  if (!(dir = PR_OpenDir(path.get()))) {
+    MTP_ERR("Unable to open directory '%s'", path.get());
+    return true;
   }
 
   PRDirEntry* dirEntry;
-  while (GetMtpConnectedStatus() &&
-         (dirEntry = PR_ReadDir(dir, PR_SKIP_BOTH))) {
-    nsPrintfCString filename("%s/%s", aPath, dirEntry->name);
+  while ((dirEntry = PR_ReadDir(dir, PR_SKIP_BOTH))) {
+    if (!GetMtpConnectedStatus()) {
+      return false;
+    }
+    nsPrintfCString filename("%s/%s", path.get(), dirEntry->name);
+    if (mPathIndex.Contains(filename)) {
+      // Added by the host or DeviceStorage before we got to list this
+      // directory.
+      continue;
+    }
     PRFileInfo64 fileInfo;
     if (PR_GetFileInfo64(filename.get(), &fileInfo) != PR_SUCCESS) {
       MTP_ERR("Unable to retrieve file information for '%s'", filename.get());
@@ -547,12 +590,44 @@ void MozMtpDatabase::AddDirectory(MtpStorageID aStorageID, const char* aPath,
       entry->mObjectFormat = MTP_FORMAT_TEXT;
       // TODO: Check how 64-bit filesize are dealt with
       entry->mObjectSize = fileInfo.size;
-      AddEntry(entry);
+      AddEntryLocked(entry);
     } else if (fileInfo.type == PR_FILE_DIRECTORY) {
       entry->mObjectFormat = MTP_FORMAT_ASSOCIATION;
       entry->mObjectSize = 0;
-      AddEntry(entry);
-      AddDirectory(aStorageID, filename.get(), entry->mHandle);
+      AddEntryLocked(entry);
+    }
+  }
+  return true;
+}
+
+void MozMtpDatabase::EnsureChildrenLoaded(MtpObjectHandle aHandle) {
+  MutexAutoLock lock(mMutex);
+  EnsureChildrenLoadedLocked(aHandle);
+}
+
+void MozMtpDatabase::EnsureChildrenLoadedLocked(MtpObjectHandle aHandle) {
+  // The storage roots are listed by AddStorage.
+  if (!IsValidHandle(aHandle)) {
+    return;
+  }
+  RefPtr<DbEntry> entry = mDb[aHandle];
+  if (!entry || entry->mObjectFormat != MTP_FORMAT_ASSOCIATION ||
+      entry->mChildrenLoaded) {
+    return;
+  }
+  entry->mChildrenLoaded =
+      AddDirectoryLocked(entry->mStorageID, entry->mPath, aHandle);
+}
+
+void MozMtpDatabase::EnsureAllChildrenLoadedLocked(MtpStorageID aStorageID) {
+  // Loading a directory appends its children to mDb, so this single pass
+  // also reaches every directory it uncovers.
+  for (ProtectedDbArray::index_type entryIndex = 1;
+       entryIndex < mDb.Length() && GetMtpConnectedStatus(); entryIndex++) {
+    RefPtr<DbEntry> entry = mDb[entryIndex];
+    if (entry &&
+        (aStorageID == 0xFFFFFFFF || entry->mStorageID == aStorageID)) {
+      EnsureChildrenLoadedLocked(entryIndex);
     }
   }
 }
@@ -623,16 +698,14 @@ void MozMtpDatabase::AddStorage(MtpStorageID aStorageID, const char* aPath,
   storageEntry->mStorageID = aStorageID;
   storageEntry->mStoragePath = aPath;
   storageEntry->mStorageName = aName;
-  {
-    MutexAutoLock lock(mMutex);
-    mStorage.AppendElement(storageEntry);
-  }
 
-  AddDirectory(aStorageID, aPath, MTP_PARENT_ROOT);
-  {
-    MutexAutoLock lock(mMutex);
-    MTP_LOG("added %d items from tree '%s'", mDb.Length(), aPath);
-  }
+  // Only the top level is listed here. Walking the whole card up front can
+  // take long enough on a big SD card for the host to give up on the
+  // session; directories are filled in as the host opens them instead.
+  MutexAutoLock lock(mMutex);
+  mStorage.AppendElement(storageEntry);
+  AddDirectoryLocked(aStorageID, storageEntry->mStoragePath, MTP_PARENT_ROOT);
+  MTP_LOG("database has %d items after adding '%s'", mDb.Length(), aPath);
 }
 
 void MozMtpDatabase::RemoveStorage(MtpStorageID aStorageID) {
@@ -646,7 +719,7 @@ void MozMtpDatabase::RemoveStorage(MtpStorageID aStorageID) {
   for (entryIndex = 1; entryIndex < numEntries; entryIndex++) {
     RefPtr<DbEntry> entry = mDb[entryIndex];
     if (entry && entry->mStorageID == aStorageID) {
-      mDb[entryIndex] = nullptr;
+      RemoveEntryLocked(entryIndex);
     }
   }
   StorageArray::index_type storageIndex = FindStorage(aStorageID);
@@ -752,6 +825,7 @@ MtpObjectHandle MozMtpDatabase::beginSendObject(const char* aPath,
 #endif
 
   mBeginSendObjectCalled = true;
+  mSendObjectStart = TimeStamp::Now();
   return entry->mHandle;
 }
 
@@ -788,6 +862,18 @@ void MozMtpDatabase::endSendObject(MtpObjectHandle aHandle, bool aSucceeded) {
         entry->mObjectSize = sb.st_size;
         MTP_DBG("Path: %s, file size: %d bytes", entry->mPath.get(),
                 entry->mObjectSize);
+
+        // The data itself is moved by the kernel driver (MTP_RECEIVE_FILE),
+        // so this is the only place we get to see how fast it went.
+        double seconds =
+            mSendObjectStart.IsNull()
+                ? 0
+                : (TimeStamp::Now() - mSendObjectStart).ToSeconds();
+        if (seconds > 0) {
+          MTP_LOG("Received %llu bytes in %.2fs (%.1f MB/s)",
+                  (unsigned long long)entry->mObjectSize, seconds,
+                  entry->mObjectSize / seconds / (1024 * 1024));
+        }
       }
 
       MtpWatcherNotify(entry, "modified");
@@ -796,6 +882,7 @@ void MozMtpDatabase::endSendObject(MtpObjectHandle aHandle, bool aSucceeded) {
     RemoveEntry(aHandle);
   }
   mBeginSendObjectCalled = false;
+  mSendObjectStart = TimeStamp();
 }
 
 // virtual
@@ -845,22 +932,14 @@ MtpObjectHandleList* MozMtpDatabase::getObjectList(MtpStorageID aStorageID,
   // aParent    == 0xFFFFFFFF for objects with no parents
   // aParent    == 0          for all objects
 
-  // TODO: Optimize
-
   UniquePtr<MtpObjectHandleList> list(new MtpObjectHandleList());
 
   MutexAutoLock lock(mMutex);
 
-  ProtectedDbArray::size_type numEntries = mDb.Length();
-  ProtectedDbArray::index_type entryIndex;
-  for (entryIndex = 1; entryIndex < numEntries; entryIndex++) {
-    RefPtr<DbEntry> entry = mDb[entryIndex];
-    if (entry &&
-        (aStorageID == 0xFFFFFFFF || entry->mStorageID == aStorageID) &&
-        (aFormat == 0 || entry->mObjectFormat == aFormat) &&
-        (aParent == 0 || entry->mParent == aParent)) {
-      list->push_back(entry->mHandle);
-    }
+  UnprotectedDbArray result;
+  CollectEntriesLocked(aStorageID, aFormat, aParent, result);
+  for (DbEntry* entry : result) {
+    list->push_back(entry->mHandle);
   }
   MTP_LOG("  returning %d items", list->size());
   return list.release();
@@ -877,26 +956,65 @@ int MozMtpDatabase::getNumObjects(MtpStorageID aStorageID,
   // aParent    == 0xFFFFFFFF for objects with no parents
   // aParent    == 0          for all objects
 
-  int count = 0;
-
   MutexAutoLock lock(mMutex);
 
-  ProtectedDbArray::size_type numEntries = mDb.Length();
-  ProtectedDbArray::index_type entryIndex;
-  for (entryIndex = 1; entryIndex < numEntries; entryIndex++) {
-    RefPtr<DbEntry> entry = mDb[entryIndex];
-    if (entry &&
-        (aStorageID == 0xFFFFFFFF || entry->mStorageID == aStorageID) &&
-        (aFormat == 0 || entry->mObjectFormat == aFormat) &&
-        (aParent == 0 || entry->mParent == aParent)) {
-      count++;
-    }
-  }
+  UnprotectedDbArray result;
+  CollectEntriesLocked(aStorageID, aFormat, aParent, result);
+  int count = result.Length();
 
   MTP_LOG("  returning %d items", count);
   return count;
 }
 
+void MozMtpDatabase::CollectEntriesLocked(MtpStorageID aStorageID,
+                                          MtpObjectFormat aFormat,
+                                          MtpObjectHandle aParent,
+                                          UnprotectedDbArray& aResult) {
+  auto matches = [&](DbEntry* aEntry) {
+    return aEntry &&
+           (aStorageID == 0xFFFFFFFF || aEntry->mStorageID == aStorageID) &&
+           (aFormat == 0 || aEntry->mObjectFormat == aFormat);
+  };
+
+  if (aParent == 0) {
+    // Everything the host could ever see, so nothing can stay unlisted.
+    EnsureAllChildrenLoadedLocked(aStorageID);
+    ProtectedDbArray::size_type numEntries = mDb.Length();
+    for (ProtectedDbArray::index_type entryIndex = 1; entryIndex < numEntries;
+         entryIndex++) {
+      RefPtr<DbEntry> entry = mDb[entryIndex];
+      if (matches(entry)) {
+        aResult.AppendElement(entry);
+      }
+    }
+    return;
+  }
+
+  EnsureChildrenLoadedLocked(aParent);
+  if (auto children = mChildren.Lookup(aParent)) {
+    for (MtpObjectHandle child : *children) {
+      RefPtr<DbEntry> entry = mDb[child];
+      if (matches(entry)) {
+        aResult.AppendElement(entry);
+      }
+    }
+  }
+}
+
+// Returns the loaded part of the subtree below aHandle, parents first.
+void MozMtpDatabase::CollectDescendantsLocked(MtpObjectHandle aHandle,
+                                              UnprotectedDbArray& aResult) {
+  if (auto children = mChildren.Lookup(aHandle)) {
+    for (MtpObjectHandle child : *children) {
+      RefPtr<DbEntry> entry = mDb[child];
+      if (entry) {
+        aResult.AppendElement(entry);
+        CollectDescendantsLocked(child, aResult);
+      }
+    }
+  }
+}
+
 // virtual
 MtpObjectFormatList* MozMtpDatabase::getSupportedPlaybackFormats() {
   static const uint16_t init_data[] = {
@@ -1061,32 +1179,23 @@ MtpResponseCode MozMtpDatabase::updateSubObjectPath(MtpObjectHandle aHandle,
     return MTP_RESPONSE_INVALID_OBJECT_HANDLE;
   }
 
-  ProtectedDbArray::size_type numEntries = mDb.Length();
-  ProtectedDbArray::index_type entryIdx;
-  ProtectedDbArray::index_type tmpIdx;
-  RefPtr<DbEntry> tmpEntry;
-
-  // search entries to find the sub entry
-  for (entryIdx = aHandle + 1; entryIdx < numEntries; entryIdx++) {
-    if (!mDb[entryIdx]) {
-      continue;
-    }
+  // Directories that were never listed have no entries below them, and
+  // will be listed from their new path when the host opens them.
+  UnprotectedDbArray subEntries;
+  {
+    MutexAutoLock lock(mMutex);
+    CollectDescendantsLocked(aHandle, subEntries);
+  }
 
-    // find the sub entry
-    for (tmpIdx = entryIdx, tmpEntry = mDb[entryIdx];
-         (MTP_PARENT_ROOT != tmpIdx) && mDb[tmpIdx];
-         tmpIdx = mDb[tmpIdx]->mParent) {
-      if (aHandle == mDb[tmpIdx]->mParent) {
-        // update the mPath of each sub entry
-        MtpWatcherNotify(tmpEntry, "deleted");
-        tmpEntry->mPath.Replace(0, parentEntry->mPath.Length(),
-                                newFileFullPath.get(),
-                                newFileFullPath.Length());
-        MtpWatcherNotify(tmpEntry, "modified");
-        MTP_DBG("sub element new path: '%s'", tmpEntry->mPath.get());
-        break;
-      }
-    }
+  for (DbEntry* subEntry : subEntries) {
+    // update the mPath of each sub entry
+    MtpWatcherNotify(subEntry, "deleted");
+    nsCString newPath(subEntry->mPath);
+    newPath.Replace(0, parentEntry->mPath.Length(), newFileFullPath.get(),
+                    newFileFullPath.Length());
+    SetEntryPath(subEntry, newPath);
+    MtpWatcherNotify(subEntry, "modified");
+    MTP_DBG("sub element new path: '%s'", subEntry->mPath.get());
   }
 
   return MTP_RESPONSE_OK;
@@ -1139,7 +1248,7 @@ MtpResponseCode MozMtpDatabase::setObjectPropertyValue(
 
   MtpWatcherNotify(entry, "deleted");
 
-  entry->mPath = newFileFullPath;
+  SetEntryPath(entry, newFileFullPath);
   entry->mObjectName = BaseName(entry->mPath);
   entry->mDisplayName = entry->mObjectName;
 
@@ -1174,71 +1283,38 @@ void MozMtpDatabase::QueryEntries(MozMtpDatabase::MatchType aMatchType,
                                   UnprotectedDbArray& result) {
   MutexAutoLock lock(mMutex);
 
-  ProtectedDbArray::size_type numEntries = mDb.Length();
-  ProtectedDbArray::index_type entryIdx;
   RefPtr<DbEntry> entry;
 
   result.Clear();
 
   switch (aMatchType) {
     case MatchAll:
-      for (entryIdx = 0; entryIdx < numEntries; entryIdx++) {
-        if (mDb[entryIdx]) {
-          result.AppendElement(mDb[entryIdx]);
-        }
-      }
+      CollectEntriesLocked(0xFFFFFFFF, 0, 0, result);
       break;
 
     case MatchHandle:
-      for (entryIdx = 0; entryIdx < numEntries; entryIdx++) {
-        entry = mDb[entryIdx];
-        if (entry && entry->mHandle == aMatchField1) {
-          result.AppendElement(entry);
-          // Handles are unique - return the one that we found.
-          return;
-        }
+      if (IsValidHandle(aMatchField1) && (entry = mDb[aMatchField1])) {
+        result.AppendElement(entry);
       }
       break;
 
     case MatchParent:
-      for (entryIdx = 0; entryIdx < numEntries; entryIdx++) {
-        entry = mDb[entryIdx];
-        if (entry && entry->mParent == aMatchField1) {
-          result.AppendElement(entry);
-        }
-      }
+      CollectEntriesLocked(0xFFFFFFFF, 0, aMatchField1, result);
       break;
 
     case MatchFormat:
-      for (entryIdx = 0; entryIdx < numEntries; entryIdx++) {
-        entry = mDb[entryIdx];
-        if (entry && entry->mObjectFormat == aMatchField1) {
-          result.AppendElement(entry);
-        }
-      }
+      CollectEntriesLocked(0xFFFFFFFF, aMatchField1, 0, result);
       break;
 
     case MatchHandleFormat:
-      for (entryIdx = 0; entryIdx < numEntries; entryIdx++) {
-        entry = mDb[entryIdx];
-        if (entry && entry->mHandle == aMatchField1) {
-          if (entry->mObjectFormat == aMatchField2) {
-            result.AppendElement(entry);
-          }
-          // Only 1 entry can match my aHandle. So we can return early.
-          return;
-        }
+      if (IsValidHandle(aMatchField1) && (entry = mDb[aMatchField1]) &&
+          entry->mObjectFormat == aMatchField2) {
+        result.AppendElement(entry);
       }
       break;
 
     case MatchParentFormat:
-      for (entryIdx = 0; entryIdx < numEntries; entryIdx++) {
-        entry = mDb[entryIdx];
-        if (entry && entry->mParent == aMatchField1 &&
-            entry->mObjectFormat == aMatchField2) {
-          result.AppendElement(entry);
-        }
-      }
+      CollectEntriesLocked(0xFFFFFFFF, aMatchField2, aMatchField1, result);
       break;
 
     default:
@@ -1657,8 +1733,8 @@ MtpResponseCode MozMtpDatabase::beginMoveObject(MtpObjectHandle handle,
         updateSubObjectPath(handle, newFileFullPath);
       }
       MtpWatcherNotify(entry, "deleted");
-      entry->mPath = newFileFullPath;
-      entry->mParent = newParent;
+      SetEntryPath(entry, newFileFullPath);
+      SetEntryParent(entry, newParent);
       MtpWatcherNotify(entry, "modified");
     } else {
       // Create new handles instead of renaming the objects
@@ -1726,8 +1802,8 @@ void MozMtpDatabase::endMoveObject(MtpObjectHandle oldParent,
         // Restore sub mPath to old one
         updateSubObjectPath(aHandle, oldFileFullPath);
         MtpWatcherNotify(entry, "deleted");
-        entry->mPath = oldFileFullPath;
-        entry->mParent = oldParent;
+        SetEntryPath(entry, oldFileFullPath);
+        SetEntryParent(entry, oldParent);
         MtpWatcherNotify(entry, "modified");
       } else {
         // Remove created entry when fail to do the move operation in the same
@@ -1793,19 +1869,22 @@ MtpObjectHandle MozMtpDatabase::CopyObject(MtpObjectHandle aHandle,
     MtpWatcherNotify(dstEntry, "modified");
 
     if (srcEntry->mObjectFormat == MTP_FORMAT_ASSOCIATION) {
-      ProtectedDbArray::size_type numEntries = mDb.Length();
-      ProtectedDbArray::index_type entryIdx;
-      // search entries to find the sub entry
-      for (entryIdx = aHandle + 1; entryIdx < numEntries; entryIdx++) {
-        if (mDb[entryIdx] && aHandle == mDb[entryIdx]->mParent) {
-          if (kInvalidObjectHandle == CopyObject(mDb[entryIdx]->mHandle,
-                                                 dstEntry->mHandle,
-                                                 newStorage)) {
-            MTP_ERR(
-                "Copy sub file/folder fail, source path: %s, target path: %s",
-                mDb[entryIdx]->mPath.get(), dstEntry->mPath.get());
-            return kInvalidObjectHandle;
-          }
+      nsTArray<MtpObjectHandle> children;
+      {
+        MutexAutoLock lock(mMutex);
+        EnsureChildrenLoadedLocked(aHandle);
+        if (auto srcChildren = mChildren.Lookup(aHandle)) {
+          children = srcChildren->Clone();
+        }
+      }
+      for (MtpObjectHandle child : children) {
+        if (kInvalidObjectHandle ==
+            CopyObject(child, dstEntry->mHandle, newStorage)) {
+          MTP_ERR(
+              "Copy sub file/folder fail, source handle: 0x%08x, target path: "
+              "%s",
+              child, dstEntry->mPath.get());
+          return kInvalidObjectHandle;
         }
       }
     }
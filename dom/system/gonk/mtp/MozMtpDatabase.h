@@ -8,13 +8,17 @@
 #define mozilla_system_mozmtpdatabase_h__
 
 #include "MozMtpCommon.h"
+#include "MozMtpEventCoalescer.h"
 
 #include "mozilla/Mutex.h"
 #include "mozilla/RefPtr.h"
+#include "mozilla/TimeStamp.h"
 #include "nsCOMPtr.h"
+#include "nsHashKeys.h"
 #include "nsString.h"
 #include "nsIThread.h"
 #include "nsTArray.h"
+#include "nsTHashMap.h"
 
 class DeviceStorageFile;
 
@@ -134,6 +138,9 @@ class MozMtpDatabase final : public IMtpDatabase {
 
   void SetMtpConnectedStatus(bool status) { mMtpConnectedStatus = status; }
 
+  // Object events sent to the host go through this.
+  MozMtpEventCoalescer* EventCoalescer() { return mEventCoalescer; }
+
   bool isStorageIDExisted(MtpStorageID aStorageID) {
     return (MozMtpDatabase::StorageArray::NoIndex != FindStorage(aStorageID));
   }
@@ -151,7 +158,8 @@ class MozMtpDatabase final : public IMtpDatabase {
           mObjectSize(0),
           mDateCreated(0),
           mDateModified(0),
-          mDateAdded(0) {}
+          mDateAdded(0),
+          mChildrenLoaded(false) {}
 
     NS_INLINE_DECL_THREADSAFE_REFCOUNTING(DbEntry)
 
@@ -166,6 +174,9 @@ class MozMtpDatabase final : public IMtpDatabase {
     time_t mDateCreated;
     time_t mDateModified;
     time_t mDateAdded;
+    // Only used for directories. Their contents are read from disk the first
+    // time the host asks for them; see EnsureChildrenLoadedLocked.
+    bool mChildrenLoaded;
 
    protected:
     ~DbEntry() {}
@@ -247,12 +258,16 @@ class MozMtpDatabase final : public IMtpDatabase {
   }
 
   void AddEntry(DbEntry* aEntry);
+  void AddEntryLocked(DbEntry* aEntry);
   void AddEntryAndNotify(DbEntry* aEntr, RefCountedMtpServer* aMtpServer);
   void AddEntryAndNotify(DbEntry* aEntr);
   void DumpEntries(const char* aLabel);
   MtpObjectHandle FindEntryByPath(const nsACString& aPath);
   already_AddRefed<DbEntry> GetEntry(MtpObjectHandle aHandle);
   void RemoveEntry(MtpObjectHandle aHandle);
+  void RemoveEntryLocked(MtpObjectHandle aHandle);
+  void SetEntryPath(DbEntry* aEntry, const nsACString& aPath);
+  void SetEntryParent(DbEntry* aEntry, MtpObjectHandle aParent);
   void RemoveEntryAndNotify(MtpObjectHandle aHandle,
                             RefCountedMtpServer* aMtpServer);
   void RemoveEntryAndNotify(MtpObjectHandle aHandle);
@@ -262,12 +277,27 @@ class MozMtpDatabase final : public IMtpDatabase {
   void QueryEntries(MatchType aMatchType, uint32_t aMatchField1,
                     uint32_t aMatchField2, UnprotectedDbArray& aResult);
 
+  // Appends the entries matching the getObjectList() style filter: aStorageID
+  // 0xFFFFFFFF and aFormat 0 match anything, aParent 0 matches all objects and
+  // MTP_PARENT_ROOT the objects at the root of a storage.
+  void CollectEntriesLocked(MtpStorageID aStorageID, MtpObjectFormat aFormat,
+                            MtpObjectHandle aParent,
+                            UnprotectedDbArray& aResult);
+  void CollectDescendantsLocked(MtpObjectHandle aHandle,
+                                UnprotectedDbArray& aResult);
+
   nsCString BaseName(const nsCString& aPath);
 
   MtpObjectHandle GetNextHandle() { return mDb.Length(); }
 
-  void AddDirectory(MtpStorageID aStorageID, const char* aPath,
-                    MtpObjectHandle aParent);
+  // Adds an entry for everything directly inside aPath that isn't in the
+  // database yet. Subdirectories are left to be loaded on demand. Returns
+  // false if the listing was cut short.
+  bool AddDirectoryLocked(MtpStorageID aStorageID, const nsACString& aPath,
+                          MtpObjectHandle aParent);
+  void EnsureChildrenLoaded(MtpObjectHandle aHandle);
+  void EnsureChildrenLoadedLocked(MtpObjectHandle aHandle);
+  void EnsureAllChildrenLoadedLocked(MtpStorageID aStorageID);
 
   void CreateEntryForFileAndNotify(const nsACString& aPath,
                                    DeviceStorageFile* aFile,
@@ -291,8 +321,23 @@ class MozMtpDatabase final : public IMtpDatabase {
   ProtectedDbArray mDb;
   StorageArray mStorage;
 
+  // mDb is indexed by handle; these index it the other ways the MTP server
+  // looks things up. Both are guarded by mMutex and kept current by
+  // AddEntryLocked, RemoveEntryLocked and the SetEntry* helpers, so mPath and
+  // mParent must not be assigned directly once an entry has been added.
+  //
+  // mChildren holds the children of each directory in handle order. Objects
+  // at the root of every storage are listed under MTP_PARENT_ROOT.
+  nsTHashMap<nsUint32HashKey, nsTArray<MtpObjectHandle>> mChildren;
+  nsTHashMap<nsCStringHashKey, MtpObjectHandle> mPathIndex;
+
+  const RefPtr<MozMtpEventCoalescer> mEventCoalescer;
+
   bool mBeginSendObjectCalled;
   bool mMtpConnectedStatus;
+
+  // When the SendObject in progress started, for the throughput log.
+  mozilla::TimeStamp mSendObjectStart;
 };
 
 END_MTP_NAMESPACE
@@ -0,0 +1,173 @@
+/* -*- Mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; tab-width: 40 -*- */
+/* vim: set ts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "MozMtpEventCoalescer.h"
+#include "MozMtpServer.h"
+
+#include "mozilla/DebugOnly.h"
+#include "mozilla/TimeStamp.h"
+#include "nsTArray.h"
+#include "nsTHashSet.h"
+#include "nsThreadUtils.h"
+
+using namespace android;
+using namespace mozilla;
+
+BEGIN_MTP_NAMESPACE
+
+// How long events are held back, counted from the first one of a burst.
+static const uint32_t kCoalesceWindowMs = 100;
+
+// Beyond this many changes in one folder within a window, the host is told
+// to refresh the folder rather than about each object.
+static const uint32_t kMaxEventsPerFolder = 32;
+
+MozMtpEventCoalescer::MozMtpEventCoalescer()
+    : mMutex("MozMtpEventCoalescer::mMutex"),
+      mMergedCount(0),
+      mDroppedCount(0) {
+  DebugOnly<nsresult> rv =
+      NS_CreateBackgroundTaskQueue("MtpEvents", getter_AddRefs(mTaskQueue));
+  MOZ_ASSERT(NS_SUCCEEDED(rv));
+}
+
+void MozMtpEventCoalescer::ObjectAdded(RefCountedMtpServer* aServer,
+                                       MtpObjectHandle aHandle,
+                                       MtpObjectHandle aParent) {
+  Queue(aServer, aHandle, aParent, Kind::Added);
+}
+
+void MozMtpEventCoalescer::ObjectChanged(RefCountedMtpServer* aServer,
+                                         MtpObjectHandle aHandle,
+                                         MtpObjectHandle aParent) {
+  Queue(aServer, aHandle, aParent, Kind::Changed);
+}
+
+void MozMtpEventCoalescer::ObjectRemoved(RefCountedMtpServer* aServer,
+                                         MtpObjectHandle aHandle,
+                                         MtpObjectHandle aParent) {
+  Queue(aServer, aHandle, aParent, Kind::Removed);
+}
+
+void MozMtpEventCoalescer::Queue(RefCountedMtpServer* aServer,
+                                 MtpObjectHandle aHandle,
+                                 MtpObjectHandle aParent, Kind aKind) {
+  MOZ_ASSERT(aServer);
+
+  MutexAutoLock lock(mMutex);
+
+  mServer = aServer;
+
+  if (auto pending = mPending.Lookup(aHandle)) {
+    if (aKind == Kind::Removed && pending->mKind == Kind::Added) {
+      // The host never heard of it, so it needn't hear that it's gone.
+      pending.Remove();
+      mDroppedCount += 2;
+      return;
+    }
+    // Added then changed is still just added, and changed then removed is
+    // just removed.
+    if (aKind == Kind::Removed) {
+      pending->mKind = Kind::Removed;
+    }
+    pending->mParent = aParent;
+    mMergedCount++;
+    return;
+  }
+
+  mPending.InsertOrUpdate(aHandle, Event{aKind, aParent});
+
+  if (!mTimer) {
+    RefPtr<MozMtpEventCoalescer> self = this;
+    nsresult rv = NS_NewTimerWithCallback(
+        getter_AddRefs(mTimer), [self](nsITimer*) { self->Flush(); },
+        TimeDuration::FromMilliseconds(kCoalesceWindowMs),
+        nsITimer::TYPE_ONE_SHOT, "MozMtpEventCoalescer::Flush", mTaskQueue);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+      mTimer = nullptr;
+      DebugOnly<nsresult> rv2 = mTaskQueue->Dispatch(
+          NewRunnableMethod("MozMtpEventCoalescer::Flush", this,
+                            &MozMtpEventCoalescer::Flush),
+          NS_DISPATCH_NORMAL);
+      MOZ_ASSERT(NS_SUCCEEDED(rv2));
+    }
+  }
+}
+
+void MozMtpEventCoalescer::Clear() {
+  MutexAutoLock lock(mMutex);
+
+  if (mTimer) {
+    mTimer->Cancel();
+    mTimer = nullptr;
+  }
+  mPending.Clear();
+  mServer = nullptr;
+
+  MTP_LOG("events merged: %u dropped: %u", uint32_t(mMergedCount),
+          uint32_t(mDroppedCount));
+}
+
+void MozMtpEventCoalescer::Flush() {
+  MOZ_ASSERT(mTaskQueue->IsOnCurrentThread());
+
+  RefPtr<RefCountedMtpServer> server;
+  nsTHashMap<nsUint32HashKey, Event> pending;
+  {
+    MutexAutoLock lock(mMutex);
+    mTimer = nullptr;
+    server = std::move(mServer);
+    pending.SwapElements(mPending);
+  }
+  if (!server || pending.IsEmpty()) {
+    return;
+  }
+
+  nsTArray<MtpObjectHandle> handles;
+  nsTHashMap<nsUint32HashKey, uint32_t> folderEventCount;
+  for (auto iter = pending.ConstIter(); !iter.Done(); iter.Next()) {
+    auto parent = pending.Lookup(iter.Data().mParent);
+    if (parent && parent->mKind != Kind::Changed) {
+      // Covered by the event for the folder being added or removed.
+      mDroppedCount++;
+      continue;
+    }
+    handles.AppendElement(iter.Key());
+    folderEventCount.LookupOrInsert(iter.Data().mParent)++;
+  }
+
+  // Handles grow as objects are added, so this reports folders before what
+  // is inside them.
+  handles.Sort();
+
+  nsTHashSet<uint32_t> refreshedFolders;
+  for (MtpObjectHandle handle : handles) {
+    const Event& event = *pending.Lookup(handle);
+    if (event.mParent != MTP_PARENT_ROOT &&
+        folderEventCount.Get(event.mParent) > kMaxEventsPerFolder) {
+      if (refreshedFolders.EnsureInserted(event.mParent)) {
+        MTP_DBG("Folder 0x%08x refreshed for %u changes", event.mParent,
+                folderEventCount.Get(event.mParent));
+        server->sendObjectInfoChanged(event.mParent);
+      }
+      mDroppedCount++;
+      continue;
+    }
+
+    switch (event.mKind) {
+      case Kind::Added:
+      case Kind::Changed:
+        // The host only refreshes an object's info on ObjectAdded.
+        server->sendObjectAdded(handle);
+        break;
+      case Kind::Removed:
+        server->sendObjectRemoved(handle);
+        break;
+    }
+  }
+}
+
+END_MTP_NAMESPACE
@@ -0,0 +1,91 @@
+/* -*- Mode: c++; c-basic-offset: 2; indent-tabs-mode: nil; tab-width: 40 -*- */
+/* vim: set ts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef mozilla_system_mozmtpeventcoalescer_h__
+#define mozilla_system_mozmtpeventcoalescer_h__
+
+#include "MozMtpCommon.h"
+
+#include "mozilla/Atomics.h"
+#include "mozilla/Mutex.h"
+#include "mozilla/RefPtr.h"
+#include "nsCOMPtr.h"
+#include "nsHashKeys.h"
+#include "nsITimer.h"
+#include "nsTHashMap.h"
+
+class nsISerialEventTarget;
+
+BEGIN_MTP_NAMESPACE  // mozilla::system::mtp
+
+    class RefCountedMtpServer;
+
+/**
+ * Holds back the object events we send to the USB host for a short while
+ * and merges them, so that a camera burst or an unzip doesn't turn into a
+ * flood of ObjectAdded events that stalls transfers.
+ *
+ * Within one window:
+ *  - repeated events for the same object collapse into one, and an object
+ *    that is added and removed again isn't reported at all;
+ *  - nothing is sent for objects below a folder that is itself being added
+ *    or removed, since the host will list the folder when it opens it;
+ *  - a folder with more than kMaxEventsPerFolder changes gets a single
+ *    ObjectInfoChanged for the folder instead of one event per child.
+ *
+ * Events are sent from a background task queue. May be used from any
+ * thread.
+ */
+class MozMtpEventCoalescer final {
+ public:
+  NS_INLINE_DECL_THREADSAFE_REFCOUNTING(MozMtpEventCoalescer)
+
+  MozMtpEventCoalescer();
+
+  void ObjectAdded(RefCountedMtpServer* aServer, MtpObjectHandle aHandle,
+                   MtpObjectHandle aParent);
+  void ObjectChanged(RefCountedMtpServer* aServer, MtpObjectHandle aHandle,
+                     MtpObjectHandle aParent);
+  void ObjectRemoved(RefCountedMtpServer* aServer, MtpObjectHandle aHandle,
+                     MtpObjectHandle aParent);
+
+  // Forgets everything still pending, e.g. because the session has ended.
+  void Clear();
+
+  // Events folded into another event for the same object.
+  uint32_t MergedCount() const { return mMergedCount; }
+  // Events that were never sent because they cancelled out or were covered
+  // by an event for their folder.
+  uint32_t DroppedCount() const { return mDroppedCount; }
+
+ private:
+  ~MozMtpEventCoalescer() {}
+
+  enum class Kind : uint8_t { Added, Changed, Removed };
+
+  struct Event {
+    Kind mKind;
+    MtpObjectHandle mParent;
+  };
+
+  void Queue(RefCountedMtpServer* aServer, MtpObjectHandle aHandle,
+             MtpObjectHandle aParent, Kind aKind);
+  void Flush();
+
+  nsCOMPtr<nsISerialEventTarget> mTaskQueue;
+
+  mozilla::Mutex mMutex;
+  RefPtr<RefCountedMtpServer> mServer;
+  nsTHashMap<nsUint32HashKey, Event> mPending;
+  nsCOMPtr<nsITimer> mTimer;
+
+  mozilla::Atomic<uint32_t> mMergedCount;
+  mozilla::Atomic<uint32_t> mDroppedCount;
+};
+
+END_MTP_NAMESPACE
+
+#endif  // mozilla_system_mozmtpeventcoalescer_h__
@@ -22,7 +22,6 @@
 
 #include "base/message_loop.h"
 #include "DeviceStorage.h"
-#include "mozilla/LazyIdleThread.h"
 #include "mozilla/Scoped.h"
 #include "mozilla/Services.h"
 #include "mozilla/StaticPtr.h"
@@ -38,7 +37,6 @@
 
 #define MOZ_UTF16(s) MOZ_UTF16_HELPER(s)
 
-#define DEFAULT_THREAD_TIMEOUT_MS 30000
 #define MTP_STATE_STARTED MOZ_UTF16("started")
 #define MTP_STATE_FINISHED MOZ_UTF16("finished")
 
@@ -63,7 +61,7 @@ class MtpWatcherUpdateRunnable final : public Runnable {
         mEventType(aEventType) {}
 
   NS_IMETHOD Run() {
-    // Runs on the MtpWatcherUpdate->mIOThread
+    // Runs on the MtpWatcherUpdate->mIOQueue
     MOZ_ASSERT(!NS_IsMainThread());
 
     mMozMtpDatabase->MtpWatcherUpdate(mMtpServer, mFile, mEventType);
@@ -86,8 +84,9 @@ class MtpWatcherUpdate final : public nsIObserver {
   MtpWatcherUpdate(MozMtpServer* aMozMtpServer) : mMozMtpServer(aMozMtpServer) {
     MOZ_ASSERT(NS_IsMainThread());
 
-    mIOThread =
-        new LazyIdleThread(DEFAULT_THREAD_TIMEOUT_MS, "MtpWatcherUpdate"_ns);
+    // The updates need to be done in order, but not on any given thread.
+    MOZ_ALWAYS_SUCCEEDS(NS_CreateBackgroundTaskQueue(
+        "MtpWatcherUpdate", getter_AddRefs(mIOQueue)));
 
     nsCOMPtr<nsIObserverService> obs = mozilla::services::GetObserverService();
     obs->AddObserver(this, kMtpWatcherUpdate, false);
@@ -124,7 +123,7 @@ class MtpWatcherUpdate final : public nsIObserver {
 
     RefPtr<MtpWatcherUpdateRunnable> r = new MtpWatcherUpdateRunnable(
         mozMtpDatabase, mtpServer, file, eventType);
-    mIOThread->Dispatch(r, NS_DISPATCH_NORMAL);
+    mIOQueue->Dispatch(r.forget(), NS_DISPATCH_EVENT_MAY_BLOCK);
 
     return NS_OK;
   }
@@ -139,7 +138,7 @@ class MtpWatcherUpdate final : public nsIObserver {
 
  private:
   RefPtr<MozMtpServer> mMozMtpServer;
-  nsCOMPtr<nsIThread> mIOThread;
+  nsCOMPtr<nsISerialEventTarget> mIOQueue;
 };
 NS_IMPL_ISUPPORTS(MtpWatcherUpdate, nsIObserver)
 static StaticRefPtr<MtpWatcherUpdate> sMtpWatcherUpdate;
@@ -224,6 +223,10 @@ class MtpServerRunnable : public Runnable {
     MTP_LOG("MozMtpServer finished");
     mMozMtpStorage.Clear();
 
+    // Whatever hasn't been sent yet refers to a session that's gone.
+    RefPtr<MozMtpDatabase> db = mMozMtpServer->GetMozMtpDatabase();
+    db->EventCoalescer()->Clear();
+
     rv = NS_DispatchToMainThread(
         new FreeMtpWatcherUpdateRunnable(mMozMtpServer));
     MOZ_ASSERT(NS_SUCCEEDED(rv));
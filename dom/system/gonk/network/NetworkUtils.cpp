@@ -46,6 +46,7 @@
 #include <android/net/IDnsResolver.h>
 #include "NetdUnsolService.h"
 #include "NetdEventListener.h"
+#include "TetherOffload.h"
 
 #define WARN(args...) \
   __android_log_print(ANDROID_LOG_WARN, "NetworkUtils", ##args)
@@ -166,9 +167,11 @@ const CommandFunc NetworkUtils::sWifiEnableChain[] = {
     NetworkUtils::enableNat,
     NetworkUtils::addIpv6TetheringInterfaces,
     NetworkUtils::updateIpv6Tethering,
+    NetworkUtils::startTetherOffload,
     NetworkUtils::wifiTetheringSuccess};
 
 const CommandFunc NetworkUtils::sWifiDisableChain[] = {
+    NetworkUtils::stopTetherOffload,
     NetworkUtils::stopIpv6Tethering,
     NetworkUtils::removeIpv6TetheringInterfaces,
     NetworkUtils::updateIpv6Tethering,
@@ -194,9 +197,11 @@ const CommandFunc NetworkUtils::sUSBEnableChain[] = {
     NetworkUtils::enableNat,
     NetworkUtils::addIpv6TetheringInterfaces,
     NetworkUtils::updateIpv6Tethering,
+    NetworkUtils::startTetherOffload,
     NetworkUtils::usbTetheringSuccess};
 
 const CommandFunc NetworkUtils::sUSBDisableChain[] = {
+    NetworkUtils::stopTetherOffload,
     NetworkUtils::stopIpv6Tethering,
     NetworkUtils::removeIpv6TetheringInterfaces,
     NetworkUtils::updateIpv6Tethering,
@@ -220,6 +225,7 @@ const CommandFunc NetworkUtils::sUpdateUpStreamChain[] = {
     NetworkUtils::createUpStreamInterfaceForwarding,
     NetworkUtils::setDnsForwarders,
     NetworkUtils::updateIpv6Tethering,
+    NetworkUtils::updateTetherOffloadUpstream,
     NetworkUtils::updateUpStreamSuccess};
 
 /*
@@ -464,9 +470,38 @@ void NetworkUtils::runNextQueuedCommandChain() {
   next(nextChain, false, newResult);
 }
 
+// Chains slower than this are logged even without network debugging, with
+// the time of each step, so the netd call that stalled can be found.
+static const double kSlowCommandChainMs = 500;
+
+static void reportCommandChainLatency(CommandChain* aChain, bool aError) {
+  const nsTArray<double>& steps = aChain->getStepLatencyMs();
+  double running = aChain->getRunningMs();
+  if (running < kSlowCommandChainMs && !ENABLE_NU_DEBUG) {
+    return;
+  }
+
+  nsAutoCString stepList;
+  for (uint32_t i = 0; i < steps.Length(); i++) {
+    stepList.AppendPrintf("%s%.1f", i ? ", " : "", steps[i]);
+  }
+  nsPrintfCString message(
+      "%s %s in %.1fms, queued %.1fms, steps [%s]",
+      NS_ConvertUTF16toUTF8(aChain->getParams().mCmd).get(),
+      aError ? "failed" : "done", running, aChain->getQueuedMs(),
+      stepList.get());
+  if (running >= kSlowCommandChainMs) {
+    WARN("%s", message.get());
+  } else {
+    NU_DBG("%s", message.get());
+  }
+}
+
 void NetworkUtils::next(CommandChain* aChain, bool aError,
                         NetworkResultOptions& aResult) {
   if (aError) {
+    aChain->recordStep();
+    reportCommandChainLatency(aChain, true);
     ErrorCallback onError = aChain->getErrorCallback();
     if (onError) {
       aResult.mError = true;
@@ -479,6 +514,7 @@ void NetworkUtils::next(CommandChain* aChain, bool aError,
   }
   CommandFunc f = aChain->getNextCommand();
   if (!f) {
+    reportCommandChainLatency(aChain, false);
     delete aChain;
     gCommandChainQueue.RemoveElementAt(0);
     runNextQueuedCommandChain();
@@ -1188,6 +1224,63 @@ void NetworkUtils::stopIpv6Tethering(CommandChain* aChain,
   next(aChain, false, aResult);
 }
 
+// Tether offload is best effort and never fails a chain: the kernel path set
+// up by netd forwards whatever the hardware doesn't.
+void NetworkUtils::startTetherOffload(CommandChain* aChain,
+                                      CommandCallback aCallback,
+                                      NetworkResultOptions& aResult) {
+  TetherOffload* offload = TetherOffload::Get();
+  if (!offload) {
+    next(aChain, false, aResult);
+    return;
+  }
+
+  nsTArray<nsCString> gateways;
+  for (const nsString& gateway : GET_FIELD(mGateways)) {
+    gateways.AppendElement(NS_ConvertUTF16toUTF8(gateway));
+  }
+  offload->SetUpstream(NS_ConvertUTF16toUTF8(GET_FIELD(mExternalIfname)),
+                       gateways);
+
+  nsTArray<nsCString> prefixes;
+  nsAutoCString prefix;
+  if (TetherOffload::Ipv4Prefix(GET_CHAR(mIp), atoi(GET_CHAR(mPrefix)),
+                                prefix)) {
+    prefixes.AppendElement(prefix);
+  }
+  if (!GET_FIELD(mIPv6Prefix).IsEmpty()) {
+    prefixes.AppendElement(NS_ConvertUTF16toUTF8(GET_FIELD(mIPv6Prefix)));
+  }
+  offload->AddDownstream(NS_ConvertUTF16toUTF8(GET_FIELD(mInternalIfname)),
+                         prefixes);
+  NU_DBG("%s: %s", __FUNCTION__, GET_CHAR(mInternalIfname));
+  next(aChain, false, aResult);
+}
+
+void NetworkUtils::stopTetherOffload(CommandChain* aChain,
+                                     CommandCallback aCallback,
+                                     NetworkResultOptions& aResult) {
+  if (TetherOffload* offload = TetherOffload::Peek()) {
+    offload->RemoveDownstream(
+        NS_ConvertUTF16toUTF8(GET_FIELD(mInternalIfname)));
+  }
+  next(aChain, false, aResult);
+}
+
+void NetworkUtils::updateTetherOffloadUpstream(CommandChain* aChain,
+                                               CommandCallback aCallback,
+                                               NetworkResultOptions& aResult) {
+  if (TetherOffload* offload = TetherOffload::Peek()) {
+    nsTArray<nsCString> gateways;
+    for (const nsString& gateway : GET_FIELD(mGateways)) {
+      gateways.AppendElement(NS_ConvertUTF16toUTF8(gateway));
+    }
+    offload->SetUpstream(NS_ConvertUTF16toUTF8(GET_FIELD(mCurExternalIfname)),
+                         gateways);
+  }
+  next(aChain, false, aResult);
+}
+
 void NetworkUtils::updateIpv6Tethering(CommandChain* aChain,
                                        CommandCallback aCallback,
                                        NetworkResultOptions& aResult) {
@@ -1528,6 +1621,8 @@ NetworkUtils::NetworkUtils(MessageCallback aCallback)
 NetworkUtils::~NetworkUtils() {
   setupNetd(false);
   NU_DBG("destroy NetworkUtils");
+  gNetworkUtilsThread->Dispatch(NS_NewRunnableFunction(
+      "TetherOffload::Shutdown", [] { TetherOffload::Shutdown(); }));
   gNetworkUtilsThread->Shutdown();
   gNetworkUtilsThread = nullptr;
 }
@@ -2380,6 +2475,13 @@ CommandResult NetworkUtils::getTetherStats(NetworkParams& aOptions) {
   Status status;
   result.mResult = false;
 
+  // Traffic forwarded by the offload hardware never shows in netd's
+  // counters, so it is added here.
+  TetherOffload* offload = TetherOffload::Peek();
+  if (offload) {
+    offload->UpdateDownstreamStats();
+  }
+
   std::vector<TetherStatsParcel> tetherStatsParcelVec;
   status = gNetd->tetherGetStats(&tetherStatsParcelVec);
   NU_DBG("getTetherStats %s", status.isOk() ? "success" : "failed");
@@ -2392,12 +2494,18 @@ CommandResult NetworkUtils::getTetherStats(NetworkParams& aOptions) {
         // Just ignore the dummy upstream interface.
         continue;
       }
+      uint64_t rxBytes = statsParcel.rxBytes;
+      uint64_t txBytes = statsParcel.txBytes;
+      if (offload) {
+        offload->AddForwardedStats(
+            nsDependentCString(statsParcel.iface.c_str()), rxBytes, txBytes);
+      }
       TetherStats tetherStats;
       tetherStats.mIfname =
           nsString(NS_ConvertUTF8toUTF16(statsParcel.iface.c_str()));
-      tetherStats.mRxBytes = statsParcel.rxBytes;
+      tetherStats.mRxBytes = rxBytes;
       tetherStats.mRxPackets = statsParcel.rxPackets;
-      tetherStats.mTxBytes = statsParcel.txBytes;
+      tetherStats.mTxBytes = txBytes;
       tetherStats.mTxPackets = statsParcel.txPackets;
       result.mTetherStats.Value().AppendElement(std::move(tetherStats),
                                                 mozilla::fallible);
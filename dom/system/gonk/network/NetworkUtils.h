@@ -9,6 +9,7 @@
 #include "mozilla/dom/NetworkOptionsBinding.h"
 #include "mozilla/dom/network/NetUtils.h"
 #include "mozilla/FileUtils.h"
+#include "mozilla/TimeStamp.h"
 #include "nsTArray.h"
 #include "NetIdManager.h"
 
@@ -213,6 +214,7 @@ class NetworkParams {
 // 2. Command list.
 // 3. Error callback function.
 // 4. Index of current execution command.
+// 5. How long each command took, for spotting slow netd calls.
 class CommandChain final {
  public:
   CommandChain(const NetworkParams& aParams, const CommandFunc aCmds[],
@@ -221,23 +223,50 @@ class CommandChain final {
         mParams(aParams),
         mCommands(aCmds),
         mLength(aLength),
-        mError(aError) {}
+        mError(aError),
+        mQueuedTime(mozilla::TimeStamp::Now()) {}
 
   NetworkParams& getParams() { return mParams; };
 
   CommandFunc getNextCommand() {
+    recordStep();
     mIndex++;
     return mIndex < mLength ? mCommands[mIndex] : nullptr;
   };
 
   ErrorCallback getErrorCallback() const { return mError; };
 
+  // Closes the timing of the command that is running, if any. Also marks
+  // the start of the chain the first time it is called.
+  void recordStep() {
+    mozilla::TimeStamp now = mozilla::TimeStamp::Now();
+    if (mStepTime.IsNull()) {
+      mStartTime = now;
+    } else if (mIndex < mLength) {
+      mStepLatencyMs.AppendElement((now - mStepTime).ToMilliseconds());
+    }
+    mStepTime = now;
+  }
+
+  // Time spent behind other chains in the queue.
+  double getQueuedMs() const {
+    return (mStartTime - mQueuedTime).ToMilliseconds();
+  }
+  double getRunningMs() const {
+    return (mStepTime - mStartTime).ToMilliseconds();
+  }
+  const nsTArray<double>& getStepLatencyMs() const { return mStepLatencyMs; }
+
  private:
   uint32_t mIndex;
   NetworkParams mParams;
   const CommandFunc* mCommands;
   uint32_t mLength;
   ErrorCallback mError;
+  mozilla::TimeStamp mQueuedTime;
+  mozilla::TimeStamp mStartTime;
+  mozilla::TimeStamp mStepTime;
+  nsTArray<double> mStepLatencyMs;
 };
 
 // A helper class to easily construct a resolved
@@ -373,6 +402,9 @@ class NetworkUtils final {
   static void removeIpv6TetheringInterfaces(PARAMS);
   static void updateIpv6Tethering(PARAMS);
   static void stopIpv6Tethering(PARAMS);
+  static void startTetherOffload(PARAMS);
+  static void stopTetherOffload(PARAMS);
+  static void updateTetherOffloadUpstream(PARAMS);
   static void usbTetheringSuccess(PARAMS);
   static void wifiTetheringSuccess(PARAMS);
   static void updateUpStreamSuccess(PARAMS);
@@ -0,0 +1,590 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "TetherOffload.h"
+
+#include "mozilla/StaticPrefs_network.h"
+#include "mozilla/StaticPtr.h"
+#include "nsPrintfCString.h"
+
+#include <android/log.h>
+#include <arpa/inet.h>
+#include <cutils/native_handle.h>
+#include <errno.h>
+#include <ifaddrs.h>
+#include <linux/netfilter/nfnetlink.h>
+#include <linux/netfilter/nfnetlink_compat.h>
+#include <linux/netfilter/nfnetlink_conntrack.h>
+#include <linux/netlink.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define LOG(args...) \
+  __android_log_print(ANDROID_LOG_DEBUG, "TetherOffload", ##args)
+#define WARN(args...) \
+  __android_log_print(ANDROID_LOG_WARN, "TetherOffload", ##args)
+
+using android::sp;
+using android::hardware::hidl_handle;
+using android::hardware::hidl_string;
+using android::hardware::hidl_vec;
+using android::hardware::Return;
+using android::hardware::Void;
+using android::hardware::tetheroffload::config::V1_0::IOffloadConfig;
+using android::hardware::tetheroffload::control::V1_0::IOffloadControl;
+using android::hardware::tetheroffload::control::V1_0::
+    ITetheringOffloadCallback;
+using android::hardware::tetheroffload::control::V1_0::NatTimeoutUpdate;
+using android::hardware::tetheroffload::control::V1_0::NetworkProtocol;
+using android::hardware::tetheroffload::control::V1_0::OffloadCallbackEvent;
+
+// Conntrack timeouts, in seconds, applied to the flows the hardware keeps
+// alive. The kernel sees none of their packets and would otherwise expire
+// them. These are the kernel's own defaults for established TCP and for UDP
+// streams.
+static const uint32_t kTcpConntrackTimeout = 432000;
+static const uint32_t kUdpConntrackTimeout = 180;
+
+static mozilla::StaticRefPtr<TetherOffload> sInstance;
+
+// Opens a conntrack netlink socket that receives the events of aGroups.
+static int OpenConntrackSocket(uint32_t aGroups) {
+  int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_NETFILTER);
+  if (fd < 0) {
+    return -1;
+  }
+
+  struct sockaddr_nl addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = aGroups;
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static bool ReadInterfaceCounter(const nsACString& aIfname,
+                                 const char* aCounter, uint64_t& aValue) {
+  nsPrintfCString path("/sys/class/net/%s/statistics/%s",
+                       PromiseFlatCString(aIfname).get(), aCounter);
+  FILE* file = fopen(path.get(), "re");
+  if (!file) {
+    return false;
+  }
+  unsigned long long value;
+  bool ok = fscanf(file, "%llu", &value) == 1;
+  fclose(file);
+  if (ok) {
+    aValue = value;
+  }
+  return ok;
+}
+
+static nsCString GetIpv4Address(const nsACString& aIfname) {
+  nsCString address;
+  struct ifaddrs* addrs;
+  if (getifaddrs(&addrs)) {
+    return address;
+  }
+  for (struct ifaddrs* ifa = addrs; ifa; ifa = ifa->ifa_next) {
+    if (ifa->ifa_addr && ifa->ifa_addr->sa_family == AF_INET &&
+        aIfname.Equals(ifa->ifa_name)) {
+      char buf[INET_ADDRSTRLEN];
+      auto* sin = reinterpret_cast<struct sockaddr_in*>(ifa->ifa_addr);
+      if (inet_ntop(AF_INET, &sin->sin_addr, buf, sizeof(buf))) {
+        address.Assign(buf);
+      }
+      break;
+    }
+  }
+  freeifaddrs(addrs);
+  return address;
+}
+
+static hidl_vec<hidl_string> ToHidlVec(const nsTArray<nsCString>& aStrings) {
+  hidl_vec<hidl_string> vec;
+  vec.resize(aStrings.Length());
+  for (size_t i = 0; i < aStrings.Length(); i++) {
+    vec[i] = aStrings[i].get();
+  }
+  return vec;
+}
+
+// Builds a netlink message with nested attributes.
+class NetlinkMessage {
+ public:
+  NetlinkMessage(uint16_t aType, uint16_t aFlags) {
+    struct nlmsghdr header;
+    memset(&header, 0, sizeof(header));
+    header.nlmsg_type = aType;
+    header.nlmsg_flags = aFlags;
+    AppendRaw(&header, sizeof(header));
+  }
+
+  void AppendRaw(const void* aData, size_t aLength) {
+    static const uint8_t kPadding[NLA_ALIGNTO] = {};
+    mBuffer.AppendElements(static_cast<const uint8_t*>(aData), aLength);
+    mBuffer.AppendElements(kPadding, NLA_ALIGN(aLength) - aLength);
+  }
+
+  size_t Append(uint16_t aType, const void* aData, size_t aLength) {
+    size_t offset = mBuffer.Length();
+    struct nlattr attr;
+    attr.nla_len = NLA_HDRLEN + aLength;
+    attr.nla_type = aType;
+    AppendRaw(&attr, sizeof(attr));
+    if (aLength) {
+      AppendRaw(aData, aLength);
+    }
+    return offset;
+  }
+
+  size_t BeginNested(uint16_t aType) {
+    return Append(aType | NLA_F_NESTED, nullptr, 0);
+  }
+
+  void EndNested(size_t aOffset) {
+    uint16_t length = mBuffer.Length() - aOffset;
+    memcpy(&mBuffer[aOffset], &length, sizeof(length));
+  }
+
+  bool Send(int aFd) {
+    uint32_t length = mBuffer.Length();
+    memcpy(&mBuffer[0], &length, sizeof(length));
+
+    struct sockaddr_nl kernel;
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+    return sendto(aFd, mBuffer.Elements(), mBuffer.Length(), 0,
+                  reinterpret_cast<struct sockaddr*>(&kernel),
+                  sizeof(kernel)) == ssize_t(mBuffer.Length());
+  }
+
+ private:
+  nsTArray<uint8_t> mBuffer;
+};
+
+// Receives the HAL's events on a hwbinder thread and forwards them to the
+// NetworkUtils thread.
+class TetherOffload::Callback final : public ITetheringOffloadCallback {
+ public:
+  explicit Callback(nsIEventTarget* aThread) : mThread(aThread) {}
+
+  Return<void> onEvent(OffloadCallbackEvent aEvent) override {
+    mThread->Dispatch(NS_NewRunnableFunction(
+        "TetherOffload::Callback::onEvent", [aEvent]() {
+          if (!sInstance) {
+            return;
+          }
+          switch (aEvent) {
+            case OffloadCallbackEvent::OFFLOAD_STARTED:
+              LOG("offload started");
+              sInstance->mStarted = true;
+              break;
+            case OffloadCallbackEvent::OFFLOAD_STOPPED_ERROR:
+            case OffloadCallbackEvent::OFFLOAD_STOPPED_UNSUPPORTED:
+            case OffloadCallbackEvent::OFFLOAD_STOPPED_LIMIT_REACHED:
+              sInstance->OnStopped();
+              break;
+            case OffloadCallbackEvent::OFFLOAD_SUPPORT_AVAILABLE:
+              sInstance->OnSupportAvailable();
+              break;
+          }
+        }));
+    return Void();
+  }
+
+  Return<void> updateTimeout(const NatTimeoutUpdate& aParams) override {
+    NatTimeoutUpdate params = aParams;
+    mThread->Dispatch(NS_NewRunnableFunction(
+        "TetherOffload::Callback::updateTimeout", [params]() {
+          if (sInstance) {
+            sInstance->RefreshConntrack(params);
+          }
+        }));
+    return Void();
+  }
+
+ private:
+  nsCOMPtr<nsIEventTarget> mThread;
+};
+
+TetherOffload::TetherOffload() : mStarted(false), mConntrackFd(-1) {}
+
+TetherOffload::~TetherOffload() {
+  if (mConntrackFd >= 0) {
+    close(mConntrackFd);
+  }
+}
+
+/* static */
+TetherOffload* TetherOffload::Get() {
+  if (!mozilla::StaticPrefs::network_tethering_offload_enabled()) {
+    return nullptr;
+  }
+  if (!sInstance) {
+    sInstance = new TetherOffload();
+  }
+  if (!sInstance->mControl && !sInstance->Init()) {
+    return nullptr;
+  }
+  return sInstance;
+}
+
+/* static */
+TetherOffload* TetherOffload::Peek() { return sInstance; }
+
+/* static */
+void TetherOffload::Shutdown() {
+  if (sInstance) {
+    sInstance->Stop();
+    sInstance = nullptr;
+  }
+}
+
+bool TetherOffload::Init() {
+  sp<IOffloadConfig> config = IOffloadConfig::getService();
+  sp<IOffloadControl> control = IOffloadControl::getService();
+  if (!config || !control) {
+    LOG("no tetheroffload HAL, forwarding in software");
+    return false;
+  }
+
+  // The HAL follows conntrack to learn which flows it may offload.
+  int fd1 = OpenConntrackSocket(NF_NETLINK_CONNTRACK_NEW |
+                                NF_NETLINK_CONNTRACK_DESTROY);
+  int fd2 = OpenConntrackSocket(NF_NETLINK_CONNTRACK_UPDATE |
+                                NF_NETLINK_CONNTRACK_DESTROY);
+  if (fd1 < 0 || fd2 < 0) {
+    WARN("cannot open conntrack sockets: %s", strerror(errno));
+    if (fd1 >= 0) {
+      close(fd1);
+    }
+    if (fd2 >= 0) {
+      close(fd2);
+    }
+    return false;
+  }
+
+  native_handle_t* handle1 = native_handle_create(1, 0);
+  native_handle_t* handle2 = native_handle_create(1, 0);
+  handle1->data[0] = fd1;
+  handle2->data[0] = fd2;
+
+  bool success = false;
+  // The HAL duplicates the descriptors it keeps.
+  Return<void> ret = config->setHandles(
+      hidl_handle(handle1), hidl_handle(handle2),
+      [&success](bool aSuccess, const hidl_string& aError) {
+        success = aSuccess;
+        if (!aSuccess) {
+          WARN("setHandles failed: %s", aError.c_str());
+        }
+      });
+  native_handle_close(handle1);
+  native_handle_close(handle2);
+  native_handle_delete(handle1);
+  native_handle_delete(handle2);
+  if (!ret.isOk() || !success) {
+    return false;
+  }
+
+  mThread = mozilla::GetCurrentEventTarget();
+  mCallback = new Callback(mThread);
+  ret = control->initOffload(
+      mCallback, [&success](bool aSuccess, const hidl_string& aError) {
+        success = aSuccess;
+        if (!aSuccess) {
+          WARN("initOffload failed: %s", aError.c_str());
+        }
+      });
+  if (!ret.isOk() || !success) {
+    mCallback = nullptr;
+    return false;
+  }
+
+  if (mConntrackFd < 0) {
+    mConntrackFd =
+        socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_NETFILTER);
+  }
+
+  LOG("tetheroffload HAL initialized");
+  mControl = control;
+  ApplyLocalPrefixes();
+  return true;
+}
+
+void TetherOffload::Stop() {
+  if (!mControl) {
+    return;
+  }
+
+  PollForwardedStats();
+  mControl->stopOffload([](bool aSuccess, const hidl_string& aError) {
+    if (!aSuccess) {
+      WARN("stopOffload failed: %s", aError.c_str());
+    }
+  });
+  mControl = nullptr;
+  mCallback = nullptr;
+  mStarted = false;
+}
+
+void TetherOffload::OnStopped() {
+  // The kernel path is still set up and takes the traffic over.
+  WARN("offload stopped by the hardware, forwarding in software");
+  mStarted = false;
+}
+
+void TetherOffload::OnSupportAvailable() {
+  if (!mControl) {
+    return;
+  }
+
+  // The hardware may have lost its configuration when it stopped.
+  LOG("offload available again");
+  ApplyLocalPrefixes();
+  for (const Downstream& downstream : mDownstreams) {
+    for (const nsCString& prefix : downstream.mPrefixes) {
+      mControl->addDownstream(downstream.mIfname.get(), prefix.get(),
+                              [](bool, const hidl_string&) {});
+    }
+  }
+  ApplyUpstream();
+}
+
+void TetherOffload::SetUpstream(const nsACString& aIfname,
+                                const nsTArray<nsCString>& aGateways) {
+  if (mUpstream.Equals(aIfname) && mUpstreamGateways == aGateways) {
+    return;
+  }
+
+  // Forwarded bytes are only reported for the current upstream.
+  PollForwardedStats();
+  mUpstream = aIfname;
+  mUpstreamGateways = aGateways.Clone();
+  ApplyLocalPrefixes();
+  ApplyUpstream();
+}
+
+void TetherOffload::ApplyUpstream() {
+  if (!mControl) {
+    return;
+  }
+
+  nsCString v4Address;
+  nsCString v4Gateway;
+  nsTArray<nsCString> v6Gateways;
+  if (!mUpstream.IsEmpty()) {
+    v4Address = GetIpv4Address(mUpstream);
+    for (const nsCString& gateway : mUpstreamGateways) {
+      if (gateway.Contains(':')) {
+        v6Gateways.AppendElement(gateway);
+      } else if (v4Gateway.IsEmpty()) {
+        v4Gateway = gateway;
+      }
+    }
+  }
+
+  mControl->setUpstreamParameters(
+      mUpstream.get(), v4Address.get(), v4Gateway.get(), ToHidlVec(v6Gateways),
+      [this](bool aSuccess, const hidl_string& aError) {
+        if (!aSuccess) {
+          WARN("setUpstreamParameters(%s) failed: %s", mUpstream.get(),
+               aError.c_str());
+        }
+      });
+}
+
+void TetherOffload::ApplyLocalPrefixes() {
+  if (!mControl) {
+    return;
+  }
+
+  // Traffic to and from these stays with the kernel.
+  nsTArray<nsCString> prefixes;
+  prefixes.AppendElement("127.0.0.0/8"_ns);
+  prefixes.AppendElement("::1/128"_ns);
+  prefixes.AppendElement("fe80::/64"_ns);
+  for (const Downstream& downstream : mDownstreams) {
+    prefixes.AppendElements(downstream.mPrefixes);
+  }
+  if (!mUpstream.IsEmpty()) {
+    nsCString address = GetIpv4Address(mUpstream);
+    if (!address.IsEmpty()) {
+      address.AppendLiteral("/32");
+      prefixes.AppendElement(address);
+    }
+  }
+
+  mControl->setLocalPrefixes(
+      ToHidlVec(prefixes), [](bool aSuccess, const hidl_string& aError) {
+        if (!aSuccess) {
+          WARN("setLocalPrefixes failed: %s", aError.c_str());
+        }
+      });
+}
+
+void TetherOffload::AddDownstream(const nsACString& aIfname,
+                                  const nsTArray<nsCString>& aPrefixes) {
+  RemoveDownstream(aIfname);
+
+  Downstream* downstream = mDownstreams.AppendElement();
+  downstream->mIfname = aIfname;
+  downstream->mPrefixes = aPrefixes.Clone();
+  ReadInterfaceCounter(aIfname, "rx_bytes", downstream->mRxBytes);
+  ReadInterfaceCounter(aIfname, "tx_bytes", downstream->mTxBytes);
+  downstream->mSampled = mozilla::TimeStamp::Now();
+
+  if (!mControl) {
+    return;
+  }
+  ApplyLocalPrefixes();
+  for (const nsCString& prefix : aPrefixes) {
+    mControl->addDownstream(
+        downstream->mIfname.get(), prefix.get(),
+        [&prefix](bool aSuccess, const hidl_string& aError) {
+          if (!aSuccess) {
+            WARN("addDownstream(%s) failed: %s", prefix.get(),
+                 aError.c_str());
+          }
+        });
+  }
+}
+
+void TetherOffload::RemoveDownstream(const nsACString& aIfname) {
+  for (size_t i = 0; i < mDownstreams.Length(); i++) {
+    if (!mDownstreams[i].mIfname.Equals(aIfname)) {
+      continue;
+    }
+    if (mControl) {
+      for (const nsCString& prefix : mDownstreams[i].mPrefixes) {
+        mControl->removeDownstream(mDownstreams[i].mIfname.get(),
+                                   prefix.get(),
+                                   [](bool, const hidl_string&) {});
+      }
+    }
+    mDownstreams.RemoveElementAt(i);
+    break;
+  }
+
+  // Let the hardware idle when nothing is tethered any more.
+  if (mDownstreams.IsEmpty()) {
+    Stop();
+  }
+}
+
+void TetherOffload::PollForwardedStats() {
+  if (!mControl || mUpstream.IsEmpty()) {
+    return;
+  }
+
+  // The HAL reports the bytes forwarded since the previous call.
+  mControl->getForwardedStats(
+      mUpstream.get(), [this](uint64_t aRxBytes, uint64_t aTxBytes) {
+        ForwardedBytes& forwarded = mForwarded.LookupOrInsert(mUpstream);
+        forwarded.mRxBytes += aRxBytes;
+        forwarded.mTxBytes += aTxBytes;
+      });
+}
+
+void TetherOffload::AddForwardedStats(const nsACString& aUpstream,
+                                      uint64_t& aRxBytes, uint64_t& aTxBytes) {
+  PollForwardedStats();
+  if (auto forwarded = mForwarded.Lookup(aUpstream)) {
+    aRxBytes += forwarded->mRxBytes;
+    aTxBytes += forwarded->mTxBytes;
+  }
+}
+
+void TetherOffload::UpdateDownstreamStats() {
+  mozilla::TimeStamp now = mozilla::TimeStamp::Now();
+  for (Downstream& downstream : mDownstreams) {
+    uint64_t rxBytes = downstream.mRxBytes;
+    uint64_t txBytes = downstream.mTxBytes;
+    if (!ReadInterfaceCounter(downstream.mIfname, "rx_bytes", rxBytes) ||
+        !ReadInterfaceCounter(downstream.mIfname, "tx_bytes", txBytes)) {
+      continue;
+    }
+
+    double seconds = (now - downstream.mSampled).ToSeconds();
+    if (seconds > 0 && rxBytes >= downstream.mRxBytes &&
+        txBytes >= downstream.mTxBytes) {
+      LOG("%s: rx %.0f B/s, tx %.0f B/s%s", downstream.mIfname.get(),
+          (rxBytes - downstream.mRxBytes) / seconds,
+          (txBytes - downstream.mTxBytes) / seconds,
+          mStarted ? " (kernel path only)" : "");
+    }
+    downstream.mRxBytes = rxBytes;
+    downstream.mTxBytes = txBytes;
+    downstream.mSampled = now;
+  }
+}
+
+void TetherOffload::RefreshConntrack(const NatTimeoutUpdate& aUpdate) {
+  if (mConntrackFd < 0) {
+    return;
+  }
+
+  struct in_addr src, dst;
+  if (!inet_aton(aUpdate.src.addr.c_str(), &src) ||
+      !inet_aton(aUpdate.dst.addr.c_str(), &dst)) {
+    return;
+  }
+
+  NetlinkMessage msg((NFNL_SUBSYS_CTNETLINK << 8) | IPCTNL_MSG_CT_NEW,
+                     NLM_F_REQUEST | NLM_F_REPLACE);
+  struct nfgenmsg header;
+  memset(&header, 0, sizeof(header));
+  header.nfgen_family = AF_INET;
+  header.version = NFNETLINK_V0;
+  msg.AppendRaw(&header, sizeof(header));
+
+  size_t tuple = msg.BeginNested(CTA_TUPLE_ORIG);
+  size_t ip = msg.BeginNested(CTA_TUPLE_IP);
+  msg.Append(CTA_IP_V4_SRC, &src.s_addr, sizeof(src.s_addr));
+  msg.Append(CTA_IP_V4_DST, &dst.s_addr, sizeof(dst.s_addr));
+  msg.EndNested(ip);
+  size_t proto = msg.BeginNested(CTA_TUPLE_PROTO);
+  uint8_t protoNum = static_cast<uint8_t>(aUpdate.proto);
+  uint16_t srcPort = htons(aUpdate.src.port);
+  uint16_t dstPort = htons(aUpdate.dst.port);
+  msg.Append(CTA_PROTO_NUM, &protoNum, sizeof(protoNum));
+  msg.Append(CTA_PROTO_SRC_PORT, &srcPort, sizeof(srcPort));
+  msg.Append(CTA_PROTO_DST_PORT, &dstPort, sizeof(dstPort));
+  msg.EndNested(proto);
+  msg.EndNested(tuple);
+
+  uint32_t timeout = htonl(aUpdate.proto == NetworkProtocol::TCP
+                               ? kTcpConntrackTimeout
+                               : kUdpConntrackTimeout);
+  msg.Append(CTA_TIMEOUT, &timeout, sizeof(timeout));
+
+  if (!msg.Send(mConntrackFd)) {
+    WARN("cannot refresh conntrack entry: %s", strerror(errno));
+  }
+}
+
+/* static */
+bool TetherOffload::Ipv4Prefix(const char* aIp, uint32_t aPrefixLength,
+                               nsACString& aPrefix) {
+  struct in_addr addr;
+  if (!inet_aton(aIp, &addr) || aPrefixLength > 32) {
+    return false;
+  }
+
+  uint32_t mask = aPrefixLength ? ~0u << (32 - aPrefixLength) : 0;
+  addr.s_addr = htonl(ntohl(addr.s_addr) & mask);
+  char buf[INET_ADDRSTRLEN];
+  if (!inet_ntop(AF_INET, &addr, buf, sizeof(buf))) {
+    return false;
+  }
+  aPrefix.Assign(buf);
+  aPrefix.AppendPrintf("/%u", aPrefixLength);
+  return true;
+}
@@ -0,0 +1,110 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef TetherOffload_h
+#define TetherOffload_h
+
+#include "mozilla/TimeStamp.h"
+#include "nsISupportsImpl.h"
+#include "nsString.h"
+#include "nsTArray.h"
+#include "nsTHashMap.h"
+#include "nsThreadUtils.h"
+
+#include <android/hardware/tetheroffload/config/1.0/IOffloadConfig.h>
+#include <android/hardware/tetheroffload/control/1.0/IOffloadControl.h>
+
+// TetherOffload hands tethered traffic over to the forwarding hardware of
+// the SoC through the tetheroffload HAL, when the device has one and
+// network.tethering.offload.enabled is set.
+//
+// Offload is best effort. netd sets up the kernel forwarding path as usual,
+// so traffic falls back to it whenever the HAL is missing, rejects part of
+// the configuration or stops offloading on its own.
+//
+// Traffic forwarded by the hardware bypasses the kernel's counters. The
+// bytes the HAL reports for each upstream are kept here so that they can be
+// added to netd's tether statistics. Per-downstream throughput is sampled
+// from the kernel's interface counters.
+//
+// Must only be used on the NetworkUtils thread.
+class TetherOffload final {
+ public:
+  NS_INLINE_DECL_THREADSAFE_REFCOUNTING(TetherOffload)
+
+  // Returns nullptr if offload is disabled by pref or the HAL can't be
+  // initialized, in which case the next call tries again.
+  static TetherOffload* Get();
+  // Returns the instance if there is one, without initializing the HAL.
+  static TetherOffload* Peek();
+  static void Shutdown();
+
+  // Sets the interface tethered traffic leaves through. aGateways may hold
+  // both IPv4 and IPv6 gateways.
+  void SetUpstream(const nsACString& aIfname,
+                   const nsTArray<nsCString>& aGateways);
+
+  // aPrefixes are the IPv4 and IPv6 prefixes served on aIfname, in
+  // "address/length" form.
+  void AddDownstream(const nsACString& aIfname,
+                     const nsTArray<nsCString>& aPrefixes);
+  void RemoveDownstream(const nsACString& aIfname);
+
+  // Adds the bytes the hardware forwarded for aUpstream so far.
+  void AddForwardedStats(const nsACString& aUpstream, uint64_t& aRxBytes,
+                         uint64_t& aTxBytes);
+
+  // Samples the counters of every downstream and logs their throughput since
+  // the previous sample.
+  void UpdateDownstreamStats();
+
+  // The network prefix of aIp/aPrefixLength, e.g. "192.168.42.0/24".
+  static bool Ipv4Prefix(const char* aIp, uint32_t aPrefixLength,
+                         nsACString& aPrefix);
+
+ private:
+  struct Downstream {
+    nsCString mIfname;
+    nsTArray<nsCString> mPrefixes;
+    uint64_t mRxBytes = 0;
+    uint64_t mTxBytes = 0;
+    mozilla::TimeStamp mSampled;
+  };
+
+  struct ForwardedBytes {
+    uint64_t mRxBytes = 0;
+    uint64_t mTxBytes = 0;
+  };
+
+  class Callback;
+
+  TetherOffload();
+  ~TetherOffload();
+
+  bool Init();
+  void Stop();
+  void OnStopped();
+  void OnSupportAvailable();
+  void ApplyUpstream();
+  void ApplyLocalPrefixes();
+  void PollForwardedStats();
+  void RefreshConntrack(
+      const android::hardware::tetheroffload::control::V1_0::NatTimeoutUpdate&
+          aUpdate);
+
+  android::sp<android::hardware::tetheroffload::control::V1_0::IOffloadControl>
+      mControl;
+  android::sp<Callback> mCallback;
+  nsCOMPtr<nsIEventTarget> mThread;
+  // Whether the hardware is currently forwarding.
+  bool mStarted;
+  int mConntrackFd;
+
+  nsCString mUpstream;
+  nsTArray<nsCString> mUpstreamGateways;
+  nsTArray<Downstream> mDownstreams;
+  nsTHashMap<nsCStringHashKey, ForwardedBytes> mForwarded;
+};
+
+#endif
@@ -5,16 +5,37 @@
  * You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "TrafficStats.h"
+#include <algorithm>
 #include <inttypes.h>
 
+#include "mozilla/DebugOnly.h"
+#include "nsPrintfCString.h"
+#include "nsThreadUtils.h"
+
 using android::bpf::bpfGetIfaceStats;
 using android::bpf::stats_line;
 
 namespace mozilla {
 
-TrafficStats::TrafficStats() {}
+// Polling faster than this costs more in map walks than it tells anyone.
+static const uint32_t kMinIntervalMs = 1000;
+
+// Arguments to parseBpfNetworkStatsDetail(): restricting to tag 0 returns
+// the untagged rows, which already include the traffic of tagged sockets.
+static const int kUntagged = 0;
+static const int kAllUids = -1;
+
+TrafficStats::TrafficStats() : mIntervalMs(0) {
+  DebugOnly<nsresult> rv = NS_CreateBackgroundTaskQueue(
+      "TrafficStats", getter_AddRefs(mTaskQueue));
+  MOZ_ASSERT(NS_SUCCEEDED(rv));
+}
 
-TrafficStats::~TrafficStats() {}
+TrafficStats::~TrafficStats() {
+  if (mTimer) {
+    mTimer->Cancel();
+  }
+}
 
 //-----------------------------------------------------------------------------
 // TrafficStats::nsISupports
@@ -40,6 +61,180 @@ TrafficStats::GetStats(nsTArray<RefPtr<nsIStatsInfo>>& aStatsInfos) {
   return NS_OK;
 }
 
+NS_IMETHODIMP
+TrafficStats::GetStatsByUid(nsTArray<RefPtr<nsIStatsInfo>>& aStatsInfos) {
+  Snapshot snapshot;
+  ReadUidStats(snapshot);
+  for (auto iter = snapshot.ConstIter(); !iter.Done(); iter.Next()) {
+    const UidCounters& counters = iter.Data();
+    RefPtr<nsIStatsInfo> statsInfo = new StatsInfo(
+        counters.mName, counters.mRxBytes, counters.mRxPackets,
+        counters.mTxBytes, counters.mTxPackets, counters.mUid);
+    aStatsInfos.AppendElement(std::move(statsInfo));
+  }
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+TrafficStats::AddListener(nsITrafficStatsListener* aListener,
+                          uint32_t aIntervalMs) {
+  MOZ_ASSERT(NS_IsMainThread());
+  NS_ENSURE_ARG(aListener);
+
+  for (Listener& listener : mListeners) {
+    if (listener.mListener == aListener) {
+      listener.mIntervalMs = aIntervalMs;
+      UpdateTimer();
+      return NS_OK;
+    }
+  }
+  mListeners.AppendElement(Listener{aListener, aIntervalMs});
+  UpdateTimer();
+  return NS_OK;
+}
+
+NS_IMETHODIMP
+TrafficStats::RemoveListener(nsITrafficStatsListener* aListener) {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  mListeners.RemoveElementsBy([aListener](const Listener& aEntry) {
+    return aEntry.mListener == aListener;
+  });
+  UpdateTimer();
+  return NS_OK;
+}
+
+void TrafficStats::UpdateTimer() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (mListeners.IsEmpty()) {
+    if (mTimer) {
+      mTimer->Cancel();
+      mTimer = nullptr;
+      mIntervalMs = 0;
+      mTaskQueue->Dispatch(
+          NewRunnableMethod<bool>("TrafficStats::ResetBaseline", this,
+                                  &TrafficStats::ResetBaseline, false),
+          NS_DISPATCH_NORMAL);
+    }
+    return;
+  }
+
+  uint32_t interval = UINT32_MAX;
+  for (const Listener& listener : mListeners) {
+    interval = std::min(interval, listener.mIntervalMs);
+  }
+  interval = std::max(interval, kMinIntervalMs);
+
+  if (mTimer) {
+    if (interval != mIntervalMs) {
+      mIntervalMs = interval;
+      mTimer->SetDelay(interval);
+    }
+    return;
+  }
+
+  // The first delta is counted from the moment someone started listening.
+  mTaskQueue->Dispatch(
+      NewRunnableMethod<bool>("TrafficStats::ResetBaseline", this,
+                              &TrafficStats::ResetBaseline, true),
+      NS_DISPATCH_NORMAL);
+
+  RefPtr<TrafficStats> self = this;
+  nsresult rv = NS_NewTimerWithCallback(
+      getter_AddRefs(mTimer), [self](nsITimer*) { self->Poll(); },
+      TimeDuration::FromMilliseconds(interval),
+      nsITimer::TYPE_REPEATING_SLACK, "TrafficStats::Poll", mTaskQueue);
+  if (NS_WARN_IF(NS_FAILED(rv))) {
+    mTimer = nullptr;
+    return;
+  }
+  mIntervalMs = interval;
+}
+
+/* static */
+void TrafficStats::ReadUidStats(Snapshot& aSnapshot) {
+  std::vector<stats_line> lines;
+  if (parseBpfNetworkStatsDetail(&lines, std::vector<std::string>(), kUntagged,
+                                 kAllUids) != 0) {
+    return;
+  }
+
+  // There is a row per counter set (foreground/background); fold them.
+  for (const stats_line& line : lines) {
+    nsPrintfCString key("%s:%d", line.iface, int32_t(line.uid));
+    UidCounters& counters = aSnapshot.LookupOrInsertWith(key, [&] {
+      return UidCounters{nsCString(line.iface), int32_t(line.uid), 0, 0, 0, 0};
+    });
+    counters.mRxBytes += line.rxBytes;
+    counters.mRxPackets += line.rxPackets;
+    counters.mTxBytes += line.txBytes;
+    counters.mTxPackets += line.txPackets;
+  }
+}
+
+void TrafficStats::ResetBaseline(bool aTakeSnapshot) {
+  MOZ_ASSERT(mTaskQueue->IsOnCurrentThread());
+
+  mLastSnapshot.Clear();
+  if (aTakeSnapshot) {
+    ReadUidStats(mLastSnapshot);
+  }
+}
+
+void TrafficStats::Poll() {
+  MOZ_ASSERT(mTaskQueue->IsOnCurrentThread());
+
+  Snapshot snapshot;
+  ReadUidStats(snapshot);
+
+  nsTArray<RefPtr<nsIStatsInfo>> deltas;
+  for (auto iter = snapshot.ConstIter(); !iter.Done(); iter.Next()) {
+    const UidCounters& now = iter.Data();
+    UidCounters delta = now;
+    if (auto last = mLastSnapshot.Lookup(iter.Key())) {
+      // Counters only go backwards when the uid's entry was deleted and
+      // recreated, in which case everything in it is new.
+      if (now.mRxBytes >= last->mRxBytes && now.mTxBytes >= last->mTxBytes &&
+          now.mRxPackets >= last->mRxPackets &&
+          now.mTxPackets >= last->mTxPackets) {
+        delta.mRxBytes -= last->mRxBytes;
+        delta.mRxPackets -= last->mRxPackets;
+        delta.mTxBytes -= last->mTxBytes;
+        delta.mTxPackets -= last->mTxPackets;
+      }
+    }
+    if (!delta.mRxPackets && !delta.mTxPackets) {
+      continue;
+    }
+    deltas.AppendElement(new StatsInfo(delta.mName, delta.mRxBytes,
+                                       delta.mRxPackets, delta.mTxBytes,
+                                       delta.mTxPackets, delta.mUid));
+  }
+  mLastSnapshot.SwapElements(snapshot);
+
+  if (deltas.IsEmpty()) {
+    return;
+  }
+  using Deltas = nsTArray<RefPtr<nsIStatsInfo>>;
+  NS_DispatchToMainThread(NewRunnableMethod<StoreCopyPassByRRef<Deltas>>(
+      "TrafficStats::NotifyListeners", this, &TrafficStats::NotifyListeners,
+      std::move(deltas)));
+}
+
+void TrafficStats::NotifyListeners(nsTArray<RefPtr<nsIStatsInfo>>&& aDeltas) {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  // A listener may remove itself from its callback.
+  nsTArray<nsCOMPtr<nsITrafficStatsListener>> listeners;
+  for (const Listener& listener : mListeners) {
+    listeners.AppendElement(listener.mListener);
+  }
+  for (nsITrafficStatsListener* listener : listeners) {
+    listener->OnStatsChanged(aDeltas);
+  }
+}
+
 //-----------------------------------------------------------------------------
 // StatsInfo::nsISupports
 //-----------------------------------------------------------------------------
@@ -50,12 +245,13 @@ NS_IMPL_ISUPPORTS(StatsInfo, nsIStatsInfo)
 //-----------------------------------------------------------------------------
 StatsInfo::StatsInfo(const nsCString& aInterface, const int64_t aRxBytes,
                      const int64_t aRxPackets, const int64_t aTxBytes,
-                     const int64_t aTxPackets)
+                     const int64_t aTxPackets, const int32_t aUid)
     : mName(aInterface),
       mRxBytes(aRxBytes),
       mRxPackets(aRxPackets),
       mTxBytes(aTxBytes),
-      mTxPackets(aTxPackets) {}
+      mTxPackets(aTxPackets),
+      mUid(aUid) {}
 
 NS_IMETHODIMP
 StatsInfo::GetName(nsACString& aName) {
@@ -87,6 +283,12 @@ StatsInfo::GetTxPackets(int64_t* aTxPackets) {
   return NS_OK;
 }
 
+NS_IMETHODIMP
+StatsInfo::GetUid(int32_t* aUid) {
+  *aUid = mUid;
+  return NS_OK;
+}
+
 }  // namespace mozilla
 
 already_AddRefed<nsITrafficStats> NS_CreateTrafficStats() {
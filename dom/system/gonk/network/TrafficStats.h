@@ -7,24 +7,68 @@
 #ifndef moziila_TrafficStats_H
 #define moziila_TrafficStats_H
 
+#include "nsCOMPtr.h"
+#include "nsHashKeys.h"
+#include "nsITimer.h"
 #include "nsITrafficStats.h"
 #include "nsString.h"
+#include "nsTArray.h"
+#include "nsTHashMap.h"
 #include "bpf/BpfUtils.h"
 #include "netdbpf/BpfNetworkStats.h"
 
 using android::bpf::Stats;
 
+class nsISerialEventTarget;
+
 namespace mozilla {
 
 class TrafficStats final : public nsITrafficStats {
  public:
-  NS_DECL_ISUPPORTS
+  NS_DECL_THREADSAFE_ISUPPORTS
   NS_DECL_NSITRAFFICSTATS
 
   TrafficStats();
 
  protected:
   virtual ~TrafficStats();
+
+ private:
+  struct Listener {
+    nsCOMPtr<nsITrafficStatsListener> mListener;
+    uint32_t mIntervalMs;
+  };
+
+  struct UidCounters {
+    nsCString mName;
+    int32_t mUid;
+    int64_t mRxBytes;
+    int64_t mRxPackets;
+    int64_t mTxBytes;
+    int64_t mTxPackets;
+  };
+
+  using Snapshot = nsTHashMap<nsCStringHashKey, UidCounters>;
+
+  static void ReadUidStats(Snapshot& aSnapshot);
+
+  // Starts, retunes or stops the poll timer to match mListeners.
+  void UpdateTimer();
+
+  // Run on mTaskQueue.
+  void Poll();
+  void ResetBaseline(bool aTakeSnapshot);
+
+  void NotifyListeners(nsTArray<RefPtr<nsIStatsInfo>>&& aDeltas);
+
+  // Main thread only.
+  nsTArray<Listener> mListeners;
+  nsCOMPtr<nsITimer> mTimer;
+  uint32_t mIntervalMs;
+
+  nsCOMPtr<nsISerialEventTarget> mTaskQueue;
+  // Only touched on mTaskQueue.
+  Snapshot mLastSnapshot;
 };
 
 class StatsInfo : public nsIStatsInfo {
@@ -34,7 +78,7 @@ class StatsInfo : public nsIStatsInfo {
 
   StatsInfo(const nsCString& aInterface, const int64_t aRxBytes,
             const int64_t aRxPackets, const int64_t aTxBytes,
-            const int64_t aTxPackets);
+            const int64_t aTxPackets, const int32_t aUid = -1);
 
  protected:
   virtual ~StatsInfo() = default;
@@ -45,6 +89,7 @@ class StatsInfo : public nsIStatsInfo {
   const int64_t mRxPackets;
   const int64_t mTxBytes;
   const int64_t mTxPackets;
+  const int32_t mUid;
 };
 
 }  // namespace mozilla
@@ -7,6 +7,9 @@
 #include "nsRilIndication.h"
 #include "nsRilWorker.h"
 
+#include "mozilla/DebugOnly.h"
+#include "mozilla/StaticPrefs_ril.h"
+
 /* Logging related */
 #undef LOG_TAG
 #define LOG_TAG "RilIndication"
@@ -23,17 +26,100 @@
     }                                                          \
   } while (0)
 
+// Whether any field moved by at least aThreshold since aOld. Fields going to
+// or from "unknown" (INT_MAX, or 99 for GSM) always count as a move.
+static bool SignalStrengthMoved(const SignalStrength& aOld,
+                                const SignalStrength& aNew,
+                                uint32_t aThreshold) {
+  auto moved = [aThreshold](int64_t aFrom, int64_t aTo) {
+    return aFrom != aTo &&
+           uint64_t(aFrom > aTo ? aFrom - aTo : aTo - aFrom) >= aThreshold;
+  };
+  return moved(aOld.gw.signalStrength, aNew.gw.signalStrength) ||
+         moved(aOld.gw.bitErrorRate, aNew.gw.bitErrorRate) ||
+         moved(aOld.cdma.dbm, aNew.cdma.dbm) ||
+         moved(aOld.cdma.ecio, aNew.cdma.ecio) ||
+         moved(aOld.evdo.dbm, aNew.evdo.dbm) ||
+         moved(aOld.evdo.ecio, aNew.evdo.ecio) ||
+         moved(aOld.evdo.signalNoiseRatio, aNew.evdo.signalNoiseRatio) ||
+         moved(aOld.lte.signalStrength, aNew.lte.signalStrength) ||
+         moved(aOld.lte.rsrp, aNew.lte.rsrp) ||
+         moved(aOld.lte.rsrq, aNew.lte.rsrq) ||
+         moved(aOld.lte.rssnr, aNew.lte.rssnr) ||
+         moved(aOld.lte.cqi, aNew.lte.cqi) ||
+         moved(aOld.lte.timingAdvance, aNew.lte.timingAdvance) ||
+         moved(aOld.tdScdma.rscp, aNew.tdScdma.rscp);
+}
+
+// Cell info lists carry the time of measurement, which changes with every
+// report; only the cells themselves are compared.
+static bool SameCellInfoList(const hidl_vec<CellInfo>& aOld,
+                             const hidl_vec<CellInfo>& aNew) {
+  if (aOld.size() != aNew.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < aNew.size(); i++) {
+    CellInfo cell = aNew[i];
+    cell.timeStamp = aOld[i].timeStamp;
+    if (cell != aOld[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Cell broadcast PDU layout, see 3GPP TS 23.041 section 9.4.
+static const size_t kCbMessageHeaderSize = 6;
+static const size_t kCbMessageSizeGsm = 88;
+static const size_t kCbMessageSizeUmtsMin = 90;
+static const size_t kCbMessageSizeUmtsMax = 1252;
+static const uint8_t kCbUmtsMessageTypeCbs = 1;
+static const uint8_t kCbGeographicalScopePlmnWide = 1;
+
+// Number of cell broadcast pages remembered for duplicate detection.
+static const size_t kMaxReceivedCbPages = 64;
+
+// Reads the header fields that identify a cell broadcast page. A GSM or ETWS
+// PDU carries one page of a message and a UMTS PDU all of them, so mPage is
+// the page parameter for the former and 0 for the latter.
+static bool ReadCbPageKey(const hidl_vec<uint8_t>& aPdu,
+                          nsRilIndication::CbPageKey& aKey) {
+  size_t length = aPdu.size();
+  if (length >= kCbMessageHeaderSize && length <= kCbMessageSizeGsm) {
+    aKey.mSerial = (aPdu[0] << 8) | aPdu[1];
+    aKey.mMessageId = (aPdu[2] << 8) | aPdu[3];
+    aKey.mPage = aPdu[5];
+    return true;
+  }
+  if (length >= kCbMessageSizeUmtsMin && length <= kCbMessageSizeUmtsMax &&
+      aPdu[0] == kCbUmtsMessageTypeCbs) {
+    aKey.mMessageId = (aPdu[1] << 8) | aPdu[2];
+    aKey.mSerial = (aPdu[3] << 8) | aPdu[4];
+    aKey.mPage = 0;
+    return true;
+  }
+  return false;
+}
+
 /**
  *
  */
-nsRilIndication::nsRilIndication(nsRilWorker* aRil) {
+nsRilIndication::nsRilIndication(nsRilWorker* aRil)
+    : mLastIndicationsLock("nsRilIndication::mLastIndicationsLock") {
   DEBUG("init nsRilIndication");
   mRIL = aRil;
+  mozilla::DebugOnly<nsresult> rv =
+      NS_CreateBackgroundTaskQueue("RilIndication", getter_AddRefs(mTaskQueue));
+  MOZ_ASSERT(NS_SUCCEEDED(rv));
   DEBUG("init nsRilIndication done");
 }
 
 nsRilIndication::~nsRilIndication() {
   DEBUG("Destructor nsRilIndication");
+  if (mNetworkStateTimer) {
+    mNetworkStateTimer->Cancel();
+    mNetworkStateTimer = nullptr;
+  }
   mRIL = nullptr;
   MOZ_ASSERT(!mRIL);
 }
@@ -42,6 +128,9 @@ Return<void> nsRilIndication::radioStateChanged(RadioIndicationType type,
                                                 RadioState radioState) {
   DEBUG("radioStateChanged");
   mRIL->processIndication(type);
+  // Whatever was reported before no longer holds, so pass the next values on
+  // even if they match.
+  resetLastIndications();
 
   nsString rilmessageType(u"radiostatechange"_ns);
   RefPtr<nsRilIndicationResult> result =
@@ -57,7 +146,46 @@ Return<void> nsRilIndication::callStateChanged(RadioIndicationType type) {
 }
 
 Return<void> nsRilIndication::networkStateChanged(RadioIndicationType type) {
-  defaultResponse(type, u"networkStateChanged"_ns);
+  DEBUG("networkStateChanged");
+  mRIL->processIndication(type);
+
+  {
+    mozilla::MutexAutoLock lock(mLastIndicationsLock);
+    // We may be in another cell or location area now, where the same cell
+    // broadcast is a new message. Only PLMN wide ones stay duplicates.
+    mReceivedCbPages.RemoveElementsBy([](const ReceivedCbPage& aPage) {
+      return aPage.mKey.GeographicalScope() != kCbGeographicalScopePlmnWide;
+    });
+
+    if (mNetworkStateTimer) {
+      // Already going out once the interval is up.
+      mRIL->noteIndicationFiltered(u"networkStateChanged"_ns);
+      return Void();
+    }
+
+    mozilla::TimeDuration interval = mozilla::TimeDuration::FromMilliseconds(
+        mozilla::StaticPrefs::ril_indication_network_state_interval_ms());
+    mozilla::TimeStamp now = mozilla::TimeStamp::Now();
+    if (!mLastNetworkStateForwarded.IsNull() &&
+        now - mLastNetworkStateForwarded < interval) {
+      RefPtr<nsRilWorker> ril = mRIL;
+      nsresult rv = NS_NewTimerWithCallback(
+          getter_AddRefs(mNetworkStateTimer),
+          [this, ril](nsITimer*) { forwardNetworkStateChanged(); },
+          mLastNetworkStateForwarded + interval - now, nsITimer::TYPE_ONE_SHOT,
+          "nsRilIndication::networkStateChanged", mTaskQueue);
+      if (NS_SUCCEEDED(rv)) {
+        mRIL->noteIndicationFiltered(u"networkStateChanged"_ns);
+        return Void();
+      }
+      mNetworkStateTimer = nullptr;
+    }
+    mLastNetworkStateForwarded = now;
+  }
+
+  RefPtr<nsRilIndicationResult> result =
+      new nsRilIndicationResult(u"networkStateChanged"_ns);
+  mRIL->sendRilIndicationResult(result);
   return Void();
 }
 
@@ -150,6 +278,19 @@ Return<void> nsRilIndication::currentSignalStrength(
   DEBUG("currentSignalStrength");
   mRIL->processIndication(type);
 
+  {
+    mozilla::MutexAutoLock lock(mLastIndicationsLock);
+    if (mLastSignalStrength &&
+        !SignalStrengthMoved(
+            *mLastSignalStrength, sig_strength,
+            mozilla::StaticPrefs::ril_indication_signal_strength_threshold())) {
+      DEBUG("currentSignalStrength unchanged");
+      mRIL->noteIndicationFiltered(u"signalstrengthchange"_ns);
+      return Void();
+    }
+    mLastSignalStrength = mozilla::Some(sig_strength);
+  }
+
   nsString rilmessageType(u"signalstrengthchange"_ns);
 
   RefPtr<nsRilIndicationResult> result =
@@ -292,6 +433,12 @@ Return<void> nsRilIndication::newBroadcastSms(
     const ::android::hardware::hidl_vec<uint8_t>& data) {
   mRIL->processIndication(type);
 
+  if (isDuplicateCbPage(data)) {
+    DEBUG("newBroadcastSms: dropping duplicated page");
+    mRIL->noteIndicationFiltered(u"cellbroadcast-received"_ns);
+    return Void();
+  }
+
   nsString rilmessageType(u"cellbroadcast-received"_ns);
   RefPtr<nsRilIndicationResult> result =
       new nsRilIndicationResult(rilmessageType);
@@ -390,6 +537,7 @@ Return<void> nsRilIndication::exitEmergencyCallbackMode(
 }
 
 Return<void> nsRilIndication::rilConnected(RadioIndicationType type) {
+  resetLastIndications();
   defaultResponse(type, u"rilconnected"_ns);
   return Void();
 }
@@ -415,6 +563,16 @@ Return<void> nsRilIndication::cellInfoList(
   DEBUG("cellInfoList");
   mRIL->processIndication(type);
 
+  {
+    mozilla::MutexAutoLock lock(mLastIndicationsLock);
+    if (mLastCellInfoList && SameCellInfoList(*mLastCellInfoList, records)) {
+      DEBUG("cellInfoList unchanged");
+      mRIL->noteIndicationFiltered(u"cellInfoList"_ns);
+      return Void();
+    }
+    mLastCellInfoList = mozilla::Some(records);
+  }
+
   RefPtr<nsRilIndicationResult> result =
       new nsRilIndicationResult(u"cellInfoList"_ns);
   uint32_t numCellInfo = records.size();
@@ -580,6 +738,7 @@ Return<void> nsRilIndication::modemReset(
     RadioIndicationType type, const ::android::hardware::hidl_string& reason) {
   DEBUG("modemReset");
   mRIL->processIndication(type);
+  resetLastIndications();
 
   nsString rilmessageType(u"modemReset"_ns);
 
@@ -609,6 +768,54 @@ Return<void> nsRilIndication::keepaliveStatus(
 }
 
 // Helper function
+void nsRilIndication::resetLastIndications() {
+  mozilla::MutexAutoLock lock(mLastIndicationsLock);
+  mLastSignalStrength.reset();
+  mLastCellInfoList.reset();
+  mReceivedCbPages.Clear();
+}
+
+bool nsRilIndication::isDuplicateCbPage(const hidl_vec<uint8_t>& aPdu) {
+  CbPageKey key;
+  if (!ReadCbPageKey(aPdu, key)) {
+    // Let RadioInterfaceLayer report the malformed PDU.
+    return false;
+  }
+
+  mozilla::TimeDuration window = mozilla::TimeDuration::FromSeconds(
+      mozilla::StaticPrefs::ril_indication_cell_broadcast_duplicate_window());
+  mozilla::TimeStamp now = mozilla::TimeStamp::Now();
+
+  mozilla::MutexAutoLock lock(mLastIndicationsLock);
+  mReceivedCbPages.RemoveElementsBy([&](const ReceivedCbPage& aPage) {
+    return now - aPage.mReceived >= window;
+  });
+  for (const ReceivedCbPage& page : mReceivedCbPages) {
+    if (page.mKey == key) {
+      return true;
+    }
+  }
+
+  if (mReceivedCbPages.Length() >= kMaxReceivedCbPages) {
+    mReceivedCbPages.RemoveElementAt(0);
+  }
+  mReceivedCbPages.AppendElement(ReceivedCbPage{key, now});
+  return false;
+}
+
+void nsRilIndication::forwardNetworkStateChanged() {
+  MOZ_ASSERT(mTaskQueue->IsOnCurrentThread());
+  {
+    mozilla::MutexAutoLock lock(mLastIndicationsLock);
+    mNetworkStateTimer = nullptr;
+    mLastNetworkStateForwarded = mozilla::TimeStamp::Now();
+  }
+
+  RefPtr<nsRilIndicationResult> result =
+      new nsRilIndicationResult(u"networkStateChanged"_ns);
+  mRIL->sendRilIndicationResult(result);
+}
+
 void nsRilIndication::defaultResponse(const RadioIndicationType type,
                                       const nsString& rilmessageType) {
   mRIL->processIndication(type);
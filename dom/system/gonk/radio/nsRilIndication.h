@@ -8,6 +8,11 @@
 #define nsRilIndication_H
 #include <nsISupportsImpl.h>
 #include <nsTArray.h>
+#include "mozilla/Maybe.h"
+#include "mozilla/Mutex.h"
+#include "mozilla/TimeStamp.h"
+#include "nsCOMPtr.h"
+#include "nsITimer.h"
 #include <android/hardware/radio/1.1/IRadioIndication.h>
 
 using namespace ::android::hardware::radio::V1_1;
@@ -182,9 +187,57 @@ class nsRilIndication : public IRadioIndication {
  
   Return<void> keepaliveStatus(RadioIndicationType type, const KeepaliveStatus& status);
 
+  // The fields that tell a cell broadcast page apart, see 3GPP TS 23.041
+  // section 8. The serial number includes the geographical scope and the
+  // update number, so an updated message is never taken for a duplicate.
+  struct CbPageKey {
+    uint16_t mMessageId;
+    uint16_t mSerial;
+    uint8_t mPage;
+
+    uint8_t GeographicalScope() const { return mSerial >> 14; }
+    bool operator==(const CbPageKey& aOther) const {
+      return mMessageId == aOther.mMessageId && mSerial == aOther.mSerial &&
+             mPage == aOther.mPage;
+    }
+  };
+
  private:
   void defaultResponse(const RadioIndicationType type,
                        const nsString& rilmessageType);
+  void resetLastIndications();
+  void forwardNetworkStateChanged();
+
+  // Whether the cell broadcast page was already passed on within
+  // ril.indication.cell_broadcast_duplicate_window; if not, remembers it.
+  bool isDuplicateCbPage(const hidl_vec<uint8_t>& aPdu);
+
+  // Signal strength and cell info arrive about once a second per SIM, mostly
+  // unchanged. The last values passed on are kept here so that repeats, and
+  // signal changes below ril.indication.signal_strength_threshold, never
+  // reach the main thread.
+  mozilla::Mutex mLastIndicationsLock;
+  mozilla::Maybe<SignalStrength> mLastSignalStrength;
+  mozilla::Maybe<hidl_vec<CellInfo>> mLastCellInfoList;
+
+  // Emergency broadcasts are repeated every few seconds for as long as they
+  // are in force. The pages passed on recently are kept here, oldest first,
+  // so that the repeats never reach the main thread. Pages not broadcast
+  // PLMN wide are forgotten on networkStateChanged, as the device may have
+  // moved to another area. Guarded by mLastIndicationsLock.
+  struct ReceivedCbPage {
+    CbPageKey mKey;
+    mozilla::TimeStamp mReceived;
+  };
+  nsTArray<ReceivedCbPage> mReceivedCbPages;
+
+  // networkStateChanged is passed on at most once per
+  // ril.indication.network_state_interval_ms; one arriving sooner is held
+  // back and sent by mNetworkStateTimer, on mTaskQueue, when the interval
+  // is up. Guarded by mLastIndicationsLock.
+  nsCOMPtr<nsISerialEventTarget> mTaskQueue;
+  nsCOMPtr<nsITimer> mNetworkStateTimer;
+  mozilla::TimeStamp mLastNetworkStateForwarded;
   int32_t convertRadioStateToNum(RadioState state);
   int32_t convertSimRefreshType(SimRefreshType type);
   int32_t convertPhoneRestrictedState(PhoneRestrictedState state);
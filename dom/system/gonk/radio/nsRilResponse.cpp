@@ -7,6 +7,8 @@
 #include "nsRilResponse.h"
 #include "nsRilWorker.h"
 
+#include "AudioManager.h"
+
 /* Logging related */
 #undef LOG_TAG
 #define LOG_TAG "nsRilResponse"
@@ -28,7 +30,7 @@ CardStatus cardStatus;
 /**
  *
  */
-nsRilResponse::nsRilResponse(nsRilWorker* aRil) {
+nsRilResponse::nsRilResponse(nsRilWorker* aRil) : mVoiceCallInProgress(false) {
   DEBUG("init nsRilResponse");
   mRIL = aRil;
 }
@@ -239,6 +241,21 @@ Return<void> nsRilResponse::getCurrentCallsResponse(
       aCalls.AppendElement(call);
     }
     result->updateCurrentCalls(aCalls);
+
+    // Route audio to a call as soon as it is dialed or answered. Everything
+    // else about call audio is left to the telephony service.
+    bool voiceCallInProgress = false;
+    for (const Call& call : calls) {
+      if (call.isVoice && call.state != CallState::INCOMING &&
+          call.state != CallState::WAITING) {
+        voiceCallInProgress = true;
+        break;
+      }
+    }
+    if (!mVoiceCallInProgress.exchange(voiceCallInProgress) &&
+        voiceCallInProgress) {
+      mozilla::dom::gonk::AudioManager::NotifyVoiceCallStarted();
+    }
   } else {
     DEBUG("getCurrentCalls error.");
   }
@@ -482,11 +499,9 @@ Return<void> nsRilResponse::sendSmsResponse(const RadioResponseInfo& info,
 
 Return<void> nsRilResponse::sendSMSExpectMoreResponse(
     const RadioResponseInfo& info, const SendSmsResult& sms) {
-  rspInfo = info;
-  mRIL->processResponse(rspInfo.type);
-  // sendSmsResult = sms;
-
-  return Void();
+  // Reported the same way, so the segment logic in RadioInterfaceLayer.jsm
+  // doesn't need to tell the two apart.
+  return sendSmsResponse(info, sms);
 }
 
 Return<void> nsRilResponse::setupDataCallResponse(
@@ -8,6 +8,7 @@
 #define nsRilResponse_H
 #include <nsISupportsImpl.h>
 #include <nsTArray.h>
+#include "mozilla/Atomics.h"
 
 #include <android/hardware/radio/1.1/IRadioResponse.h>
 
@@ -455,6 +456,10 @@ class nsRilResponse : public IRadioResponse {
   Return<void> stopKeepaliveResponse(const RadioResponseInfo& info);
 
  private:
+  // Whether the last call list had a voice call off hook, see
+  // getCurrentCallsResponse().
+  mozilla::Atomic<bool> mVoiceCallInProgress;
+
   void defaultResponse(const RadioResponseInfo& rspInfo,
                        const nsString& rilmessageType);
   int32_t convertRadioErrorToNum(RadioError error);
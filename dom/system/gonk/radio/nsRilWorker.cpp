@@ -6,6 +6,7 @@
 
 #include "nsRilWorker.h"
 #include "mozilla/Preferences.h"
+#include "nsPrintfCString.h"
 
 /* Logging related */
 #if !defined(RILWORKER_LOG_TAG)
@@ -31,13 +32,14 @@
     }                                                                    \
   } while (0)
 
-NS_IMPL_ISUPPORTS(nsRilWorker, nsIRilWorker)
+NS_IMPL_ISUPPORTS(nsRilWorker, nsIRilWorker, nsIMemoryReporter)
 static hidl_string HIDL_SERVICE_NAME[3] = {"slot1", "slot2", "slot3"};
 
 /**
  *
  */
-nsRilWorker::nsRilWorker(uint32_t aClientId) {
+nsRilWorker::nsRilWorker(uint32_t aClientId)
+    : mIndicationCountsLock("nsRilWorker::mIndicationCountsLock") {
   DEBUG("init nsRilWorker");
   mRadioProxy = nullptr;
   mDeathRecipient = nullptr;
@@ -46,6 +48,7 @@ nsRilWorker::nsRilWorker(uint32_t aClientId) {
   mRilResponse = new nsRilResponse(this);
   mRilIndication = new nsRilIndication(this);
   updateDebug();
+  mozilla::RegisterWeakMemoryReporter(this);
 }
 
 void nsRilWorker::updateDebug() {
@@ -1163,6 +1166,25 @@ NS_IMETHODIMP nsRilWorker::SendSMS(int32_t serial, const nsAString& smsc,
   return NS_OK;
 }
 
+NS_IMETHODIMP nsRilWorker::SendSMSExpectMore(int32_t serial,
+                                             const nsAString& smsc,
+                                             const nsAString& pdu) {
+  DEBUG("nsRilWorker: [%d] > RIL_REQUEST_SEND_SMS_EXPECT_MORE ", serial);
+  GetRadioProxy();
+  if (mRadioProxy == nullptr) {
+    ERROR_NS_OK("No Radio HAL exist");
+  }
+
+  GsmSmsMessage smsMessage;
+  smsMessage.smscPdu = NS_ConvertUTF16toUTF8(smsc).get();
+  smsMessage.pdu = NS_ConvertUTF16toUTF8(pdu).get();
+  DEBUG("nsRilWorker: [%d] > RIL_REQUEST_SEND_SMS_EXPECT_MORE %s", serial,
+        NS_ConvertUTF16toUTF8(pdu).get());
+
+  mRadioProxy->sendSMSExpectMore(serial, smsMessage);
+  return NS_OK;
+}
+
 NS_IMETHODIMP nsRilWorker::AcknowledgeLastIncomingGsmSms(int32_t serial,
                                                          bool success,
                                                          int32_t cause) {
@@ -1241,6 +1263,7 @@ NS_IMETHODIMP nsRilWorker::SendEnvelope(
 
 nsRilWorker::~nsRilWorker() {
   DEBUG("Destructor nsRilWorker");
+  mozilla::UnregisterWeakMemoryReporter(this);
   mRilResponse = nullptr;
   MOZ_ASSERT(!mRilResponse);
   mRilIndication = nullptr;
@@ -1439,6 +1462,14 @@ void nsRilWorker::sendRilIndicationResult(nsRilIndicationResult* aIndication) {
   DEBUG("nsRilWorker: [USOL]< %s",
         NS_LossyConvertUTF16toASCII(aIndication->mRilMessageType).get());
 
+  {
+    mozilla::MutexAutoLock lock(mIndicationCountsLock);
+    IndicationCounts& counts =
+        mIndicationCounts.LookupOrInsert(aIndication->mRilMessageType);
+    counts.mReceived++;
+    counts.mForwarded++;
+  }
+
   RefPtr<nsRilIndicationResult> indication = aIndication;
   nsCOMPtr<nsIRunnable> r = NS_NewRunnableFunction(
       "nsRilWorker::sendRilIndicationResult", [this, indication]() {
@@ -1451,6 +1482,35 @@ void nsRilWorker::sendRilIndicationResult(nsRilIndicationResult* aIndication) {
   NS_DispatchToMainThread(r);
 }
 
+void nsRilWorker::noteIndicationFiltered(const nsAString& aRilMessageType) {
+  mozilla::MutexAutoLock lock(mIndicationCountsLock);
+  mIndicationCounts.LookupOrInsert(aRilMessageType).mReceived++;
+}
+
+NS_IMETHODIMP
+nsRilWorker::CollectReports(nsIHandleReportCallback* aHandleReport,
+                            nsISupports* aData, bool aAnonymize) {
+  mozilla::MutexAutoLock lock(mIndicationCountsLock);
+  for (auto iter = mIndicationCounts.ConstIter(); !iter.Done(); iter.Next()) {
+    NS_ConvertUTF16toUTF8 type(iter.Key());
+    aHandleReport->Callback(
+        ""_ns,
+        nsPrintfCString("ril-indications/client-%d/%s/received", mClientId,
+                        type.get()),
+        KIND_OTHER, UNITS_COUNT, iter.Data().mReceived,
+        "RIL indications of this type received from the radio HAL."_ns,
+        aData);
+    aHandleReport->Callback(
+        ""_ns,
+        nsPrintfCString("ril-indications/client-%d/%s/forwarded", mClientId,
+                        type.get()),
+        KIND_OTHER, UNITS_COUNT, iter.Data().mForwarded,
+        "RIL indications of this type passed on to the main thread."_ns,
+        aData);
+  }
+  return NS_OK;
+}
+
 void nsRilWorker::sendRilResponseResult(nsRilResponseResult* aResponse) {
   DEBUG("nsRilWorker: [%d] < %s", aResponse->mRilMessageToken,
         NS_LossyConvertUTF16toASCII(aResponse->mRilMessageType).get());
@@ -8,7 +8,9 @@
 #define nsRilWorker_H
 
 #include <nsISupportsImpl.h>
+#include <nsIMemoryReporter.h>
 #include <nsIRilWorkerService.h>
+#include <nsTHashMap.h>
 #include <nsThreadUtils.h>
 #include <nsTArray.h>
 #include "nsRilIndication.h"
@@ -16,6 +18,7 @@
 #include "nsRilResponse.h"
 #include "nsRilResponseResult.h"
 #include "nsRilResult.h"
+#include "mozilla/Mutex.h"
 
 #include <android/hardware/radio/1.1/IRadio.h>
 
@@ -62,10 +65,11 @@ static bool gRilDebug_isLoggingEnabled = false;
 
 class nsRilWorker;
 
-class nsRilWorker final : public nsIRilWorker {
+class nsRilWorker final : public nsIRilWorker, public nsIMemoryReporter {
  public:
-  NS_DECL_ISUPPORTS
+  NS_DECL_THREADSAFE_ISUPPORTS
   NS_DECL_NSIRILWORKER
+  NS_DECL_NSIMEMORYREPORTER
 
   explicit nsRilWorker(uint32_t aClientId);
 
@@ -80,6 +84,8 @@ class nsRilWorker final : public nsIRilWorker {
   void processResponse(RadioResponseType responseType);
   void sendAck();
   void sendRilIndicationResult(nsRilIndicationResult* aIndication);
+  // Counts an indication that was handled without reaching the main thread.
+  void noteIndicationFiltered(const nsAString& aRilMessageType);
   void sendRilResponseResult(nsRilResponseResult* aResponse);
   void updateDebug();
   nsCOMPtr<nsIRilCallback> mRilCallback;
@@ -91,6 +97,15 @@ class nsRilWorker final : public nsIRilWorker {
   sp<IRadioResponse> mRilResponse;
   sp<IRadioIndication> mRilIndication;
   sp<RadioProxyDeathRecipient> mDeathRecipient;
+
+  // Indications received and passed on to the main thread, per message type,
+  // reported in about:memory. Updated from binder threads.
+  struct IndicationCounts {
+    uint32_t mReceived = 0;
+    uint32_t mForwarded = 0;
+  };
+  mozilla::Mutex mIndicationCountsLock;
+  nsTHashMap<nsStringHashKey, IndicationCounts> mIndicationCounts;
   MvnoType convertToHalMvnoType(const nsAString& mvnoType);
   DataProfileInfo convertToHalDataProfile(nsIDataProfile* profile);
 };
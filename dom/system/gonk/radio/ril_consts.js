@@ -502,6 +502,7 @@ this.ICC_COMMAND_UPDATE_RECORD = 0xdc;
 // ICC constants, GSM SIM file ids from TS 51.011
 this.ICC_EF_ICCID = 0x2fe2;
 this.ICC_EF_IMG = 0x4f20;
+this.ICC_EF_CC = 0x4f23;
 this.ICC_EF_PBR = 0x4f30;
 this.ICC_EF_PLMNsel = 0x6f30; // PLMN for SIM
 this.ICC_EF_SST = 0x6f38;
@@ -35,6 +35,10 @@ const MODEM_RESTART_TIMEOUT_MS = 15000; // 15 seconds
 
 const PDU_HEX_OCTET_SIZE = 2;
 
+// Maximum number of SIM IO requests kept in flight while reading the records
+// of an ADN like EF.
+const kPrefIccContactsMaxPendingReads = "ril.icc.contacts.maxPendingReads";
+
 //TODO: Find better place
 const EARTH_RADIUS_METER = 6371 * 1000;
 const GEO_FENCING_MAXIMUM_WAIT_TIME_NOT_SET = 255;
@@ -680,7 +684,8 @@ ICCFileHelperObject.prototype = {
       case ICC_EF_ADN:
       case ICC_EF_SDN: // Fall through.
         return EF_PATH_MF_SIM + EF_PATH_DF_TELECOM;
-      case ICC_EF_PBR:
+      case ICC_EF_CC:
+      case ICC_EF_PBR: // Fall through.
         return EF_PATH_MF_SIM + EF_PATH_DF_TELECOM + EF_PATH_DF_PHONEBOOK;
       case ICC_EF_IMG:
         return EF_PATH_MF_SIM + EF_PATH_DF_TELECOM + EF_PATH_GRAPHICS;
@@ -3812,24 +3817,77 @@ ICCRecordHelperObject.prototype = {
    */
   readADNLike(fileId, extFileId, onsuccess, onerror) {
     let ICCIOHelper = this.context.ICCIOHelper;
+    // The first record is read on its own to learn the record size and count
+    // of the EF, the remaining ones are then kept in flight up to
+    // |maxPendingReads| at a time.
+    let maxPendingReads = Math.max(
+      1,
+      Services.prefs.getIntPref(kPrefIccContactsMaxPendingReads, 1)
+    );
+    let records = [];
+    let pathId = null;
+    let recordSize = 0;
+    let totalRecords = 1;
+    let nextRecord = 2;
+    let pendingReads = 1;
+    let failed = false;
+
+    let onRecordError = errorMsg => {
+      if (failed) {
+        return;
+      }
+      failed = true;
+      if (onerror) {
+        onerror(errorMsg);
+      }
+    };
 
-    function callback(options) {
-      let loadNextContactRecord = () => {
-        if (options.p1 < options.totalRecords) {
-          ICCIOHelper.loadNextRecord(options);
-          return;
-        }
-        if (DEBUG) {
-          for (let i = 0; i < contacts.length; i++) {
-            this.context.debug(
-              "contact [" + i + "] " + JSON.stringify(contacts[i])
-            );
-          }
-        }
-        if (onsuccess) {
-          onsuccess(contacts);
+    let loadMoreRecords = () => {
+      while (pendingReads < maxPendingReads && nextRecord <= totalRecords) {
+        pendingReads++;
+        ICCIOHelper.loadLinearFixedEF({
+          fileId,
+          pathId,
+          recordNumber: nextRecord++,
+          recordSize,
+          callback: callback.bind(this),
+          onerror: onRecordError,
+        });
+      }
+    };
+
+    let recordDone = () => {
+      pendingReads--;
+      if (failed) {
+        return;
+      }
+      loadMoreRecords();
+      if (pendingReads > 0 || nextRecord <= totalRecords) {
+        return;
+      }
+
+      let contacts = records.filter(record => record);
+      if (DEBUG) {
+        for (let i = 0; i < contacts.length; i++) {
+          this.context.debug(
+            "contact [" + i + "] " + JSON.stringify(contacts[i])
+          );
         }
-      };
+      }
+      if (onsuccess) {
+        onsuccess(contacts);
+      }
+    };
+
+    function callback(options) {
+      if (failed) {
+        return;
+      }
+      if (options.p1 == 1) {
+        pathId = options.pathId;
+        recordSize = options.recordSize;
+        totalRecords = options.totalRecords;
+      }
 
       let contact = this.context.ICCPDUHelper.readAlphaIdDiallingNumber(
         options
@@ -3840,7 +3898,7 @@ ICCRecordHelperObject.prototype = {
           alphaId: contact.alphaId,
           number: contact.number,
         };
-        contacts.push(record);
+        records[options.p1] = record;
 
         if (extFileId && contact.extRecordNumber != 0xff) {
           this.readExtension(
@@ -3850,21 +3908,20 @@ ICCRecordHelperObject.prototype = {
               if (number) {
                 record.number += number;
               }
-              loadNextContactRecord();
+              recordDone();
             },
-            () => loadNextContactRecord()
+            () => recordDone()
           );
           return;
         }
       }
-      loadNextContactRecord();
+      recordDone();
     }
 
-    let contacts = [];
     ICCIOHelper.loadLinearFixedEF({
       fileId,
       callback: callback.bind(this),
-      onerror,
+      onerror: onRecordError,
     });
   },
 
@@ -3979,6 +4036,32 @@ ICCRecordHelperObject.prototype = {
     });
   },
 
+  /**
+   * Read the USIM phonebook change counter.
+   *
+   * @see TS 131.102, clause 4.4.2.12.2
+   *
+   * @param onsuccess   Callback to be called with the counter value.
+   * @param onerror     Callback to be called when error.
+   */
+  readPhonebookChangeCounter(onsuccess, onerror) {
+    function callback(options) {
+      let value = this.context.GsmPDUHelper.processHexToInt(
+        options.simResponse.slice(0, 4),
+        16
+      );
+      if (onsuccess) {
+        onsuccess(value);
+      }
+    }
+
+    this.context.ICCIOHelper.loadTransparentEF({
+      fileId: ICC_EF_CC,
+      callback: callback.bind(this),
+      onerror,
+    });
+  },
+
   /**
    * Cache EF_IAP record size.
    */
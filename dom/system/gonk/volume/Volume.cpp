@@ -5,7 +5,9 @@
 #include "Volume.h"
 #include "VolumeManager.h"
 #include "VolumeManagerLog.h"
+#include "base/task.h"
 #include "nsIVolume.h"
+#include "nsThreadUtils.h"
 #include "nsXULAppAPI.h"
 
 namespace mozilla {
@@ -78,6 +80,7 @@ Volume::Volume(const nsACString& aName)
       mIsUnmounting(false),
       mIsRemovable(false),
       mIsHotSwappable(false),
+      mMountPending(false),
       mId(sNextId++) {
   DBG("Volume %s: created", NameStr());
 }
@@ -99,6 +102,7 @@ Volume::Volume(const nsACString& aName, const nsACString& aUuid)
       mIsUnmounting(false),
       mIsRemovable(false),
       mIsHotSwappable(false),
+      mMountPending(false),
       mId(sNextId++) {
   DBG("Volume %s: created", NameStr());
 }
@@ -390,12 +394,54 @@ void Volume::SetMountPoint(const nsACString& aMountPoint) {
   ResolveAndSetMountPoint(aMountPoint);
 }
 
+// static
+void Volume::MountDone(const nsCString& aName, bool aSucceeded) {
+  MOZ_ASSERT(MessageLoop::current() == XRE_GetIOMessageLoop());
+
+  RefPtr<Volume> vol = VolumeManager::FindVolumeByName(aName);
+  if (!vol) {
+    return;
+  }
+  if (!aSucceeded) {
+    ERR("Volume %s: mount failed", vol->NameStr());
+  }
+  vol->SetMountPending(false);
+}
+
 void Volume::StartMount() {
   MOZ_ASSERT(XRE_IsParentProcess());
   MOZ_ASSERT(MessageLoop::current() == XRE_GetIOMessageLoop());
 
+  if (mMountPending) {
+    return;
+  }
+  mMountPending = true;
+
+  // vold only returns from mount() once the file system has been checked,
+  // which can take seconds on a large card. Wait for it on a background
+  // thread so the I/O thread, and the other volumes, aren't held up.
   const ::std::string volId(this->Uuid().get());
-  VoldProxy::Mount(volId, VolumeInfo::kPrimary, 0);
+  nsCString name(mName);
+  nsresult rv = NS_DispatchBackgroundTask(
+      NS_NewRunnableFunction(
+          "Volume::StartMount",
+          [volId, name]() {
+            bool succeeded = VoldProxy::Mount(volId, VolumeInfo::kPrimary, 0);
+            XRE_GetIOMessageLoop()->PostTask(NewRunnableFunction(
+                "Volume::MountDone", &Volume::MountDone, name, succeeded));
+          }),
+      NS_DISPATCH_EVENT_MAY_BLOCK);
+  if (NS_FAILED(rv)) {
+    mMountPending = false;
+    VoldProxy::Mount(volId, VolumeInfo::kPrimary, 0);
+  }
+}
+
+void Volume::SetMountPending(bool aMountPending) {
+  MOZ_ASSERT(XRE_IsParentProcess());
+  MOZ_ASSERT(MessageLoop::current() == XRE_GetIOMessageLoop());
+
+  mMountPending = aMountPending;
 }
 
 void Volume::StartUnmount() {
@@ -482,6 +528,7 @@ void Volume::HandleVolumeStateChanged(int32_t aState) {
   DBG("%s with state is %d\n", __func__, aState);
   VolumeInfo::State newState = static_cast<VolumeInfo::State>(aState);
   if (newState == VolumeInfo::State::kMounted) {
+    mMountPending = false;
     SetState(nsIVolume::STATE_MOUNTED);
   } else if (newState == VolumeInfo::State::kEjecting) {
     SetState(nsIVolume::STATE_UNMOUNTING);
@@ -83,6 +83,8 @@ class Volume final {
   bool IsUnmounting() const { return mIsUnmounting; }
   bool IsRemovable() const { return mIsRemovable; }
   bool IsHotSwappable() const { return mIsHotSwappable; }
+  // A mount has been sent to vold and it hasn't answered yet.
+  bool IsMountPending() const { return mMountPending; }
 
   void SetFakeVolume(const nsACString& aMountPoint);
 
@@ -134,6 +136,9 @@ class Volume final {
 
   void HandleVolumeStateChanged(int32_t aState);
 
+  void SetMountPending(bool aMountPending);
+  static void MountDone(const nsCString& aName, bool aSucceeded);
+
   static void UpdateMountLock(const nsACString& aVolumeName,
                               const int32_t& aMountGeneration,
                               const bool& aMountLocked);
@@ -155,6 +160,7 @@ class Volume final {
   bool mIsUnmounting;
   bool mIsRemovable;
   bool mIsHotSwappable;
+  bool mMountPending;
   uint32_t mId;  // Unique ID (used by MTP)
 
   static VolumeObserverList sEventObserverList;
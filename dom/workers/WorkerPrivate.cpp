@@ -1130,6 +1130,7 @@ class WorkerPrivate::MemoryReporter final : public nsIMemoryReporter {
     size_t mPerformanceResourceEntries;
     const bool mAnonymize;
     bool mSuccess;
+    bool mHibernated;
 
    public:
     WorkerJSContextStats mCxStats;
@@ -1147,6 +1148,8 @@ class WorkerPrivate::MemoryReporter final : public nsIMemoryReporter {
 
     void SetSuccess(bool success) { mSuccess = success; }
 
+    void SetHibernated(bool aHibernated) { mHibernated = aHibernated; }
+
    private:
     ~FinishCollectRunnable() {
       // mHandleReport and mHandlerData are released on the main thread.
@@ -1246,6 +1249,7 @@ bool WorkerPrivate::MemoryReporter::CollectReportsRunnable::WorkerRun(
 
   mFinishCollectRunnable->SetSuccess(aWorkerPrivate->CollectRuntimeStats(
       &mFinishCollectRunnable->mCxStats, mAnonymize));
+  mFinishCollectRunnable->SetHibernated(aWorkerPrivate->IsHibernated());
 
   return true;
 }
@@ -1261,6 +1265,7 @@ WorkerPrivate::MemoryReporter::FinishCollectRunnable::FinishCollectRunnable(
       mPerformanceResourceEntries(0),
       mAnonymize(aAnonymize),
       mSuccess(false),
+      mHibernated(false),
       mCxStats(aPath) {}
 
 NS_IMETHODIMP
@@ -1273,8 +1278,28 @@ WorkerPrivate::MemoryReporter::FinishCollectRunnable::Run() {
   if (!manager) return NS_OK;
 
   if (mSuccess) {
-    xpc::ReportJSRuntimeExplicitTreeStats(
-        mCxStats, mCxStats.Path(), mHandleReport, mHandlerData, mAnonymize);
+    size_t total = 0;
+    xpc::ReportJSRuntimeExplicitTreeStats(mCxStats, mCxStats.Path(),
+                                          mHandleReport, mHandlerData,
+                                          mAnonymize, &total);
+
+    // Also file the worker's JS memory under its state, so hibernated and
+    // active workers can be told apart at a glance. The explicit path is
+    // "explicit/workers/workers(...)/worker(...)/".
+    constexpr auto explicitPrefix = "explicit/workers/"_ns;
+    const nsCString& rtPath = mCxStats.Path();
+    MOZ_ASSERT(StringBeginsWith(rtPath, explicitPrefix));
+    nsAutoCString statePath(mHibernated ? "workers-by-state/hibernated/"_ns
+                                        : "workers-by-state/active/"_ns);
+    statePath.Append(Substring(rtPath, explicitPrefix.Length(),
+                               rtPath.Length() - explicitPrefix.Length() - 1));
+    mHandleReport->Callback(
+        ""_ns, statePath, nsIMemoryReporter::KIND_OTHER,
+        nsIMemoryReporter::UNITS_BYTES, total,
+        nsLiteralCString("Memory used by the JS runtime of a worker, by "
+                         "whether the worker is hibernated, i.e. has had its "
+                         "idle GC and hasn't run anything since."),
+        mHandlerData);
 
     if (mPerformanceUserEntries) {
       nsCString path = mCxStats.Path();
@@ -2142,7 +2167,8 @@ WorkerPrivate::WorkerThreadAccessible::WorkerThreadAccessible(
       mIdleGCTimerRunning(false),
       mOnLine(aParent ? aParent->OnLine() : !NS_IsOffline()),
       mJSThreadExecutionGranted(false),
-      mCCCollectedAnything(false) {}
+      mCCCollectedAnything(false),
+      mHibernated(false) {}
 
 namespace {
 
@@ -3343,6 +3369,11 @@ void WorkerPrivate::SetGCTimerMode(GCTimerMode aMode) {
 
   MOZ_ASSERT(aMode == PeriodicTimer || aMode == IdleTimer);
 
+  if (aMode == PeriodicTimer && data->mHibernated) {
+    data->mHibernated = false;
+    LOG(WorkerLog(), ("Worker %p woke up\n", this));
+  }
+
   uint32_t delay = 0;
   int16_t type = nsITimer::TYPE_ONE_SHOT;
   nsTimerCallbackFunc callback = nullptr;
@@ -4967,6 +4998,10 @@ void WorkerPrivate::GarbageCollectInternal(JSContext* aCx, bool aShrinking,
       }
 
       if (!aCollectChildren) {
+        // A shrinking GC discards all JIT code and shrinks the nursery to
+        // its minimum size, so this is as small as the worker gets until it
+        // has something to do again.
+        data->mHibernated = true;
         LOG(WorkerLog(), ("Worker %p collected idle garbage\n", this));
       }
     } else {
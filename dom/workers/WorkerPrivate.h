@@ -311,6 +311,12 @@ class WorkerPrivate final : public RelativeTimeline {
 
   bool CollectRuntimeStats(JS::RuntimeStats* aRtStats, bool aAnonymize);
 
+  // Whether the worker has been idle since its last idle GC.
+  bool IsHibernated() {
+    AssertIsOnWorkerThread();
+    return mWorkerThreadAccessible.Access()->mHibernated;
+  }
+
 #ifdef JS_GC_ZEAL
   void UpdateGCZealInternal(JSContext* aCx, uint8_t aGCZeal,
                             uint32_t aFrequency);
@@ -1283,6 +1289,9 @@ class WorkerPrivate final : public RelativeTimeline {
     bool mOnLine;
     bool mJSThreadExecutionGranted;
     bool mCCCollectedAnything;
+    // Set by the idle GC, which leaves the worker with a shrunk heap and
+    // nursery and no JIT code, until the worker has something to do again.
+    bool mHibernated;
     FlippedOnce<false> mDeletionScheduled;
   };
   ThreadBound<WorkerThreadAccessible> mWorkerThreadAccessible;
@@ -1686,6 +1686,11 @@ nsresult PermissionManager::AddInternal(
     aModificationTime = EXPIRY_NOW;
   }
 
+  if (op != eOperationNone) {
+    // Decisions made for this origin or for its subdomains may change.
+    ClearDecisionCache();
+  }
+
   switch (op) {
     case eOperationNone: {
       // nothing to do
@@ -2214,6 +2219,20 @@ nsresult PermissionManager::CommonTestPermissionInternal(
   }
 #endif
 
+  nsAutoCString decisionKey;
+  if (aPrincipal && StaticPrefs::permissions_decision_cache_enabled() &&
+      NS_SUCCEEDED(aPrincipal->GetOrigin(decisionKey))) {
+    decisionKey.AppendPrintf(" %d %d%d", aTypeIndex, aExactHostMatch,
+                             aIncludingSession);
+    uint32_t decision;
+    if (mDecisionCache.Get(decisionKey, &decision)) {
+      if (decision != kNoDecision) {
+        *aPermission = decision;
+      }
+      return NS_OK;
+    }
+  }
+
   PermissionHashKey* entry =
       aPrincipal ? GetPermissionHashKey(aPrincipal, aTypeIndex, aExactHostMatch)
                  : GetPermissionHashKey(aURI, aOriginAttributes, aTypeIndex,
@@ -2221,16 +2240,40 @@ nsresult PermissionManager::CommonTestPermissionInternal(
   if (!entry || (!aIncludingSession &&
                  entry->GetPermission(aTypeIndex).mNonSessionExpireType ==
                      nsIPermissionManager::EXPIRE_SESSION)) {
+    if (!decisionKey.IsEmpty()) {
+      CacheDecision(decisionKey, kNoDecision);
+    }
     return NS_OK;
   }
 
-  *aPermission = aIncludingSession
-                     ? entry->GetPermission(aTypeIndex).mPermission
-                     : entry->GetPermission(aTypeIndex).mNonSessionPermission;
+  const PermissionEntry& permEntry = entry->GetPermission(aTypeIndex);
+  *aPermission = aIncludingSession ? permEntry.mPermission
+                                   : permEntry.mNonSessionPermission;
+
+  // Permissions that expire at some point are looked up every time, so that
+  // they are removed when they do.
+  if (!decisionKey.IsEmpty() &&
+      permEntry.mExpireType != nsIPermissionManager::EXPIRE_TIME &&
+      (permEntry.mExpireType != nsIPermissionManager::EXPIRE_SESSION ||
+       !permEntry.mExpireTime)) {
+    CacheDecision(decisionKey, *aPermission);
+  }
 
   return NS_OK;
 }
 
+void PermissionManager::CacheDecision(const nsACString& aKey,
+                                      uint32_t aDecision) {
+  // Most processes check a handful of permissions for a handful of origins,
+  // just don't let a page going through many origins grow it forever.
+  if (mDecisionCache.Count() >= kMaxCachedDecisions) {
+    mDecisionCache.Clear();
+  }
+  mDecisionCache.InsertOrUpdate(aKey, aDecision);
+}
+
+void PermissionManager::ClearDecisionCache() { mDecisionCache.Clear(); }
+
 // Helper function to filter permissions using a condition function.
 template <class T>
 nsresult PermissionManager::GetPermissionEntries(
@@ -2661,6 +2704,7 @@ nsresult PermissionManager::RemoveAllFromMemory() {
   mLargestID = 0;
   mTypeArray.clear();
   mPermissionTable.Clear();
+  ClearDecisionCache();
 
   return NS_OK;
 }
@@ -3031,6 +3075,10 @@ void PermissionManager::SetPermissionsWithKey(
   mPermissionKeyPromiseMap.InsertOrUpdate(
       aPermissionKey, RefPtr<GenericNonExclusivePromise::Private>{});
 
+  // Nothing should have been decided for these origins before, but a key
+  // without any permission adds none below.
+  ClearDecisionCache();
+
   // Add the permissions locally to our process
   for (IPC::Permission& perm : aPerms) {
     nsCOMPtr<nsIPrincipal> principal;
@@ -17,6 +17,7 @@
 #include "nsString.h"
 #include "nsHashKeys.h"
 #include "nsRefPtrHashtable.h"
+#include "nsTHashMap.h"
 #include "mozilla/Atomics.h"
 #include "mozilla/Monitor.h"
 #include "mozilla/MozPromise.h"
@@ -427,6 +428,11 @@ class PermissionManager final : public nsIPermissionManager,
       const nsACString& aType, uint32_t* aPermission, bool aExactHostMatch,
       bool aIncludingSession);
 
+  // Remembers what CommonTestPermissionInternal() found for a principal, see
+  // mDecisionCache.
+  void CacheDecision(const nsACString& aKey, uint32_t aDecision);
+  void ClearDecisionCache();
+
   nsresult OpenDatabase(nsIFile* permissionsFile);
 
   void InitDB(bool aRemoveFile);
@@ -617,6 +623,17 @@ class PermissionManager final : public nsIPermissionManager,
   bool mBlockerAdded;
 
   nsTHashtable<PermissionHashKey> mPermissionTable;
+
+  // What CommonTestPermissionInternal() found for principals, keyed by origin,
+  // type index and lookup flags, or kNoDecision when there was no permission,
+  // so that the permissions checked over and over by the same origins (every
+  // SMS sent, DeviceStorage request or settings access of an app) don't go
+  // through the permission keys and their subdomains again. Cleared whenever
+  // a permission is added, changed or removed, including those broadcast to
+  // content processes by the parent. Permissions that expire are not cached.
+  static const uint32_t kNoDecision = UINT32_MAX;
+  static const uint32_t kMaxCachedDecisions = 1024;
+  nsTHashMap<nsCStringHashKey, uint32_t> mDecisionCache;
   // a unique, monotonically increasing id used to identify each database entry
   int64_t mLargestID;
 
@@ -104,10 +104,20 @@ struct APZCTreeManager::TreeBuildingState {
   // State that is updated as we perform the tree build
 
   // A list of nodes that need to be destroyed at the end of the tree building.
-  // This is initialized with all nodes in the old tree, and nodes are removed
-  // from it as we reuse them in the new tree.
+  // This is initialized with all the non-recyclable nodes in the old tree, and
+  // nodes are nulled out in it as we reuse them in the new tree.
   nsTArray<RefPtr<HitTestingTreeNode>> mNodesToDestroy;
 
+  // The recyclable nodes of the old tree, which are also destroyed at the end
+  // of the tree building unless RecycleOrCreateNode hands them out first.
+  nsTArray<RefPtr<HitTestingTreeNode>> mRecyclableNodes;
+
+  // The index in mNodesToDestroy of the primary-holder node of each APZC of
+  // the old tree, so that the APZCs that are still in the new tree are found
+  // without walking the whole old tree for each of them.
+  std::unordered_map<ScrollableLayerGuid, size_t, ScrollableLayerGuid::HashFn>
+      mPrimaryHoldersToDestroy;
+
   // This map is populated as we place APZCs into the new tree. Its purpose is
   // to facilitate re-using the same APZC for different layers that scroll
   // together (and thus have the same ScrollableLayerGuid). The presShellId
@@ -408,10 +418,19 @@ APZCTreeManager::UpdateHitTestingTreeImpl(const ScrollNode& aRoot,
   // transplanted elsewhere. Doing that as part of a recursive tree walk is hard
   // and so maintaining a list and removing APZCs that are still alive is much
   // simpler.
-  ForEachNode<ReverseIterator>(mRootNode.get(),
-                               [&state](HitTestingTreeNode* aNode) {
-                                 state.mNodesToDestroy.AppendElement(aNode);
-                               });
+  ForEachNode<ReverseIterator>(
+      mRootNode.get(), [&state, &lock](HitTestingTreeNode* aNode) {
+        if (aNode->IsRecyclable(lock)) {
+          state.mRecyclableNodes.AppendElement(aNode);
+          return;
+        }
+        if (aNode->IsPrimaryHolder() && aNode->GetApzc()) {
+          // Only the first primary holder of a guid is ever reused.
+          state.mPrimaryHoldersToDestroy.emplace(
+              aNode->GetApzc()->GetGuid(), state.mNodesToDestroy.Length());
+        }
+        state.mNodesToDestroy.AppendElement(aNode);
+      });
   mRootNode = nullptr;
   mAsyncZoomContainerSubtree = Nothing();
   int asyncZoomContainerNestingDepth = 0;
@@ -678,7 +697,11 @@ APZCTreeManager::UpdateHitTestingTreeImpl(const ScrollNode& aRoot,
     mStickyPositionInfo = std::move(state.mStickyPositionInfo);
   }
 
+  state.mNodesToDestroy.AppendElements(std::move(state.mRecyclableNodes));
   for (size_t i = 0; i < state.mNodesToDestroy.Length(); i++) {
+    if (!state.mNodesToDestroy[i]) {
+      continue;  // reused in the new tree
+    }
     APZCTM_LOG("Destroying node at %p with APZC %p\n",
                state.mNodesToDestroy[i].get(),
                state.mNodesToDestroy[i]->GetApzc());
@@ -1051,16 +1074,14 @@ static EventRegions GetEventRegions(const ScrollNode& aLayer) {
 already_AddRefed<HitTestingTreeNode> APZCTreeManager::RecycleOrCreateNode(
     const RecursiveMutexAutoLock& aProofOfTreeLock, TreeBuildingState& aState,
     AsyncPanZoomController* aApzc, LayersId aLayersId) {
-  // Find a node without an APZC and return it. Note that unless the layer tree
-  // actually changes, this loop should generally do an early-return on the
-  // first iteration, so it should be cheap in the common case.
-  for (int32_t i = aState.mNodesToDestroy.Length() - 1; i >= 0; i--) {
-    RefPtr<HitTestingTreeNode> node = aState.mNodesToDestroy[i];
-    if (node->IsRecyclable(aProofOfTreeLock)) {
-      aState.mNodesToDestroy.RemoveElementAt(i);
-      node->RecycleWith(aProofOfTreeLock, aApzc, aLayersId);
-      return node.forget();
-    }
+  // Reuse a recyclable node of the old tree, in the same order as they were
+  // collected so that an unchanged tree gets back the same nodes.
+  if (!aState.mRecyclableNodes.IsEmpty()) {
+    RefPtr<HitTestingTreeNode> node =
+        aState.mRecyclableNodes.PopLastElement();
+    MOZ_ASSERT(node->IsRecyclable(aProofOfTreeLock));
+    node->RecycleWith(aProofOfTreeLock, aApzc, aLayersId);
+    return node.forget();
   }
   RefPtr<HitTestingTreeNode> node =
       new HitTestingTreeNode(aApzc, false, aLayersId);
@@ -1256,18 +1277,19 @@ HitTestingTreeNode* APZCTreeManager::PrepareNodeForLayer(
     // definition, but we want to keep that APZC around in the new tree.
     // We leave non-primary-holder nodes in the destroy list because we don't
     // care about those nodes getting destroyed.
-    for (size_t i = 0; i < aState.mNodesToDestroy.Length(); i++) {
-      RefPtr<HitTestingTreeNode> n = aState.mNodesToDestroy[i];
-      if (n->IsPrimaryHolder() && n->GetApzc() && n->GetApzc()->Matches(guid)) {
-        node = n;
-        if (apzc != nullptr) {
-          // If there is an APZC already then it should match the one from the
-          // old primary-holder node
-          MOZ_ASSERT(apzc == node->GetApzc());
-        }
-        apzc = node->GetApzc();
-        break;
+    size_t reusedIndex = 0;
+    auto holder = aState.mPrimaryHoldersToDestroy.find(guid);
+    if (holder != aState.mPrimaryHoldersToDestroy.end()) {
+      reusedIndex = holder->second;
+      node = aState.mNodesToDestroy[reusedIndex];
+      aState.mPrimaryHoldersToDestroy.erase(holder);
+      MOZ_ASSERT(node->GetApzc()->Matches(guid));
+      if (apzc != nullptr) {
+        // If there is an APZC already then it should match the one from the
+        // old primary-holder node
+        MOZ_ASSERT(apzc == node->GetApzc());
       }
+      apzc = node->GetApzc();
     }
 
     // The APZC we get off the layer may have been destroyed previously if the
@@ -1292,7 +1314,7 @@ HitTestingTreeNode* APZCTreeManager::PrepareNodeForLayer(
       // be in the tree. These pointers will get reset properly as we continue
       // building the tree. Also remove it from the set of nodes that are going
       // to be destroyed, because it's going to remain active.
-      aState.mNodesToDestroy.RemoveElement(node);
+      aState.mNodesToDestroy[reusedIndex] = nullptr;
       node->SetPrevSibling(nullptr);
       node->SetLastChild(nullptr);
     }
@@ -509,10 +509,20 @@ StaticAutoPtr<ComputedTimingFunction> gZoomAnimationFunction;
 StaticAutoPtr<ComputedTimingFunction> gVelocityCurveFunction;
 
 /**
- * The estimated duration of a paint for the purposes of calculating a new
- * displayport, in milliseconds.
+ * Bounds of the estimated duration of a paint, for the purposes of calculating
+ * a new displayport, that an APZC learns from its paints, in milliseconds, and
+ * the weight a new paint gets in it.
  */
-static const double kDefaultEstimatedPaintDurationMs = 50;
+static const double kMinPaintDurationMs = 16;
+static const double kMaxPaintDurationMs = 200;
+static const double kPaintDurationWeight = 0.2;
+
+/**
+ * How the skate displayport of an APZC is scaled after a transform that
+ * checkerboarded, and after one that didn't.
+ */
+static const float kSkateScaleGrowth = 1.25f;
+static const float kSkateScaleDecay = 0.95f;
 
 /**
  * Returns true if this is a high memory system and we can use
@@ -739,7 +749,9 @@ AsyncPanZoomController::AsyncPanZoomController(
       mTestAttributeAppliers(0),
       mAsyncTransformAppliedToContent(false),
       mTestHasAsyncKeyScrolled(false),
-      mCheckerboardEventLock("APZCBELock") {
+      mCheckerboardEventLock("APZCBELock"),
+      mTransformCheckerboarded(false),
+      mWasTransforming(false) {
   if (aGestures == USE_GESTURE_DETECTOR) {
     mGestureEventListener = new GestureEventListener(this);
   }
@@ -4082,7 +4094,7 @@ gfx::IntSize AsyncPanZoomController::GetDisplayportAlignmentMultiplier(
 static CSSSize CalculateDisplayPortSize(
     const CSSSize& aCompositionSize, const CSSPoint& aVelocity,
     AsyncPanZoomController::ZoomInProgress aZoomInProgress,
-    const CSSToScreenScale2D& aDpPerCSS) {
+    const CSSToScreenScale2D& aDpPerCSS, float aSkateScale) {
   bool xIsStationarySpeed =
       fabsf(aVelocity.x) < StaticPrefs::apz_min_skate_speed();
   bool yIsStationarySpeed =
@@ -4102,6 +4114,26 @@ static CSSSize CalculateDisplayPortSize(
     yMultiplier += StaticPrefs::apz_y_skate_highmem_adjust();
   }
 
+  if (aSkateScale != 1.0f) {
+    float xScaled = xIsStationarySpeed
+                        ? xMultiplier
+                        : 1 + std::max(xMultiplier - 1, 0.0f) * aSkateScale;
+    float yScaled = yIsStationarySpeed
+                        ? yMultiplier
+                        : 1 + std::max(yMultiplier - 1, 0.0f) * aSkateScale;
+    // Keep a grown displayport within the memory budget, but never below
+    // what the prefs ask for.
+    float maxArea = StaticPrefs::apz_adaptive_displayport_max_area();
+    float area = xScaled * yScaled;
+    if (aSkateScale > 1.0f && area > maxArea) {
+      float shrink = sqrt(maxArea / area);
+      xScaled = std::max(xScaled * shrink, xMultiplier);
+      yScaled = std::max(yScaled * shrink, yMultiplier);
+    }
+    xMultiplier = xScaled;
+    yMultiplier = yScaled;
+  }
+
   if (aZoomInProgress == AsyncPanZoomController::ZoomInProgress::Yes) {
     // If a zoom is in progress, we will be making content visible on the
     // x and y axes in equal proportion, because the zoom operation scales
@@ -4195,7 +4227,7 @@ static void RedistributeDisplayPortExcess(CSSSize& aDisplayPortSize,
 /* static */
 const ScreenMargin AsyncPanZoomController::CalculatePendingDisplayPort(
     const FrameMetrics& aFrameMetrics, const ParentLayerPoint& aVelocity,
-    ZoomInProgress aZoomInProgress) {
+    ZoomInProgress aZoomInProgress, const DisplayportTuning& aTuning) {
   if (aFrameMetrics.IsScrollInfoLayer()) {
     // Don't compute margins. Since we can't asynchronously scroll this frame,
     // we don't want to paint anything more than the composition bounds.
@@ -4212,9 +4244,9 @@ const ScreenMargin AsyncPanZoomController::CalculatePendingDisplayPort(
 
   // Calculate the displayport size based on how fast we're moving along each
   // axis.
-  CSSSize displayPortSize =
-      CalculateDisplayPortSize(compositionSize, velocity, aZoomInProgress,
-                               aFrameMetrics.DisplayportPixelsPerCSSPixel());
+  CSSSize displayPortSize = CalculateDisplayPortSize(
+      compositionSize, velocity, aZoomInProgress,
+      aFrameMetrics.DisplayportPixelsPerCSSPixel(), aTuning.mSkateScale);
 
   displayPortSize =
       ExpandDisplayPortToDangerZone(displayPortSize, aFrameMetrics);
@@ -4237,14 +4269,14 @@ const ScreenMargin AsyncPanZoomController::CalculatePendingDisplayPort(
 
   // Offset the displayport, depending on how fast we're moving and the
   // estimated time it takes to paint, to try to minimise checkerboarding.
-  float paintFactor = kDefaultEstimatedPaintDurationMs;
+  float paintFactor = aTuning.mPaintDurationMs;
   displayPort.MoveBy(velocity * paintFactor * StaticPrefs::apz_velocity_bias());
 
   APZC_LOGV_FM(aFrameMetrics,
                "Calculated displayport as %s from velocity %s zooming %d paint "
-               "time %f metrics",
+               "time %f skate scale %f metrics",
                ToString(displayPort).c_str(), ToString(aVelocity).c_str(),
-               (int)aZoomInProgress, paintFactor);
+               (int)aZoomInProgress, paintFactor, aTuning.mSkateScale);
 
   CSSMargin cssMargins;
   cssMargins.left = -displayPort.X();
@@ -4373,7 +4405,8 @@ void AsyncPanZoomController::RequestContentRepaint(
   ScreenMargin displayportMargins = CalculatePendingDisplayPort(
       Metrics(), velocity,
       (mState == PINCHING || mState == ANIMATING_ZOOM) ? ZoomInProgress::Yes
-                                                       : ZoomInProgress::No);
+                                                       : ZoomInProgress::No,
+      GetDisplayportTuning());
   Metrics().SetPaintRequestTime(TimeStamp::Now());
   RequestContentRepaint(Metrics(), velocity, displayportMargins, aUpdateType);
 }
@@ -4434,6 +4467,10 @@ void AsyncPanZoomController::RequestContentRepaint(
     if (mCheckerboardEvent && mCheckerboardEvent->IsRecordingTrace()) {
       std::stringstream info;
       info << " velocity " << aVelocity;
+      if (StaticPrefs::apz_adaptive_displayport_enabled()) {
+        info << " skatescale " << mDisplayportTuning.mSkateScale
+             << " paintestimate " << mDisplayportTuning.mPaintDurationMs;
+      }
       std::string str = info.str();
       mCheckerboardEvent->UpdateRendertraceProperty(
           CheckerboardEvent::RequestedDisplayPort,
@@ -4884,6 +4921,59 @@ void AsyncPanZoomController::ReportCheckerboard(
     mPotentialCheckerboardTracker.CheckerboardSeen();
   }
   UpdateCheckerboardEvent(lock, magnitude);
+  UpdateDisplayportTuning(lock, inTransformingState, magnitude);
+}
+
+void AsyncPanZoomController::UpdateDisplayportTuning(
+    const MutexAutoLock& aProofOfLock, bool aInTransformingState,
+    uint32_t aMagnitude) {
+  if (!StaticPrefs::apz_adaptive_displayport_enabled()) {
+    return;
+  }
+
+  if (aInTransformingState) {
+    mWasTransforming = true;
+    mTransformCheckerboarded |= aMagnitude > 0;
+    return;
+  }
+  if (!mWasTransforming) {
+    return;
+  }
+  mWasTransforming = false;
+
+  // Grow the skate displayport quickly after a transform that checkerboarded,
+  // and give the memory back slowly after the ones that didn't.
+  float& scale = mDisplayportTuning.mSkateScale;
+  if (mTransformCheckerboarded) {
+    scale = std::min(scale * kSkateScaleGrowth,
+                     StaticPrefs::apz_adaptive_displayport_max_skate_scale());
+  } else {
+    scale = std::max(scale * kSkateScaleDecay,
+                     StaticPrefs::apz_adaptive_displayport_min_skate_scale());
+  }
+  mTransformCheckerboarded = false;
+  APZC_LOG("%p adjusted displayport skate scale to %f\n", this, scale);
+}
+
+void AsyncPanZoomController::NotePaintDuration(const TimeDuration& aPaintTime) {
+  if (!StaticPrefs::apz_adaptive_displayport_enabled()) {
+    return;
+  }
+
+  MutexAutoLock lock(mCheckerboardEventLock);
+  double& estimate = mDisplayportTuning.mPaintDurationMs;
+  double paintMs = clamped(aPaintTime.ToMilliseconds(), kMinPaintDurationMs,
+                           kMaxPaintDurationMs);
+  estimate += (paintMs - estimate) * kPaintDurationWeight;
+}
+
+AsyncPanZoomController::DisplayportTuning
+AsyncPanZoomController::GetDisplayportTuning() {
+  if (!StaticPrefs::apz_adaptive_displayport_enabled()) {
+    return DisplayportTuning();
+  }
+  MutexAutoLock lock(mCheckerboardEventLock);
+  return mDisplayportTuning;
 }
 
 void AsyncPanZoomController::UpdateCheckerboardEvent(
@@ -4961,6 +5051,10 @@ void AsyncPanZoomController::NotifyLayersUpdated(
                "aThisLayerTreeUpdated=%d",
                this, aIsFirstPaint, aThisLayerTreeUpdated);
 
+  if (aThisLayerTreeUpdated && !aLayerMetrics.GetPaintRequestTime().IsNull()) {
+    NotePaintDuration(TimeStamp::Now() - aLayerMetrics.GetPaintRequestTime());
+  }
+
   {  // scope lock
     MutexAutoLock lock(mCheckerboardEventLock);
     if (mCheckerboardEvent && mCheckerboardEvent->IsRecordingTrace()) {
@@ -343,6 +343,20 @@ class AsyncPanZoomController {
     Yes,
   };
 
+  /**
+   * Adjustments to the displayport computation that an APZC learns from its
+   * own checkerboarding and paint times, when
+   * apz.adaptive_displayport.enabled is set. The defaults leave the
+   * computation as configured by the prefs.
+   */
+  struct DisplayportTuning {
+    // Scales the part of the skate size multipliers above 1.
+    float mSkateScale = 1.0f;
+    // The estimated duration of a paint in milliseconds, which sets how far
+    // the displayport is moved in the direction of the velocity.
+    double mPaintDurationMs = 50;
+  };
+
   /**
    * Recalculates the displayport. Ideally, this should paint an area bigger
    * than the composite-to dimensions so that when you scroll down, you don't
@@ -352,7 +366,8 @@ class AsyncPanZoomController {
    */
   static const ScreenMargin CalculatePendingDisplayPort(
       const FrameMetrics& aFrameMetrics, const ParentLayerPoint& aVelocity,
-      ZoomInProgress aZoomInProgress);
+      ZoomInProgress aZoomInProgress,
+      const DisplayportTuning& aTuning = DisplayportTuning());
 
   nsEventStatus HandleDragEvent(const MouseInput& aEvent,
                                 const AsyncDragMetrics& aDragMetrics,
@@ -1786,8 +1801,20 @@ class AsyncPanZoomController {
   void UpdateCheckerboardEvent(const MutexAutoLock& aProofOfLock,
                                uint32_t aMagnitude);
 
-  // Mutex protecting mCheckerboardEvent
+  // Adjusts mDisplayportTuning at the end of a transform, depending on
+  // whether it checkerboarded.
+  void UpdateDisplayportTuning(const MutexAutoLock& aProofOfLock,
+                               bool aInTransformingState, uint32_t aMagnitude);
+  // Folds the duration of a paint into mDisplayportTuning.
+  void NotePaintDuration(const TimeDuration& aPaintTime);
+  DisplayportTuning GetDisplayportTuning();
+
+  // Mutex protecting mCheckerboardEvent and the displayport tuning state
   Mutex mCheckerboardEventLock;
+  DisplayportTuning mDisplayportTuning;
+  // Whether the transform in progress, if any, checkerboarded.
+  bool mTransformCheckerboarded;
+  bool mWasTransforming;
   // This is created when this APZC instance is first included as part of a
   // composite. If a checkerboard event takes place, this is destroyed at the
   // end of the event, and a new one is created on the next composite.
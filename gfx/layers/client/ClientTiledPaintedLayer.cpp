@@ -13,6 +13,7 @@
 #include "gfxRect.h"             // for gfxRect
 #include "mozilla/Assertions.h"  // for MOZ_ASSERT, etc
 #include "mozilla/StaticPrefs_layers.h"
+#include "mozilla/TimeStamp.h"
 #include "mozilla/StaticPrefs_layout.h"
 #include "mozilla/gfx/BaseSize.h"  // for BaseSize
 #include "mozilla/gfx/gfxVars.h"
@@ -34,6 +35,58 @@ using gfx::IntRect;
 using gfx::IntSize;
 using gfx::Rect;
 
+#ifdef XP_LINUX
+// Returns MemAvailable from /proc/meminfo in MB, or -1 if unknown.
+static int64_t GetAvailableMemoryMB() {
+  FILE* fp = fopen("/proc/meminfo", "r");
+  if (!fp) {
+    return -1;
+  }
+  int64_t result = -1;
+  char line[128];
+  while (fgets(line, sizeof(line), fp)) {
+    long long kb;
+    if (sscanf(line, "MemAvailable: %lld kB", &kb) == 1) {
+      result = kb / 1024;
+      break;
+    }
+  }
+  fclose(fp);
+  return result;
+}
+#endif
+
+// The low-precision buffer covers the whole displayport on top of the
+// high-precision tiles, which on a long page is a lot of extra tiles. It's
+// only worth it while there is memory to spare.
+static bool LowPrecisionAllowed() {
+#ifdef XP_LINUX
+  uint32_t minAvailable = StaticPrefs::layers_low_precision_min_available_mb();
+  if (!minAvailable) {
+    return true;
+  }
+
+  // Checked at most once a second, as we get here on every paint.
+  static TimeStamp sLastCheck;
+  static bool sAllowed = true;
+  TimeStamp now = TimeStamp::Now();
+  if (sLastCheck.IsNull() || (now - sLastCheck).ToMilliseconds() >= 1000) {
+    sLastCheck = now;
+    int64_t available = GetAvailableMemoryMB();
+    bool allowed = available < 0 || available >= int64_t(minAvailable);
+    if (allowed != sAllowed) {
+      TILING_LOG("TILING: Low-precision painting %s, %" PRId64
+                 "MB available\n",
+                 allowed ? "enabled" : "disabled", available);
+    }
+    sAllowed = allowed;
+  }
+  return sAllowed;
+#else
+  return true;
+#endif
+}
+
 ClientTiledPaintedLayer::ClientTiledPaintedLayer(
     ClientLayerManager* const aManager,
     ClientLayerManager::PaintedLayerCreationHint aCreationHint)
@@ -565,10 +618,22 @@ void ClientTiledPaintedLayer::RenderLayer() {
 
   nsIntRegion lowPrecisionInvalidRegion;
   if (mContentClient->GetLowPrecisionTiledBuffer()) {
-    // Calculate the invalid region for the low precision buffer. Make sure
-    // to remove the valid high-precision area so we don't double-paint it.
-    lowPrecisionInvalidRegion.Sub(neededRegion, mLowPrecisionValidRegion);
-    lowPrecisionInvalidRegion.Sub(lowPrecisionInvalidRegion, GetValidRegion());
+    if (LowPrecisionAllowed()) {
+      // Calculate the invalid region for the low precision buffer. Make sure
+      // to remove the valid high-precision area so we don't double-paint it.
+      lowPrecisionInvalidRegion.Sub(neededRegion, mLowPrecisionValidRegion);
+      lowPrecisionInvalidRegion.Sub(lowPrecisionInvalidRegion,
+                                    GetValidRegion());
+    } else if (!mLowPrecisionValidRegion.IsEmpty()) {
+      // Let the low-precision tiles go, both here and on the compositor.
+      TILING_LOG("TILING %p: Clearing low-precision buffer, memory is low\n",
+                 this);
+      mLowPrecisionValidRegion.SetEmpty();
+      mContentClient->GetLowPrecisionTiledBuffer()->ResetPaintedAndValidState();
+      ClientManager()->Hold(this);
+      mContentClient->UpdatedBuffer(
+          TiledContentClient::LOW_PRECISION_TILED_BUFFER);
+    }
   }
   TILING_LOG("TILING %p: Low-precision invalid region %s\n", this,
              ToString(lowPrecisionInvalidRegion).c_str());
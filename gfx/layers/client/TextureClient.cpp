@@ -356,6 +356,9 @@ static bool ShouldRemoteTextureType(TextureType aTextureType,
 
   switch (aTextureType) {
     case TextureType::D3D11:
+#ifdef MOZ_WIDGET_GONK
+    case TextureType::GrallocBuffer:
+#endif
       return true;
     default:
       return false;
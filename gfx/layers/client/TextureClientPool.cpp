@@ -48,7 +48,8 @@ TextureClientPool::TextureClientPool(
       mPoolUnusedSize(aPoolUnusedSize),
       mOutstandingClients(0),
       mSurfaceAllocator(aAllocator),
-      mDestroyed(false) {
+      mDestroyed(false),
+      mBackground(false) {
   TCP_LOG("TexturePool %p created with maximum unused texture clients %u\n",
           this, mInitialPoolSize);
   mShrinkTimer = NS_NewTimer();
@@ -185,6 +186,11 @@ void TextureClientPool::ReturnTextureClient(TextureClient* aClient) {
   // Add the client to the pool:
   MOZ_ASSERT(mOutstandingClients > mTextureClientsDeferred.size());
   mOutstandingClients--;
+  if (mBackground) {
+    TCP_LOG("TexturePool %p releasing returned client %p in background\n",
+            this, aClient);
+    return;
+  }
   mTextureClients.push(aClient);
   TCP_LOG("TexturePool %p had client %p returned; size %u outstanding %u\n",
           this, aClient, mTextureClients.size(), mOutstandingClients);
@@ -222,7 +228,9 @@ void TextureClientPool::ShrinkToMaximumSize() {
   // mPoolUnusedSize at a maximum. If we have fewer than mInitialPoolSize
   // outstanding, then keep around the entire initial pool size.
   uint32_t targetUnusedClients;
-  if (mOutstandingClients > mInitialPoolSize) {
+  if (mBackground) {
+    targetUnusedClients = 0;
+  } else if (mOutstandingClients > mInitialPoolSize) {
     targetUnusedClients = mPoolUnusedSize;
   } else {
     targetUnusedClients = mInitialPoolSize;
@@ -302,6 +310,18 @@ void TextureClientPool::Clear() {
   }
 }
 
+void TextureClientPool::SetBackground(bool aBackground) {
+  if (mBackground == aBackground) {
+    return;
+  }
+  TCP_LOG("TexturePool %p going to the %s\n", this,
+          aBackground ? "background" : "foreground");
+  mBackground = aBackground;
+  if (aBackground) {
+    Clear();
+  }
+}
+
 void TextureClientPool::Destroy() {
   Clear();
   mDestroyed = true;
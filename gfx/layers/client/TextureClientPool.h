@@ -98,6 +98,13 @@ class TextureClientPool final : public TextureClientAllocator {
    */
   void Clear();
 
+  /**
+   * While in the background the pool keeps no unused clients: it is cleared
+   * right away and clients returned to it are released, so that processes
+   * the user isn't looking at don't sit on idle tile memory.
+   */
+  void SetBackground(bool aBackground);
+
   LayersBackend GetBackend() const {
     return mKnowsCompositor->GetCompositorBackendType();
   }
@@ -167,6 +174,8 @@ class TextureClientPool final : public TextureClientAllocator {
   // we won't accept returns of TextureClients anymore, and the refcounting
   // should take care of their destruction.
   bool mDestroyed;
+
+  bool mBackground;
 };
 
 }  // namespace layers
@@ -0,0 +1,169 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "FrameTimingRecorder.h"
+
+#include <algorithm>  // for std::min
+#include <math.h>     // for lround
+#include "mozilla/Hal.h"
+#include "mozilla/Logging.h"
+#include "mozilla/ProfilerMarkers.h"
+#include "mozilla/StaticPrefs_layers.h"
+#include "mozilla/Telemetry.h"
+#include "mozilla/layers/CompositorThread.h"
+
+namespace mozilla {
+namespace layers {
+
+static LazyLogModule sFrameTimingLog("FrameTiming");
+
+FrameTimingRecorder::FrameTimingRecorder(uint64_t aCompositorId)
+    : mCompositorId(aCompositorId),
+      mNextFrame(0),
+      mFrameCount(0),
+      mJankCount(0),
+      mTotalFrames(0) {
+  for (uint32_t& bucket : mBuckets) {
+    bucket = 0;
+  }
+}
+
+/* static */
+size_t FrameTimingRecorder::BucketFor(uint32_t aLatency) {
+  return std::min<size_t>(aLatency / kBucketWidth, kBucketCount - 1);
+}
+
+void FrameTimingRecorder::RecordFrame(const VsyncId& aId,
+                                      const TimeStamp& aVsyncStart,
+                                      const TimeStamp& aCompositeStart,
+                                      const TimeStamp& aCompositeEnd,
+                                      const TimeDuration& aVsyncRate) {
+  MOZ_ASSERT(CompositorThreadHolder::IsInCompositorThread());
+  MOZ_ASSERT(!aVsyncStart.IsNull() && aCompositeEnd >= aVsyncStart);
+
+  if (aVsyncRate.IsZero()) {
+    return;
+  }
+
+  double latencyNorm = (aCompositeEnd - aVsyncStart) / aVsyncRate;
+  uint32_t latency = uint32_t(lround(latencyNorm * 100.0));
+  bool janky = latency > kJankLatency;
+
+  Frame& frame = mFrames[mNextFrame];
+  if (mFrameCount == kCapacity) {
+    mBuckets[BucketFor(frame.mLatency)]--;
+    if (frame.mLatency > kJankLatency) {
+      mJankCount--;
+    }
+  } else {
+    mFrameCount++;
+  }
+  frame = Frame{aId, aVsyncStart, aCompositeStart, aCompositeEnd, latency};
+  mBuckets[BucketFor(latency)]++;
+  if (janky) {
+    mJankCount++;
+  }
+  mNextFrame = (mNextFrame + 1) % kCapacity;
+  mTotalFrames++;
+
+  MOZ_LOG(sFrameTimingLog, LogLevel::Verbose,
+          ("Compositor %" PRIu64 " vsync %" PRIu64
+           " started after %.2fms, done after %.2fms (%u%%)",
+           mCompositorId, uint64_t(aId),
+           (aCompositeStart - aVsyncStart).ToMilliseconds(),
+           (aCompositeEnd - aVsyncStart).ToMilliseconds(), latency));
+
+  if (janky) {
+    if (uint32_t hintMs = StaticPrefs::layers_frame_timing_jank_hint_ms()) {
+      hal::NotifyPerformanceHint(hal::PERFORMANCE_HINT_INTERACTION, hintMs);
+    }
+  }
+
+#ifdef MOZ_GECKO_PROFILER
+  if (janky && profiler_can_accept_markers()) {
+    struct CompositeJankMarker {
+      static constexpr Span<const char> MarkerTypeName() {
+        return MakeStringSpan("CompositeJank");
+      }
+      static void StreamJSONMarkerData(
+          baseprofiler::SpliceableJSONWriter& aWriter, uint64_t aVsyncId,
+          uint32_t aLatency) {
+        aWriter.IntProperty("vsyncId", int64_t(aVsyncId));
+        aWriter.IntProperty("latency", aLatency);
+      }
+      static MarkerSchema MarkerTypeDisplay() {
+        using MS = MarkerSchema;
+        MS schema{MS::Location::markerChart, MS::Location::markerTable};
+        schema.AddKeyLabelFormat("vsyncId", "Vsync", MS::Format::integer);
+        schema.AddKeyLabelFormat("latency", "Latency (% of vsync interval)",
+                                 MS::Format::integer);
+        return schema;
+      }
+    };
+
+    profiler_add_marker("CompositeJank", geckoprofiler::category::GRAPHICS,
+                        MarkerTiming::Interval(aVsyncStart, aCompositeEnd),
+                        CompositeJankMarker{}, uint64_t(aId), latency);
+  }
+#endif
+
+  if (mTotalFrames % kCapacity == 0) {
+    ReportWindow();
+  }
+}
+
+uint32_t FrameTimingRecorder::LatencyPercentile(uint32_t aPercentile) const {
+  MOZ_ASSERT(aPercentile <= 100);
+  if (!mFrameCount) {
+    return 0;
+  }
+
+  // The number of frames that have to be at or below the answer.
+  size_t wanted = (mFrameCount * aPercentile + 99) / 100;
+  size_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; i++) {
+    seen += mBuckets[i];
+    if (seen >= wanted) {
+      return (i + 1) * kBucketWidth;
+    }
+  }
+  return kBucketCount * kBucketWidth;
+}
+
+uint32_t FrameTimingRecorder::JankPercentage() const {
+  return mFrameCount ? mJankCount * 100 / mFrameCount : 0;
+}
+
+void FrameTimingRecorder::ReportWindow() const {
+  uint32_t jank = JankPercentage();
+  uint32_t p95 = LatencyPercentile(95);
+
+  Telemetry::Accumulate(Telemetry::COMPOSITE_JANK_PERCENT, jank);
+  Telemetry::Accumulate(Telemetry::COMPOSITE_FRAME_LATENCY_P95, p95);
+
+  MOZ_LOG(sFrameTimingLog, LogLevel::Info,
+          ("Compositor %" PRIu64 ": %u%% of the last %zu frames janky, "
+           "latency p50 %u%% p95 %u%% p99 %u%% of the vsync interval",
+           mCompositorId, jank, mFrameCount, LatencyPercentile(50), p95,
+           LatencyPercentile(99)));
+}
+
+void FrameTimingRecorder::Dump() const {
+  size_t oldest = mFrameCount == kCapacity ? mNextFrame : 0;
+  for (size_t i = 0; i < mFrameCount; i++) {
+    const Frame& frame = mFrames[(oldest + i) % kCapacity];
+    MOZ_LOG(sFrameTimingLog, LogLevel::Debug,
+            ("Compositor %" PRIu64 " vsync %" PRIu64
+             " started after %.2fms, done after %.2fms (%u%%)",
+             mCompositorId, uint64_t(frame.mId),
+             (frame.mCompositeStart - frame.mVsyncStart).ToMilliseconds(),
+             (frame.mCompositeEnd - frame.mVsyncStart).ToMilliseconds(),
+             frame.mLatency));
+  }
+}
+
+}  // namespace layers
+}  // namespace mozilla
@@ -0,0 +1,92 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef mozilla_layers_FrameTimingRecorder_h_
+#define mozilla_layers_FrameTimingRecorder_h_
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint32_t, uint64_t
+#include "VsyncSource.h"  // for VsyncId
+#include "mozilla/Array.h"
+#include "mozilla/TimeStamp.h"
+
+namespace mozilla {
+namespace layers {
+
+/**
+ * Keeps the timings of the last kCapacity composites of one compositor (that
+ * is, one display) in a ring buffer: the vsync the composite was started
+ * for, and when the composite started and finished. The end of the composite
+ * includes the buffer swap, so it is as close to the present as we get
+ * without a present fence.
+ *
+ * Latencies are kept as the time from vsync to the end of the composite, in
+ * percent of the vsync interval. A frame is janky if it took longer than one
+ * interval, i.e. missed the vsync after the one it started on. A histogram of
+ * the frames in the ring is updated as frames come and go, so percentiles of
+ * the last kCapacity frames are cheap to get at any time.
+ *
+ * Janky frames get a profiler marker, and ask the platform for more CPU with
+ * an interaction performance hint. Every kCapacity frames the jank
+ * percentage and the 95th percentile go to telemetry, and a summary to the
+ * FrameTiming log. Dump() writes out the whole ring at the log's debug level,
+ * and the verbose level has every frame as it is recorded.
+ *
+ * Compositor thread only, so the ring needs no locking.
+ */
+class FrameTimingRecorder final {
+ public:
+  explicit FrameTimingRecorder(uint64_t aCompositorId);
+
+  void RecordFrame(const VsyncId& aId, const TimeStamp& aVsyncStart,
+                   const TimeStamp& aCompositeStart,
+                   const TimeStamp& aCompositeEnd,
+                   const TimeDuration& aVsyncRate);
+
+  // The latency, in percent of the vsync interval, that aPercentile percent
+  // of the recorded frames didn't exceed. Rounded up to a whole bucket.
+  uint32_t LatencyPercentile(uint32_t aPercentile) const;
+
+  // The percentage of the recorded frames that were janky.
+  uint32_t JankPercentage() const;
+
+  // Logs every frame in the ring, oldest first.
+  void Dump() const;
+
+ private:
+  struct Frame {
+    VsyncId mId;
+    TimeStamp mVsyncStart;
+    TimeStamp mCompositeStart;
+    TimeStamp mCompositeEnd;
+    uint32_t mLatency;
+  };
+
+  // About eight seconds at 60Hz.
+  static const size_t kCapacity = 512;
+  // Latency buckets are this many percent of a vsync interval wide. The last
+  // one takes everything from eight intervals up.
+  static const uint32_t kBucketWidth = 10;
+  static const size_t kBucketCount = 81;
+  static const uint32_t kJankLatency = 100;
+
+  static size_t BucketFor(uint32_t aLatency);
+  void ReportWindow() const;
+
+  const uint64_t mCompositorId;
+  Array<Frame, kCapacity> mFrames;
+  Array<uint32_t, kBucketCount> mBuckets;
+  // Where the next frame goes; once the ring is full, also the oldest one.
+  size_t mNextFrame;
+  size_t mFrameCount;
+  uint32_t mJankCount;
+  uint64_t mTotalFrames;
+};
+
+}  // namespace layers
+}  // namespace mozilla
+
+#endif  // mozilla_layers_FrameTimingRecorder_h_
@@ -22,6 +22,10 @@
 #  include "mozilla/layers/TextureD3D11.h"
 #endif
 
+#if defined(MOZ_WIDGET_GONK)
+#  include "mozilla/layers/GrallocTextureClient.h"
+#endif
+
 namespace mozilla {
 namespace layers {
 
@@ -60,6 +64,12 @@ TextureData* CanvasTranslator::CreateTextureData(TextureType aTextureType,
           D3D11TextureData::Create(aSize, aFormat, ALLOC_CLEAR_BUFFER, mDevice);
       break;
     }
+#endif
+#ifdef MOZ_WIDGET_GONK
+    case TextureType::GrallocBuffer: {
+      textureData = GrallocTextureData::CreateForRemoteCanvas(aSize, aFormat);
+      break;
+    }
 #endif
     default:
       MOZ_CRASH("Unsupported TextureType for CanvasTranslator.");
@@ -145,6 +155,13 @@ mozilla::ipc::IPCResult CanvasTranslator::RecvInitTranslator(
     gfxCriticalNote << "GFX: CanvasTranslator failed to get device";
     return IPC_OK();
   }
+#elif defined(MOZ_WIDGET_GONK)
+  // Gralloc buffers don't depend on a device that can be reset, so the
+  // reference texture only needs creating once.
+  if (!CreateReferenceTexture()) {
+    gfxCriticalNote << "GFX: CanvasTranslator failed to create gralloc buffer";
+    return IPC_OK();
+  }
 #endif
 
   mTranslationTaskQueue = mCanvasThreadHolder->CreateWorkerTaskQueue();
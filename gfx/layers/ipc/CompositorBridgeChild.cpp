@@ -44,6 +44,7 @@
 #include "mozilla/DebugOnly.h"
 #include "mozilla/SpinEventLoopUntil.h"
 #include "nsThreadUtils.h"
+#include "prsystem.h"
 #if defined(XP_WIN)
 #  include "WinUtils.h"
 #endif
@@ -90,6 +91,7 @@ CompositorBridgeChild::CompositorBridgeChild(CompositorManagerChild* aManager)
       mActorDestroyed(false),
       mFwdTransactionId(0),
       mThread(NS_GetCurrentThread()),
+      mTexturePoolsBackground(false),
       mProcessToken(0),
       mSectionAllocator(nullptr),
       mPaintLock("CompositorBridgeChild.mPaintLock"),
@@ -754,12 +756,34 @@ TextureClientPool* CompositorBridgeChild::GetTexturePool(
     }
   }
 
-  mTexturePools.AppendElement(new TextureClientPool(
-      aAllocator, aFormat, gfx::gfxVars::TileSize(), aFlags,
+  gfx::IntSize tileSize = gfx::gfxVars::TileSize();
+  uint32_t initialPoolSize =
+      StaticPrefs::layers_tile_initial_pool_size_AtStartup();
+  uint32_t poolUnusedSize =
+      StaticPrefs::layers_tile_pool_unused_size_AtStartup();
+
+  // Every content process has its own pools, so the defaults, sized for
+  // desktop, add up to a lot of idle tiles on a phone. Don't let a pool keep
+  // more unused tiles than a fraction of physical memory.
+  uint32_t budgetPermille =
+      StaticPrefs::layers_tile_pool_unused_budget_permille_AtStartup();
+  uint64_t tileBytes = uint64_t(tileSize.width) * tileSize.height *
+                       gfx::BytesPerPixel(aFormat);
+  if (budgetPermille && tileBytes) {
+    uint64_t budget = PR_GetPhysicalMemorySize() / 1000 * budgetPermille;
+    uint32_t maxTiles = uint32_t(std::min<uint64_t>(
+        std::max<uint64_t>(budget / tileBytes, 1), UINT32_MAX));
+    initialPoolSize = std::min(initialPoolSize, maxTiles);
+    poolUnusedSize = std::min(poolUnusedSize, maxTiles);
+  }
+
+  RefPtr<TextureClientPool> pool = new TextureClientPool(
+      aAllocator, aFormat, tileSize, aFlags,
       StaticPrefs::layers_tile_pool_shrink_timeout_AtStartup(),
-      StaticPrefs::layers_tile_pool_clear_timeout_AtStartup(),
-      StaticPrefs::layers_tile_initial_pool_size_AtStartup(),
-      StaticPrefs::layers_tile_pool_unused_size_AtStartup(), this));
+      StaticPrefs::layers_tile_pool_clear_timeout_AtStartup(), initialPoolSize,
+      poolUnusedSize, this);
+  pool->SetBackground(mTexturePoolsBackground);
+  mTexturePools.AppendElement(pool);
 
   return mTexturePools.LastElement();
 }
@@ -776,6 +800,13 @@ void CompositorBridgeChild::ClearTexturePool() {
   }
 }
 
+void CompositorBridgeChild::SetTexturePoolsBackground(bool aBackground) {
+  mTexturePoolsBackground = aBackground;
+  for (size_t i = 0; i < mTexturePools.Length(); i++) {
+    mTexturePools[i]->SetBackground(aBackground);
+  }
+}
+
 FixedSizeSmallShmemSectionAllocator*
 CompositorBridgeChild::GetTileLockAllocator() {
   if (!IPCOpen()) {
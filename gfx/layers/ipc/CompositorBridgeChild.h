@@ -188,6 +188,10 @@ class CompositorBridgeChild final : public PCompositorBridgeChild,
                                     TextureFlags aFlags);
   void ClearTexturePool();
 
+  // Called when the process moves to or from the background, see
+  // TextureClientPool::SetBackground().
+  void SetTexturePoolsBackground(bool aBackground);
+
   FixedSizeSmallShmemSectionAllocator* GetTileLockAllocator() override;
 
   void HandleMemoryPressure();
@@ -369,6 +373,7 @@ class CompositorBridgeChild final : public PCompositorBridgeChild,
   nsCOMPtr<nsISerialEventTarget> mThread;
 
   AutoTArray<RefPtr<TextureClientPool>, 2> mTexturePools;
+  bool mTexturePoolsBackground;
 
   uint64_t mProcessToken;
 
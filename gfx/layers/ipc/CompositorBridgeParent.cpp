@@ -50,6 +50,7 @@
 #include "mozilla/layers/CompositorTypes.h"
 #include "mozilla/layers/CompositorVsyncScheduler.h"
 #include "mozilla/layers/ContentCompositorBridgeParent.h"
+#include "mozilla/layers/FrameTimingRecorder.h"
 #include "mozilla/layers/FrameUniformityData.h"
 #include "mozilla/layers/GeckoContentController.h"
 #include "mozilla/layers/ImageBridgeParent.h"
@@ -529,6 +530,11 @@ void CompositorBridgeParent::StopAndClearResources() {
     mCompositor = nullptr;
   }
 
+  if (mFrameTimingRecorder) {
+    mFrameTimingRecorder->Dump();
+    mFrameTimingRecorder = nullptr;
+  }
+
   // This must be destroyed now since it accesses the widget.
   if (mCompositorScheduler) {
     mCompositorScheduler->Destroy();
@@ -942,6 +948,17 @@ void CompositorBridgeParent::CompositeToTarget(VsyncId aId, DrawTarget* aTarget,
   if (!aTarget) {
     TimeStamp end = TimeStamp::Now();
     DidComposite(aId, start, end);
+
+    // Composites forced outside of vsync have no vsync to be late for.
+    if (StaticPrefs::layers_frame_timing_enabled() && aId.IsValid()) {
+      if (!mFrameTimingRecorder) {
+        mFrameTimingRecorder =
+            MakeUnique<FrameTimingRecorder>(mCompositorBridgeID);
+      }
+      mFrameTimingRecorder->RecordFrame(
+          aId, mCompositorScheduler->GetLastVsyncTime(), start, end,
+          mVsyncRate);
+    }
   }
 
   // We're not really taking advantage of the stored composite-again-time here.
@@ -22,6 +22,7 @@
 #include "mozilla/Monitor.h"    // for Monitor
 #include "mozilla/RefPtr.h"     // for RefPtr
 #include "mozilla/TimeStamp.h"  // for TimeStamp
+#include "mozilla/UniquePtr.h"
 #include "mozilla/gfx/Point.h"  // for IntSize
 #include "mozilla/ipc/ProtocolUtils.h"
 #include "mozilla/ipc/SharedMemory.h"
@@ -85,6 +86,7 @@ class CompositorAnimationStorage;
 class CompositorBridgeParent;
 class CompositorManagerParent;
 class CompositorVsyncScheduler;
+class FrameTimingRecorder;
 class FrameUniformityData;
 class GeckoContentController;
 class HostLayerManager;
@@ -826,6 +828,8 @@ class CompositorBridgeParent final : public CompositorBridgeParentBase,
   RefPtr<OMTASampler> mOMTASampler;
 
   RefPtr<CompositorVsyncScheduler> mCompositorScheduler;
+  // Created on the first composite if layers.frame-timing.enabled is set.
+  UniquePtr<FrameTimingRecorder> mFrameTimingRecorder;
   // This makes sure the compositorParent is not destroyed before receiving
   // confirmation that the channel is closed.
   // mSelfRef is cleared in DeferredDestroy which is scheduled by ActorDestroy.
@@ -75,6 +75,7 @@ CompositorVsyncScheduler::CompositorVsyncScheduler(
       mLastVsyncOutputTime(TimeStamp::Now()),
       mIsObservingVsync(false),
       mVsyncNotificationsSkipped(0),
+      mVsyncCount(0),
       mWidget(aWidget),
       mCurrentCompositeTaskMonitor("CurrentCompositeTaskMonitor"),
       mCurrentCompositeTask(nullptr),
@@ -320,6 +321,12 @@ bool CompositorVsyncScheduler::NotifyVsync(const VsyncEvent& aVsync) {
                 CompositorThreadHolder::IsInCompositorThread());
 #endif  // DEBUG
 
+  // Lowers the composition rate, e.g. while the device is hot.
+  uint32_t divisor = StaticPrefs::gfx_vsync_compositor_divisor();
+  if (divisor > 1 && mVsyncCount++ % divisor != 0) {
+    return true;
+  }
+
 #if defined(MOZ_WIDGET_ANDROID)
   gfx::VRManager* vm = gfx::VRManager::Get();
   if (!vm->IsPresenting()) {
@@ -382,9 +389,10 @@ void CompositorVsyncScheduler::Composite(const VsyncEvent& aVsyncEvent) {
       return;
     }
   }
-  NS_DispatchToMainThread(NewRunnableMethod<TimeStamp>(
+  NS_DispatchToMainThread(NewRunnableMethod<TimeStamp, TimeStamp>(
     "CompositorVsyncScheduler::DispatchTouchEvents", this,
-    &CompositorVsyncScheduler::DispatchTouchEvents, aVsyncEvent.mTime));
+    &CompositorVsyncScheduler::DispatchTouchEvents, aVsyncEvent.mTime,
+    aVsyncEvent.mOutputTime));
 
   DispatchVREvents(aVsyncEvent.mTime);
 
@@ -460,10 +468,12 @@ void CompositorVsyncScheduler::UnobserveVsync() {
 }
 
 void
-CompositorVsyncScheduler::DispatchTouchEvents(TimeStamp aVsyncTimestamp)
+CompositorVsyncScheduler::DispatchTouchEvents(TimeStamp aVsyncTimestamp,
+                                              TimeStamp aOutputTimestamp)
 {
 #ifdef MOZ_WIDGET_GONK
-  GeckoTouchDispatcher::GetInstance()->NotifyVsync(aVsyncTimestamp);
+  GeckoTouchDispatcher::GetInstance()->NotifyVsync(aVsyncTimestamp,
+                                                   aOutputTimestamp);
 #endif
 }
 
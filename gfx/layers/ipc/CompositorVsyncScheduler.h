@@ -144,7 +144,8 @@ class CompositorVsyncScheduler {
   void ObserveVsync();
   void UnobserveVsync();
 
-  void DispatchTouchEvents(TimeStamp aVsyncTimestamp);
+  void DispatchTouchEvents(TimeStamp aVsyncTimestamp,
+                           TimeStamp aOutputTimestamp);
   void DispatchVREvents(TimeStamp aVsyncTimestamp);
 
   void CancelCurrentSetNeedsCompositeTask();
@@ -177,6 +178,9 @@ class CompositorVsyncScheduler {
   bool mIsObservingVsync;
   TimeStamp mCompositeRequestedAt;
   int32_t mVsyncNotificationsSkipped;
+  // Counts the vsyncs seen, to only use every Nth of them when
+  // gfx.vsync.compositor.divisor is above 1.
+  uint32_t mVsyncCount;
   widget::CompositorWidget* mWidget;
   RefPtr<CompositorVsyncScheduler::Observer> mVsyncObserver;
 
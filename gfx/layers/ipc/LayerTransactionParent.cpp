@@ -523,14 +523,17 @@ bool LayerTransactionParent::SetLayerAttributes(
   } else {
     layer->SetMaskLayer(nullptr);
   }
-  layer->SetCompositorAnimations(mId, common.compositorAnimations());
-  // Clean up the Animations by id in the CompositorAnimationStorage
-  // if there are no active animations on the layer
-  if (mAnimStorage && layer->GetCompositorAnimationsId() &&
-      layer->GetPropertyAnimationGroups().IsEmpty()) {
-    mAnimStorage->ClearById(layer->GetCompositorAnimationsId());
+  if (common.compositorAnimations()) {
+    layer->SetCompositorAnimations(mId, *common.compositorAnimations());
+    // Clean up the Animations by id in the CompositorAnimationStorage
+    // if there are no active animations on the layer
+    if (mAnimStorage && layer->GetCompositorAnimationsId() &&
+        layer->GetPropertyAnimationGroups().IsEmpty()) {
+      mAnimStorage->ClearById(layer->GetCompositorAnimationsId());
+    }
   }
-  if (common.scrollMetadata() != layer->GetAllScrollMetadata()) {
+  if (common.scrollMetadataChanged() &&
+      common.scrollMetadata() != layer->GetAllScrollMetadata()) {
     UpdateHitTestingTree(layer, "scroll metadata changed");
     layer->SetScrollMetadata(common.scrollMetadata());
   }
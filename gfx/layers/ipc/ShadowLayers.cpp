@@ -637,11 +637,19 @@ bool ShadowLayerForwarder::EndTransaction(
     } else {
       common.maskLayer() = LayerHandle();
     }
-    common.compositorAnimations().id() = mutant->GetCompositorAnimationsId();
-    common.compositorAnimations().animations() =
-        mutant->GetAnimations().Clone();
+    if (shadow->UpdateSentAnimations(mutant->GetCompositorAnimationsId(),
+                                     mutant->GetAnimations())) {
+      CompositorAnimations animations;
+      animations.id() = mutant->GetCompositorAnimationsId();
+      animations.animations() = mutant->GetAnimations().Clone();
+      common.compositorAnimations() = Some(std::move(animations));
+    }
     common.invalidRegion() = mutant->GetInvalidRegion().GetRegion();
-    common.scrollMetadata() = mutant->GetAllScrollMetadata().Clone();
+    common.scrollMetadataChanged() =
+        shadow->UpdateSentScrollMetadata(mutant->GetAllScrollMetadata());
+    if (common.scrollMetadataChanged()) {
+      common.scrollMetadata() = mutant->GetAllScrollMetadata().Clone();
+    }
     for (size_t i = 0; i < mutant->GetAncestorMaskLayerCount(); i++) {
       auto layer =
           Shadow(mutant->GetAncestorMaskLayerAt(i)->AsShadowableLayer());
@@ -1052,5 +1060,24 @@ ShadowableLayer::~ShadowableLayer() {
   }
 }
 
+bool ShadowableLayer::UpdateSentAnimations(
+    uint64_t aId, const nsTArray<Animation>& aAnimations) {
+  if (mSentAnimationsId == Some(aId) && mSentAnimations == aAnimations) {
+    return false;
+  }
+  mSentAnimationsId = Some(aId);
+  mSentAnimations = aAnimations.Clone();
+  return true;
+}
+
+bool ShadowableLayer::UpdateSentScrollMetadata(
+    const nsTArray<ScrollMetadata>& aMetadata) {
+  if (mSentScrollMetadata && *mSentScrollMetadata == aMetadata) {
+    return false;
+  }
+  mSentScrollMetadata = Some(aMetadata.Clone());
+  return true;
+}
+
 }  // namespace layers
 }  // namespace mozilla
@@ -21,6 +21,9 @@
 #include "mozilla/layers/TextureForwarder.h"
 #include "mozilla/layers/CompositorTypes.h"  // for OpenMode, etc
 #include "mozilla/layers/CompositorBridgeChild.h"
+#include "mozilla/layers/LayersMessages.h"
+#include "mozilla/Maybe.h"
+#include "FrameMetrics.h"
 #include "nsCOMPtr.h"                // for already_AddRefed
 #include "nsRegion.h"                // for nsIntRegion
 #include "nsTArrayForwardDeclare.h"  // for nsTArray
@@ -459,12 +462,24 @@ class ShadowableLayer {
 
   virtual CompositableClient* GetCompositableClient() { return nullptr; }
 
+  /**
+   * Return whether these differ from what was last sent to our shadow, and
+   * if so remember them as sent.
+   */
+  bool UpdateSentAnimations(uint64_t aId,
+                            const nsTArray<Animation>& aAnimations);
+  bool UpdateSentScrollMetadata(const nsTArray<ScrollMetadata>& aMetadata);
+
  protected:
   ShadowableLayer() = default;
 
  private:
   RefPtr<ShadowLayerForwarder> mForwarder;
   LayerHandle mShadow;
+
+  Maybe<uint64_t> mSentAnimationsId;
+  nsTArray<Animation> mSentAnimations;
+  Maybe<nsTArray<ScrollMetadata>> mSentScrollMetadata;
 };
 
 }  // namespace layers
@@ -79,6 +79,10 @@ using namespace mozilla::gl;
 static const GLuint kCoordinateAttributeIndex = 0;
 static const GLuint kTexCoordinateAttributeIndex = 1;
 
+// The oldest back buffer, in frames, we keep enough history to redraw
+// partially. Anything older is drawn in full.
+static const uint32_t kMaxPartialRedrawBufferAge = 4;
+
 class AsyncReadbackBufferOGL final : public AsyncReadbackBuffer {
  public:
   AsyncReadbackBufferOGL(GLContext* aGL, const IntSize& aSize);
@@ -1045,7 +1049,21 @@ Maybe<IntRect> CompositorOGL::BeginFrame(const nsIntRegion& aInvalidRegion,
   SetRenderTarget(rt);
   mWindowRenderTarget = mCurrentRenderTarget;
 
-  for (auto iter = aInvalidRegion.RectIter(); !iter.Done(); iter.Next()) {
+  Maybe<IntRect> redrawRect;
+  if (!mTarget) {
+    redrawRect = ComputePartialRedrawRect(aInvalidRegion, rect);
+  }
+
+  IntRegion frameDamage = aInvalidRegion;
+  if (redrawRect) {
+    // The rest of the back buffer still holds what we drew there before, so
+    // clip everything we draw this frame to what has changed since.
+    mCurrentRenderTarget->SetClipRect(redrawRect);
+    mPixelsPerFrame = redrawRect->Area();
+    frameDamage = *redrawRect;
+  }
+
+  for (auto iter = frameDamage.RectIter(); !iter.Done(); iter.Next()) {
     const IntRect& r = iter.Get();
     mCurrentFrameInvalidRegion.OrWith(
         IntRect(r.X(), FlipY(r.YMost()), r.Width(), r.Height()));
@@ -1055,11 +1073,17 @@ Maybe<IntRect> CompositorOGL::BeginFrame(const nsIntRegion& aInvalidRegion,
   // TODO: Currently we initialize the clear region to the widget bounds as
   // SwapBuffers will update the entire framebuffer. On platforms that support
   // damage regions, we could initialize this to mCurrentFrameInvalidRegion.
-  IntRegion regionToClear(rect);
+  IntRegion regionToClear(redrawRect.valueOr(rect));
   regionToClear.SubOut(aOpaqueRegion);
   GLbitfield clearBits = LOCAL_GL_DEPTH_BUFFER_BIT;
-  if (regionToClear.IsEmpty() &&
-      mGLContext->IsSupported(GLFeature::invalidate_framebuffer)) {
+  if (redrawRect) {
+    // The framebuffer must not be invalidated, since we keep what's outside
+    // redrawRect.
+    if (!regionToClear.IsEmpty()) {
+      clearBits |= LOCAL_GL_COLOR_BUFFER_BIT;
+    }
+  } else if (regionToClear.IsEmpty() &&
+             mGLContext->IsSupported(GLFeature::invalidate_framebuffer)) {
     GLenum attachments[] = {LOCAL_GL_COLOR};
     mGLContext->fInvalidateFramebuffer(
         LOCAL_GL_FRAMEBUFFER, MOZ_ARRAY_LENGTH(attachments), attachments);
@@ -1082,11 +1106,60 @@ Maybe<IntRect> CompositorOGL::BeginFrame(const nsIntRegion& aInvalidRegion,
   mGLContext->fClearColor(mClearColor.r, mClearColor.g, mClearColor.b,
                           mClearColor.a);
 #endif  // defined(MOZ_WIDGET_ANDROID)
-  mGLContext->fClear(clearBits);
+  if (redrawRect) {
+    ScopedGLState scopedScissorTestState(mGLContext, LOCAL_GL_SCISSOR_TEST,
+                                         true);
+    ScopedScissorRect autoScissorRect(mGLContext, redrawRect->x,
+                                      FlipY(redrawRect->YMost()),
+                                      redrawRect->Width(),
+                                      redrawRect->Height());
+    mGLContext->fClear(clearBits);
+  } else {
+    mGLContext->fClear(clearBits);
+  }
 
   return Some(rect);
 }
 
+Maybe<IntRect> CompositorOGL::ComputePartialRedrawRect(
+    const nsIntRegion& aInvalidRegion, const IntRect& aWindowRect) {
+  // The GL cursor is drawn on top of every frame without being part of the
+  // invalid region, so it would leave trails behind.
+  if (!StaticPrefs::layers_partial_redraw_enabled() ||
+      StaticPrefs::dom_virtualcursor_enabled() ||
+      !aWindowRect.IsEqualEdges(mPreviousFrameWindowRect)) {
+    mPreviousFrameInvalidRegions.Clear();
+    mPreviousFrameWindowRect = aWindowRect;
+    return Nothing();
+  }
+
+  IntRegion invalid;
+  invalid.And(aInvalidRegion, aWindowRect);
+
+  // A buffer of age N was last drawn N frames ago, so it misses the changes
+  // of the N - 1 frames since as well as this one. An age of 0 means its
+  // contents are undefined.
+  GLint age = mGLContext->GetBufferAge();
+  Maybe<IntRect> redrawRect;
+  if (age > 0 &&
+      uint32_t(age) - 1 <= mPreviousFrameInvalidRegions.Length()) {
+    IntRegion redraw = invalid;
+    for (GLint i = 0; i < age - 1; i++) {
+      redraw.OrWith(mPreviousFrameInvalidRegions[i]);
+    }
+    IntRect bounds = redraw.GetBounds();
+    if (!bounds.Contains(aWindowRect)) {
+      redrawRect = Some(bounds);
+    }
+  }
+
+  mPreviousFrameInvalidRegions.InsertElementAt(0, std::move(invalid));
+  if (mPreviousFrameInvalidRegions.Length() > kMaxPartialRedrawBufferAge) {
+    mPreviousFrameInvalidRegions.TruncateLength(kMaxPartialRedrawBufferAge);
+  }
+  return redrawRect;
+}
+
 void CompositorOGL::CreateFBOWithTexture(const gfx::IntRect& aRect,
                                          bool aCopyFromSource,
                                          GLuint aSourceFrameBuffer,
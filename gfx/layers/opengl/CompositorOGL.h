@@ -298,6 +298,11 @@ class CompositorOGL final : public Compositor {
 
   bool NeedToRecreateFullWindowRenderTarget() const;
 
+  // Returns the part of aWindowRect that needs to be drawn again for the
+  // window's back buffer to be current, or Nothing() if that's all of it.
+  Maybe<gfx::IntRect> ComputePartialRedrawRect(
+      const nsIntRegion& aInvalidRegion, const gfx::IntRect& aWindowRect);
+
   /** Widget associated with this compositor */
   LayoutDeviceIntSize mWidgetSize;
   RefPtr<GLContext> mGLContext;
@@ -535,6 +540,11 @@ class CompositorOGL final : public Compositor {
 
   gfx::IntRegion mCurrentFrameInvalidRegion;
 
+  // Invalid regions of the last frames drawn to the window, most recent
+  // first, and the window rect they were drawn for.
+  nsTArray<gfx::IntRegion> mPreviousFrameInvalidRegions;
+  gfx::IntRect mPreviousFrameWindowRect;
+
   RefPtr<gfx::DataSourceSurface> mCursorSurfaceCache;
   RefPtr<DataTextureSource> mCursorTextureCache;
 };
@@ -100,6 +100,7 @@ GrallocTextureData::GrallocTextureData(MaybeMagicGrallocBufferHandle aGrallocHan
 , mMoz2DBackend(aMoz2DBackend)
 , mGrallocHandle(aGrallocHandle)
 , mMappedBuffer(nullptr)
+, mReleaseOnDestroy(false)
 , mMediaBuffer(nullptr)
 {
   mGraphicBuffer = GetGraphicBufferFrom(aGrallocHandle);
@@ -108,6 +109,12 @@ GrallocTextureData::GrallocTextureData(MaybeMagicGrallocBufferHandle aGrallocHan
 
 GrallocTextureData::~GrallocTextureData()
 {
+  if (mReleaseOnDestroy) {
+    if (mMappedBuffer) {
+      Unlock();
+    }
+    SharedBufferManagerChild::GetSingleton()->DeallocGrallocBuffer(mGrallocHandle);
+  }
   MOZ_COUNT_DTOR(GrallocTextureData);
 }
 
@@ -300,6 +307,14 @@ GrallocTextureData::Create(gfx::IntSize aSize, AndroidFormat aAndroidFormat,
   //if (aSize.width > maxSize || aSize.height > maxSize) {
   //  return nullptr;
   //}
+  return Allocate(aSize, aAndroidFormat, aMoz2dBackend, aUsage);
+}
+
+// static
+GrallocTextureData*
+GrallocTextureData::Allocate(gfx::IntSize aSize, AndroidFormat aAndroidFormat,
+                             gfx::BackendType aMoz2dBackend, uint32_t aUsage)
+{
   gfx::SurfaceFormat format;
   switch (aAndroidFormat) {
   case android::PIXEL_FORMAT_RGBA_8888:
@@ -393,6 +408,40 @@ GrallocTextureData::CreateForDrawing(gfx::IntSize aSize, gfx::SurfaceFormat aFor
   return data;
 }
 
+// static
+GrallocTextureData*
+GrallocTextureData::CreateForRemoteCanvas(gfx::IntSize aSize, gfx::SurfaceFormat aFormat)
+{
+  if (DisableGralloc(aFormat, aSize)) {
+    return nullptr;
+  }
+
+  uint32_t usage = android::GraphicBuffer::USAGE_SW_READ_OFTEN |
+                   android::GraphicBuffer::USAGE_SW_WRITE_OFTEN |
+                   android::GraphicBuffer::USAGE_HW_TEXTURE;
+  GrallocTextureData* data = Allocate(aSize, GetAndroidFormat(aFormat),
+                                      gfx::BackendType::SKIA, usage);
+  if (!data) {
+    return nullptr;
+  }
+  data->mReleaseOnDestroy = true;
+
+  // Recorded canvases start out transparent, unlike freshly allocated gralloc
+  // memory.
+  uint8_t* buffer;
+  android::status_t rv = data->mGraphicBuffer->lock(android::GraphicBuffer::USAGE_SW_WRITE_OFTEN,
+                                                    reinterpret_cast<void**>(&buffer));
+  if (rv != android::OK) {
+    delete data;
+    return nullptr;
+  }
+  memset(buffer, 0, data->mGraphicBuffer->getStride() * aSize.height *
+                    BytesPerPixel(data->mFormat));
+  data->mGraphicBuffer->unlock();
+
+  return data;
+}
+
 TextureFlags
 GrallocTextureData::GetTextureFlags() const
 {
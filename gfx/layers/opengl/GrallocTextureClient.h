@@ -72,6 +72,12 @@ public:
                                     gfx::BackendType aMoz2DBackend, uint32_t aUsage,
                                     LayersIPCChannel* aAllocator);
 
+  /// Creates a cleared buffer for the compositor-side CanvasTranslator. The
+  /// translator has no LayersIPCChannel to deallocate through, so the buffer
+  /// is handed back to the SharedBufferManager when the data is destroyed.
+  static GrallocTextureData* CreateForRemoteCanvas(gfx::IntSize aSize,
+                                                   gfx::SurfaceFormat aFormat);
+
   virtual TextureData* CreateSimilar(
       LayersIPCChannel* aAllocator, LayersBackend aLayersBackend,
       TextureFlags aFlags = TextureFlags::DEFAULT,
@@ -137,6 +143,9 @@ protected:
                      gfx::IntSize aSize, gfx::SurfaceFormat aFormat,
                      gfx::BackendType aMoz2DBackend);
 
+  static GrallocTextureData* Allocate(gfx::IntSize aSize, AndroidFormat aFormat,
+                                      gfx::BackendType aMoz2DBackend, uint32_t aUsage);
+
   gfx::IntSize mSize;
   gfx::SurfaceFormat mFormat;
   gfx::BackendType mMoz2DBackend;
@@ -151,6 +160,10 @@ protected:
   // Should be null outside of the lock-unlock pair.
   uint8_t* mMappedBuffer;
 
+  // Set for buffers from CreateForRemoteCanvas(), which are released in the
+  // destructor rather than through Deallocate().
+  bool mReleaseOnDestroy;
+
   android::MediaBuffer* mMediaBuffer;
   android::sp<android::RefBase> mMediaPrivate;
 };
@@ -17,6 +17,12 @@ SkMemoryReporter::CollectReports(nsIHandleReportCallback* aHandleReport,
   MOZ_COLLECT_REPORT("explicit/skia-font-cache", KIND_HEAP, UNITS_BYTES,
                      SkGraphics::GetFontCacheUsed(),
                      "Memory used in the skia font cache.");
+  MOZ_COLLECT_REPORT("skia-font-cache/limit", KIND_OTHER, UNITS_BYTES,
+                     SkGraphics::GetFontCacheLimit(),
+                     "Byte budget of the skia font cache.");
+  MOZ_COLLECT_REPORT("skia-font-cache/glyph-caches", KIND_OTHER, UNITS_COUNT,
+                     SkGraphics::GetFontCacheCountUsed(),
+                     "Number of per-font glyph caches in the skia font cache.");
   return NS_OK;
 }
 
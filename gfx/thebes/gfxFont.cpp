@@ -20,6 +20,7 @@
 
 #include "gfxGlyphExtents.h"
 #include "gfxPlatform.h"
+#include "gfxShapedWordStore.h"
 #include "gfxTextRun.h"
 #include "nsGkAtoms.h"
 
@@ -2773,6 +2774,16 @@ gfxShapedWord* gfxFont::GetShapedWord(
   }
 #endif
 
+  gfxShapedWordStore* store = aVertical ? nullptr : gfxShapedWordStore::Get();
+  if (store) {
+    sw = store->Lookup(this, aText, aLength, aRunScript, aLanguage,
+                       aAppUnitsPerDevUnit, aFlags, aRounding);
+    if (sw) {
+      entry->mShapedWord.reset(sw);
+      return sw;
+    }
+  }
+
   sw = gfxShapedWord::Create(aText, aLength, aRunScript, aLanguage,
                              aAppUnitsPerDevUnit, aFlags, aRounding);
   entry->mShapedWord.reset(sw);
@@ -2781,11 +2792,15 @@ gfxShapedWord* gfxFont::GetShapedWord(
     return nullptr;
   }
 
-  DebugOnly<bool> ok = ShapeText(aDrawTarget, aText, 0, aLength, aRunScript,
-                                 aLanguage, aVertical, aRounding, sw);
+  bool ok = ShapeText(aDrawTarget, aText, 0, aLength, aRunScript, aLanguage,
+                      aVertical, aRounding, sw);
 
   NS_WARNING_ASSERTION(ok, "failed to shape word - expect garbled text");
 
+  if (ok && store) {
+    store->WordShaped(this, sw);
+  }
+
   return sw;
 }
 
@@ -2794,6 +2809,18 @@ template gfxShapedWord* gfxFont::GetShapedWord(
     uint32_t aHash, Script aRunScript, nsAtom* aLanguage, bool aVertical,
     int32_t aAppUnitsPerDevUnit, gfx::ShapedTextFlags aFlags,
     RoundingFlags aRounding, gfxTextPerfMetrics* aTextPerf);
+template gfxShapedWord* gfxFont::GetShapedWord(
+    DrawTarget* aDrawTarget, const char16_t* aText, uint32_t aLength,
+    uint32_t aHash, Script aRunScript, nsAtom* aLanguage, bool aVertical,
+    int32_t aAppUnitsPerDevUnit, gfx::ShapedTextFlags aFlags,
+    RoundingFlags aRounding, gfxTextPerfMetrics* aTextPerf);
+
+uint64_t gfxFont::ShapedWordStoreKey() {
+  if (!mShapedWordStoreKey) {
+    mShapedWordStoreKey = Some(gfxShapedWordStore::FontKey(this));
+  }
+  return *mShapedWordStoreKey;
+}
 
 bool gfxFont::CacheHashEntry::KeyEquals(const KeyTypePointer aKey) const {
   const gfxShapedWord* sw = mShapedWord.get();
@@ -17,6 +17,7 @@
 #include "mozilla/AlreadyAddRefed.h"
 #include "mozilla/Attributes.h"
 #include "mozilla/FontPropertyTypes.h"
+#include "mozilla/Maybe.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/RefPtr.h"
 #include "mozilla/ServoStyleConsts.h"
@@ -1831,6 +1832,10 @@ class gfxFont {
   // Glyph rendering/geometry has changed, so invalidate data as necessary.
   void NotifyGlyphsChanged();
 
+  // The key of this font in the gfxShapedWordStore, or 0 if the store
+  // doesn't keep its words. Computed on first use.
+  uint64_t ShapedWordStoreKey();
+
   virtual void AddSizeOfExcludingThis(mozilla::MallocSizeOf aMallocSizeOf,
                                       FontCacheSizes* aSizes) const;
   virtual void AddSizeOfIncludingThis(mozilla::MallocSizeOf aMallocSizeOf,
@@ -2135,6 +2140,7 @@ class gfxFont {
   };
 
   mozilla::UniquePtr<nsTHashtable<CacheHashEntry>> mWordCache;
+  mozilla::Maybe<uint64_t> mShapedWordStoreKey;
 
   static const uint32_t kShapedWordCacheMaxAge = 3;
 
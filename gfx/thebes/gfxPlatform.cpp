@@ -21,6 +21,7 @@
 #include "mozilla/gfx/gfxVars.h"
 #include "mozilla/gfx/GPUProcessManager.h"
 #include "mozilla/gfx/GraphicsMessages.h"
+#include "mozilla/AppUnits.h"
 #include "mozilla/ClearOnShutdown.h"
 #include "mozilla/StaticPrefs_accessibility.h"
 #include "mozilla/StaticPrefs_apz.h"
@@ -134,6 +135,8 @@ static const uint32_t kDefaultGlyphCacheSize = -1;
 #endif
 
 #include "mozilla/Preferences.h"
+#include "mozilla/StaticPtr.h"
+#include "nsCharSeparatedTokenizer.h"
 #include "mozilla/Assertions.h"
 #include "mozilla/Atomics.h"
 #include "mozilla/Attributes.h"
@@ -643,6 +646,14 @@ static uint32_t GetSkiaGlyphCacheSize() {
   // Only increase memory on the content process
   uint32_t cacheSize =
       StaticPrefs::gfx_content_skia_font_cache_size_AtStartup() * 1024 * 1024;
+#    if defined(MOZ_WIDGET_GONK)
+  // Every app runs in its own content process, so scale the cache with the
+  // device memory class: 1/256th of physical memory, between the 2MB Skia
+  // default and the pref.
+  uint64_t budget = PR_GetPhysicalMemorySize() / 256;
+  budget = std::max<uint64_t>(budget, 2 * 1024 * 1024);
+  cacheSize = std::min<uint64_t>(cacheSize, budget);
+#    endif
   if (mozilla::BrowserTabsRemoteAutostart()) {
     return XRE_IsContentProcess() ? cacheSize : kDefaultGlyphCacheSize;
   }
@@ -1700,6 +1711,72 @@ void gfxPlatform::PurgeSkiaFontCache() {
 #endif
 }
 
+// Font groups whose glyphs PrerenderCommonGlyphs drew. Holding on to them
+// keeps their fonts, and so the scaled fonts the glyph cache entries belong
+// to, from expiring before the app using this process paints.
+static StaticAutoPtr<nsTArray<RefPtr<gfxFontGroup>>> sPrerenderedFontGroups;
+
+/* static */
+void gfxPlatform::PrerenderCommonGlyphs() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  nsAutoCString sizes;
+  Preferences::GetCString("gfx.font-prerender.sizes", sizes);
+  if (sizes.IsEmpty()) {
+    return;
+  }
+
+  RefPtr<DrawTarget> dt =
+      GetPlatform()->CreateOffscreenContentDrawTarget(IntSize(64, 64),
+                                                      SurfaceFormat::B8G8R8A8);
+  RefPtr<gfxContext> ctx = gfxContext::CreateOrNull(dt);
+  if (!ctx) {
+    return;
+  }
+
+  // Printable ASCII, which covers most of the UI text of an app.
+  uint8_t text[0x7f - 0x20];
+  for (uint32_t i = 0; i < ArrayLength(text); i++) {
+    text[i] = uint8_t(0x20 + i);
+  }
+
+  if (!sPrerenderedFontGroups) {
+    sPrerenderedFontGroups = new nsTArray<RefPtr<gfxFontGroup>>();
+    ClearOnShutdown(&sPrerenderedFontGroups);
+  }
+
+  for (const nsACString& size :
+       nsCCharSeparatedTokenizer(sizes, ',').ToRange()) {
+    nsresult rv;
+    float px = PromiseFlatCString(size).ToFloat(&rv);
+    if (NS_FAILED(rv) || px <= 0.0f) {
+      continue;
+    }
+
+    // Sizes are in device pixels, so draw with one CSS pixel per device
+    // pixel and no transform; that gives the same glyph cache keys as text
+    // painted by layout at that size.
+    gfxFontStyle style;
+    style.size = px;
+    RefPtr<gfxFontGroup> fontGroup = GetPlatform()->CreateFontGroup(
+        FontFamilyList(StyleGenericFontFamily::SansSerif), &style,
+        nsGkAtoms::x_western, false, nullptr, nullptr, nullptr, 1.0);
+    RefPtr<gfxTextRun> textRun = fontGroup->MakeTextRun(
+        text, ArrayLength(text), dt, AppUnitsPerCSSPixel(),
+        gfx::ShapedTextFlags(), nsTextFrameUtils::Flags(), nullptr);
+    if (!textRun) {
+      continue;
+    }
+
+    // Every glyph is drawn at the origin; only rasterizing them matters.
+    gfxTextRun::DrawParams params(ctx);
+    for (uint32_t i = 0; i < textRun->GetLength(); i++) {
+      textRun->Draw(gfxTextRun::Range(i, i + 1), gfx::Point(0, px), params);
+    }
+    sPrerenderedFontGroups->AppendElement(std::move(fontGroup));
+  }
+}
+
 already_AddRefed<DrawTarget> gfxPlatform::CreateDrawTargetForBackend(
     BackendType aBackend, const IntSize& aSize, SurfaceFormat aFormat) {
   // There is a bunch of knowledge in the gfxPlatform heirarchy about how to
@@ -2554,8 +2631,14 @@ void gfxPlatform::InitAcceleration() {
         "media.hardware-video-decoding.failed");
     InitGPUProcessPrefs();
 
+#ifdef MOZ_WIDGET_GONK
+    // Gonk has no GPU process, the translator runs on the parent process
+    // compositor and draws into gralloc buffers.
+    gfxVars::SetRemoteCanvasEnabled(StaticPrefs::gfx_canvas_remote());
+#else
     gfxVars::SetRemoteCanvasEnabled(StaticPrefs::gfx_canvas_remote() &&
                                     gfxConfig::IsEnabled(Feature::GPU_PROCESS));
+#endif
   }
 }
 
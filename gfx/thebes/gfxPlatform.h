@@ -682,6 +682,15 @@ class gfxPlatform : public mozilla::layers::MemoryPressureListener {
 
   static void PurgeSkiaFontCache();
 
+  /**
+   * Draws the printable ASCII glyphs of the default sans-serif font at the
+   * device pixel sizes listed in gfx.font-prerender.sizes, so that they are
+   * in the glyph cache before the first paint, and keeps those fonts alive.
+   * Meant for preallocated content processes, which are idle until an app
+   * is launched into them.
+   */
+  static void PrerenderCommonGlyphs();
+
   virtual bool IsInGonkEmulator() const { return false; }
 
   static bool UsesOffMainThreadCompositing();
@@ -0,0 +1,685 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "gfxShapedWordStore.h"
+
+#include "gfxFontConstants.h"
+#include "gfxFontUtils.h"
+#include "gfxPlatform.h"
+#include "gfxPlatformFontList.h"
+#include "mozilla/Casting.h"
+#include "mozilla/ClearOnShutdown.h"
+#include "mozilla/HashFunctions.h"
+#include "mozilla/Latin1.h"
+#include "mozilla/Logging.h"
+#include "mozilla/StaticPrefs_gfx.h"
+#include "mozilla/StaticPtr.h"
+#include "mozilla/dom/ContentChild.h"
+#include "mozilla/dom/PContent.h"
+#include "mozilla/ipc/FileDescriptor.h"
+#include "nsAppDirectoryServiceDefs.h"
+#include "nsDirectoryServiceUtils.h"
+#include "nsIFile.h"
+#include "nsITimer.h"
+#include "nsThreadUtils.h"
+#include "nsXULAppAPI.h"
+#include "prio.h"
+
+using namespace mozilla;
+using mozilla::dom::ShapedWordFont;
+using mozilla::dom::ShapedWordText;
+using mozilla::ipc::FileDescriptor;
+
+static LazyLogModule sShapedWordStoreLog("ShapedWordStore");
+#define LOG(...) MOZ_LOG(sShapedWordStoreLog, LogLevel::Debug, (__VA_ARGS__))
+
+static const uint32_t kMagic = 0x44575347;  // "GSWD"
+static const uint32_t kVersion = 1;
+
+// A content process sends the words it shaped this long after the first one.
+static const uint32_t kFlushDelayMS = 5000;
+// The parent writes the file this long after the first word it added.
+static const uint32_t kWriteDelayMS = 30000;
+// The most words a content process sends at a time.
+static const uint32_t kMaxPendingWords = 1024;
+
+struct FileHeader {
+  uint32_t mMagic;
+  uint32_t mVersion;
+  uint32_t mBuildID;
+  uint32_t mPadding;
+};
+
+// Followed by the language tag, the text as UTF-16 and, 4-byte aligned, the
+// glyph records. Everything is in native byte order, the file never leaves
+// the device.
+struct gfxShapedWordStore::RecordHeader {
+  uint64_t mFontKey;
+  uint32_t mWordHash;
+  uint16_t mLength;
+  uint16_t mFlags;
+  uint16_t mAppUnitsPerDevUnit;
+  int16_t mScript;
+  uint8_t mRounding;
+  uint8_t mLanguageLength;
+  uint16_t mPadding;
+};
+
+struct gfxShapedWordStore::PendingFont {
+  ShapedWordFont mFont;
+  nsTArray<ShapedWordText> mWords;
+};
+
+static StaticAutoPtr<gfxShapedWordStore> sStore;
+static bool sShutdown = false;
+
+static uint32_t BuildID() { return HashString(PlatformBuildID()); }
+
+static size_t GlyphsOffset(uint32_t aLanguageLength, uint32_t aLength) {
+  size_t offset = sizeof(gfxShapedWordStore::RecordHeader) + aLanguageLength +
+                  aLength * sizeof(char16_t);
+  return (offset + 3) & ~size_t(3);
+}
+
+static size_t RecordSize(uint32_t aLanguageLength, uint32_t aLength) {
+  return GlyphsOffset(aLanguageLength, aLength) +
+         aLength * sizeof(gfxShapedText::CompressedGlyph);
+}
+
+template <typename T>
+static uint32_t WordHash(const T* aText, uint32_t aLength,
+                         unicode::Script aScript, int32_t aAppUnitsPerDevUnit,
+                         gfx::ShapedTextFlags aFlags,
+                         gfxFontShaper::RoundingFlags aRounding) {
+  uint32_t hash = HashGeneric(aLength, uint16_t(aFlags), aAppUnitsPerDevUnit,
+                              int(aScript), int(aRounding));
+  for (uint32_t i = 0; i < aLength; i++) {
+    hash = AddToHash(hash, char16_t(aText[i]));
+  }
+  return hash;
+}
+
+static uint64_t IndexKey(uint64_t aFontKey, uint32_t aWordHash) {
+  return aFontKey ^ (uint64_t(aWordHash) * 0x9E3779B97F4A7C15ULL);
+}
+
+// Untrusted values from a content process: NaN goes to aMin too.
+static float ClampFloat(float aValue, float aMin, float aMax) {
+  return aValue >= aMin ? std::min(aValue, aMax) : aMin;
+}
+
+gfxShapedWordStore::gfxShapedWordStore() : mWriting(false), mPendingCount(0) {}
+
+gfxShapedWordStore::~gfxShapedWordStore() {
+  if (mWriteTimer) {
+    mWriteTimer->Cancel();
+  }
+  if (mFlushTimer) {
+    mFlushTimer->Cancel();
+  }
+}
+
+/* static */
+void gfxShapedWordStore::Shutdown() {
+  sStore = nullptr;
+  sShutdown = true;
+}
+
+/* static */
+gfxShapedWordStore* gfxShapedWordStore::Get() {
+  if (!StaticPrefs::gfx_font_rendering_shaped_word_store_enabled_AtStartup() ||
+      !NS_IsMainThread()) {
+    return nullptr;
+  }
+  if (!sStore && !sShutdown && XRE_IsParentProcess()) {
+    UniquePtr<gfxShapedWordStore> store(new gfxShapedWordStore());
+    // Until there is a profile, try again next time.
+    if (!store->InitParent()) {
+      return nullptr;
+    }
+    sStore = store.release();
+    RunOnShutdown(&gfxShapedWordStore::Shutdown);
+  }
+  return sStore;
+}
+
+bool gfxShapedWordStore::InitParent() {
+  nsCOMPtr<nsIFile> file;
+  if (NS_FAILED(NS_GetSpecialDirectory(NS_APP_USER_PROFILE_LOCAL_50_DIR,
+                                       getter_AddRefs(file))) ||
+      NS_FAILED(file->AppendNative("shapedwords.bin"_ns))) {
+    return false;
+  }
+  mFile = std::move(file);
+
+  // A missing or stale file just means starting with no words.
+  if (mMap.init(mFile).isErr()) {
+    return true;
+  }
+  auto data = mMap.get<uint8_t>();
+  FileHeader header;
+  if (mMap.size() < sizeof(header)) {
+    mMap.reset();
+    return true;
+  }
+  memcpy(&header, data.get(), sizeof(header));
+  if (header.mMagic != kMagic || header.mVersion != kVersion ||
+      header.mBuildID != BuildID()) {
+    LOG("Dropping stale shaped word file");
+    mMap.reset();
+    return true;
+  }
+  mRecords.AppendElements(data.get() + sizeof(header),
+                          mMap.size() - sizeof(header));
+  IndexRecords(0);
+  LOG("Loaded %u shaped words", mIndex.Count());
+  return true;
+}
+
+/* static */
+void gfxShapedWordStore::InitChild(const FileDescriptor& aFile,
+                                   uint32_t aSize) {
+  MOZ_ASSERT(XRE_IsContentProcess());
+  if (!StaticPrefs::gfx_font_rendering_shaped_word_store_enabled_AtStartup() ||
+      sStore) {
+    return;
+  }
+
+  // Even without a file, the words shaped here still go to the parent.
+  UniquePtr<gfxShapedWordStore> store(new gfxShapedWordStore());
+  if (aFile.IsValid() && aSize > sizeof(FileHeader) &&
+      store->mMap.init(aFile, PR_PROT_READONLY, aSize).isOk()) {
+    store->IndexRecords(0);
+  }
+  sStore = store.release();
+  RunOnShutdown(&gfxShapedWordStore::Shutdown);
+}
+
+void gfxShapedWordStore::GetFileForChild(FileDescriptor* aFile,
+                                         uint32_t* aSize) {
+  MOZ_ASSERT(XRE_IsParentProcess());
+  if (mMap.initialized()) {
+    *aFile = mMap.cloneFileDescriptor();
+    *aSize = mMap.size();
+  }
+}
+
+Span<const uint8_t> gfxShapedWordStore::Data() const {
+  if (XRE_IsParentProcess()) {
+    return Span(mRecords.Elements(), mRecords.Length());
+  }
+  if (!mMap.initialized()) {
+    return Span<const uint8_t>();
+  }
+  return Span(mMap.get<uint8_t>().get() + sizeof(FileHeader),
+              mMap.size() - sizeof(FileHeader));
+}
+
+void gfxShapedWordStore::IndexRecords(size_t aStart) {
+  Span<const uint8_t> data = Data();
+  uint32_t charLimit = gfxPlatform::GetPlatform()->WordCacheCharLimit();
+  size_t offset = aStart;
+  while (offset + sizeof(RecordHeader) <= data.Length()) {
+    RecordHeader header;
+    memcpy(&header, data.Elements() + offset, sizeof(header));
+    size_t size = RecordSize(header.mLanguageLength, header.mLength);
+    if (!header.mLength || header.mLength > charLimit || header.mScript < 0 ||
+        header.mScript >= int16_t(unicode::Script::NUM_SCRIPT_CODES) ||
+        size > data.Length() - offset) {
+      break;
+    }
+    mIndex.LookupOrInsert(IndexKey(header.mFontKey, header.mWordHash),
+                          uint32_t(offset));
+    offset += size;
+  }
+  if (offset != data.Length()) {
+    NS_WARNING("Truncated or corrupt shaped word store");
+    if (XRE_IsParentProcess()) {
+      mRecords.TruncateLength(offset);
+    }
+  }
+}
+
+/* static */
+uint64_t gfxShapedWordStore::FontKey(gfxFont* aFont) {
+  gfxFontEntry* fe = aFont->GetFontEntry();
+  const gfxFontStyle* style = aFont->GetStyle();
+  if (fe->IsUserFont() || !style->featureSettings.IsEmpty() ||
+      !style->variationSettings.IsEmpty() ||
+      !style->variantAlternates.IsEmpty() || style->sizeAdjust >= 0.0f ||
+      style->baselineOffset != 0.0f || style->languageOverride ||
+      style->variantCaps != NS_FONT_VARIANT_CAPS_NORMAL ||
+      style->variantSubSuper != NS_FONT_VARIANT_POSITION_NORMAL ||
+      style->printerFont || style->style.IsOblique()) {
+    return 0;
+  }
+  SlantStyleRange slant = fe->SlantStyle();
+  if (slant.Min() != slant.Max() || slant.Min().IsOblique()) {
+    return 0;
+  }
+
+  uint32_t revision = 0;
+  uint32_t checksum = 0;
+  {
+    gfxFontEntry::AutoTable headTable(fe, TRUETYPE_TAG('h', 'e', 'a', 'd'));
+    if (!headTable) {
+      return 0;
+    }
+    uint32_t len;
+    const HeadTable* head =
+        reinterpret_cast<const HeadTable*>(hb_blob_get_data(headTable, &len));
+    if (len < sizeof(HeadTable)) {
+      return 0;
+    }
+    revision = head->fontRevision;
+    checksum = head->checkSumAdjustment;
+  }
+
+  uint32_t nameHash = HashString(fe->Name().get(), fe->Name().Length());
+  uint32_t styleHash = HashGeneric(
+      revision, checksum, BitwiseCast<uint32_t>(fe->Weight().Min().ToFloat()),
+      BitwiseCast<uint32_t>(fe->Weight().Max().ToFloat()),
+      BitwiseCast<uint32_t>(fe->Stretch().Min().Percentage()),
+      BitwiseCast<uint32_t>(fe->Stretch().Max().Percentage()),
+      slant.Min().IsItalic());
+  styleHash = AddToHash(
+      styleHash, BitwiseCast<uint64_t>(style->size),
+      BitwiseCast<uint32_t>(style->weight.ToFloat()),
+      BitwiseCast<uint32_t>(style->stretch.Percentage()),
+      style->style.IsItalic(), BitwiseCast<uint32_t>(style->autoOpticalSize));
+  styleHash = AddToHash(styleHash, style->allowSyntheticWeight,
+                        style->allowSyntheticStyle, style->systemFont);
+
+  uint64_t key = (uint64_t(nameHash) << 32) | styleHash;
+  return key ? key : 1;
+}
+
+template <typename T>
+gfxShapedWord* gfxShapedWordStore::Lookup(
+    gfxFont* aFont, const T* aText, uint32_t aLength, Script aRunScript,
+    nsAtom* aLanguage, int32_t aAppUnitsPerDevUnit, ShapedTextFlags aFlags,
+    RoundingFlags aRounding) {
+  if (mIndex.IsEmpty()) {
+    return nullptr;
+  }
+  uint64_t fontKey = aFont->ShapedWordStoreKey();
+  if (!fontKey) {
+    return nullptr;
+  }
+  uint32_t hash = WordHash(aText, aLength, aRunScript, aAppUnitsPerDevUnit,
+                           aFlags, aRounding);
+  auto offset = mIndex.Lookup(IndexKey(fontKey, hash));
+  if (!offset) {
+    return nullptr;
+  }
+
+  const uint8_t* record = Data().Elements() + *offset;
+  RecordHeader header;
+  memcpy(&header, record, sizeof(header));
+  if (header.mFontKey != fontKey || header.mWordHash != hash ||
+      header.mLength != aLength || header.mFlags != uint16_t(aFlags) ||
+      header.mAppUnitsPerDevUnit != aAppUnitsPerDevUnit ||
+      header.mScript != int16_t(aRunScript) ||
+      header.mRounding != uint8_t(aRounding)) {
+    return nullptr;
+  }
+
+  const char* language = reinterpret_cast<const char*>(record + sizeof(header));
+  nsAutoCString wanted;
+  if (aLanguage) {
+    aLanguage->ToUTF8String(wanted);
+  }
+  if (!wanted.Equals(
+          nsDependentCSubstring(language, header.mLanguageLength))) {
+    return nullptr;
+  }
+
+  const uint8_t* text = record + sizeof(header) + header.mLanguageLength;
+  for (uint32_t i = 0; i < aLength; i++) {
+    char16_t ch;
+    memcpy(&ch, text + i * sizeof(char16_t), sizeof(ch));
+    if (ch != char16_t(aText[i])) {
+      return nullptr;
+    }
+  }
+
+  gfxShapedWord* sw =
+      gfxShapedWord::Create(aText, aLength, aRunScript, aLanguage,
+                            aAppUnitsPerDevUnit, aFlags, aRounding);
+  if (!sw) {
+    return nullptr;
+  }
+  memcpy(sw->GetCharacterGlyphs(),
+         record + GlyphsOffset(header.mLanguageLength, aLength),
+         aLength * sizeof(gfxShapedText::CompressedGlyph));
+  return sw;
+}
+
+template gfxShapedWord* gfxShapedWordStore::Lookup(
+    gfxFont* aFont, const uint8_t* aText, uint32_t aLength, Script aRunScript,
+    nsAtom* aLanguage, int32_t aAppUnitsPerDevUnit, ShapedTextFlags aFlags,
+    RoundingFlags aRounding);
+template gfxShapedWord* gfxShapedWordStore::Lookup(
+    gfxFont* aFont, const char16_t* aText, uint32_t aLength, Script aRunScript,
+    nsAtom* aLanguage, int32_t aAppUnitsPerDevUnit, ShapedTextFlags aFlags,
+    RoundingFlags aRounding);
+
+void gfxShapedWordStore::WordShaped(gfxFont* aFont,
+                                    const gfxShapedWord* aWord) {
+  uint64_t fontKey = aFont->ShapedWordStoreKey();
+  if (!fontKey || aWord->GetLength() > UINT16_MAX) {
+    return;
+  }
+  // Glyphs with offsets or unusual advances live in the detailed glyph
+  // store, which isn't worth keeping for UI text.
+  const gfxShapedText::CompressedGlyph* glyphs = aWord->GetCharacterGlyphs();
+  for (uint32_t i = 0; i < aWord->GetLength(); i++) {
+    if (!glyphs[i].IsSimpleGlyph() && glyphs[i].GetGlyphCount()) {
+      return;
+    }
+  }
+
+  if (XRE_IsParentProcess()) {
+    AppendRecord(fontKey, aWord);
+  } else {
+    QueueWord(aFont, fontKey, aWord);
+  }
+}
+
+static void GetWordText(const gfxShapedWord* aWord, nsAString& aText) {
+  if (aWord->TextIs8Bit()) {
+    AppendASCIItoUTF16(
+        nsDependentCSubstring(reinterpret_cast<const char*>(aWord->Text8Bit()),
+                              aWord->GetLength()),
+        aText);
+  } else {
+    aText.Assign(aWord->TextUnicode(), aWord->GetLength());
+  }
+}
+
+void gfxShapedWordStore::AppendRecord(uint64_t aFontKey,
+                                      const gfxShapedWord* aWord) {
+  MOZ_ASSERT(XRE_IsParentProcess());
+
+  nsAutoCString language;
+  if (aWord->GetLanguage()) {
+    aWord->GetLanguage()->ToUTF8String(language);
+  }
+  if (language.Length() > UINT8_MAX) {
+    return;
+  }
+
+  uint32_t length = aWord->GetLength();
+  size_t size = RecordSize(language.Length(), length);
+  if (mRecords.Length() + size >
+      StaticPrefs::gfx_font_rendering_shaped_word_store_max_kb() * 1024) {
+    return;
+  }
+
+  nsAutoString text;
+  GetWordText(aWord, text);
+  RecordHeader header;
+  header.mFontKey = aFontKey;
+  header.mWordHash =
+      WordHash(text.get(), length, aWord->GetScript(),
+               aWord->GetAppUnitsPerDevUnit(), aWord->GetFlags(),
+               aWord->GetRounding());
+  header.mLength = uint16_t(length);
+  header.mFlags = uint16_t(aWord->GetFlags());
+  header.mAppUnitsPerDevUnit = uint16_t(aWord->GetAppUnitsPerDevUnit());
+  header.mScript = int16_t(aWord->GetScript());
+  header.mRounding = uint8_t(aWord->GetRounding());
+  header.mLanguageLength = uint8_t(language.Length());
+  header.mPadding = 0;
+
+  uint32_t offset = mRecords.Length();
+  if (!mIndex.WithEntryHandle(IndexKey(aFontKey, header.mWordHash),
+                              [&](auto&& entry) {
+                                if (entry) {
+                                  return false;
+                                }
+                                entry.Insert(offset);
+                                return true;
+                              })) {
+    return;
+  }
+
+  uint8_t* record = mRecords.AppendElements(size);
+  memset(record, 0, size);
+  memcpy(record, &header, sizeof(header));
+  memcpy(record + sizeof(header), language.get(), language.Length());
+  memcpy(record + sizeof(header) + language.Length(), text.get(),
+         length * sizeof(char16_t));
+  memcpy(record + GlyphsOffset(language.Length(), length),
+         aWord->GetCharacterGlyphs(),
+         length * sizeof(gfxShapedText::CompressedGlyph));
+
+  if (!mWriteTimer) {
+    NS_NewTimerWithFuncCallback(getter_AddRefs(mWriteTimer),
+                                WriteTimerCallback, this, kWriteDelayMS,
+                                nsITimer::TYPE_ONE_SHOT,
+                                "gfxShapedWordStore::WriteTimerCallback");
+  }
+}
+
+void gfxShapedWordStore::QueueWord(gfxFont* aFont, uint64_t aFontKey,
+                                   const gfxShapedWord* aWord) {
+  if (mPendingCount >= kMaxPendingWords) {
+    return;
+  }
+
+  PendingFont* pending =
+      mPending
+          .LookupOrInsertWith(
+              aFontKey,
+              [&] {
+                auto pending = MakeUnique<PendingFont>();
+                gfxFontEntry* fe = aFont->GetFontEntry();
+                const gfxFontStyle* style = aFont->GetStyle();
+                ShapedWordFont& font = pending->mFont;
+                font.name() = fe->Name();
+                font.minWeight() = fe->Weight().Min().ToFloat();
+                font.maxWeight() = fe->Weight().Max().ToFloat();
+                font.minStretch() = fe->Stretch().Min().Percentage();
+                font.maxStretch() = fe->Stretch().Max().Percentage();
+                font.italicFace() = fe->SlantStyle().Min().IsItalic();
+                font.size() = style->size;
+                font.weight() = style->weight.ToFloat();
+                font.stretch() = style->stretch.Percentage();
+                font.italic() = style->style.IsItalic();
+                font.autoOpticalSize() = style->autoOpticalSize;
+                font.allowSyntheticWeight() = style->allowSyntheticWeight;
+                font.allowSyntheticStyle() = style->allowSyntheticStyle;
+                font.systemFont() = style->systemFont;
+                return pending;
+              })
+          .get();
+
+  ShapedWordText* word = pending->mWords.AppendElement();
+  GetWordText(aWord, word->text());
+  word->script() = int16_t(aWord->GetScript());
+  if (aWord->GetLanguage()) {
+    aWord->GetLanguage()->ToUTF8String(word->language());
+  }
+  word->appUnitsPerDevUnit() = uint16_t(aWord->GetAppUnitsPerDevUnit());
+  word->flags() = uint16_t(aWord->GetFlags());
+  word->rounding() = uint8_t(aWord->GetRounding());
+  mPendingCount++;
+
+  if (!mFlushTimer) {
+    NS_NewTimerWithFuncCallback(getter_AddRefs(mFlushTimer),
+                                FlushTimerCallback, this, kFlushDelayMS,
+                                nsITimer::TYPE_ONE_SHOT,
+                                "gfxShapedWordStore::FlushTimerCallback");
+  }
+}
+
+/* static */
+void gfxShapedWordStore::FlushTimerCallback(nsITimer* aTimer, void* aStore) {
+  static_cast<gfxShapedWordStore*>(aStore)->SendPendingWords();
+}
+
+void gfxShapedWordStore::SendPendingWords() {
+  mFlushTimer = nullptr;
+  if (dom::ContentChild* cc = dom::ContentChild::GetSingleton()) {
+    for (const auto& entry : mPending) {
+      Unused << cc->SendShapeWordsForStore(entry.GetData()->mFont,
+                                           entry.GetData()->mWords);
+    }
+  }
+  LOG("Sent %u shaped words to the parent", mPendingCount);
+  mPending.Clear();
+  mPendingCount = 0;
+}
+
+void gfxShapedWordStore::ShapeWordsForChild(
+    const ShapedWordFont& aFont, const nsTArray<ShapedWordText>& aWords) {
+  MOZ_ASSERT(XRE_IsParentProcess());
+  if (aWords.Length() > kMaxPendingWords) {
+    return;
+  }
+
+  SlantStyleRange slant(aFont.italicFace() ? FontSlantStyle::Italic()
+                                           : FontSlantStyle::Normal());
+  RefPtr<gfxFontEntry> fe =
+      gfxPlatformFontList::PlatformFontList()->LookupLocalFont(
+          aFont.name(),
+          WeightRange(FontWeight(ClampFloat(aFont.minWeight(), 1, 1000)),
+                      FontWeight(ClampFloat(aFont.maxWeight(), 1, 1000))),
+          StretchRange(FontStretch(ClampFloat(aFont.minStretch(), 0, 1000)),
+                       FontStretch(ClampFloat(aFont.maxStretch(), 0, 1000))),
+          slant);
+  if (!fe) {
+    LOG("No font %s to shape words with", aFont.name().get());
+    return;
+  }
+
+  gfxFontStyle style;
+  style.size = aFont.size() >= 1.0 ? std::min<gfxFloat>(aFont.size(),
+                                                        FONT_MAX_SIZE)
+                                   : 1.0;
+  style.weight = FontWeight(ClampFloat(aFont.weight(), 1, 1000));
+  style.stretch = FontStretch(ClampFloat(aFont.stretch(), 0, 1000));
+  style.style =
+      aFont.italic() ? FontSlantStyle::Italic() : FontSlantStyle::Normal();
+  style.autoOpticalSize = aFont.autoOpticalSize() >= 0.0f
+                              ? ClampFloat(aFont.autoOpticalSize(), 0,
+                                           FONT_MAX_SIZE)
+                              : -1.0f;
+  style.allowSyntheticWeight = aFont.allowSyntheticWeight();
+  style.allowSyntheticStyle = aFont.allowSyntheticStyle();
+  style.systemFont = aFont.systemFont();
+
+  RefPtr<gfxFont> font = fe->FindOrMakeFont(&style);
+  if (!font || !font->ShapedWordStoreKey()) {
+    return;
+  }
+  font->InitWordCache();
+
+  RefPtr<gfx::DrawTarget> dt =
+      gfxPlatform::GetPlatform()->ScreenReferenceDrawTarget();
+  uint32_t charLimit = gfxPlatform::GetPlatform()->WordCacheCharLimit();
+  const auto kVertical = ShapedTextFlags::TEXT_ORIENT_MASK;
+  for (const ShapedWordText& word : aWords) {
+    uint32_t length = word.text().Length();
+    auto flags = ShapedTextFlags(word.flags());
+    if (!length || length > charLimit || word.script() < 0 ||
+        word.script() >= int16_t(Script::NUM_SCRIPT_CODES) ||
+        !word.appUnitsPerDevUnit() ||
+        word.rounding() > 3 ||
+        (flags & kVertical) != ShapedTextFlags::TEXT_ORIENT_HORIZONTAL) {
+      continue;
+    }
+    const char16_t* text = word.text().get();
+    if ((flags & ShapedTextFlags::TEXT_IS_8BIT) &&
+        !IsUtf16Latin1(Span(text, length))) {
+      continue;
+    }
+
+    uint32_t hash = 0;
+    for (uint32_t i = 0; i < length; i++) {
+      hash = gfxShapedWord::HashMix(hash, text[i]);
+    }
+    RefPtr<nsAtom> language =
+        word.language().IsEmpty() ? nullptr : NS_Atomize(word.language());
+    // This shapes the word, unless the parent happens to know it already,
+    // and adds it here through WordShaped().
+    font->GetShapedWord(dt, text, length, hash, Script(word.script()),
+                        language, false, word.appUnitsPerDevUnit(), flags,
+                        RoundingFlags(word.rounding()), nullptr);
+  }
+}
+
+/* static */
+void gfxShapedWordStore::WriteTimerCallback(nsITimer* aTimer, void* aStore) {
+  auto* store = static_cast<gfxShapedWordStore*>(aStore);
+  store->mWriteTimer = nullptr;
+  store->Write();
+}
+
+static nsresult WriteFile(nsIFile* aFile, const nsTArray<uint8_t>& aData) {
+  nsCOMPtr<nsIFile> tmp;
+  nsresult rv = aFile->Clone(getter_AddRefs(tmp));
+  NS_ENSURE_SUCCESS(rv, rv);
+  rv = tmp->SetLeafName(u"shapedwords.tmp"_ns);
+  NS_ENSURE_SUCCESS(rv, rv);
+
+  PRFileDesc* fd;
+  rv = tmp->OpenNSPRFileDesc(PR_WRONLY | PR_CREATE_FILE | PR_TRUNCATE, 0644,
+                             &fd);
+  NS_ENSURE_SUCCESS(rv, rv);
+  int32_t written = PR_Write(fd, aData.Elements(), aData.Length());
+  PR_Close(fd);
+  if (written != int32_t(aData.Length())) {
+    tmp->Remove(false);
+    return NS_ERROR_FAILURE;
+  }
+  // Processes that have the old file mapped keep it; new ones get this.
+  return tmp->MoveTo(nullptr, u"shapedwords.bin"_ns);
+}
+
+void gfxShapedWordStore::Write() {
+  if (mWriting) {
+    // Try again once the write in progress is done.
+    NS_NewTimerWithFuncCallback(getter_AddRefs(mWriteTimer),
+                                WriteTimerCallback, this, kWriteDelayMS,
+                                nsITimer::TYPE_ONE_SHOT,
+                                "gfxShapedWordStore::WriteTimerCallback");
+    return;
+  }
+  mWriting = true;
+
+  FileHeader header = {kMagic, kVersion, BuildID(), 0};
+  nsTArray<uint8_t> data(sizeof(header) + mRecords.Length());
+  data.AppendElements(reinterpret_cast<const uint8_t*>(&header),
+                      sizeof(header));
+  data.AppendElements(mRecords);
+  LOG("Writing %u shaped words", mIndex.Count());
+
+  nsCOMPtr<nsIFile> file = mFile;
+  NS_DispatchBackgroundTask(
+      NS_NewRunnableFunction(
+          "gfxShapedWordStore::Write",
+          [file, data = std::move(data)]() {
+            nsresult rv = WriteFile(file, data);
+            NS_DispatchToMainThread(NS_NewRunnableFunction(
+                "gfxShapedWordStore::FileWritten", [rv]() {
+                  if (sStore) {
+                    sStore->mWriting = false;
+                    if (NS_SUCCEEDED(rv)) {
+                      sStore->FileWritten();
+                    }
+                  }
+                }));
+          }),
+      NS_DISPATCH_EVENT_MAY_BLOCK);
+}
+
+void gfxShapedWordStore::FileWritten() {
+  mMap.reset();
+  if (mMap.init(mFile).isErr()) {
+    NS_WARNING("Can't map the shaped word store that was just written");
+  }
+}
@@ -0,0 +1,125 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef GFX_SHAPED_WORD_STORE_H
+#define GFX_SHAPED_WORD_STORE_H
+
+#include "gfxFont.h"
+#include "mozilla/AutoMemMap.h"
+#include "mozilla/Span.h"
+#include "nsCOMPtr.h"
+#include "nsTArray.h"
+#include "nsTHashMap.h"
+
+class nsIFile;
+class nsITimer;
+
+namespace mozilla {
+namespace dom {
+class ShapedWordFont;
+class ShapedWordText;
+}  // namespace dom
+namespace ipc {
+class FileDescriptor;
+}  // namespace ipc
+}  // namespace mozilla
+
+/**
+ * A persistent cache of shaped words, so that the UI strings an app shapes on
+ * every launch are only shaped once. It complements the per-font word caches
+ * of gfxFont: a word that misses there is looked up here before it is shaped.
+ *
+ * The words are kept in shapedwords.bin in the profile, written by the parent
+ * process. Content processes get the file at launch and map it; they can't
+ * write to it, so they send the words they had to shape to the parent, which
+ * shapes them again with its own copy of the font and adds them. That way no
+ * glyph data from a content process ends up in what other processes draw.
+ *
+ * Only words of system fonts in a plain style (no features, variations, size
+ * adjustment or synthetic sub/superscript) whose glyphs are all simple are
+ * kept. Fonts are identified by their face name, descriptors, 'head' table
+ * revision and checksum and style, so an updated font doesn't match old
+ * words. The file is dropped when the build changes, in case the shaping
+ * code did.
+ *
+ * Main thread only.
+ */
+class gfxShapedWordStore final {
+  typedef mozilla::gfx::DrawTarget DrawTarget;
+  typedef mozilla::gfx::ShapedTextFlags ShapedTextFlags;
+  typedef mozilla::unicode::Script Script;
+  typedef gfxFontShaper::RoundingFlags RoundingFlags;
+
+ public:
+  // Returns null if the store is disabled, or not ready yet.
+  static gfxShapedWordStore* Get();
+
+  // Content processes: maps the file the parent sent at launch.
+  static void InitChild(const mozilla::ipc::FileDescriptor& aFile,
+                        uint32_t aSize);
+
+  // Parent process: the file to send to a new content process, if any.
+  void GetFileForChild(mozilla::ipc::FileDescriptor* aFile, uint32_t* aSize);
+
+  // Returns a new word with the glyphs of a stored one, or null.
+  template <typename T>
+  gfxShapedWord* Lookup(gfxFont* aFont, const T* aText, uint32_t aLength,
+                        Script aRunScript, nsAtom* aLanguage,
+                        int32_t aAppUnitsPerDevUnit, ShapedTextFlags aFlags,
+                        RoundingFlags aRounding);
+
+  // Called for every word gfxFont had to shape. The parent adds it, content
+  // processes queue it to be sent to the parent.
+  void WordShaped(gfxFont* aFont, const gfxShapedWord* aWord);
+
+  // Parent process: shapes the words a content process sent.
+  void ShapeWordsForChild(const mozilla::dom::ShapedWordFont& aFont,
+                          const nsTArray<mozilla::dom::ShapedWordText>& aWords);
+
+  // The key identifying aFont in the store, or 0 if its words aren't kept.
+  static uint64_t FontKey(gfxFont* aFont);
+
+ private:
+  struct RecordHeader;
+  struct PendingFont;
+
+  gfxShapedWordStore();
+  ~gfxShapedWordStore();
+
+  static void Shutdown();
+
+  bool InitParent();
+  mozilla::Span<const uint8_t> Data() const;
+  void IndexRecords(size_t aStart);
+  void AppendRecord(uint64_t aFontKey, const gfxShapedWord* aWord);
+  void QueueWord(gfxFont* aFont, uint64_t aFontKey,
+                 const gfxShapedWord* aWord);
+
+  static void FlushTimerCallback(nsITimer* aTimer, void* aStore);
+  void SendPendingWords();
+  static void WriteTimerCallback(nsITimer* aTimer, void* aStore);
+  void Write();
+  void FileWritten();
+
+  // The records, after a header. A content process maps the file; the
+  // parent reads it into mRecords and appends to that.
+  mozilla::loader::AutoMemMap mMap;
+  nsTArray<uint8_t> mRecords;
+  // Offsets of the records, by font key and word hash.
+  nsTHashMap<nsUint64HashKey, uint32_t> mIndex;
+
+  // Parent: the file and a mapping of its last written version, which is
+  // what new content processes get.
+  nsCOMPtr<nsIFile> mFile;
+  nsCOMPtr<nsITimer> mWriteTimer;
+  bool mWriting;
+
+  // Content: the words to send to the parent, by font key.
+  nsTHashMap<nsUint64HashKey, mozilla::UniquePtr<PendingFont>> mPending;
+  uint32_t mPendingCount;
+  nsCOMPtr<nsITimer> mFlushTimer;
+};
+
+#endif /* GFX_SHAPED_WORD_STORE_H */
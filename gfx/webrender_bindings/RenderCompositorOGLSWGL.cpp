@@ -66,7 +66,7 @@ UniquePtr<RenderCompositor> RenderCompositorOGLSWGL::Create(
     return nullptr;
   }
   compositor = compositorOGL;
-#elif defined(MOZ_WIDGET_GTK)
+#elif defined(MOZ_WIDGET_GTK) || defined(MOZ_WIDGET_GONK)
   nsCString log;
   RefPtr<CompositorOGL> compositorOGL;
   compositorOGL = new CompositorOGL(nullptr, aWidget);
@@ -201,7 +201,7 @@ bool RenderCompositorOGLSWGL::RequestFullRender() { return mFullRender; }
 void RenderCompositorOGLSWGL::Pause() {
 #ifdef MOZ_WIDGET_ANDROID
   DestroyEGLSurface();
-#elif defined(MOZ_WIDGET_GTK)
+#elif defined(MOZ_WIDGET_GTK) || defined(MOZ_WIDGET_GONK)
   mCompositor->Pause();
 #endif
 }
@@ -243,7 +243,7 @@ bool RenderCompositorOGLSWGL::Resume() {
   mEGLSurfaceSize = Some(LayoutDeviceIntSize(width, height));
   ANativeWindow_release(nativeWindow);
   mCompositor->SetDestinationSurfaceSize(gfx::IntSize(width, height));
-#elif defined(MOZ_WIDGET_GTK)
+#elif defined(MOZ_WIDGET_GTK) || defined(MOZ_WIDGET_GONK)
   bool resumed = mCompositor->Resume();
   if (!resumed) {
     RenderThread::Get()->HandleWebRenderError(WebRenderError::NEW_SURFACE);
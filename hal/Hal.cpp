@@ -736,6 +736,21 @@ void SetProcessPriority(int aPid, ProcessPriority aPriority) {
   PROXY_IF_SANDBOXED(SetProcessPriority(aPid, aPriority));
 }
 
+void BoostForegroundProcesses(uint32_t aDurationMs) {
+  // n.b. The sandboxed implementation crashes, like SetProcessPriority.
+  PROXY_IF_SANDBOXED(BoostForegroundProcesses(aDurationMs));
+}
+
+void NotifyPerformanceHint(PerformanceHint aHint, uint32_t aDurationMs) {
+  // n.b. The sandboxed implementation crashes, like SetProcessPriority.
+  PROXY_IF_SANDBOXED(NotifyPerformanceHint(aHint, aDurationMs));
+}
+
+void PageOutProcess(int aPid) {
+  // n.b. The sandboxed implementation crashes, like SetProcessPriority.
+  PROXY_IF_SANDBOXED(PageOutProcess(aPid));
+}
+
 uint32_t GetTotalSystemMemory() { return hal_impl::GetTotalSystemMemory(); }
 
 // From HalTypes.h.
@@ -489,6 +489,35 @@ void NotifyAlarmFired();
  */
 void SetProcessPriority(int aPid, hal::ProcessPriority aPriority);
 
+/**
+ * Give the foreground processes more CPU for the next aDurationMs
+ * milliseconds, e.g. while an app launches or responds to a touch. Calling
+ * this again before the boost is over extends it if needed.
+ *
+ * Platforms without a way to favor processes ignore this call.
+ */
+void BoostForegroundProcesses(uint32_t aDurationMs);
+
+/**
+ * Tell the platform that the user will be waiting on the CPU for the next
+ * aDurationMs milliseconds, so that it raises the CPU frequency right away
+ * rather than when its governor notices the load. Hints may be sent from any
+ * thread and as often as needed; repeating a hint extends it.
+ *
+ * Platforms without performance hints ignore this call.
+ */
+void NotifyPerformanceHint(hal::PerformanceHint aHint, uint32_t aDurationMs);
+
+/**
+ * Move the anonymous memory of the process aPid out to swap, e.g. once it has
+ * stayed in the background for a while, so that it gets compressed in zram
+ * instead of the whole process being killed when memory runs out. The work
+ * is done off the calling thread.
+ *
+ * Platforms without swap, or without a way to ask for it, ignore this call.
+ */
+void PageOutProcess(int aPid);
+
 /**
  * Get total system memory of device being run on in bytes.
  *
@@ -28,6 +28,9 @@ enum SensorType {
   SENSOR_ROTATION_VECTOR = 6,
   SENSOR_GAME_ROTATION_VECTOR = 7,
   SENSOR_PRESSURE = 8,
+  // The rotation the screen should take, as a single nsIScreen::ROTATION_*
+  // value, reported only when it changes. Only implemented on gonk.
+  SENSOR_SCREEN_ROTATION = 9,
   NUM_SENSOR_TYPE
 };
 
@@ -71,6 +71,20 @@ enum ProcessPriority {
  */
 const char* ProcessPriorityToString(ProcessPriority aPriority);
 
+/**
+ * What the user is waiting for, see NotifyPerformanceHint.
+ */
+enum PerformanceHint {
+  // The user is touching the screen, or what they are looking at is missing
+  // frames.
+  PERFORMANCE_HINT_INTERACTION,
+  // An app is starting or coming to the foreground.
+  PERFORMANCE_HINT_APP_LAUNCH,
+  // A video is playing.
+  PERFORMANCE_HINT_VIDEO_PLAYBACK,
+  NUM_PERFORMANCE_HINT
+};
+
 /**
  * Used by ModifyWakeLock
  */
@@ -8,13 +8,21 @@
 #include "base/process_util.h"
 #include "mozilla/HalWakeLock.h"
 #include "mozilla/Services.h"
+#include "mozilla/StaticPrefs_dom.h"
 #include "mozilla/StaticPtr.h"
+#include "mozilla/TimeStamp.h"
 #include "nsClassHashtable.h"
 #include "nsTHashMap.h"
+#include "nsTHashSet.h"
 #include "nsHashKeys.h"
+#include "nsIMemoryReporter.h"
 #include "nsIPropertyBag2.h"
 #include "nsIObserver.h"
 #include "nsIObserverService.h"
+#include "nsITimer.h"
+#include "nsPrintfCString.h"
+#include "nsThreadUtils.h"
+#include "nsXULAppAPI.h"
 
 using namespace mozilla;
 using namespace mozilla::hal;
@@ -31,8 +39,34 @@ struct LockCount {
 typedef nsTHashMap<nsUint64HashKey, LockCount> ProcessLockTable;
 typedef nsClassHashtable<nsStringHashKey, ProcessLockTable> LockTable;
 
+// What listeners were last told about a topic.
+struct NotifiedState {
+  WakeLockState state;
+  CopyableTArray<uint64_t> processes;
+};
+
+typedef nsTHashMap<nsStringHashKey, NotifiedState> NotifiedTable;
+
+// How much each process has used each topic, for finding out who keeps the
+// device awake.
+struct LockUsage {
+  LockUsage() : acquireCount(0) {}
+  uint32_t acquireCount;
+  TimeDuration heldTime;
+  TimeStamp heldSince;
+};
+
+typedef nsTHashMap<nsUint64HashKey, LockUsage> ProcessUsageTable;
+typedef nsClassHashtable<nsStringHashKey, ProcessUsageTable> UsageTable;
+
 int sActiveListeners = 0;
 StaticAutoPtr<LockTable> sLockTable;
+StaticAutoPtr<NotifiedTable> sNotifiedTable;
+StaticAutoPtr<UsageTable> sUsageTable;
+StaticAutoPtr<nsTHashSet<nsString>> sPendingTopics;
+StaticRefPtr<nsITimer> sCpuReleaseTimer;
+bool sCpuReleaseDue = false;
+bool sFlushScheduled = false;
 bool sIsShuttingDown = false;
 
 WakeLockInformation WakeLockInfoFromLockCount(const nsAString& aTopic,
@@ -59,6 +93,159 @@ static void CountWakeLocks(ProcessLockTable* aTable, LockCount* aTotalCount) {
   }
 }
 
+static void UpdateUsage(const nsAString& aTopic, uint64_t aProcessID,
+                        bool aWasLocked, bool aIsLocked, bool aAcquired) {
+  if (!aAcquired && aWasLocked == aIsLocked) {
+    return;
+  }
+
+  LockUsage& usage =
+      sUsageTable->GetOrInsertNew(aTopic)->LookupOrInsert(aProcessID);
+  if (aAcquired) {
+    usage.acquireCount++;
+  }
+  if (!aWasLocked && aIsLocked) {
+    usage.heldSince = TimeStamp::Now();
+  } else if (aWasLocked && !aIsLocked && !usage.heldSince.IsNull()) {
+    usage.heldTime += TimeStamp::Now() - usage.heldSince;
+    usage.heldSince = TimeStamp();
+  }
+}
+
+static void FlushWakeLockNotifications();
+
+static void CpuReleaseTimerFired(nsITimer* aTimer, void* aClosure) {
+  sCpuReleaseTimer = nullptr;
+  if (sIsShuttingDown) {
+    return;
+  }
+  sCpuReleaseDue = true;
+  sPendingTopics->Insert(u"cpu"_ns);
+  FlushWakeLockNotifications();
+}
+
+// Tells listeners about every topic that changed since the last flush.
+// A lock that is taken and dropped again within one turn of the event loop
+// doesn't generate any notification at all.
+static void FlushWakeLockNotifications() {
+  sFlushScheduled = false;
+  if (sIsShuttingDown) {
+    return;
+  }
+
+  nsTHashSet<nsString> topics = std::move(*sPendingTopics);
+  for (const nsString& topic : topics) {
+    WakeLockInformation info;
+    hal::GetWakeLockInfo(topic, &info);
+    WakeLockState state = ComputeWakeLockState(info.numLocks(),
+                                               info.numHidden());
+
+    bool isCpu = topic.EqualsLiteral("cpu");
+    bool releaseDue = isCpu && sCpuReleaseDue;
+    if (isCpu) {
+      sCpuReleaseDue = false;
+      if (sCpuReleaseTimer && state != WAKE_LOCK_STATE_UNLOCKED) {
+        // Taken again before the release went out; listeners never see it.
+        sCpuReleaseTimer->Cancel();
+        sCpuReleaseTimer = nullptr;
+      }
+    }
+
+    NotifiedState* notified = sNotifiedTable->Lookup(topic).DataPtrOrNull();
+    WakeLockState oldState =
+        notified ? notified->state : WAKE_LOCK_STATE_UNLOCKED;
+    if (state == oldState &&
+        (notified ? notified->processes == info.lockingProcesses()
+                  : info.lockingProcesses().IsEmpty())) {
+      continue;
+    }
+
+    if (isCpu && state == WAKE_LOCK_STATE_UNLOCKED && !releaseDue) {
+      // Hold off on telling whoever drives the kernel wake lock, so that a
+      // lock taken again shortly after doesn't make it flap.
+      uint32_t delay = StaticPrefs::dom_wakelock_cpu_release_delay_ms();
+      if (delay && !sCpuReleaseTimer) {
+        RefPtr<nsITimer> timer;
+        NS_NewTimerWithFuncCallback(
+            getter_AddRefs(timer), CpuReleaseTimerFired, nullptr, delay,
+            nsITimer::TYPE_ONE_SHOT, "hal::CpuReleaseTimerFired");
+        sCpuReleaseTimer = timer;
+      }
+      if (sCpuReleaseTimer) {
+        continue;
+      }
+    }
+
+    if (state == WAKE_LOCK_STATE_UNLOCKED) {
+      sNotifiedTable->Remove(topic);
+    } else {
+      sNotifiedTable->InsertOrUpdate(
+          topic, NotifiedState{state, info.lockingProcesses()});
+    }
+
+    if (sActiveListeners) {
+      NotifyWakeLockChange(info);
+    }
+  }
+}
+
+static void ScheduleWakeLockNotification(const nsAString& aTopic) {
+  sPendingTopics->Insert(aTopic);
+  if (sFlushScheduled) {
+    return;
+  }
+  if (NS_SUCCEEDED(NS_DispatchToCurrentThread(NS_NewRunnableFunction(
+          "hal::FlushWakeLockNotifications", FlushWakeLockNotifications)))) {
+    sFlushScheduled = true;
+  }
+}
+
+class WakeLockReporter final : public nsIMemoryReporter {
+  ~WakeLockReporter() {}
+
+ public:
+  NS_DECL_ISUPPORTS
+
+  NS_IMETHOD CollectReports(nsIHandleReportCallback* aHandleReport,
+                            nsISupports* aData, bool aAnonymize) override {
+    if (!sUsageTable) {
+      return NS_OK;
+    }
+
+    TimeStamp now = TimeStamp::Now();
+    for (auto iter = sUsageTable->ConstIter(); !iter.Done(); iter.Next()) {
+      NS_ConvertUTF16toUTF8 topic(iter.Key());
+      topic.ReplaceChar('/', '\\');
+
+      for (auto procIter = iter.UserData()->ConstIter(); !procIter.Done();
+           procIter.Next()) {
+        const LockUsage& usage = procIter.Data();
+        TimeDuration held = usage.heldTime;
+        if (!usage.heldSince.IsNull()) {
+          held += now - usage.heldSince;
+        }
+
+        nsPrintfCString path("wake-locks/%s/process(%" PRIu64 ")/",
+                             topic.get(), procIter.Key());
+        aHandleReport->Callback(
+            ""_ns, path + "acquired"_ns, KIND_OTHER, UNITS_COUNT_CUMULATIVE,
+            usage.acquireCount,
+            "Number of times the process took a wake lock on this topic."_ns,
+            aData);
+        aHandleReport->Callback(
+            ""_ns, path + "held-ms"_ns, KIND_OTHER, UNITS_COUNT_CUMULATIVE,
+            int64_t(held.ToMilliseconds()),
+            "Milliseconds during which the process held at least one wake "
+            "lock on this topic."_ns,
+            aData);
+      }
+    }
+    return NS_OK;
+  }
+};
+
+NS_IMPL_ISUPPORTS(WakeLockReporter, nsIMemoryReporter)
+
 class ClearHashtableOnShutdown final : public nsIObserver {
   ~ClearHashtableOnShutdown() {}
 
@@ -76,6 +263,13 @@ ClearHashtableOnShutdown::Observe(nsISupports* aSubject, const char* aTopic,
 
   sIsShuttingDown = true;
   sLockTable = nullptr;
+  sNotifiedTable = nullptr;
+  sUsageTable = nullptr;
+  sPendingTopics = nullptr;
+  if (sCpuReleaseTimer) {
+    sCpuReleaseTimer->Cancel();
+    sCpuReleaseTimer = nullptr;
+  }
 
   return NS_OK;
 }
@@ -113,14 +307,12 @@ CleanupOnContentShutdown::Observe(nsISupports* aSubject, const char* aTopic,
 
       if (table->Get(childID, nullptr)) {
         table->Remove(childID);
+        UpdateUsage(iter.Key(), childID, true, false, false);
 
         LockCount totalCount;
         CountWakeLocks(table, &totalCount);
 
-        if (sActiveListeners) {
-          NotifyWakeLockChange(
-              WakeLockInfoFromLockCount(iter.Key(), totalCount));
-        }
+        ScheduleWakeLockNotification(iter.Key());
 
         if (totalCount.numLocks == 0) {
           iter.Remove();
@@ -141,6 +333,13 @@ namespace hal {
 
 void WakeLockInit() {
   sLockTable = new LockTable();
+  sNotifiedTable = new NotifiedTable();
+  sUsageTable = new UsageTable();
+  sPendingTopics = new nsTHashSet<nsString>();
+
+  if (XRE_IsParentProcess()) {
+    RegisterStrongMemoryReporter(new WakeLockReporter());
+  }
 
   nsCOMPtr<nsIObserverService> obs = mozilla::services::GetObserverService();
   if (obs) {
@@ -197,8 +396,6 @@ void ModifyWakeLock(const nsAString& aTopic, hal::WakeLockControl aLockAdjust,
   MOZ_ASSERT(aLockAdjust >= 0 || totalCount.numLocks > 0);
   MOZ_ASSERT(aHiddenAdjust >= 0 || totalCount.numHidden > 0);
 
-  WakeLockState oldState =
-      ComputeWakeLockState(totalCount.numLocks, totalCount.numHidden);
   bool processWasLocked = processCount.numLocks > 0;
 
   processCount.numLocks += aLockAdjust;
@@ -216,14 +413,9 @@ void ModifyWakeLock(const nsAString& aTopic, hal::WakeLockControl aLockAdjust,
     sLockTable->Remove(aTopic);
   }
 
-  if (sActiveListeners &&
-      (oldState !=
-           ComputeWakeLockState(totalCount.numLocks, totalCount.numHidden) ||
-       processWasLocked != (processCount.numLocks > 0))) {
-    WakeLockInformation info;
-    hal::GetWakeLockInfo(aTopic, &info);
-    NotifyWakeLockChange(info);
-  }
+  UpdateUsage(aTopic, aProcessID, processWasLocked, processCount.numLocks > 0,
+              aLockAdjust > 0);
+  ScheduleWakeLockNotification(aTopic);
 }
 
 void GetWakeLockInfo(const nsAString& aTopic,
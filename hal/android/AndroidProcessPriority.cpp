@@ -56,5 +56,17 @@ void SetProcessPriority(int aPid, ProcessPriority aPriority) {
                                                 relativeImportance);
 }
 
+void BoostForegroundProcesses(uint32_t aDurationMs) {
+  // Android schedules the foreground services itself.
+}
+
+void NotifyPerformanceHint(PerformanceHint aHint, uint32_t aDurationMs) {
+  // Android sends the power HAL its own hints for the foreground app.
+}
+
+void PageOutProcess(int aPid) {
+  // Android's own activity manager compacts cached apps.
+}
+
 }  // namespace hal_impl
 }  // namespace mozilla
@@ -15,5 +15,14 @@ void SetProcessPriority(int aPid, ProcessPriority aPriority) {
           ProcessPriorityToString(aPriority));
 }
 
+void BoostForegroundProcesses(uint32_t aDurationMs) {
+  HAL_LOG("FallbackProcessPriority - BoostForegroundProcesses(%u)\n",
+          aDurationMs);
+}
+
+void NotifyPerformanceHint(PerformanceHint aHint, uint32_t aDurationMs) {}
+
+void PageOutProcess(int aPid) {}
+
 }  // namespace hal_impl
 }  // namespace mozilla
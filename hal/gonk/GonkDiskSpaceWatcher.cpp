@@ -3,6 +3,7 @@
  * You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "Hal.h"
+#include <sys/stat.h>
 #include <sys/syscall.h>
 #include <sys/vfs.h>
 #include <fcntl.h>
@@ -86,19 +87,35 @@ class GonkDiskSpaceWatcher final : public MessageLoopForIO::Watcher {
   void DoStop();
 
  private:
+  void MaybeSampleFreeSpace();
+  void SampleFreeSpace();
+  uint16_t ComputeLevel(uint64_t aFreeSpace) const;
+  uint64_t LevelThreshold(uint16_t aLevel) const;
   void NotifyUpdate();
   void NotifyAlmostLowDiskSpace(bool aLowDiskSpace);
+  void NotifyLevel();
 
   uint64_t mLowThreshold;
   uint64_t mHighThreshold;
   uint64_t mWarningThreshold;
+  uint64_t mCriticalThreshold;
   TimeDuration mTimeout;
   TimeStamp mLastTimestamp;
   uint64_t mLastFreeSpace;
   uint32_t mSizeDelta;
 
+  // statfs() is only called once per mSampleInterval. In between, the size of
+  // the files closed after writing is added up in mEstimatedWrites and taken
+  // off the last sample, which forces an early sample when that estimate
+  // would enter a lower level.
+  TimeDuration mSampleInterval;
+  TimeStamp mLastSampleTime;
+  uint64_t mEstimatedWrites;
+  RefPtr<CancelableRunnable> mSampleTask;
+
   bool mIsDiskFull;
   bool mIsBelowWarningThreshold;
+  uint16_t mLevel;
   uint64_t mFreeSpace;
 
   int mFd;
@@ -112,6 +129,8 @@ static GonkDiskSpaceWatcher* gHalDiskSpaceWatcher = nullptr;
 #define WATCHER_PREF_WARNING "disk_space_watcher.warning_threshold"
 #define WATCHER_PREF_TIMEOUT "disk_space_watcher.timeout"
 #define WATCHER_PREF_SIZE_DELTA "disk_space_watcher.size_delta"
+#define WATCHER_PREF_CRITICAL "disk_space_watcher.critical_threshold"
+#define WATCHER_PREF_SAMPLE_INTERVAL "disk_space_watcher.sample_interval_ms"
 
 static const char kWatchedPath[] = "/data";
 
@@ -156,6 +175,21 @@ class AlmostLowDiskSpaceNotifier : public Runnable {
   bool mLowDiskSpace;
 };
 
+class DiskSpaceLevelNotifier : public Runnable {
+ public:
+  explicit DiskSpaceLevelNotifier(const uint16_t aLevel)
+      : mozilla::Runnable("DiskSpaceLevelNotifier"), mLevel(aLevel) {}
+
+  NS_IMETHOD Run() override {
+    MOZ_ASSERT(NS_IsMainThread());
+    DiskSpaceWatcher::UpdateLevel(mLevel);
+    return NS_OK;
+  }
+
+ private:
+  uint16_t mLevel;
+};
+
 // Helper runnable to delete the watcher on the main thread.
 class DiskSpaceCleaner : public Runnable {
  public:
@@ -173,22 +207,29 @@ class DiskSpaceCleaner : public Runnable {
 
 GonkDiskSpaceWatcher::GonkDiskSpaceWatcher()
     : mLastFreeSpace(UINT64_MAX),
+      mEstimatedWrites(0),
       mIsDiskFull(false),
       mIsBelowWarningThreshold(false),
+      mLevel(nsIDiskSpaceWatcher::LEVEL_NORMAL),
       mFreeSpace(UINT64_MAX),
       mFd(-1) {
   MOZ_ASSERT(NS_IsMainThread());
   MOZ_ASSERT(gHalDiskSpaceWatcher == nullptr);
 
   // Default values: 30MB for low threshold, 32MB for high threshold, and
-  // a timeout of 5 seconds.
+  // a timeout of 5 seconds. The gap between the low and high thresholds is
+  // the hysteresis of every level.
   mLowThreshold = Preferences::GetInt(WATCHER_PREF_LOW, 30) * 1024 * 1024;
   mHighThreshold = Preferences::GetInt(WATCHER_PREF_HIGH, 32) * 1024 * 1024;
   mWarningThreshold =
       Preferences::GetInt(WATCHER_PREF_WARNING, 50) * 1024 * 1024;
+  mCriticalThreshold =
+      Preferences::GetInt(WATCHER_PREF_CRITICAL, 10) * 1024 * 1024;
   mTimeout =
       TimeDuration::FromSeconds(Preferences::GetInt(WATCHER_PREF_TIMEOUT, 5));
   mSizeDelta = Preferences::GetInt(WATCHER_PREF_SIZE_DELTA, 1) * 1024 * 1024;
+  mSampleInterval = TimeDuration::FromMilliseconds(
+      Preferences::GetInt(WATCHER_PREF_SAMPLE_INTERVAL, 1000));
 }
 
 void GonkDiskSpaceWatcher::DoStart() {
@@ -208,7 +249,8 @@ void GonkDiskSpaceWatcher::DoStart() {
     return;
   }
 
-  if (fanotify_mark(mFd, FAN_MARK_ADD | FAN_MARK_MOUNT, FAN_CLOSE, 0,
+  // Files only closed after reading don't change the free space.
+  if (fanotify_mark(mFd, FAN_MARK_ADD | FAN_MARK_MOUNT, FAN_CLOSE_WRITE, 0,
                     kWatchedPath) < 0) {
     NS_WARNING("Error calling fanotify_mark");
     close(mFd);
@@ -229,6 +271,11 @@ void GonkDiskSpaceWatcher::DoStop() {
   NS_ASSERTION(XRE_GetIOMessageLoop() == MessageLoopForIO::current(),
                "Not on the correct message loop");
 
+  if (mSampleTask) {
+    mSampleTask->Cancel();
+    mSampleTask = nullptr;
+  }
+
   if (mFd != -1) {
     mReadWatcher.StopWatchingFileDescriptor();
     fanotify_mark(mFd, FAN_MARK_FLUSH, 0, 0, kWatchedPath);
@@ -258,11 +305,117 @@ void GonkDiskSpaceWatcher::NotifyAlmostLowDiskSpace(bool aLowDiskSpace) {
   NS_DispatchToMainThread(runnable);
 }
 
+void GonkDiskSpaceWatcher::NotifyLevel() {
+  nsCOMPtr<nsIRunnable> runnable = new DiskSpaceLevelNotifier(mLevel);
+  NS_DispatchToMainThread(runnable);
+}
+
+uint64_t GonkDiskSpaceWatcher::LevelThreshold(uint16_t aLevel) const {
+  switch (aLevel) {
+    case nsIDiskSpaceWatcher::LEVEL_WARNING:
+      return mWarningThreshold;
+    case nsIDiskSpaceWatcher::LEVEL_LOW:
+      return mLowThreshold;
+    case nsIDiskSpaceWatcher::LEVEL_CRITICAL:
+      return mCriticalThreshold;
+    default:
+      return UINT64_MAX;
+  }
+}
+
+uint16_t GonkDiskSpaceWatcher::ComputeLevel(uint64_t aFreeSpace) const {
+  uint64_t hysteresis =
+      mHighThreshold > mLowThreshold ? mHighThreshold - mLowThreshold : 0;
+  uint16_t level = mLevel;
+  while (level < nsIDiskSpaceWatcher::LEVEL_CRITICAL &&
+         aFreeSpace <= LevelThreshold(level + 1)) {
+    level++;
+  }
+  while (level > nsIDiskSpaceWatcher::LEVEL_NORMAL &&
+         aFreeSpace > LevelThreshold(level) + hysteresis) {
+    level--;
+  }
+  return level;
+}
+
+void GonkDiskSpaceWatcher::MaybeSampleFreeSpace() {
+  if (mFreeSpace == UINT64_MAX ||
+      TimeStamp::Now() - mLastSampleTime >= mSampleInterval) {
+    SampleFreeSpace();
+    return;
+  }
+
+  uint64_t estimatedFreeSpace =
+      mFreeSpace > mEstimatedWrites ? mFreeSpace - mEstimatedWrites : 0;
+  if (ComputeLevel(estimatedFreeSpace) > mLevel) {
+    SampleFreeSpace();
+    return;
+  }
+
+  // Make sure the last writes of a burst are accounted for.
+  if (!mSampleTask) {
+    TimeDuration delay = mSampleInterval - (TimeStamp::Now() - mLastSampleTime);
+    mSampleTask = NewNonOwningCancelableRunnableMethod(
+        "GonkDiskSpaceWatcher::SampleFreeSpace", this,
+        &GonkDiskSpaceWatcher::SampleFreeSpace);
+    MessageLoopForIO::current()->PostDelayedTask(
+        do_AddRef(mSampleTask), static_cast<int>(delay.ToMilliseconds()) + 1);
+  }
+}
+
+void GonkDiskSpaceWatcher::SampleFreeSpace() {
+  if (mSampleTask) {
+    mSampleTask->Cancel();
+    mSampleTask = nullptr;
+  }
+
+  struct statfs sfs;
+  if (statfs(kWatchedPath, &sfs) < 0) {
+    NS_WARNING("Unable to statfs the watched path");
+    return;
+  }
+
+  bool firstRun = mFreeSpace == UINT64_MAX;
+  mFreeSpace = sfs.f_bavail * sfs.f_bsize;
+  mEstimatedWrites = 0;
+  mLastSampleTime = TimeStamp::Now();
+
+  uint16_t level = ComputeLevel(mFreeSpace);
+  bool levelChanged = level != mLevel;
+  mLevel = level;
+
+  // We change from full <-> free depending on the level, which follows the
+  // low and high thresholds.
+  // Once we are in 'full' mode we send updates for all size changes with
+  // a minimum of time between messages or when we cross a size change
+  // threshold.
+  bool isDiskFull = mLevel >= nsIDiskSpaceWatcher::LEVEL_LOW;
+  if (firstRun || isDiskFull != mIsDiskFull) {
+    // Always notify the current state at first run.
+    mIsDiskFull = isDiskFull;
+    NotifyUpdate();
+  } else if (mIsDiskFull) {
+    if (mTimeout < TimeStamp::Now() - mLastTimestamp ||
+        mSizeDelta < llabs(mFreeSpace - mLastFreeSpace)) {
+      NotifyUpdate();
+    }
+  }
+
+  bool isBelowWarningThreshold = mLevel >= nsIDiskSpaceWatcher::LEVEL_WARNING;
+  if (isBelowWarningThreshold != mIsBelowWarningThreshold) {
+    mIsBelowWarningThreshold = isBelowWarningThreshold;
+    NotifyAlmostLowDiskSpace(mIsBelowWarningThreshold);
+  }
+
+  if (firstRun || levelChanged) {
+    NotifyLevel();
+  }
+}
+
 void GonkDiskSpaceWatcher::OnFileCanReadWithoutBlocking(int aFd) {
   struct fanotify_event_metadata* fem = nullptr;
   char buf[4096];
-  struct statfs sfs;
-  int32_t len, rc;
+  int32_t len;
 
   do {
     len = read(aFd, buf, sizeof(buf));
@@ -281,45 +434,15 @@ void GonkDiskSpaceWatcher::OnFileCanReadWithoutBlocking(int aFd) {
   fem = reinterpret_cast<fanotify_event_metadata*>(buf);
 
   while (FAN_EVENT_OK(fem, len)) {
-    rc = fstatfs(fem->fd, &sfs);
-    if (rc < 0) {
-      NS_WARNING("Unable to stat fan_notify fd");
-    } else {
-      bool firstRun = mFreeSpace == UINT64_MAX;
-      mFreeSpace = sfs.f_bavail * sfs.f_bsize;
-      // We change from full <-> free depending on the free space and the
-      // low and high thresholds.
-      // Once we are in 'full' mode we send updates for all size changes with
-      // a minimum of time between messages or when we cross a size change
-      // threshold.
-      if (firstRun) {
-        mIsDiskFull = mFreeSpace <= mLowThreshold;
-        // Always notify the current state at first run.
-        NotifyUpdate();
-      } else if (!mIsDiskFull && (mFreeSpace <= mLowThreshold)) {
-        mIsDiskFull = true;
-        NotifyUpdate();
-      } else if (mIsDiskFull && (mFreeSpace > mHighThreshold)) {
-        mIsDiskFull = false;
-        NotifyUpdate();
-      } else if (mIsDiskFull) {
-        if (mTimeout < TimeStamp::Now() - mLastTimestamp ||
-            mSizeDelta < llabs(mFreeSpace - mLastFreeSpace)) {
-          NotifyUpdate();
-        }
-      }
-
-      if (!mIsBelowWarningThreshold && mFreeSpace <= mWarningThreshold) {
-        NotifyAlmostLowDiskSpace(true);
-        mIsBelowWarningThreshold = true;
-      } else if (mIsBelowWarningThreshold && mFreeSpace > mWarningThreshold) {
-        NotifyAlmostLowDiskSpace(false);
-        mIsBelowWarningThreshold = false;
-      }
+    struct stat st;
+    if (fstat(fem->fd, &st) == 0) {
+      mEstimatedWrites += st.st_size;
     }
     close(fem->fd);
     fem = FAN_EVENT_NEXT(fem, len);
   }
+
+  MaybeSampleFreeSpace();
 }
 
 void StartDiskSpaceWatcher() {
@@ -16,7 +16,9 @@
 #include "Hal.h"
 #include "HalLog.h"
 #include "tavarua.h"
+#include "nsTArray.h"
 #include "nsThreadUtils.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/FileUtils.h"
 
 #include <cutils/properties.h>
@@ -87,6 +89,9 @@ static pthread_t sRDSThread;
 static hal::FMRadioSettings sRadioSettings;
 static bool sMsmFMMode;
 static bool sRDSSupported;
+// Bumped whenever the radio is retuned, so that the RDS thread forgets the
+// groups it has seen from the previous station.
+static Atomic<uint32_t> sRDSStationGeneration;
 
 static int setControl(uint32_t id, int32_t value) {
   struct v4l2_control control = {0};
@@ -95,20 +100,38 @@ static int setControl(uint32_t id, int32_t value) {
   return ioctl(sRadioFD, VIDIOC_S_CTRL, &control);
 }
 
+// Delivers one or more operation results on the main thread, in order. The
+// results of a seek and of the tune it ends with travel together, as do all
+// the events the driver reports at once.
 class RadioUpdate : public Runnable {
-  hal::FMRadioOperation mOp;
-  hal::FMRadioOperationStatus mStatus;
+  struct Operation {
+    hal::FMRadioOperation mOp;
+    hal::FMRadioOperationStatus mStatus;
+  };
+  AutoTArray<Operation, 2> mOps;
 
  public:
+  RadioUpdate() : Runnable("hal::RadioUpdate") {}
   RadioUpdate(hal::FMRadioOperation op, hal::FMRadioOperationStatus status)
-      : Runnable("hal::RadioUpdate"), mOp(op), mStatus(status) {}
+      : Runnable("hal::RadioUpdate") {
+    Append(op, status);
+  }
+
+  void Append(hal::FMRadioOperation op, hal::FMRadioOperationStatus status) {
+    mOps.AppendElement(Operation{op, status});
+  }
+
+  bool IsEmpty() const { return mOps.IsEmpty(); }
 
   NS_IMETHOD Run() override {
-    hal::FMRadioOperationInformation info;
-    info.operation() = mOp;
-    info.status() = mStatus;
-    info.frequency() = GetFMRadioFrequency();
-    hal::NotifyFMRadioStatus(info);
+    uint32_t frequency = GetFMRadioFrequency();
+    for (const Operation& op : mOps) {
+      hal::FMRadioOperationInformation info;
+      info.operation() = op.mOp;
+      info.status() = op.mStatus;
+      info.frequency() = frequency;
+      hal::NotifyFMRadioStatus(info);
+    }
     return NS_OK;
   }
 };
@@ -242,32 +265,35 @@ static void* runMsmFMRadio(void*) {
 
     /* The tavarua driver reports a number of things asynchronously.
      * In those cases, the status update comes from this thread. */
+    RefPtr<RadioUpdate> update = new RadioUpdate();
     for (unsigned int i = 0; i < buffer.bytesused; i++) {
       switch (buf[i]) {
         case TAVARUA_EVT_RADIO_READY:
           // The driver sends RADIO_READY both when we turn the radio on and
           // when we turn the radio off.
           if (sRadioEnabled) {
-            NS_DispatchToMainThread(
-                new RadioUpdate(hal::FM_RADIO_OPERATION_ENABLE,
-                                hal::FM_RADIO_OPERATION_STATUS_SUCCESS));
+            update->Append(hal::FM_RADIO_OPERATION_ENABLE,
+                           hal::FM_RADIO_OPERATION_STATUS_SUCCESS);
           }
           break;
 
         case TAVARUA_EVT_SEEK_COMPLETE:
-          NS_DispatchToMainThread(
-              new RadioUpdate(hal::FM_RADIO_OPERATION_SEEK,
-                              hal::FM_RADIO_OPERATION_STATUS_SUCCESS));
+          sRDSStationGeneration++;
+          update->Append(hal::FM_RADIO_OPERATION_SEEK,
+                         hal::FM_RADIO_OPERATION_STATUS_SUCCESS);
           break;
         case TAVARUA_EVT_TUNE_SUCC:
-          NS_DispatchToMainThread(
-              new RadioUpdate(hal::FM_RADIO_OPERATION_TUNE,
-                              hal::FM_RADIO_OPERATION_STATUS_SUCCESS));
+          sRDSStationGeneration++;
+          update->Append(hal::FM_RADIO_OPERATION_TUNE,
+                         hal::FM_RADIO_OPERATION_STATUS_SUCCESS);
           break;
         default:
           break;
       }
     }
+    if (!update->IsEmpty()) {
+      NS_DispatchToMainThread(update.forget());
+    }
   }
 
   return nullptr;
@@ -405,18 +431,19 @@ void FMRadioSeek(const hal::FMRadioSeekDirection& aDirection) {
   int rc = ioctl(sRadioFD, VIDIOC_S_HW_FREQ_SEEK, &seek);
   if (sMsmFMMode && rc >= 0) return;
 
-  NS_DispatchToMainThread(
-      new RadioUpdate(hal::FM_RADIO_OPERATION_SEEK,
-                      rc < 0 ? hal::FM_RADIO_OPERATION_STATUS_FAIL
-                             : hal::FM_RADIO_OPERATION_STATUS_SUCCESS));
-
   if (rc < 0) {
     HAL_LOG("Could not initiate hardware seek");
+    NS_DispatchToMainThread(new RadioUpdate(
+        hal::FM_RADIO_OPERATION_SEEK, hal::FM_RADIO_OPERATION_STATUS_FAIL));
     return;
   }
 
-  NS_DispatchToMainThread(new RadioUpdate(
-      hal::FM_RADIO_OPERATION_TUNE, hal::FM_RADIO_OPERATION_STATUS_SUCCESS));
+  sRDSStationGeneration++;
+  RefPtr<RadioUpdate> update = new RadioUpdate(
+      hal::FM_RADIO_OPERATION_SEEK, hal::FM_RADIO_OPERATION_STATUS_SUCCESS);
+  update->Append(hal::FM_RADIO_OPERATION_TUNE,
+                 hal::FM_RADIO_OPERATION_STATUS_SUCCESS);
+  NS_DispatchToMainThread(update.forget());
 }
 
 void GetFMRadioSettings(hal::FMRadioSettings* aInfo) {
@@ -441,7 +468,11 @@ void SetFMRadioFrequency(const uint32_t frequency) {
   freq.frequency = (frequency * 10000) / 625;
 
   int rc = ioctl(sRadioFD, VIDIOC_S_FREQUENCY, &freq);
-  if (rc < 0) HAL_LOG("Could not set radio frequency");
+  if (rc < 0) {
+    HAL_LOG("Could not set radio frequency");
+  } else {
+    sRDSStationGeneration++;
+  }
 
   if (sMsmFMMode && rc >= 0) return;
 
@@ -484,6 +515,13 @@ static void* readRDSDataThread(void* data) {
   v4l2_rds_data rdsblocks[16];
   uint16_t blocks[4];
 
+  // The last group of each of the 32 group types. Stations repeat their
+  // groups continuously; a group identical to the last one of its type
+  // carries nothing new and isn't passed on.
+  uint16_t lastGroups[32][4];
+  uint32_t lastGroupsSet = 0;
+  uint32_t stationGeneration = sRDSStationGeneration;
+
   // Explicitely force cast to (int)(unsigned long) to avoid Clang error:
   // error: cast from pointer to smaller type 'int' loses information
   // due to 64-bits pointer to 32-bits int with just casting (int)
@@ -572,6 +610,19 @@ static void* readRDSDataThread(void* data) {
       // Make sure we have all 4 blocks and that they're valid
       if (block_bitmap != 0x0F) continue;
 
+      if (stationGeneration != sRDSStationGeneration) {
+        stationGeneration = sRDSStationGeneration;
+        lastGroupsSet = 0;
+      }
+
+      uint16_t groupType = blocks[V4L2_RDS_BLOCK_B] >> 11;
+      if ((lastGroupsSet & (1u << groupType)) &&
+          !memcmp(lastGroups[groupType], blocks, sizeof(blocks))) {
+        continue;
+      }
+      memcpy(lastGroups[groupType], blocks, sizeof(blocks));
+      lastGroupsSet |= 1u << groupType;
+
       hal::FMRadioRDSGroup group;
       group.blockA() = blocks[V4L2_RDS_BLOCK_A];
       group.blockB() = blocks[V4L2_RDS_BLOCK_B];
@@ -22,11 +22,14 @@
 #include <regex.h>
 #include <sched.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/klog.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
 #include <sys/timerfd.h>
 #include <sys/resource.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -40,6 +43,7 @@
 #include "hardware/hardware.h"
 #include "hardware/lights.h"
 #include "hardware_legacy/uevent.h"
+#include "android/hardware/power/1.0/IPower.h"
 #include "android/hardware/vibrator/1.0/IVibrator.h"
 #include "libdisplay/GonkDisplay.h"
 
@@ -53,15 +57,18 @@
 #include "HalLog.h"
 #include "HalScreenConfiguration.h"
 #include "mozilla/ArrayUtils.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/ClearOnShutdown.h"
 #include "mozilla/dom/battery/Constants.h"
 #include "mozilla/dom/NetworkInformationBinding.h"
 #include "mozilla/DebugOnly.h"
 #include "mozilla/FileUtils.h"
+#include "mozilla/Maybe.h"
 #include "mozilla/Monitor.h"
 #include "mozilla/RefPtr.h"
 #include "mozilla/Services.h"
 #include "mozilla/StaticMutex.h"
+#include "mozilla/StaticPrefs_dom.h"
 #include "mozilla/StaticPtr.h"
 #include "mozilla/TimeStamp.h"
 #include "mozilla/Preferences.h"
@@ -79,6 +86,7 @@
 #include "nsThreadUtils.h"
 #include "nsThreadUtils.h"
 #include "nsIThread.h"
+#include "nsITimer.h"
 #include "nsXULAppAPI.h"
 #include "OrientationObserver.h"
 #include "UeventPoller.h"
@@ -131,13 +139,25 @@ namespace hal_impl {
 
 namespace {
 
+namespace vibrator = android::hardware::vibrator::V1_0;
+
 /**
  * This runnable runs for the lifetime of the program, once started.  It's
  * responsible for "playing" vibration patterns.
+ *
+ * Short patterns which look like a key click are played as one of the
+ * vibrator HAL's predefined effects, which the driver renders in a single
+ * call. Other patterns are played pulse by pulse: the vibrator stops by
+ * itself at the end of each pulse, so the thread only wakes up once per
+ * pulse, at a deadline computed from the start of the pattern so that
+ * scheduling delays don't add up.
  */
 class VibratorRunnable final : public nsIRunnable, public nsIObserver {
  public:
-  VibratorRunnable() : mMonitor("VibratorRunnable"), mIndex(0) {
+  VibratorRunnable()
+      : mMonitor("VibratorRunnable"),
+        mIndex(0),
+        mEffectUnsupported{false, false} {
     nsCOMPtr<nsIObserverService> os = services::GetObserverService();
     if (!os) {
       NS_WARNING("Could not get observer service!");
@@ -161,8 +181,20 @@ class VibratorRunnable final : public nsIRunnable, public nsIObserver {
   ~VibratorRunnable() {}
 
  private:
+  // Returns the effect to play aPattern with, if any.
+  static Maybe<vibrator::Effect> PatternToEffect(
+      const nsTArray<uint32_t>& aPattern);
+
+  // Called on the vibrator thread with mMonitor held.
+  bool PerformEffect(vibrator::Effect aEffect);
+  void PlayNextPulse();
+
   Monitor mMonitor;
 
+  // Only used on the vibrator thread. Looked up once, and again only if the
+  // HAL went away.
+  android::sp<vibrator::IVibrator> mVibrator;
+
   // The currently-playing pattern.
   nsTArray<uint32_t> mPattern;
 
@@ -170,6 +202,15 @@ class VibratorRunnable final : public nsIRunnable, public nsIObserver {
   // mPattern.Length(), then we're not currently playing anything.
   uint32_t mIndex;
 
+  // When the pulse at mIndex starts.
+  TimeStamp mNextPulse;
+
+  // The effect to play instead of mPattern, if the HAL supports it.
+  Maybe<vibrator::Effect> mEffect;
+
+  // Indexed by vibrator::Effect. Only used on the vibrator thread.
+  bool mEffectUnsupported[2];
+
   // Set to true in our shutdown observer.  When this is true, we kill the
   // vibrator thread.
   static bool sShuttingDown;
@@ -185,36 +226,93 @@ NS_IMETHODIMP
 VibratorRunnable::Run() {
   MonitorAutoLock lock(mMonitor);
 
-  // We currently assume that mMonitor.Wait(X) waits for X milliseconds.  But in
-  // reality, the kernel might not switch to this thread for some time after the
-  // wait expires.  So there's potential for some inaccuracy here.
-  //
-  // This doesn't worry me too much.  Note that we don't even start vibrating
-  // immediately when VibratorRunnable::Vibrate is called -- we go through a
-  // condvar onto another thread.  Better just to be chill about small errors in
-  // the timing here.
+  mVibrator = vibrator::IVibrator::getService();
 
   while (!sShuttingDown) {
-    if (mIndex < mPattern.Length()) {
-      uint32_t duration = mPattern[mIndex];
-      // Get a handle to the HIDL vibrator service.
-      auto vibrator =
-          android::hardware::vibrator::V1_0::IVibrator::getService();
-      if ((mPattern.Length() == 1) && (duration == 0)) {
-        vibrator->off();
-      } else if (mIndex % 2 == 0) {
-        vibrator->on(duration);
+    if (mEffect) {
+      vibrator::Effect effect = mEffect.extract();
+      if (PerformEffect(effect)) {
+        mIndex = mPattern.Length();
+        continue;
       }
-      mIndex++;
-      mMonitor.Wait(TimeDuration::FromMilliseconds(duration));
-    } else {
+    }
+
+    if (mIndex >= mPattern.Length()) {
       mMonitor.Wait();
+      continue;
+    }
+
+    // A new pattern may come in while we wait, which restarts the loop.
+    TimeStamp now = TimeStamp::Now();
+    if (now < mNextPulse) {
+      mMonitor.Wait(mNextPulse - now);
+      continue;
     }
+
+    PlayNextPulse();
   }
+
+  mVibrator = nullptr;
   sVibratorRunnable = nullptr;
   return NS_OK;
 }
 
+bool VibratorRunnable::PerformEffect(vibrator::Effect aEffect) {
+  uint32_t index = static_cast<uint32_t>(aEffect);
+  if (index >= ArrayLength(mEffectUnsupported) ||
+      mEffectUnsupported[index]) {
+    return false;
+  }
+
+  if (!mVibrator) {
+    mVibrator = vibrator::IVibrator::getService();
+    if (!mVibrator) {
+      return false;
+    }
+  }
+
+  vibrator::Status status = vibrator::Status::UNKNOWN_ERROR;
+  auto ret = mVibrator->perform(
+      aEffect, vibrator::EffectStrength::MEDIUM,
+      [&status](vibrator::Status aStatus, uint32_t) { status = aStatus; });
+  if (!ret.isOk()) {
+    mVibrator = nullptr;
+    return false;
+  }
+
+  if (status == vibrator::Status::UNSUPPORTED_OPERATION) {
+    HAL_LOG("Vibrator effect %u is unsupported, playing patterns instead",
+            index);
+    mEffectUnsupported[index] = true;
+  }
+  return status == vibrator::Status::OK;
+}
+
+void VibratorRunnable::PlayNextPulse() {
+  if (!mVibrator) {
+    mVibrator = vibrator::IVibrator::getService();
+  }
+
+  uint32_t duration = mPattern[mIndex];
+  bool ok = true;
+  if (mVibrator) {
+    if (mPattern.Length() == 1 && duration == 0) {
+      ok = mVibrator->off().isOk();
+    } else if (duration) {
+      ok = mVibrator->on(duration).isOk();
+    }
+  }
+  if (!ok) {
+    mVibrator = nullptr;
+  }
+
+  // The vibrator stops by itself, so sleep through the following pause as
+  // well.
+  uint32_t pause = mIndex + 1 < mPattern.Length() ? mPattern[mIndex + 1] : 0;
+  mNextPulse += TimeDuration::FromMilliseconds(duration + pause);
+  mIndex += 2;
+}
+
 NS_IMETHODIMP
 VibratorRunnable::Observe(nsISupports* subject, const char* topic,
                           const char16_t* data) {
@@ -226,10 +324,39 @@ VibratorRunnable::Observe(nsISupports* subject, const char* topic,
   return NS_OK;
 }
 
+/* static */
+Maybe<vibrator::Effect> VibratorRunnable::PatternToEffect(
+    const nsTArray<uint32_t>& aPattern) {
+  if (!StaticPrefs::dom_vibrator_effects_enabled()) {
+    return Nothing();
+  }
+
+  uint32_t maxClick = StaticPrefs::dom_vibrator_effects_max_click_ms();
+  uint32_t maxGap = StaticPrefs::dom_vibrator_effects_max_double_click_gap_ms();
+  auto isClick = [maxClick](uint32_t aDuration) {
+    return aDuration && aDuration <= maxClick;
+  };
+
+  if (aPattern.Length() == 1 && isClick(aPattern[0])) {
+    return Some(vibrator::Effect::CLICK);
+  }
+  // A trailing pause doesn't change what the pattern feels like.
+  if ((aPattern.Length() == 3 || aPattern.Length() == 4) &&
+      isClick(aPattern[0]) && isClick(aPattern[2]) &&
+      aPattern[1] <= maxGap) {
+    return Some(vibrator::Effect::DOUBLE_CLICK);
+  }
+  return Nothing();
+}
+
 void VibratorRunnable::Vibrate(const nsTArray<uint32_t>& pattern) {
+  Maybe<vibrator::Effect> effect = PatternToEffect(pattern);
+
   MonitorAutoLock lock(mMonitor);
   mPattern.Assign(pattern);
   mIndex = 0;
+  mNextPulse = TimeStamp::Now();
+  mEffect = effect;
   mMonitor.Notify();
 }
 
@@ -238,6 +365,8 @@ void VibratorRunnable::CancelVibrate() {
   mPattern.Clear();
   mPattern.AppendElement(0);
   mIndex = 0;
+  mNextPulse = TimeStamp::Now();
+  mEffect.reset();
   mMonitor.Notify();
 }
 
@@ -275,10 +404,10 @@ namespace {
 
 class BatteryUpdater : public Runnable {
  public:
-  explicit BatteryUpdater() : Runnable("hal::BatteryUpdater") {}
+  explicit BatteryUpdater(const hal::BatteryInformation& aInfo)
+      : Runnable("hal::BatteryUpdater"), mInfo(aInfo) {}
   NS_IMETHOD Run() override {
-    hal::BatteryInformation info;
-    hal_impl::GetCurrentBatteryInformation(&info);
+    const hal::BatteryInformation& info = mInfo;
 
     // Control the battery indicator (led light) here using BatteryInformation
     // we just retrieved.
@@ -327,15 +456,54 @@ class BatteryUpdater : public Runnable {
 
     return NS_OK;
   }
+
+ private:
+  hal::BatteryInformation mInfo;
 };
 
 }  // namespace
 
+// The power supply state is read from sysfs in one pass on sBatteryTaskQueue
+// whenever the kernel reports a power_supply uevent, and every query in
+// between is answered from sBatteryInfo. The cache is only trusted while the
+// uevent observer is registered; otherwise queries read sysfs directly.
+static StaticMutex sBatteryInfoMutex;
+static hal::BatteryInformation sBatteryInfo;
+static bool sBatteryInfoValid = false;
+static StaticRefPtr<nsISerialEventTarget> sBatteryTaskQueue;
+static Atomic<bool> sBatteryRefreshPending(false);
+
+static void ReadCurrentBatteryInformation(hal::BatteryInformation* aBatteryInfo);
+
+static void RefreshBatteryInformation() {
+  sBatteryRefreshPending = false;
+
+  hal::BatteryInformation info;
+  {
+    StaticMutexAutoLock lock(sBatteryInfoMutex);
+    ReadCurrentBatteryInformation(&info);
+    sBatteryInfo = info;
+    sBatteryInfoValid = true;
+  }
+
+  NS_DispatchToMainThread(new BatteryUpdater(info));
+}
+
+static void ScheduleBatteryRefresh() {
+  // A charger being plugged in fires a burst of uevents; one read after the
+  // burst sees the same state as one read per event.
+  if (!sBatteryTaskQueue || sBatteryRefreshPending.exchange(true)) {
+    return;
+  }
+  sBatteryTaskQueue->Dispatch(NS_NewRunnableFunction(
+      "hal::RefreshBatteryInformation", RefreshBatteryInformation));
+}
+
 class BatteryObserver final : public IUeventObserver {
  public:
   NS_INLINE_DECL_REFCOUNTING(BatteryObserver)
 
-  BatteryObserver() : mUpdater(new BatteryUpdater()) {}
+  BatteryObserver() {}
 
   virtual void Notify(const NetlinkEvent& aEvent) {
     // this will run on IO thread
@@ -345,15 +513,12 @@ class BatteryObserver final : public IUeventObserver {
     const char* devpath = event->findParam("DEVPATH");
     if (strcmp(subsystem, "power_supply") == 0 && strstr(devpath, "battery")) {
       // aEvent will be valid only in this method.
-      NS_DispatchToMainThread(mUpdater);
+      ScheduleBatteryRefresh();
     }
   }
 
  protected:
   ~BatteryObserver() {}
-
- private:
-  RefPtr<BatteryUpdater> mUpdater;
 };
 
 // sBatteryObserver is owned by the IO thread. Only the IO thread may
@@ -365,10 +530,23 @@ static void RegisterBatteryObserverIOThread() {
   MOZ_ASSERT(!sBatteryObserver);
 
   sBatteryObserver = new BatteryObserver();
-  RegisterUeventListener(sBatteryObserver);
+  RegisterUeventListener(sBatteryObserver, "power_supply");
+
+  // Fill the cache now, so queries stop touching sysfs right away.
+  ScheduleBatteryRefresh();
 }
 
 void EnableBatteryNotifications() {
+  MOZ_ASSERT(NS_IsMainThread());
+  if (!sBatteryTaskQueue) {
+    nsCOMPtr<nsISerialEventTarget> taskQueue;
+    DebugOnly<nsresult> rv =
+        NS_CreateBackgroundTaskQueue("BatteryState", getter_AddRefs(taskQueue));
+    MOZ_ASSERT(NS_SUCCEEDED(rv));
+    sBatteryTaskQueue = taskQueue.forget();
+    ClearOnShutdown(&sBatteryTaskQueue);
+  }
+
   XRE_GetIOMessageLoop()->PostTask(NewRunnableFunction(
       "RegisterBatteryObserver", RegisterBatteryObserverIOThread));
 }
@@ -379,6 +557,11 @@ static void UnregisterBatteryObserverIOThread() {
 
   UnregisterUeventListener(sBatteryObserver);
   sBatteryObserver = nullptr;
+
+  // Nothing keeps the cache current any more. A refresh still queued may
+  // mark it valid again briefly, which is no worse than a sysfs read.
+  StaticMutexAutoLock lock(sBatteryInfoMutex);
+  sBatteryInfoValid = false;
 }
 
 static BatteryHealth GetCurrentBatteryHealth() {
@@ -468,7 +651,7 @@ static bool GetCurrentBatteryCharging(int* aCharging) {
   return false;
 }
 
-double GetBatteryTemperature() {
+static double ReadBatteryTemperature() {
   int temperature;
   bool success =
       ReadSysFile("/sys/class/power_supply/battery/temp", &temperature);
@@ -478,7 +661,7 @@ double GetBatteryTemperature() {
   ;
 }
 
-bool IsBatteryPresent() {
+static bool ReadBatteryPresent() {
   bool present;
   bool success =
       ReadSysFile("/sys/class/power_supply/battery/present", &present);
@@ -486,7 +669,10 @@ bool IsBatteryPresent() {
   return success ? present : dom::battery::kDefaultPresent;
 }
 
-void GetCurrentBatteryInformation(hal::BatteryInformation* aBatteryInfo) {
+// Must be called with sBatteryInfoMutex held, as it keeps the state used to
+// estimate the remaining time across calls.
+static void ReadCurrentBatteryInformation(
+    hal::BatteryInformation* aBatteryInfo) {
   int charge;
   static bool previousCharging = false;
   static double previousLevel = 0.0, remainingTime = 0.0;
@@ -500,9 +686,9 @@ void GetCurrentBatteryInformation(hal::BatteryInformation* aBatteryInfo) {
     aBatteryInfo->level() = dom::battery::kDefaultLevel;
   }
 
-  aBatteryInfo->temperature() = GetBatteryTemperature();
+  aBatteryInfo->temperature() = ReadBatteryTemperature();
   aBatteryInfo->health() = GetCurrentBatteryHealth();
-  aBatteryInfo->present() = IsBatteryPresent();
+  aBatteryInfo->present() = ReadBatteryPresent();
 
   int charging;
 
@@ -588,6 +774,35 @@ void GetCurrentBatteryInformation(hal::BatteryInformation* aBatteryInfo) {
   previousLevel = aBatteryInfo->level();
 }
 
+void GetCurrentBatteryInformation(hal::BatteryInformation* aBatteryInfo) {
+  StaticMutexAutoLock lock(sBatteryInfoMutex);
+  if (!sBatteryInfoValid) {
+    ReadCurrentBatteryInformation(aBatteryInfo);
+    return;
+  }
+  *aBatteryInfo = sBatteryInfo;
+}
+
+double GetBatteryTemperature() {
+  {
+    StaticMutexAutoLock lock(sBatteryInfoMutex);
+    if (sBatteryInfoValid) {
+      return sBatteryInfo.temperature();
+    }
+  }
+  return ReadBatteryTemperature();
+}
+
+bool IsBatteryPresent() {
+  {
+    StaticMutexAutoLock lock(sBatteryInfoMutex);
+    if (sBatteryInfoValid) {
+      return sBatteryInfo.present();
+    }
+  }
+  return ReadBatteryPresent();
+}
+
 namespace {
 
 class UsbUpdater : public Runnable {
@@ -652,7 +867,7 @@ static void RegisterUsbObserverIOThread() {
   MOZ_ASSERT(!sUsbObserver);
 
   sUsbObserver = new UsbObserver();
-  RegisterUeventListener(sUsbObserver);
+  RegisterUeventListener(sUsbObserver, "android_usb");
 }
 
 void EnableUsbNotifications() {
@@ -762,7 +977,7 @@ static void RegisterPowerSupplyObserverIOThread() {
   MOZ_ASSERT(!sPowerSupplyObserver);
 
   sPowerSupplyObserver = new PowerSupplyObserver();
-  RegisterUeventListener(sPowerSupplyObserver);
+  RegisterUeventListener(sPowerSupplyObserver, "power_supply");
 }
 
 void EnablePowerSupplyNotifications() {
@@ -1447,7 +1662,6 @@ DisableFlipNotifications()
 {
 }
 
-#if 0  // TODO: FIXME
 static int
 OomAdjOfOomScoreAdj(int aOomScoreAdj)
 {
@@ -1465,15 +1679,6 @@ OomAdjOfOomScoreAdj(int aOomScoreAdj)
   return adj;
 }
 
-static void
-RoundOomScoreAdjUpWithLRU(int& aOomScoreAdj, uint32_t aLRU)
-{
-  // We want to add minimum value to round OomScoreAdj up according to
-  // the steps by aLRU.
-  aOomScoreAdj +=
-    ceil(((float)OOM_SCORE_ADJ_MAX / OOM_ADJUST_MAX) * aLRU);
-}
-
 #  define OOM_LOG(level, args...) \
     __android_log_print(level, "OomLogger", ##args)
 class OomVictimLogger final
@@ -1652,7 +1857,7 @@ public:
 
   int32_t OomScoreAdj()
   {
-    return clamped<int32_t>(mOomScoreAdj, OOM_SCORE_ADJ_MIN, OOM_SCORE_ADJ_MAX);
+    return std::clamp<int32_t>(mOomScoreAdj, OOM_SCORE_ADJ_MIN, OOM_SCORE_ADJ_MAX);
   }
 
   int32_t KillUnderKB()
@@ -1673,13 +1878,29 @@ public:
    */
   void AddProcess(int aPid);
 
+  /**
+   * Switches the utilization clamp and the schedtune boost of the control
+   * group between their boosted and normal values, see
+   * BoostForegroundProcesses.
+   */
+  void SetBoosted(bool aBoosted);
+
 private:
   ProcessPriority mPriority;
   int32_t mOomScoreAdj;
   int32_t mKillUnderKB;
   int mCpuCGroupProcsFd;
   int mMemCGroupProcsFd;
+  int mCpusetCGroupProcsFd;
+  int mStuneCGroupProcsFd;
   nsCString mGroup;
+  // -1 when the group doesn't have the corresponding pref.
+  int32_t mUclampMin;
+  int32_t mBoostedUclampMin;
+  int32_t mSchedtuneBoost;
+  int32_t mBoostedSchedtuneBoost;
+
+  void ReadBoostPrefs();
 
   /**
    * Return a string that identifies where we can find the value of aPref
@@ -1736,8 +1957,161 @@ private:
   {
     return open(MemCGroupProcsFilename().get(), O_WRONLY);
   }
+
+  /**
+   * The cpuset and schedtune hierarchies are optional: the groups are only
+   * created if the corresponding prefs are set, so the procs files may not
+   * exist.
+   */
+  int OpenCpusetCGroupProcs()
+  {
+    return open(("/dev/cpuset/"_ns + mGroup + "/cgroup.procs"_ns).get(),
+                O_WRONLY);
+  }
+
+  int OpenStuneCGroupProcs()
+  {
+    return open(("/dev/stune/"_ns + mGroup + "/cgroup.procs"_ns).get(),
+                O_WRONLY);
+  }
 };
 
+/**
+ * Returns the prefix of the preferences of the given control group, e.g.
+ * "hal.processPriorityManager.gonk.cgroups.apps/critical.".
+ */
+static nsAutoCString
+CGroupPrefPrefix(const nsACString& aGroup)
+{
+  nsAutoCString prefPrefix("hal.processPriorityManager.gonk.cgroups.");
+
+  /* If cgroup is not empty, append the cgroup name and a dot to obtain the
+   * group specific preferences. */
+  if (!aGroup.IsEmpty()) {
+    prefPrefix += aGroup + "."_ns;
+  }
+
+  return prefPrefix;
+}
+
+/**
+ * Creates aGroup and its parents in the hierarchy mounted at aRoot, like
+ * mkdir -p.
+ */
+static bool
+EnsureCGroupDirectories(const nsACString& aRoot, const nsACString& aGroup)
+{
+  nsCString cgroupIter = aGroup + "/"_ns;
+
+  int32_t offset = 0;
+  while ((offset = cgroupIter.FindChar('/', offset)) != -1) {
+    nsAutoCString path = aRoot + Substring(cgroupIter, 0, offset);
+    int rv = mkdir(path.get(), 0744);
+
+    if (rv == -1 && errno != EEXIST) {
+      HAL_LOG("Could not create the %s control group.", path.get());
+      return false;
+    }
+
+    offset++;
+  }
+
+  return true;
+}
+
+/**
+ * Android mounts the cpuset hierarchy with the noprefix option, so its files
+ * are called cpus and mems rather than cpuset.cpus and cpuset.mems.
+ */
+static nsAutoCString
+CpusetFilename(const nsACString& aDirectory, const char* aName)
+{
+  nsAutoCString path(aDirectory + nsDependentCString(aName));
+  if (access(path.get(), F_OK) == 0) {
+    return path;
+  }
+  return nsAutoCString(aDirectory + "cpuset."_ns + nsDependentCString(aName));
+}
+
+/**
+ * Creates the cpuset of the given group, restricted to the CPUs listed by its
+ * cpuset preference, e.g. "0-3" for the little cores of a big.LITTLE device.
+ * Groups without the preference are left out of the cpuset hierarchy.
+ *
+ * @return true if the group has a cpuset.
+ */
+static bool
+EnsureCpusetCGroupExists(const nsACString& aGroup)
+{
+  NS_NAMED_LITERAL_CSTRING(kDevCpuset, "/dev/cpuset/");
+
+  nsAutoCString cpus;
+  if (aGroup.IsEmpty() ||
+      NS_FAILED(Preferences::GetCString(
+        (CGroupPrefPrefix(aGroup) + "cpuset"_ns).get(), cpus)) ||
+      cpus.IsEmpty()) {
+    return false;
+  }
+
+  if (access(kDevCpuset.get(), F_OK) != 0) {
+    HAL_LOG("No cpuset hierarchy, can't restrict group '%s' to CPUs %s",
+            PromiseFlatCString(aGroup).get(), cpus.get());
+    return false;
+  }
+
+  if (!EnsureCGroupDirectories(kDevCpuset, aGroup)) {
+    return false;
+  }
+
+  // A cpuset doesn't take any task until its memory nodes are set, use the
+  // ones of the root set.
+  char mems[32];
+  if (!ReadSysFile(CpusetFilename(kDevCpuset, "mems").get(), mems,
+                   sizeof(mems))) {
+    HAL_LOG("Could not read the memory nodes of the root cpuset");
+    return false;
+  }
+
+  nsAutoCString pathPrefix(kDevCpuset + aGroup + "/"_ns);
+  if (!WriteSysFile(CpusetFilename(pathPrefix, "mems").get(), mems) ||
+      !WriteSysFile(CpusetFilename(pathPrefix, "cpus").get(), cpus.get())) {
+    HAL_LOG("Could not set up the cpuset of group %s",
+            PromiseFlatCString(aGroup).get());
+    return false;
+  }
+
+  HAL_LOG("Restricted group '%s' to CPUs %s",
+          PromiseFlatCString(aGroup).get(), cpus.get());
+  return true;
+}
+
+/**
+ * Creates the schedtune group of the given group if it has boost values.
+ * Kernels with utilization clamping have no schedtune and use cpu.uclamp.min
+ * in the cpu hierarchy instead.
+ *
+ * @return true if the group has a schedtune group.
+ */
+static bool
+EnsureStuneCGroupExists(const nsACString& aGroup)
+{
+  NS_NAMED_LITERAL_CSTRING(kDevStune, "/dev/stune/");
+
+  nsAutoCString prefPrefix(CGroupPrefPrefix(aGroup));
+  if (aGroup.IsEmpty() ||
+      (Preferences::GetInt((prefPrefix + "schedtune_boost"_ns).get(), -1) < 0 &&
+       Preferences::GetInt((prefPrefix + "boosted_schedtune_boost"_ns).get(),
+                           -1) < 0)) {
+    return false;
+  }
+
+  if (access(kDevStune.get(), F_OK) != 0) {
+    return false;
+  }
+
+  return EnsureCGroupDirectories(kDevStune, aGroup);
+}
+
 /**
  * Try to create the cgroup for the given PriorityClass, if it doesn't already
  * exist.  This essentially implements mkdir -p; that is, we create parent
@@ -1864,6 +2238,12 @@ PriorityClass::PriorityClass(ProcessPriority aPriority)
   , mKillUnderKB(0)
   , mCpuCGroupProcsFd(-1)
   , mMemCGroupProcsFd(-1)
+  , mCpusetCGroupProcsFd(-1)
+  , mStuneCGroupProcsFd(-1)
+  , mUclampMin(-1)
+  , mBoostedUclampMin(-1)
+  , mSchedtuneBoost(-1)
+  , mBoostedSchedtuneBoost(-1)
 {
   DebugOnly<nsresult> rv;
 
@@ -1874,7 +2254,7 @@ PriorityClass::PriorityClass(ProcessPriority aPriority)
   rv = Preferences::GetInt(PriorityPrefName("KillUnderKB").get(),
                            &mKillUnderKB);
 
-  rv = Preferences::GetCString(PriorityPrefName("cgroup").get(), &mGroup);
+  rv = Preferences::GetCString(PriorityPrefName("cgroup").get(), mGroup);
   MOZ_ASSERT(NS_SUCCEEDED(rv), "Missing control group preference");
 
   if (EnsureCpuCGroupExists(mGroup)) {
@@ -1883,6 +2263,15 @@ PriorityClass::PriorityClass(ProcessPriority aPriority)
   if (EnsureMemCGroupExists(mGroup)) {
     mMemCGroupProcsFd = OpenMemCGroupProcs();
   }
+  if (EnsureCpusetCGroupExists(mGroup)) {
+    mCpusetCGroupProcsFd = OpenCpusetCGroupProcs();
+  }
+  if (EnsureStuneCGroupExists(mGroup)) {
+    mStuneCGroupProcsFd = OpenStuneCGroupProcs();
+  }
+
+  ReadBoostPrefs();
+  SetBoosted(false);
 }
 
 PriorityClass::~PriorityClass()
@@ -1893,6 +2282,12 @@ PriorityClass::~PriorityClass()
   if (mMemCGroupProcsFd != -1) {
     close(mMemCGroupProcsFd);
   }
+  if (mCpusetCGroupProcsFd != -1) {
+    close(mCpusetCGroupProcsFd);
+  }
+  if (mStuneCGroupProcsFd != -1) {
+    close(mStuneCGroupProcsFd);
+  }
 }
 
 PriorityClass::PriorityClass(const PriorityClass& aOther)
@@ -1900,9 +2295,17 @@ PriorityClass::PriorityClass(const PriorityClass& aOther)
   , mOomScoreAdj(aOther.mOomScoreAdj)
   , mKillUnderKB(aOther.mKillUnderKB)
   , mGroup(aOther.mGroup)
+  , mUclampMin(aOther.mUclampMin)
+  , mBoostedUclampMin(aOther.mBoostedUclampMin)
+  , mSchedtuneBoost(aOther.mSchedtuneBoost)
+  , mBoostedSchedtuneBoost(aOther.mBoostedSchedtuneBoost)
 {
   mCpuCGroupProcsFd = OpenCpuCGroupProcs();
   mMemCGroupProcsFd = OpenMemCGroupProcs();
+  mCpusetCGroupProcsFd =
+    aOther.mCpusetCGroupProcsFd != -1 ? OpenCpusetCGroupProcs() : -1;
+  mStuneCGroupProcsFd =
+    aOther.mStuneCGroupProcsFd != -1 ? OpenStuneCGroupProcs() : -1;
 }
 
 PriorityClass& PriorityClass::operator=(const PriorityClass& aOther)
@@ -1911,11 +2314,58 @@ PriorityClass& PriorityClass::operator=(const PriorityClass& aOther)
   mOomScoreAdj = aOther.mOomScoreAdj;
   mKillUnderKB = aOther.mKillUnderKB;
   mGroup = aOther.mGroup;
+  mUclampMin = aOther.mUclampMin;
+  mBoostedUclampMin = aOther.mBoostedUclampMin;
+  mSchedtuneBoost = aOther.mSchedtuneBoost;
+  mBoostedSchedtuneBoost = aOther.mBoostedSchedtuneBoost;
   mCpuCGroupProcsFd = OpenCpuCGroupProcs();
   mMemCGroupProcsFd = OpenMemCGroupProcs();
+  mCpusetCGroupProcsFd =
+    aOther.mCpusetCGroupProcsFd != -1 ? OpenCpusetCGroupProcs() : -1;
+  mStuneCGroupProcsFd =
+    aOther.mStuneCGroupProcsFd != -1 ? OpenStuneCGroupProcs() : -1;
   return *this;
 }
 
+void PriorityClass::ReadBoostPrefs()
+{
+  nsAutoCString prefPrefix(CGroupPrefPrefix(mGroup));
+
+  mUclampMin = Preferences::GetInt((prefPrefix + "uclamp_min"_ns).get(), -1);
+  mBoostedUclampMin =
+    Preferences::GetInt((prefPrefix + "boosted_uclamp_min"_ns).get(), -1);
+  mSchedtuneBoost =
+    Preferences::GetInt((prefPrefix + "schedtune_boost"_ns).get(), -1);
+  mBoostedSchedtuneBoost =
+    Preferences::GetInt((prefPrefix + "boosted_schedtune_boost"_ns).get(), -1);
+}
+
+void PriorityClass::SetBoosted(bool aBoosted)
+{
+  if (mGroup.IsEmpty()) {
+    return;
+  }
+
+  // Without a boosted value, the group keeps its normal one while boosted.
+  int32_t uclampMin =
+    aBoosted && mBoostedUclampMin >= 0 ? mBoostedUclampMin : mUclampMin;
+  if (uclampMin >= 0) {
+    // cpu.uclamp.min is a percentage of the capacity of the biggest CPU.
+    WriteSysFile(
+      ("/dev/cpuctl/"_ns + mGroup + "/cpu.uclamp.min"_ns).get(),
+      nsPrintfCString("%d", std::min(uclampMin, 100)).get());
+  }
+
+  int32_t schedtuneBoost = aBoosted && mBoostedSchedtuneBoost >= 0
+                             ? mBoostedSchedtuneBoost
+                             : mSchedtuneBoost;
+  if (mStuneCGroupProcsFd != -1 && schedtuneBoost >= 0) {
+    WriteSysFile(
+      ("/dev/stune/"_ns + mGroup + "/schedtune.boost"_ns).get(),
+      nsPrintfCString("%d", std::min(schedtuneBoost, 100)).get());
+  }
+}
+
 void PriorityClass::AddProcess(int aPid)
 {
   if (mCpuCGroupProcsFd >= 0) {
@@ -1932,6 +2382,26 @@ void PriorityClass::AddProcess(int aPid)
       HAL_ERR("Couldn't add PID %d to the %s memory control group", aPid, mGroup.get());
     }
   }
+  // A class without a cpuset or schedtune group puts the process back in the
+  // root one, so that it doesn't keep those of its previous priority.
+  if (mCpusetCGroupProcsFd >= 0) {
+    nsPrintfCString str("%d", aPid);
+
+    if (write(mCpusetCGroupProcsFd, str.get(), strlen(str.get())) < 0) {
+      HAL_ERR("Couldn't add PID %d to the %s cpuset", aPid, mGroup.get());
+    }
+  } else if (access("/dev/cpuset/cgroup.procs", W_OK) == 0) {
+    WriteSysFile("/dev/cpuset/cgroup.procs", nsPrintfCString("%d", aPid).get());
+  }
+  if (mStuneCGroupProcsFd >= 0) {
+    nsPrintfCString str("%d", aPid);
+
+    if (write(mStuneCGroupProcsFd, str.get(), strlen(str.get())) < 0) {
+      HAL_ERR("Couldn't add PID %d to the %s schedtune group", aPid, mGroup.get());
+    }
+  } else if (access("/dev/stune/cgroup.procs", W_OK) == 0) {
+    WriteSysFile("/dev/stune/cgroup.procs", nsPrintfCString("%d", aPid).get());
+  }
 }
 
 /**
@@ -1966,42 +2436,68 @@ GetPriorityClass(ProcessPriority aPriority)
   return &(*priorityClasses)[aPriority];
 }
 
-static void
-EnsureKernelLowMemKillerParamsSet()
+namespace {
+
+// The zram compression ratio the LMK thresholds were last computed with.
+double sLowMemKillerZramRatio = 1.0;
+
+/**
+ * How many times smaller the pages swapped out to zram are once compressed,
+ * from /sys/block/zram0/mm_stat. 1 when there is no zram or nothing in it
+ * yet.
+ */
+double
+ZramCompressionRatio()
 {
-  static bool kernelLowMemKillerParamsSet;
-  if (kernelLowMemKillerParamsSet) {
-    return;
+  char stat[256];
+  if (!ReadSysFile("/sys/block/zram0/mm_stat", stat, sizeof(stat))) {
+    return 1.0;
   }
-  kernelLowMemKillerParamsSet = true;
-
-  HAL_LOG("Setting kernel's low-mem killer parameters.");
+  unsigned long long origSize = 0;
+  unsigned long long comprSize = 0;
+  if (sscanf(stat, "%llu %llu", &origSize, &comprSize) != 2 || !comprSize ||
+      origSize < comprSize) {
+    return 1.0;
+  }
+  return double(origSize) / double(comprSize);
+}
 
-  // Set /sys/module/lowmemorykiller/parameters/{adj,minfree,notify_trigger}
-  // according to our prefs.  These files let us tune when the kernel kills
-  // processes when we're low on memory, and when it notifies us that we're
-  // running low on available memory.
-  //
-  // adj and minfree are both comma-separated lists of integers.  If adj="A,B"
-  // and minfree="X,Y", then the kernel will kill processes with oom_adj
-  // A or higher once we have fewer than X pages of memory free, and will kill
-  // processes with oom_adj B or higher once we have fewer than Y pages of
-  // memory free.
-  //
-  // notify_trigger is a single integer.   If we set notify_trigger=Z, then
-  // we'll get notified when there are fewer than Z pages of memory free.  (See
-  // GonkMemoryPressureMonitoring.cpp.)
+} // namespace
 
+/**
+ * Sets /sys/module/lowmemorykiller/parameters/{adj,minfree} according to our
+ * prefs. These files let us tune when the kernel kills processes when we're
+ * low on memory.
+ *
+ * adj and minfree are both comma-separated lists of integers.  If adj="A,B"
+ * and minfree="X,Y", then the kernel will kill processes with oom_adj
+ * A or higher once we have fewer than X pages of memory free, and will kill
+ * processes with oom_adj B or higher once we have fewer than Y pages of
+ * memory free.
+ *
+ * With zram, the anonymous memory of background processes can be swapped
+ * out and compressed instead, which frees more memory the better it
+ * compresses. So the background thresholds are divided by aZramRatio, down to
+ * hal.processPriorityManager.gonk.zramMinKillUnderPercent of their pref, and
+ * the kernel swaps a little longer before it kills them.
+ */
+static void
+SetKernelLowMemKillerParams(double aZramRatio)
+{
   // Build the adj and minfree strings.
   nsAutoCString adjParams;
   nsAutoCString minfreeParams;
 
   DebugOnly<int32_t> lowerBoundOfNextOomScoreAdj = OOM_SCORE_ADJ_MIN - 1;
-  DebugOnly<int32_t> lowerBoundOfNextKillUnderKB = 0;
+  int32_t lowerBoundOfNextKillUnderKB = 0;
   int32_t countOfLowmemorykillerParametersSets = 0;
 
   long page_size = sysconf(_SC_PAGESIZE);
 
+  int32_t minPercent = Preferences::GetInt(
+    "hal.processPriorityManager.gonk.zramMinKillUnderPercent", 100);
+  double scale = std::max(std::min(minPercent, 100) / 100.0, 1.0 / aZramRatio);
+
   for (int i = NUM_PROCESS_PRIORITY - 1; i >= 0; i--) {
     // The system doesn't function correctly if we're missing these prefs, so
     // crash loudly.
@@ -2023,6 +2519,12 @@ EnsureKernelLowMemKillerParamsSet()
     MOZ_ASSERT(oomScoreAdj > lowerBoundOfNextOomScoreAdj);
     MOZ_ASSERT(killUnderKB > lowerBoundOfNextKillUnderKB);
 
+    // Scaling must not break that order either.
+    if (i <= PROCESS_PRIORITY_BACKGROUND_PERCEIVABLE) {
+      killUnderKB = std::max(int32_t(killUnderKB * scale),
+                             lowerBoundOfNextKillUnderKB + 1);
+    }
+
     // The LMK in kernel only accept 6 sets of LMK parameters. See bug 914728.
     MOZ_ASSERT(countOfLowmemorykillerParametersSets < 6);
 
@@ -2045,6 +2547,26 @@ EnsureKernelLowMemKillerParamsSet()
     WriteSysFile("/sys/module/lowmemorykiller/parameters/minfree",
                  minfreeParams.get());
   }
+  sLowMemKillerZramRatio = aZramRatio;
+}
+
+static void
+EnsureKernelLowMemKillerParamsSet()
+{
+  static bool kernelLowMemKillerParamsSet;
+  if (kernelLowMemKillerParamsSet) {
+    return;
+  }
+  kernelLowMemKillerParamsSet = true;
+
+  HAL_LOG("Setting kernel's low-mem killer parameters.");
+
+  SetKernelLowMemKillerParams(ZramCompressionRatio());
+
+  // notify_trigger is a single integer.   If we set notify_trigger=Z, then
+  // we'll get notified when there are fewer than Z pages of memory free.  (See
+  // GonkMemoryPressureMonitoring.cpp.)
+  long page_size = sysconf(_SC_PAGESIZE);
 
   // Set the low-memory-notification threshold.
   int32_t lowMemNotifyThresholdKB;
@@ -2066,10 +2588,9 @@ EnsureKernelLowMemKillerParamsSet()
 }
 
 void
-SetProcessPriority(int aPid, ProcessPriority aPriority, uint32_t aLRU)
+SetProcessPriority(int aPid, ProcessPriority aPriority)
 {
-  HAL_LOG("SetProcessPriority(pid=%d, priority=%d, LRU=%u)",
-          aPid, aPriority, aLRU);
+  HAL_LOG("SetProcessPriority(pid=%d, priority=%d)", aPid, aPriority);
 
   // If this is the first time SetProcessPriority was called, set the kernel's
   // OOM parameters according to our prefs.
@@ -2084,8 +2605,6 @@ SetProcessPriority(int aPid, ProcessPriority aPriority, uint32_t aLRU)
 
   int oomScoreAdj = pc->OomScoreAdj();
 
-  RoundOomScoreAdjUpWithLRU(oomScoreAdj, aLRU);
-
   // We try the newer interface first, and fall back to the older interface
   // on failure.
   if (!WriteSysFile(nsPrintfCString("/proc/%d/oom_score_adj", aPid).get(),
@@ -2099,6 +2618,342 @@ SetProcessPriority(int aPid, ProcessPriority aPriority, uint32_t aLRU)
   pc->AddProcess(aPid);
 }
 
+namespace {
+
+StaticRefPtr<nsITimer> sBoostTimer;
+TimeStamp sBoostEnd;
+
+void
+SetForegroundBoosted(bool aBoosted)
+{
+  HAL_LOG("%s the foreground processes",
+          aBoosted ? "Boosting" : "Unboosting");
+  GetPriorityClass(PROCESS_PRIORITY_FOREGROUND)->SetBoosted(aBoosted);
+  GetPriorityClass(PROCESS_PRIORITY_FOREGROUND_HIGH)->SetBoosted(aBoosted);
+}
+
+void
+EndForegroundBoost(nsITimer* aTimer, void* aClosure)
+{
+  sBoostEnd = TimeStamp();
+  SetForegroundBoosted(false);
+}
+
+} // namespace
+
+void
+BoostForegroundProcesses(uint32_t aDurationMs)
+{
+  if (!aDurationMs) {
+    return;
+  }
+
+  // The priority classes read their prefs, so they may only be used on the
+  // main thread. Input events come from the input reader thread.
+  if (!NS_IsMainThread()) {
+    NS_DispatchToMainThread(NS_NewRunnableFunction(
+      "hal_impl::BoostForegroundProcesses",
+      [aDurationMs]() { BoostForegroundProcesses(aDurationMs); }));
+    return;
+  }
+
+  TimeStamp end =
+    TimeStamp::Now() + TimeDuration::FromMilliseconds(aDurationMs);
+  if (!sBoostEnd.IsNull() && end <= sBoostEnd) {
+    // Already boosted for long enough.
+    return;
+  }
+
+  if (!sBoostTimer) {
+    sBoostTimer = NS_NewTimer();
+    if (!sBoostTimer) {
+      return;
+    }
+    ClearOnShutdown(&sBoostTimer);
+  }
+
+  if (sBoostEnd.IsNull()) {
+    SetForegroundBoosted(true);
+  }
+  sBoostEnd = end;
+  sBoostTimer->InitWithNamedFuncCallback(EndForegroundBoost, nullptr,
+                                         aDurationMs, nsITimer::TYPE_ONE_SHOT,
+                                         "hal_impl::EndForegroundBoost");
+}
+
+namespace {
+
+using android::hardware::power::V1_0::IPower;
+using PowerHalHint = android::hardware::power::V1_0::PowerHint;
+
+/**
+ * Returns the power HAL, or null if the device doesn't have one. It is only
+ * looked up once, and kept until exit.
+ */
+IPower*
+GetPowerHal()
+{
+  static android::sp<IPower>* sPowerHal =
+    new android::sp<IPower>(IPower::getService());
+  return sPowerHal->get();
+}
+
+/**
+ * Devices without a power HAL may have a sysfs node that boosts the CPU
+ * frequency for the number of milliseconds written to it, named by the
+ * ro.b2g.perf.boost_node property.
+ */
+void
+WriteBoostNode(uint32_t aDurationMs)
+{
+  static const char* sBoostNode = []() {
+    char* node = new char[system::Property::VALUE_MAX_LENGTH];
+    system::Property::Get("ro.b2g.perf.boost_node", node, "");
+    return node;
+  }();
+  if (sBoostNode[0]) {
+    WriteSysFile(sBoostNode, nsPrintfCString("%u", aDurationMs).get());
+  }
+}
+
+StaticMutex sInteractionHintMutex;
+TimeStamp sInteractionHintEnd;
+
+// The start/stop hints, main thread only.
+StaticRefPtr<nsITimer> sPerformanceHintTimers[NUM_PERFORMANCE_HINT];
+TimeStamp sPerformanceHintEnds[NUM_PERFORMANCE_HINT];
+
+PowerHalHint
+ToPowerHalHint(PerformanceHint aHint)
+{
+  switch (aHint) {
+    case PERFORMANCE_HINT_INTERACTION:
+      return PowerHalHint::INTERACTION;
+    case PERFORMANCE_HINT_APP_LAUNCH:
+      return PowerHalHint::LAUNCH;
+    case PERFORMANCE_HINT_VIDEO_PLAYBACK:
+    default:
+      return PowerHalHint::VIDEO_DECODE;
+  }
+}
+
+void
+EndPerformanceHint(nsITimer* aTimer, void* aClosure)
+{
+  PerformanceHint hint =
+    static_cast<PerformanceHint>(reinterpret_cast<uintptr_t>(aClosure));
+  HAL_LOG("Performance hint %d over", hint);
+  sPerformanceHintEnds[hint] = TimeStamp();
+  if (IPower* power = GetPowerHal()) {
+    power->powerHint(ToPowerHalHint(hint), 0);
+  }
+}
+
+} // namespace
+
+void
+NotifyPerformanceHint(PerformanceHint aHint, uint32_t aDurationMs)
+{
+  if (!aDurationMs || aHint < 0 || aHint >= NUM_PERFORMANCE_HINT) {
+    return;
+  }
+
+  TimeStamp now = TimeStamp::Now();
+  TimeStamp end = now + TimeDuration::FromMilliseconds(aDurationMs);
+
+  // The power HAL takes the duration of interactions, so they don't need a
+  // timer and can be sent from the input and compositor threads right away.
+  if (aHint == PERFORMANCE_HINT_INTERACTION) {
+    {
+      // Touch moves and missed frames come at the frame rate, only renew the
+      // hint once half of it has run out.
+      StaticMutexAutoLock lock(sInteractionHintMutex);
+      if (!sInteractionHintEnd.IsNull() &&
+          sInteractionHintEnd - now >
+            TimeDuration::FromMilliseconds(aDurationMs / 2)) {
+        return;
+      }
+      sInteractionHintEnd = end;
+    }
+
+    if (IPower* power = GetPowerHal()) {
+      power->powerHint(PowerHalHint::INTERACTION, aDurationMs);
+    } else {
+      WriteBoostNode(aDurationMs);
+    }
+    return;
+  }
+
+  if (!NS_IsMainThread()) {
+    NS_DispatchToMainThread(NS_NewRunnableFunction(
+      "hal_impl::NotifyPerformanceHint", [aHint, aDurationMs]() {
+        NotifyPerformanceHint(aHint, aDurationMs);
+      }));
+    return;
+  }
+
+  // Launches and video playback are started and stopped.
+  if (!sPerformanceHintEnds[aHint].IsNull() &&
+      end <= sPerformanceHintEnds[aHint]) {
+    return;
+  }
+
+  StaticRefPtr<nsITimer>& timer = sPerformanceHintTimers[aHint];
+  if (!timer) {
+    timer = NS_NewTimer();
+    if (!timer) {
+      return;
+    }
+    ClearOnShutdown(&timer);
+  }
+
+  if (sPerformanceHintEnds[aHint].IsNull()) {
+    HAL_LOG("Performance hint %d for %ums", aHint, aDurationMs);
+    if (IPower* power = GetPowerHal()) {
+      power->powerHint(ToPowerHalHint(aHint), 1);
+    } else if (aHint == PERFORMANCE_HINT_APP_LAUNCH) {
+      WriteBoostNode(aDurationMs);
+    }
+  }
+  sPerformanceHintEnds[aHint] = end;
+  timer->InitWithNamedFuncCallback(
+    EndPerformanceHint, reinterpret_cast<void*>(uintptr_t(aHint)), aDurationMs,
+    nsITimer::TYPE_ONE_SHOT, "hal_impl::EndPerformanceHint");
+}
+
+namespace {
+
+#ifndef MADV_PAGEOUT
+#define MADV_PAGEOUT 21
+#endif
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
+#ifndef __NR_process_madvise
+#define __NR_process_madvise 440
+#endif
+
+bool
+HasSwap()
+{
+  // /proc/swaps has a header line, then one line per swap device.
+  static bool sHasSwap = []() {
+    ScopedClose fd(open("/proc/swaps", O_RDONLY | O_CLOEXEC));
+    char swaps[512];
+    if (fd.get() < 0) {
+      return false;
+    }
+    ssize_t length = read(fd.get(), swaps, sizeof(swaps) - 1);
+    if (length <= 0) {
+      return false;
+    }
+    swaps[length] = '\0';
+    char* header = strchr(swaps, '\n');
+    return header && header[1] != '\0';
+  }();
+  return sHasSwap;
+}
+
+/**
+ * Asks the kernel to page out the private anonymous mappings of aPid, which
+ * hold the heaps that zram compresses well. Clean file backed pages are
+ * dropped by the kernel anyway. Needs Linux 5.10, returns false when the
+ * kernel doesn't have process_madvise().
+ */
+bool
+PageOutWithProcessMadvise(int aPid)
+{
+  ScopedClose pidfd(int(syscall(__NR_pidfd_open, aPid, 0)));
+  if (pidfd.get() < 0) {
+    return false;
+  }
+
+  FILE* maps = fopen(nsPrintfCString("/proc/%d/maps", aPid).get(), "re");
+  if (!maps) {
+    return false;
+  }
+
+  static const size_t kMaxRanges = 512;
+  struct iovec ranges[kMaxRanges];
+  size_t count = 0;
+  bool supported = true;
+  auto flush = [&]() {
+    if (count && supported &&
+        syscall(__NR_process_madvise, pidfd.get(), ranges, count,
+                MADV_PAGEOUT, 0) < 0 &&
+        (errno == ENOSYS || errno == EINVAL)) {
+      supported = false;
+    }
+    count = 0;
+  };
+
+  char line[512];
+  while (supported && fgets(line, sizeof(line), maps)) {
+    unsigned long start, end, inode;
+    char perms[5];
+    int pathOffset = 0;
+    if (sscanf(line, "%lx-%lx %4s %*s %*s %lu %n", &start, &end, perms,
+               &inode, &pathOffset) < 4) {
+      continue;
+    }
+    const char* path = line + pathOffset;
+    bool anonymous = !inode && (path[0] == '\n' || path[0] == '\0' ||
+                                !strncmp(path, "[heap]", 6) ||
+                                !strncmp(path, "[anon:", 6));
+    if (!anonymous || perms[1] != 'w' || perms[3] != 'p') {
+      continue;
+    }
+    ranges[count].iov_base = reinterpret_cast<void*>(start);
+    ranges[count].iov_len = end - start;
+    if (++count == kMaxRanges) {
+      flush();
+    }
+  }
+  flush();
+  fclose(maps);
+  return supported;
+}
+
+// Updates the LMK thresholds once zram compresses noticeably better or worse
+// than when they were set.
+void
+MaybeUpdateLowMemKillerParams(double aZramRatio)
+{
+  if (fabs(aZramRatio - sLowMemKillerZramRatio) >
+      sLowMemKillerZramRatio / 10) {
+    HAL_LOG("zram compression ratio now %.2f", aZramRatio);
+    SetKernelLowMemKillerParams(aZramRatio);
+  }
+}
+
+} // namespace
+
+void
+PageOutProcess(int aPid)
+{
+  if (aPid <= 0 || !HasSwap()) {
+    return;
+  }
+
+  NS_DispatchBackgroundTask(NS_NewRunnableFunction(
+    "hal_impl::PageOutProcess", [aPid]() {
+      HAL_LOG("Paging out process %d", aPid);
+      // Kernels older than process_madvise() may have the per process
+      // reclaim of Android instead.
+      if (!PageOutWithProcessMadvise(aPid)) {
+        WriteSysFile(nsPrintfCString("/proc/%d/reclaim", aPid).get(), "anon");
+      }
+
+      // The priority classes read their prefs on the main thread.
+      double ratio = ZramCompressionRatio();
+      NS_DispatchToMainThread(NS_NewRunnableFunction(
+        "hal_impl::MaybeUpdateLowMemKillerParams",
+        [ratio]() { MaybeUpdateLowMemKillerParams(ratio); }));
+    }),
+    NS_DISPATCH_EVENT_MAY_BLOCK);
+}
+
+#if 0  // TODO: FIXME
 static bool
 IsValidRealTimePriority(int aValue, int aSchedulePolicy)
 {
@@ -15,8 +15,12 @@
  */
 
 #include "Hal.h"
+#include "HalImpl.h"
 #include "GonkSensorsHal.h"
 #include "base/task.h"
+#include "mozilla/Services.h"
+#include "nsIObserver.h"
+#include "nsIObserverService.h"
 
 using namespace mozilla::hal;
 
@@ -26,6 +30,25 @@ namespace hal_impl {
 
 static GonkSensorsHal* sSensorsHal = nullptr;
 
+// Nobody is looking at the screen while it is off, so let the sensors batch
+// their samples rather than wake the device up at the full rate.
+class ScreenStateObserver final : public nsIObserver {
+public:
+  NS_DECL_ISUPPORTS
+
+  NS_IMETHOD Observe(nsISupports* aSubject, const char* aTopic,
+                     const char16_t* aData) override {
+    MOZ_ASSERT(!strcmp(aTopic, "screen-state-changed"));
+    sSensorsHal->SetBatchingEnabled(u"off"_ns.Equals(aData));
+    return NS_OK;
+  }
+
+private:
+  ~ScreenStateObserver() {}
+};
+
+NS_IMPL_ISUPPORTS(ScreenStateObserver, nsIObserver)
+
 void
 EnableSensorNotifications(SensorType aSensor) {
   if (!sSensorsHal) {
@@ -36,6 +59,12 @@ EnableSensorNotifications(SensorType aSensor) {
   static bool isRegistered = false;
   if (!isRegistered) {
     isRegistered = sSensorsHal->RegisterSensorDataCallback(&NotifySensorChange);
+
+    nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+    if (obs) {
+      obs->AddObserver(new ScreenStateObserver(), "screen-state-changed", false);
+    }
+    sSensorsHal->SetBatchingEnabled(!GetScreenEnabled());
   }
 }
 
@@ -7,6 +7,7 @@
 
 #include "Hal.h"
 #include "HalLog.h"
+#include "nsTArray.h"
 
 #include "GonkSensorsHal.h"
 
@@ -35,6 +36,8 @@ SensorType getSensorType(hidl_sensors::SensorType aHidlSensorType) {
       return SENSOR_GAME_ROTATION_VECTOR;
     case hidl_sensors::SensorType::PRESSURE:
       return SENSOR_PRESSURE;
+    case hidl_sensors::SensorType::DEVICE_ORIENTATION:
+      return SENSOR_SCREEN_ROTATION;
     default:
       return SENSOR_UNKNOWN;
   }
@@ -44,24 +47,48 @@ namespace mozilla {
 namespace hal_impl {
 
 
+// Carries every sample read by one poll() to the main thread, so that a FIFO
+// flush costs a single wakeup of the main thread rather than one per sample.
 class GonkSensorsHal::SensorDataNotifier : public Runnable {
 public:
-  SensorDataNotifier(const SensorData aSensorData, const SensorDataCallback aCallback)
+  SensorDataNotifier(nsTArray<SensorData>&& aSensorData, const SensorDataCallback aCallback)
   : mozilla::Runnable("GonkSensors::SensorDataNotifier"),
-    mSensorData(aSensorData),
+    mSensorData(std::move(aSensorData)),
     mCallback(aCallback) {}
 
   NS_IMETHOD Run() override {
     if (mCallback) {
-      mCallback(mSensorData);
+      for (const SensorData& sensorData : mSensorData) {
+        mCallback(sensorData);
+      }
     }
     return NS_OK;
   }
 private:
-  SensorData mSensorData;
+  nsTArray<SensorData> mSensorData;
   SensorDataCallback mCallback;
 };
 
+bool
+GonkSensorsHal::ShouldDecimate(const hidl_sensors::Event& aEvent, SensorType aSensorType) {
+  // on-change sensors are never decimated
+  const int64_t samplingPeriodNs = mSamplingPeriodNs[aSensorType];
+  if (samplingPeriodNs <= 0) {
+    return false;
+  }
+
+  // The HAL is free to sample faster than requested, and a batched FIFO
+  // flush hands us all of those at once. Only pass on samples at the rate
+  // Gecko asked for, allowing some jitter in the hardware timestamps.
+  const int64_t sinceLastNs = aEvent.timestamp - mLastTimestampNs[aSensorType];
+  if (sinceLastNs >= 0 && sinceLastNs < samplingPeriodNs - samplingPeriodNs / 8) {
+    return true;
+  }
+
+  mLastTimestampNs[aSensorType] = aEvent.timestamp;
+  return false;
+}
+
 SensorData
 GonkSensorsHal::CreateSensorData(const hidl_sensors::Event aEvent) {
   AutoTArray<float, 4> values;
@@ -109,6 +136,7 @@ GonkSensorsHal::CreateSensorData(const hidl_sensors::Event aEvent) {
       values.AppendElement(aEvent.u.vec4.w);
       break;
     case SENSOR_PRESSURE:
+    case SENSOR_SCREEN_ROTATION:
       values.AppendElement(aEvent.u.scalar);
       break;
     case SENSOR_UNKNOWN:
@@ -142,18 +170,37 @@ GonkSensorsHal::StartPollingThread() {
             continue;
           }
 
-          // create sensor data and dispatch to main thread
+          // create sensor data and dispatch to main thread in one go
           const size_t count = events.size();
+          nsTArray<SensorData> sensorDataList(count);
           for (size_t i=0; i<count; i++) {
-            SensorData sensorData;
+            SensorType sensorType = getSensorType(events[i].sensorType);
+            if (sensorType == SENSOR_ACCELERATION) {
+              if (mRotationFromAccelerometer) {
+                int rotation = ProcessRotation(events[i]);
+                if (rotation >= 0) {
+                  AutoTArray<float, 1> values;
+                  values.AppendElement(rotation);
+                  sensorDataList.AppendElement(SensorData(
+                    SENSOR_SCREEN_ROTATION, events[i].timestamp, values));
+                }
+              }
+              if (!mAccelerometerRequested) {
+                continue;
+              }
+            }
 
-            sensorData = CreateSensorData(events[i]);
-            if (sensorData.sensor() == SENSOR_UNKNOWN) {
+            if (sensorType == SENSOR_UNKNOWN ||
+                ShouldDecimate(events[i], sensorType)) {
               continue;
             }
 
+            sensorDataList.AppendElement(CreateSensorData(events[i]));
+          }
+
+          if (!sensorDataList.IsEmpty()) {
             NS_DispatchToMainThread(
-              new SensorDataNotifier(sensorData, mSensorDataCallback));
+              new SensorDataNotifier(std::move(sensorDataList), mSensorDataCallback));
           }
         } while (true);
       })
@@ -247,6 +294,7 @@ GonkSensorsHal::InitSensorsList() {
         }
         break;
       case SENSOR_LIGHT:
+      case SENSOR_SCREEN_ROTATION:
         if (mode == SensorFlagBits::ON_CHANGE_MODE && !canWakeUp) {
           isValid = true;
         }
@@ -281,25 +329,61 @@ GonkSensorsHal::RegisterSensorDataCallback(const SensorDataCallback aCallback) {
   return true;
 };
 
-bool
-GonkSensorsHal::ActivateSensor(const SensorType aSensorType) {
-  if (mSensors == nullptr) {
-    return false;
+int
+GonkSensorsHal::ProcessRotation(const hidl_sensors::Event& aEvent) {
+  if (mResetRotation.exchange(false)) {
+    mProcessOrientation.Reset();
+    mLastRotation = -1;
+    mLastMotionNs = aEvent.timestamp;
   }
 
-  const int32_t handle = mSensorInfoList[aSensorType].sensorHandle;
+  // sample faster only while the device moves, since a still device keeps
+  // its orientation
+  const float delta = fabsf(aEvent.u.vec3.x - mLastAcceleration[0]) +
+                      fabsf(aEvent.u.vec3.y - mLastAcceleration[1]) +
+                      fabsf(aEvent.u.vec3.z - mLastAcceleration[2]);
+  mLastAcceleration[0] = aEvent.u.vec3.x;
+  mLastAcceleration[1] = aEvent.u.vec3.y;
+  mLastAcceleration[2] = aEvent.u.vec3.z;
+  if (delta > kRotationMotionThreshold) {
+    mLastMotionNs = aEvent.timestamp;
+  }
 
-  // check if specified sensor is supported
-  if (!handle) {
-    HAL_LOG("device unsupported sensor aSensorType=%d", aSensorType);
-    return false;
+  const int64_t samplingPeriodNs =
+    aEvent.timestamp - mLastMotionNs < kRotationSettleTimeNs ?
+      kRotationMovingSamplingPeriodNs : kRotationStillSamplingPeriodNs;
+  if (samplingPeriodNs != mRotationSamplingPeriodNs) {
+    mRotationSamplingPeriodNs = samplingPeriodNs;
+    ConfigureSensor(SENSOR_ACCELERATION);
+  }
+
+  // the last rotation we proposed stands in for the screen's, which only
+  // the main thread knows; it is only used for hysteresis
+  int rotation = mProcessOrientation.OnSensorChanged(
+    CreateSensorData(aEvent), mLastRotation < 0 ? 0 : mLastRotation);
+  if (rotation < 0 || rotation == mLastRotation) {
+    return -1;
   }
 
+  mLastRotation = rotation;
+  return rotation;
+}
+
+bool
+GonkSensorsHal::ConfigureSensor(const SensorType aSensorType) {
+  // screen rotation computed here is driven by the accelerometer
+  if (aSensorType == SENSOR_SCREEN_ROTATION && mRotationFromAccelerometer) {
+    return ConfigureSensor(SENSOR_ACCELERATION);
+  }
+
+  const hidl_sensors::SensorInfo& sensorInfo = mSensorInfoList[aSensorType];
+
   int64_t samplingPeriodNs;
   switch (aSensorType) {
     // no sampling period for on-change sensors
     case SENSOR_PROXIMITY:
     case SENSOR_LIGHT:
+    case SENSOR_SCREEN_ROTATION:
       samplingPeriodNs = 0;
       break;
     // specific sampling period for pressure sensor
@@ -318,23 +402,80 @@ GonkSensorsHal::ActivateSensor(const SensorType aSensorType) {
       break;
   }
 
-  int64_t minDelayNs = mSensorInfoList[aSensorType].minDelay * 1000;
+  int64_t minDelayNs = sensorInfo.minDelay * 1000;
   if (samplingPeriodNs < minDelayNs) {
     samplingPeriodNs = minDelayNs;
   }
 
+  // screen rotation may want the accelerometer faster than its own
+  // observers, who still get samples decimated to their rate below
+  int64_t hardwarePeriodNs = samplingPeriodNs;
+  if (aSensorType == SENSOR_ACCELERATION && mRotationFromAccelerometer) {
+    const int64_t rotationPeriodNs = mRotationSamplingPeriodNs;
+    if (rotationPeriodNs < hardwarePeriodNs) {
+      hardwarePeriodNs = rotationPeriodNs < minDelayNs ? minDelayNs
+                                                       : rotationPeriodNs;
+    }
+  }
+
+  // only continuous sensors with a hardware FIFO are worth batching; the
+  // proximity sensor has to keep waking us up for calls
+  int64_t reportLatencyNs = kReportLatencyNs;
+  if (mBatchingEnabled && samplingPeriodNs > 0 &&
+      sensorInfo.fifoMaxEventCount > 0) {
+    reportLatencyNs = kBatchedReportLatencyNs;
+  }
+
   // config sampling period and reporting latency to specified sensor
-  if (!mSensors->batch(handle, samplingPeriodNs, kReportLatencyNs).isOk()) {
+  if (!mSensors->batch(sensorInfo.sensorHandle, hardwarePeriodNs, reportLatencyNs).isOk()) {
     HAL_ERR("sensors batch failed aSensorType=%d", aSensorType);
     return false;
   }
 
+  mSamplingPeriodNs[aSensorType] = samplingPeriodNs;
+  return true;
+}
+
+bool
+GonkSensorsHal::ActivateSensor(const SensorType aSensorType) {
+  if (mSensors == nullptr) {
+    return false;
+  }
+
+  const int32_t handle = mSensorInfoList[aSensorType].sensorHandle;
+
+  // fall back on the accelerometer when the HAL has no device orientation
+  if (aSensorType == SENSOR_SCREEN_ROTATION && !handle) {
+    return ActivateRotationFallback();
+  }
+
+  // already running for screen rotation; only its rate needs updating
+  if (aSensorType == SENSOR_ACCELERATION && mRotationFromAccelerometer) {
+    mAccelerometerRequested = true;
+    mSensorActive[aSensorType] = true;
+    return ConfigureSensor(aSensorType);
+  }
+
+  // check if specified sensor is supported
+  if (!handle) {
+    HAL_LOG("device unsupported sensor aSensorType=%d", aSensorType);
+    return false;
+  }
+
+  if (!ConfigureSensor(aSensorType)) {
+    return false;
+  }
+
   // activate specified sensor
   if (!mSensors->activate(handle, true).isOk()) {
     HAL_ERR("sensors activate failed aSensorType=%d", aSensorType);
     return false;
   }
 
+  if (aSensorType == SENSOR_ACCELERATION) {
+    mAccelerometerRequested = true;
+  }
+  mSensorActive[aSensorType] = true;
   return true;
 }
 
@@ -346,6 +487,17 @@ GonkSensorsHal::DeactivateSensor(const SensorType aSensorType) {
 
   const int32_t handle = mSensorInfoList[aSensorType].sensorHandle;
 
+  if (aSensorType == SENSOR_SCREEN_ROTATION && mRotationFromAccelerometer) {
+    return DeactivateRotationFallback();
+  }
+
+  // keep the accelerometer running for screen rotation, at its rate
+  if (aSensorType == SENSOR_ACCELERATION && mRotationFromAccelerometer) {
+    mAccelerometerRequested = false;
+    mSensorActive[aSensorType] = false;
+    return ConfigureSensor(aSensorType);
+  }
+
   // check if specified sensor is supported
   if (!handle) {
     HAL_LOG("device unsupported sensor aSensorType=%d", aSensorType);
@@ -358,9 +510,80 @@ GonkSensorsHal::DeactivateSensor(const SensorType aSensorType) {
     return false;
   }
 
+  if (aSensorType == SENSOR_ACCELERATION) {
+    mAccelerometerRequested = false;
+  }
+  mSensorActive[aSensorType] = false;
+  return true;
+}
+
+bool
+GonkSensorsHal::ActivateRotationFallback() {
+  const int32_t handle = mSensorInfoList[SENSOR_ACCELERATION].sensorHandle;
+  if (!handle) {
+    HAL_LOG("device unsupported sensor aSensorType=%d", SENSOR_SCREEN_ROTATION);
+    return false;
+  }
+
+  // the polling thread resets orientation detection on the next sample
+  mRotationSamplingPeriodNs = kRotationStillSamplingPeriodNs;
+  mResetRotation = true;
+  mRotationFromAccelerometer = true;
+
+  if (!ConfigureSensor(SENSOR_ACCELERATION) ||
+      (!mSensorActive[SENSOR_ACCELERATION] &&
+       !mSensors->activate(handle, true).isOk())) {
+    HAL_ERR("sensors activate failed aSensorType=%d", SENSOR_SCREEN_ROTATION);
+    mRotationFromAccelerometer = false;
+    return false;
+  }
+
+  mSensorActive[SENSOR_SCREEN_ROTATION] = true;
   return true;
 }
 
+bool
+GonkSensorsHal::DeactivateRotationFallback() {
+  const int32_t handle = mSensorInfoList[SENSOR_ACCELERATION].sensorHandle;
+
+  mRotationFromAccelerometer = false;
+  mSensorActive[SENSOR_SCREEN_ROTATION] = false;
+
+  // restore the rate of the accelerometer's own observers, if any
+  if (mSensorActive[SENSOR_ACCELERATION]) {
+    return ConfigureSensor(SENSOR_ACCELERATION);
+  }
+
+  if (!mSensors->activate(handle, false).isOk()) {
+    HAL_ERR("sensors deactivate failed aSensorType=%d", SENSOR_SCREEN_ROTATION);
+    return false;
+  }
+  return true;
+}
+
+void
+GonkSensorsHal::SetBatchingEnabled(bool aEnabled) {
+  if (mSensors == nullptr || mBatchingEnabled == aEnabled) {
+    return;
+  }
+
+  mBatchingEnabled = aEnabled;
+  HAL_LOG("sensors batching %s", aEnabled ? "enabled" : "disabled");
+
+  // batch() may be called on an active sensor and takes effect right away;
+  // leaving batching flushes the FIFO so nothing is delivered late
+  for (int i = 0; i < NUM_SENSOR_TYPE; i++) {
+    if (!mSensorActive[i]) {
+      continue;
+    }
+    SensorType sensorType = static_cast<SensorType>(i);
+    if (ConfigureSensor(sensorType) && !aEnabled &&
+        mSensorInfoList[i].fifoMaxEventCount > 0) {
+      mSensors->flush(mSensorInfoList[i].sensorHandle);
+    }
+  }
+}
+
 
 } // hal_impl
 } // mozilla
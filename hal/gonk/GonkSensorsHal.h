@@ -7,6 +7,8 @@
 
 #include "base/thread.h"
 #include "HalSensor.h"
+#include "ProcessOrientation.h"
+#include "mozilla/Atomics.h"
 
 #include "android/hardware/sensors/1.0/types.h"
 #include "android_sensors/ISensorsWrapper.h"
@@ -34,6 +36,9 @@ public:
   bool RegisterSensorDataCallback(const SensorDataCallback aCallback);
   bool ActivateSensor(const SensorType aSensorType);
   bool DeactivateSensor(const SensorType aSensorType);
+  // Let continuous sensors queue samples in the hardware FIFO instead of
+  // waking us up for each one, e.g. while the screen is off.
+  void SetBatchingEnabled(bool aEnabled);
 private:
   class SensorDataNotifier;
 
@@ -42,8 +47,18 @@ private:
   GonkSensorsHal()
     : mSensors(nullptr),
       mPollingThread(nullptr),
-      mSensorDataCallback(nullptr) {
+      mSensorDataCallback(nullptr),
+      mBatchingEnabled(false),
+      mAccelerometerRequested(false),
+      mRotationFromAccelerometer(false),
+      mResetRotation(false),
+      mRotationSamplingPeriodNs(kRotationStillSamplingPeriodNs),
+      mLastRotation(-1),
+      mLastMotionNs(0) {
         memset(mSensorInfoList, 0, sizeof(mSensorInfoList));
+        memset(mSensorActive, 0, sizeof(mSensorActive));
+        memset(mLastTimestampNs, 0, sizeof(mLastTimestampNs));
+        memset(mLastAcceleration, 0, sizeof(mLastAcceleration));
         Init();
   };
   ~GonkSensorsHal() {};
@@ -53,16 +68,56 @@ private:
   bool InitHidlServiceV1_0(android::sp<V1_0::ISensors> aServiceV1_0);
   bool InitSensorsList();
   void StartPollingThread();
+  bool ConfigureSensor(const SensorType aSensorType);
+  bool ShouldDecimate(const hidl_sensors::Event& aEvent, SensorType aSensorType);
   SensorData CreateSensorData(const hidl_sensors::Event aEvent);
+  bool ActivateRotationFallback();
+  bool DeactivateRotationFallback();
+  int ProcessRotation(const hidl_sensors::Event& aEvent);
 
   android::sp<ISensorsWrapper> mSensors;
   hidl_sensors::SensorInfo mSensorInfoList[NUM_SENSOR_TYPE];
   base::Thread* mPollingThread;
   SensorDataCallback mSensorDataCallback;
 
+  // main thread only
+  bool mSensorActive[NUM_SENSOR_TYPE];
+
+  // written on main thread, read on polling thread when it reconfigures the
+  // accelerometer for screen rotation
+  Atomic<bool> mBatchingEnabled;
+  // whether the accelerometer was activated for its own samples, rather than
+  // only on behalf of screen rotation
+  Atomic<bool> mAccelerometerRequested;
+
+  // Without a device orientation sensor in the HAL, screen rotation is worked
+  // out from the accelerometer on the polling thread, and only a change of
+  // rotation is sent to the main thread.
+  Atomic<bool> mRotationFromAccelerometer;
+  Atomic<bool> mResetRotation;
+  Atomic<int64_t> mRotationSamplingPeriodNs;
+  // polling thread only
+  ProcessOrientation mProcessOrientation;
+  int mLastRotation;
+  int64_t mLastMotionNs;
+  float mLastAcceleration[3];
+
+  // written on main thread, read on polling thread for decimation
+  Atomic<int64_t> mSamplingPeriodNs[NUM_SENSOR_TYPE];
+  // polling thread only
+  int64_t mLastTimestampNs[NUM_SENSOR_TYPE];
+
   const int64_t kDefaultSamplingPeriodNs = 200000000;
   const int64_t kPressureSamplingPeriodNs = 1000000000;
   const int64_t kReportLatencyNs = 0;
+  const int64_t kBatchedReportLatencyNs = 1000000000;
+  // The accelerometer feeds screen rotation at a low rate while the device
+  // is still, and faster while it moves and the rotation may change.
+  static const int64_t kRotationStillSamplingPeriodNs = 200000000;
+  static const int64_t kRotationMovingSamplingPeriodNs = 66000000;
+  static const int64_t kRotationSettleTimeNs = 1000000000;
+  // Change of acceleration, in m/s^2, between two samples taken as motion.
+  static constexpr float kRotationMotionThreshold = 1.0f;
 };
 
 GonkSensorsHal* GonkSensorsHal::sInstance = nullptr;
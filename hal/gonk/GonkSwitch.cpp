@@ -341,7 +341,9 @@ static RefPtr<SwitchEventObserver> sSwitchObserver;
 static void InitializeResourceIfNeed() {
   if (!sSwitchObserver) {
     sSwitchObserver = new SwitchEventObserver();
-    RegisterUeventListener(sSwitchObserver);
+    // The subsystems returned by the SwitchHandler::GetSubsystem overrides.
+    RegisterUeventListener(sSwitchObserver, "switch");
+    RegisterUeventListener(sSwitchObserver, "android_usb");
   }
 }
 
@@ -35,6 +35,9 @@
 #include "mozilla/ClearOnShutdown.h"
 #include "mozilla/FileUtils.h"
 #include "mozilla/Monitor.h"
+#include "mozilla/UniquePtr.h"
+#include "nsString.h"
+#include "nsTArray.h"
 #include "nsThreadUtils.h"
 #include "nsXULAppAPI.h"
 
@@ -47,11 +50,47 @@ namespace hal_impl {
 
 static void ShutdownUevent();
 
+// Finds the SUBSYSTEM of a kernel uevent in place. A kernel uevent is
+// "action@devpath" followed by NUL separated KEY=value pairs.
+static bool FindUeventSubsystem(const char* aBuffer, size_t aLength,
+                                nsDependentCSubstring& aSubsystem) {
+  static const char kKey[] = "SUBSYSTEM=";
+  static const size_t kKeyLength = sizeof(kKey) - 1;
+
+  const char* end = aBuffer + aLength;
+  for (const char* entry = aBuffer; entry < end;) {
+    const char* entryEnd =
+        static_cast<const char*>(memchr(entry, '\0', end - entry));
+    if (!entryEnd) {
+      entryEnd = end;
+    }
+    if (size_t(entryEnd - entry) > kKeyLength &&
+        !memcmp(entry, kKey, kKeyLength)) {
+      aSubsystem.Rebind(entry + kKeyLength, entryEnd);
+      return true;
+    }
+    entry = entryEnd + 1;
+  }
+  return false;
+}
+
 class NetlinkPoller : public MessageLoopForIO::Watcher {
  public:
-  NetlinkPoller() : mSocket(-1), mIOLoop(MessageLoopForIO::current()) {}
-
-  virtual ~NetlinkPoller() {}
+  NetlinkPoller()
+      : mSocket(-1),
+        mIOLoop(MessageLoopForIO::current()),
+        mReceived(0),
+        mUnmatched(0) {}
+
+  virtual ~NetlinkPoller() {
+    HAL_LOG("Uevents received: %u, without listener subsystem: %u", mReceived,
+            mUnmatched);
+    for (const auto& subsystem : mSubsystems) {
+      HAL_LOG("Uevents received for %s: %u (%u dispatched)",
+              subsystem->mName.get(), subsystem->mReceived,
+              subsystem->mDispatched);
+    }
+  }
 
   bool OpenSocket();
 
@@ -63,13 +102,28 @@ class NetlinkPoller : public MessageLoopForIO::Watcher {
   }
 
   MessageLoopForIO* GetIOLoop() const { return mIOLoop; }
-  void RegisterObserver(IUeventObserver* aObserver) {
-    mUeventObserverList.AddObserver(aObserver);
+  void RegisterObserver(IUeventObserver* aObserver, const char* aSubsystem) {
+    if (!aSubsystem) {
+      mUeventObserverList.AddObserver(aObserver);
+      return;
+    }
+
+    nsDependentCString name(aSubsystem);
+    Subsystem* subsystem = FindSubsystem(name);
+    if (!subsystem) {
+      subsystem = mSubsystems.AppendElement(MakeUnique<Subsystem>(name))->get();
+    }
+    subsystem->mObservers.AddObserver(aObserver);
   }
 
   void UnregisterObserver(IUeventObserver* aObserver) {
     mUeventObserverList.RemoveObserver(aObserver);
-    if (mUeventObserverList.Length() == 0) {
+    uint32_t count = mUeventObserverList.Length();
+    for (const auto& subsystem : mSubsystems) {
+      subsystem->mObservers.RemoveObserver(aObserver);
+      count += subsystem->mObservers.Length();
+    }
+    if (count == 0) {
       ShutdownUevent();  // this will destroy self
     }
   }
@@ -83,7 +137,33 @@ class NetlinkPoller : public MessageLoopForIO::Watcher {
   uint8_t mBuffer[kBuffsize];
 
   typedef ObserverList<NetlinkEvent> UeventObserverList;
+
+  // The observers of one subsystem. Entries are kept once created, there are
+  // only a handful of subsystems anybody listens to.
+  struct Subsystem {
+    explicit Subsystem(const nsACString& aName)
+        : mName(aName), mReceived(0), mDispatched(0) {}
+
+    nsCString mName;
+    UeventObserverList mObservers;
+    uint32_t mReceived;
+    uint32_t mDispatched;
+  };
+
+  Subsystem* FindSubsystem(const nsACString& aName) {
+    for (const auto& subsystem : mSubsystems) {
+      if (subsystem->mName.Equals(aName)) {
+        return subsystem.get();
+      }
+    }
+    return nullptr;
+  }
+
+  // Observers of every uevent.
   UeventObserverList mUeventObserverList;
+  nsTArray<UniquePtr<Subsystem>> mSubsystems;
+  uint32_t mReceived;
+  uint32_t mUnmatched;
 };
 
 bool NetlinkPoller::OpenSocket() {
@@ -188,8 +268,34 @@ void NetlinkPoller::OnFileCanReadWithoutBlocking(int fd) {
       // fatal error on netlink socket which should not happen
       _exit(1);
     }
+
+    // Look up the listeners before decoding, which allocates every
+    // parameter, so that uevents nobody listens to cost no allocation.
+    mReceived++;
+    const char* buffer = reinterpret_cast<const char*>(mBuffer);
+    nsDependentCSubstring name;
+    Subsystem* subsystem = nullptr;
+    if (FindUeventSubsystem(buffer, ret, name)) {
+      subsystem = FindSubsystem(name);
+    }
+    if (subsystem) {
+      subsystem->mReceived++;
+    } else {
+      mUnmatched++;
+    }
+
+    bool hasSubsystemObservers =
+        subsystem && subsystem->mObservers.Length() > 0;
+    if (!hasSubsystemObservers && mUeventObserverList.Length() == 0) {
+      continue;
+    }
+
     NetlinkEvent netlinkEvent;
     netlinkEvent.decode(reinterpret_cast<char*>(mBuffer), ret);
+    if (hasSubsystemObservers) {
+      subsystem->mDispatched++;
+      subsystem->mObservers.Broadcast(netlinkEvent);
+    }
     mUeventObserverList.Broadcast(netlinkEvent);
   }
 }
@@ -264,7 +370,8 @@ static void InitializeUevent() {
 
 static void ShutdownUevent() { sPoller = nullptr; }
 
-void RegisterUeventListener(IUeventObserver* aObserver) {
+void RegisterUeventListener(IUeventObserver* aObserver,
+                            const char* aSubsystem) {
   MOZ_ASSERT(MessageLoop::current() == XRE_GetIOMessageLoop());
 
   if (sShutdown) {
@@ -274,7 +381,7 @@ void RegisterUeventListener(IUeventObserver* aObserver) {
   if (!sPoller) {
     InitializeUevent();
   }
-  sPoller->RegisterObserver(aObserver);
+  sPoller->RegisterObserver(aObserver, aSubsystem);
 }
 
 void UnregisterUeventListener(IUeventObserver* aObserver) {
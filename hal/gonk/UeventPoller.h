@@ -32,13 +32,18 @@ typedef mozilla::Observer<NetlinkEvent> IUeventObserver;
  * <b> IO Thread </b>
  * @aObserver the observer to be added. The observer's Notify() is only called
  * on the <b> IO Thread </b>
+ * @aSubsystem if given, the observer only gets the uevents whose SUBSYSTEM is
+ * aSubsystem. Uevents nobody listens to are dropped without being decoded.
+ * An observer may be registered for several subsystems.
  */
-void RegisterUeventListener(IUeventObserver* aObserver);
+void RegisterUeventListener(IUeventObserver* aObserver,
+                            const char* aSubsystem = nullptr);
 
 /**
  * Unregister for uevent notification. Note that the method should run on the
  * <b> IO Thread </b>
- * @aObserver the observer to be removed
+ * @aObserver the observer to be removed, from every subsystem it was
+ * registered for
  */
 void UnregisterUeventListener(IUeventObserver* aObserver);
 
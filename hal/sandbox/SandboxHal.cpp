@@ -248,6 +248,18 @@ void SetProcessPriority(int aPid, ProcessPriority aPriority) {
   MOZ_CRASH("Only the main process may set processes' priorities.");
 }
 
+void BoostForegroundProcesses(uint32_t aDurationMs) {
+  MOZ_CRASH("Only the main process may boost processes.");
+}
+
+void NotifyPerformanceHint(PerformanceHint aHint, uint32_t aDurationMs) {
+  MOZ_CRASH("Only the main process may send performance hints.");
+}
+
+void PageOutProcess(int aPid) {
+  MOZ_CRASH("Only the main process may page processes out.");
+}
+
 bool IsHeadphoneEventFromInputDev() {
   MOZ_CRASH(
       "IsHeadphoneEventFromInputDev() cannot be called from sandboxed "
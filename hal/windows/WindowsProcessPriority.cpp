@@ -33,5 +33,13 @@ void SetProcessPriority(int aPid, ProcessPriority aPriority) {
   }
 }
 
+void BoostForegroundProcesses(uint32_t aDurationMs) {
+  // The Windows scheduler already boosts the foreground window's process.
+}
+
+void NotifyPerformanceHint(PerformanceHint aHint, uint32_t aDurationMs) {}
+
+void PageOutProcess(int aPid) {}
+
 }  // namespace hal_impl
 }  // namespace mozilla
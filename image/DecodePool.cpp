@@ -9,6 +9,7 @@
 
 #include "mozilla/ClearOnShutdown.h"
 #include "mozilla/DebugOnly.h"
+#include "mozilla/HalTypes.h"
 #include "mozilla/Monitor.h"
 #include "mozilla/ProfilerLabels.h"
 #include "mozilla/SchedulerGroup.h"
@@ -18,9 +19,11 @@
 #include "mozilla/TimeStamp.h"
 #include "nsCOMPtr.h"
 #include "nsIObserverService.h"
+#include "nsIPropertyBag2.h"
 #include "nsThreadManager.h"
 #include "nsThreadUtils.h"
 #include "nsXPCOMCIDInternal.h"
+#include "nsXULAppAPI.h"
 #include "prsystem.h"
 
 #include "Decoder.h"
@@ -85,7 +88,7 @@ class IOThreadIniter final : public Runnable {
 };
 #endif
 
-DecodePool::DecodePool() : mMutex("image::IOThread") {
+DecodePool::DecodePool() : mInBackground(false), mMutex("image::IOThread") {
   // Initialize the I/O thread.
 #if defined(XP_WIN)
   // On Windows we use the io thread to get icons from the system. Any thread
@@ -105,6 +108,9 @@ DecodePool::DecodePool() : mMutex("image::IOThread") {
   nsCOMPtr<nsIObserverService> obsSvc = services::GetObserverService();
   if (obsSvc) {
     obsSvc->AddObserver(this, "xpcom-shutdown-threads", false);
+    if (XRE_IsContentProcess()) {
+      obsSvc->AddObserver(this, "ipc:process-priority-changed", false);
+    }
   }
 }
 
@@ -113,7 +119,19 @@ DecodePool::~DecodePool() {
 }
 
 NS_IMETHODIMP
-DecodePool::Observe(nsISupports*, const char* aTopic, const char16_t*) {
+DecodePool::Observe(nsISupports* aSubject, const char* aTopic,
+                    const char16_t*) {
+  if (strcmp(aTopic, "ipc:process-priority-changed") == 0) {
+    nsCOMPtr<nsIPropertyBag2> props = do_QueryInterface(aSubject);
+    int32_t priority = hal::PROCESS_PRIORITY_UNKNOWN;
+    if (props) {
+      props->GetPropertyAsInt32(u"priority"_ns, &priority);
+    }
+    mInBackground = priority == hal::PROCESS_PRIORITY_BACKGROUND ||
+                    priority == hal::PROCESS_PRIORITY_BACKGROUND_PERCEIVABLE;
+    return NS_OK;
+  }
+
   MOZ_ASSERT(strcmp(aTopic, "xpcom-shutdown-threads") == 0, "Unexpected topic");
 
   mShuttingDown = true;
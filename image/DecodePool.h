@@ -10,6 +10,7 @@
 #ifndef mozilla_image_DecodePool_h
 #define mozilla_image_DecodePool_h
 
+#include "mozilla/Atomics.h"
 #include "mozilla/Mutex.h"
 #include "mozilla/StaticPtr.h"
 #include "nsCOMArray.h"
@@ -58,6 +59,10 @@ class DecodePool final : public nsIObserver {
   /// threads from the pool to check if they should keep working or not.
   bool IsShuttingDown() const;
 
+  /// True if this is a content process that has been sent to the background,
+  /// in which case none of its images are on screen.
+  bool IsInBackground() const { return mInBackground; }
+
   /// Ask the DecodePool to run @aTask asynchronously and return immediately.
   void AsyncRun(IDecodingTask* aTask);
 
@@ -96,6 +101,7 @@ class DecodePool final : public nsIObserver {
   static StaticRefPtr<DecodePool> sSingleton;
   static uint32_t sNumCores;
   bool mShuttingDown = false;
+  Atomic<bool, Relaxed> mInBackground;
 
   // mMutex protects mIOThread.
   Mutex mMutex;
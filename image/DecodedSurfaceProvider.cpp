@@ -6,9 +6,12 @@
 #include "DecodedSurfaceProvider.h"
 
 #include "mozilla/StaticPrefs_image.h"
+#include "mozilla/Unused.h"
 #include "nsProxyRelease.h"
 
 #include "Decoder.h"
+#include "DecodePool.h"
+#include "RasterImage.h"
 
 using namespace mozilla::gfx;
 
@@ -22,7 +25,13 @@ DecodedSurfaceProvider::DecodedSurfaceProvider(NotNull<RasterImage*> aImage,
                        AvailabilityState::StartAsPlaceholder()),
       mImage(aImage.get()),
       mMutex("mozilla::image::DecodedSurfaceProvider"),
-      mDecoder(aDecoder.get()) {
+      mDecoder(aDecoder.get()),
+      mPriority(StaticPrefs::image_decode_prioritize_visible() &&
+                        aImage->HasLocks() &&
+                        !DecodePool::Singleton()->IsInBackground()
+                    ? TaskPriority::eHigh
+                    : TaskPriority::eLow),
+      mLockGeneration(aImage->LockGeneration()) {
   MOZ_ASSERT(!mDecoder->IsMetadataDecode(),
              "Use MetadataDecodingTask for metadata decodes");
   MOZ_ASSERT(mDecoder->IsFirstFrameDecode(),
@@ -119,6 +128,11 @@ void DecodedSurfaceProvider::Run() {
     return;
   }
 
+  if (ShouldCancel()) {
+    CancelDecoding();
+    return;
+  }
+
   // Run the decoder.
   LexerResult result = mDecoder->Decode(WrapNotNull(this));
 
@@ -200,6 +214,40 @@ void DecodedSurfaceProvider::FinishDecoding() {
   DropImageReference();
 }
 
+bool DecodedSurfaceProvider::ShouldCancel() const {
+  mMutex.AssertCurrentThreadOwns();
+
+  // Only decodes requested while the image was visible are given up on once
+  // it scrolls away; anything else was asked for on purpose (canvas
+  // drawImage(), img.decode(), ...) by someone who may be waiting for it.
+  bool wasLocked = mLockGeneration % 2 == 1;
+  if (!wasLocked || !StaticPrefs::image_decode_cancel_offscreen()) {
+    return false;
+  }
+
+  // If the image has been locked again since, it's back in view and a paint
+  // may already be waiting for our placeholder.
+  uint32_t generation = mImage->LockGeneration();
+  return generation != mLockGeneration && generation % 2 == 0;
+}
+
+void DecodedSurfaceProvider::CancelDecoding() {
+  mMutex.AssertCurrentThreadOwns();
+  MOZ_ASSERT(mImage);
+  MOZ_ASSERT(mDecoder);
+
+  // Take our entry, placeholder or partial surface, out of the surface cache
+  // so that the image starts a new decode when it becomes visible again.
+  SurfaceCache::RemoveSurface(WrapNotNull(this));
+
+  // Nobody is going to draw what we've decoded so far.
+  Unused << mDecoder->TakeProgress();
+  Unused << mDecoder->TakeInvalidRect();
+
+  mDecoder = nullptr;
+  DropImageReference();
+}
+
 bool DecodedSurfaceProvider::ShouldPreferSyncRun() const {
   return mDecoder->ShouldSyncDecode(
       StaticPrefs::image_mem_decode_bytes_at_a_time_AtStartup());
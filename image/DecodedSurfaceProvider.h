@@ -52,8 +52,10 @@ class DecodedSurfaceProvider final : public ISurfaceProvider,
   bool ShouldPreferSyncRun() const override;
 
   // Full decodes are low priority compared to metadata decodes because they
-  // don't block layout or page load.
-  TaskPriority Priority() const override { return TaskPriority::eLow; }
+  // don't block layout or page load. The exception is an image that is on
+  // screen (locked) in a foreground process, since that's what the user is
+  // waiting for.
+  TaskPriority Priority() const override { return mPriority; }
 
  private:
   virtual ~DecodedSurfaceProvider();
@@ -61,6 +63,8 @@ class DecodedSurfaceProvider final : public ISurfaceProvider,
   void DropImageReference();
   void CheckForNewSurface();
   void FinishDecoding();
+  bool ShouldCancel() const;
+  void CancelDecoding();
 
   /// The image associated with our decoder. Dropped after decoding.
   RefPtr<RasterImage> mImage;
@@ -76,6 +80,12 @@ class DecodedSurfaceProvider final : public ISurfaceProvider,
 
   /// A drawable reference to our service; used for locking.
   DrawableFrameRef mLockRef;
+
+  /// Whether the image was visible when this decode was requested.
+  const TaskPriority mPriority;
+
+  /// The image's lock generation when this decode was requested.
+  const uint32_t mLockGeneration;
 };
 
 }  // namespace image
@@ -72,6 +72,7 @@ RasterImage::RasterImage(nsIURI* aURI /* = nullptr */)
     : ImageResource(aURI),  // invoke superclass's constructor
       mSize(0, 0),
       mLockCount(0),
+      mLockGeneration(0),
       mDecoderType(DecoderType::UNKNOWN),
       mDecodeCount(0),
       mRequestedSampleSize(0),
@@ -128,6 +129,7 @@ nsresult RasterImage::Init(const char* aMimeType, uint32_t aFlags) {
   // Lock this image's surfaces in the SurfaceCache if we're not discardable.
   if (!LoadDiscardable()) {
     mLockCount++;
+    mLockGeneration++;
     SurfaceCache::LockImage(ImageKey(this));
   }
 
@@ -1527,6 +1529,7 @@ RasterImage::LockImage() {
   // Lock this image's surfaces in the SurfaceCache.
   if (mLockCount == 1) {
     SurfaceCache::LockImage(ImageKey(this));
+    mLockGeneration++;
   }
 
   return NS_OK;
@@ -1554,6 +1557,7 @@ RasterImage::UnlockImage() {
   // Unlock this image's surfaces in the SurfaceCache.
   if (mLockCount == 0) {
     SurfaceCache::UnlockImage(ImageKey(this));
+    mLockGeneration++;
   }
 
   return NS_OK;
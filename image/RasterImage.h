@@ -29,6 +29,7 @@
 #include "ISurfaceProvider.h"
 #include "Orientation.h"
 #include "mozilla/AtomicBitfields.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/Attributes.h"
 #include "mozilla/Maybe.h"
 #include "mozilla/MemoryReporting.h"
@@ -192,6 +193,20 @@ class RasterImage final : public ImageResource,
   /* Triggers discarding. */
   void Discard();
 
+  /// @return true if some consumer has locked this image. Images in an active
+  /// document stay locked while they're approximately visible. Main thread
+  /// only.
+  bool HasLocks() const {
+    MOZ_ASSERT(NS_IsMainThread());
+    return mLockCount > 0;
+  }
+
+  /// Bumped each time this image becomes locked or unlocked, so it's odd
+  /// while the image is locked. Lets decoders started while the image was
+  /// visible tell that it has since left the viewport. May be called on any
+  /// thread.
+  uint32_t LockGeneration() const { return mLockGeneration; }
+
   //////////////////////////////////////////////////////////////////////////////
   // Decoder callbacks.
   //////////////////////////////////////////////////////////////////////////////
@@ -439,6 +454,7 @@ class RasterImage final : public ImageResource,
 
   // Image locking.
   uint32_t mLockCount;
+  Atomic<uint32_t, Relaxed> mLockGeneration;
 
   // The type of decoder this image needs. Computed from the MIME type in
   // Init().
@@ -23,6 +23,7 @@
 #include "mozilla/Attributes.h"
 #include "mozilla/CheckedInt.h"
 #include "mozilla/DebugOnly.h"
+#include "mozilla/HalTypes.h"
 #include "mozilla/Likely.h"
 #include "mozilla/RefPtr.h"
 #include "mozilla/StaticMutex.h"
@@ -32,9 +33,11 @@
 #include "nsExpirationTracker.h"
 #include "nsHashKeys.h"
 #include "nsIMemoryReporter.h"
+#include "nsIPropertyBag2.h"
 #include "nsRefPtrHashtable.h"
 #include "nsSize.h"
 #include "nsTArray.h"
+#include "nsXULAppAPI.h"
 #include "Orientation.h"
 #include "prsystem.h"
 
@@ -162,6 +165,9 @@ class CachedSurface {
   bool IsPlaceholder() const {
     return mProvider->Availability().IsPlaceholder();
   }
+  bool HasProvider(const ISurfaceProvider* aProvider) const {
+    return mProvider.get() == aProvider;
+  }
   bool IsDecoded() const { return !IsPlaceholder() && mProvider->IsFinished(); }
 
   ImageKey GetImageKey() const { return mProvider->GetImageKey(); }
@@ -734,10 +740,13 @@ class SurfaceCacheImpl final : public nsIMemoryReporter {
 
   SurfaceCacheImpl(uint32_t aSurfaceCacheExpirationTimeMS,
                    uint32_t aSurfaceCacheDiscardFactor,
-                   uint32_t aSurfaceCacheSize)
+                   uint32_t aSurfaceCacheSize,
+                   uint32_t aSurfaceCacheBackgroundSize)
       : mExpirationTracker(aSurfaceCacheExpirationTimeMS),
         mMemoryPressureObserver(new MemoryPressureObserver),
         mDiscardFactor(aSurfaceCacheDiscardFactor),
+        mForegroundMaxCost(aSurfaceCacheSize),
+        mBackgroundMaxCost(aSurfaceCacheBackgroundSize),
         mMaxCost(aSurfaceCacheSize),
         mAvailableCost(aSurfaceCacheSize),
         mLockedCost(0),
@@ -748,6 +757,10 @@ class SurfaceCacheImpl final : public nsIMemoryReporter {
     nsCOMPtr<nsIObserverService> os = services::GetObserverService();
     if (os) {
       os->AddObserver(mMemoryPressureObserver, "memory-pressure", false);
+      if (mBackgroundMaxCost && XRE_IsContentProcess()) {
+        os->AddObserver(mMemoryPressureObserver,
+                        "ipc:process-priority-changed", false);
+      }
     }
   }
 
@@ -756,6 +769,10 @@ class SurfaceCacheImpl final : public nsIMemoryReporter {
     nsCOMPtr<nsIObserverService> os = services::GetObserverService();
     if (os) {
       os->RemoveObserver(mMemoryPressureObserver, "memory-pressure");
+      if (mBackgroundMaxCost && XRE_IsContentProcess()) {
+        os->RemoveObserver(mMemoryPressureObserver,
+                           "ipc:process-priority-changed");
+      }
     }
 
     UnregisterWeakMemoryReporter(this);
@@ -1094,6 +1111,23 @@ class SurfaceCacheImpl final : public nsIMemoryReporter {
                      aAutoLock);
   }
 
+  void RemoveSurface(NotNull<ISurfaceProvider*> aProvider,
+                     const StaticMutexAutoLock& aAutoLock) {
+    RefPtr<ImageSurfaceCache> cache = GetImageCache(aProvider->GetImageKey());
+    if (!cache) {
+      return;  // No cached surfaces for this image, so nothing to do.
+    }
+
+    // The entry for this key may already belong to a newer provider.
+    RefPtr<CachedSurface> surface =
+        cache->Lookup(aProvider->GetSurfaceKey(), /* aForAccess = */ false);
+    if (!surface || !surface->HasProvider(aProvider)) {
+      return;
+    }
+
+    Remove(WrapNotNull(surface), /* aStopTracking */ true, aAutoLock);
+  }
+
   already_AddRefed<ImageSurfaceCache> RemoveImage(
       const ImageKey aImageKey, const StaticMutexAutoLock& aAutoLock) {
     RefPtr<ImageSurfaceCache> cache = GetImageCache(aImageKey);
@@ -1172,6 +1206,30 @@ class SurfaceCacheImpl final : public nsIMemoryReporter {
     }
   }
 
+  void SetInBackground(bool aInBackground,
+                       const StaticMutexAutoLock& aAutoLock) {
+    const Cost targetCost = aInBackground
+                                ? min(mBackgroundMaxCost, mForegroundMaxCost)
+                                : mForegroundMaxCost;
+    if (targetCost == mMaxCost) {
+      return;
+    }
+
+    // Shrinking: discard unlocked surfaces, largest first, until the rest
+    // fits. Growing back needs nothing else; surfaces are decoded again as
+    // they're drawn.
+    while (!mCosts.IsEmpty() && mMaxCost - mAvailableCost > targetCost) {
+      Remove(mCosts.LastElement().Surface(), /* aStopTracking */ true,
+             aAutoLock);
+    }
+
+    // Locked surfaces may keep us above the target; they stay until they're
+    // unlocked and expire like anything else.
+    const Cost usedCost = mMaxCost - mAvailableCost;
+    mMaxCost = max(targetCost, usedCost);
+    mAvailableCost = mMaxCost - usedCost;
+  }
+
   void TakeDiscard(nsTArray<RefPtr<CachedSurface>>& aDiscard,
                    const StaticMutexAutoLock& aAutoLock) {
     MOZ_ASSERT(aDiscard.IsEmpty());
@@ -1239,6 +1297,12 @@ class SurfaceCacheImpl final : public nsIMemoryReporter {
       KIND_OTHER, UNITS_BYTES, (mMaxCost - mAvailableCost),
 "Estimated total memory used by the imagelib surface cache.");
 
+    MOZ_COLLECT_REPORT(
+      "imagelib-surface-cache-size-limit",
+      KIND_OTHER, UNITS_BYTES, mMaxCost,
+"Current size limit of the imagelib surface cache, which is lower while the "
+"process is in the background.");
+
     MOZ_COLLECT_REPORT(
       "imagelib-surface-cache-estimated-locked",
       KIND_OTHER, UNITS_BYTES, mLockedCost,
@@ -1471,7 +1535,7 @@ class SurfaceCacheImpl final : public nsIMemoryReporter {
    public:
     NS_DECL_ISUPPORTS
 
-    NS_IMETHOD Observe(nsISupports*, const char* aTopic,
+    NS_IMETHOD Observe(nsISupports* aSubject, const char* aTopic,
                        const char16_t*) override {
       nsTArray<RefPtr<CachedSurface>> discard;
       {
@@ -1479,6 +1543,18 @@ class SurfaceCacheImpl final : public nsIMemoryReporter {
         if (sInstance && strcmp(aTopic, "memory-pressure") == 0) {
           sInstance->DiscardForMemoryPressure(lock);
           sInstance->TakeDiscard(discard, lock);
+        } else if (sInstance &&
+                   strcmp(aTopic, "ipc:process-priority-changed") == 0) {
+          nsCOMPtr<nsIPropertyBag2> props = do_QueryInterface(aSubject);
+          int32_t priority = hal::PROCESS_PRIORITY_UNKNOWN;
+          if (props) {
+            props->GetPropertyAsInt32(u"priority"_ns, &priority);
+          }
+          sInstance->SetInBackground(
+              priority == hal::PROCESS_PRIORITY_BACKGROUND ||
+                  priority == hal::PROCESS_PRIORITY_BACKGROUND_PERCEIVABLE,
+              lock);
+          sInstance->TakeDiscard(discard, lock);
         }
       }
       return NS_OK;
@@ -1495,7 +1571,10 @@ class SurfaceCacheImpl final : public nsIMemoryReporter {
   RefPtr<MemoryPressureObserver> mMemoryPressureObserver;
   nsTArray<RefPtr<image::Image>> mReleasingImagesOnMainThread;
   const uint32_t mDiscardFactor;
-  const Cost mMaxCost;
+  const Cost mForegroundMaxCost;
+  // Zero if the cache keeps its full size in the background.
+  const Cost mBackgroundMaxCost;
+  Cost mMaxCost;
   Cost mAvailableCost;
   Cost mLockedCost;
   size_t mOverflowCount;
@@ -1563,12 +1642,19 @@ void SurfaceCache::Initialize() {
   uint32_t finalSurfaceCacheSizeBytes =
       min(surfaceCacheSizeBytes, uint64_t(UINT32_MAX));
 
+  // Maximum size of the surface cache while a content process is in the
+  // background, in kilobytes. Zero leaves the size alone.
+  uint64_t surfaceCacheBackgroundSizeKB =
+      StaticPrefs::image_mem_surfacecache_background_max_size_kb_AtStartup();
+  uint32_t finalSurfaceCacheBackgroundSizeBytes = min(
+      surfaceCacheBackgroundSizeKB * 1024, uint64_t(finalSurfaceCacheSizeBytes));
+
   // Create the surface cache singleton with the requested settings.  Note that
   // the size is a limit that the cache may not grow beyond, but we do not
   // actually allocate any storage for surfaces at this time.
-  sInstance = new SurfaceCacheImpl(surfaceCacheExpirationTimeMS,
-                                   surfaceCacheDiscardFactor,
-                                   finalSurfaceCacheSizeBytes);
+  sInstance = new SurfaceCacheImpl(
+      surfaceCacheExpirationTimeMS, surfaceCacheDiscardFactor,
+      finalSurfaceCacheSizeBytes, finalSurfaceCacheBackgroundSizeBytes);
   sInstance->InitMemoryReporter();
 }
 
@@ -1708,6 +1794,18 @@ void SurfaceCache::RemoveImage(const ImageKey aImageKey) {
   }
 }
 
+/* static */
+void SurfaceCache::RemoveSurface(NotNull<ISurfaceProvider*> aProvider) {
+  nsTArray<RefPtr<CachedSurface>> discard;
+  {
+    StaticMutexAutoLock lock(sInstanceMutex);
+    if (sInstance) {
+      sInstance->RemoveSurface(aProvider, lock);
+      sInstance->TakeDiscard(discard, lock);
+    }
+  }
+}
+
 /* static */
 void SurfaceCache::PruneImage(const ImageKey aImageKey) {
   nsTArray<RefPtr<CachedSurface>> discard;
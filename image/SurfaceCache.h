@@ -399,6 +399,15 @@ struct SurfaceCache {
    */
   static void RemoveImage(const ImageKey aImageKey);
 
+  /**
+   * Removes the cache entry (possibly a placeholder) belonging to the given
+   * provider, if it's still in the cache. Entries for the same surface that
+   * were inserted by other providers are left alone.
+   *
+   * @param aProvider  The provider whose entry should be removed.
+   */
+  static void RemoveSurface(NotNull<ISurfaceProvider*> aProvider);
+
   /**
    * Attempts to remove cache entries (including placeholders) associated with
    * the given image from the cache, assuming there is an equivalent entry that
@@ -392,7 +392,33 @@ class SurfacePipeFactory {
           }
         }
       } else {  // (colorManagement is false)
-        if (downscale) {
+        if (downscale && !premultiplyAlpha) {
+          // A pure channel swap commutes with downscaling, so do it on the
+          // (smaller) output rows instead of on every input row.
+          MOZ_ASSERT(!blendAnimation);
+          if (removeFrameRect) {
+            if (deinterlace) {
+              pipe = MakePipe(deinterlacingConfig, removeFrameRectConfig,
+                              downscalingConfig, swizzleConfig, surfaceConfig);
+            } else if (adam7Interpolate) {
+              pipe = MakePipe(interpolatingConfig, removeFrameRectConfig,
+                              downscalingConfig, swizzleConfig, surfaceConfig);
+            } else {  // (deinterlace and adam7Interpolate are false)
+              pipe = MakePipe(removeFrameRectConfig, downscalingConfig,
+                              swizzleConfig, surfaceConfig);
+            }
+          } else {  // (removeFrameRect is false)
+            if (deinterlace) {
+              pipe = MakePipe(deinterlacingConfig, downscalingConfig,
+                              swizzleConfig, surfaceConfig);
+            } else if (adam7Interpolate) {
+              pipe = MakePipe(interpolatingConfig, downscalingConfig,
+                              swizzleConfig, surfaceConfig);
+            } else {  // (deinterlace and adam7Interpolate are false)
+              pipe = MakePipe(downscalingConfig, swizzleConfig, surfaceConfig);
+            }
+          }
+        } else if (downscale) {
           MOZ_ASSERT(!blendAnimation);
           if (removeFrameRect) {
             if (deinterlace) {
@@ -24,6 +24,7 @@
 #include "gfxPlatform.h"
 #include "mozilla/EndianUtils.h"
 #include "mozilla/gfx/Types.h"
+#include "mozilla/StaticPrefs_image.h"
 #include "mozilla/Telemetry.h"
 
 extern "C" {
@@ -62,6 +63,20 @@ static qcms_profile* GetICCProfile(struct jpeg_decompress_struct& info) {
   return profile;
 }
 
+// Returns the largest IDCT scaling denominator libjpeg supports that still
+// produces at least aOutputSize pixels from an aSize image, or 1.
+static uint32_t GetDCTScaleDenom(const gfx::IntSize& aSize,
+                                 const gfx::IntSize& aOutputSize) {
+  for (uint32_t denom : {8, 4, 2}) {
+    // libjpeg rounds the scaled dimensions up.
+    if ((aSize.width + denom - 1) / denom >= uint32_t(aOutputSize.width) &&
+        (aSize.height + denom - 1) / denom >= uint32_t(aOutputSize.height)) {
+      return denom;
+    }
+  }
+  return 1;
+}
+
 METHODDEF(void) init_source(j_decompress_ptr jd);
 METHODDEF(boolean) fill_input_buffer(j_decompress_ptr jd);
 METHODDEF(void) skip_input_data(j_decompress_ptr jd, long num_bytes);
@@ -81,7 +96,8 @@ nsJPEGDecoder::nsJPEGDecoder(RasterImage* aImage,
       mProfileLength(0),
       mCMSLine(nullptr),
       mDecodeStyle(aDecodeStyle),
-      mSampleSize(0) {
+      mSampleSize(0),
+      mDCTScaleDenom(1) {
   this->mErr.pub.error_exit = nullptr;
   this->mErr.pub.emit_message = nullptr;
   this->mErr.pub.output_message = nullptr;
@@ -260,6 +276,15 @@ LexerTransition<nsJPEGDecoder::State> nsJPEGDecoder::ReadJPEGData(
         return Transition::TerminateSuccess();
       }
 
+      // When downscaling during decode, have libjpeg do as much of it as it
+      // can by scaling the IDCT, which skips most of the work for the pixels
+      // we'd throw away, and leave the remainder to the downscaling filter.
+      if (mSampleSize <= 0 && StaticPrefs::image_jpeg_dct_scaling_enabled()) {
+        mDCTScaleDenom = GetDCTScaleDenom(Size(), OutputSize());
+        mInfo.scale_num = 1;
+        mInfo.scale_denom = mDCTScaleDenom;
+      }
+
       // We're doing a full decode.
       switch (mInfo.jpeg_color_space) {
         case JCS_GRAYSCALE:
@@ -370,8 +395,15 @@ LexerTransition<nsJPEGDecoder::State> nsJPEGDecoder::ReadJPEGData(
       qcms_transform* pipeTransform =
           mInfo.out_color_space != JCS_GRAYSCALE ? mTransform : nullptr;
 
+      // If libjpeg scales the IDCT, its scanlines are smaller than the image.
+      gfx::IntSize inputSize = Size();
+      if (mDCTScaleDenom > 1) {
+        inputSize = gfx::IntSize(mInfo.output_width, mInfo.output_height);
+      }
+
       Maybe<SurfacePipe> pipe = SurfacePipeFactory::CreateSurfacePipe(
-          this, Size(), OutputSize(), FullFrame(), SurfaceFormat::OS_RGBX,
+          this, inputSize, OutputSize(),
+          gfx::IntRect(gfx::IntPoint(), inputSize), SurfaceFormat::OS_RGBX,
           SurfaceFormat::OS_RGBX, Nothing(), pipeTransform, SurfacePipeFlags());
       if (!pipe) {
         mState = JPEG_ERROR;
@@ -671,8 +703,14 @@ WriteState nsJPEGDecoder::OutputScanlines() {
 
   Maybe<SurfaceInvalidRect> invalidRect = mPipe.TakeInvalidRect();
   if (invalidRect) {
-    PostInvalidation(invalidRect->mInputSpaceRect,
-                     Some(invalidRect->mOutputSpaceRect));
+    // The pipe's input space is the IDCT scaled one, which PostInvalidation()
+    // doesn't know about.
+    gfx::IntRect inputSpaceRect = invalidRect->mInputSpaceRect;
+    if (mDCTScaleDenom > 1) {
+      inputSpaceRect.ScaleRoundOut(mDCTScaleDenom);
+      inputSpaceRect = inputSpaceRect.Intersect(FullFrame());
+    }
+    PostInvalidation(inputSpaceRect, Some(invalidRect->mOutputSpaceRect));
   }
 
   return result;
@@ -111,6 +111,10 @@ class nsJPEGDecoder : public Decoder {
   SurfacePipe mPipe;
 
   int mSampleSize;
+
+  // The IDCT scaling denominator we asked libjpeg for when downscaling during
+  // decode, or 1.
+  uint32_t mDCTScaleDenom;
 };
 
 }  // namespace mozilla::image
@@ -129,16 +129,35 @@ static void CheckDownscaleDuringDecode(const ImageTestCase& aTestCase,
     CheckDecode(testCase, mSourceBuffer);                         \
   });
 
-#define IMAGE_GTEST_BENCH_F(type, test)                            \
-  IMAGE_GTEST_BENCH_FIXTURE(ImageDecodersPerf_##type##_##test,     \
-                            Perf##test##type##TestCase)            \
-  IMAGE_GTEST_NATIVE_BENCH_F(ImageDecodersPerf_##type##_##test)    \
-  IMAGE_GTEST_DOWNSCALE_BENCH_F(ImageDecodersPerf_##type##_##test) \
-  IMAGE_GTEST_NO_COLOR_MANAGEMENT_BENCH_F(ImageDecodersPerf_##type##_##test)
-
-#define IMAGE_GTEST_BENCH_ALPHA_F(type, test) \
-  IMAGE_GTEST_BENCH_F(type, test)             \
-  IMAGE_GTEST_NO_PREMULTIPLY_BENCH_F(ImageDecodersPerf_##type##_##test)
+#define IMAGE_GTEST_DOWNSCALE_NO_COLOR_MANAGEMENT_BENCH_F(test_fixture) \
+  MOZ_GTEST_BENCH_F(test_fixture, DownscaleNoColorManagement, [this] {  \
+    ImageTestCase testCase = mTestCase;                                 \
+    testCase.mSurfaceFlags |= SurfaceFlags::NO_COLORSPACE_CONVERSION;   \
+    CheckDownscaleDuringDecode(testCase, mSourceBuffer);                \
+  });
+
+#define IMAGE_GTEST_DOWNSCALE_NO_PREMULTIPLY_BENCH_F(test_fixture)      \
+  MOZ_GTEST_BENCH_F(test_fixture, DownscaleNoPremultiplyAlpha, [this] { \
+    ImageTestCase testCase = mTestCase;                                 \
+    testCase.mSurfaceFlags |= SurfaceFlags::NO_COLORSPACE_CONVERSION |  \
+                              SurfaceFlags::NO_PREMULTIPLY_ALPHA;       \
+    CheckDownscaleDuringDecode(testCase, mSourceBuffer);                \
+  });
+
+#define IMAGE_GTEST_BENCH_F(type, test)                                      \
+  IMAGE_GTEST_BENCH_FIXTURE(ImageDecodersPerf_##type##_##test,               \
+                            Perf##test##type##TestCase)                      \
+  IMAGE_GTEST_NATIVE_BENCH_F(ImageDecodersPerf_##type##_##test)              \
+  IMAGE_GTEST_DOWNSCALE_BENCH_F(ImageDecodersPerf_##type##_##test)           \
+  IMAGE_GTEST_NO_COLOR_MANAGEMENT_BENCH_F(ImageDecodersPerf_##type##_##test) \
+  IMAGE_GTEST_DOWNSCALE_NO_COLOR_MANAGEMENT_BENCH_F(                         \
+      ImageDecodersPerf_##type##_##test)
+
+#define IMAGE_GTEST_BENCH_ALPHA_F(type, test)                           \
+  IMAGE_GTEST_BENCH_F(type, test)                                       \
+  IMAGE_GTEST_NO_PREMULTIPLY_BENCH_F(ImageDecodersPerf_##type##_##test) \
+  IMAGE_GTEST_DOWNSCALE_NO_PREMULTIPLY_BENCH_F(                         \
+      ImageDecodersPerf_##type##_##test)
 
 IMAGE_GTEST_BENCH_F(JPG, YCbCr)
 IMAGE_GTEST_BENCH_F(JPG, Cmyk)
@@ -6,6 +6,7 @@
 
 #include "DateTimeFormat.h"
 #include "nsCOMPtr.h"
+#include "mozilla/intl/ICUServiceMemory.h"
 #include "mozilla/intl/LocaleService.h"
 #include "OSPreferences.h"
 #include "mozIOSPreferences.h"
@@ -63,6 +64,8 @@ nsresult DateTimeFormat::FormatPRExplodedTime(
 nsresult DateTimeFormat::FormatDateTime(
     const PRExplodedTime* aExplodedTime,
     const DateTimeFormat::Skeleton aSkeleton, nsAString& aStringOut) {
+  AutoICUService service(ICUService::DateFormat);
+
   // set up locale data
   nsresult rv = Initialize();
   if (NS_FAILED(rv)) {
@@ -134,6 +137,8 @@ nsresult DateTimeFormat::GetCalendarSymbol(const Field aField,
                                            const Style aStyle,
                                            const PRExplodedTime* aExplodedTime,
                                            nsAString& aStringOut) {
+  AutoICUService service(ICUService::DateFormat);
+
   nsresult rv = Initialize();
   if (NS_FAILED(rv)) {
     return rv;
@@ -211,6 +216,8 @@ nsresult DateTimeFormat::FormatUDateTime(
     const nsDateFormatSelector aDateFormatSelector,
     const nsTimeFormatSelector aTimeFormatSelector, const UDate aUDateTime,
     const PRTimeParameters* aTimeParameters, nsAString& aStringOut) {
+  AutoICUService service(ICUService::DateFormat);
+
   int32_t dateTimeLen = 0;
   nsresult rv = NS_OK;
 
@@ -354,6 +361,7 @@ void DateTimeFormat::BuildTimeZoneString(
 /*static*/
 void DateTimeFormat::DeleteCache() {
   if (mFormatCache) {
+    AutoICUService service(ICUService::DateFormat);
     for (const auto& entry : mFormatCache->Values()) {
       udat_close(entry);
     }
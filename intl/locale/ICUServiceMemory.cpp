@@ -0,0 +1,83 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode:nil; c-basic-offset: 2 -*- */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "ICUServiceMemory.h"
+
+#include "mozilla/ArrayUtils.h"
+#include "mozilla/Atomics.h"
+#include "mozilla/ThreadLocal.h"
+#include "mozilla/mozalloc.h"
+
+namespace mozilla {
+namespace intl {
+
+static const uint8_t kNoService = uint8_t(ICUService::Count);
+
+static const char* const kServiceNames[] = {"collation", "date-format",
+                                            "number-format"};
+static_assert(ArrayLength(kServiceNames) == size_t(ICUService::Count),
+              "Every ICU service needs a name");
+
+// The service the current thread is calling ICU for, if any.
+static MOZ_THREAD_LOCAL(uint8_t) sCurrentService;
+
+// Signed, as a block allocated outside of any scope may be freed within one.
+static Atomic<intptr_t> sAmounts[size_t(ICUService::Count)];
+
+static uint8_t CurrentService() {
+  if (!sCurrentService.initialized()) {
+    return kNoService;
+  }
+  // Threads start with zero, which stands for no service.
+  return sCurrentService.get() ? sCurrentService.get() - 1 : kNoService;
+}
+
+/* static */
+void ICUServiceMemory::Init() { sCurrentService.infallibleInit(); }
+
+/* static */
+void ICUServiceMemory::NoteAlloc(const void* aPtr) {
+  uint8_t service = CurrentService();
+  if (aPtr && service != kNoService) {
+    sAmounts[service] += moz_malloc_size_of(aPtr);
+  }
+}
+
+/* static */
+void ICUServiceMemory::NoteFree(const void* aPtr) {
+  uint8_t service = CurrentService();
+  if (aPtr && service != kNoService) {
+    sAmounts[service] -= moz_malloc_size_of(aPtr);
+  }
+}
+
+/* static */
+size_t ICUServiceMemory::Amount(ICUService aService) {
+  intptr_t amount = sAmounts[size_t(aService)];
+  return amount > 0 ? size_t(amount) : 0;
+}
+
+/* static */
+const char* ICUServiceMemory::Name(ICUService aService) {
+  return kServiceNames[size_t(aService)];
+}
+
+AutoICUService::AutoICUService(ICUService aService) {
+  if (!sCurrentService.initialized()) {
+    mPrevious = 0;
+    return;
+  }
+  mPrevious = sCurrentService.get();
+  sCurrentService.set(uint8_t(aService) + 1);
+}
+
+AutoICUService::~AutoICUService() {
+  if (sCurrentService.initialized()) {
+    sCurrentService.set(mPrevious);
+  }
+}
+
+}  // namespace intl
+}  // namespace mozilla
@@ -0,0 +1,59 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode:nil; c-basic-offset: 2 -*- */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef mozilla_intl_ICUServiceMemory_h__
+#define mozilla_intl_ICUServiceMemory_h__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mozilla/Attributes.h"
+
+namespace mozilla {
+namespace intl {
+
+// The ICU services Gecko itself uses, which the ICU memory reporter lists
+// separately under explicit/icu/. Everything else, notably the JS Intl
+// objects, is reported as explicit/icu/other.
+enum class ICUService : uint8_t {
+  Collation,
+  DateFormat,
+  NumberFormat,
+  Count
+};
+
+/**
+ * Attributes the heap memory ICU allocates to the service on whose behalf it
+ * does so. The code calling into ICU for a service opens an AutoICUService
+ * scope around the calls that create and destroy its ICU objects; the memory
+ * ICU allocates or frees on that thread meanwhile is counted for the
+ * service, including the locale data ICU caches on first use.
+ */
+class ICUServiceMemory final {
+ public:
+  // Must be called before the ICU memory functions are installed.
+  static void Init();
+
+  // Called by the ICU memory functions, on any thread.
+  static void NoteAlloc(const void* aPtr);
+  static void NoteFree(const void* aPtr);
+
+  static size_t Amount(ICUService aService);
+  static const char* Name(ICUService aService);
+};
+
+class MOZ_RAII AutoICUService final {
+ public:
+  explicit AutoICUService(ICUService aService);
+  ~AutoICUService();
+
+ private:
+  uint8_t mPrevious;
+};
+
+}  // namespace intl
+}  // namespace mozilla
+
+#endif  // mozilla_intl_ICUServiceMemory_h__
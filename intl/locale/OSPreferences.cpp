@@ -13,6 +13,7 @@
 
 #include "mozilla/ClearOnShutdown.h"
 #include "mozilla/Services.h"
+#include "mozilla/intl/ICUServiceMemory.h"
 #include "nsIObserverService.h"
 #include "unicode/udat.h"
 #include "unicode/udatpg.h"
@@ -103,6 +104,8 @@ bool OSPreferences::GetDateTimePatternForStyle(DateTimeFormatStyle aDateStyle,
                                                DateTimeFormatStyle aTimeStyle,
                                                const nsACString& aLocale,
                                                nsACString& aRetVal) {
+  AutoICUService service(ICUService::DateFormat);
+
   UDateFormatStyle timeStyle = UDAT_NONE;
   UDateFormatStyle dateStyle = UDAT_NONE;
 
@@ -188,6 +191,8 @@ bool OSPreferences::GetDateTimeSkeletonForStyle(DateTimeFormatStyle aDateStyle,
                                                 DateTimeFormatStyle aTimeStyle,
                                                 const nsACString& aLocale,
                                                 nsACString& aRetVal) {
+  AutoICUService service(ICUService::DateFormat);
+
   nsAutoCString pattern;
   if (!GetDateTimePatternForStyle(aDateStyle, aTimeStyle, aLocale, pattern)) {
     return false;
@@ -342,6 +347,8 @@ bool OSPreferences::OverrideDateTimePattern(DateTimeFormatStyle aDateStyle,
 bool OSPreferences::GetPatternForSkeleton(const nsACString& aSkeleton,
                                           const nsACString& aLocale,
                                           nsACString& aRetVal) {
+  AutoICUService service(ICUService::DateFormat);
+
   aRetVal.Truncate();
 
   UErrorCode status = U_ZERO_ERROR;
@@ -385,6 +392,8 @@ bool OSPreferences::GetPatternForSkeleton(const nsACString& aSkeleton,
  */
 bool OSPreferences::GetDateTimeConnectorPattern(const nsACString& aLocale,
                                                 nsACString& aRetVal) {
+  AutoICUService service(ICUService::DateFormat);
+
   bool result = false;
 
   // Check for a valid override pref and use that if present.
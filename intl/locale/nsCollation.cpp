@@ -4,6 +4,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "nsCollation.h"
+#include "mozilla/intl/ICUServiceMemory.h"
 #include "mozilla/intl/LocaleService.h"
 #include "nsString.h"
 
@@ -60,21 +61,29 @@ nsresult nsCollation::EnsureCollator(const int32_t newStrength) {
   NS_ENSURE_TRUE(mInit, NS_ERROR_NOT_INITIALIZED);
   if (mHasCollator && (mLastStrength == newStrength)) return NS_OK;
 
-  nsresult res;
-  res = CleanUpCollator();
-  NS_ENSURE_SUCCESS(res, res);
-
-  UErrorCode status;
-  status = U_ZERO_ERROR;
-  mCollatorICU = ucol_open(mLocale.get(), &status);
-  NS_ENSURE_TRUE(U_SUCCESS(status), NS_ERROR_FAILURE);
-
   UCollationStrength strength;
   UColAttributeValue caseLevel;
-  res = ConvertStrength(newStrength, &strength, &caseLevel);
+  nsresult res = ConvertStrength(newStrength, &strength, &caseLevel);
   NS_ENSURE_SUCCESS(res, res);
 
-  status = U_ZERO_ERROR;
+  UErrorCode status = U_ZERO_ERROR;
+
+  // The collator is only opened on first use, and then kept across strength
+  // changes, which only need its attributes to be set again.
+  if (!mHasCollator) {
+    mozilla::intl::AutoICUService service(
+        mozilla::intl::ICUService::Collation);
+    mCollatorICU = ucol_open(mLocale.get(), &status);
+    if (U_FAILURE(status)) {
+      // Fall back to the application locale if the requested one is invalid.
+      status = U_ZERO_ERROR;
+      mozilla::LocaleService::GetInstance()->GetAppLocaleAsBCP47(mLocale);
+      mCollatorICU = ucol_open(mLocale.get(), &status);
+      NS_ENSURE_TRUE(U_SUCCESS(status), NS_ERROR_FAILURE);
+    }
+    mHasCollator = true;
+  }
+
   ucol_setAttribute(mCollatorICU, UCOL_STRENGTH, strength, &status);
   NS_ENSURE_TRUE(U_SUCCESS(status), NS_ERROR_FAILURE);
   ucol_setAttribute(mCollatorICU, UCOL_CASE_LEVEL, caseLevel, &status);
@@ -89,14 +98,14 @@ nsresult nsCollation::EnsureCollator(const int32_t newStrength) {
   ucol_setAttribute(mCollatorICU, UCOL_CASE_FIRST, UCOL_DEFAULT, &status);
   NS_ENSURE_TRUE(U_SUCCESS(status), NS_ERROR_FAILURE);
 
-  mHasCollator = true;
-
   mLastStrength = newStrength;
   return NS_OK;
 }
 
 nsresult nsCollation::CleanUpCollator(void) {
   if (mHasCollator) {
+    mozilla::intl::AutoICUService service(
+        mozilla::intl::ICUService::Collation);
     ucol_close(mCollatorICU);
     mHasCollator = false;
   }
@@ -108,20 +117,9 @@ NS_IMETHODIMP
 nsCollation::Initialize(const nsACString& locale) {
   NS_ENSURE_TRUE((!mInit), NS_ERROR_ALREADY_INITIALIZED);
 
-  // Check whether locale parameter is valid.  If no, use application locale
-  UErrorCode status = U_ZERO_ERROR;
-  UCollator* collator = ucol_open(PromiseFlatCString(locale).get(), &status);
-  if (U_SUCCESS(status)) {
-    mLocale = locale;
-  } else {
-    status = U_ZERO_ERROR;
-    mozilla::LocaleService::GetInstance()->GetAppLocaleAsBCP47(mLocale);
-    collator = ucol_open(mLocale.get(), &status);
-    if (NS_WARN_IF(U_FAILURE(status))) {
-      return NS_ERROR_UNEXPECTED;
-    }
-  }
-  ucol_close(collator);
+  // The locale is checked when the collator is first opened, by
+  // EnsureCollator(), which falls back to the application locale.
+  mLocale = locale;
 
   mInit = true;
   return NS_OK;
@@ -9,6 +9,7 @@
 
 #  include "ICUUtils.h"
 #  include "mozilla/StaticPrefs_dom.h"
+#  include "mozilla/intl/ICUServiceMemory.h"
 #  include "mozilla/intl/LocaleService.h"
 #  include "nsIContent.h"
 #  include "mozilla/dom/Document.h"
@@ -17,6 +18,8 @@
 #  include "unicode/unum.h"
 
 using namespace mozilla;
+using mozilla::intl::AutoICUService;
+using mozilla::intl::ICUService;
 using mozilla::intl::LocaleService;
 
 class NumberFormatDeleter {
@@ -75,6 +78,7 @@ bool ICUUtils::LocalizeNumber(double aValue,
                               LanguageTagIterForContent& aLangTags,
                               nsAString& aLocalizedValue) {
   MOZ_ASSERT(aLangTags.IsAtStart(), "Don't call Next() before passing");
+  AutoICUService service(ICUService::NumberFormat);
 
   static const int32_t kBufferSize = 256;
 
@@ -121,6 +125,8 @@ double ICUUtils::ParseNumber(nsAString& aValue,
     return std::numeric_limits<float>::quiet_NaN();
   }
 
+  AutoICUService service(ICUService::NumberFormat);
+
   uint32_t length = aValue.Length();
 
   nsAutoCString langTag;
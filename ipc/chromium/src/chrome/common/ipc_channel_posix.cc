@@ -209,6 +209,7 @@ void Channel::ChannelImpl::Init(Mode mode, Listener* listener) {
 
   mode_ = mode;
   is_blocked_on_write_ = false;
+  flush_pending_ = false;
   partial_write_iter_.reset();
   input_buf_offset_ = 0;
   input_buf_ = mozilla::MakeUnique<char[]>(Channel::kReadBufferSize);
@@ -676,6 +677,44 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
     }
 
     const bool intentional_short_write = !iter.Done();
+    const size_t first_amt_to_write = amt_to_write;
+
+    // If all of this message fits, add whole messages queued behind it, so
+    // that a burst of small messages goes out with a single sendmsg. A message
+    // with descriptors gets a sendmsg of its own, since the control data
+    // travels with the first byte written.
+    size_t coalesced = 0;
+    if (!intentional_short_write) {
+      for (size_t i = 1; i < output_queue_length_; ++i) {
+        Message* next = output_queue_.ElementAt(i).get();
+        if (!next->file_descriptor_set()->empty()) {
+          break;
+        }
+
+        size_t next_iov_count = iov_count;
+        size_t next_amt_to_write = amt_to_write;
+        Pickle::BufferList::IterImpl next_iter(next->Buffers());
+        while (!next_iter.Done() && next_iov_count < kMaxIOVecSize &&
+               PipeBufHasSpaceAfter(next_amt_to_write)) {
+          size_t size = next_iter.RemainingInSegment();
+          iov[next_iov_count].iov_base = next_iter.Data();
+          iov[next_iov_count].iov_len = size;
+          next_iov_count++;
+          next_amt_to_write += size;
+          next_iter.Advance(next->Buffers(), size);
+        }
+        if (!next_iter.Done()) {
+          break;
+        }
+
+        AddIPCProfilerMarker(*next, other_pid_, MessageDirection::eSending,
+                             MessagePhase::TransferStart);
+        iov_count = next_iov_count;
+        amt_to_write = next_amt_to_write;
+        coalesced++;
+      }
+    }
+
     msgh.msg_iov = iov;
     msgh.msg_iovlen = iov_count;
 
@@ -726,13 +765,13 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
       }
     }
 
-    if (intentional_short_write ||
-        static_cast<size_t>(bytes_written) != amt_to_write) {
+    if (intentional_short_write || bytes_written < 0 ||
+        static_cast<size_t>(bytes_written) < first_amt_to_write) {
       // If write() fails with EAGAIN then bytes_written will be -1.
       if (bytes_written > 0) {
         MOZ_DIAGNOSTIC_ASSERT(intentional_short_write ||
                               static_cast<size_t>(bytes_written) <
-                                  amt_to_write);
+                                  first_amt_to_write);
         partial_write_iter_.ref().AdvanceAcrossSegments(msg->Buffers(),
                                                         bytes_written);
         // We should not hit the end of the buffer.
@@ -767,11 +806,48 @@ bool Channel::ChannelImpl::ProcessOutgoingMessages() {
       OutputQueuePop();
       // msg has been destroyed, so clear the dangling reference.
       msg = nullptr;
+
+      // Then the messages that went out with it.
+      size_t remaining = bytes_written - first_amt_to_write;
+      for (size_t i = 0; i < coalesced; ++i) {
+        msg = output_queue_.FirstElement().get();
+        size_t size = msg->Buffers().Size();
+        if (remaining < size) {
+          // Carry on with this one once the pipe has drained.
+          Pickle::BufferList::IterImpl partial(msg->Buffers());
+          partial.AdvanceAcrossSegments(msg->Buffers(), remaining);
+          partial_write_iter_.emplace(partial);
+
+          is_blocked_on_write_ = true;
+          MessageLoopForIO::current()->WatchFileDescriptor(
+              pipe_,
+              false,  // One shot
+              MessageLoopForIO::WATCH_WRITE, &write_watcher_, this);
+          return true;
+        }
+        remaining -= size;
+
+        AddIPCProfilerMarker(*msg, other_pid_, MessageDirection::eSending,
+                             MessagePhase::TransferEnd);
+        OutputQueuePop();
+        msg = nullptr;
+      }
     }
   }
   return true;
 }
 
+void Channel::ChannelImpl::FlushOutgoingMessages() {
+  flush_pending_ = false;
+  if (closed_ || waiting_connect_ || is_blocked_on_write_) {
+    return;
+  }
+  if (!ProcessOutgoingMessages()) {
+    Close();
+    listener_->OnChannelError();
+  }
+}
+
 bool Channel::ChannelImpl::Send(mozilla::UniquePtr<Message> message) {
 #ifdef IPC_MESSAGE_DEBUG_EXTRA
   DLOG(INFO) << "sending message @" << message.get() << " on channel @" << this
@@ -798,10 +874,13 @@ bool Channel::ChannelImpl::Send(mozilla::UniquePtr<Message> message) {
   }
 
   OutputQueuePush(std::move(message));
-  if (!waiting_connect_) {
-    if (!is_blocked_on_write_) {
-      if (!ProcessOutgoingMessages()) return false;
-    }
+  if (!waiting_connect_ && !is_blocked_on_write_ && !flush_pending_) {
+    // Each message is sent from its own task on the I/O thread. Rather than
+    // writing it out right away, let the sends already posted queue their
+    // messages too, so they go out together.
+    flush_pending_ = true;
+    MessageLoopForIO::current()->PostTask(
+        factory_.NewRunnableMethod(&ChannelImpl::FlushOutgoingMessages));
   }
 
   return true;
@@ -64,6 +64,7 @@ class Channel::ChannelImpl : public MessageLoopForIO::Watcher {
 
   bool ProcessIncomingMessages();
   bool ProcessOutgoingMessages();
+  void FlushOutgoingMessages();
 
   // MessageLoopForIO::Watcher implementation.
   virtual void OnFileCanReadWithoutBlocking(int fd) override;
@@ -87,6 +88,10 @@ class Channel::ChannelImpl : public MessageLoopForIO::Watcher {
   // Indicates whether we're currently blocked waiting for a write to complete.
   bool is_blocked_on_write_;
 
+  // Indicates whether a task to write out the queued messages is pending, see
+  // Send().
+  bool flush_pending_;
+
   // If sending a message blocks then we use this iterator to keep track of
   // where in the message we are. It gets reset when the message is finished
   // sending.
@@ -435,6 +435,7 @@ GeckoChildProcessHost::GeckoChildProcessHost(GeckoProcessType aProcessType,
 #if defined(MOZ_ENABLE_FORKSERVER)
   if (aProcessType == GeckoProcessType_Content && ForkServiceChild::Get()) {
     mLaunchOptions->use_forkserver = true;
+    mUsesForkServer = true;
   }
 #endif
 }
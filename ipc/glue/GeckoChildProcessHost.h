@@ -132,6 +132,10 @@ class GeckoChildProcessHost : public ChildProcessHost,
 
   GeckoProcessType GetProcessType() { return mProcessType; }
 
+  // Whether the process is forked from the fork server rather than
+  // launched with a fresh exec.
+  bool UsesForkServer() const { return mUsesForkServer; }
+
 #ifdef XP_MACOSX
   task_t GetChildTask() { return mChildTask; }
 #endif
@@ -201,6 +205,7 @@ class GeckoChildProcessHost : public ChildProcessHost,
   // then used for the actual launch on another thread.  This pointer
   // is set to null to free the options after the child is launched.
   UniquePtr<base::LaunchOptions> mLaunchOptions;
+  bool mUsesForkServer = false;
 
   // This value must be accessed while holding mMonitor.
   enum {
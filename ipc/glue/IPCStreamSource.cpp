@@ -182,7 +182,9 @@ void IPCStreamSource::DoRead() {
   static_assert(kMaxBytesPerMessage <= static_cast<uint64_t>(UINT32_MAX),
                 "kMaxBytesPerMessage must cleanly cast to uint32_t");
 
-  UniquePtr<char[]> buffer(new char[kMaxBytesPerMessage]);
+  if (!mBuffer) {
+    mBuffer.reset(new char[kMaxBytesPerMessage]);
+  }
 
   while (true) {
     // It should not be possible to transition to closed state without
@@ -198,7 +200,7 @@ void IPCStreamSource::DoRead() {
     }
 
     uint32_t bytesRead = 0;
-    rv = mStream->Read(buffer.get(), kMaxBytesPerMessage, &bytesRead);
+    rv = mStream->Read(mBuffer.get(), kMaxBytesPerMessage, &bytesRead);
 
     if (rv == NS_BASE_STREAM_WOULD_BLOCK) {
       MOZ_ASSERT(bytesRead == 0);
@@ -219,7 +221,7 @@ void IPCStreamSource::DoRead() {
     }
 
     // We read some data from the stream, send it across.
-    SendData(ByteBuffer(bytesRead, reinterpret_cast<uint8_t*>(buffer.get())));
+    SendData(ByteBuffer(bytesRead, reinterpret_cast<uint8_t*>(mBuffer.get())));
   }
 }
 
@@ -263,6 +265,7 @@ void IPCStreamSource::OnEnd(nsresult aRv) {
   }
 
   mState = eClosed;
+  mBuffer = nullptr;
 
   mStream->CloseWithStatus(aRv);
 
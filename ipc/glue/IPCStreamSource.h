@@ -9,6 +9,7 @@
 
 #include "mozilla/AlreadyAddRefed.h"
 #include "mozilla/dom/WorkerRef.h"
+#include "mozilla/UniquePtr.h"
 #include "nsCOMPtr.h"
 
 class nsIAsyncInputStream;
@@ -107,6 +108,10 @@ class IPCStreamSource {
   nsCOMPtr<nsIAsyncInputStream> mStream;
   RefPtr<Callback> mCallback;
 
+  // Staging buffer for DoRead(). It is kept across wake-ups so that a
+  // network-fed stream does not allocate a fresh buffer for every chunk.
+  UniquePtr<char[]> mBuffer;
+
   RefPtr<dom::StrongWorkerRef> mWorkerRef;
 
 #ifdef DEBUG
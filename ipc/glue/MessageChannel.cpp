@@ -548,6 +548,93 @@ ChannelCountReporter::CountTable* ChannelCountReporter::sChannelCounts;
 
 NS_IMPL_ISUPPORTS(ChannelCountReporter, nsIMemoryReporter)
 
+// Messages and bytes sent to and received from other processes, by protocol.
+// These are running totals; comparing two about:memory snapshots gives the
+// rates.
+class MessageCountReporter final : public nsIMemoryReporter {
+  ~MessageCountReporter() = default;
+
+  struct MessageCounts {
+    uint64_t mSent = 0;
+    uint64_t mSentBytes = 0;
+    uint64_t mReceived = 0;
+    uint64_t mReceivedBytes = 0;
+  };
+
+  using CountTable = nsTHashMap<nsCStringHashKey, MessageCounts>;
+
+  static StaticMutex sMessageCountMutex;
+  static CountTable* sMessageCounts;
+
+ public:
+  NS_DECL_THREADSAFE_ISUPPORTS
+
+  NS_IMETHOD
+  CollectReports(nsIHandleReportCallback* aHandleReport, nsISupports* aData,
+                 bool aAnonymize) override {
+    StaticMutexAutoLock countLock(sMessageCountMutex);
+    if (!sMessageCounts) {
+      return NS_OK;
+    }
+    for (const auto& entry : *sMessageCounts) {
+      const MessageCounts& counts = entry.GetData();
+      const char* protocol = entry.GetKey().get();
+      aHandleReport->Callback(
+          ""_ns, nsPrintfCString("ipc-messages/%s/sent", protocol), KIND_OTHER,
+          UNITS_COUNT_CUMULATIVE, counts.mSent,
+          nsPrintfCString("Messages of protocol %s sent.", protocol), aData);
+      aHandleReport->Callback(
+          ""_ns, nsPrintfCString("ipc-messages/%s/received", protocol),
+          KIND_OTHER, UNITS_COUNT_CUMULATIVE, counts.mReceived,
+          nsPrintfCString("Messages of protocol %s received.", protocol),
+          aData);
+      aHandleReport->Callback(
+          ""_ns, nsPrintfCString("ipc-message-bytes/%s/sent", protocol),
+          KIND_OTHER, UNITS_BYTES, counts.mSentBytes,
+          nsPrintfCString("Bytes of protocol %s messages sent.", protocol),
+          aData);
+      aHandleReport->Callback(
+          ""_ns, nsPrintfCString("ipc-message-bytes/%s/received", protocol),
+          KIND_OTHER, UNITS_BYTES, counts.mReceivedBytes,
+          nsPrintfCString("Bytes of protocol %s messages received.", protocol),
+          aData);
+    }
+    return NS_OK;
+  }
+
+  static void Record(const Message& aMsg, bool aSent) {
+    // Message names are "Protocol::Msg_Name".
+    nsDependentCString name(aMsg.name());
+    int32_t separator = name.Find("::");
+    const nsDependentCSubstring protocol =
+        separator == kNotFound ? Substring(name, 0)
+                               : Substring(name, 0, separator);
+
+    StaticMutexAutoLock countLock(sMessageCountMutex);
+    if (!sMessageCounts) {
+      sMessageCounts = new CountTable;
+    }
+    MessageCounts& counts = sMessageCounts->LookupOrInsert(protocol);
+    if (aSent) {
+      counts.mSent++;
+      counts.mSentBytes += aMsg.size();
+    } else {
+      counts.mReceived++;
+      counts.mReceivedBytes += aMsg.size();
+    }
+  }
+};
+
+StaticMutex MessageCountReporter::sMessageCountMutex;
+MessageCountReporter::CountTable* MessageCountReporter::sMessageCounts;
+
+NS_IMPL_ISUPPORTS(MessageCountReporter, nsIMemoryReporter)
+
+/* static */
+void MessageChannel::NoteLinkMessage(const Message& aMsg, bool aSent) {
+  MessageCountReporter::Record(aMsg, aSent);
+}
+
 // In child processes, the first MessageChannel is created before
 // XPCOM is initialized enough to construct the memory reporter
 // manager.  This retries every time a MessageChannel is constructed,
@@ -611,6 +698,7 @@ MessageChannel::MessageChannel(const char* aName, IToplevelProtocol* aListener)
 
   TryRegisterStrongMemoryReporter<PendingResponseReporter>();
   TryRegisterStrongMemoryReporter<ChannelCountReporter>();
+  TryRegisterStrongMemoryReporter<MessageCountReporter>();
 }
 
 MessageChannel::~MessageChannel() {
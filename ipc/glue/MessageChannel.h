@@ -147,6 +147,10 @@ class MessageChannel : HasResultCodes {
   static Atomic<size_t> gUnresolvedResponses;
   friend class PendingResponseReporter;
 
+  // Accounts a message sent or received over a link to another process in
+  // the per-protocol counts of the ipc-messages memory reports.
+  static void NoteLinkMessage(const Message& aMsg, bool aSent);
+
  public:
   static const int32_t kNoTimeout;
 
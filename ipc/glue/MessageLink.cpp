@@ -149,6 +149,7 @@ void ProcessLink::SendMessage(UniquePtr<Message> msg) {
   mChan->mMonitor->AssertCurrentThreadOwns();
 
   msg->AssertAsLargeAsHeader();
+  MessageChannel::NoteLinkMessage(*msg, /* aSent */ true);
 
   mIOLoop->PostTask(NewNonOwningRunnableMethod<UniquePtr<Message>&&>(
       "IPC::Channel::Send", mTransport.get(), &Transport::Send,
@@ -260,6 +261,7 @@ uint32_t ThreadLink::Unsound_NumQueuedMessages() const {
 void ProcessLink::OnMessageReceived(Message&& msg) {
   AssertIOThread();
   NS_ASSERTION(mChan->mChannelState != ChannelError, "Shouldn't get here!");
+  MessageChannel::NoteLinkMessage(msg, /* aSent */ false);
   MonitorAutoLock lock(*mChan->mMonitor);
   mChan->OnMessageReceivedFromLink(std::move(msg));
 }
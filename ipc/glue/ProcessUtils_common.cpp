@@ -217,8 +217,9 @@ static const int kJSInitFileDescriptor = 11;
 
 void ExportSharedJSInit(mozilla::ipc::GeckoChildProcessHost& procHost,
                         std::vector<std::string>& aExtraOpts) {
-#ifdef ANDROID
-  // The code to support Android is added in a follow-up patch.
+#ifdef MOZ_WIDGET_ANDROID
+  // The code to support Android is added in a follow-up patch. Gonk launches
+  // its children like the other Unixes, so it can use the fixed fd below.
   return;
 #else
   // Formats a pointer or pointer-sized-integer as a string suitable for passing
@@ -56,6 +56,9 @@ size_t SharedMemory::PageAlignedSize(size_t aSize) {
   return pageSize * nPagesNeeded;
 }
 
+/*static*/
+size_t SharedMemory::TotalMapped() { return gShmemMapped; }
+
 void SharedMemory::Created(size_t aNBytes) {
   mAllocSize = aNBytes;
   gShmemAllocated += mAllocSize;
@@ -89,6 +89,10 @@ class SharedMemory {
   static size_t SystemPageSize();
   static size_t PageAlignedSize(size_t aSize);
 
+  // The size of all the shared memory this process has mapped, mostly layer
+  // buffers in content processes.
+  static size_t TotalMapped();
+
  protected:
   SharedMemory();
 
@@ -547,7 +547,7 @@ namespace JS {
   D(CC_FINISHED, 36)                        \
   D(CC_FORCED, 37)                          \
   D(LOAD_END, 38)                           \
-  D(UNUSED3, 39)                            \
+  D(BACKGROUND_COMPACTION, 39)              \
   D(PAGE_HIDE, 40)                          \
   D(NSJSCONTEXT_DESTROY, 41)                \
   D(WORKER_SHUTDOWN, 42)                    \
@@ -647,6 +647,17 @@ extern JS_PUBLIC_API void SkipZoneForGC(JSContext* cx, Zone* zone);
 extern JS_PUBLIC_API void NonIncrementalGC(JSContext* cx, JS::GCOptions options,
                                            GCReason reason);
 
+/**
+ * Collects the nursery and shrinks it to JSGC_MIN_NURSERY_BYTES, handing the
+ * memory it no longer needs back to the OS. The nursery grows again with the
+ * allocation rate, up to JSGC_MAX_NURSERY_BYTES.
+ *
+ * This is for embeddings that know the runtime is about to go quiet for a
+ * while, e.g. because its process has been moved to the background. Unlike a
+ * shrinking GC, it leaves the tenured heap alone.
+ */
+extern JS_PUBLIC_API void ShrinkNursery(JSContext* cx, GCReason reason);
+
 /*
  * Incremental GC:
  *
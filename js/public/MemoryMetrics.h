@@ -508,6 +508,7 @@ struct RuntimeSizes {
   MACRO(_, MallocHeap, sharedImmutableStringsCache) \
   MACRO(_, MallocHeap, sharedIntlData)              \
   MACRO(_, MallocHeap, uncompressedSourceCache)     \
+  MACRO(_, MallocHeap, regExpBytecodeCache)         \
   MACRO(_, MallocHeap, scriptData)                  \
   MACRO(_, MallocHeap, tracelogger)                 \
   MACRO(_, MallocHeap, wasmRuntime)                 \
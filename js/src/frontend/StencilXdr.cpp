@@ -18,6 +18,8 @@
 #include "frontend/CompilationStencil.h"  // CompilationStencil
 #include "frontend/ScriptIndex.h"         // ScriptIndex
 #include "vm/JSScript.h"                  // js::CheckCompileOptionsMatch
+#include "vm/RegExpBytecodeCache.h"       // js::RegExpBytecodeCache
+#include "vm/Runtime.h"                   // JSRuntime
 #include "vm/Scope.h"                     // SizeOfParserScopeData
 #include "vm/StencilEnums.h"              // js::ImmutableScriptFlagsEnum
 
@@ -578,6 +580,104 @@ XDRResult XDRCompilationStencilSpanSize(
   return Ok();
 }
 
+static RegExpBytecodeCache::Lookup RegExpByteCodeLookup(
+    const ParserAtom* source, JS::RegExpFlags flags, bool latin1) {
+  if (source->hasLatin1Chars()) {
+    return RegExpBytecodeCache::Lookup(source->latin1Chars(), source->length(),
+                                       flags, latin1);
+  }
+  return RegExpBytecodeCache::Lookup(source->twoByteChars(), source->length(),
+                                     flags, latin1);
+}
+
+// The bytecode the runtime has for the regexps of the stencil, so that the
+// process decoding it can put it in its RegExpBytecodeCache instead of
+// compiling them again. Regexps whose source is a static or well-known atom
+// are too short to be worth it.
+template <XDRMode mode>
+/* static */ XDRResult StencilXDR::codeRegExpByteCode(
+    XDRState<mode>* xdr, CompilationStencil& stencil) {
+  RegExpBytecodeCache& cache = xdr->cx()->runtime()->regExpBytecodeCache();
+
+  auto sourceOf = [&](const RegExpStencil& regExp) -> const ParserAtom* {
+    if (!regExp.atom_.isParserAtomIndex()) {
+      return nullptr;
+    }
+    return stencil.parserAtomData[regExp.atom_.toParserAtomIndex()];
+  };
+
+  struct Entry {
+    uint32_t index;
+    uint8_t latin1;
+    uint32_t maxRegisters;
+    irregexp::ByteArray byteCode;
+  };
+  Vector<Entry, 0, SystemAllocPolicy> entries;
+
+  if (mode == XDR_ENCODE) {
+    for (uint32_t i = 0; i < stencil.regExpData.size(); i++) {
+      const RegExpStencil& regExp = stencil.regExpData[i];
+      const ParserAtom* source = sourceOf(regExp);
+      if (!source) {
+        continue;
+      }
+      for (bool latin1 : {true, false}) {
+        uint32_t maxRegisters = 0;
+        irregexp::ByteArray byteCode = cache.lookup(
+            RegExpByteCodeLookup(source, regExp.flags(), latin1),
+            &maxRegisters);
+        if (byteCode && !entries.append(Entry{i, latin1, maxRegisters,
+                                              std::move(byteCode)})) {
+          return xdr->fail(JS::TranscodeResult::Throw);
+        }
+      }
+    }
+  }
+
+  uint32_t count = entries.length();
+  MOZ_TRY(xdr->codeUint32(&count));
+
+  for (uint32_t i = 0; i < count; i++) {
+    Entry decoded{};
+    Entry& entry = mode == XDR_ENCODE ? entries[i] : decoded;
+    MOZ_TRY(xdr->codeUint32(&entry.index));
+    MOZ_TRY(xdr->codeUint8(&entry.latin1));
+    MOZ_TRY(xdr->codeUint32(&entry.maxRegisters));
+
+    uint32_t length = 0;
+    if (mode == XDR_ENCODE) {
+      length = entry.byteCode->length;
+    }
+    MOZ_TRY(xdr->codeUint32(&length));
+
+    if (mode == XDR_DECODE) {
+      if (entry.index >= stencil.regExpData.size()) {
+        return xdr->fail(JS::TranscodeResult::Failure_BadDecode);
+      }
+      size_t size = sizeof(irregexp::ByteArrayData) + length;
+      entry.byteCode.reset(
+          static_cast<irregexp::ByteArrayData*>(js_malloc(size)));
+      if (!entry.byteCode) {
+        return xdr->fail(JS::TranscodeResult::Throw);
+      }
+      entry.byteCode->length = length;
+    }
+    // The bytecode immediately follows its length, see
+    // ByteArrayData::data().
+    MOZ_TRY(xdr->codeBytes(entry.byteCode.get() + 1, length));
+
+    if (mode == XDR_DECODE) {
+      const RegExpStencil& regExp = stencil.regExpData[entry.index];
+      if (const ParserAtom* source = sourceOf(regExp)) {
+        cache.put(RegExpByteCodeLookup(source, regExp.flags(), entry.latin1),
+                  entry.byteCode.get(), entry.maxRegisters);
+      }
+    }
+  }
+
+  return Ok();
+}
+
 // Marker between each section inside CompilationStencil.
 //
 // These values should meet the following requirement:
@@ -591,6 +691,7 @@ enum class SectionMarker : uint32_t {
   ScopeData = 0x892C25EF,
   ScopeNames = 0x638C4FB3,
   RegExpData = 0xB030C2AF,
+  RegExpByteCode = 0x5C3E7A9B,
   BigIntData = 0x4B24F449,
   ObjLiteralData = 0x9AFAAE45,
   SharedData = 0xAAD52687,
@@ -655,6 +756,9 @@ template <XDRMode mode>
   MOZ_TRY(CodeMarker(xdr, SectionMarker::RegExpData));
   MOZ_TRY(XDRSpanContent(xdr, stencil.regExpData, regExpSize));
 
+  MOZ_TRY(CodeMarker(xdr, SectionMarker::RegExpByteCode));
+  MOZ_TRY(codeRegExpByteCode(xdr, stencil));
+
   MOZ_TRY(CodeMarker(xdr, SectionMarker::BigIntData));
   MOZ_TRY(
       XDRSpanInitialized(xdr, stencil.alloc, stencil.bigIntData, bigIntSize));
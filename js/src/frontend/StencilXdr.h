@@ -77,6 +77,10 @@ class StencilXDR {
   static XDRResult codeModuleMetadata(XDRState<mode>* xdr,
                                       StencilModuleMetadata& stencil);
 
+  template <XDRMode mode>
+  static XDRResult codeRegExpByteCode(XDRState<mode>* xdr,
+                                      CompilationStencil& stencil);
+
   static XDRResult checkCompilationStencil(XDRStencilEncoder* encoder,
                                            const CompilationStencil& stencil);
 
@@ -4447,6 +4447,7 @@ void GCRuntime::endPreparePhase(JS::GCReason reason) {
       relazifyFunctionsForShrinkingGC();
       purgeShapeCachesForShrinkingGC();
       purgeSourceURLsForShrinkingGC();
+      rt->regExpBytecodeCache().purge();
     }
 
     /*
@@ -5304,9 +5305,13 @@ void GCRuntime::updateAtomsBitmap() {
   }
 
   atomMarking.markAtomsUsedByUncollectedZones(rt);
+}
 
-  // For convenience sweep these tables non-incrementally as part of bitmap
-  // sweeping; they are likely to be much smaller than the main atoms table.
+void GCRuntime::sweepAtomReferences() {
+  // These tables are much smaller than the main atoms table so they are swept
+  // in one go, but off the main thread, in parallel with the rest of the
+  // group's sweeping. They only need the atom mark bits to be final.
+  AutoSetThreadIsSweeping threadIsSweeping;  // This may touch any zone.
   rt->symbolRegistry().sweep();
   SweepingTracer trc(rt);
   for (RealmsIter realm(this); !realm.done(); realm.next()) {
@@ -5471,6 +5476,7 @@ void GCRuntime::sweepJitDataOnMainThread(JSFreeOp* fop) {
     gcstats::AutoPhase apdc(stats(), gcstats::PhaseKind::SWEEP_DISCARD_CODE);
     for (SweepGroupZonesIter zone(this); !zone.done(); zone.next()) {
       zone->discardJitCode(fop);
+      zone->discardIdleBaselineCode(fop);
     }
   }
 
@@ -5641,6 +5647,11 @@ IncrementalProgress GCRuntime::beginSweepingSweepGroup(JSFreeOp* fop,
                                        PhaseKind::SWEEP_UNIQUEIDS, lock);
     AutoRunParallelTask sweepWeakRefs(this, &GCRuntime::sweepWeakRefs,
                                       PhaseKind::SWEEP_WEAKREFS, lock);
+    Maybe<AutoRunParallelTask> sweepAtomRefs;
+    if (sweepingAtoms) {
+      sweepAtomRefs.emplace(this, &GCRuntime::sweepAtomReferences,
+                            PhaseKind::SWEEP_ATOM_REFERENCES, lock);
+    }
 
     WeakCacheTaskVector sweepCacheTasks;
     bool canSweepWeakCachesOffThread =
@@ -7917,6 +7928,21 @@ void GCRuntime::minorGC(JS::GCReason reason, gcstats::PhaseKind phase) {
   }
 }
 
+void GCRuntime::shrinkNursery(JS::GCReason reason) {
+  MOZ_ASSERT(!JS::RuntimeHeapIsBusy());
+
+  if (rt->mainContextFromOwnThread()->suppressGC) {
+    return;
+  }
+
+  incGcNumber();
+
+  // Collecting with the shrink option sizes the nursery down to the minimum
+  // and queues the freed chunks for decommit, even if it was already empty.
+  collectNursery(JS::GCOptions::Shrink, reason,
+                 gcstats::PhaseKind::EVICT_NURSERY);
+}
+
 void GCRuntime::collectNursery(JS::GCOptions options, JS::GCReason reason,
                                gcstats::PhaseKind phase) {
   AutoMaybeLeaveAtomsZone leaveAtomsZone(rt->mainContextFromOwnThread());
@@ -8641,6 +8667,13 @@ JS_PUBLIC_API void JS::NonIncrementalGC(JSContext* cx, JS::GCOptions options,
   MOZ_ASSERT(!IsIncrementalGCInProgress(cx));
 }
 
+JS_PUBLIC_API void JS::ShrinkNursery(JSContext* cx, GCReason reason) {
+  AssertHeapIsIdle();
+  CHECK_THREAD(cx);
+
+  cx->runtime()->gc.shrinkNursery(reason);
+}
+
 JS_PUBLIC_API void JS::StartIncrementalGC(JSContext* cx, JS::GCOptions options,
                                           GCReason reason, int64_t millis) {
   AssertHeapIsIdle();
@@ -362,6 +362,7 @@ class GCRuntime {
   void evictNursery(JS::GCReason reason = JS::GCReason::EVICT_NURSERY) {
     minorGC(reason, gcstats::PhaseKind::EVICT_NURSERY);
   }
+  void shrinkNursery(JS::GCReason reason) JS_HAZ_GC_CALL;
 
   void* addressOfNurseryPosition() {
     return nursery_.refNoCheck().addressOfPosition();
@@ -775,6 +776,7 @@ class GCRuntime {
                                               SliceBudget& budget);
   IncrementalProgress markDuringSweeping(JSFreeOp* fop, SliceBudget& budget);
   void updateAtomsBitmap();
+  void sweepAtomReferences();
   void sweepCCWrappers();
   void sweepMisc();
   void sweepCompressionTasks();
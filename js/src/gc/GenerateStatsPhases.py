@@ -194,6 +194,9 @@ PhaseKindGraphRoots = [
                         74,
                     ),
                     addPhaseKind("SWEEP_WEAKREFS", "Sweep WeakRefs", 75),
+                    addPhaseKind(
+                        "SWEEP_ATOM_REFERENCES", "Sweep Atom References", 77
+                    ),
                     addPhaseKind("SWEEP_JIT_DATA", "Sweep JIT Data", 65),
                     addPhaseKind("SWEEP_WEAK_CACHES", "Sweep Weak Caches", 66),
                     addPhaseKind("SWEEP_MISC", "Sweep Miscellaneous", 29),
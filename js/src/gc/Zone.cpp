@@ -18,6 +18,7 @@
 #include "jit/Invalidation.h"
 #include "jit/Ion.h"
 #include "jit/JitZone.h"
+#include "vm/HelperThreads.h"
 #include "vm/Runtime.h"
 #include "wasm/WasmInstance.h"
 
@@ -492,6 +493,62 @@ void Zone::discardJitCode(JSFreeOp* fop,
   }
 }
 
+void Zone::discardIdleBaselineCode(JSFreeOp* fop) {
+  uint32_t maxIdleGCs = jit::JitOptions.baselineDiscardIdleGCs;
+  if (!maxIdleGCs || !jitZone() || !isPreservingCode()) {
+    return;
+  }
+
+  // Baseline code only bumps the warm-up count on the way to Ion, so without
+  // Ion we can't tell whether a script has run.
+  if (!jit::JitOptions.ion) {
+    return;
+  }
+
+  bool anyIdle = false;
+  for (auto base = cellIterUnsafe<BaseScript>(); !base.done(); base.next()) {
+    jit::JitScript* jitScript = base->maybeJitScript();
+    if (!jitScript || !jitScript->hasBaselineScript()) {
+      continue;
+    }
+    // Scripts running in Ion code don't bump their warm-up count either.
+    JSScript* script = base->asJSScript();
+    if (!script->canIonCompile() || jitScript->hasIonScript() ||
+        jitScript->isIonCompilingOffThread()) {
+      jitScript->resetIdleGCs();
+      continue;
+    }
+    if (jitScript->noteGCAndGetIdleGCs() >= maxIdleGCs) {
+      anyIdle = true;
+    }
+  }
+  if (!anyIdle) {
+    return;
+  }
+
+  // Ion code, including what is being compiled, may have inlined an idle
+  // script, and bailing out of it needs the inlined script's Baseline code.
+  // Scripts inlined into Ion code don't bump their own warm-up count, so we
+  // can't tell those apart and have to throw away the zone's Ion code.
+  CancelOffThreadIonCompile(this);
+  jit::MarkActiveJitScripts(this);
+  jit::InvalidateAll(fop, this);
+
+  for (auto base = cellIterUnsafe<BaseScript>(); !base.done(); base.next()) {
+    jit::JitScript* jitScript = base->maybeJitScript();
+    if (!jitScript) {
+      continue;
+    }
+    JSScript* script = base->asJSScript();
+    jit::FinishInvalidation(fop, script);
+    if (jitScript->hasBaselineScript() && !jitScript->active() &&
+        jitScript->idleGCs() >= maxIdleGCs) {
+      jit::FinishDiscardBaselineScript(fop, script);
+    }
+    jitScript->resetActive();
+  }
+}
+
 void JS::Zone::beforeClearDelegateInternal(JSObject* wrapper,
                                            JSObject* delegate) {
   MOZ_ASSERT(js::gc::detail::GetDelegate(wrapper) == delegate);
@@ -397,6 +397,11 @@ class Zone : public js::ZoneAllocator, public js::gc::GraphNodeBase<JS::Zone> {
       ShouldDiscardBaselineCode discardBaselineCode = DiscardBaselineCode,
       ShouldDiscardJitScripts discardJitScripts = KeepJitScripts);
 
+  // For zones that keep their JIT code over this GC, discard the Baseline
+  // code of the scripts that haven't run for JitOptions.baselineDiscardIdleGCs
+  // GCs.
+  void discardIdleBaselineCode(JSFreeOp* fop);
+
   void addSizeOfIncludingThis(
       mozilla::MallocSizeOf mallocSizeOf, JS::CodeSizes* code,
       size_t* regexpZone, size_t* jitZone, size_t* baselineStubsOptimized,
@@ -30,6 +30,7 @@
 #include "js/friend/StackLimits.h"    // js::ReportOverRecursed
 #include "util/StringBuffer.h"
 #include "vm/MatchPairs.h"
+#include "vm/RegExpBytecodeCache.h"
 #include "vm/RegExpShared.h"
 
 namespace js {
@@ -454,6 +455,21 @@ class RegExpDepthCheck final : public v8::internal::RegExpVisitor {
   static const size_t FRAME_PADDING = 256;
 };
 
+// Call |f| with the key of the bytecode of |pattern| in the runtime's
+// RegExpBytecodeCache. The key points to the chars of |pattern| so |f| must
+// not GC.
+template <typename F>
+static auto WithByteCodeLookup(JSAtom* pattern, JS::RegExpFlags flags,
+                               bool isLatin1, F f) {
+  JS::AutoCheckCannotGC nogc;
+  if (pattern->hasLatin1Chars()) {
+    return f(RegExpBytecodeCache::Lookup(pattern->latin1Chars(nogc),
+                                         pattern->length(), flags, isLatin1));
+  }
+  return f(RegExpBytecodeCache::Lookup(pattern->twoByteChars(nogc),
+                                       pattern->length(), flags, isLatin1));
+}
+
 enum class AssembleResult {
   Success,
   TooLarge,
@@ -560,6 +576,11 @@ enum class AssembleResult {
     ByteArray bytecode =
         v8::internal::ByteArray::cast(*result.code).takeOwnership(cx->isolate);
     uint32_t length = bytecode->length;
+    WithByteCodeLookup(pattern, re->getFlags(), isLatin1,
+                       [&](const RegExpBytecodeCache::Lookup& lookup) {
+                         cx->runtime()->regExpBytecodeCache().put(
+                             lookup, bytecode.get(), result.num_registers);
+                       });
     re->setByteCode(bytecode.release(), isLatin1);
     js::AddCellMemory(re, length, MemoryUse::RegExpSharedBytecode);
   }
@@ -632,10 +653,30 @@ bool CompilePattern(JSContext* cx, MutableHandleRegExpShared re,
 
   MOZ_ASSERT(re->kind() == RegExpShared::Kind::RegExp);
 
-  RegExpCompiler compiler(cx->isolate, &zone, data.capture_count,
-                          input->hasLatin1Chars());
-
   bool isLatin1 = input->hasLatin1Chars();
+  bool useNativeCode = codeKind == RegExpShared::CodeKind::Jitcode;
+  MOZ_ASSERT_IF(useNativeCode, IsNativeRegExpEnabled());
+
+  // Another zone, or the process that encoded the stencil of the script
+  // using this regexp, may have compiled it to bytecode already.
+  if (!useNativeCode) {
+    uint32_t maxRegisters = 0;
+    ByteArray bytecode = WithByteCodeLookup(
+        pattern, flags, isLatin1,
+        [&](const RegExpBytecodeCache::Lookup& lookup) {
+          return cx->runtime()->regExpBytecodeCache().lookup(lookup,
+                                                              &maxRegisters);
+        });
+    if (bytecode) {
+      uint32_t length = bytecode->length;
+      re->updateMaxRegisters(maxRegisters);
+      re->setByteCode(bytecode.release(), isLatin1);
+      js::AddCellMemory(re, length, MemoryUse::RegExpSharedBytecode);
+      return true;
+    }
+  }
+
+  RegExpCompiler compiler(cx->isolate, &zone, data.capture_count, isLatin1);
 
   FlatStringReader sample_subject(cx, input);
   SampleCharacters(&sample_subject, compiler);
@@ -647,9 +688,6 @@ bool CompilePattern(JSContext* cx, MutableHandleRegExpShared re,
     return false;
   }
 
-  bool useNativeCode = codeKind == RegExpShared::CodeKind::Jitcode;
-  MOZ_ASSERT_IF(useNativeCode, IsNativeRegExpEnabled());
-
   switch (Assemble(cx, &compiler, &data, re, pattern, &zone, useNativeCode,
                    isLatin1)) {
     case AssembleResult::TooLarge:
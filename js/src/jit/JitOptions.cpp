@@ -163,6 +163,11 @@ DefaultJitOptions::DefaultJitOptions() {
   // Duplicated in all.js - ensure both match.
   SET_DEFAULT(baselineJitWarmUpThreshold, 100);
 
+  // How many GCs in a row a script in a zone that keeps its JIT code must
+  // not have run for its Baseline code to be discarded anyway. 0 keeps the
+  // code for as long as the zone does.
+  SET_DEFAULT(baselineDiscardIdleGCs, 0);
+
   // How many invocations or loop iterations are needed before functions
   // are considered for trial inlining.
   SET_DEFAULT(trialInliningWarmUpThreshold, 500);
@@ -305,6 +305,13 @@ class alignas(uintptr_t) JitScript final : public TrailingArray {
   };
   Flags flags_ = {};  // Zero-initialize flags.
 
+  // The warm-up count seen by the last GC that kept this script's JIT code,
+  // and how many such GCs in a row saw it unchanged. Used to discard the
+  // Baseline code of scripts that have stopped running, see
+  // JitOptions.baselineDiscardIdleGCs.
+  uint32_t warmUpCountAtLastGC_ = 0;
+  uint32_t idleGCs_ = 0;
+
   js::UniquePtr<InliningRoot> inliningRoot_;
 
 #ifdef DEBUG
@@ -389,6 +396,20 @@ class alignas(uintptr_t) JitScript final : public TrailingArray {
   void incWarmUpCount(uint32_t amount) { icScript_.warmUpCount_ += amount; }
   void resetWarmUpCount(uint32_t count);
 
+  // Returns how many GCs in a row, including this one, the script hasn't run
+  // for. Only meaningful for scripts whose JIT code bumps the warm-up count.
+  uint32_t noteGCAndGetIdleGCs() {
+    if (warmUpCount() != warmUpCountAtLastGC_) {
+      warmUpCountAtLastGC_ = warmUpCount();
+      idleGCs_ = 0;
+    } else if (idleGCs_ < UINT32_MAX) {
+      idleGCs_++;
+    }
+    return idleGCs_;
+  }
+  uint32_t idleGCs() const { return idleGCs_; }
+  void resetIdleGCs() { idleGCs_ = 0; }
+
   void prepareForDestruction(Zone* zone) {
     // When the script contains pointers to nursery things, the store buffer can
     // contain entries that point into the stub space. Since we can destroy
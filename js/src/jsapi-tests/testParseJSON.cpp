@@ -15,6 +15,7 @@
 #include "js/MemoryFunctions.h"
 #include "js/Printf.h"
 #include "jsapi-tests/tests.h"
+#include "vm/NativeObject.h"  // js::NativeObject
 
 using namespace js;
 
@@ -354,3 +355,72 @@ inline bool TryParse(JSContext* cx, const char (&input)[N],
   return true;
 }
 END_TEST(testParseJSON_reviver)
+
+BEGIN_TEST(testParseJSON_longStrings) {
+  // String literals are scanned a word at a time, put the characters that
+  // need attention at every offset of a word, in both encodings.
+  JS::RootedValue v(cx);
+  EVAL(
+      "var ok = true;\n"
+      "for (var pad of ['', '\\u20ac']) {\n"
+      "  for (var i = 0; i < 20; i++) {\n"
+      "    var prefix = pad + 'x'.repeat(i);\n"
+      "    for (var special of ['\\n', '\"', '\\\\', '\\u0001', 'a']) {\n"
+      "      var s = prefix + special + 'y'.repeat(20 - i);\n"
+      "      ok = ok && JSON.parse(JSON.stringify(s)) === s;\n"
+      "      ok = ok && JSON.parse(JSON.stringify([s, s]))[1] === s;\n"
+      "    }\n"
+      "    try {\n"
+      "      JSON.parse('\"' + prefix + '\\u0001' + 'y'.repeat(20) + '\"');\n"
+      "      ok = false;\n"
+      "    } catch (e) {\n"
+      "      ok = ok && e instanceof SyntaxError &&\n"
+      "           e.message.includes('column ' + (prefix.length + 2) + ' ');\n"
+      "    }\n"
+      "  }\n"
+      "}\n"
+      "ok",
+      &v);
+  CHECK(v.isTrue());
+  return true;
+}
+END_TEST(testParseJSON_longStrings)
+
+BEGIN_TEST(testParseJSON_repeatedKeys) {
+  // Objects with the same keys at the same depth reuse the same shape, the
+  // others must not be confused with them.
+  const char* json =
+      "[{\"a\":1,\"b\":{\"c\":2}},{\"a\":3,\"b\":{\"c\":4}},"
+      "{\"b\":5,\"a\":6},{\"a\":7,\"b\":8,\"c\":9},{\"a\":10},"
+      "{\"a\":11,\"a\":12},{\"0\":13,\"a\":14},{\"a\":15,\"b\":16}]";
+
+  JS::RootedValue v(cx);
+  JS::RootedValue str(cx);
+  AutoInflatedString input(cx);
+  input = json;
+  CHECK(JS_ParseJSON(cx, input.chars(), input.length(), &v));
+
+  CHECK(JS_SetProperty(cx, global, "parsed", v));
+  EVAL("JSON.stringify(parsed)", &str);
+  CHECK(str.isString());
+  bool match;
+  CHECK(JS_StringEqualsAscii(
+      cx, str.toString(),
+      "[{\"a\":1,\"b\":{\"c\":2}},{\"a\":3,\"b\":{\"c\":4}},"
+      "{\"b\":5,\"a\":6},{\"a\":7,\"b\":8,\"c\":9},{\"a\":10},"
+      "{\"a\":12},{\"0\":13,\"a\":14},{\"a\":15,\"b\":16}]",
+      &match));
+  CHECK(match);
+
+  JS::RootedObject array(cx, &v.toObject());
+  JS::RootedValue first(cx), second(cx), last(cx);
+  CHECK(JS_GetElement(cx, array, 0, &first));
+  CHECK(JS_GetElement(cx, array, 1, &second));
+  CHECK(JS_GetElement(cx, array, 7, &last));
+  CHECK(first.toObject().as<NativeObject>().shape() ==
+        second.toObject().as<NativeObject>().shape());
+  CHECK(first.toObject().as<NativeObject>().shape() ==
+        last.toObject().as<NativeObject>().shape());
+  return true;
+}
+END_TEST(testParseJSON_repeatedKeys)
@@ -81,6 +81,47 @@ BEGIN_TEST(testStructuredClone_string) {
 }
 END_TEST(testStructuredClone_string)
 
+BEGIN_TEST(testStructuredClone_shapedObjects) {
+  // Runs of records sharing a shape, interleaved with records of other
+  // shapes, records with object values and more shapes than the writer keeps
+  // descriptors for.
+  JS::RootedValue v1(cx);
+  EVAL(
+      "var records = [];\n"
+      "for (var i = 0; i < 1000; i++) {\n"
+      "  records.push({id: i, subject: 'message ' + i, unread: i % 3 == 0});\n"
+      "  var other = {};\n"
+      "  other['key' + (i % 80)] = i % 2 ? 1.5 : 10n;\n"
+      "  records.push(other);\n"
+      "  if (i % 100 == 0) {\n"
+      "    records.push({id: i, thread: {id: i}});\n"
+      "  }\n"
+      "}\n"
+      "records",
+      &v1);
+
+  JS::RootedValue v2(cx);
+  CHECK(JS_StructuredClone(cx, v1, &v2, nullptr, nullptr));
+  CHECK(v2.isObject());
+  CHECK(&v1.toObject() != &v2.toObject());
+  CHECK(JS_SetProperty(cx, global, "copy", v2));
+
+  JS::RootedValue same(cx);
+  EVAL(
+      "function same(a, b) {\n"
+      "  if (typeof a != 'object') return a === b;\n"
+      "  var keys = Object.keys(a);\n"
+      "  return a !== b && keys.join() == Object.keys(b).join() &&\n"
+      "         keys.every(k => same(a[k], b[k]));\n"
+      "}\n"
+      "same(records, copy)",
+      &same);
+  CHECK(same.isTrue());
+
+  return true;
+}
+END_TEST(testStructuredClone_shapedObjects)
+
 BEGIN_TEST(testStructuredClone_externalArrayBuffer) {
   ExternalData data("One two three four");
   JS::RootedObject g1(cx, createGlobal());
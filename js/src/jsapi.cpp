@@ -5111,6 +5111,13 @@ JS_PUBLIC_API void JS_SetGlobalJitCompilerOption(JSContext* cx,
       }
       jit::JitOptions.baselineJitWarmUpThreshold = value;
       break;
+    case JSJITCOMPILER_BASELINE_DISCARD_IDLE_GCS:
+      if (value == uint32_t(-1)) {
+        jit::DefaultJitOptions defaultValues;
+        value = defaultValues.baselineDiscardIdleGCs;
+      }
+      jit::JitOptions.baselineDiscardIdleGCs = value;
+      break;
     case JSJITCOMPILER_IC_FORCE_MEGAMORPHIC:
       jit::JitOptions.forceMegamorphicICs = !!value;
       break;
@@ -5280,6 +5287,9 @@ JS_PUBLIC_API bool JS_GetGlobalJitCompilerOption(JSContext* cx,
     case JSJITCOMPILER_BASELINE_WARMUP_TRIGGER:
       *valueOut = jit::JitOptions.baselineJitWarmUpThreshold;
       break;
+    case JSJITCOMPILER_BASELINE_DISCARD_IDLE_GCS:
+      *valueOut = jit::JitOptions.baselineDiscardIdleGCs;
+      break;
     case JSJITCOMPILER_IC_FORCE_MEGAMORPHIC:
       *valueOut = jit::JitOptions.forceMegamorphicICs;
       break;
@@ -1726,6 +1726,7 @@ extern JS_PUBLIC_API void JS_SetOffthreadIonCompilationEnabled(JSContext* cx,
 #define JIT_COMPILER_OPTIONS(Register) \
   Register(BASELINE_INTERPRETER_WARMUP_TRIGGER, "blinterp.warmup.trigger") \
   Register(BASELINE_WARMUP_TRIGGER, "baseline.warmup.trigger") \
+  Register(BASELINE_DISCARD_IDLE_GCS, "baseline.discard-idle-gcs") \
   Register(IC_FORCE_MEGAMORPHIC, "ic.force-megamorphic") \
   Register(ION_NORMAL_WARMUP_TRIGGER, "ion.warmup.trigger") \
   Register(ION_GVN_ENABLE, "ion.gvn.enable") \
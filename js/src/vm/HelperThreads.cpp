@@ -1880,9 +1880,12 @@ HelperThreadTask* GlobalHelperThreadState::maybeGetParseTask(
     return nullptr;
   }
 
+  // Start with the oldest task. Embeddings usually queue scripts in the order
+  // they will run them, e.g. a page's deferred scripts in document order, so
+  // this gets the script that is waited for first done first.
   auto& worklist = parseWorklist(lock);
-  UniquePtr<ParseTask> task = std::move(worklist.back());
-  worklist.popBack();
+  UniquePtr<ParseTask> task = std::move(worklist[0]);
+  worklist.erase(&worklist[0]);
   return task.release();
 }
 
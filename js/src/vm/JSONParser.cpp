@@ -11,6 +11,9 @@
 #include "mozilla/Sprintf.h"
 #include "mozilla/TextUtils.h"
 
+#include <limits>
+#include <string.h>
+
 #include "jsnum.h"
 
 #include "builtin/Array.h"
@@ -20,6 +23,7 @@
 #include "vm/Realm.h"
 
 #include "vm/NativeObject-inl.h"
+#include "vm/PlainObject-inl.h"  // js::PlainObject::createWithTemplate
 
 using namespace js;
 
@@ -54,6 +58,10 @@ void JSONParserBase::trace(JSTracer* trc) {
       elem.properties().trace(trc);
     }
   }
+
+  for (auto& templateObject : shapeTemplates) {
+    TraceNullableRoot(trc, &templateObject, "JSONParser shape template");
+  }
 }
 
 template <typename CharT>
@@ -99,6 +107,37 @@ bool JSONParserBase::errorReturn() {
   return parseType == ParseType::AttemptForEval;
 }
 
+// Skip the characters of a string literal that need no special handling,
+// testing a word's worth of them at a time. Return the start of the first
+// word holding a '"', a '\\' or a control character, or of the last few
+// characters that don't fill a word: the caller looks at those one by one.
+template <typename CharT>
+static const CharT* SkipPlainStringChars(const CharT* ptr, const CharT* end) {
+  constexpr size_t CharsPerWord = sizeof(uint64_t) / sizeof(CharT);
+  // Words with every character set to 1, and to its high bit.
+  constexpr uint64_t Ones = UINT64_MAX / std::numeric_limits<CharT>::max();
+  constexpr uint64_t HighBits = Ones << (8 * sizeof(CharT) - 1);
+
+  while (size_t(end - ptr) >= CharsPerWord) {
+    uint64_t word;
+    memcpy(&word, ptr, sizeof(word));
+
+    // Subtracting n from a character sets its high bit if it is below n
+    // (and didn't have it set already). The borrow may flag the characters
+    // after that one too, but only when there is one to find.
+    uint64_t quote = word ^ (Ones * '"');
+    uint64_t backslash = word ^ (Ones * '\\');
+    uint64_t special = ((quote - Ones) & ~quote) |
+                       ((backslash - Ones) & ~backslash) |
+                       ((word - Ones * 0x20) & ~word);
+    if (special & HighBits) {
+      break;
+    }
+    ptr += CharsPerWord;
+  }
+  return ptr;
+}
+
 template <typename CharT>
 template <JSONParserBase::StringType ST>
 JSONParserBase::Token JSONParser<CharT>::readString() {
@@ -120,6 +159,7 @@ JSONParserBase::Token JSONParser<CharT>::readString() {
    * string directly from the source text.
    */
   CharPtr start = current;
+  current += SkipPlainStringChars(current.get(), end.get()) - current.get();
   for (; current < end; current++) {
     if (*current == '"') {
       size_t length = current - start;
@@ -244,6 +284,7 @@ JSONParserBase::Token JSONParser<CharT>::readString() {
     }
 
     start = current;
+    current += SkipPlainStringChars(current.get(), end.get()) - current.get();
     for (; current < end; current++) {
       if (*current == '"' || *current == '\\' || *current <= 0x001F) {
         break;
@@ -577,12 +618,62 @@ JSONParserBase::Token JSONParser<CharT>::advanceAfterProperty() {
   return token(Error);
 }
 
+// Whether |properties| are the properties of |templateObject|, in the same
+// order and without duplicates, so that an object with them can be created
+// with its shape. Dictionary mode objects are never used as templates.
+static bool MatchesShapeTemplate(PlainObject* templateObject,
+                                 const IdValuePair* properties,
+                                 size_t nproperties) {
+  if (templateObject->slotSpan() != nproperties) {
+    return false;
+  }
+
+  // Properties are iterated from the last one added.
+  size_t i = nproperties;
+  for (ShapePropertyIter<NoGC> iter(templateObject->shape()); !iter.done();
+       iter++) {
+    if (i == 0 || iter->key() != properties[i - 1].id) {
+      return false;
+    }
+    i--;
+    MOZ_ASSERT(iter->slot() == i);
+  }
+  return i == 0;
+}
+
+PlainObject* JSONParserBase::createFinishedObject(PropertyVector& properties) {
+  // JSON documents often hold many objects with the same keys, like the
+  // elements of an array. Objects at the same depth of the document are
+  // likely to be alike, so the last one created at each depth is kept as a
+  // template for the next: when they have the same keys, the new object is
+  // created with the template's shape and gets its values at once, instead
+  // of adding its properties one at a time.
+  size_t depth = std::min(stack.length(), ShapeTemplateDepths) - 1;
+  Rooted<PlainObject*> templateObject(cx, shapeTemplates[depth]);
+  if (templateObject && MatchesShapeTemplate(templateObject, properties.begin(),
+                                             properties.length())) {
+    PlainObject* obj;
+    JS_TRY_VAR_OR_RETURN_NULL(
+        cx, obj, PlainObject::createWithTemplate(cx, templateObject));
+    for (size_t i = 0; i < properties.length(); i++) {
+      obj->setSlot(i, properties[i].value);
+    }
+    return obj;
+  }
+
+  PlainObject* obj = NewPlainObjectWithProperties(
+      cx, properties.begin(), properties.length(), GenericObject);
+  if (obj && !properties.empty() && !obj->inDictionaryMode()) {
+    shapeTemplates[depth] = obj;
+  }
+  return obj;
+}
+
 inline bool JSONParserBase::finishObject(MutableHandleValue vp,
                                          PropertyVector& properties) {
   MOZ_ASSERT(&properties == &stack.back().properties());
 
-  JSObject* obj = NewPlainObjectWithProperties(
-      cx, properties.begin(), properties.length(), GenericObject);
+  JSObject* obj = createFinishedObject(properties);
   if (!obj) {
     return false;
   }
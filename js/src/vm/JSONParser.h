@@ -10,6 +10,9 @@
 #include "mozilla/Attributes.h"
 #include "mozilla/Range.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include "jspubtd.h"
 
 #include "ds/IdValuePair.h"
@@ -17,6 +20,8 @@
 
 namespace js {
 
+class PlainObject;
+
 // JSONParser base class. JSONParser is templatized to work on either Latin1
 // or TwoByte input strings, JSONParserBase holds all state and methods that
 // can be shared between the two encodings.
@@ -117,6 +122,12 @@ class MOZ_STACK_CLASS JSONParserBase {
   Vector<ElementVector*, 5> freeElements;
   Vector<PropertyVector*, 5> freeProperties;
 
+  // The last object created at each of the first depths of the document,
+  // whose shape the next object at that depth may reuse. See
+  // createFinishedObject.
+  static const size_t ShapeTemplateDepths = 8;
+  PlainObject* shapeTemplates[ShapeTemplateDepths] = {};
+
 #ifdef DEBUG
   Token lastToken;
 #endif
@@ -148,6 +159,8 @@ class MOZ_STACK_CLASS JSONParserBase {
         lastToken(std::move(other.lastToken))
 #endif
   {
+    std::copy(std::begin(other.shapeTemplates), std::end(other.shapeTemplates),
+              std::begin(shapeTemplates));
   }
 
   Value numberValue() const {
@@ -196,6 +209,7 @@ class MOZ_STACK_CLASS JSONParserBase {
 
   bool errorReturn();
 
+  PlainObject* createFinishedObject(PropertyVector& properties);
   bool finishObject(MutableHandleValue vp, PropertyVector& properties);
   bool finishArray(MutableHandleValue vp, ElementVector& elements);
 
@@ -0,0 +1,135 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "vm/RegExpBytecodeCache.h"
+
+#include "mozilla/HashFunctions.h"  // mozilla::HashString, mozilla::AddToHash
+
+#include <string.h>
+
+#include "threading/LockGuard.h"
+#include "util/Text.h"  // js::EqualChars
+#include "vm/MutexIDs.h"
+
+using namespace js;
+
+RegExpBytecodeCache::Lookup::Lookup(const JS::Latin1Char* source,
+                                    size_t length, JS::RegExpFlags flags,
+                                    bool latin1)
+    : latin1Source_(source),
+      length_(length),
+      flags_(flags),
+      latin1_(latin1),
+      hash_(mozilla::AddToHash(mozilla::HashString(source, length),
+                               flags.value(), latin1)) {}
+
+RegExpBytecodeCache::Lookup::Lookup(const char16_t* source, size_t length,
+                                    JS::RegExpFlags flags, bool latin1)
+    : twoByteSource_(source),
+      length_(length),
+      flags_(flags),
+      latin1_(latin1),
+      hash_(mozilla::AddToHash(mozilla::HashString(source, length),
+                               flags.value(), latin1)) {}
+
+/* static */
+bool RegExpBytecodeCache::Hasher::match(const UniquePtr<Entry>& entry,
+                                        const Lookup& l) {
+  if (entry->hash != l.hash_ || entry->length != l.length_ ||
+      entry->flags != l.flags_ || entry->latin1 != l.latin1_) {
+    return false;
+  }
+  if (l.latin1Source_) {
+    return EqualChars(l.latin1Source_, entry->source.get(), l.length_);
+  }
+  return EqualChars(l.twoByteSource_, entry->source.get(), l.length_);
+}
+
+static irregexp::ByteArray CopyByteCode(
+    const irregexp::ByteArrayData* byteCode) {
+  // The bytecode immediately follows its length, see ByteArrayData::data().
+  size_t size = sizeof(irregexp::ByteArrayData) + byteCode->length;
+  irregexp::ByteArray copy(
+      static_cast<irregexp::ByteArrayData*>(js_malloc(size)));
+  if (copy) {
+    memcpy(copy.get(), byteCode, size);
+  }
+  return copy;
+}
+
+RegExpBytecodeCache::RegExpBytecodeCache()
+    : lock_(mutexid::RegExpBytecodeCache) {}
+
+irregexp::ByteArray RegExpBytecodeCache::lookup(const Lookup& lookup,
+                                                uint32_t* maxRegisters) {
+  LockGuard<Mutex> guard(lock_);
+  Set::Ptr p = set_.lookup(lookup);
+  if (!p) {
+    return nullptr;
+  }
+  *maxRegisters = (*p)->maxRegisters;
+  return CopyByteCode((*p)->byteCode.get());
+}
+
+void RegExpBytecodeCache::put(const Lookup& lookup,
+                              const irregexp::ByteArrayData* byteCode,
+                              uint32_t maxRegisters) {
+  LockGuard<Mutex> guard(lock_);
+  if (bytes_ + byteCode->length > MaxBytes) {
+    return;
+  }
+
+  Set::AddPtr p = set_.lookupForAdd(lookup);
+  if (p) {
+    return;
+  }
+
+  UniquePtr<Entry> entry(js_new<Entry>());
+  if (!entry) {
+    return;
+  }
+  entry->source.reset(js_pod_malloc<char16_t>(lookup.length_));
+  entry->byteCode = CopyByteCode(byteCode);
+  if (!entry->source || !entry->byteCode) {
+    return;
+  }
+  if (lookup.latin1Source_) {
+    CopyAndInflateChars(entry->source.get(), lookup.latin1Source_,
+                        lookup.length_);
+  } else {
+    memcpy(entry->source.get(), lookup.twoByteSource_,
+           lookup.length_ * sizeof(char16_t));
+  }
+  entry->length = lookup.length_;
+  entry->flags = lookup.flags_;
+  entry->latin1 = lookup.latin1_;
+  entry->hash = lookup.hash_;
+  entry->maxRegisters = maxRegisters;
+
+  size_t length = entry->byteCodeLength();
+  if (!set_.add(p, std::move(entry))) {
+    return;
+  }
+  bytes_ += length;
+}
+
+void RegExpBytecodeCache::purge() {
+  LockGuard<Mutex> guard(lock_);
+  set_.clearAndCompact();
+  bytes_ = 0;
+}
+
+size_t RegExpBytecodeCache::sizeOfExcludingThis(
+    mozilla::MallocSizeOf mallocSizeOf) {
+  LockGuard<Mutex> guard(lock_);
+  size_t n = set_.shallowSizeOfExcludingThis(mallocSizeOf);
+  for (Set::Range r = set_.all(); !r.empty(); r.popFront()) {
+    const UniquePtr<Entry>& entry = r.front();
+    n += mallocSizeOf(entry.get()) + mallocSizeOf(entry->source.get()) +
+         mallocSizeOf(entry->byteCode.get());
+  }
+  return n;
+}
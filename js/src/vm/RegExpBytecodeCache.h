@@ -0,0 +1,114 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * vim: set ts=8 sts=2 et sw=2 tw=80:
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef vm_RegExpBytecodeCache_h
+#define vm_RegExpBytecodeCache_h
+
+#include "mozilla/MemoryReporting.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "irregexp/RegExpTypes.h"
+#include "js/AllocPolicy.h"
+#include "js/CharacterEncoding.h"  // JS::Latin1Char
+#include "js/HashTable.h"
+#include "js/RegExpFlags.h"  // JS::RegExpFlags
+#include "js/UniquePtr.h"
+#include "threading/Mutex.h"
+
+class JSLinearString;
+
+namespace js {
+
+/*
+ * The irregexp bytecode of the regexps compiled in the runtime, so that a
+ * regexp compiled in one zone doesn't have to be compiled again by the realms
+ * of other zones running the same one. It is also written along with the
+ * stencils of the scripts using those regexps, see StencilXDR, so that the
+ * next process decoding them doesn't have to compile them at all.
+ *
+ * Entries are keyed by the source and flags of the regexp and by whether the
+ * bytecode was compiled for Latin-1 or two-byte input. Each RegExpShared owns
+ * its bytecode, so lookups return a copy.
+ *
+ * The cache is filled from the main thread and from helper threads decoding
+ * stencils, hence the lock. It holds at most MaxBytes of bytecode and is
+ * emptied on shrinking GCs.
+ */
+class RegExpBytecodeCache {
+ public:
+  static const size_t MaxBytes = 512 * 1024;
+
+  // The source of a regexp, which is either a JSAtom or a ParserAtom.
+  class Lookup {
+    const JS::Latin1Char* latin1Source_ = nullptr;
+    const char16_t* twoByteSource_ = nullptr;
+    size_t length_;
+    JS::RegExpFlags flags_;
+    bool latin1_;
+    HashNumber hash_;
+
+    friend class RegExpBytecodeCache;
+
+   public:
+    // |latin1| is whether the bytecode is for Latin-1 input, whatever the
+    // encoding of the source.
+    Lookup(const JS::Latin1Char* source, size_t length, JS::RegExpFlags flags,
+           bool latin1);
+    Lookup(const char16_t* source, size_t length, JS::RegExpFlags flags,
+           bool latin1);
+
+    HashNumber hash() const { return hash_; }
+  };
+
+ private:
+  struct Entry {
+    UniqueTwoByteChars source;
+    size_t length;
+    JS::RegExpFlags flags;
+    bool latin1;
+    HashNumber hash;
+    uint32_t maxRegisters;
+    irregexp::ByteArray byteCode;
+
+    size_t byteCodeLength() const { return byteCode->length; }
+  };
+
+  struct Hasher {
+    using Lookup = RegExpBytecodeCache::Lookup;
+    static HashNumber hash(const Lookup& l) { return l.hash(); }
+    static bool match(const UniquePtr<Entry>& entry, const Lookup& l);
+  };
+
+  using Set = HashSet<UniquePtr<Entry>, Hasher, SystemAllocPolicy>;
+
+  Mutex lock_;
+  Set set_;
+  size_t bytes_ = 0;
+
+ public:
+  RegExpBytecodeCache();
+
+  /*
+   * Return a copy of the bytecode cached for |lookup| and set |maxRegisters|
+   * to the number of registers it uses, or return nullptr if there is none
+   * (or if copying it failed, which is not worth reporting).
+   */
+  irregexp::ByteArray lookup(const Lookup& lookup, uint32_t* maxRegisters);
+
+  // Cache a copy of |byteCode|. Failing to do so is not an error.
+  void put(const Lookup& lookup, const irregexp::ByteArrayData* byteCode,
+           uint32_t maxRegisters);
+
+  void purge();
+
+  size_t sizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf);
+};
+
+}  // namespace js
+
+#endif /* vm_RegExpBytecodeCache_h */
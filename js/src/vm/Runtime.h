@@ -60,6 +60,7 @@
 #include "vm/JSAtomState.h"
 #include "vm/JSScript.h"
 #include "vm/OffThreadPromiseRuntimeState.h"  // js::OffThreadPromiseRuntimeState
+#include "vm/RegExpBytecodeCache.h"
 #include "vm/Scope.h"
 #include "vm/SharedImmutableStringsCache.h"
 #include "vm/SharedStencil.h"  // js::SharedImmutableScriptDataTable
@@ -1036,6 +1037,16 @@ struct JSRuntime {
  public:
   js::RuntimeCaches& caches() { return caches_.ref(); }
 
+ private:
+  // Bytecode of the regexps compiled by any zone, accessed from the main
+  // thread and from helper threads decoding stencils.
+  js::RegExpBytecodeCache regExpBytecodeCache_;
+
+ public:
+  js::RegExpBytecodeCache& regExpBytecodeCache() {
+    return regExpBytecodeCache_;
+  }
+
   // List of all the live wasm::Instances in the runtime. Equal to the union
   // of all instances registered in all JS::Realms. Accessed from watchdog
   // threads for purposes of wasm::InterruptRunningCode().
@@ -45,6 +45,7 @@
 
 #include "builtin/DataViewObject.h"
 #include "builtin/MapObject.h"
+#include "ds/IdValuePair.h"
 #include "js/Array.h"        // JS::GetArrayLength, JS::IsArrayObject
 #include "js/ArrayBuffer.h"  // JS::{ArrayBufferHasData,DetachArrayBuffer,IsArrayBufferObject,New{,Mapped}ArrayBufferWithContents,ReleaseMappedArrayBufferContents}
 #include "js/Date.h"
@@ -67,6 +68,7 @@
 #include "wasm/WasmJS.h"
 
 #include "vm/InlineCharBuffer-inl.h"
+#include "vm/JSAtom-inl.h"
 #include "vm/JSContext-inl.h"
 #include "vm/JSObject-inl.h"
 
@@ -136,6 +138,10 @@ enum StructuredDataType : uint32_t {
   SCTAG_TYPED_ARRAY_OBJECT,
   SCTAG_DATA_VIEW_OBJECT,
 
+  // Only written for SameProcess clones, which are never persisted and are
+  // always read by the build that wrote them.
+  SCTAG_SHAPED_OBJECT,
+
   SCTAG_TYPED_ARRAY_V1_MIN = 0xFFFF0100,
   SCTAG_TYPED_ARRAY_V1_INT8 = SCTAG_TYPED_ARRAY_V1_MIN + Scalar::Int8,
   SCTAG_TYPED_ARRAY_V1_UINT8 = SCTAG_TYPED_ARRAY_V1_MIN + Scalar::Uint8,
@@ -411,6 +417,8 @@ struct JSStructuredCloneReader {
         cloneDataPolicy(cloneDataPolicy),
         objs(in.context()),
         allObjs(in.context()),
+        shapedObjectKeys(in.context()),
+        shapedObjectStarts(in.context()),
         callbacks(cb),
         closure(cbClosure) {}
 
@@ -440,6 +448,7 @@ struct JSStructuredCloneReader {
   [[nodiscard]] bool readV1ArrayBuffer(uint32_t arrayType, uint32_t nelems,
                                        MutableHandleValue vp);
   JSObject* readSavedFrame(uint32_t principalsTag);
+  [[nodiscard]] bool readShapedObject(uint32_t index, MutableHandleValue vp);
   [[nodiscard]] bool startRead(MutableHandleValue vp,
                                gc::InitialHeap strHeap = gc::DefaultHeap);
 
@@ -469,6 +478,12 @@ struct JSStructuredCloneReader {
   // one `undefined` placeholder value (the readTypedArray hack).
   RootedValueVector allObjs;
 
+  // The keys of every shaped object descriptor read so far, one descriptor
+  // after the other; the keys of descriptor i start at shapedObjectKeys[
+  // shapedObjectStarts[i]].
+  RootedIdVector shapedObjectKeys;
+  Vector<size_t> shapedObjectStarts;
+
   // The user defined callbacks that will be used for cloning.
   const JSStructuredCloneCallbacks* callbacks;
 
@@ -496,6 +511,7 @@ struct JSStructuredCloneWriter {
         memory(out.context()),
         transferable(out.context(), tVal),
         transferableObjects(out.context(), TransferableObjectsSet(cx)),
+        shapedObjectShapes(out.context(), ShapeVector(cx)),
         cloneDataPolicy(cloneDataPolicy) {
     out.setCallbacks(cb, cbClosure, OwnTransferablePolicy::NoTransferables);
   }
@@ -532,6 +548,7 @@ struct JSStructuredCloneWriter {
   bool writeSharedWasmMemory(HandleObject obj);
   bool startObject(HandleObject obj, bool* backref);
   bool startWrite(HandleValue v);
+  bool writeShapedObject(HandleObject obj, bool* written);
   bool traverseObject(HandleObject obj, ESClass cls);
   bool traverseMap(HandleObject obj);
   bool traverseSet(HandleObject obj);
@@ -592,6 +609,10 @@ struct JSStructuredCloneWriter {
       TransferableObjectsSet;
   Rooted<TransferableObjectsSet> transferableObjects;
 
+  // The shape of each shaped object descriptor written so far, indexed by
+  // descriptor number. See writeShapedObject.
+  Rooted<ShapeVector> shapedObjectShapes;
+
   const JS::CloneDataPolicy cloneDataPolicy;
 
   friend bool JS_WriteString(JSStructuredCloneWriter* w, HandleString str);
@@ -1479,6 +1500,95 @@ static bool TryAppendNativeProperties(JSContext* cx, HandleObject obj,
   return true;
 }
 
+// Plain objects whose enumerable properties are all data properties holding
+// primitives don't need the objs stack: nothing can run while their values
+// are written, so they are written in one go as
+//
+//     <SCTAG_SHAPED_OBJECT, descriptor number>
+//       [<property count> <key data>...]
+//       <value data>...
+//
+// where the keys are only present the first time a shape is seen. Every later
+// object with that shape refers to the same descriptor, so an array of
+// records costs a descriptor plus the packed values of each record, and the
+// reader doesn't have to read and atomize the same keys over and over.
+//
+// This is only done for SameProcess clones, which are never persisted.
+static const size_t MaxShapedObjectDescriptors = 64;
+
+bool JSStructuredCloneWriter::writeShapedObject(HandleObject obj,
+                                                bool* written) {
+  *written = false;
+
+  if (out.scope() != JS::StructuredCloneScope::SameProcess ||
+      !obj->is<PlainObject>()) {
+    return true;
+  }
+
+  Handle<PlainObject*> nobj = obj.as<PlainObject>();
+  if (nobj->isIndexed() || nobj->getDenseInitializedLength() != 0) {
+    return true;
+  }
+
+  uint32_t index = 0;
+  while (index < shapedObjectShapes.length() &&
+         shapedObjectShapes[index] != nobj->shape()) {
+    index++;
+  }
+  bool isNew = index == shapedObjectShapes.length();
+  if (isNew && index == MaxShapedObjectDescriptors) {
+    return true;
+  }
+
+  // The properties come last to first, like in TryAppendNativeProperties.
+  RootedIdVector keys(context());
+  RootedValueVector values(context());
+  for (ShapePropertyIter<NoGC> iter(nobj->shape()); !iter.done(); iter++) {
+    // Symbols and non-enumerable properties are skipped, as usual.
+    if (!iter->enumerable() || iter->key().isSymbol()) {
+      continue;
+    }
+
+    if (!iter->isDataProperty()) {
+      return true;
+    }
+    const Value& v = nobj->getSlot(iter->slot());
+    if (v.isObject()) {
+      return true;
+    }
+
+    MOZ_ASSERT(JSID_IS_STRING(iter->key()));
+    if ((isNew && !keys.append(iter->key())) || !values.append(v)) {
+      return false;
+    }
+  }
+
+  if (isNew && !shapedObjectShapes.append(nobj->shape())) {
+    return false;
+  }
+
+  *written = true;
+  if (!out.writePair(SCTAG_SHAPED_OBJECT, index)) {
+    return false;
+  }
+  if (isNew) {
+    if (!out.write(keys.length())) {
+      return false;
+    }
+    for (size_t i = keys.length(); i > 0; --i) {
+      if (!writeString(SCTAG_STRING, JSID_TO_STRING(keys[i - 1]))) {
+        return false;
+      }
+    }
+  }
+  for (size_t i = values.length(); i > 0; --i) {
+    if (!startWrite(values[i - 1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Objects are written as a "preorder" traversal of the object graph: object
 // "headers" (the class tag and any data needed for initial construction) are
 // visited first, then the children are recursed through (where children are
@@ -1505,6 +1615,16 @@ static bool TryAppendNativeProperties(JSContext* cx, HandleObject obj,
 // ends with its end-of-children marker) and so it can be presented indented.
 // But see traverseMap below for how this looks different for Maps.
 bool JSStructuredCloneWriter::traverseObject(HandleObject obj, ESClass cls) {
+  if (cls == ESClass::Object) {
+    bool written;
+    if (!writeShapedObject(obj, &written)) {
+      return false;
+    }
+    if (written) {
+      return true;
+    }
+  }
+
   size_t count;
   bool optimized = false;
   if (!TryAppendNativeProperties(context(), obj, &objectEntries, &count,
@@ -2702,6 +2822,13 @@ bool JSStructuredCloneReader::startRead(MutableHandleValue vp,
       break;
     }
 
+    case SCTAG_SHAPED_OBJECT: {
+      if (!readShapedObject(data, vp)) {
+        return false;
+      }
+      break;
+    }
+
     case SCTAG_BACK_REFERENCE_OBJECT: {
       if (data >= allObjs.length() || !allObjs[data].isObject()) {
         JS_ReportErrorNumberASCII(context(), GetErrorMessage, nullptr,
@@ -3157,6 +3284,90 @@ JSObject* JSStructuredCloneReader::readSavedFrame(uint32_t principalsTag) {
   return savedFrame;
 }
 
+// Read an object written by JSStructuredCloneWriter::writeShapedObject.
+bool JSStructuredCloneReader::readShapedObject(uint32_t index,
+                                               MutableHandleValue vp) {
+  JSContext* cx = context();
+
+  if (allowedScope != JS::StructuredCloneScope::SameProcess ||
+      index > shapedObjectStarts.length()) {
+    JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr,
+                              JSMSG_SC_BAD_SERIALIZED_DATA,
+                              "invalid shaped object");
+    return false;
+  }
+
+  if (index == shapedObjectStarts.length()) {
+    uint64_t count;
+    if (!in.read(&count) ||
+        !shapedObjectStarts.append(shapedObjectKeys.length())) {
+      return false;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+      uint32_t tag, data;
+      if (!in.readPair(&tag, &data)) {
+        return false;
+      }
+      if (tag != SCTAG_STRING) {
+        JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr,
+                                  JSMSG_SC_BAD_SERIALIZED_DATA,
+                                  "property key expected");
+        return false;
+      }
+      JSString* str = readString(data, gc::TenuredHeap);
+      if (!str) {
+        return false;
+      }
+      JSAtom* atom = AtomizeString(cx, str);
+      if (!atom || !shapedObjectKeys.append(AtomToId(atom))) {
+        return false;
+      }
+    }
+  }
+
+  size_t start = shapedObjectStarts[index];
+  size_t end = index + 1 < shapedObjectStarts.length()
+                   ? shapedObjectStarts[index + 1]
+                   : shapedObjectKeys.length();
+
+  Rooted<IdValueVector> props(cx, IdValueVector(cx));
+  if (!props.reserve(end - start)) {
+    return false;
+  }
+  RootedValue val(cx);
+  for (size_t i = start; i < end; i++) {
+    // The values are all primitives, so this doesn't nest.
+    uint32_t tag, data;
+    if (!in.getPair(&tag, &data)) {
+      return false;
+    }
+    if (tag == SCTAG_SHAPED_OBJECT) {
+      JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr,
+                                JSMSG_SC_BAD_SERIALIZED_DATA,
+                                "invalid shaped object value");
+      return false;
+    }
+    if (!startRead(&val)) {
+      return false;
+    }
+    if (val.isObject()) {
+      JS_ReportErrorNumberASCII(cx, GetErrorMessage, nullptr,
+                                JSMSG_SC_BAD_SERIALIZED_DATA,
+                                "invalid shaped object value");
+      return false;
+    }
+    props.infallibleAppend(IdValuePair(shapedObjectKeys[i], val));
+  }
+
+  PlainObject* obj = NewPlainObjectWithProperties(cx, props.begin(),
+                                                  props.length(), GenericObject);
+  if (!obj) {
+    return false;
+  }
+  vp.setObject(*obj);
+  return true;
+}
+
 // Class for counting "children" (actually parent frames) of the SavedFrames on
 // the `objs` stack. When a SavedFrame is complete, it should have exactly 1
 // parent frame.
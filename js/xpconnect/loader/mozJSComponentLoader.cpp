@@ -39,6 +39,7 @@
 #include "nsIFileURL.h"
 #include "nsIJARURI.h"
 #include "nsIChannel.h"
+#include "nsIObserverService.h"
 #include "nsNetUtil.h"
 #include "nsJSPrincipals.h"
 #include "nsJSUtils.h"
@@ -62,6 +63,7 @@
 #include "mozilla/ResultExtensions.h"
 #include "mozilla/ScriptPreloader.h"
 #include "mozilla/ScopeExit.h"
+#include "mozilla/Services.h"
 #include "mozilla/dom/AutoEntryScript.h"
 #include "mozilla/dom/ScriptSettings.h"
 #include "mozilla/ResultExtensions.h"
@@ -97,6 +99,8 @@ static LazyLogModule gJSCLLog("JSComponentLoader");
   "%s - Error getting array length of EXPORTED_SYMBOLS."
 #define ERROR_ARRAY_ELEMENT "%s - EXPORTED_SYMBOLS[%d] is not a string."
 #define ERROR_GETTING_SYMBOL "%s - Could not get symbol '%s'."
+#define LOAD_REPORT_TOPIC "jsloader-load-report"
+
 #define ERROR_SETTING_SYMBOL "%s - Could not set symbol '%s' on target object."
 #define ERROR_UNINITIALIZED_SYMBOL \
   "%s - Symbol '%s' accessed before initialization. Cyclic import?"
@@ -190,7 +194,7 @@ static nsresult MOZ_FORMAT_PRINTF(2, 3)
   return NS_OK;
 }
 
-NS_IMPL_ISUPPORTS(mozJSComponentLoader, nsIMemoryReporter)
+NS_IMPL_ISUPPORTS(mozJSComponentLoader, nsIMemoryReporter, nsIObserver)
 
 mozJSComponentLoader::mozJSComponentLoader()
     : mModules(16),
@@ -369,10 +373,12 @@ const mozilla::Module* mozJSComponentLoader::LoadModule(FileLocation& aFile) {
 
   auto entry = MakeUnique<ModuleEntry>(RootingContext::get(cx));
   RootedValue exn(cx);
+  entry->loadStart = TimeStamp::Now();
   rv = ObjectForLocation(info, file, &entry->obj, &entry->thisObjectKey,
                          &entry->location, /* aPropagateExceptions */ false,
                          &exn);
   NS_ENSURE_SUCCESS(rv, nullptr);
+  entry->loadDuration = TimeStamp::Now() - entry->loadStart;
 
   nsCOMPtr<nsIComponentManager> cm;
   rv = NS_GetComponentManager(getter_AddRefs(cm));
@@ -459,6 +465,11 @@ void mozJSComponentLoader::InitStatics() {
   MOZ_ASSERT(!sSelf);
   sSelf = new mozJSComponentLoader();
   RegisterWeakMemoryReporter(sSelf);
+
+  nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+  if (obs) {
+    obs->AddObserver(sSelf, LOAD_REPORT_TOPIC, false);
+  }
 }
 
 void mozJSComponentLoader::Unload() {
@@ -470,6 +481,11 @@ void mozJSComponentLoader::Unload() {
 void mozJSComponentLoader::Shutdown() {
   MOZ_ASSERT(sSelf);
   UnregisterWeakMemoryReporter(sSelf);
+
+  nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+  if (obs) {
+    obs->RemoveObserver(sSelf, LOAD_REPORT_TOPIC);
+  }
   sSelf = nullptr;
 }
 
@@ -562,6 +578,52 @@ mozJSComponentLoader::CollectReports(nsIHandleReportCallback* aHandleReport,
   return NS_OK;
 }
 
+NS_IMETHODIMP
+mozJSComponentLoader::Observe(nsISupports* aSubject, const char* aTopic,
+                              const char16_t* aData) {
+  if (!strcmp(aTopic, LOAD_REPORT_TOPIC)) {
+    DumpLoadReport();
+  }
+  return NS_OK;
+}
+
+void mozJSComponentLoader::DumpLoadReport() {
+  struct Load {
+    const ModuleEntry* mEntry;
+    const char* mKind;
+
+    bool operator<(const Load& aOther) const {
+      return mEntry->loadStart < aOther.mEntry->loadStart;
+    }
+    bool operator==(const Load& aOther) const {
+      return mEntry->loadStart == aOther.mEntry->loadStart;
+    }
+  };
+
+  nsTArray<Load> loads(mImports.Count() + mModules.Count());
+  for (const auto& entry : mImports.Values()) {
+    loads.AppendElement(Load{entry.get(), "module"});
+  }
+  for (const auto& entry : mModules.Values()) {
+    loads.AppendElement(Load{entry, "component"});
+  }
+  loads.Sort();
+
+  // One line per load, as logcat truncates long ones. Times are in ms, |at|
+  // since the process was created, so that what was loaded at boot stands
+  // out from what was loaded on demand. |ms| includes the modules imported
+  // meanwhile, which are listed after.
+  TimeStamp processCreation = TimeStamp::ProcessCreation();
+  for (const Load& load : loads) {
+    printf_stderr(
+        "JSM_LOADS: {\"uri\":\"%s\",\"kind\":\"%s\",\"at\":%.0f,"
+        "\"ms\":%.1f}\n",
+        load.mEntry->location ? load.mEntry->location : "", load.mKind,
+        (load.mEntry->loadStart - processCreation).ToMilliseconds(),
+        load.mEntry->loadDuration.ToMilliseconds());
+  }
+}
+
 void mozJSComponentLoader::CreateLoaderGlobal(JSContext* aCx,
                                               const nsACString& aLocation,
                                               MutableHandleObject aGlobal) {
@@ -1272,9 +1334,11 @@ nsresult mozJSComponentLoader::Import(JSContext* aCx,
       auto cleanup =
           MakeScopeExit([&]() { mInProgressImports.Remove(info.Key()); });
 
+      newEntry->loadStart = TimeStamp::Now();
       rv = ObjectForLocation(info, sourceFile, &newEntry->obj,
                              &newEntry->thisObjectKey, &newEntry->location,
                              true, &exception);
+      newEntry->loadDuration = TimeStamp::Now() - newEntry->loadStart;
     }
 
     if (NS_FAILED(rv)) {
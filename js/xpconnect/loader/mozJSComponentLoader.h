@@ -12,8 +12,10 @@
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/Module.h"
 #include "mozilla/StaticPtr.h"
+#include "mozilla/TimeStamp.h"
 #include "mozilla/UniquePtr.h"
 #include "nsIMemoryReporter.h"
+#include "nsIObserver.h"
 #include "nsISupports.h"
 #include "nsIURI.h"
 #include "nsClassHashtable.h"
@@ -34,10 +36,12 @@ class ScriptPreloader;
 #  define STARTUP_RECORDER_ENABLED
 #endif
 
-class mozJSComponentLoader final : public nsIMemoryReporter {
+class mozJSComponentLoader final : public nsIMemoryReporter,
+                                   public nsIObserver {
  public:
   NS_DECL_ISUPPORTS
   NS_DECL_NSIMEMORYREPORTER
+  NS_DECL_NSIOBSERVER
 
   void GetLoadedModules(nsTArray<nsCString>& aLoadedModules);
   void GetLoadedComponents(nsTArray<nsCString>& aLoadedComponents);
@@ -85,6 +89,10 @@ class mozJSComponentLoader final : public nsIMemoryReporter {
 
   void UnloadModules();
 
+  // Dumps the modules and components loaded so far, with when they were
+  // loaded and how long that took, as "JSM_LOADS:" JSON lines.
+  void DumpLoadReport();
+
   void CreateLoaderGlobal(JSContext* aCx, const nsACString& aLocation,
                           JS::MutableHandleObject aGlobal);
 
@@ -157,6 +165,10 @@ class mozJSComponentLoader final : public nsIMemoryReporter {
         const mozilla::Module& module, const mozilla::Module::CIDEntry& entry);
 
     nsCOMPtr<xpcIJSGetFactory> getfactoryobj;
+    // When the module started loading, and how long compiling and running
+    // it took, including the modules it imported meanwhile.
+    mozilla::TimeStamp loadStart;
+    mozilla::TimeDuration loadDuration;
     JS::PersistentRootedObject obj;
     JS::PersistentRootedObject exports;
     JS::PersistentRootedScript thisObjectKey;
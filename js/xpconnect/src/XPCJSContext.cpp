@@ -863,9 +863,21 @@ static void LoadStartupJSPrefs(XPCJSContext* xpccx) {
   JS_SetGlobalJitCompilerOption(
       cx, JSJITCOMPILER_BASELINE_WARMUP_TRIGGER,
       StaticPrefs::javascript_options_baselinejit_threshold_DoNotUseDirectly());
-  JS_SetGlobalJitCompilerOption(
-      cx, JSJITCOMPILER_ION_NORMAL_WARMUP_TRIGGER,
-      StaticPrefs::javascript_options_ion_threshold_DoNotUseDirectly());
+  int32_t ionThreshold =
+      StaticPrefs::javascript_options_ion_threshold_DoNotUseDirectly();
+  int32_t baselineIdleGCs = 0;
+  if (StaticPrefs::javascript_options_jit_small_memory_DoNotUseDirectly()) {
+    ionThreshold = std::max(
+        ionThreshold,
+        StaticPrefs::
+            javascript_options_jit_small_memory_ion_threshold_DoNotUseDirectly());
+    baselineIdleGCs = StaticPrefs::
+        javascript_options_jit_small_memory_baseline_idle_gcs_DoNotUseDirectly();
+  }
+  JS_SetGlobalJitCompilerOption(cx, JSJITCOMPILER_ION_NORMAL_WARMUP_TRIGGER,
+                                ionThreshold);
+  JS_SetGlobalJitCompilerOption(cx, JSJITCOMPILER_BASELINE_DISCARD_IDLE_GCS,
+                                baselineIdleGCs);
   JS_SetGlobalJitCompilerOption(
       cx, JSJITCOMPILER_ION_FREQUENT_BAILOUT_THRESHOLD,
       StaticPrefs::
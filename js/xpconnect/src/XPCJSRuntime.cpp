@@ -1909,6 +1909,10 @@ void ReportJSRuntimeExplicitTreeStats(const JS::RuntimeStats& rtStats,
                 rtStats.runtime.uncompressedSourceCache,
                 "The uncompressed source code cache.");
 
+  RREPORT_BYTES(rtPath + "runtime/regexp-bytecode-cache"_ns, KIND_HEAP,
+                rtStats.runtime.regExpBytecodeCache,
+                "The bytecode of the regexps compiled in the runtime.");
+
   RREPORT_BYTES(rtPath + "runtime/script-data"_ns, KIND_HEAP,
                 rtStats.runtime.scriptData,
                 "The table holding script data shared in the runtime.");
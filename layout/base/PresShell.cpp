@@ -77,6 +77,7 @@
 #include "nsTArray.h"
 #include "nsCOMArray.h"
 #include "nsContainerFrame.h"
+#include "nsBlockFrame.h"
 #include "mozilla/dom/Selection.h"
 #include "nsGkAtoms.h"
 #include "nsRange.h"
@@ -835,6 +836,8 @@ PresShell::PresShell(Document* aDocument)
       mWasLastReflowInterrupted(false),
       mObservingStyleFlushes(false),
       mObservingLayoutFlushes(false),
+      mInRefreshDriverLayoutFlush(false),
+      mNeedContentRelevanceUpdate(false),
       mResizeEventPending(false),
       mFontSizeInflationForceEnabled(false),
       mFontSizeInflationDisabledInMasterProcess(false),
@@ -4245,7 +4248,21 @@ void PresShell::DoFlushPendingNotifications(mozilla::ChangesToFlush aFlush) {
         !mIsDestroying) {
       didLayoutFlush = true;
       mFrameConstructor->RecalcQuotesAndCounters();
-      if (ProcessReflowCommands(flushType < FlushType::Layout)) {
+      const bool interruptible = flushType < FlushType::Layout;
+      if (!mInRefreshDriverLayoutFlush) {
+        UnskipAllContent();
+      } else if (mNeedContentRelevanceUpdate) {
+        UpdateContentRelevance();
+      }
+      bool completed = ProcessReflowCommands(interruptible);
+      // Frames that skipped their contents have been placed now, lay out the
+      // ones that are near the viewport before they are painted. Their size
+      // doesn't depend on their contents, so that doesn't move anything.
+      if (completed && mNeedContentRelevanceUpdate &&
+          UpdateContentRelevance()) {
+        completed = ProcessReflowCommands(interruptible);
+      }
+      if (completed) {
         if (mContentToScrollTo) {
           DoScrollContentIntoView();
           if (mContentToScrollTo) {
@@ -9419,7 +9436,10 @@ void PresShell::MaybeScheduleReflow() {
       mDirtyRoots.IsEmpty())
     return;
 
-  if (!mPresContext->HasPendingInterrupt() || !ScheduleReflowOffTimer()) {
+  // Reflows interrupted at a deadline continue on the next tick, those
+  // interrupted for input once the input had a chance to be handled.
+  if (!mPresContext->HasPendingInterrupt() ||
+      mPresContext->HasReflowDeadline() || !ScheduleReflowOffTimer()) {
     ScheduleReflow();
   }
 
@@ -9996,6 +10016,126 @@ void PresShell::DoObserveStyleFlushes() {
   }
 }
 
+static LazyLogModule sContentSkippingLog("ContentSkipping");
+
+bool PresShell::CanSkipContent() const {
+  return mInRefreshDriverLayoutFlush &&
+         StaticPrefs::layout_contain_skip_offscreen_content_enabled();
+}
+
+void PresShell::DidSkipContent(nsIFrame* aFrame) {
+  aFrame->SetProperty(nsBlockFrame::ContentSkipStateProperty(),
+                      nsBlockFrame::ContentSkipState::Skipped);
+  mContentSkippingFrames.Insert(aFrame);
+  mNeedContentRelevanceUpdate = true;
+}
+
+void PresShell::ScheduleContentRelevanceUpdate() {
+  if (mContentSkippingFrames.IsEmpty() || mNeedContentRelevanceUpdate ||
+      mIsDestroying) {
+    return;
+  }
+  mNeedContentRelevanceUpdate = true;
+  SetNeedLayoutFlush();
+  if (!ObservingLayoutFlushes() && !mReflowContinueTimer) {
+    DoObserveLayoutFlushes();
+  }
+}
+
+// Whether aFrame is near enough to what its scroll frame shows, or is about
+// to show, for its contents to be laid out.
+static bool IsNearScrollPort(nsIFrame* aFrame) {
+  nsIScrollableFrame* sf = nsLayoutUtils::GetNearestScrollableFrame(
+      aFrame->GetParent(), nsLayoutUtils::SCROLLABLE_SAME_DOC |
+                               nsLayoutUtils::SCROLLABLE_INCLUDE_HIDDEN);
+  if (!sf) {
+    // Nothing can scroll it into view.
+    return true;
+  }
+
+  nsIFrame* scrolledFrame = sf->GetScrolledFrame();
+  nsRect rect = aFrame->GetRectRelativeToSelf() +
+                aFrame->GetOffsetTo(scrolledFrame);
+  nsRect area(sf->GetScrollPosition(), sf->GetScrollPortRect().Size());
+  nsIFrame* scrollFrame = do_QueryFrame(sf);
+  nsRect displayPort;
+  if (DisplayPortUtils::GetDisplayPort(scrollFrame->GetContent(),
+                                       &displayPort)) {
+    area = area.Union(displayPort);
+  }
+  float margin =
+      StaticPrefs::layout_contain_skip_offscreen_content_margin_percent() /
+      100.0f;
+  area.Inflate(NSToCoordRound(area.width * margin),
+               NSToCoordRound(area.height * margin));
+
+  // Inclusive, as empty frames still count.
+  return rect.XMost() >= area.x && rect.x <= area.XMost() &&
+         rect.YMost() >= area.y && rect.y <= area.YMost();
+}
+
+bool PresShell::UpdateContentRelevance() {
+  MOZ_ASSERT(!mIsReflowing);
+  mNeedContentRelevanceUpdate = false;
+
+  using ContentSkipState = nsBlockFrame::ContentSkipState;
+  uint32_t skipped = 0;
+  uint32_t unskipped = 0;
+  mContentSkippingFrames.RemoveIf([&](nsIFrame* aFrame) {
+    const bool isNear = IsNearScrollPort(aFrame);
+    bool wasSkipped = aFrame->GetProperty(
+                          nsBlockFrame::ContentSkipStateProperty()) ==
+                      ContentSkipState::Skipped;
+    if (!isNear) {
+      if (wasSkipped) {
+        skipped++;
+        return false;
+      }
+      // Its contents are laid out, they'll be skipped from its next reflow
+      // on.
+      aFrame->RemoveProperty(nsBlockFrame::ContentSkipStateProperty());
+      return true;
+    }
+    if (wasSkipped) {
+      aFrame->SetProperty(nsBlockFrame::ContentSkipStateProperty(),
+                          ContentSkipState::Relevant);
+      FrameNeedsReflow(aFrame, IntrinsicDirty::Resize, NS_FRAME_IS_DIRTY);
+      // Its contents were never painted.
+      aFrame->InvalidateFrameSubtree();
+      unskipped++;
+    }
+    return false;
+  });
+
+  MOZ_LOG(sContentSkippingLog, LogLevel::Debug,
+          ("PresShell %p: %u frames skipping their contents, %u no longer",
+           this, skipped, unskipped));
+  return unskipped > 0;
+}
+
+void PresShell::UnskipAllContent() {
+  if (mContentSkippingFrames.IsEmpty()) {
+    return;
+  }
+  mNeedContentRelevanceUpdate = false;
+
+  uint32_t unskipped = 0;
+  mContentSkippingFrames.RemoveIf([&](nsIFrame* aFrame) {
+    if (aFrame->GetProperty(nsBlockFrame::ContentSkipStateProperty()) ==
+        nsBlockFrame::ContentSkipState::Skipped) {
+      FrameNeedsReflow(aFrame, IntrinsicDirty::Resize, NS_FRAME_IS_DIRTY);
+      aFrame->InvalidateFrameSubtree();
+      unskipped++;
+    }
+    aFrame->RemoveProperty(nsBlockFrame::ContentSkipStateProperty());
+    return true;
+  });
+
+  MOZ_LOG(sContentSkippingLog, LogLevel::Debug,
+          ("PresShell %p: laying out the contents of %u frames for a flush",
+           this, unskipped));
+}
+
 void PresShell::DoObserveLayoutFlushes() {
   MOZ_ASSERT(!ObservingLayoutFlushes());
   mObservingLayoutFlushes = true;
@@ -1426,6 +1426,22 @@ class PresShell final : public nsStubDocumentObserver,
       nsIFrame* aFrame, IntrinsicDirty aIntrinsicDirty, nsFrameState aBitToAdd,
       ReflowRootHandling aRootHandling = ReflowRootHandling::InferFromBitToAdd);
 
+  /**
+   * Blocks with size, layout and paint containment don't lay out their
+   * contents while they are far from the viewport, which containment allows,
+   * see nsBlockFrame::ShouldSkipContent. Only reflows for the refresh driver
+   * skip contents; the pres shell keeps track of the frames that did, lays
+   * them out once they get near what their scroll frame shows, and before any
+   * other layout flush, since whoever flushes wants to look at the geometry.
+   */
+  bool CanSkipContent() const;
+  void DidSkipContent(nsIFrame* aFrame);
+  void ForgetContentSkippingFrame(nsIFrame* aFrame) {
+    mContentSkippingFrames.Remove(aFrame);
+  }
+  // Called when something scrolled, which may bring skipped contents near.
+  void ScheduleContentRelevanceUpdate();
+
   /**
    * Calls FrameNeedsReflow on all fixed position children of the root frame.
    */
@@ -1676,6 +1692,12 @@ class PresShell final : public nsStubDocumentObserver,
    */
   void FrameNeedsToContinueReflow(nsIFrame* aFrame);
 
+  // Lays out the contents of the frames that skipped them and are now near
+  // the viewport, and stops tracking the ones that got far. Returns whether
+  // anything needs a reflow.
+  bool UpdateContentRelevance();
+  void UnskipAllContent();
+
   /**
    * Notification sent by a frame informing the pres shell that it is about to
    * be destroyed.
@@ -2912,6 +2934,9 @@ class PresShell final : public nsStubDocumentObserver,
   // Set of frames that we should mark with NS_FRAME_HAS_DIRTY_CHILDREN after
   // we finish reflowing mCurrentReflowRoot.
   nsTHashSet<nsIFrame*> mFramesToDirty;
+  // Frames whose contents are skipped, or laid out because they are near the
+  // viewport, see CanSkipContent.
+  nsTHashSet<nsIFrame*> mContentSkippingFrames;
   nsTHashSet<nsIScrollableFrame*> mPendingScrollAnchorSelection;
   nsTHashSet<nsIScrollableFrame*> mPendingScrollAnchorAdjustment;
 
@@ -3056,6 +3081,10 @@ class PresShell final : public nsStubDocumentObserver,
   // Guaranteed to be false if mReflowContinueTimer is non-null.
   bool mObservingLayoutFlushes : 1;
 
+  // True while the refresh driver flushes layout, see CanSkipContent.
+  bool mInRefreshDriverLayoutFlush : 1;
+  bool mNeedContentRelevanceUpdate : 1;
+
   bool mResizeEventPending : 1;
 
   bool mFontSizeInflationForceEnabled : 1;
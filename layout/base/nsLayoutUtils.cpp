@@ -3469,6 +3469,9 @@ nsresult nsLayoutUtils::PaintFrame(gfxContext* aRenderingContext,
 
   Telemetry::Accumulate(Telemetry::PAINT_BUILD_DISPLAYLIST_TIME,
                         geckoDLBuildTime);
+  if (useRetainedBuilder) {
+    retainedBuilder->AccumulateTelemetry();
+  }
 
   bool consoleNeedsDisplayList =
       (gfxUtils::DumpDisplayList() || gfxEnv::DumpPaint()) &&
@@ -2235,6 +2235,10 @@ static uint32_t sInterruptChecksToSkip = 200;
 // GECKO_REFLOW_MIN_NOINTERRUPT_DURATION env var.  Can't be initialized here,
 // because TimeDuration/TimeStamp is not safe to use in static constructors..
 static TimeDuration sInterruptTimeout;
+// Number of interrupt checks to skip between looking at the clock when
+// interrupting at a deadline (see nsPresContext::HasReflowDeadline). Checks
+// come after every line reflowed, 200 of which can take longer than a frame.
+static const uint32_t kDeadlineInterruptChecksToSkip = 20;
 
 static void GetInterruptEnv() {
   char* ev = PR_GetEnv("GECKO_REFLOW_INTERRUPT_MODE");
@@ -2321,8 +2325,30 @@ void nsPresContext::ReflowStarted(bool aInterruptible) {
 
   mInterruptChecksToSkip = sInterruptChecksToSkip;
 
+  mReflowDeadline = TimeStamp();
   if (mInterruptsEnabled) {
     mReflowStartTime = TimeStamp::Now();
+
+    // In content processes, yield to the next frame rather than only to
+    // input: reserve some of the frame for painting, but always give the
+    // reflow some time so it gets somewhere, even in a late tick.
+    if (StaticPrefs::layout_interruptible_reflow_vsync_deadline() &&
+        XRE_IsContentProcess() && !IsChrome()) {
+      uint32_t minBudget =
+          StaticPrefs::layout_interruptible_reflow_vsync_deadline_min_budget_ms();
+      uint32_t paintReserve = StaticPrefs::
+          layout_interruptible_reflow_vsync_deadline_paint_reserve_ms();
+      mReflowDeadline =
+          mReflowStartTime + TimeDuration::FromMilliseconds(minBudget);
+      if (Maybe<TimeStamp> nextTick = nsRefreshDriver::GetNextTickHint()) {
+        TimeStamp deadline =
+            *nextTick - TimeDuration::FromMilliseconds(paintReserve);
+        if (deadline > mReflowDeadline) {
+          mReflowDeadline = deadline;
+        }
+      }
+      mInterruptChecksToSkip = kDeadlineInterruptChecksToSkip;
+    }
   }
 }
 
@@ -2345,13 +2371,18 @@ bool nsPresContext::CheckForInterrupt(nsIFrame* aFrame) {
     --mInterruptChecksToSkip;
     return false;
   }
-  mInterruptChecksToSkip = sInterruptChecksToSkip;
+  if (HasReflowDeadline()) {
+    mInterruptChecksToSkip = kDeadlineInterruptChecksToSkip;
+    mHasPendingInterrupt = TimeStamp::Now() > mReflowDeadline;
+  } else {
+    mInterruptChecksToSkip = sInterruptChecksToSkip;
 
-  // Don't interrupt if it's been less than sInterruptTimeout since we started
-  // the reflow.
-  mHasPendingInterrupt =
-      TimeStamp::Now() - mReflowStartTime > sInterruptTimeout &&
-      HavePendingInputEvent() && !IsChrome();
+    // Don't interrupt if it's been less than sInterruptTimeout since we
+    // started the reflow.
+    mHasPendingInterrupt =
+        TimeStamp::Now() - mReflowStartTime > sInterruptTimeout &&
+        HavePendingInputEvent() && !IsChrome();
+  }
 
   if (mPendingInterruptFromTest) {
     mPendingInterruptFromTest = false;
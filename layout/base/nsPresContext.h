@@ -973,6 +973,13 @@ class nsPresContext : public nsISupports, public mozilla::SupportsWeakPtr {
    * ReflowStarted call. Cannot itself trigger an interrupt check.
    */
   bool HasPendingInterrupt() { return mHasPendingInterrupt; }
+  /**
+   * Returns true if the current (or last) reflow is interrupted when it runs
+   * past the next refresh tick rather than on pending events, see
+   * layout.interruptible-reflow.vsync-deadline. Such reflows are continued on
+   * that tick.
+   */
+  bool HasReflowDeadline() const { return !mReflowDeadline.IsNull(); }
   /**
    * Sets a flag that will trip a reflow interrupt. This only bypasses the
    * interrupt timeout and the pending event check; other checks such as whether
@@ -1224,6 +1231,9 @@ class nsPresContext : public nsISupports, public mozilla::SupportsWeakPtr {
   uint64_t mFramesReflowed;
 
   mozilla::TimeStamp mReflowStartTime;
+  // Null unless the reflow is interrupted at a deadline, see
+  // HasReflowDeadline().
+  mozilla::TimeStamp mReflowDeadline;
 
   Maybe<TransactionId> mFirstContentfulPaintTransactionId;
 
@@ -2325,7 +2325,9 @@ void nsRefreshDriver::Tick(VsyncId aId, TimeStamp aNowTime,
         FlushType flushType = HasPendingAnimations(presShell)
                                   ? FlushType::Layout
                                   : FlushType::InterruptibleLayout;
+        presShell->mInRefreshDriverLayoutFlush = true;
         presShell->FlushPendingNotifications(ChangesToFlush(flushType, false));
+        presShell->mInRefreshDriverLayoutFlush = false;
         // Inform the FontFaceSet that we ticked, so that it can resolve its
         // ready promise if it needs to.
         presShell->NotifyFontFaceSetOnRefresh();
@@ -467,6 +467,10 @@ void nsBlockFrame::DestroyFrom(nsIFrame* aDestructRoot,
     RemoveStateBits(NS_BLOCK_FRAME_HAS_OUTSIDE_MARKER);
   }
 
+  if (HasProperty(ContentSkipStateProperty())) {
+    presShell->ForgetContentSkippingFrame(this);
+  }
+
   nsContainerFrame::DestroyFrom(aDestructRoot, aPostDestroyData);
 }
 
@@ -1370,7 +1374,14 @@ void nsBlockFrame::Reflow(nsPresContext* aPresContext, ReflowOutput& aMetrics,
   LazyMarkLinesDirty();
 
   // Now reflow...
-  ReflowDirtyLines(state);
+  const bool skipContent = ShouldSkipContent(*reflowInput);
+  if (skipContent) {
+    // Leave the dirty lines dirty, they get reflowed once the pres shell
+    // finds this block near the viewport.
+    PresShell()->DidSkipContent(this);
+  } else {
+    ReflowDirtyLines(state);
+  }
 
   // If we have a next-in-flow, and that next-in-flow has pushed floats from
   // this frame from a previous iteration of reflow, then we should not return
@@ -1429,7 +1440,7 @@ void nsBlockFrame::Reflow(nsPresContext* aPresContext, ReflowOutput& aMetrics,
   // rare case: an empty first line followed by a second line that
   // contains a block (example: <LI>\n<P>... ). This is where
   // the second case can happen.
-  if (HasOutsideMarker() && !mLines.empty() &&
+  if (!skipContent && HasOutsideMarker() && !mLines.empty() &&
       (mLines.front()->IsBlock() ||
        (0 == mLines.front()->BSize() && mLines.front() != mLines.back() &&
         mLines.begin().next()->IsBlock()))) {
@@ -1478,7 +1489,9 @@ void nsBlockFrame::Reflow(nsPresContext* aPresContext, ReflowOutput& aMetrics,
     ClearLineClampEllipsis();
   }
 
-  CheckFloats(state);
+  if (!skipContent) {
+    CheckFloats(state);
+  }
 
   // Compute our final size
   nscoord blockEndEdgeOfChildren;
@@ -1554,7 +1567,7 @@ void nsBlockFrame::Reflow(nsPresContext* aPresContext, ReflowOutput& aMetrics,
   // children in that situation --- what we think is our "new size" will not be
   // our real new size. This also happens to be more efficient.
   WritingMode parentWM = aMetrics.GetWritingMode();
-  if (HasAbsolutelyPositionedChildren()) {
+  if (!skipContent && HasAbsolutelyPositionedChildren()) {
     nsAbsoluteContainingBlock* absoluteContainer = GetAbsoluteContainingBlock();
     bool haveInterrupt = aPresContext->HasPendingInterrupt();
     if (reflowInput->WillReflowAgainForClearance() || haveInterrupt) {
@@ -1681,6 +1694,26 @@ void nsBlockFrame::Reflow(nsPresContext* aPresContext, ReflowOutput& aMetrics,
   NS_FRAME_SET_TRUNCATION(aStatus, (*reflowInput), aMetrics);
 }
 
+bool nsBlockFrame::ShouldSkipContent(const ReflowInput& aReflowInput) const {
+  const nsStyleDisplay* disp = aReflowInput.mStyleDisplay;
+  if (!disp->IsContainSize() || !disp->IsContainLayout() ||
+      !disp->IsContainPaint()) {
+    return false;
+  }
+  // Only plain, unfragmented blocks: the size of anything else may still
+  // depend on its contents.
+  if (!IsBlockFrame() || GetPrevInFlow() || GetNextInFlow() ||
+      aReflowInput.AvailableBSize() != NS_UNCONSTRAINEDSIZE) {
+    return false;
+  }
+  if (!PresShell()->CanSkipContent()) {
+    return false;
+  }
+  bool found;
+  ContentSkipState state = GetProperty(ContentSkipStateProperty(), &found);
+  return !found || state == ContentSkipState::Skipped;
+}
+
 bool nsBlockFrame::CheckForCollapsedBEndMarginFromClearanceLine() {
   for (auto& line : Reversed(Lines())) {
     if (0 != line.BSize() || !line.CachedIsEmpty()) {
@@ -6951,6 +6984,11 @@ void nsBlockFrame::BuildDisplayList(nsDisplayListBuilder* aBuilder,
 
   DisplayBorderBackgroundOutline(aBuilder, aLists);
 
+  if (IsContentSkipped()) {
+    // Our contents aren't laid out, and are nowhere near what gets painted.
+    return;
+  }
+
   if (GetPrevInFlow()) {
     DisplayOverflowContainers(aBuilder, aLists);
     for (nsIFrame* f : mFloats) {
@@ -284,6 +284,12 @@ class nsBlockFrame : public nsContainerFrame {
  private:
   void CheckIntrinsicCacheAgainstShrinkWrapState();
 
+  // Containment makes the size of the block independent of its contents and
+  // keeps them from affecting anything outside it, so while it is far from
+  // the viewport its contents don't need laying out. See
+  // PresShell::CanSkipContent.
+  bool ShouldSkipContent(const ReflowInput& aReflowInput) const;
+
  public:
   nscoord GetMinISize(gfxContext* aRenderingContext) override;
   nscoord GetPrefISize(gfxContext* aRenderingContext) override;
@@ -522,6 +528,26 @@ class nsBlockFrame : public nsContainerFrame {
   bool IsVisualFormControl(nsPresContext* aPresContext);
 
  public:
+  /**
+   * Where a block with size, layout and paint containment is with laying out
+   * its contents, see ShouldSkipContent. Blocks without the property have
+   * laid out their contents, and skip them from their next reflow on.
+   */
+  enum class ContentSkipState : uint8_t {
+    // Far from the viewport, and the contents haven't been laid out since.
+    Skipped,
+    // Near the viewport, the contents are laid out as usual.
+    Relevant,
+  };
+  NS_DECLARE_FRAME_PROPERTY_SMALL_VALUE(ContentSkipStateProperty,
+                                        ContentSkipState)
+
+  bool IsContentSkipped() const {
+    bool found;
+    ContentSkipState state = GetProperty(ContentSkipStateProperty(), &found);
+    return found && state == ContentSkipState::Skipped;
+  }
+
   /**
    * Helper function for the frame ctor to register a ::marker frame.
    */
@@ -3162,6 +3162,9 @@ void ScrollFrameHelper::ScrollToImpl(nsPoint aPt, const nsRect& aRange,
     mOuter->UpdateOverflow();
   }
 
+  // Contents skipped for being far from the viewport may be near now.
+  presContext->PresShell()->ScheduleContentRelevanceUpdate();
+
   ScheduleSyntheticMouseMove();
 
   PresShell::AutoAssertNoFlush noFlush(*mOuter->PresShell());
@@ -4981,7 +4981,17 @@ void ContainerState::ProcessDisplayItems(nsDisplayList* aList) {
 
         nsDisplayMasksAndClipPaths* maskItem =
             static_cast<nsDisplayMasksAndClipPaths*>(item);
-        SetupMaskLayerForCSSMask(ownLayer, maskItem);
+        if (Maybe<nsRect> insetRect = maskItem->GetRectangularClipPath()) {
+          ParentLayerIntRect insetClip = ViewAs<ParentLayerPixel>(
+              ScaleToNearestPixels(*insetRect) + mParameters.mOffset);
+          if (const Maybe<ParentLayerIntRect>& layerClip =
+                  ownLayer->GetClipRect()) {
+            insetClip = insetClip.Intersect(*layerClip);
+          }
+          ownLayer->SetClipRect(Some(insetClip));
+        } else {
+          SetupMaskLayerForCSSMask(ownLayer, maskItem);
+        }
 
         if (iter.PeekNext() && iter.PeekNext()->GetType() ==
                                    DisplayItemType::TYPE_SCROLL_INFO_LAYER) {
@@ -19,6 +19,7 @@
 #include "mozilla/DisplayPortUtils.h"
 #include "mozilla/PresShell.h"
 #include "mozilla/ProfilerLabels.h"
+#include "mozilla/Telemetry.h"
 
 /**
  * Code for doing display list building for a modified subset of the window,
@@ -1328,6 +1329,69 @@ bool RetainedDisplayListBuilder::ShouldBuildPartial(
   return true;
 }
 
+bool RetainedDisplayListBuilder::RebuildAreaExceedsLimit(
+    const nsRect& aDirty) {
+  const uint32_t limit =
+      StaticPrefs::layout_display_list_rebuild_area_limit_percent();
+  if (!limit) {
+    return false;
+  }
+
+  const nsRect& visible = mBuilder.GetVisibleRect();
+  const nsRect dirty = aDirty.Intersect(visible);
+  const int64_t visibleArea = int64_t(visible.width) * visible.height;
+  const int64_t dirtyArea = int64_t(dirty.width) * dirty.height;
+  return visibleArea > 0 && dirtyArea * 100 >= visibleArea * limit;
+}
+
+void RetainedDisplayListBuilder::AccumulateTelemetry() {
+  const RetainedDisplayListMetrics& metrics = mMetrics;
+
+  if (metrics.mPartialUpdateResult != PartialUpdateResult::Failed) {
+    Telemetry::AccumulateCategorical(
+        metrics.mPartialUpdateResult == PartialUpdateResult::Updated
+            ? Telemetry::LABELS_PAINT_DISPLAYLIST_PARTIAL_RESULT::Partial
+            : Telemetry::LABELS_PAINT_DISPLAYLIST_PARTIAL_RESULT::NoChange);
+    if (mFullBuildEstimate > 0.0) {
+      // What this paint would roughly have cost without the retained list.
+      double saved = mFullBuildEstimate - metrics.mPartialBuildDuration;
+      Telemetry::Accumulate(Telemetry::PAINT_DISPLAYLIST_PARTIAL_TIME_SAVED_MS,
+                            saved > 0.0 ? uint32_t(saved) : 0);
+    }
+    return;
+  }
+
+  using Label = Telemetry::LABELS_PAINT_DISPLAYLIST_PARTIAL_RESULT;
+  Label label = Label::Disabled;
+  switch (metrics.mPartialUpdateFailReason) {
+    case PartialUpdateFailReason::EmptyList:
+      label = Label::EmptyList;
+      break;
+    case PartialUpdateFailReason::RebuildLimit:
+      label = Label::RebuildLimit;
+      break;
+    case PartialUpdateFailReason::FrameType:
+      label = Label::FrameType;
+      break;
+    case PartialUpdateFailReason::Content:
+      label = Label::Content;
+      break;
+    case PartialUpdateFailReason::VisibleRect:
+      label = Label::VisibleRect;
+      break;
+    case PartialUpdateFailReason::NA:
+    case PartialUpdateFailReason::Disabled:
+      break;
+  }
+  Telemetry::AccumulateCategorical(label);
+
+  // Keep a moving average of full builds to compare partial builds against.
+  // It includes the failed partial attempt, if any, as that was paid too.
+  const double full = metrics.mFullBuildDuration;
+  mFullBuildEstimate =
+      mFullBuildEstimate > 0.0 ? (mFullBuildEstimate * 7 + full) / 8 : full;
+}
+
 void RetainedDisplayListBuilder::InvalidateCaretFramesIfNeeded() {
   if (mPreviousCaret == mBuilder.GetCaretFrame()) {
     // The current caret frame is the same as the previous one.
@@ -1414,6 +1478,14 @@ PartialUpdateResult RetainedDisplayListBuilder::AttemptPartialUpdate(
     return PartialUpdateResult::Failed;
   }
 
+  if (RebuildAreaExceedsLimit(modifiedDirty)) {
+    Metrics()->mPartialUpdateFailReason = PartialUpdateFailReason::VisibleRect;
+    mBuilder.SetPartialBuildFailed(true);
+    mBuilder.LeavePresShell(mBuilder.RootReferenceFrame(), nullptr);
+    mList.DeleteAll(&mBuilder);
+    return PartialUpdateResult::Failed;
+  }
+
   // This is normally handled by EnterPresShell, but we skipped it so that we
   // didn't call MarkFrameForDisplayIfVisible before ComputeRebuildRegion.
   nsIScrollableFrame* sf = mBuilder.RootReferenceFrame()
@@ -167,7 +167,8 @@ struct RetainedDisplayListMetrics {
 struct RetainedDisplayListBuilder {
   RetainedDisplayListBuilder(nsIFrame* aReferenceFrame,
                              nsDisplayListBuilderMode aMode, bool aBuildCaret)
-      : mBuilder(aReferenceFrame, aMode, aBuildCaret, true) {}
+      : mBuilder(aReferenceFrame, aMode, aBuildCaret, true),
+        mFullBuildEstimate(0.0) {}
   ~RetainedDisplayListBuilder() { mList.DeleteAll(&mBuilder); }
 
   nsDisplayListBuilder* Builder() { return &mBuilder; }
@@ -178,6 +179,12 @@ struct RetainedDisplayListBuilder {
 
   PartialUpdateResult AttemptPartialUpdate(nscolor aBackstop);
 
+  /**
+   * Records whether the last paint could reuse the retained display list, or
+   * why not, and how much time that saved compared to recent full builds.
+   */
+  void AccumulateTelemetry();
+
   /**
    * Iterates through the display list builder reference frame document and
    * subdocuments, and clears the modified frame lists from the root frames.
@@ -203,6 +210,13 @@ struct RetainedDisplayListBuilder {
    */
   bool ShouldBuildPartial(nsTArray<nsIFrame*>& aModifiedFrames);
 
+  /**
+   * Returns true if aDirty covers so much of the visible area, per
+   * layout.display-list.rebuild-area-limit-percent, that a full build is
+   * cheaper than a partial build and merge.
+   */
+  bool RebuildAreaExceedsLimit(const nsRect& aDirty);
+
   /**
    * Recursively pre-processes the old display list tree before building the
    * new partial display lists, and serializes the old list into an array,
@@ -256,6 +270,8 @@ struct RetainedDisplayListBuilder {
   nsRect mPreviousVisibleRect;
   WeakFrame mPreviousCaret;
   RetainedDisplayListMetrics mMetrics;
+  // Moving average of the full build durations, in milliseconds.
+  double mFullBuildEstimate;
 };
 
 #endif  // RETAINEDDISPLAYLISTBUILDER_H_
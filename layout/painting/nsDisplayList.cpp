@@ -9651,6 +9651,40 @@ bool nsDisplayMasksAndClipPaths::CanPaintOnMaskLayer(LayerManager* aManager) {
   return true;
 }
 
+Maybe<nsRect> nsDisplayMasksAndClipPaths::GetRectangularClipPath() const {
+  if (!StaticPrefs::layers_clip_path_inset_as_layer_clip() ||
+      !SVGIntegrationUtils::UsingSimpleClipPathForFrame(mFrame)) {
+    return Nothing();
+  }
+
+  // Opacity folded into us is applied while painting the mask.
+  if (mHandleOpacity) {
+    return Nothing();
+  }
+
+  // Each continuation clips to its own reference box, which a single layer
+  // clip can't express.
+  if (mFrame->GetPrevContinuation() || mFrame->GetNextContinuation() ||
+      mFrame->HasAnyStateBits(NS_FRAME_PART_OF_IBSPLIT)) {
+    return Nothing();
+  }
+
+  const auto& clipPath = mFrame->StyleSVGReset()->mClipPath;
+  const auto& shape = *clipPath.AsShape()._0;
+  if (!shape.IsInset()) {
+    return Nothing();
+  }
+
+  const nsRect refBox =
+      nsLayoutUtils::ComputeGeometryBox(mFrame, clipPath.AsShape()._1);
+  nscoord radii[8] = {0};
+  if (ShapeUtils::ComputeInsetRadii(shape, refBox, radii)) {
+    return Nothing();
+  }
+
+  return Some(ShapeUtils::ComputeInsetRect(shape, refBox) + ToReferenceFrame());
+}
+
 bool nsDisplayMasksAndClipPaths::ComputeVisibility(
     nsDisplayListBuilder* aBuilder, nsRegion* aVisibleRegion) {
   // Our children may be made translucent or arbitrarily deformed so we should
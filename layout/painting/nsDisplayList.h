@@ -6541,6 +6541,13 @@ class nsDisplayMasksAndClipPaths : public nsDisplayEffectsBase {
 
   const nsTArray<nsRect>& GetDestRects() { return mDestRects; }
 
+  /*
+   * If our only effect is a clip-path: inset() without rounded corners,
+   * return the inset rect relative to the reference frame, so that it can be
+   * applied as a layer clip instead of a mask.
+   */
+  mozilla::Maybe<nsRect> GetRectangularClipPath() const;
+
   void SelectOpacityOptimization(const bool aUsingLayers) override;
 
   bool CreateWebRenderCommands(
@@ -154,6 +154,14 @@ SheetLoadDataHashKey::SheetLoadDataHashKey(const css::SheetLoadData& aLoadData)
   aLoadData.mSheet->GetIntegrity(mSRIMetadata);
 }
 
+SheetLoadDataHashKey SheetLoadDataHashKey::WithPrincipal(
+    nsIPrincipal* aPrincipal) const {
+  return SheetLoadDataHashKey(mURI, aPrincipal, aPrincipal, aPrincipal,
+                              mEncodingGuess, mCORSMode, mParsingMode,
+                              mCompatMode, mSRIMetadata,
+                              css::StylePreloadKind::None);
+}
+
 bool SheetLoadDataHashKey::KeyEquals(const SheetLoadDataHashKey& aKey) const {
   {
     bool eq;
@@ -134,6 +134,10 @@ class SheetLoadDataHashKey : public PLDHashEntryHdr {
 
   css::SheetParsingMode ParsingMode() const { return mParsingMode; }
 
+  // This key with all of its principals replaced by aPrincipal, and not a link
+  // preload.
+  SheetLoadDataHashKey WithPrincipal(nsIPrincipal* aPrincipal) const;
+
   enum { ALLOW_MEMMOVE = true };
 
  protected:
@@ -6,14 +6,18 @@
 
 #include "SharedStyleSheetCache.h"
 
+#include "mozilla/ClearOnShutdown.h"
 #include "mozilla/MemoryReporting.h"
+#include "mozilla/Preferences.h"
 #include "mozilla/StoragePrincipalHelper.h"
 #include "mozilla/StyleSheet.h"
 #include "mozilla/css/SheetLoadData.h"
 #include "mozilla/dom/ContentParent.h"
 #include "mozilla/dom/Document.h"
 #include "mozilla/ServoBindings.h"
+#include "nsCharSeparatedTokenizer.h"
 #include "nsContentUtils.h"
+#include "nsICSSLoaderObserver.h"
 #include "nsXULPrototypeCache.h"
 
 extern mozilla::LazyLogModule sCssLoaderLog;
@@ -28,6 +32,9 @@ using LoadDataArray = css::Loader::LoadDataArray;
 using IsAlternate = css::Loader::IsAlternate;
 
 SharedStyleSheetCache* SharedStyleSheetCache::sInstance;
+StaticAutoPtr<
+    nsTHashMap<SheetLoadDataHashKey, SharedStyleSheetCache::CompleteSheet>>
+    SharedStyleSheetCache::sSharedOriginSheets;
 
 void SharedStyleSheetCache::Clear(nsIPrincipal* aForPrincipal,
                                   const nsACString* aBaseDomain) {
@@ -42,6 +49,11 @@ void SharedStyleSheetCache::Clear(nsIPrincipal* aForPrincipal,
     }
   }
 
+  // These are only kept around to save parsing time, so just drop them all.
+  if (sSharedOriginSheets) {
+    sSharedOriginSheets->Clear();
+  }
+
   if (!sInstance) {
     return;
   }
@@ -200,6 +212,26 @@ SharedStyleSheetCache::CacheResult SharedStyleSheetCache::Lookup(
     }
   }
 
+  // Then the sheets of the shared origins, which documents of other origins,
+  // or the preallocated process, may have loaded already.
+  if (sSharedOriginSheets && !aLoader.ShouldBypassCache() &&
+      IsSharedOrigin(uri)) {
+    auto key = aKey.WithPrincipal(nsContentUtils::GetSystemPrincipal());
+    if (auto lookup = sSharedOriginSheets->Lookup(key)) {
+      const CompleteSheet& completeSheet = lookup.Data();
+      StyleSheet& cachedSheet = *completeSheet.mSheet;
+      LOG(("  From shared origin: %p, expired: %d", &cachedSheet,
+           completeSheet.Expired()));
+
+      if (!completeSheet.Expired()) {
+        AssertComplete(cachedSheet);
+        MOZ_ASSERT(!cachedSheet.HasForcedUniqueInner());
+        aLoader.DidHitCompleteSheetCache(aKey, nullptr);
+        return {CloneSheet(cachedSheet), SheetState::Complete};
+      }
+    }
+  }
+
   if (aSyncLoad) {
     return {};
   }
@@ -280,6 +312,13 @@ size_t SharedStyleSheetCache::SizeOfIncludingThis(
     n += aMallocSizeOf(data.mUseCounters.get());
   }
 
+  if (sSharedOriginSheets) {
+    n += sSharedOriginSheets->ShallowSizeOfIncludingThis(aMallocSizeOf);
+    for (const auto& data : sSharedOriginSheets->Values()) {
+      n += data.mSheet->SizeOfIncludingThis(aMallocSizeOf);
+    }
+  }
+
   // Measurement of the following members may be added later if DMD finds it is
   // worthwhile:
   // - mLoadingDatas: transient, and should be small
@@ -511,12 +550,104 @@ void SharedStyleSheetCache::InsertIntoCompleteCacheIfNeeded(
       Servo_UseCounters_Merge(counters.get(), aData.mUseCounters.get());
     }
 
+    if (IsSharedOrigin(aData.mURI)) {
+      PutSharedOriginSheet(
+          key.WithPrincipal(nsContentUtils::GetSystemPrincipal()),
+          aData.mExpirationTime, CloneSheet(*sheet));
+    }
+
     mCompleteSheets.InsertOrUpdate(
         key, CompleteSheet{aData.mExpirationTime, std::move(counters),
                            std::move(sheet)});
   }
 }
 
+/* static */
+bool SharedStyleSheetCache::IsSharedOrigin(nsIURI* aURI) {
+  nsAutoCString origins;
+  Preferences::GetCString("layout.css.shared-sheets.origins", origins);
+  if (origins.IsEmpty()) {
+    return false;
+  }
+
+  nsAutoCString prePath;
+  if (NS_FAILED(aURI->GetPrePath(prePath))) {
+    return false;
+  }
+  for (const nsACString& origin :
+       nsCCharSeparatedTokenizer(origins, ',').ToRange()) {
+    if (origin.Equals(prePath)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* static */
+void SharedStyleSheetCache::PutSharedOriginSheet(
+    const SheetLoadDataHashKey& aKey, uint32_t aExpirationTime,
+    RefPtr<StyleSheet> aSheet) {
+  MOZ_ASSERT(NS_IsMainThread());
+  MOZ_ASSERT(aSheet->IsComplete(), "Should only be caching complete sheets");
+  if (!sSharedOriginSheets) {
+    sSharedOriginSheets =
+        new nsTHashMap<SheetLoadDataHashKey, CompleteSheet>();
+    ClearOnShutdown(&sSharedOriginSheets);
+  }
+  LOG(("  Keeping shared origin sheet: %s",
+       aKey.URI()->GetSpecOrDefault().get()));
+  sSharedOriginSheets->InsertOrUpdate(
+      aKey, CompleteSheet{aExpirationTime, nullptr, std::move(aSheet)});
+}
+
+// Keeps what a document-less loader parsed, since those loads don't go
+// through InsertIntoCompleteCacheIfNeeded. The key is that of a link in a
+// UTF-8, standards mode document, which is what apps are.
+class SharedStyleSheetCache::SharedOriginSheetObserver final
+    : public nsICSSLoaderObserver {
+ public:
+  NS_DECL_ISUPPORTS
+
+  NS_IMETHOD StyleSheetLoaded(StyleSheet* aSheet, bool aWasDeferred,
+                              nsresult aStatus) override {
+    if (NS_FAILED(aStatus) || !aSheet->GetOriginalURI()) {
+      return NS_OK;
+    }
+    nsIPrincipal* system = nsContentUtils::GetSystemPrincipal();
+    dom::SRIMetadata sriMetadata;
+    aSheet->GetIntegrity(sriMetadata);
+    SheetLoadDataHashKey key(aSheet->GetOriginalURI(), system, system, system,
+                             WrapNotNull(UTF_8_ENCODING),
+                             aSheet->GetCORSMode(), aSheet->ParsingMode(),
+                             eCompatibility_FullStandards, sriMetadata,
+                             css::StylePreloadKind::None);
+    PutSharedOriginSheet(key, 0, CloneSheet(*aSheet));
+    return NS_OK;
+  }
+
+ private:
+  ~SharedOriginSheetObserver() = default;
+};
+
+NS_IMPL_ISUPPORTS(SharedStyleSheetCache::SharedOriginSheetObserver,
+                  nsICSSLoaderObserver)
+
+/* static */
+void SharedStyleSheetCache::PreloadSharedOriginSheet(nsIURI* aURI) {
+  MOZ_ASSERT(NS_IsMainThread());
+  if (!IsSharedOrigin(aURI)) {
+    NS_WARNING("Not preloading a sheet from an origin that isn't shared");
+    return;
+  }
+  LOG(("SharedStyleSheetCache::PreloadSharedOriginSheet(%s)",
+       aURI->GetSpecOrDefault().get()));
+
+  RefPtr<css::Loader> loader = new css::Loader();
+  RefPtr<SharedOriginSheetObserver> observer = new SharedOriginSheetObserver();
+  Unused << loader->LoadSheet(aURI, css::eAuthorSheetFeatures,
+                              css::Loader::UseSystemPrincipal::No, observer);
+}
+
 void SharedStyleSheetCache::StartDeferredLoadsForLoader(
     css::Loader& aLoader, StartLoads aStartLoads) {
   using PendingLoad = css::Loader::PendingLoad;
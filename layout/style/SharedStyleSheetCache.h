@@ -20,6 +20,7 @@
 //    might re-create it.
 
 #include "mozilla/PrincipalHashKey.h"
+#include "mozilla/StaticPtr.h"
 #include "mozilla/WeakPtr.h"
 #include "mozilla/css/Loader.h"
 #include "nsTHashMap.h"
@@ -102,6 +103,16 @@ class SharedStyleSheetCache final : public nsIMemoryReporter {
   static void Clear(nsIPrincipal* aForPrincipal = nullptr,
                     const nsACString* aBaseDomain = nullptr);
 
+  // Sheets from the origins in layout.css.shared-sheets.origins are linked by
+  // most apps, so once parsed they are kept for the lifetime of the process
+  // rather than for that of the documents of one origin, and are shared by
+  // documents of any origin.
+  //
+  // Starts loading, without a document, a sheet from one of those origins and
+  // keeps it once complete. Used by preallocated processes so that the app
+  // that takes the process over finds its shared sheets parsed already.
+  static void PreloadSharedOriginSheet(nsIURI*);
+
  private:
   static already_AddRefed<SharedStyleSheetCache> Create();
   void CancelDeferredLoadsForLoader(css::Loader&);
@@ -124,6 +135,13 @@ class SharedStyleSheetCache final : public nsIMemoryReporter {
 
   void WillStartPendingLoad(css::SheetLoadData&);
 
+  static bool IsSharedOrigin(nsIURI*);
+  static void PutSharedOriginSheet(const SheetLoadDataHashKey&,
+                                   uint32_t aExpirationTime,
+                                   RefPtr<StyleSheet>);
+
+  class SharedOriginSheetObserver;
+
   nsTHashMap<SheetLoadDataHashKey, CompleteSheet> mCompleteSheets;
   nsRefPtrHashtable<SheetLoadDataHashKey, css::SheetLoadData> mPendingDatas;
   // The SheetLoadData pointers in mLoadingDatas below are weak references that
@@ -138,6 +156,12 @@ class SharedStyleSheetCache final : public nsIMemoryReporter {
   nsTHashMap<PrincipalHashKey, uint32_t> mLoaderPrincipalRefCnt;
 
   static SharedStyleSheetCache* sInstance;
+
+  // The complete sheets of the shared origins, keyed with the system principal
+  // in place of the principals of the loads. Outlives sInstance, and is only
+  // emptied by Clear().
+  static StaticAutoPtr<nsTHashMap<SheetLoadDataHashKey, CompleteSheet>>
+      sSharedOriginSheets;
 };
 
 }  // namespace mozilla
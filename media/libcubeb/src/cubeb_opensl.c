@@ -68,6 +68,10 @@
 
 #define DEFAULT_SAMPLE_RATE 48000
 #define DEFAULT_NUM_OF_FRAMES 480
+#ifdef MOZ_WIDGET_GONK
+// Largest buffer, in frames, for which a fast mixer track is requested.
+#define GONK_FAST_TRACK_FRAMES_THRESHOLD 256
+#endif
 
 static struct cubeb_ops const opensl_ops;
 
@@ -1305,6 +1309,13 @@ opensl_configure_playback(cubeb_stream * stm, cubeb_stream_params * params) {
     // Default to SL_ANDROID_PERFORMANCE_LATENCY_EFFECTS to make sure primary
     // output is used.
     SLuint32 performanceMode = SL_ANDROID_PERFORMANCE_LATENCY_EFFECTS;
+    // Small buffers are a request for low latency. PERFORMANCE_LATENCY has
+    // OpenSL ask for AUDIO_OUTPUT_FLAG_FAST, which AudioFlinger drops by
+    // itself when the device has no fast mixer. Voice keeps its effects.
+    if (!stm->voice_output &&
+        stm->buffer_size_frames <= GONK_FAST_TRACK_FRAMES_THRESHOLD) {
+      performanceMode = SL_ANDROID_PERFORMANCE_LATENCY;
+    }
 #else
     SLuint32 performanceMode = SL_ANDROID_PERFORMANCE_LATENCY;
 #endif
@@ -68,6 +68,9 @@ MALLOC_DECL(malloc_good_size, size_t, size_t)
 MALLOC_DECL(jemalloc_stats_internal, void, jemalloc_stats_t*,
             jemalloc_bin_stats_t*)
 
+// Fills in the cheaper subset of jemalloc_stats.
+MALLOC_DECL(jemalloc_stats_lite, void, jemalloc_stats_lite_t*)
+
 // On some operating systems (Mac), we use madvise(MADV_FREE) to hand pages
 // back to the operating system.  On Mac, the operating system doesn't take
 // this memory back immediately; instead, the OS takes it back only when the
@@ -99,6 +102,12 @@ MALLOC_DECL(jemalloc_purge_freed_pages, void)
 // provides functionality similar to mallctl("arenas.purge") in jemalloc 3.
 MALLOC_DECL(jemalloc_free_dirty_pages, void)
 
+// Scale the number of dirty pages each arena may keep by 2^aModifier, so 0
+// restores the defaults and negative values keep fewer. Arenas that are over
+// their new limit are purged right away. Meant for processes going in and out
+// of the background on devices that are short on memory.
+MALLOC_DECL(moz_set_max_dirty_page_modifier, void, int32_t)
+
 // Opt in or out of a thread local arena (bool argument is whether to opt-in
 // (true) or out (false)).
 MALLOC_DECL(jemalloc_thread_local_arena, void, bool)
@@ -942,6 +942,9 @@ struct arena_t {
   // Maximum value allowed for mNumDirty.
   size_t mMaxDirty;
 
+  // mMaxDirty before moz_set_max_dirty_page_modifier scaled it.
+  size_t mMaxDirtyBase;
+
  private:
   // Size/address-ordered tree of this arena's available runs.  This tree
   // is used for first-best-fit run allocation.
@@ -1034,6 +1037,10 @@ struct arena_t {
 
   void HardPurge();
 
+  // Scales mMaxDirtyBase into mMaxDirty, purging if needed. The arena lock
+  // must be held, unless the arena isn't in use yet.
+  void SetMaxDirtyModifier(int32_t aModifier);
+
   void* operator new(size_t aCount) = delete;
 
   void* operator new(size_t aCount, const fallible_t&) noexcept;
@@ -1063,6 +1070,7 @@ class ArenaCollection {
   bool Init() {
     mArenas.Init();
     mPrivateArenas.Init();
+    mMaxDirtyModifier = 0;
     arena_params_t params;
     // The main arena allows more dirty pages than the default for other arenas.
     params.mMaxDirty = opt_dirty_max;
@@ -1114,6 +1122,10 @@ class ArenaCollection {
 
   Mutex mLock;
 
+  // The last value given to moz_set_max_dirty_page_modifier, applied to
+  // arenas created afterwards too. Protected by mLock.
+  int32_t mMaxDirtyModifier;
+
  private:
   inline arena_t* GetByIdInternal(arena_id_t aArenaId, bool aIsPrivate);
 
@@ -2538,6 +2550,17 @@ void arena_t::Purge(bool aAll) {
   }
 }
 
+void arena_t::SetMaxDirtyModifier(int32_t aModifier) {
+  if (aModifier >= 0) {
+    mMaxDirty = mMaxDirtyBase << aModifier;
+  } else {
+    mMaxDirty = std::max<size_t>(mMaxDirtyBase >> -aModifier, 1);
+  }
+  if (mNumDirty > mMaxDirty) {
+    Purge(false);
+  }
+}
+
 void arena_t::DallocRun(arena_run_t* aRun, bool aDirty) {
   arena_chunk_t* chunk;
   size_t size, run_ind, run_pages;
@@ -3542,6 +3565,7 @@ arena_t::arena_t(arena_params_t* aParams, bool aIsPrivate) {
   // of opt_dirty_max.
   mMaxDirty = (aParams && aParams->mMaxDirty) ? aParams->mMaxDirty
                                               : (opt_dirty_max / 8);
+  mMaxDirtyBase = mMaxDirty;
 
   mRunsAvail.Init();
 
@@ -3607,6 +3631,10 @@ arena_t* ArenaCollection::CreateArena(bool aIsPrivate,
 
   MutexAutoLock lock(mLock);
 
+  if (mMaxDirtyModifier) {
+    ret->SetMaxDirtyModifier(mMaxDirtyModifier);
+  }
+
   // For public arenas, it's fine to just use incrementing arena id
   if (!aIsPrivate) {
     ret->mId = mLastPublicArenaId++;
@@ -4221,6 +4249,37 @@ inline size_t MozJemalloc::malloc_usable_size(usable_ptr_t aPtr) {
   return AllocInfo::GetValidated(aPtr).Size();
 }
 
+template <>
+inline void MozJemalloc::jemalloc_stats_lite(jemalloc_stats_lite_t* aStats) {
+  if (!aStats) {
+    return;
+  }
+  memset(aStats, 0, sizeof(*aStats));
+  if (!malloc_init()) {
+    return;
+  }
+
+  {
+    MutexAutoLock lock(huge_mtx);
+    aStats->mapped += huge_mapped;
+    aStats->allocated += huge_allocated;
+  }
+
+  {
+    MutexAutoLock lock(base_mtx);
+    aStats->mapped += base_mapped;
+  }
+
+  MutexAutoLock lock(gArenas.mLock);
+  for (auto arena : gArenas.iter()) {
+    MutexAutoLock arena_lock(arena->mLock);
+    aStats->mapped += arena->mStats.mapped;
+    aStats->allocated +=
+        arena->mStats.allocated_small + arena->mStats.allocated_large;
+    aStats->page_cache += arena->mNumDirty << gPageSize2Pow;
+  }
+}
+
 template <>
 inline void MozJemalloc::jemalloc_stats_internal(
     jemalloc_stats_t* aStats, jemalloc_bin_stats_t* aBinStats) {
@@ -4430,6 +4489,23 @@ inline void MozJemalloc::jemalloc_free_dirty_pages(void) {
   }
 }
 
+template <>
+inline void MozJemalloc::moz_set_max_dirty_page_modifier(int32_t aModifier) {
+  // Past this, limits either overflow or are all down to a single page.
+  aModifier = std::min(std::max(aModifier, -16), 16);
+  if (malloc_initialized) {
+    MutexAutoLock lock(gArenas.mLock);
+    if (aModifier == gArenas.mMaxDirtyModifier) {
+      return;
+    }
+    gArenas.mMaxDirtyModifier = aModifier;
+    for (auto arena : gArenas.iter()) {
+      MutexAutoLock arena_lock(arena->mLock);
+      arena->SetMaxDirtyModifier(aModifier);
+    }
+  }
+}
+
 inline arena_t* ArenaCollection::GetByIdInternal(arena_id_t aArenaId,
                                                  bool aIsPrivate) {
   // Use AlignedStorage2 to avoid running the arena_t constructor, while
@@ -101,6 +101,14 @@ typedef struct {
   size_t bin_unused;   // Bytes committed to a bin but currently unused.
 } jemalloc_stats_t;
 
+// The part of jemalloc_stats_t that can be gathered without walking the bins
+// of every arena, for callers that want it often.
+typedef struct {
+  size_t mapped;      // Bytes mapped (not necessarily committed).
+  size_t allocated;   // Bytes allocated (committed, in use by application).
+  size_t page_cache;  // Committed, unused pages kept around as a cache.
+} jemalloc_stats_lite_t;
+
 typedef struct {
   size_t size;               // The size of objects in this bin, zero if this
                              // bin stats array entry is unused (no more bins).
@@ -11,8 +11,10 @@
 // necessary:
 //   - malloc_good_size (used to be called je_malloc_usable_in_advance)
 //   - jemalloc_stats
+//   - jemalloc_stats_lite
 //   - jemalloc_purge_freed_pages
 //   - jemalloc_free_dirty_pages
+//   - moz_set_max_dirty_page_modifier
 //   - jemalloc_thread_local_arena
 //   - jemalloc_ptr_info
 
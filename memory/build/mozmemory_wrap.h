@@ -35,8 +35,10 @@
 //
 // - jemalloc specific functions:
 //   - jemalloc_stats
+//   - jemalloc_stats_lite
 //   - jemalloc_purge_freed_pages
 //   - jemalloc_free_dirty_pages
+//   - moz_set_max_dirty_page_modifier
 //   - jemalloc_thread_local_arena
 //   - jemalloc_ptr_info
 //   (these functions are native to mozjemalloc)
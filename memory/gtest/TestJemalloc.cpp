@@ -757,3 +757,37 @@ TEST(Jemalloc, DisposeArena)
   _gdb_sleep_duration = old_gdb_sleep_duration;
 #endif
 }
+
+TEST(Jemalloc, DirtyPageModifier)
+{
+  jemalloc_stats_t stats;
+  jemalloc_stats(&stats);
+
+  arena_params_t params;
+  params.mMaxDirty = 64;
+  arena_id_t arena = moz_create_arena_with_params(&params);
+
+  // Leave 40 dirty pages behind, which the arena is fine with.
+  const size_t kPages = 40;
+  void* ptrs[kPages];
+  for (auto& ptr : ptrs) {
+    ptr = moz_arena_malloc(arena, stats.page_size);
+  }
+  for (auto& ptr : ptrs) {
+    moz_arena_free(arena, ptr);
+  }
+
+  jemalloc_stats_lite_t before;
+  jemalloc_stats_lite(&before);
+  ASSERT_GE(before.page_cache, kPages * stats.page_size);
+
+  // The arena may now keep 8 pages, and purges down to half of that.
+  moz_set_max_dirty_page_modifier(-3);
+  jemalloc_stats_lite_t after;
+  jemalloc_stats_lite(&after);
+  EXPECT_LE(after.page_cache + (kPages - 4) * stats.page_size,
+            before.page_cache);
+
+  moz_set_max_dirty_page_modifier(0);
+  moz_dispose_arena(arena);
+}
@@ -1395,6 +1395,23 @@ void replace_jemalloc_stats(jemalloc_stats_t* aStats,
   aStats->bookkeeping += bookkeeping;
 }
 
+void replace_jemalloc_stats_lite(jemalloc_stats_lite_t* aStats) {
+  sMallocTable.jemalloc_stats_lite(aStats);
+
+  // As in replace_jemalloc_stats.
+  aStats->mapped += kAllPagesSize;
+  {
+    MutexAutoLock lock(GMut::sMutex);
+    for (size_t i = 0; i < kNumAllocPages; i++) {
+      if (gMut->IsPageInUse(lock, i)) {
+        aStats->allocated += gMut->PageUsableSize(lock, i);
+      }
+    }
+  }
+  aStats->allocated -= sMallocTable.malloc_usable_size(gConst) +
+                       sMallocTable.malloc_usable_size(gMut);
+}
+
 void replace_jemalloc_ptr_info(const void* aPtr, jemalloc_ptr_info_t* aInfo) {
   // We need to implement this properly, because various code locations do
   // things like checking that allocations are in the expected arena.
@@ -1549,8 +1566,10 @@ void replace_init(malloc_table_t* aMallocTable, ReplaceMallocBridge** aBridge) {
   // default malloc_good_size: the default suffices.
 
   aMallocTable->jemalloc_stats_internal = replace_jemalloc_stats;
+  aMallocTable->jemalloc_stats_lite = replace_jemalloc_stats_lite;
   // jemalloc_purge_freed_pages: the default suffices.
   // jemalloc_free_dirty_pages: the default suffices.
+  // moz_set_max_dirty_page_modifier: the default suffices.
   // jemalloc_thread_local_arena: the default suffices.
   aMallocTable->jemalloc_ptr_info = replace_jemalloc_ptr_info;
 
@@ -12,6 +12,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef MOZ_UTF8_ARM_NEON
+#  include <arm_neon.h>
+#endif
+
 MFBT_API bool mozilla::detail::IsValidUtf8(const void* aCodeUnits,
                                            size_t aCount) {
   const auto* s = reinterpret_cast<const unsigned char*>(aCodeUnits);
@@ -36,3 +40,49 @@ MFBT_API bool mozilla::detail::IsValidUtf8(const void* aCodeUnits,
   MOZ_ASSERT(s == limit);
   return true;
 }
+
+#ifdef MOZ_UTF8_ARM_NEON
+
+// Returns whether any byte of the 16-byte vector has its high bit set.
+static inline bool HasNonAscii(uint8x16_t aBytes) {
+  uint8x8_t folded = vorr_u8(vget_low_u8(aBytes), vget_high_u8(aBytes));
+  return (vget_lane_u64(vreinterpret_u64_u8(folded), 0) &
+          UINT64_C(0x8080808080808080)) != 0;
+}
+
+MFBT_API size_t mozilla::detail::Utf8AsciiPrefixLengthNeon(
+    const char* aCodeUnits, size_t aCount) {
+  const auto* s = reinterpret_cast<const uint8_t*>(aCodeUnits);
+  size_t i = 0;
+  for (; i + 16 <= aCount; i += 16) {
+    if (HasNonAscii(vld1q_u8(s + i))) {
+      break;
+    }
+  }
+  while (i < aCount && IsAscii(s[i])) {
+    i++;
+  }
+  return i;
+}
+
+MFBT_API size_t mozilla::detail::ConvertAsciiPrefixToUtf16Neon(
+    const char* aSource, size_t aCount, char16_t* aDest) {
+  const auto* s = reinterpret_cast<const uint8_t*>(aSource);
+  auto* d = reinterpret_cast<uint16_t*>(aDest);
+  size_t i = 0;
+  for (; i + 16 <= aCount; i += 16) {
+    uint8x16_t bytes = vld1q_u8(s + i);
+    if (HasNonAscii(bytes)) {
+      break;
+    }
+    vst1q_u16(d + i, vmovl_u8(vget_low_u8(bytes)));
+    vst1q_u16(d + i + 8, vmovl_u8(vget_high_u8(bytes)));
+  }
+  while (i < aCount && IsAscii(s[i])) {
+    d[i] = s[i];
+    i++;
+  }
+  return i;
+}
+
+#endif  // MOZ_UTF8_ARM_NEON
@@ -31,6 +31,25 @@ extern "C" {
 // Declared as uint8_t instead of char to match declaration in another header.
 size_t encoding_utf8_valid_up_to(uint8_t const* buffer, size_t buffer_len);
 }
+
+// encoding_rs only has SIMD code paths for x86 and aarch64, so on 32-bit ARM
+// its ASCII fast paths run a word at a time. Handle the leading ASCII run of
+// longer inputs with NEON before passing the remainder over.
+#  if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__aarch64__)
+#    define MOZ_UTF8_ARM_NEON 1
+namespace mozilla {
+namespace detail {
+// Returns the length of the leading ASCII run of aCodeUnits.
+extern MFBT_API size_t Utf8AsciiPrefixLengthNeon(const char* aCodeUnits,
+                                                 size_t aCount);
+// Zero-extends the leading ASCII run of aSource into aDest, which must have
+// room for aCount code units, and returns its length.
+extern MFBT_API size_t ConvertAsciiPrefixToUtf16Neon(const char* aSource,
+                                                     size_t aCount,
+                                                     char16_t* aDest);
+}  // namespace detail
+}  // namespace mozilla
+#  endif
 #else
 namespace mozilla {
 namespace detail {
@@ -267,6 +286,14 @@ inline bool IsUtf8(mozilla::Span<const char> aString) {
     }
     return true;
   }
+#  ifdef MOZ_UTF8_ARM_NEON
+  {
+    size_t ascii = mozilla::detail::Utf8AsciiPrefixLengthNeon(
+        reinterpret_cast<const char*>(ptr), length);
+    ptr += ascii;
+    length -= ascii;
+  }
+#  endif
 end:
   return length == encoding_utf8_valid_up_to(ptr, length);
 #else
@@ -283,6 +310,16 @@ end:
  * sequence or the length of the string if there are none.
  */
 inline size_t Utf8ValidUpTo(mozilla::Span<const char> aString) {
+#  ifdef MOZ_UTF8_ARM_NEON
+  if (aString.Length() >= 16) {
+    size_t ascii = mozilla::detail::Utf8AsciiPrefixLengthNeon(
+        aString.Elements(), aString.Length());
+    return ascii + encoding_utf8_valid_up_to(
+                       reinterpret_cast<const uint8_t*>(aString.Elements()) +
+                           ascii,
+                       aString.Length() - ascii);
+  }
+#  endif
   return encoding_utf8_valid_up_to(
       reinterpret_cast<const uint8_t*>(aString.Elements()), aString.Length());
 }
@@ -343,6 +380,15 @@ inline mozilla::Tuple<size_t, size_t> ConvertUtf16toUtf8Partial(
  */
 inline size_t ConvertUtf8toUtf16(mozilla::Span<const char> aSource,
                                  mozilla::Span<char16_t> aDest) {
+#  ifdef MOZ_UTF8_ARM_NEON
+  if (aSource.Length() >= 16) {
+    size_t ascii = mozilla::detail::ConvertAsciiPrefixToUtf16Neon(
+        aSource.Elements(), aSource.Length(), aDest.Elements());
+    return ascii + encoding_mem_convert_utf8_to_utf16(
+                       aSource.Elements() + ascii, aSource.Length() - ascii,
+                       aDest.Elements() + ascii, aDest.Length() - ascii);
+  }
+#  endif
   return encoding_mem_convert_utf8_to_utf16(
       aSource.Elements(), aSource.Length(), aDest.Elements(), aDest.Length());
 }
@@ -357,8 +403,7 @@ inline size_t ConvertUtf8toUtf16(mozilla::Span<const char> aSource,
  */
 inline size_t UnsafeConvertValidUtf8toUtf16(mozilla::Span<const char> aSource,
                                             mozilla::Span<char16_t> aDest) {
-  return encoding_mem_convert_utf8_to_utf16(
-      aSource.Elements(), aSource.Length(), aDest.Elements(), aDest.Length());
+  return ConvertUtf8toUtf16(aSource, aDest);
 }
 
 /**
@@ -377,12 +422,20 @@ inline size_t UnsafeConvertValidUtf8toUtf16(mozilla::Span<const char> aSource,
  */
 inline mozilla::Maybe<size_t> ConvertUtf8toUtf16WithoutReplacement(
     mozilla::Span<const char> aSource, mozilla::Span<char16_t> aDest) {
+  size_t ascii = 0;
+#  ifdef MOZ_UTF8_ARM_NEON
+  if (aSource.Length() >= 16) {
+    ascii = mozilla::detail::ConvertAsciiPrefixToUtf16Neon(
+        aSource.Elements(), aSource.Length(), aDest.Elements());
+  }
+#  endif
   size_t written = encoding_mem_convert_utf8_to_utf16_without_replacement(
-      aSource.Elements(), aSource.Length(), aDest.Elements(), aDest.Length());
+      aSource.Elements() + ascii, aSource.Length() - ascii,
+      aDest.Elements() + ascii, aDest.Length() - ascii);
   if (MOZ_UNLIKELY(written == std::numeric_limits<size_t>::max())) {
     return mozilla::Nothing();
   }
-  return mozilla::Some(written);
+  return mozilla::Some(ascii + written);
 }
 
 #endif  // MOZ_HAS_JSRUST
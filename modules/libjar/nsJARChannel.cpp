@@ -155,8 +155,8 @@ nsJARInputThunk::Read(char* buf, uint32_t count, uint32_t* countRead) {
 NS_IMETHODIMP
 nsJARInputThunk::ReadSegments(nsWriteSegmentFun writer, void* closure,
                               uint32_t count, uint32_t* countRead) {
-  // stream transport does only calls Read()
-  return NS_ERROR_NOT_IMPLEMENTED;
+  // Only implemented by the stream of a stored entry, see nsJARInputStream.
+  return mJarStream->ReadSegments(writer, closure, count, countRead);
 }
 
 NS_IMETHODIMP
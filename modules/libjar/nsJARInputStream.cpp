@@ -244,8 +244,46 @@ nsJARInputStream::Read(char* aBuffer, uint32_t aCount, uint32_t* aBytesRead) {
 NS_IMETHODIMP
 nsJARInputStream::ReadSegments(nsWriteSegmentFun writer, void* closure,
                                uint32_t count, uint32_t* _retval) {
-  // don't have a buffer to read from, so this better not be called!
-  return NS_ERROR_NOT_IMPLEMENTED;
+  NS_ENSURE_ARG_POINTER(_retval);
+  *_retval = 0;
+
+  if (mMode == MODE_CLOSED) {
+    return NS_BASE_STREAM_CLOSED;
+  }
+  // Only stored entries have a buffer to read from: the mapped file itself.
+  // Handing it to the writer saves consumers a copy.
+  if (mMode != MODE_COPY) {
+    return NS_ERROR_NOT_IMPLEMENTED;
+  }
+  if (!mFd) {
+    return NS_OK;
+  }
+
+  MMAP_FAULT_HANDLER_BEGIN_HANDLE(mFd)
+  MOZ_DIAGNOSTIC_ASSERT(mOutSize >= mZs.total_out,
+                        "Did we read more than expected?");
+  uint32_t remaining = std::min(count, mOutSize - uint32_t(mZs.total_out));
+  while (remaining) {
+    uint32_t written = 0;
+    const char* segment = (const char*)mZs.next_in + mZs.total_out;
+    nsresult rv =
+        writer(this, closure, segment, *_retval, remaining, &written);
+    if (NS_FAILED(rv) || !written) {
+      // Errors from the writer aren't passed on.
+      break;
+    }
+    MOZ_ASSERT(written <= remaining);
+    mZs.total_out += written;
+    *_retval += written;
+    remaining -= written;
+  }
+  MMAP_FAULT_HANDLER_CATCH(NS_ERROR_FAILURE)
+
+  // be aggressive about releasing the file!
+  if (mZs.total_out >= mOutSize) {
+    mFd = nullptr;
+  }
+  return NS_OK;
 }
 
 NS_IMETHODIMP
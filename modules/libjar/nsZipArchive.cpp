@@ -22,6 +22,7 @@
 #include "mozilla/Attributes.h"
 #include "mozilla/Logging.h"
 #include "mozilla/MemUtils.h"
+#include "mozilla/PerfectHash.h"
 #include "mozilla/UniquePtrExtensions.h"
 #include "mozilla/StaticMutex.h"
 #include "stdlib.h"
@@ -432,6 +433,11 @@ nsresult nsZipArchive::Test(const char* aEntryName) {
   }
 
   // test all items in archive
+  {
+    MutexAutoLock lock(mLock);
+    nsresult rv = EnsureFileList();
+    if (NS_FAILED(rv)) return rv;
+  }
   for (auto* item : mFiles) {
     for (currItem = item; currItem; currItem = currItem->next) {
       //-- don't test (synthetic) directory items
@@ -463,6 +469,7 @@ nsresult nsZipArchive::CloseArchive() {
   // Let us also cleanup the mFiles table for re-use on the next 'open' call
   memset(mFiles, 0, sizeof(mFiles));
   mBuiltSynthetics = false;
+  mIndexEntryCount = 0;
   return NS_OK;
 }
 
@@ -482,19 +489,24 @@ nsZipItem* nsZipArchive::GetItem(const char* aEntryName) {
       }
     }
     MMAP_FAULT_HANDLER_BEGIN_HANDLE(mFd)
-    nsZipItem* item = mFiles[HashName(aEntryName, len)];
-    while (item) {
-      if ((len == item->nameLength) &&
-          (!memcmp(aEntryName, item->Name(), len))) {
-        // Successful GetItem() is a good indicator that the file is about to be
-        // read
-        if (mUseZipLog && mURI.Length()) {
-          zipLog.Write(mURI, aEntryName);
-        }
-        return item;  //-- found it
-      }
+    uint32_t hash = HashName(aEntryName, len);
+    nsZipItem* item = mFiles[hash];
+    while (item && ((len != item->nameLength) ||
+                    memcmp(aEntryName, item->Name(), len))) {
       item = item->next;
     }
+    //-- Items are only created as they are looked up when using the index.
+    if (!item && mIndexEntryCount) {
+      item = GetIndexedItem(aEntryName, len, hash);
+    }
+    if (item) {
+      // Successful GetItem() is a good indicator that the file is about to be
+      // read
+      if (mUseZipLog && mURI.Length()) {
+        zipLog.Write(mURI, aEntryName);
+      }
+      return item;  //-- found it
+    }
     MMAP_FAULT_HANDLER_CATCH(nullptr)
   }
   return nullptr;
@@ -662,6 +674,7 @@ nsresult nsZipArchive::BuildFileList(PRFileDesc* aFd) {
   const uint8_t* startp = mFd->mFileData;
   const uint8_t* endp = startp + mFd->mLen;
   MMAP_FAULT_HANDLER_BEGIN_HANDLE(mFd)
+  const ZipEnd* zipend = nullptr;
   uint32_t centralOffset = 4;
   // Only perform readahead in the parent process. Children processes
   // don't need readahead when the file has already been readahead by
@@ -675,7 +688,8 @@ nsresult nsZipArchive::BuildFileList(PRFileDesc* aFd) {
   } else {
     for (buf = endp - ZIPEND_SIZE; buf > startp; buf--) {
       if (xtolong(buf) == ENDSIG) {
-        centralOffset = xtolong(((ZipEnd*)buf)->offset_central_dir);
+        zipend = (const ZipEnd*)buf;
+        centralOffset = xtolong(zipend->offset_central_dir);
         break;
       }
     }
@@ -692,6 +706,45 @@ nsresult nsZipArchive::BuildFileList(PRFileDesc* aFd) {
     return NS_ERROR_FILE_CORRUPTED;
   }
 
+  //-- With an entry index there is no need to read the central directory.
+  if (zipend && ReadIndex(zipend, buf)) {
+    return NS_OK;
+  }
+
+  nsresult rv = ReadCentralDirectory(buf, &buf);
+  if (NS_FAILED(rv)) {
+    return rv;
+  }
+
+  // Make the comment available for consumers.
+  if ((endp >= buf) && (endp - buf >= ZIPEND_SIZE)) {
+    zipend = (const ZipEnd*)buf;
+
+    buf += ZIPEND_SIZE;
+    uint16_t commentlen = xtoint(zipend->commentfield_len);
+    if (endp - buf >= commentlen) {
+      mCommentPtr = (const char*)buf;
+      mCommentLen = commentlen;
+    }
+  }
+
+  MMAP_FAULT_HANDLER_CATCH(NS_ERROR_FAILURE)
+  return NS_OK;
+}
+
+//---------------------------------------------
+//  nsZipArchive::ReadCentralDirectory
+//  Adds an item for every central record starting at aBuf and points
+//  aEndRecord at the end record following them. The caller has to handle
+//  mmap faults.
+//---------------------------------------------
+nsresult nsZipArchive::ReadCentralDirectory(const uint8_t* aBuf,
+                                            const uint8_t** aEndRecord) {
+  mLock.AssertCurrentThreadOwns();
+
+  const uint8_t* buf = aBuf;
+  const uint8_t* endp = mFd->mFileData + mFd->mLen;
+
   //-- Read the central directory headers
   uint32_t sig = 0;
   while ((buf + int32_t(sizeof(uint32_t)) > buf) &&
@@ -723,7 +776,17 @@ nsresult nsZipArchive::BuildFileList(PRFileDesc* aFd) {
     // Point to the next item at the top of loop
     buf += diff;
 
-    nsZipItem* item = CreateZipItem();
+    // Skip items that were already created through the index.
+    uint32_t hash = HashName((const char*)central + ZIPCENTRAL_SIZE, namelen);
+    nsZipItem* item = mFiles[hash];
+    if (mIndexEntryCount) {
+      while (item && item->central != central) {
+        item = item->next;
+      }
+      if (item) continue;
+    }
+
+    item = CreateZipItem();
     if (!item) return NS_ERROR_OUT_OF_MEMORY;
 
     item->central = central;
@@ -731,7 +794,6 @@ nsresult nsZipArchive::BuildFileList(PRFileDesc* aFd) {
     item->isSynthetic = false;
 
     // Add item to file table
-    uint32_t hash = HashName(item->Name(), namelen);
     item->next = mFiles[hash];
     mFiles[hash] = item;
 
@@ -742,20 +804,121 @@ nsresult nsZipArchive::BuildFileList(PRFileDesc* aFd) {
     return NS_ERROR_FILE_CORRUPTED;
   }
 
-  // Make the comment available for consumers.
-  if ((endp >= buf) && (endp - buf >= ZIPEND_SIZE)) {
-    ZipEnd* zipend = (ZipEnd*)buf;
+  *aEndRecord = buf;
+  return NS_OK;
+}
 
-    buf += ZIPEND_SIZE;
-    uint16_t commentlen = xtoint(zipend->commentfield_len);
-    if (endp - buf >= commentlen) {
-      mCommentPtr = (const char*)buf;
-      mCommentLen = commentlen;
-    }
+//---------------------------------------------
+//  nsZipArchive::ReadIndex
+//  Sets up lookups through the entry index at the end of the comment, if
+//  there is one. The index is only checked for being in bounds here: as
+//  GetIndexedItem checks the record it finds, a bad index can hide entries
+//  but not make up any. The caller has to handle mmap faults.
+//---------------------------------------------
+bool nsZipArchive::ReadIndex(const ZipEnd* aZipEnd, const uint8_t* aCentral) {
+  mLock.AssertCurrentThreadOwns();
+
+  const uint8_t* endRecord = (const uint8_t*)aZipEnd;
+  const uint8_t* comment = endRecord + ZIPEND_SIZE;
+  const uint8_t* endp = mFd->mFileData + mFd->mLen;
+  uint16_t commentlen = xtoint(aZipEnd->commentfield_len);
+  if (commentlen < ZIPINDEX_TRAILER_SIZE || endp - comment < commentlen) {
+    return false;
+  }
+
+  const uint8_t* trailer = comment + commentlen - ZIPINDEX_TRAILER_SIZE;
+  if (xtolong(trailer + 8) != ZIPINDEXSIG) {
+    return false;
+  }
+  uint32_t baseCount = xtolong(trailer);
+  uint32_t entryCount = xtolong(trailer + 4);
+  uint32_t centralSize = xtolong(aZipEnd->central_dir_size);
+  uint64_t indexLen =
+      (uint64_t(baseCount) + entryCount) * 4 + ZIPINDEX_TRAILER_SIZE;
+  if (!baseCount || !entryCount ||
+      entryCount != xtoint(aZipEnd->total_entries_archive) ||
+      indexLen > commentlen || aCentral > endRecord ||
+      centralSize != uint32_t(endRecord - aCentral)) {
+    return false;
+  }
+
+  mIndexBases = comment + commentlen - indexLen;
+  mIndexOffsets = mIndexBases + baseCount * 4;
+  mIndexBaseCount = baseCount;
+  mIndexEntryCount = entryCount;
+  mCentralStart = aCentral;
+  mCentralSize = centralSize;
+
+  // The index isn't part of the comment for consumers.
+  mCommentPtr = (const char*)comment;
+  mCommentLen = commentlen - indexLen;
+  return true;
+}
+
+//---------------------------------------------
+//  nsZipArchive::GetIndexedItem
+//  Looks aEntryName up in the entry index, and adds an item for it to the
+//  file table if it's there. The caller has to handle mmap faults.
+//---------------------------------------------
+nsZipItem* nsZipArchive::GetIndexedItem(const char* aEntryName, uint32_t aLen,
+                                        uint32_t aHash) {
+  mLock.AssertCurrentThreadOwns();
+  MOZ_ASSERT(mIndexEntryCount);
+
+  using namespace mozilla::perfecthash;
+  uint32_t base =
+      ZipIndexSlot(Hash(FNV_OFFSET_BASIS, aEntryName, aLen), mIndexBaseCount);
+  uint32_t basis = xtolong(mIndexBases + base * 4);
+  uint32_t slot = ZipIndexSlot(Hash(basis, aEntryName, aLen), mIndexEntryCount);
+  uint32_t offset = xtolong(mIndexOffsets + slot * 4);
+  if (offset > mCentralSize || mCentralSize - offset < ZIPCENTRAL_SIZE) {
+    return nullptr;
   }
 
+  const ZipCentral* central = (const ZipCentral*)(mCentralStart + offset);
+  if (xtolong(central->signature) != CENTRALSIG) {
+    return nullptr;
+  }
+  uint16_t namelen = xtoint(central->filename_len);
+  uint32_t diff = ZIPCENTRAL_SIZE + namelen +
+                  xtoint(central->extrafield_len) +
+                  xtoint(central->commentfield_len);
+  if (namelen != aLen || mCentralSize - offset < diff ||
+      memcmp((const char*)central + ZIPCENTRAL_SIZE, aEntryName, aLen)) {
+    return nullptr;
+  }
+
+  nsZipItem* item = CreateZipItem();
+  if (!item) return nullptr;
+
+  item->central = central;
+  item->nameLength = namelen;
+  item->isSynthetic = false;
+
+  item->next = mFiles[aHash];
+  mFiles[aHash] = item;
+  return item;
+}
+
+//---------------------------------------------
+//  nsZipArchive::EnsureFileList
+//  Adds the items that haven't been looked up yet when using the entry
+//  index, for everything that walks the file table.
+//---------------------------------------------
+nsresult nsZipArchive::EnsureFileList() {
+  mLock.AssertCurrentThreadOwns();
+
+  if (!mIndexEntryCount) return NS_OK;
+
+  const uint8_t* endRecord;
+  nsresult rv;
+  MMAP_FAULT_HANDLER_BEGIN_HANDLE(mFd)
+  rv = ReadCentralDirectory(mCentralStart, &endRecord);
   MMAP_FAULT_HANDLER_CATCH(NS_ERROR_FAILURE)
-  return NS_OK;
+  if (NS_SUCCEEDED(rv)) {
+    mIndexEntryCount = 0;
+  }
+  return rv;
 }
 
 //---------------------------------------------
@@ -765,6 +928,9 @@ nsresult nsZipArchive::BuildSynthetics() {
   mLock.AssertCurrentThreadOwns();
 
   if (mBuiltSynthetics) return NS_OK;
+
+  nsresult rv = EnsureFileList();
+  if (NS_FAILED(rv)) return rv;
   mBuiltSynthetics = true;
 
   MMAP_FAULT_HANDLER_BEGIN_HANDLE(mFd)
@@ -901,6 +1067,12 @@ nsZipArchive::nsZipArchive()
       mCommentPtr(nullptr),
       mCommentLen(0),
       mBuiltSynthetics(false),
+      mIndexBases(nullptr),
+      mIndexOffsets(nullptr),
+      mIndexBaseCount(0),
+      mIndexEntryCount(0),
+      mCentralStart(nullptr),
+      mCentralSize(0),
       mUseZipLog(false) {
   // initialize the table to nullptr
   memset(mFiles, 0, sizeof(mFiles));
@@ -210,6 +210,16 @@ class nsZipArchive final {
   // Whether we synthesized the directory entries
   bool mBuiltSynthetics;
 
+  // The entry index at the end of the comment, see zipstruct.h. As long as
+  // mIndexEntryCount is set, the file table only has the items that were
+  // looked up so far; EnsureFileList() fills in the rest.
+  const uint8_t* mIndexBases;
+  const uint8_t* mIndexOffsets;
+  uint32_t mIndexBaseCount;
+  uint32_t mIndexEntryCount;
+  const uint8_t* mCentralStart;
+  uint32_t mCentralSize;
+
   // file handle
   RefPtr<nsZipHandle> mFd;
 
@@ -226,6 +236,12 @@ class nsZipArchive final {
   //--- private methods ---
   nsZipItem* CreateZipItem();
   nsresult BuildFileList(PRFileDesc* aFd = nullptr);
+  nsresult ReadCentralDirectory(const uint8_t* aBuf,
+                                const uint8_t** aEndRecord);
+  bool ReadIndex(const ZipEnd* aZipEnd, const uint8_t* aCentral);
+  nsZipItem* GetIndexedItem(const char* aEntryName, uint32_t aLen,
+                            uint32_t aHash);
+  nsresult EnsureFileList();
   nsresult BuildSynthetics();
 
   nsZipArchive& operator=(const nsZipArchive& rhs) = delete;
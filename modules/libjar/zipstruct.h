@@ -6,6 +6,8 @@
 #ifndef _zipstruct_h
 #define _zipstruct_h
 
+#include <stdint.h>
+
 /*
  *  Certain constants and structures for
  *  the Phil Katz ZIP archive format.
@@ -84,6 +86,35 @@ typedef struct ZipEnd_ {
 #define CENTRALSIG 0x02014B50l
 #define ENDSIG 0x06054B50l
 
+/*
+ * Optional entry index, written by nsZipWriter at the end of the archive
+ * comment so the central directory doesn't have to be parsed to find an
+ * entry (see nsIZipWriter.writeIndex). All values are little endian:
+ *
+ *   uint32 bases[nbases]
+ *   uint32 offsets[nentries]  central record offsets within the central
+ *                             directory, in perfect hash order
+ *   uint32 nbases
+ *   uint32 nentries           the entry count of the end record
+ *   uint32 signature          ZIPINDEXSIG
+ *
+ * An entry is looked up with the hash of mozilla::perfecthash: the basis is
+ * bases[ZipIndexSlot(Hash(FNV_OFFSET_BASIS, name), nbases)] and its record is
+ * offsets[ZipIndexSlot(Hash(basis, name), nentries)]. Names that are not in
+ * the archive hash to some record too, so its name has to be checked.
+ */
+#define ZIPINDEXSIG 0x58444E49l
+#define ZIPINDEX_TRAILER_SIZE (4 + 4 + 4)
+
+/*
+ * Maps a hash to [0, aCount). This uses the high bits of the hash rather than
+ * a modulo, as the low bits of an FNV hash are poorly mixed: the lowest one
+ * only depends on the parity of the bytes hashed.
+ */
+static inline uint32_t ZipIndexSlot(uint32_t aHash, uint32_t aCount) {
+  return (uint32_t)(((uint64_t)aHash * aCount) >> 32);
+}
+
 /* extra fields */
 #define EXTENDED_TIMESTAMP_FIELD 0x5455
 #define EXTENDED_TIMESTAMP_MODTIME 0x01
@@ -9,6 +9,8 @@
 
 #include "StreamFunctions.h"
 #include "nsZipDataStream.h"
+#include "zipstruct.h"
+#include "mozilla/PerfectHash.h"
 #include "nsISeekableStream.h"
 #include "nsIStreamListener.h"
 #include "nsIInputStreamPump.h"
@@ -25,6 +27,9 @@
 #define ZIP_EOCDR_HEADER_SIZE 22
 #define ZIP_EOCDR_HEADER_SIGNATURE 0x06054b50
 
+// How many bases are tried for a bucket of the entry index before giving up.
+#define ZIP_INDEX_MAX_TRIES (1 << 20)
+
 using namespace mozilla;
 
 /**
@@ -48,7 +53,8 @@ using namespace mozilla;
  */
 NS_IMPL_ISUPPORTS(nsZipWriter, nsIZipWriter, nsIRequestObserver)
 
-nsZipWriter::nsZipWriter() : mCDSOffset(0), mCDSDirty(false), mInQueue(false) {}
+nsZipWriter::nsZipWriter()
+    : mCDSOffset(0), mCDSDirty(false), mInQueue(false), mWriteIndex(false) {}
 
 nsZipWriter::~nsZipWriter() {
   if (mStream && !mInQueue) Close();
@@ -69,6 +75,41 @@ NS_IMETHODIMP nsZipWriter::SetComment(const nsACString& aComment) {
   return NS_OK;
 }
 
+NS_IMETHODIMP nsZipWriter::GetWriteIndex(bool* aWriteIndex) {
+  if (!mStream) return NS_ERROR_NOT_INITIALIZED;
+
+  *aWriteIndex = mWriteIndex;
+  return NS_OK;
+}
+
+NS_IMETHODIMP nsZipWriter::SetWriteIndex(bool aWriteIndex) {
+  if (!mStream) return NS_ERROR_NOT_INITIALIZED;
+
+  if (aWriteIndex != mWriteIndex) {
+    mWriteIndex = aWriteIndex;
+    mCDSDirty = true;
+  }
+  return NS_OK;
+}
+
+/*
+ * Returns the length of the entry index at the end of aComment, or 0 if
+ * there is none. See zipstruct.h for its layout.
+ */
+static uint32_t IndexLength(const nsACString& aComment, uint32_t aEntries) {
+  if (aComment.Length() < ZIPINDEX_TRAILER_SIZE) return 0;
+
+  const uint8_t* buf = (const uint8_t*)aComment.BeginReading();
+  uint32_t pos = aComment.Length() - ZIPINDEX_TRAILER_SIZE;
+  uint32_t baseCount = READ32(buf, &pos);
+  uint32_t entryCount = READ32(buf, &pos);
+  if (READ32(buf, &pos) != ZIPINDEXSIG || entryCount != aEntries) return 0;
+
+  uint64_t length =
+      (uint64_t(baseCount) + entryCount) * 4 + ZIPINDEX_TRAILER_SIZE;
+  return length <= aComment.Length() ? uint32_t(length) : 0;
+}
+
 NS_IMETHODIMP nsZipWriter::GetInQueue(bool* aInQueue) {
   *aInQueue = mInQueue;
   return NS_OK;
@@ -165,6 +206,13 @@ nsresult nsZipWriter::ReadFile(nsIFile* aFile) {
           mComment.Assign(field.get(), commentlen);
         }
 
+        // Keep the index, but build it again on close.
+        uint32_t indexLength = IndexLength(mComment, entries);
+        if (indexLength) {
+          mComment.Truncate(mComment.Length() - indexLength);
+          mWriteIndex = true;
+        }
+
         rv = seekable->Seek(nsISeekableStream::NS_SEEK_SET, mCDSOffset);
         if (NS_FAILED(rv)) {
           inputStream->Close();
@@ -232,6 +280,7 @@ NS_IMETHODIMP nsZipWriter::Open(nsIFile* aFile, int32_t aIoFlags) {
     mCDSOffset = 0;
     mCDSDirty = true;
     mComment.Truncate();
+    mWriteIndex = false;
   }
 
   // Silently drop PR_APPEND
@@ -574,6 +623,11 @@ NS_IMETHODIMP nsZipWriter::Close() {
       size += mHeaders[i]->GetCDSHeaderLength();
     }
 
+    nsAutoCString comment(mComment);
+    if (mWriteIndex && !AppendIndex(comment)) {
+      NS_WARNING("Can't write an index for this zip");
+    }
+
     uint8_t buf[ZIP_EOCDR_HEADER_SIZE];
     uint32_t pos = 0;
     WRITE32(buf, &pos, ZIP_EOCDR_HEADER_SIGNATURE);
@@ -583,7 +637,7 @@ NS_IMETHODIMP nsZipWriter::Close() {
     WRITE16(buf, &pos, mHeaders.Count());
     WRITE32(buf, &pos, size);
     WRITE32(buf, &pos, mCDSOffset);
-    WRITE16(buf, &pos, mComment.Length());
+    WRITE16(buf, &pos, comment.Length());
 
     nsresult rv = ZW_WriteData(mStream, (const char*)buf, pos);
     if (NS_FAILED(rv)) {
@@ -591,7 +645,7 @@ NS_IMETHODIMP nsZipWriter::Close() {
       return rv;
     }
 
-    rv = ZW_WriteData(mStream, mComment.get(), mComment.Length());
+    rv = ZW_WriteData(mStream, comment.get(), comment.Length());
     if (NS_FAILED(rv)) {
       Cleanup();
       return rv;
@@ -845,6 +899,99 @@ nsresult nsZipWriter::SeekCDS() {
  * In a bad error condition this essentially closes down the component as best
  * it can.
  */
+/*
+ * Appends a minimal perfect hash of the entry names to the offsets of their
+ * central directory records to aComment, in the layout described in
+ * zipstruct.h. Entries are put in buckets by their first hash, and for each
+ * bucket, biggest first, a basis is searched that moves all its entries to
+ * free slots.
+ */
+bool nsZipWriter::AppendIndex(nsACString& aComment) {
+  using namespace mozilla::perfecthash;
+
+  uint32_t count = mHeaders.Count();
+  if (!count) return false;
+
+  uint32_t baseCount = std::max(count / 2, 1u);
+  uint64_t indexLength =
+      (uint64_t(baseCount) + count) * 4 + ZIPINDEX_TRAILER_SIZE;
+  if (aComment.Length() + indexLength > UINT16_MAX) return false;
+
+  nsTArray<nsTArray<uint32_t>> buckets;
+  buckets.SetLength(baseCount);
+  for (uint32_t i = 0; i < count; i++) {
+    const nsCString& name = mHeaders[i]->mName;
+    uint32_t hash = Hash(FNV_OFFSET_BASIS, name.get(), name.Length());
+    buckets[ZipIndexSlot(hash, baseCount)].AppendElement(i);
+  }
+
+  nsTArray<uint32_t> order;
+  for (uint32_t i = 0; i < baseCount; i++) order.AppendElement(i);
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return buckets[a].Length() > buckets[b].Length();
+  });
+
+  nsTArray<uint32_t> bases;
+  bases.InsertElementsAt(0, baseCount, 0u);
+  nsTArray<int32_t> slots;
+  slots.InsertElementsAt(0, count, -1);
+  nsTArray<uint32_t> taken;
+  for (uint32_t b : order) {
+    const nsTArray<uint32_t>& bucket = buckets[b];
+    if (bucket.IsEmpty()) break;
+
+    uint32_t basis = 0;
+    bool placed = false;
+    while (!placed) {
+      if (++basis > ZIP_INDEX_MAX_TRIES) return false;
+      placed = true;
+      taken.ClearAndRetainStorage();
+      for (uint32_t entry : bucket) {
+        const nsCString& name = mHeaders[entry]->mName;
+        uint32_t slot =
+            ZipIndexSlot(Hash(basis, name.get(), name.Length()), count);
+        if (slots[slot] != -1 || taken.Contains(slot)) {
+          placed = false;
+          break;
+        }
+        taken.AppendElement(slot);
+      }
+    }
+
+    for (uint32_t i = 0; i < bucket.Length(); i++) {
+      slots[taken[i]] = bucket[i];
+    }
+    bases[b] = basis;
+  }
+
+  nsTArray<uint32_t> offsets;
+  uint32_t offset = 0;
+  for (int32_t i = 0; i < mHeaders.Count(); i++) {
+    offsets.AppendElement(offset);
+    offset += mHeaders[i]->GetCDSHeaderLength();
+  }
+
+  uint32_t start = aComment.Length();
+  aComment.SetLength(start + indexLength);
+  uint8_t* buf = (uint8_t*)aComment.BeginWriting();
+  uint32_t pos = start;
+  for (uint32_t basis : bases) WRITE32(buf, &pos, basis);
+  for (int32_t entry : slots) WRITE32(buf, &pos, offsets[entry]);
+  WRITE32(buf, &pos, baseCount);
+  WRITE32(buf, &pos, count);
+  WRITE32(buf, &pos, ZIPINDEXSIG);
+
+  // Readers look for the end record from the end of the file, so the index
+  // mustn't look like one.
+  for (pos = start >= 3 ? start - 3 : 0; pos + 4 <= aComment.Length(); pos++) {
+    if (PEEK32(buf + pos) == ZIP_EOCDR_HEADER_SIGNATURE) {
+      aComment.Truncate(start);
+      return false;
+    }
+  }
+  return true;
+}
+
 void nsZipWriter::Cleanup() {
   mHeaders.Clear();
   mEntryHash.Clear();
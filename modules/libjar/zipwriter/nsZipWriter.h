@@ -52,6 +52,7 @@ class nsZipWriter final : public nsIZipWriter, public nsIRequestObserver {
   uint32_t mCDSOffset;
   bool mCDSDirty;
   bool mInQueue;
+  bool mWriteIndex;
 
   nsCOMPtr<nsIFile> mFile;
   nsCOMPtr<nsIRequestObserver> mProcessObserver;
@@ -63,6 +64,7 @@ class nsZipWriter final : public nsIZipWriter, public nsIRequestObserver {
   nsCString mComment;
 
   nsresult SeekCDS();
+  bool AppendIndex(nsACString& aComment);
   void Cleanup();
   nsresult ReadFile(nsIFile* aFile);
   nsresult InternalAddEntryDirectory(const nsACString& aZipEntry,
@@ -425,6 +425,10 @@ struct PrefsSizes {
 
 static StaticRefPtr<SharedPrefMap> gSharedMap;
 
+// Snapshots replaced by a rebuilt gSharedMap. Strings handed out by a
+// SharedPrefMap point into its mapping, so these are kept until shutdown.
+static StaticAutoPtr<nsTArray<RefPtr<SharedPrefMap>>> gRetiredSharedMaps;
+
 // Arena for Pref names. Inside a function so we can assert it's only accessed
 // on the main thread.
 static inline ArenaAllocator<4096, 1>& PrefNameArena() {
@@ -1475,6 +1479,13 @@ static void NotifyCallbacks(const nsCString& aPrefName,
 constexpr size_t kHashTableInitialLengthParent = 3000;
 constexpr size_t kHashTableInitialLengthContent = 64;
 
+// Once this many preferences have changed in the parent since the snapshot was
+// built, the next content process launch rebuilds the snapshot rather than
+// sending every change alongside it. Superseded snapshots stay mapped, so the
+// number of rebuilds per session is bounded.
+constexpr size_t kSnapshotRebuildThreshold = 128;
+constexpr size_t kMaxSnapshotRebuilds = 4;
+
 static PrefSaveData pref_savePrefs() {
   MOZ_ASSERT(NS_IsMainThread());
 
@@ -3130,6 +3141,13 @@ PreferenceServiceReporter::CollectReports(
   if (gSharedMap) {
     sizes.mMisc += mallocSizeOf(gSharedMap);
   }
+  if (gRetiredSharedMaps) {
+    sizes.mMisc +=
+        gRetiredSharedMaps->ShallowSizeOfIncludingThis(mallocSizeOf);
+    for (const auto& map : *gRetiredSharedMaps) {
+      sizes.mMisc += mallocSizeOf(map);
+    }
+  }
 
 #ifdef ACCESS_COUNTS
   if (gAccessCounts) {
@@ -3174,6 +3192,17 @@ PreferenceServiceReporter::CollectReports(
                          UNITS_BYTES, gSharedMap->MapSize(),
                          "The shared memory mapping used to share a "
                          "snapshot of preference values across processes.");
+      size_t retiredSize = 0;
+      if (gRetiredSharedMaps) {
+        for (const auto& map : *gRetiredSharedMaps) {
+          retiredSize += map->MapSize();
+        }
+      }
+      MOZ_COLLECT_REPORT(
+          "explicit/preferences/retired-shared-memory-maps", KIND_NONHEAP,
+          UNITS_BYTES, retiredSize,
+          "Shared memory mappings of preference snapshots that have been "
+          "replaced by a newer one.");
     }
   }
 
@@ -3513,6 +3542,7 @@ Preferences::~Preferences() {
 #endif
 
   gSharedMap = nullptr;
+  gRetiredSharedMaps = nullptr;
 
   PrefNameArena().Clear();
 }
@@ -3571,10 +3601,82 @@ static void RegisterOncePrefs(SharedPrefMapBuilder& aBuilder);
 
 }  // namespace StaticPrefs
 
+static void AddSharedPrefToMap(SharedPrefMapBuilder& aMap,
+                               const SharedPrefMap::Pref& aPref) {
+  bool hasDefault = aPref.HasDefaultValue();
+  bool hasUser = aPref.HasUserValue();
+  SharedPrefMapBuilder::Flags flags{hasDefault, hasUser, aPref.IsSticky(),
+                                    aPref.IsLocked(),
+                                    aPref.IsSkippedByIteration()};
+
+  switch (aPref.Type()) {
+    case PrefType::Bool:
+      aMap.Add(aPref.NameString(), flags,
+               hasDefault && aPref.GetBoolValue(PrefValueKind::Default),
+               hasUser && aPref.GetBoolValue());
+      break;
+    case PrefType::Int:
+      aMap.Add(aPref.NameString(), flags,
+               hasDefault ? aPref.GetIntValue(PrefValueKind::Default) : 0,
+               hasUser ? aPref.GetIntValue() : 0);
+      break;
+    case PrefType::String:
+      aMap.Add(aPref.NameString(), flags,
+               hasDefault ? aPref.GetStringValue(PrefValueKind::Default)
+                          : nsCString(),
+               hasUser ? aPref.GetStringValue() : nsCString());
+      break;
+    default:
+      MOZ_ASSERT_UNREACHABLE("Unexpected preference type");
+      break;
+  }
+}
+
+// Replaces gSharedMap with a snapshot of the current database, so that new
+// content processes don't need the preferences changed since the last one.
+static void RebuildSnapshot() {
+  MOZ_ASSERT(gSharedMap);
+
+  SharedPrefMapBuilder builder;
+
+  // Entries hidden from iteration, such as the saved values of `once`-mirrored
+  // prefs, are carried over as well.
+  for (uint32_t i = 0; i < gSharedMap->Count(); i++) {
+    const SharedPrefMap::Pref pref = gSharedMap->GetValueAt(i);
+    if (!HashTable()->has(pref.Name())) {
+      AddSharedPrefToMap(builder, pref);
+    }
+  }
+  for (auto iter = HashTable()->iter(); !iter.done(); iter.next()) {
+    // Entries of type None stand for prefs deleted since the last snapshot.
+    if (!iter.get()->IsTypeNone()) {
+      iter.get()->AddToMap(builder);
+    }
+  }
+
+  if (!gRetiredSharedMaps) {
+    gRetiredSharedMaps = new nsTArray<RefPtr<SharedPrefMap>>();
+  }
+  gRetiredSharedMaps->AppendElement(gSharedMap.get());
+  gSharedMap = new SharedPrefMap(std::move(builder));
+
+  HashTable()->clearAndCompact();
+  Unused << HashTable()->reserve(kHashTableInitialLengthContent);
+
+  PrefNameArena().Clear();
+  gCallbackPref = nullptr;
+}
+
 /* static */
 FileDescriptor Preferences::EnsureSnapshot(size_t* aSize) {
   MOZ_ASSERT(XRE_IsParentProcess());
 
+  if (gSharedMap && HashTable()->count() >= kSnapshotRebuildThreshold &&
+      (!gRetiredSharedMaps ||
+       gRetiredSharedMaps->Length() < kMaxSnapshotRebuilds)) {
+    RebuildSnapshot();
+  }
+
   if (!gSharedMap) {
     SharedPrefMapBuilder builder;
 
@@ -93,6 +93,10 @@ pref("security.OCSP.require", false);
 pref("security.OCSP.timeoutMilliseconds.hard", 10000);
 
 pref("security.pki.cert_short_lifetime_in_days", 10);
+// How long, in seconds, a successfully verified TLS server certificate chain
+// can be reused before it is built and checked again. 0 disables the cache.
+// Only read at startup.
+pref("security.pki.verified_chain_cache.lifetime", 0);
 // NB: Changes to this pref affect CERT_CHAIN_SHA1_POLICY_STATUS telemetry.
 // See the comment in CertVerifier.cpp.
 // 3 = only allow SHA-1 for certificates issued by an imported root.
@@ -1128,6 +1132,9 @@ pref("javascript.options.mem.max", -1);
   pref("javascript.options.mem.nursery.min_kb", 256);
   pref("javascript.options.mem.nursery.max_kb", 16384);
 #endif
+// JSGC_MAX_NURSERY_BYTES for content processes with a background priority.
+// -1 keeps javascript.options.mem.nursery.max_kb.
+pref("javascript.options.mem.nursery.background_max_kb", -1);
 
 // JSGC_MODE
 pref("javascript.options.mem.gc_per_zone", true);
@@ -1529,6 +1536,23 @@ pref("network.websocket.timeout.ping.response", 10);
 // extension with the websocket server.
 pref("network.websocket.extensions.permessage-deflate", true);
 
+// The largest LZ77 window, in bits (9 to 15), that permessage-deflate uses to
+// compress and asks the server to use. Smaller windows need less memory per
+// connection but compress less.
+pref("network.websocket.extensions.permessage-deflate.max-window-bits", 15);
+
+// Whether permessage-deflate is offered without context takeover, so that
+// neither side keeps its compression window from one message to the next.
+pref("network.websocket.extensions.permessage-deflate.no-context-takeover", false);
+
+// The number of seconds after which the compression state that doesn't need to
+// be kept between messages is released on an idle connection. 0 disables.
+pref("network.websocket.extensions.permessage-deflate.idle-timeout", 30);
+
+// Whether the messages read from the network at once are delivered to the
+// listener by a single event rather than one event each.
+pref("network.websocket.coalesce-messages", true);
+
 // the maximum number of concurrent websocket sessions. By specification there
 // is never more than one handshake oustanding to an individual host at
 // one time.
@@ -1935,6 +1959,11 @@ pref("intl.uidirection", -1); // -1 to set from locale; 0 for LTR; 1 for RTL
 // See https://firefox-source-docs.mozilla.org/l10n/fluent/tutorial.html#pseudolocalization.
 pref("intl.l10n.pseudo", "");
 
+// Whether the sources of the Fluent resources fetched by any process are kept
+// in shared memory for the other processes, up to the given size.
+pref("intl.l10n.shared_resources.enabled", false);
+pref("intl.l10n.shared_resources.max_bytes", 4194304);
+
 // use en-US hyphenation by default for content tagged with plain lang="en"
 pref("intl.hyphenation-alias.en", "en-us");
 // and for other subtags of en-*, if no specific patterns are available
@@ -3895,6 +3924,10 @@ pref("dom.push.maxRecentMessageIDsPerSubscription", 10);
 // subscription.
 pref("dom.push.quotaUpdateDelay", 3000); // 3 seconds
 
+// Messages for the same service worker that arrive within this many ms are
+// dispatched together. 0 dispatches each message as soon as it arrives.
+pref("dom.push.coalesceWindow", 0);
+
 // Is the network connection allowed to be up?
 // This preference should be used in UX to enable/disable push.
 pref("dom.push.connection.enabled", true);
@@ -6,8 +6,15 @@
 #include "mozilla/ArrayAlgorithm.h"
 #include "mozilla/Preferences.h"
 #include "mozilla/Logging.h"
+#include "nsAppDirectoryServiceDefs.h"
+#include "nsDirectoryServiceUtils.h"
+#include "nsIFile.h"
 #include "nsIOService.h"
+#include "nsISafeOutputStream.h"
+#include "nsNetUtil.h"
 #include "nsNSSIOLayer.h"
+#include "nsReadableUtils.h"
+#include "nsThreadUtils.h"
 #include "TransportSecurityInfo.h"
 #include "CertVerifier.h"
 #include "ssl.h"
@@ -20,6 +27,75 @@ static LazyLogModule gSSLTokensCacheLog("SSLTokensCache");
 #undef LOG
 #define LOG(args) MOZ_LOG(gSSLTokensCacheLog, mozilla::LogLevel::Debug, args)
 
+namespace {
+
+constexpr auto kPersistFileName = "ssl_tokens_cache.bin"_ns;
+const uint32_t kPersistMagic = 0x53534c54;  // "SSLT"
+const uint32_t kPersistVersion = 1;
+// Stands in for an absent Maybe<> in the persisted cache.
+const uint32_t kNoValue = UINT32_MAX;
+
+template <typename T>
+void WriteValue(nsACString& aOut, T aValue) {
+  aOut.Append(reinterpret_cast<const char*>(&aValue), sizeof(T));
+}
+
+void WriteBytes(nsACString& aOut, const nsTArray<uint8_t>& aBytes) {
+  WriteValue<uint32_t>(aOut, aBytes.Length());
+  aOut.Append(reinterpret_cast<const char*>(aBytes.Elements()),
+              aBytes.Length());
+}
+
+class Reader {
+ public:
+  explicit Reader(const nsACString& aData)
+      : mCur(aData.BeginReading()), mEnd(aData.EndReading()) {}
+
+  template <typename T>
+  bool ReadValue(T& aValue) {
+    if (size_t(mEnd - mCur) < sizeof(T)) {
+      return false;
+    }
+    memcpy(&aValue, mCur, sizeof(T));
+    mCur += sizeof(T);
+    return true;
+  }
+
+  bool ReadBytes(nsTArray<uint8_t>& aBytes) {
+    uint32_t length;
+    if (!ReadValue(length) || size_t(mEnd - mCur) < length) {
+      return false;
+    }
+    aBytes.AppendElements(reinterpret_cast<const uint8_t*>(mCur), length);
+    mCur += length;
+    return true;
+  }
+
+  bool ReadString(nsACString& aString) {
+    uint32_t length;
+    if (!ReadValue(length) || size_t(mEnd - mCur) < length) {
+      return false;
+    }
+    aString.Assign(mCur, length);
+    mCur += length;
+    return true;
+  }
+
+  bool AtEnd() const { return mCur == mEnd; }
+
+ private:
+  const char* mCur;
+  const char* mEnd;
+};
+
+// Tokens of private browsing connections must never reach the disk.
+bool IsPrivateKey(const nsACString& aKey) {
+  return FindInReadable("private:"_ns, aKey) ||
+         FindInReadable("privateBrowsingId="_ns, aKey);
+}
+
+}  // namespace
+
 class ExpirationComparator {
  public:
   bool Equals(SSLTokensCache::TokenCacheRecord* a,
@@ -413,6 +489,234 @@ void SSLTokensCache::Clear() {
   gInstance->mExpirationArray.Clear();
   gInstance->mTokenCacheRecords.Clear();
   gInstance->mCacheSize = 0;
+
+  if (gInstance->mCacheFile) {
+    nsCOMPtr<nsIFile> file;
+    if (NS_SUCCEEDED(gInstance->mCacheFile->Clone(getter_AddRefs(file)))) {
+      NS_DispatchBackgroundTask(
+          NS_NewRunnableFunction("SSLTokensCache::Clear",
+                                 [file]() { file->Remove(false); }),
+          NS_DISPATCH_EVENT_MAY_BLOCK);
+    }
+  }
+}
+
+void SSLTokensCache::InsertLocked(const nsACString& aKey,
+                                  PRUint32 aExpirationTime,
+                                  nsTArray<uint8_t>&& aToken,
+                                  SessionCacheInfo&& aInfo) {
+  sLock.AssertCurrentThreadOwns();
+
+  auto rec = MakeUnique<TokenCacheRecord>();
+  rec->mKey = aKey;
+  rec->mExpirationTime = aExpirationTime;
+  rec->mToken = std::move(aToken);
+  rec->mSessionCacheInfo = std::move(aInfo);
+
+  mCacheSize += rec->Size();
+  mExpirationArray.AppendElement(rec.get());
+  mTokenCacheRecords.InsertOrUpdate(aKey, std::move(rec));
+}
+
+void SSLTokensCache::Deserialize(const nsACString& aData) {
+  sLock.AssertCurrentThreadOwns();
+
+  Reader reader(aData);
+  uint32_t magic, version;
+  if (!reader.ReadValue(magic) || magic != kPersistMagic ||
+      !reader.ReadValue(version) || version != kPersistVersion) {
+    LOG(("SSLTokensCache::Deserialize - unknown format"));
+    return;
+  }
+
+  PRTime now = PR_Now();
+  uint32_t loaded = 0;
+  while (!reader.AtEnd()) {
+    nsAutoCString key;
+    PRTime expiration;
+    nsTArray<uint8_t> token;
+    uint8_t evStatus;
+    SessionCacheInfo info;
+    uint32_t chainLength;
+    uint8_t builtInRoot;
+
+    if (!reader.ReadString(key) || !reader.ReadValue(expiration) ||
+        !reader.ReadBytes(token) || !reader.ReadValue(evStatus) ||
+        !reader.ReadValue(info.mCertificateTransparencyStatus) ||
+        !reader.ReadBytes(info.mServerCertBytes) ||
+        !reader.ReadValue(chainLength)) {
+      LOG(("SSLTokensCache::Deserialize - truncated record"));
+      break;
+    }
+
+    bool ok = true;
+    if (chainLength != kNoValue) {
+      info.mSucceededCertChainBytes.emplace();
+      for (uint32_t i = 0; ok && i < chainLength; ++i) {
+        ok = reader.ReadBytes(*info.mSucceededCertChainBytes->AppendElement());
+      }
+    }
+    if (!ok || !reader.ReadValue(builtInRoot)) {
+      LOG(("SSLTokensCache::Deserialize - truncated record"));
+      break;
+    }
+
+    // Entries made since startup are newer than anything on disk.
+    if (expiration <= now || mTokenCacheRecords.Contains(key)) {
+      continue;
+    }
+
+    info.mEVStatus = evStatus ? psm::EVStatus::EV : psm::EVStatus::NotEV;
+    if (builtInRoot) {
+      info.mIsBuiltCertChainRootBuiltInRoot.emplace(builtInRoot == 2);
+    }
+
+    InsertLocked(key, PRUint32(expiration), std::move(token),
+                 std::move(info));
+    ++loaded;
+  }
+
+  LOG(("SSLTokensCache::Deserialize - loaded %u tokens", loaded));
+  LogStats();
+  EvictIfNecessary();
+}
+
+// static
+void SSLTokensCache::LoadFromDisk() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (!StaticPrefs::network_ssl_tokens_cache_enabled() ||
+      !StaticPrefs::network_ssl_tokens_cache_persist() ||
+      !XRE_IsParentProcess() || nsIOService::UseSocketProcess()) {
+    return;
+  }
+
+  nsCOMPtr<nsIFile> file;
+  if (NS_FAILED(NS_GetSpecialDirectory(NS_APP_USER_PROFILE_50_DIR,
+                                       getter_AddRefs(file))) ||
+      NS_FAILED(file->AppendNative(kPersistFileName))) {
+    return;
+  }
+
+  nsCOMPtr<nsIFile> readFile;
+  {
+    StaticMutexAutoLock lock(sLock);
+    if (!gInstance || NS_FAILED(file->Clone(getter_AddRefs(readFile)))) {
+      return;
+    }
+    gInstance->mCacheFile = file;
+  }
+
+  NS_DispatchBackgroundTask(
+      NS_NewRunnableFunction(
+          "SSLTokensCache::LoadFromDisk",
+          [readFile]() {
+            nsCOMPtr<nsIInputStream> stream;
+            if (NS_FAILED(NS_NewLocalFileInputStream(getter_AddRefs(stream),
+                                                     readFile))) {
+              return;
+            }
+
+            nsAutoCString data;
+            if (NS_FAILED(NS_ReadInputStreamToString(stream, data, -1))) {
+              return;
+            }
+
+            StaticMutexAutoLock lock(sLock);
+            if (gInstance) {
+              gInstance->Deserialize(data);
+            }
+          }),
+      NS_DISPATCH_EVENT_MAY_BLOCK);
+}
+
+// static
+void SSLTokensCache::SaveToDisk() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  nsCOMPtr<nsIFile> file;
+  nsAutoCString data;
+  {
+    StaticMutexAutoLock lock(sLock);
+    if (!gInstance || !gInstance->mCacheFile) {
+      return;
+    }
+    file = gInstance->mCacheFile;
+
+    if (!StaticPrefs::network_ssl_tokens_cache_persist()) {
+      file->Remove(false);
+      return;
+    }
+
+    WriteValue(data, kPersistMagic);
+    WriteValue(data, kPersistVersion);
+
+    PRTime now = PR_Now();
+    for (const TokenCacheRecord* rec : gInstance->mExpirationArray) {
+      if (rec->mToken.IsEmpty() || IsPrivateKey(rec->mKey)) {
+        continue;
+      }
+
+      // mExpirationTime doesn't have a consistent unit across TLS and QUIC
+      // tokens, so take the real lifetime from the token itself.
+      SSLResumptionTokenInfo tokenInfo;
+      if (SSL_GetResumptionTokenInfo(rec->mToken.Elements(),
+                                     rec->mToken.Length(), &tokenInfo,
+                                     sizeof(tokenInfo)) != SECSuccess) {
+        continue;
+      }
+      PRTime expiration = tokenInfo.expirationTime;
+      SSL_DestroyResumptionTokenInfo(&tokenInfo);
+      if (expiration <= now) {
+        continue;
+      }
+
+      const SessionCacheInfo& info = rec->mSessionCacheInfo;
+      WriteValue<uint32_t>(data, rec->mKey.Length());
+      data.Append(rec->mKey);
+      WriteValue(data, expiration);
+      WriteBytes(data, rec->mToken);
+      WriteValue<uint8_t>(data, info.mEVStatus == psm::EVStatus::EV);
+      WriteValue(data, info.mCertificateTransparencyStatus);
+      WriteBytes(data, info.mServerCertBytes);
+      if (info.mSucceededCertChainBytes) {
+        WriteValue<uint32_t>(data, info.mSucceededCertChainBytes->Length());
+        for (const auto& cert : *info.mSucceededCertChainBytes) {
+          WriteBytes(data, cert);
+        }
+      } else {
+        WriteValue(data, kNoValue);
+      }
+      WriteValue<uint8_t>(data, info.mIsBuiltCertChainRootBuiltInRoot
+                                    ? 1 + *info.mIsBuiltCertChainRootBuiltInRoot
+                                    : 0);
+    }
+  }
+
+  nsCOMPtr<nsIOutputStream> stream;
+  nsresult rv = NS_NewSafeLocalFileOutputStream(getter_AddRefs(stream), file,
+                                                -1, 0600);
+  if (NS_FAILED(rv)) {
+    return;
+  }
+
+  const char* buf = data.BeginReading();
+  uint32_t remaining = data.Length();
+  while (remaining) {
+    uint32_t written = 0;
+    rv = stream->Write(buf, remaining, &written);
+    if (NS_FAILED(rv)) {
+      LOG(("SSLTokensCache::SaveToDisk - write failed"));
+      return;
+    }
+    buf += written;
+    remaining -= written;
+  }
+
+  nsCOMPtr<nsISafeOutputStream> safeStream = do_QueryInterface(stream);
+  if (safeStream) {
+    safeStream->Finish();
+  }
 }
 
 }  // namespace net
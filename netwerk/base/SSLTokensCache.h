@@ -7,6 +7,7 @@
 
 #include "nsIMemoryReporter.h"
 #include "nsClassHashtable.h"
+#include "nsCOMPtr.h"
 #include "nsTArray.h"
 #include "mozilla/Maybe.h"
 #include "mozilla/StaticMutex.h"
@@ -16,6 +17,8 @@
 #include "TransportSecurityInfo.h"
 #include "CertVerifier.h"  // For EVStatus
 
+class nsIFile;
+
 namespace mozilla {
 namespace net {
 
@@ -51,11 +54,22 @@ class SSLTokensCache : public nsIMemoryReporter {
   static nsresult Remove(const nsACString& aKey);
   static void Clear();
 
+  // The cache can be persisted in the profile so that sessions resume across
+  // restarts. LoadFromDisk reads it in the background once the profile is
+  // available and SaveToDisk writes it back before network teardown. Both
+  // are no-ops unless network.ssl_tokens_cache_persist is set and the tokens
+  // live in this (parent) process.
+  static void LoadFromDisk();
+  static void SaveToDisk();
+
  private:
   SSLTokensCache();
   virtual ~SSLTokensCache();
 
   nsresult RemoveLocked(const nsACString& aKey);
+  void InsertLocked(const nsACString& aKey, PRUint32 aExpirationTime,
+                    nsTArray<uint8_t>&& aToken, SessionCacheInfo&& aInfo);
+  void Deserialize(const nsACString& aData);
 
   void EvictIfNecessary();
   void LogStats();
@@ -67,6 +81,9 @@ class SSLTokensCache : public nsIMemoryReporter {
 
   uint32_t mCacheSize;  // Actual cache size in bytes
 
+  // Set once the persisted cache has been located in the profile.
+  nsCOMPtr<nsIFile> mCacheFile;
+
   class TokenCacheRecord {
    public:
     uint32_t Size() const;
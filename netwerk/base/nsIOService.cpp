@@ -1579,6 +1579,7 @@ NS_IMETHODIMP
 nsIOService::Observe(nsISupports* subject, const char* topic,
                      const char16_t* data) {
   if (!strcmp(topic, kProfileChangeNetTeardownTopic)) {
+    SSLTokensCache::SaveToDisk();
     if (!mHttpHandlerAlreadyShutingDown) {
       mNetTearingDownStarted = PR_IntervalNow();
     }
@@ -1603,6 +1604,8 @@ nsIOService::Observe(nsISupports* subject, const char* topic,
       // And now reflect the preference setting
       PrefsChanged(MANAGE_OFFLINE_STATUS_PREF);
 
+      SSLTokensCache::LoadFromDisk();
+
       // Bug 870460 - Read cookie database at an early-as-possible time
       // off main thread. Hence, we have more chance to finish db query
       // before something calls into the cookie service.
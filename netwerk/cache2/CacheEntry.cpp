@@ -379,8 +379,13 @@ bool CacheEntry::Load(bool aTruncate, bool aPriority) {
   if ((!aTruncate || !mUseDisk) && NS_SUCCEEDED(rv)) {
     // Check the index right now to know we have or have not the entry
     // as soon as possible.
+    // A disk entry only uses the index to skip opening a file that isn't
+    // there, so the main thread doesn't wait for a busy index for that.
     CacheIndex::EntryStatus status;
-    if (NS_SUCCEEDED(CacheIndex::HasEntry(fileKey, &status))) {
+    nsresult statusRv = mUseDisk && NS_IsMainThread()
+                            ? CacheIndex::TryHasEntry(fileKey, &status)
+                            : CacheIndex::HasEntry(fileKey, &status);
+    if (NS_SUCCEEDED(statusRv)) {
       switch (status) {
         case CacheIndex::DOES_NOT_EXIST:
           // Doesn't apply to memory-only entries, Load() is called only once
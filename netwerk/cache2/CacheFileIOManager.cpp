@@ -1992,6 +1992,22 @@ nsresult CacheFileIOManager::WriteInternal(CacheFileHandle* aHandle,
       return NS_ERROR_FILE_NO_DEVICE_SPACE;
     }
 
+    uint32_t pinnedLimit = CacheObserver::PinnedCacheCapacity();
+    if (pinnedLimit &&
+        aHandle->mPinning == CacheFileHandle::PinningStatus::PINNED) {
+      uint32_t pinnedUsage;
+      rv = CacheIndex::GetPinnedCacheSize(&pinnedUsage);
+      if (NS_SUCCEEDED(rv) &&
+          pinnedUsage + ((aOffset + aCount - aHandle->mFileSize) >> 10) >
+              pinnedLimit) {
+        LOG(
+            ("CacheFileIOManager::WriteInternal() - failing because pinned "
+             "entries reached their limit! [pinnedSize=%ukB, limit=%ukB]",
+             pinnedUsage, pinnedLimit));
+        return NS_ERROR_FILE_NO_DEVICE_SPACE;
+      }
+    }
+
     int64_t freeSpace;
     rv = mCacheDirectory->GetDiskSpaceAvailable(&freeSpace);
     if (NS_WARN_IF(NS_FAILED(rv))) {
@@ -2027,6 +2043,19 @@ nsresult CacheFileIOManager::WriteInternal(CacheFileHandle* aHandle,
     uint32_t oldSizeInK = aHandle->FileSizeInK();
     int64_t writeEnd = aOffset + bytesWritten;
 
+    // Only metadata is written with aTruncate, it always ends the file.
+    if (aHandle->IsSpecialFile()) {
+      mBytesWritten[WRITE_INDEX] += bytesWritten;
+    } else if (aTruncate) {
+      mBytesWritten[WRITE_METADATA] += bytesWritten;
+    } else {
+      mBytesWritten[WRITE_DATA] += bytesWritten;
+      if (aOffset < aHandle->mFileSize) {
+        mBytesWritten[WRITE_DATA_REWRITTEN] +=
+            std::min<int64_t>(writeEnd, aHandle->mFileSize) - aOffset;
+      }
+    }
+
     if (aTruncate) {
       rv = TruncFile(aHandle->mFD, writeEnd);
       NS_ENSURE_SUCCESS(rv, rv);
@@ -2789,11 +2818,18 @@ nsresult CacheFileIOManager::OverLimitEvictionInternal() {
     uint32_t cacheLimit = CacheObserver::DiskCacheCapacity();
     uint32_t freeSpaceLimit = CacheObserver::DiskFreeSpaceSoftLimit();
 
-    if (cacheUsage > cacheLimit) {
+    // This is only started once the cache is over the limit. Keep going until
+    // a whole batch below it, so that the following writes don't start
+    // another eviction of a single entry each.
+    uint32_t evictionTarget =
+        cacheLimit -
+        std::min(CacheObserver::EvictionBatchSize(), cacheLimit / 10);
+
+    if (cacheUsage > evictionTarget) {
       LOG(
           ("CacheFileIOManager::OverLimitEvictionInternal() - Cache size over "
-           "limit. [cacheSize=%ukB, limit=%ukB]",
-           cacheUsage, cacheLimit));
+           "limit. [cacheSize=%ukB, limit=%ukB, target=%ukB]",
+           cacheUsage, cacheLimit, evictionTarget));
 
       // We allow cache size to go over the specified limit. Eviction should
       // keep the size within the limit in a long run, but in case the eviction
@@ -2801,7 +2837,8 @@ nsresult CacheFileIOManager::OverLimitEvictionInternal() {
       // set flag mCacheSizeOnHardLimit when the size reaches 105% of the limit
       // and WriteInternal() and TruncateSeekSetEOFInternal() fail to cache
       // additional data.
-      if ((cacheUsage - cacheLimit) > (cacheLimit / 20)) {
+      if (cacheUsage > cacheLimit &&
+          (cacheUsage - cacheLimit) > (cacheLimit / 20)) {
         LOG(
             ("CacheFileIOManager::OverLimitEvictionInternal() - Cache size "
              "reached hard limit."));
@@ -4207,6 +4244,18 @@ size_t CacheFileIOManager::SizeOfExcludingThisInternal(
   return n;
 }
 
+// static
+uint64_t CacheFileIOManager::BytesWritten(EWriteKind aKind) {
+  MOZ_ASSERT(aKind < WRITE_KIND_COUNT);
+
+  RefPtr<CacheFileIOManager> ioMan = gInstance;
+  if (!ioMan) {
+    return 0;
+  }
+
+  return ioMan->mBytesWritten[aKind];
+}
+
 // static
 size_t CacheFileIOManager::SizeOfExcludingThis(
     mozilla::MallocSizeOf mallocSizeOf) {
@@ -345,6 +345,19 @@ class CacheFileIOManager final : public nsITimerCallback, public nsINamed {
       const SHA1Sum::Hash* aHash,
       CacheStorageService::EntryInfoCallback* aCallback);
 
+  // Bytes written to the cache files since startup, counted by what they
+  // were written for. WRITE_DATA_REWRITTEN is the part of WRITE_DATA that
+  // overwrote something already in the file, e.g. a partial chunk written
+  // again once more data arrived. Callable on any thread.
+  enum EWriteKind {
+    WRITE_DATA,
+    WRITE_DATA_REWRITTEN,
+    WRITE_METADATA,
+    WRITE_INDEX,
+    WRITE_KIND_COUNT
+  };
+  static uint64_t BytesWritten(EWriteKind aKind);
+
   // Memory reporting
   static size_t SizeOfExcludingThis(mozilla::MallocSizeOf mallocSizeOf);
   static size_t SizeOfIncludingThis(mozilla::MallocSizeOf mallocSizeOf);
@@ -471,6 +484,8 @@ class CacheFileIOManager final : public nsITimerCallback, public nsINamed {
   nsTArray<nsCString> mFailedTrashDirs;
   RefPtr<CacheFileContextEvictor> mContextEvictor;
   TimeStamp mLastSmartSizeTime;
+  // Updated on the IO thread only, see BytesWritten().
+  Atomic<uint64_t, Relaxed> mBytesWritten[WRITE_KIND_COUNT];
 };
 
 }  // namespace net
@@ -23,8 +23,6 @@
 #include "mozilla/Telemetry.h"
 #include "mozilla/Unused.h"
 
-#define kMinUnwrittenChanges 300
-#define kMinDumpInterval 20000  // in milliseconds
 #define kMaxBufSize 16384
 #define kIndexVersion 0x0000000A
 #define kUpdateIndexStartDelay 50000  // in milliseconds
@@ -1179,6 +1177,35 @@ nsresult CacheIndex::HasEntry(
     const SHA1Sum::Hash& hash, EntryStatus* _retval,
     const std::function<void(const CacheIndexEntry*)>& aCB) {
   StaticMutexAutoLock lock(sLock);
+  return HasEntryLocked(hash, _retval, aCB);
+}
+
+// static
+nsresult CacheIndex::TryHasEntry(const nsACString& aKey,
+                                 EntryStatus* _retval) {
+  LOG(("CacheIndex::TryHasEntry() [key=%s]", PromiseFlatCString(aKey).get()));
+
+  SHA1Sum sum;
+  SHA1Sum::Hash hash;
+  sum.update(aKey.BeginReading(), aKey.Length());
+  sum.finish(hash);
+
+  if (!sLock.TryLock()) {
+    LOG(("CacheIndex::TryHasEntry() - index is busy"));
+    *_retval = DO_NOT_KNOW;
+    return NS_OK;
+  }
+
+  nsresult rv = HasEntryLocked(hash, _retval, nullptr);
+  sLock.Unlock();
+  return rv;
+}
+
+// static
+nsresult CacheIndex::HasEntryLocked(
+    const SHA1Sum::Hash& hash, EntryStatus* _retval,
+    const std::function<void(const CacheIndexEntry*)>& aCB) {
+  sLock.AssertCurrentThreadOwns();
 
   RefPtr<CacheIndex> index = gInstance;
 
@@ -1353,6 +1380,25 @@ nsresult CacheIndex::GetCacheSize(uint32_t* _retval) {
   return NS_OK;
 }
 
+// static
+nsresult CacheIndex::GetPinnedCacheSize(uint32_t* _retval) {
+  LOG(("CacheIndex::GetPinnedCacheSize()"));
+
+  StaticMutexAutoLock lock(sLock);
+
+  RefPtr<CacheIndex> index = gInstance;
+
+  if (!index) return NS_ERROR_NOT_INITIALIZED;
+
+  if (!index->IsIndexUsable()) {
+    return NS_ERROR_NOT_AVAILABLE;
+  }
+
+  *_retval = index->mIndexStats.PinnedSize();
+  LOG(("CacheIndex::GetPinnedCacheSize() - returning %u", *_retval));
+  return NS_OK;
+}
+
 // static
 nsresult CacheIndex::GetEntryFileCount(uint32_t* _retval) {
   LOG(("CacheIndex::GetEntryFileCount()"));
@@ -1656,11 +1702,11 @@ bool CacheIndex::WriteIndexToDiskIfNeeded() {
 
   if (!mLastDumpTime.IsNull() &&
       (TimeStamp::NowLoRes() - mLastDumpTime).ToMilliseconds() <
-          kMinDumpInterval) {
+          CacheObserver::IndexMinDumpInterval()) {
     return false;
   }
 
-  if (mIndexStats.Dirty() < kMinUnwrittenChanges) {
+  if (mIndexStats.Dirty() < CacheObserver::IndexMinUnwrittenChanges()) {
     return false;
   }
 
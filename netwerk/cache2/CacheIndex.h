@@ -502,7 +502,8 @@ class CacheIndexStats {
         mDirty(0),
         mFresh(0),
         mEmpty(0),
-        mSize(0)
+        mSize(0),
+        mPinnedSize(0)
 #ifdef DEBUG
         ,
         mStateLogged(false),
@@ -530,7 +531,7 @@ class CacheIndexStats {
         aOther.mCount == mCount && aOther.mNotInitialized == mNotInitialized &&
         aOther.mRemoved == mRemoved && aOther.mDirty == mDirty &&
         aOther.mFresh == mFresh && aOther.mEmpty == mEmpty &&
-        aOther.mSize == mSize;
+        aOther.mSize == mSize && aOther.mPinnedSize == mPinnedSize;
   }
 
 #ifdef DEBUG
@@ -540,8 +541,9 @@ class CacheIndexStats {
   void Log() {
     LOG(
         ("CacheIndexStats::Log() [count=%u, notInitialized=%u, removed=%u, "
-         "dirty=%u, fresh=%u, empty=%u, size=%u]",
-         mCount, mNotInitialized, mRemoved, mDirty, mFresh, mEmpty, mSize));
+         "dirty=%u, fresh=%u, empty=%u, size=%u, pinnedSize=%u]",
+         mCount, mNotInitialized, mRemoved, mDirty, mFresh, mEmpty, mSize,
+         mPinnedSize));
   }
 
   void Clear() {
@@ -554,6 +556,7 @@ class CacheIndexStats {
     mFresh = 0;
     mEmpty = 0;
     mSize = 0;
+    mPinnedSize = 0;
     for (uint32_t i = 0; i < nsICacheEntry::CONTENT_TYPE_LAST; ++i) {
       mCountByType[i] = 0;
       mSizeByType[i] = 0;
@@ -597,6 +600,11 @@ class CacheIndexStats {
     return mSize;
   }
 
+  uint32_t PinnedSize() {
+    MOZ_ASSERT(!mStateLogged, "CacheIndexStats::PinnedSize() - state logged!");
+    return mPinnedSize;
+  }
+
   uint32_t SizeByType(uint8_t aContentType) {
     MOZ_ASSERT(!mStateLogged, "CacheIndexStats::SizeByType() - state logged!");
     MOZ_RELEASE_ASSERT(aContentType < nsICacheEntry::CONTENT_TYPE_LAST);
@@ -645,6 +653,10 @@ class CacheIndexStats {
             MOZ_ASSERT(mSize >= aEntry->GetFileSize());
             mSize -= aEntry->GetFileSize();
             mSizeByType[contentType] -= aEntry->GetFileSize();
+            if (aEntry->IsPinned()) {
+              MOZ_ASSERT(mPinnedSize >= aEntry->GetFileSize());
+              mPinnedSize -= aEntry->GetFileSize();
+            }
           }
         }
       }
@@ -679,6 +691,9 @@ class CacheIndexStats {
           } else {
             mSize += aEntry->GetFileSize();
             mSizeByType[contentType] += aEntry->GetFileSize();
+            if (aEntry->IsPinned()) {
+              mPinnedSize += aEntry->GetFileSize();
+            }
           }
         }
       }
@@ -702,6 +717,8 @@ class CacheIndexStats {
   uint32_t mEmpty;
   uint32_t mSize;
   uint32_t mSizeByType[nsICacheEntry::CONTENT_TYPE_LAST];
+  // The part of mSize taken by pinned entries.
+  uint32_t mPinnedSize;
 #ifdef DEBUG
   // We completely remove the data about an entry from the stats in
   // BeforeChange() and set this flag to true. The entry is then modified,
@@ -778,6 +795,12 @@ class CacheIndex final : public CacheFileIOListener, public nsIRunnable {
       const SHA1Sum::Hash& hash, EntryStatus* _retval,
       const std::function<void(const CacheIndexEntry*)>& aCB = nullptr);
 
+  // Like HasEntry(), but doesn't wait for the index lock. If the lock is held,
+  // e.g. by the IO thread while it reads, writes or updates the index, this
+  // returns DO_NOT_KNOW right away. For callers on the main thread that would
+  // rather not block on the index and can do without its answer.
+  static nsresult TryHasEntry(const nsACString& aKey, EntryStatus* _retval);
+
   // Returns a hash of the least important entry that should be evicted if the
   // cache size is over limit and also returns a total number of all entries in
   // the index minus the number of forced valid entries and unpinned entries
@@ -793,6 +816,9 @@ class CacheIndex final : public CacheFileIOListener, public nsIRunnable {
   // Returns cache size in kB.
   static nsresult GetCacheSize(uint32_t* _retval);
 
+  // Returns the size of pinned entries in kB.
+  static nsresult GetPinnedCacheSize(uint32_t* _retval);
+
   // Returns number of entry files in the cache
   static nsresult GetEntryFileCount(uint32_t* _retval);
 
@@ -860,6 +886,11 @@ class CacheIndex final : public CacheFileIOListener, public nsIRunnable {
   // originAttributes and isAnonymous. We don't expect to find a collision
   // since these values are part of the key that we hash and we use a strong
   // hash function.
+  // HasEntry() with sLock held.
+  static nsresult HasEntryLocked(
+      const SHA1Sum::Hash& aHash, EntryStatus* _retval,
+      const std::function<void(const CacheIndexEntry*)>& aCB);
+
   static bool IsCollision(CacheIndexEntry* aEntry,
                           OriginAttrsHash aOriginAttrsHash, bool aAnonymous);
 
@@ -8,6 +8,7 @@
 #include "CacheFileIOManager.h"
 #include "LoadContextInfo.h"
 #include "nsICacheStorage.h"
+#include "nsIDiskSpaceWatcher.h"
 #include "nsIObserverService.h"
 #include "mozilla/Services.h"
 #include "mozilla/Preferences.h"
@@ -32,6 +33,9 @@ float CacheObserver::sHalfLifeHours = kDefaultHalfLifeHours;
 // GetDiskSpaceAvailable() always fails.
 Atomic<uint32_t, Relaxed> CacheObserver::sSmartDiskCacheCapacity(1024 * 1024);
 
+Atomic<uint32_t, Relaxed> CacheObserver::sDiskSpaceLevel(
+    nsIDiskSpaceWatcher::LEVEL_NORMAL);
+
 Atomic<PRIntervalTime> CacheObserver::sShutdownDemandedTime(
     PR_INTERVAL_NO_TIMEOUT);
 
@@ -61,6 +65,7 @@ nsresult CacheObserver::Init() {
   obs->AddObserver(sSelf, "xpcom-shutdown", true);
   obs->AddObserver(sSelf, "last-pb-context-exited", true);
   obs->AddObserver(sSelf, "memory-pressure", true);
+  obs->AddObserver(sSelf, DISKSPACEWATCHER_LEVEL_OBSERVER_TOPIC, true);
 
   return NS_OK;
 }
@@ -135,8 +140,10 @@ void CacheObserver::SetSmartDiskCacheCapacity(uint32_t aCapacity) {
 
 // static
 uint32_t CacheObserver::DiskCacheCapacity() {
-  return SmartCacheSizeEnabled() ? sSmartDiskCacheCapacity
-                                 : StaticPrefs::browser_cache_disk_capacity();
+  uint32_t capacity = SmartCacheSizeEnabled()
+                          ? sSmartDiskCacheCapacity
+                          : StaticPrefs::browser_cache_disk_capacity();
+  return capacity >> sDiskSpaceLevel;
 }
 
 // static
@@ -249,6 +256,24 @@ CacheObserver::Observe(nsISupports* aSubject, const char* aTopic,
     return NS_OK;
   }
 
+  if (!strcmp(aTopic, DISKSPACEWATCHER_LEVEL_OBSERVER_TOPIC)) {
+    nsCOMPtr<nsIDiskSpaceWatcher> watcher = do_QueryInterface(aSubject);
+    uint16_t level;
+    if (!watcher || NS_FAILED(watcher->GetLevel(&level))) {
+      return NS_OK;
+    }
+
+    // Shrink the cache before the device runs out of space rather than
+    // waiting for writes to fail.
+    bool shrinking = level > sDiskSpaceLevel;
+    sDiskSpaceLevel = level;
+    if (shrinking) {
+      CacheFileIOManager::EvictIfOverLimit();
+    }
+
+    return NS_OK;
+  }
+
   MOZ_ASSERT(false, "Missing observer handler");
   return NS_OK;
 }
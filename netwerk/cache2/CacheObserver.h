@@ -41,6 +41,10 @@ class CacheObserver : public nsIObserver, public nsSupportsWeakReference {
   static uint32_t MemoryCacheCapacity();            // result in kilobytes.
   static uint32_t DiskCacheCapacity();              // result in kilobytes.
   static void SetSmartDiskCacheCapacity(uint32_t);  // parameter in kilobytes.
+  static uint32_t PinnedCacheCapacity()  // result in kilobytes.
+  {
+    return StaticPrefs::browser_cache_disk_pinned_capacity();
+  }
   static uint32_t DiskFreeSpaceSoftLimit()          // result in kilobytes.
   {
     return StaticPrefs::browser_cache_disk_free_space_soft_limit();
@@ -49,6 +53,17 @@ class CacheObserver : public nsIObserver, public nsSupportsWeakReference {
   {
     return StaticPrefs::browser_cache_disk_free_space_hard_limit();
   }
+  static uint32_t EvictionBatchSize()  // result in kilobytes.
+  {
+    return StaticPrefs::browser_cache_disk_eviction_batch_size();
+  }
+  static uint32_t IndexMinDumpInterval()  // result in milliseconds.
+  {
+    return StaticPrefs::browser_cache_disk_index_min_dump_interval();
+  }
+  static uint32_t IndexMinUnwrittenChanges() {
+    return StaticPrefs::browser_cache_disk_index_min_unwritten_changes();
+  }
   static bool SmartCacheSizeEnabled() {
     return StaticPrefs::browser_cache_disk_smart_size_enabled();
   }
@@ -96,6 +111,9 @@ class CacheObserver : public nsIObserver, public nsSupportsWeakReference {
 
   static int32_t sAutoMemoryCacheCapacity;
   static Atomic<uint32_t, Relaxed> sSmartDiskCacheCapacity;
+  // One of nsIDiskSpaceWatcher::LEVEL_*, the disk cache capacity is halved
+  // for each level above normal.
+  static Atomic<uint32_t, Relaxed> sDiskSpaceLevel;
   static float sHalfLifeHours;
   static Atomic<PRIntervalTime> sShutdownDemandedTime;
 
@@ -2212,6 +2212,29 @@ CacheStorageService::CollectReports(nsIHandleReportCallback* aHandleReport,
                      CacheIndex::SizeOfIncludingThis(MallocSizeOf),
                      "Memory used by the cache index.");
 
+  MOZ_COLLECT_REPORT(
+      "network-cache-written/data", KIND_OTHER, UNITS_BYTES,
+      CacheFileIOManager::BytesWritten(CacheFileIOManager::WRITE_DATA),
+      "Entry data written to the disk cache since startup.");
+
+  MOZ_COLLECT_REPORT(
+      "network-cache-written/data-rewritten", KIND_OTHER, UNITS_BYTES,
+      CacheFileIOManager::BytesWritten(
+          CacheFileIOManager::WRITE_DATA_REWRITTEN),
+      "Entry data written to the disk cache since startup over data that was "
+      "already on disk, as when a partial chunk is written again. Also "
+      "included in network-cache-written/data.");
+
+  MOZ_COLLECT_REPORT(
+      "network-cache-written/metadata", KIND_OTHER, UNITS_BYTES,
+      CacheFileIOManager::BytesWritten(CacheFileIOManager::WRITE_METADATA),
+      "Entry metadata written to the disk cache since startup.");
+
+  MOZ_COLLECT_REPORT(
+      "network-cache-written/index", KIND_OTHER, UNITS_BYTES,
+      CacheFileIOManager::BytesWritten(CacheFileIOManager::WRITE_INDEX),
+      "Cache index data written to disk since startup.");
+
   MutexAutoLock lock(mLock);
 
   // Report the service instance, this doesn't report entries, done lower
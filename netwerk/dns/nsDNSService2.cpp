@@ -5,6 +5,8 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "nsDNSService2.h"
+#include "nsAppDirectoryServiceDefs.h"
+#include "nsDirectoryServiceUtils.h"
 #include "nsIDNSRecord.h"
 #include "nsIDNSListener.h"
 #include "nsIDNSByTypeRecord.h"
@@ -32,6 +34,8 @@
 #include "nsQueryObject.h"
 #include "nsIObserverService.h"
 #include "nsINetworkLinkService.h"
+#include "nsISafeOutputStream.h"
+#include "nsNetUtil.h"
 #include "DNSResolverInfo.h"
 #include "TRRService.h"
 
@@ -45,7 +49,9 @@
 #include "mozilla/StaticPtr.h"
 #include "mozilla/SyncRunnable.h"
 #include "mozilla/TextUtils.h"
+#include "mozilla/Unused.h"
 #include "mozilla/Utf8.h"
+#include <algorithm>
 
 using namespace mozilla;
 using namespace mozilla::net;
@@ -64,6 +70,8 @@ static const char kPrefDnsOfflineLocalhost[] = "network.dns.offline-localhost";
 static const char kPrefDnsNotifyResolution[] = "network.dns.notifyResolution";
 static const char kPrefNetworkProxySOCKS[] = "network.proxy.socks";
 
+static const char kHotHostsFileName[] = "dnshosts.txt";
+
 //-----------------------------------------------------------------------------
 
 class nsDNSRecord : public nsIDNSAddrRecord {
@@ -603,6 +611,24 @@ class NotifyDNSResolution : public Runnable {
 
 //-----------------------------------------------------------------------------
 
+// For the lookups that only warm up the cache, see PrefetchHosts().
+class HotHostListener final : public nsIDNSListener {
+ public:
+  NS_DECL_THREADSAFE_ISUPPORTS
+
+  NS_IMETHOD OnLookupComplete(nsICancelable* aRequest, nsIDNSRecord* aRecord,
+                              nsresult aStatus) override {
+    return NS_OK;
+  }
+
+ private:
+  ~HotHostListener() = default;
+};
+
+NS_IMPL_ISUPPORTS(HotHostListener, nsIDNSListener)
+
+//-----------------------------------------------------------------------------
+
 NS_IMPL_ISUPPORTS(nsDNSService, nsIDNSService, nsPIDNSService, nsIObserver,
                   nsIMemoryReporter)
 
@@ -801,6 +827,10 @@ nsDNSService::Init() {
     observerService->AddObserver(this, NS_NETWORK_LINK_TOPIC, false);
     observerService->AddObserver(this, NS_XPCOM_SHUTDOWN_OBSERVER_ID, false);
     observerService->AddObserver(this, "odoh-service-activated", false);
+    if (XRE_IsParentProcess()) {
+      observerService->AddObserver(this, "profile-after-change", false);
+      observerService->AddObserver(this, "profile-before-change", false);
+    }
   }
 
   RefPtr<nsHostResolver> res;
@@ -843,6 +873,9 @@ nsDNSService::Init() {
   nsCOMPtr<nsIIDNService> idn = do_GetService(NS_IDNSERVICE_CONTRACTID);
   mIDN = idn;
 
+  // Without a profile yet, this is done on profile-after-change.
+  LoadHotHosts();
+
   return NS_OK;
 }
 
@@ -866,6 +899,10 @@ nsDNSService::Shutdown() {
     observerService->RemoveObserver(this, NS_NETWORK_LINK_TOPIC);
     observerService->RemoveObserver(this, "last-pb-context-exited");
     observerService->RemoveObserver(this, NS_XPCOM_SHUTDOWN_OBSERVER_ID);
+    if (XRE_IsParentProcess()) {
+      observerService->RemoveObserver(this, "profile-after-change");
+      observerService->RemoveObserver(this, "profile-before-change");
+    }
   }
 
   return NS_OK;
@@ -1011,6 +1048,11 @@ nsresult nsDNSService::AsyncResolveInternal(
     flags |= RESOLVE_OFFLINE;
   }
 
+  if (type == RESOLVE_TYPE_DEFAULT && !(flags & RESOLVE_SPECULATE) &&
+      !aOriginAttributes.mPrivateBrowsingId) {
+    CountHostHit(hostname);
+  }
+
   // make sure JS callers get notification on the main thread
   nsCOMPtr<nsIXPConnectWrappedJS> wrappedListener = do_QueryInterface(listener);
   if (wrappedListener && !target) {
@@ -1282,12 +1324,14 @@ NS_IMETHODIMP
 nsDNSService::Observe(nsISupports* subject, const char* topic,
                       const char16_t* data) {
   bool flushCache = false;
+  bool prefetchHotHosts = false;
   RefPtr<nsHostResolver> resolver = GetResolverLocked();
 
   if (!strcmp(topic, NS_NETWORK_LINK_TOPIC)) {
     nsAutoCString converted = NS_ConvertUTF16toUTF8(data);
     if (!strcmp(converted.get(), NS_NETWORK_LINK_DATA_CHANGED)) {
       flushCache = true;
+      prefetchHotHosts = true;
     }
   } else if (!strcmp(topic, "last-pb-context-exited")) {
     flushCache = true;
@@ -1302,16 +1346,188 @@ nsDNSService::Observe(nsISupports* subject, const char* topic,
     Shutdown();
   } else if (!strcmp(topic, "odoh-service-activated")) {
     mODoHActivated = u"true"_ns.Equals(data);
+  } else if (!strcmp(topic, "profile-after-change")) {
+    LoadHotHosts();
+  } else if (!strcmp(topic, "profile-before-change")) {
+    SaveHotHosts();
   }
 
   if (flushCache && resolver) {
     resolver->FlushCache(false);
+    if (prefetchHotHosts) {
+      // Get the hosts used the most back into the cache before they are
+      // needed, rather than paying the lookup on first use.
+      nsTArray<nsCString> hosts;
+      GetHotHosts(hosts);
+      PrefetchHosts(hosts);
+    }
     return NS_OK;
   }
 
   return NS_OK;
 }
 
+void nsDNSService::CountHostHit(const nsACString& aHost) {
+  uint32_t limit = StaticPrefs::network_dns_prefetch_hot_hosts();
+  if (!limit || !XRE_IsParentProcess() || HostIsIPLiteral(aHost)) {
+    return;
+  }
+
+  MutexAutoLock lock(mLock);
+  if (auto hits = mHostHits.Lookup(aHost)) {
+    ++*hits;
+    return;
+  }
+
+  // Keep a few times more hosts than we prefetch, so that a host needs more
+  // than a good start to make it. When full, make room by forgetting the
+  // hosts only used once.
+  if (mHostHits.Count() >= limit * 4) {
+    for (auto iter = mHostHits.Iter(); !iter.Done(); iter.Next()) {
+      if (iter.Data() == 1) {
+        iter.Remove();
+      }
+    }
+    if (mHostHits.Count() >= limit * 4) {
+      return;
+    }
+  }
+  mHostHits.InsertOrUpdate(aHost, 1);
+}
+
+void nsDNSService::GetHotHosts(nsTArray<nsCString>& aHosts) {
+  nsTArray<std::pair<uint32_t, nsCString>> hits;
+  {
+    MutexAutoLock lock(mLock);
+    for (const auto& entry : mHostHits) {
+      hits.AppendElement(std::make_pair(entry.GetData(), entry.GetKey()));
+    }
+  }
+
+  std::sort(hits.begin(), hits.end(), [](const auto& aA, const auto& aB) {
+    return aA.first > aB.first;
+  });
+
+  uint32_t count = std::min<uint32_t>(
+      hits.Length(), StaticPrefs::network_dns_prefetch_hot_hosts());
+  for (uint32_t i = 0; i < count; i++) {
+    aHosts.AppendElement(std::move(hits[i].second));
+  }
+}
+
+void nsDNSService::PrefetchHosts(const nsTArray<nsCString>& aHosts) {
+  if (aHosts.IsEmpty()) {
+    return;
+  }
+
+  RefPtr<HotHostListener> listener = new HotHostListener();
+  uint32_t count = std::min<uint32_t>(
+      aHosts.Length(), StaticPrefs::network_dns_prefetch_hot_hosts());
+  for (uint32_t i = 0; i < count; i++) {
+    nsCOMPtr<nsICancelable> request;
+    Unused << AsyncResolveInternal(
+        aHosts[i], RESOLVE_TYPE_DEFAULT,
+        RESOLVE_SPECULATE | RESOLVE_PRIORITY_LOW, nullptr, listener, nullptr,
+        OriginAttributes(), getter_AddRefs(request));
+  }
+}
+
+void nsDNSService::LoadHotHosts() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  if (mHotHostsLoaded || !XRE_IsParentProcess() ||
+      !StaticPrefs::network_dns_prefetch_hot_hosts()) {
+    return;
+  }
+
+  nsCOMPtr<nsIFile> file;
+  nsresult rv =
+      NS_GetSpecialDirectory(NS_APP_USER_PROFILE_50_DIR, getter_AddRefs(file));
+  if (NS_FAILED(rv)) {
+    return;
+  }
+  mHotHostsLoaded = true;
+
+  rv = file->AppendNative(nsLiteralCString(kHotHostsFileName));
+  if (NS_FAILED(rv)) {
+    return;
+  }
+
+  RefPtr<nsDNSService> self = this;
+  Unused << NS_DispatchBackgroundTask(
+      NS_NewRunnableFunction(
+          "nsDNSService::LoadHotHosts",
+          [self, file]() {
+            nsCOMPtr<nsIInputStream> stream;
+            nsAutoCString data;
+            if (NS_FAILED(NS_NewLocalFileInputStream(getter_AddRefs(stream),
+                                                     file)) ||
+                NS_FAILED(NS_ReadInputStreamToString(stream, data, -1))) {
+              return;
+            }
+
+            nsTArray<nsCString> hosts;
+            for (const auto& host :
+                 nsCCharSeparatedTokenizer(data, '\n').ToRange()) {
+              if (!host.IsEmpty()) {
+                hosts.AppendElement(host);
+              }
+            }
+
+            NS_DispatchToMainThread(NS_NewRunnableFunction(
+                "nsDNSService::PrefetchHosts",
+                [self, hosts = std::move(hosts)]() {
+                  self->PrefetchHosts(hosts);
+                }));
+          }),
+      NS_DISPATCH_EVENT_MAY_BLOCK);
+}
+
+void nsDNSService::SaveHotHosts() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  nsTArray<nsCString> hosts;
+  GetHotHosts(hosts);
+  if (hosts.IsEmpty()) {
+    // Keep what the last session saved rather than an empty list.
+    return;
+  }
+
+  nsCOMPtr<nsIFile> file;
+  nsresult rv =
+      NS_GetSpecialDirectory(NS_APP_USER_PROFILE_50_DIR, getter_AddRefs(file));
+  if (NS_FAILED(rv)) {
+    return;
+  }
+  rv = file->AppendNative(nsLiteralCString(kHotHostsFileName));
+  if (NS_FAILED(rv)) {
+    return;
+  }
+
+  nsAutoCString data;
+  for (const nsCString& host : hosts) {
+    data.Append(host);
+    data.Append('\n');
+  }
+
+  // The list is only a few hundred bytes, so this doesn't go off the main
+  // thread to make sure it is there before the profile goes away.
+  nsCOMPtr<nsIOutputStream> stream;
+  rv = NS_NewAtomicFileOutputStream(getter_AddRefs(stream), file);
+  if (NS_FAILED(rv)) {
+    return;
+  }
+  uint32_t written;
+  rv = stream->Write(data.get(), data.Length(), &written);
+  if (NS_FAILED(rv) || written != data.Length()) {
+    return;
+  }
+  nsCOMPtr<nsISafeOutputStream> safeStream = do_QueryInterface(stream);
+  if (safeStream) {
+    safeStream->Finish();
+  }
+}
+
 uint16_t nsDNSService::GetAFForLookup(const nsACString& host, uint32_t flags) {
   if (mDisableIPv6 || (flags & RESOLVE_DISABLE_IPV6)) {
     return PR_AF_INET;
@@ -14,6 +14,7 @@
 #include "nsIObserver.h"
 #include "nsHostResolver.h"
 #include "nsString.h"
+#include "nsTHashMap.h"
 #include "nsTHashSet.h"
 #include "nsHashKeys.h"
 #include "mozilla/Mutex.h"
@@ -77,14 +78,25 @@ class nsDNSService final : public nsPIDNSService,
 
   bool DNSForbiddenByActiveProxy(const nsACString& aHostname, uint32_t flags);
 
+  // The hosts resolved the most are kept in the profile and prefetched at
+  // startup, and again after a network change flushed the cache. Counting is
+  // done in the parent process, which resolves for every process, and only
+  // if network.dns.prefetch_hot_hosts is set.
+  void CountHostHit(const nsACString& aHost);
+  // The most used hosts first, at most network.dns.prefetch_hot_hosts.
+  void GetHotHosts(nsTArray<nsCString>& aHosts);
+  void PrefetchHosts(const nsTArray<nsCString>& aHosts);
+  void LoadHotHosts();
+  void SaveHotHosts();
+
   // Locks the mutex and returns an addreffed resolver. May return null.
   already_AddRefed<nsHostResolver> GetResolverLocked();
 
   RefPtr<nsHostResolver> mResolver;
   nsCOMPtr<nsIIDNService> mIDN;
 
-  // mLock protects access to mResolver, mLocalDomains, mIPv4OnlyDomains and
-  // mFailedSVCDomainNames
+  // mLock protects access to mResolver, mLocalDomains, mIPv4OnlyDomains,
+  // mFailedSVCDomainNames and mHostHits
   mozilla::Mutex mLock{"nsDNSServer.mLock"};
 
   // mIPv4OnlyDomains is a comma-separated list of domains for which only
@@ -108,6 +120,9 @@ class nsDNSService final : public nsPIDNSService,
   bool mResolverPrefsUpdated = false;
   bool mODoHActivated = false;
   nsClassHashtable<nsCStringHashKey, nsTArray<nsCString>> mFailedSVCDomainNames;
+  // Lookups per host this session, see CountHostHit().
+  nsTHashMap<nsCStringHashKey, uint32_t> mHostHits;
+  bool mHotHostsLoaded = false;
 };
 
 already_AddRefed<nsIDNSService> GetOrInitDNSService();
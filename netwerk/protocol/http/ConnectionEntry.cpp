@@ -15,6 +15,7 @@
 #include "ConnectionEntry.h"
 #include "nsQueryObject.h"
 #include "mozilla/ChaosMode.h"
+#include "mozilla/StaticPrefs_network.h"
 
 namespace mozilla {
 namespace net {
@@ -472,6 +473,14 @@ void ConnectionEntry::VerifyTraffic() {
         conn->CheckForTraffic(false);
       }
     }
+  } else if (StaticPrefs::network_http_http3_retire_on_network_change()) {
+    // A QUIC connection stays bound to the local address it was opened on,
+    // so after a change of network it can only time out. Let the streams in
+    // progress finish, but open a new connection, resumed with 0-RTT if
+    // possible, for the new transactions.
+    for (uint32_t index = 0; index < mActiveConns.Length(); ++index) {
+      mActiveConns[index]->DontReuse();
+    }
   }
 }
 
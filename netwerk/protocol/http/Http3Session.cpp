@@ -295,6 +295,10 @@ void Http3Session::ProcessInput(nsIUDPSocket* socket) {
   LOG(("Http3Session::ProcessInput writer=%p [this=%p state=%d]",
        mUdpConn.get(), this, mState));
 
+  // All the packets of a burst normally come from the same peer address, so
+  // only format it again when it changes.
+  NetAddr lastAddr{};
+  nsAutoCString remoteAddrStr;
   while (true) {
     nsTArray<uint8_t> data;
     NetAddr addr{};
@@ -304,8 +308,11 @@ void Http3Session::ProcessInput(nsIUDPSocket* socket) {
     if (NS_FAILED(rv) || data.IsEmpty()) {
       break;
     }
-    nsAutoCString remoteAddrStr;
-    AddrToString(addr, remoteAddrStr);
+    if (remoteAddrStr.IsEmpty() || !(addr == lastAddr)) {
+      lastAddr = addr;
+      remoteAddrStr.Truncate();
+      AddrToString(addr, remoteAddrStr);
+    }
     rv = mHttp3Connection->ProcessInput(&remoteAddrStr, data);
     MOZ_ALWAYS_SUCCEEDS(rv);
     if (NS_FAILED(rv)) {
@@ -18,6 +18,7 @@
 #include "NullHttpTransaction.h"
 #include "mozilla/Components.h"
 #include "mozilla/SpinEventLoopUntil.h"
+#include "mozilla/StaticPrefs_network.h"
 #include "mozilla/Telemetry.h"
 #include "mozilla/Unused.h"
 #include "mozilla/net/DNS.h"
@@ -298,6 +299,9 @@ nsHttpConnectionMgr::Observe(nsISupports* subject, const char* topic,
       ThrottlerTick();
     } else if (timer == mDelayedResumeReadTimer) {
       ResumeBackgroundThrottledTransactions();
+    } else if (timer == mRadioDeferTimer) {
+      mRadioDeferTimer = nullptr;
+      ReleaseRadioDeferredTransactions();
     } else {
       MOZ_ASSERT(false, "unexpected timer-callback");
       LOG(("Unexpected timer object\n"));
@@ -1978,6 +1982,15 @@ void nsHttpConnectionMgr::OnMsgShutdown(int32_t, ARefBase* param) {
   }
   DestroyThrottleTicker();
 
+  if (mRadioDeferTimer) {
+    mRadioDeferTimer->Cancel();
+    mRadioDeferTimer = nullptr;
+  }
+  for (const auto& trans : mRadioDeferredTransactions) {
+    trans->Close(NS_ERROR_ABORT);
+  }
+  mRadioDeferredTransactions.Clear();
+
   mCoalescingHash.Clear();
 
   // signal shutdown complete
@@ -2001,6 +2014,9 @@ void nsHttpConnectionMgr::OnMsgNewTransaction(int32_t priority,
 
   LOG(("nsHttpConnectionMgr::OnMsgNewTransaction [trans=%p]\n", trans));
   trans->SetPriority(priority);
+  if (MaybeDeferForRadio(trans)) {
+    return;
+  }
   nsresult rv = ProcessNewTransaction(trans);
   if (NS_FAILED(rv)) trans->Close(rv);  // for whatever its worth
 }
@@ -2104,6 +2120,7 @@ void nsHttpConnectionMgr::OnMsgCancelTransaction(int32_t reason,
            trans));
     }
 
+    mRadioDeferredTransactions.RemoveElement(trans);
     trans->Close(closeCode);
 
     // Cancel is a pretty strong signal that things might be hanging
@@ -2872,6 +2889,82 @@ bool nsHttpConnectionMgr::ShouldThrottle(nsHttpTransaction* aTrans) {
   return stop && inWindow;
 }
 
+// How long the radio stays in its high power state after the last traffic.
+// The RRC inactivity timers of UMTS and LTE networks are some seconds, this
+// errs on the short side.
+static const uint32_t kRadioTailTimeMs = 5000;
+
+bool nsHttpConnectionMgr::IsRadioActive() {
+  MOZ_ASSERT(OnSocketThread(), "not on socket thread");
+
+  if (mNumActiveConns) {
+    return true;
+  }
+  return !mLastRadioActivity.IsNull() &&
+         (TimeStamp::Now() - mLastRadioActivity).ToMilliseconds() <
+             kRadioTailTimeMs;
+}
+
+bool nsHttpConnectionMgr::MaybeDeferForRadio(nsHttpTransaction* aTrans) {
+  MOZ_ASSERT(OnSocketThread(), "not on socket thread");
+
+  uint32_t maxDelay = StaticPrefs::network_http_radio_batching_max_delay_ms();
+  if (!maxDelay || !gHttpHandler->IsCellularLink()) {
+    ReleaseRadioDeferredTransactions();
+    return false;
+  }
+
+  uint32_t cos = aTrans->ClassOfService();
+  bool background =
+      (cos & nsIClassOfService::Background) &&
+      !(cos & (nsIClassOfService::Leader | nsIClassOfService::Unblocked |
+               nsIClassOfService::UrgentStart));
+  bool radioActive = IsRadioActive();
+
+  if (background && !radioActive) {
+    LOG(("nsHttpConnectionMgr::MaybeDeferForRadio holding trans=%p", aTrans));
+    mRadioDeferredTransactions.AppendElement(aTrans);
+    if (!mRadioDeferTimer) {
+      NS_NewTimerWithObserver(getter_AddRefs(mRadioDeferTimer), this, maxDelay,
+                              nsITimer::TYPE_ONE_SHOT);
+    }
+    return true;
+  }
+
+  mLastRadioActivity = TimeStamp::Now();
+  if (!background) {
+    // A foreground transaction wakes the radio up anyway (or finds it awake),
+    // send what was held back along with it.
+    ReleaseRadioDeferredTransactions();
+  }
+  return false;
+}
+
+void nsHttpConnectionMgr::ReleaseRadioDeferredTransactions() {
+  MOZ_ASSERT(OnSocketThread(), "not on socket thread");
+
+  if (mRadioDeferTimer) {
+    mRadioDeferTimer->Cancel();
+    mRadioDeferTimer = nullptr;
+  }
+  if (mRadioDeferredTransactions.IsEmpty()) {
+    return;
+  }
+
+  LOG(("nsHttpConnectionMgr::ReleaseRadioDeferredTransactions %zu",
+       mRadioDeferredTransactions.Length()));
+  mLastRadioActivity = TimeStamp::Now();
+
+  nsTArray<RefPtr<nsHttpTransaction>> transactions =
+      std::move(mRadioDeferredTransactions);
+  for (const auto& trans : transactions) {
+    nsresult rv = ProcessNewTransaction(trans);
+    if (NS_FAILED(rv)) {
+      trans->Close(rv);
+    }
+  }
+}
+
 bool nsHttpConnectionMgr::IsConnEntryUnderPressure(
     nsHttpConnectionInfo* connInfo) {
   ConnectionEntry* ent = mCT.GetWeak(connInfo->HashKey());
@@ -447,6 +447,20 @@ class nsHttpConnectionMgr final : public HttpConnectionMgrShell,
   // Then, it notifies selected transactions' connection of the new active tab
   // id.
   void NotifyConnectionOfBrowsingContextIdChange(uint64_t previousId);
+
+  // On a cellular link, every request made while the radio is idle pays for
+  // waking it up, and keeps it in a high power state for some seconds after.
+  // Background transactions that would wake it are held here until a
+  // foreground transaction wakes it anyway, or at most
+  // network.http.radio_batching.max_delay_ms.
+  nsTArray<RefPtr<nsHttpTransaction>> mRadioDeferredTransactions;
+  nsCOMPtr<nsITimer> mRadioDeferTimer;
+  // When we last sent a transaction out while on a cellular link.
+  TimeStamp mLastRadioActivity;
+  // Returns true if aTrans was held back and must not be processed now.
+  bool MaybeDeferForRadio(nsHttpTransaction* aTrans);
+  bool IsRadioActive();
+  void ReleaseRadioDeferredTransactions();
 };
 
 }  // namespace net
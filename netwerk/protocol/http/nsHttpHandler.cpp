@@ -80,6 +80,10 @@
 #include "nsNSSComponent.h"
 #include "TRRServiceChannel.h"
 
+#ifdef MOZ_WIDGET_GONK
+#  include "nsINetworkInterface.h"
+#endif
+
 #include <bitset>
 
 #if defined(XP_UNIX)
@@ -509,6 +513,10 @@ nsresult nsHttpHandler::Init() {
     obsService->AddObserver(this, "browser-delayed-startup-finished", true);
     obsService->AddObserver(this, "network:captive-portal-connectivity", true);
     obsService->AddObserver(this, "network:reset-http3-excluded-list", true);
+#ifdef MOZ_WIDGET_GONK
+    // Sent by the NetworkManager with the type of the new default network.
+    obsService->AddObserver(this, "network-active-changed", true);
+#endif
 
     if (!IsNeckoChild()) {
       obsService->AddObserver(this, "net:current-top-browsing-context-id",
@@ -2254,6 +2262,14 @@ nsHttpHandler::Observe(nsISupports* subject, const char* topic,
     if (mAltSvcCache) {
       mAltSvcCache->ClearAltServiceMappings();
     }
+#ifdef MOZ_WIDGET_GONK
+  } else if (!strcmp(topic, "network-active-changed")) {
+    NS_ConvertUTF16toUTF8 type(data);
+    mCellularLink = !type.IsEmpty() &&
+                    atoi(type.get()) == nsINetworkInfo::NETWORK_TYPE_MOBILE;
+    LOG(("nsHttpHandler::Observe network-active-changed cellular=%d",
+         bool(mCellularLink)));
+#endif
   } else if (!strcmp(topic, NS_NETWORK_LINK_TOPIC)) {
     nsAutoCString converted = NS_ConvertUTF16toUTF8(data);
     if (!strcmp(converted.get(), NS_NETWORK_LINK_DATA_CHANGED)) {
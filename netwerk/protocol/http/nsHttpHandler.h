@@ -190,6 +190,8 @@ class nsHttpHandler final : public nsIHttpProtocolHandler,
   bool PromptTempRedirect() { return mPromptTempRedirect; }
   bool IsUrgentStartEnabled() { return mUrgentStartEnabled; }
   bool IsTailBlockingEnabled() { return mTailBlockingEnabled; }
+  // Whether the default network is a cellular one. Only known on Gonk.
+  bool IsCellularLink() const { return mCellularLink; }
   uint32_t TailBlockingDelayQuantum(bool aAfterDOMContentLoaded) {
     return aAfterDOMContentLoaded ? mTailDelayQuantumAfterDCL
                                   : mTailDelayQuantum;
@@ -589,6 +591,9 @@ class nsHttpHandler final : public nsIHttpProtocolHandler,
   uint8_t mMaxPersistentConnectionsPerServer;
   uint8_t mMaxPersistentConnectionsPerProxy;
 
+  // Set on the main thread, read on the socket thread.
+  Atomic<bool, Relaxed> mCellularLink{false};
+
   bool mThrottleEnabled;
   uint32_t mThrottleVersion;
   uint32_t mThrottleSuspendFor;
@@ -520,25 +520,39 @@ StaticMutex nsWSAdmissionManager::sLock;
 
 class CallOnMessageAvailable final : public Runnable {
  public:
+  typedef WebSocketChannel::IncomingMessage IncomingMessage;
+
   CallOnMessageAvailable(WebSocketChannel* aChannel, nsACString& aData,
                          int32_t aLen)
+      : Runnable("net::CallOnMessageAvailable"),
+        mChannel(aChannel),
+        mListenerMT(aChannel->mListenerMT) {
+    mMessages.AppendElement(IncomingMessage{nsCString(aData), aLen});
+  }
+
+  // Delivers several messages, in order, from a single event.
+  CallOnMessageAvailable(WebSocketChannel* aChannel,
+                         nsTArray<IncomingMessage>&& aMessages)
       : Runnable("net::CallOnMessageAvailable"),
         mChannel(aChannel),
         mListenerMT(aChannel->mListenerMT),
-        mData(aData),
-        mLen(aLen) {}
+        mMessages(std::move(aMessages)) {}
 
   NS_IMETHOD Run() override {
     MOZ_ASSERT(mChannel->IsOnTargetThread());
 
-    if (mListenerMT) {
+    if (!mListenerMT) {
+      return NS_OK;
+    }
+
+    for (IncomingMessage& message : mMessages) {
       nsresult rv;
-      if (mLen < 0) {
+      if (message.mLen < 0) {
         rv = mListenerMT->mListener->OnMessageAvailable(mListenerMT->mContext,
-                                                        mData);
+                                                        message.mData);
       } else {
         rv = mListenerMT->mListener->OnBinaryMessageAvailable(
-            mListenerMT->mContext, mData);
+            mListenerMT->mContext, message.mData);
       }
       if (NS_FAILED(rv)) {
         LOG(
@@ -556,8 +570,7 @@ class CallOnMessageAvailable final : public Runnable {
 
   RefPtr<WebSocketChannel> mChannel;
   RefPtr<BaseWebSocketChannel::ListenerAndContextContainer> mListenerMT;
-  nsCString mData;
-  int32_t mLen;
+  nsTArray<IncomingMessage> mMessages;
 };
 
 //-----------------------------------------------------------------------------
@@ -709,12 +722,17 @@ class CallOnTransportAvailable final : public Runnable {
 
 class PMCECompression {
  public:
-  PMCECompression(bool aNoContextTakeover, int32_t aLocalMaxWindowBits,
-                  int32_t aRemoteMaxWindowBits)
+  PMCECompression(bool aNoContextTakeover, bool aRemoteNoContextTakeover,
+                  int32_t aLocalMaxWindowBits, int32_t aRemoteMaxWindowBits)
       : mActive(false),
         mNoContextTakeover(aNoContextTakeover),
+        mRemoteNoContextTakeover(aRemoteNoContextTakeover),
         mResetDeflater(false),
-        mMessageDeflated(false) {
+        mMessageDeflated(false),
+        mDeflaterInitialized(false),
+        mInflaterInitialized(false),
+        mLocalMaxWindowBits(aLocalMaxWindowBits),
+        mRemoteMaxWindowBits(aRemoteMaxWindowBits) {
     this->mDeflater.next_in = nullptr;
     this->mDeflater.avail_in = 0;
     this->mDeflater.total_in = 0;
@@ -743,27 +761,42 @@ class PMCECompression {
     mDeflater.zfree = mInflater.zfree = Z_NULL;
     mDeflater.opaque = mInflater.opaque = Z_NULL;
 
-    if (deflateInit2(&mDeflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
-                     -aLocalMaxWindowBits, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
-      if (inflateInit2(&mInflater, -aRemoteMaxWindowBits) == Z_OK) {
-        mActive = true;
-      } else {
-        deflateEnd(&mDeflater);
-      }
-    }
+    mActive = InitDeflater() && InitInflater();
   }
 
   ~PMCECompression() {
     MOZ_COUNT_DTOR(PMCECompression);
 
-    if (mActive) {
+    if (mInflaterInitialized) {
       inflateEnd(&mInflater);
+    }
+    if (mDeflaterInitialized) {
       deflateEnd(&mDeflater);
     }
   }
 
   bool Active() { return mActive; }
 
+  // Whether ReleaseIdleState() can free anything, i.e. whether at least one
+  // direction doesn't carry its context over from one message to the next.
+  bool CanReleaseIdleState() {
+    return mNoContextTakeover || mRemoteNoContextTakeover;
+  }
+
+  // Frees the zlib state of the directions negotiated without context
+  // takeover. It is set up again by the next Deflate() or Inflate(). Must not
+  // be called in the middle of a fragmented message.
+  void ReleaseIdleState() {
+    if (mNoContextTakeover && mDeflaterInitialized) {
+      deflateEnd(&mDeflater);
+      mDeflaterInitialized = false;
+    }
+    if (mRemoteNoContextTakeover && mInflaterInitialized) {
+      inflateEnd(&mInflater);
+      mInflaterInitialized = false;
+    }
+  }
+
   void SetMessageDeflated() {
     MOZ_ASSERT(!mMessageDeflated);
     mMessageDeflated = true;
@@ -773,7 +806,12 @@ class PMCECompression {
   bool UsingContextTakeover() { return !mNoContextTakeover; }
 
   nsresult Deflate(uint8_t* data, uint32_t dataLen, nsACString& _retval) {
-    if (mResetDeflater || mNoContextTakeover) {
+    if (!mDeflaterInitialized) {
+      if (!InitDeflater()) {
+        return NS_ERROR_OUT_OF_MEMORY;
+      }
+      mResetDeflater = false;
+    } else if (mResetDeflater || mNoContextTakeover) {
       if (deflateReset(&mDeflater) != Z_OK) {
         return NS_ERROR_UNEXPECTED;
       }
@@ -826,6 +864,10 @@ class PMCECompression {
   nsresult Inflate(uint8_t* data, uint32_t dataLen, nsACString& _retval) {
     mMessageDeflated = false;
 
+    if (!mInflaterInitialized && !InitInflater()) {
+      return NS_ERROR_OUT_OF_MEMORY;
+    }
+
     Bytef trailingData[] = {0x00, 0x00, 0xFF, 0xFF};
     bool trailingDataUsed = false;
 
@@ -884,10 +926,32 @@ class PMCECompression {
   }
 
  private:
+  bool InitDeflater() {
+    // The hash table is scaled down along with the window, as zlib itself
+    // suggests: the default memLevel of 8 goes with the default 15 bits.
+    int memLevel = clamped(mLocalMaxWindowBits - 7, 1, 8);
+    mDeflaterInitialized =
+        deflateInit2(&mDeflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                     -mLocalMaxWindowBits, memLevel,
+                     Z_DEFAULT_STRATEGY) == Z_OK;
+    return mDeflaterInitialized;
+  }
+
+  bool InitInflater() {
+    mInflaterInitialized =
+        inflateInit2(&mInflater, -mRemoteMaxWindowBits) == Z_OK;
+    return mInflaterInitialized;
+  }
+
   bool mActive;
   bool mNoContextTakeover;
+  bool mRemoteNoContextTakeover;
   bool mResetDeflater;
   bool mMessageDeflated;
+  bool mDeflaterInitialized;
+  bool mInflaterInitialized;
+  int32_t mLocalMaxWindowBits;
+  int32_t mRemoteMaxWindowBits;
   z_stream mDeflater;
   z_stream mInflater;
   const static uint32_t kBufferLen = 4096;
@@ -1108,6 +1172,7 @@ WebSocketChannel::WebSocketChannel()
       mRecvdHttpUpgradeTransport(0),
       mAutoFollowRedirects(0),
       mAllowPMCE(1),
+      mPMCENoContextTakeover(0),
       mPingOutstanding(0),
       mReleaseOnTransmit(0),
       mDataStarted(false),
@@ -1134,6 +1199,9 @@ WebSocketChannel::WebSocketChannel()
       mHdrOut(nullptr),
       mDynamicOutputSize(0),
       mDynamicOutput(nullptr),
+      mPMCEMaxWindowBits(15),
+      mPMCEIdleTimeout(0),
+      mCoalesceMessages(true),
       mPrivateBrowsing(false),
       mConnectionLogService(nullptr),
       mMutex("WebSocketChannel::mMutex") {
@@ -1419,6 +1487,10 @@ nsresult WebSocketChannel::ProcessInput(uint8_t* buffer, uint32_t count) {
   // life, it does not necessarily have to be a pong.
   ResetPingTimer();
 
+  // Every message parsed out of this read reaches the target thread in a
+  // single event, see DeliverMessage().
+  auto flushMessages = MakeScopeExit([&] { FlushPendingMessages(); });
+
   uint32_t avail;
 
   if (!mBuffered) {
@@ -1626,6 +1698,7 @@ nsresult WebSocketChannel::ProcessInput(uint8_t* buffer, uint32_t count) {
 
         if (isDeflated) {
           rv = mPMCECompressor->Inflate(payload, payloadLength, utf8Data);
+          NotePMCEActivity();
           if (NS_FAILED(rv)) {
             return rv;
           }
@@ -1653,8 +1726,7 @@ nsresult WebSocketChannel::ProcessInput(uint8_t* buffer, uint32_t count) {
           mService->FrameReceived(mSerial, mInnerWindowID, frame.forget());
         }
 
-        mTargetThread->Dispatch(new CallOnMessageAvailable(this, utf8Data, -1),
-                                NS_DISPATCH_NORMAL);
+        DeliverMessage(utf8Data, -1);
         if (mConnectionLogService && !mPrivateBrowsing) {
           mConnectionLogService->NewMsgReceived(mHost, mSerial, count);
           LOG(("Added new msg received for %s", mHost.get()));
@@ -1712,6 +1784,7 @@ nsresult WebSocketChannel::ProcessInput(uint8_t* buffer, uint32_t count) {
           frame = nullptr;
         }
 
+        FlushPendingMessages();
         if (mListenerMT) {
           mTargetThread->Dispatch(
               new CallOnServerClose(this, mServerCloseCode, mServerCloseReason),
@@ -1758,6 +1831,7 @@ nsresult WebSocketChannel::ProcessInput(uint8_t* buffer, uint32_t count) {
 
         if (isDeflated) {
           rv = mPMCECompressor->Inflate(payload, payloadLength, binaryData);
+          NotePMCEActivity();
           if (NS_FAILED(rv)) {
             return rv;
           }
@@ -1779,9 +1853,7 @@ nsresult WebSocketChannel::ProcessInput(uint8_t* buffer, uint32_t count) {
           mService->FrameReceived(mSerial, mInnerWindowID, frame.forget());
         }
 
-        mTargetThread->Dispatch(
-            new CallOnMessageAvailable(this, binaryData, binaryData.Length()),
-            NS_DISPATCH_NORMAL);
+        DeliverMessage(binaryData, binaryData.Length());
         // To add the header to 'Networking Dashboard' log
         if (mConnectionLogService && !mPrivateBrowsing) {
           mConnectionLogService->NewMsgReceived(mHost, mSerial, count);
@@ -1882,6 +1954,49 @@ void WebSocketChannel::GeneratePing() {
                          new OutboundMessage(kMsgTypePing, buf));
 }
 
+void WebSocketChannel::DeliverMessage(nsACString& aData, int32_t aLen) {
+  MOZ_ASSERT(OnSocketThread(), "not on socket thread");
+
+  if (!mCoalesceMessages) {
+    mTargetThread->Dispatch(new CallOnMessageAvailable(this, aData, aLen),
+                            NS_DISPATCH_NORMAL);
+    return;
+  }
+
+  // A burst of small messages then wakes the target thread up only once.
+  mPendingMessages.AppendElement(IncomingMessage{nsCString(aData), aLen});
+}
+
+void WebSocketChannel::FlushPendingMessages() {
+  MOZ_ASSERT(OnSocketThread(), "not on socket thread");
+
+  if (mPendingMessages.IsEmpty()) {
+    return;
+  }
+
+  LOG(("WebSocketChannel::FlushPendingMessages() %p [%zu messages]\n", this,
+       mPendingMessages.Length()));
+  mTargetThread->Dispatch(
+      new CallOnMessageAvailable(this, std::move(mPendingMessages)),
+      NS_DISPATCH_NORMAL);
+  mPendingMessages.Clear();
+}
+
+void WebSocketChannel::NotePMCEActivity() {
+  MOZ_ASSERT(OnSocketThread(), "not on socket thread");
+
+  if (!mPMCEIdleTimeout || !mPMCECompressor ||
+      !mPMCECompressor->CanReleaseIdleState()) {
+    return;
+  }
+
+  mPMCELastActivity = TimeStamp::Now();
+  if (!mPMCEIdleTimer) {
+    NS_NewTimerWithCallback(getter_AddRefs(mPMCEIdleTimer), this,
+                            mPMCEIdleTimeout, nsITimer::TYPE_ONE_SHOT);
+  }
+}
+
 void WebSocketChannel::GeneratePong(uint8_t* payload, uint32_t len) {
   nsAutoCString buf;
   buf.SetLength(len);
@@ -2058,7 +2173,9 @@ void WebSocketChannel::PrimeNewOutgoingMessage() {
     // deflate the payload if PMCE is negotiated
     if (mPMCECompressor &&
         (msgType == kMsgTypeString || msgType == kMsgTypeBinaryString)) {
-      if (mCurrentOut->DeflatePayload(mPMCECompressor.get())) {
+      bool deflated = mCurrentOut->DeflatePayload(mPMCECompressor.get());
+      NotePMCEActivity();
+      if (deflated) {
         // The payload was deflated successfully, set RSV1 bit
         mOutHeader[0] |= kRsv1Bit;
 
@@ -2293,6 +2410,11 @@ void WebSocketChannel::DoStopSession(nsresult reason) {
     mPingTimer = nullptr;
   }
 
+  if (mPMCEIdleTimer) {
+    mPMCEIdleTimer->Cancel();
+    mPMCEIdleTimer = nullptr;
+  }
+
   if (mSocketIn && !mTCPClosed && mDataStarted) {
     // Drain, within reason, this socket. if we leave any data
     // unconsumed (including the tcp fin) a RST will be generated
@@ -2604,8 +2726,16 @@ nsresult WebSocketChannel::HandleExtensions() {
     serverMaxWindowBits = 15;
   }
 
+  // Whatever the server agreed to, our own compressor may always use a
+  // smaller window or drop its context between messages.
+  clientMaxWindowBits = std::min(clientMaxWindowBits, mPMCEMaxWindowBits);
+  if (mPMCENoContextTakeover) {
+    clientNoContextTakeover = true;
+  }
+
   mPMCECompressor = MakeUnique<PMCECompression>(
-      clientNoContextTakeover, clientMaxWindowBits, serverMaxWindowBits);
+      clientNoContextTakeover, serverNoContextTakeover, clientMaxWindowBits,
+      serverMaxWindowBits);
   if (mPMCECompressor->Active()) {
     LOG(
         ("WebSocketChannel::HandleExtensions: PMCE negotiated, %susing "
@@ -2736,8 +2866,24 @@ nsresult WebSocketChannel::SetupRequest() {
   }
 
   if (mAllowPMCE) {
+    nsAutoCString extensions;
+    if (mPMCEMaxWindowBits < 15 || mPMCENoContextTakeover) {
+      // Ask for a smaller window and/or no context takeover first, and fall
+      // back to a plain offer for servers that decline these parameters.
+      extensions.AssignLiteral("permessage-deflate");
+      if (mPMCEMaxWindowBits < 15) {
+        extensions.AppendPrintf("; server_max_window_bits=%d",
+                                mPMCEMaxWindowBits);
+      }
+      if (mPMCENoContextTakeover) {
+        extensions.AppendLiteral(
+            "; server_no_context_takeover; client_no_context_takeover");
+      }
+      extensions.AppendLiteral(", ");
+    }
+    extensions.AppendLiteral("permessage-deflate");
     rv = mHttpChannel->SetRequestHeader("Sec-WebSocket-Extensions"_ns,
-                                        "permessage-deflate"_ns, false);
+                                        extensions, false);
     MOZ_ASSERT(NS_SUCCEEDED(rv));
   }
 
@@ -3195,6 +3341,27 @@ WebSocketChannel::Notify(nsITimer* timer) {
       mPingTimer = nullptr;
       AbortSession(NS_ERROR_NET_TIMEOUT);
     }
+  } else if (timer == mPMCEIdleTimer) {
+    MOZ_ASSERT(OnSocketThread(), "not on socket thread");
+
+    mPMCEIdleTimer = nullptr;
+    if (!mPMCECompressor) {
+      return NS_OK;
+    }
+
+    // The timer isn't re-armed on every message; it checks when the
+    // compressor was last used and waits for the remainder if needed.
+    uint32_t idle = static_cast<uint32_t>(
+        (TimeStamp::Now() - mPMCELastActivity).ToMilliseconds());
+    if (idle < mPMCEIdleTimeout || mFragmentAccumulator) {
+      uint32_t delay =
+          idle < mPMCEIdleTimeout ? mPMCEIdleTimeout - idle : mPMCEIdleTimeout;
+      NS_NewTimerWithCallback(getter_AddRefs(mPMCEIdleTimer), this, delay,
+                              nsITimer::TYPE_ONE_SHOT);
+    } else {
+      LOG(("WebSocketChannel:: releasing idle PMCE state %p", this));
+      mPMCECompressor->ReleaseIdleState();
+    }
   } else if (timer == mLingeringCloseTimer) {
     LOG(("WebSocketChannel:: Lingering Close Timer"));
     CleanupConnection();
@@ -3294,6 +3461,30 @@ WebSocketChannel::AsyncOpen(nsIURI* aURI, const nsACString& aOrigin,
     if (NS_SUCCEEDED(rv)) {
       mAllowPMCE = boolpref ? 1 : 0;
     }
+    rv = prefService->GetIntPref(
+        "network.websocket.extensions.permessage-deflate.max-window-bits",
+        &intpref);
+    if (NS_SUCCEEDED(rv)) {
+      // zlib doesn't support raw deflate streams with an 8 bit window.
+      mPMCEMaxWindowBits = clamped(intpref, 9, 15);
+    }
+    rv = prefService->GetBoolPref(
+        "network.websocket.extensions.permessage-deflate.no-context-takeover",
+        &boolpref);
+    if (NS_SUCCEEDED(rv)) {
+      mPMCENoContextTakeover = boolpref ? 1 : 0;
+    }
+    rv = prefService->GetIntPref(
+        "network.websocket.extensions.permessage-deflate.idle-timeout",
+        &intpref);
+    if (NS_SUCCEEDED(rv)) {
+      mPMCEIdleTimeout = clamped(intpref, 0, 3600) * 1000;
+    }
+    rv = prefService->GetBoolPref("network.websocket.coalesce-messages",
+                                  &boolpref);
+    if (NS_SUCCEEDED(rv)) {
+      mCoalesceMessages = boolpref;
+    }
     rv = prefService->GetBoolPref(
         "network.websocket.auto-follow-http-redirects", &boolpref);
     if (NS_SUCCEEDED(rv)) {
@@ -3611,7 +3802,8 @@ WebSocketChannel::OnTransportAvailable(nsISocketTransport* aTransport,
       }
 
       mPMCECompressor = MakeUnique<PMCECompression>(
-          serverNoContextTakeover, serverMaxWindowBits, clientMaxWindowBits);
+          serverNoContextTakeover, clientNoContextTakeover, serverMaxWindowBits,
+          clientMaxWindowBits);
       if (mPMCECompressor->Active()) {
         LOG(
             ("WebSocketChannel::OnTransportAvailable: PMCE negotiated, %susing "
@@ -24,7 +24,9 @@
 #include "nsCOMPtr.h"
 #include "nsString.h"
 #include "nsDeque.h"
+#include "nsTArray.h"
 #include "mozilla/Atomics.h"
+#include "mozilla/TimeStamp.h"
 
 class nsIAsyncVerifyRedirectCallback;
 class nsIDashboardEventNotifier;
@@ -148,6 +150,17 @@ class WebSocketChannel : public BaseWebSocketChannel,
   void GeneratePong(uint8_t* payload, uint32_t len);
   void GeneratePing();
 
+  // Hands an incoming message to the listener on the target thread. Unless
+  // network.websocket.coalesce-messages is off, messages are held until
+  // FlushPendingMessages() is called at the end of ProcessInput().
+  // aLen is -1 for text messages.
+  void DeliverMessage(nsACString& aData, int32_t aLen);
+  void FlushPendingMessages();
+
+  // Called whenever mPMCECompressor is used, to release its state once the
+  // connection has been idle for mPMCEIdleTimeout.
+  void NotePMCEActivity();
+
   [[nodiscard]] nsresult OnNetworkChanged();
   [[nodiscard]] nsresult StartPinging();
 
@@ -241,6 +254,7 @@ class WebSocketChannel : public BaseWebSocketChannel,
   uint32_t mRecvdHttpUpgradeTransport : 1;
   uint32_t mAutoFollowRedirects : 1;
   uint32_t mAllowPMCE : 1;
+  uint32_t mPMCENoContextTakeover : 1;
   uint32_t : 0;
 
   // following members are accessed only on the socket thread
@@ -292,6 +306,19 @@ class WebSocketChannel : public BaseWebSocketChannel,
   uint8_t* mHdrOut;
   uint8_t mOutHeader[kCopyBreak + 16];
   UniquePtr<PMCECompression> mPMCECompressor;
+  int32_t mPMCEMaxWindowBits;
+  uint32_t mPMCEIdleTimeout; /* milliseconds */
+  nsCOMPtr<nsITimer> mPMCEIdleTimer;
+  TimeStamp mPMCELastActivity;
+
+  struct IncomingMessage {
+    nsCString mData;
+    int32_t mLen;
+  };
+  // Incoming messages not yet dispatched to the target thread, socket thread
+  // only.
+  nsTArray<IncomingMessage> mPendingMessages;
+  bool mCoalesceMessages;
   uint32_t mDynamicOutputSize;
   uint8_t* mDynamicOutput;
   bool mPrivateBrowsing;
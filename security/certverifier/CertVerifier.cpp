@@ -16,6 +16,7 @@
 #include "MultiLogCTVerifier.h"
 #include "NSSCertDBTrustDomain.h"
 #include "NSSErrorsService.h"
+#include "VerifiedChainCache.h"
 #include "cert.h"
 #include "mozilla/Assertions.h"
 #include "mozilla/Casting.h"
@@ -129,6 +130,28 @@ CertVerifier::CertVerifier(OcspDownloadConfig odc, OcspStrictConfig osc,
       }
     }
   }
+
+  Digest digest;
+  if (NS_SUCCEEDED(digest.Begin(SEC_OID_SHA256))) {
+    const uint32_t settings[] = {uint32_t(mOCSPDownloadConfig),
+                                 uint32_t(mOCSPStrict),
+                                 mCertShortLifetimeInDays,
+                                 uint32_t(mPinningMode),
+                                 uint32_t(mSHA1Mode),
+                                 uint32_t(mNameMatchingMode),
+                                 uint32_t(mNetscapeStepUpPolicy),
+                                 uint32_t(mCTMode),
+                                 uint32_t(mCRLiteMode)};
+    Unused << digest.Update(reinterpret_cast<const uint8_t*>(settings),
+                            sizeof(settings));
+    for (const auto& cert : mThirdPartyCerts) {
+      Input input;
+      if (cert.GetInput(input) == Success) {
+        Unused << digest.Update(input.UnsafeGetData(), input.GetLength());
+      }
+    }
+    Unused << digest.End(mTrustSettingsDigest);
+  }
 }
 
 CertVerifier::~CertVerifier() = default;
@@ -895,6 +918,61 @@ static bool CertIsSelfSigned(const UniqueCERTCertificate& cert, void* pinarg) {
   return rv == Success;
 }
 
+// Computes the VerifiedChainCache key of a TLS server certificate
+// verification, and the digest of the stapled OCSP response (all zeroes if
+// there is none). The key covers every input of VerifyCert that can change
+// its outcome other than the time, the stapled response and the
+// certificates the server sent along; any chain built from those remains
+// valid until the cache entry expires.
+static bool ComputeChainCacheKey(
+    const nsTArray<uint8_t>& trustSettingsDigest,
+    const UniqueCERTCertificate& peerCert, const nsACString& hostname,
+    CertVerifier::Flags flags, const OriginAttributes& originAttributes,
+    const Maybe<nsTArray<uint8_t>>& stapledOCSPResponse,
+    /*out*/ SHA256Buffer& key,
+    /*out*/ SHA256Buffer& stapledOCSPResponseDigest) {
+  if (trustSettingsDigest.IsEmpty()) {
+    return false;
+  }
+
+  nsAutoCString suffix;
+  originAttributes.CreateSuffix(suffix);
+
+  // Host names can't contain NUL, so it separates them from what follows.
+  static const uint8_t kSeparator = 0;
+
+  Digest digest;
+  nsTArray<uint8_t> out;
+  if (NS_FAILED(digest.Begin(SEC_OID_SHA256)) ||
+      NS_FAILED(digest.Update(trustSettingsDigest.Elements(),
+                              trustSettingsDigest.Length())) ||
+      NS_FAILED(digest.Update(peerCert->derCert.data, peerCert->derCert.len)) ||
+      NS_FAILED(digest.Update(
+          reinterpret_cast<const uint8_t*>(hostname.BeginReading()),
+          hostname.Length())) ||
+      NS_FAILED(digest.Update(&kSeparator, 1)) ||
+      NS_FAILED(digest.Update(reinterpret_cast<const uint8_t*>(&flags),
+                              sizeof(flags))) ||
+      NS_FAILED(digest.Update(
+          reinterpret_cast<const uint8_t*>(suffix.BeginReading()),
+          suffix.Length())) ||
+      NS_FAILED(digest.End(out)) || out.Length() != SHA256_LENGTH) {
+    return false;
+  }
+  memcpy(key, out.Elements(), SHA256_LENGTH);
+
+  memset(stapledOCSPResponseDigest, 0, SHA256_LENGTH);
+  if (stapledOCSPResponse) {
+    if (NS_FAILED(Digest::DigestBuf(SEC_OID_SHA256, *stapledOCSPResponse,
+                                    out)) ||
+        out.Length() != SHA256_LENGTH) {
+      return false;
+    }
+    memcpy(stapledOCSPResponseDigest, out.Elements(), SHA256_LENGTH);
+  }
+  return true;
+}
+
 Result CertVerifier::VerifySSLServerCert(
     const UniqueCERTCertificate& peerCert, Time time,
     /*optional*/ void* pinarg, const nsACString& hostname,
@@ -929,14 +1007,39 @@ Result CertVerifier::VerifySSLServerCert(
     return Result::ERROR_BAD_CERT_DOMAIN;
   }
 
+  // Results are only cached for callers that want the EV status, since a
+  // hit can't tell what it would have been otherwise, and only while CT
+  // verification is off, since a hit has no CT information to report.
+  SHA256Buffer chainCacheKey;
+  SHA256Buffer stapledOCSPResponseDigest;
+  bool useChainCache =
+      evStatus && mCTMode == CertificateTransparencyMode::Disabled &&
+      VerifiedChainCache::IsEnabled() &&
+      ComputeChainCacheKey(mTrustSettingsDigest, peerCert, hostname, flags,
+                           originAttributes, stapledOCSPResponse,
+                           chainCacheKey, stapledOCSPResponseDigest);
+
   // CreateCertErrorRunnable assumes that CheckCertHostname is only called
   // if VerifyCert succeeded.
-  Result rv = VerifyCert(peerCert.get(), certificateUsageSSLServer, time,
-                         pinarg, PromiseFlatCString(hostname).get(), builtChain,
-                         flags, extraCertificates, stapledOCSPResponse,
-                         sctsFromTLS, originAttributes, evStatus,
-                         ocspStaplingStatus, keySizeStatus, sha1ModeResult,
-                         pinningTelemetryInfo, ctInfo, crliteLookupResult);
+  Result rv;
+  if (useChainCache &&
+      VerifiedChainCache::Get(chainCacheKey, stapledOCSPResponseDigest, time,
+                              builtChain, *evStatus)) {
+    MOZ_LOG(gCertVerifierLog, LogLevel::Debug,
+            ("VerifySSLServerCert: chain cache hit"));
+    rv = Success;
+  } else {
+    rv = VerifyCert(peerCert.get(), certificateUsageSSLServer, time, pinarg,
+                    PromiseFlatCString(hostname).get(), builtChain, flags,
+                    extraCertificates, stapledOCSPResponse, sctsFromTLS,
+                    originAttributes, evStatus, ocspStaplingStatus,
+                    keySizeStatus, sha1ModeResult, pinningTelemetryInfo, ctInfo,
+                    crliteLookupResult);
+    if (rv == Success && useChainCache) {
+      VerifiedChainCache::Put(chainCacheKey, stapledOCSPResponseDigest,
+                              builtChain, *evStatus);
+    }
+  }
   if (rv != Success) {
     if (rv == Result::ERROR_UNKNOWN_ISSUER &&
         CertIsSelfSigned(peerCert, pinarg)) {
@@ -269,6 +269,10 @@ class CertVerifier {
   Vector<mozilla::pkix::Input> mThirdPartyRootInputs;
   // Similarly, but with intermediates.
   Vector<mozilla::pkix::Input> mThirdPartyIntermediateInputs;
+  // SHA-256 over everything above that decides whether a chain is trusted.
+  // Part of the key of VerifiedChainCache entries, so that a verifier with
+  // different settings never reuses another one's results.
+  nsTArray<uint8_t> mTrustSettingsDigest;
 
   // We only have a forward declarations of these classes (see above)
   // so we must allocate dynamically.
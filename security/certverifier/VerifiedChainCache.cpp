@@ -0,0 +1,409 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "VerifiedChainCache.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "cert.h"
+#include "mozilla/ArrayAlgorithm.h"
+#include "mozilla/Logging.h"
+#include "mozilla/StaticMutex.h"
+#include "mozilla/StaticPtr.h"
+#include "mozilla/UniquePtr.h"
+#include "mozilla/Unused.h"
+#include "nsIFile.h"
+#include "nsISafeOutputStream.h"
+#include "nsNetUtil.h"
+#include "nsString.h"
+#include "nsThreadUtils.h"
+#include "nss.h"
+
+extern mozilla::LazyLogModule gCertVerifierLog;
+
+using namespace mozilla::pkix;
+
+namespace mozilla {
+namespace psm {
+
+namespace {
+
+const size_t kMaxEntries = 256;
+const uint32_t kFileMagic = 0x56434348;  // "VCCH"
+const uint32_t kFileVersion = 1;
+
+struct Entry {
+  SHA256Buffer mKey;
+  SHA256Buffer mStapledOCSPResponseDigest;
+  uint64_t mExpiresAt;  // seconds since the epoch
+  EVStatus mEVStatus;
+  nsTArray<nsTArray<uint8_t>> mChain;  // end-entity first
+};
+
+StaticMutex sMutex;
+// Sorted with the most-recently-used entry at the end.
+StaticAutoPtr<nsTArray<UniquePtr<Entry>>> sEntries;
+StaticRefPtr<nsIFile> sFile;
+// NSS_VERSION and the build ID of the running build.
+StaticAutoPtr<nsCString> sFileTag;
+uint32_t sLifetimeSeconds = 0;
+
+template <typename T>
+void WriteValue(nsACString& aOut, const T& aValue) {
+  aOut.Append(reinterpret_cast<const char*>(&aValue), sizeof(T));
+}
+
+class Reader {
+ public:
+  explicit Reader(const nsACString& aData)
+      : mCur(aData.BeginReading()), mEnd(aData.EndReading()) {}
+
+  bool Read(void* aDest, size_t aLength) {
+    if (size_t(mEnd - mCur) < aLength) {
+      return false;
+    }
+    memcpy(aDest, mCur, aLength);
+    mCur += aLength;
+    return true;
+  }
+
+  template <typename T>
+  bool ReadValue(T& aValue) {
+    return Read(&aValue, sizeof(T));
+  }
+
+  bool ReadBytes(nsTArray<uint8_t>& aBytes) {
+    uint32_t length;
+    if (!ReadValue(length) || size_t(mEnd - mCur) < length) {
+      return false;
+    }
+    aBytes.AppendElements(reinterpret_cast<const uint8_t*>(mCur), length);
+    mCur += length;
+    return true;
+  }
+
+  bool AtEnd() const { return mCur == mEnd; }
+
+ private:
+  const char* mCur;
+  const char* mEnd;
+};
+
+// Returns the index of the entry with the given key, or -1.
+int32_t FindLocked(const SHA256Buffer& aKey) {
+  sMutex.AssertCurrentThreadOwns();
+  for (size_t i = 0; i < sEntries->Length(); ++i) {
+    if (memcmp((*sEntries)[i]->mKey, aKey, SHA256_LENGTH) == 0) {
+      return int32_t(i);
+    }
+  }
+  return -1;
+}
+
+void Serialize(nsACString& aOut) {
+  sMutex.AssertCurrentThreadOwns();
+  WriteValue(aOut, kFileMagic);
+  WriteValue(aOut, kFileVersion);
+  WriteValue<uint32_t>(aOut, sFileTag->Length());
+  aOut.Append(*sFileTag);
+
+  for (const auto& entry : *sEntries) {
+    aOut.Append(reinterpret_cast<const char*>(entry->mKey), SHA256_LENGTH);
+    aOut.Append(
+        reinterpret_cast<const char*>(entry->mStapledOCSPResponseDigest),
+        SHA256_LENGTH);
+    WriteValue(aOut, entry->mExpiresAt);
+    WriteValue(aOut, entry->mEVStatus);
+    WriteValue<uint32_t>(aOut, entry->mChain.Length());
+    for (const auto& cert : entry->mChain) {
+      WriteValue<uint32_t>(aOut, cert.Length());
+      aOut.Append(reinterpret_cast<const char*>(cert.Elements()),
+                  cert.Length());
+    }
+  }
+}
+
+void Deserialize(const nsACString& aData) {
+  sMutex.AssertCurrentThreadOwns();
+
+  Reader reader(aData);
+  uint32_t magic, version;
+  nsTArray<uint8_t> tagBytes;
+  if (!reader.ReadValue(magic) || magic != kFileMagic ||
+      !reader.ReadValue(version) || version != kFileVersion ||
+      !reader.ReadBytes(tagBytes)) {
+    return;
+  }
+  // The built-in roots ship with NSS and the static pins with the build, so
+  // any other NSS or build may trust differently.
+  if (!sFileTag->Equals(nsDependentCSubstring(
+          reinterpret_cast<const char*>(tagBytes.Elements()),
+          tagBytes.Length()))) {
+    return;
+  }
+
+  uint64_t now = uint64_t(PR_Now() / PR_USEC_PER_SEC);
+  nsTArray<UniquePtr<Entry>> loaded;
+  while (!reader.AtEnd()) {
+    auto entry = MakeUnique<Entry>();
+    uint32_t chainLength;
+    if (!reader.Read(entry->mKey, SHA256_LENGTH) ||
+        !reader.Read(entry->mStapledOCSPResponseDigest, SHA256_LENGTH) ||
+        !reader.ReadValue(entry->mExpiresAt) ||
+        !reader.ReadValue(entry->mEVStatus) ||
+        !reader.ReadValue(chainLength)) {
+      break;
+    }
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < chainLength; ++i) {
+      ok = reader.ReadBytes(*entry->mChain.AppendElement());
+    }
+    if (!ok) {
+      break;
+    }
+    if (entry->mExpiresAt <= now || entry->mChain.IsEmpty() ||
+        FindLocked(entry->mKey) >= 0) {
+      continue;
+    }
+    loaded.AppendElement(std::move(entry));
+  }
+
+  // Anything verified since startup counts as more recently used.
+  size_t room = kMaxEntries - std::min(kMaxEntries, sEntries->Length());
+  if (loaded.Length() > room) {
+    loaded.RemoveElementsAt(0, loaded.Length() - room);
+  }
+  for (size_t i = 0; i < loaded.Length(); ++i) {
+    sEntries->InsertElementAt(i, std::move(loaded[i]));
+  }
+
+  MOZ_LOG(gCertVerifierLog, LogLevel::Debug,
+          ("VerifiedChainCache: %zu entries after load", sEntries->Length()));
+}
+
+void RemoveFile(nsIFile* aFile) {
+  nsCOMPtr<nsIFile> file;
+  if (!aFile || NS_FAILED(aFile->Clone(getter_AddRefs(file)))) {
+    return;
+  }
+  NS_DispatchBackgroundTask(
+      NS_NewRunnableFunction("VerifiedChainCache::RemoveFile",
+                             [file]() { file->Remove(false); }),
+      NS_DISPATCH_EVENT_MAY_BLOCK);
+}
+
+}  // namespace
+
+// static
+void VerifiedChainCache::Init(uint32_t aLifetimeSeconds, nsIFile* aFile,
+                              const nsACString& aBuildID) {
+  StaticMutexAutoLock lock(sMutex);
+
+  if (aLifetimeSeconds == 0) {
+    // A cache left behind by an earlier session must not be picked up if
+    // the cache gets re-enabled later.
+    RemoveFile(aFile);
+    return;
+  }
+
+  sLifetimeSeconds = aLifetimeSeconds;
+  sEntries = new nsTArray<UniquePtr<Entry>>();
+  sFile = aFile;
+  sFileTag = new nsCString(NSS_VERSION);
+  sFileTag->Append(':');
+  sFileTag->Append(aBuildID);
+  if (!aFile) {
+    return;
+  }
+
+  nsCOMPtr<nsIFile> file;
+  if (NS_FAILED(aFile->Clone(getter_AddRefs(file)))) {
+    return;
+  }
+  NS_DispatchBackgroundTask(
+      NS_NewRunnableFunction(
+          "VerifiedChainCache::Load",
+          [file]() {
+            nsCOMPtr<nsIInputStream> stream;
+            if (NS_FAILED(NS_NewLocalFileInputStream(getter_AddRefs(stream),
+                                                     file))) {
+              return;
+            }
+            nsAutoCString data;
+            if (NS_FAILED(NS_ReadInputStreamToString(stream, data, -1))) {
+              return;
+            }
+            StaticMutexAutoLock lock(sMutex);
+            if (sEntries) {
+              Deserialize(data);
+            }
+          }),
+      NS_DISPATCH_EVENT_MAY_BLOCK);
+}
+
+// static
+void VerifiedChainCache::Shutdown() {
+  nsCOMPtr<nsIFile> file;
+  nsAutoCString data;
+  {
+    StaticMutexAutoLock lock(sMutex);
+    if (!sEntries) {
+      return;
+    }
+    if (sFile) {
+      file = sFile.get();
+      Serialize(data);
+    }
+    sEntries = nullptr;
+    sFile = nullptr;
+    sFileTag = nullptr;
+    sLifetimeSeconds = 0;
+  }
+
+  if (!file) {
+    return;
+  }
+
+  nsCOMPtr<nsIOutputStream> stream;
+  if (NS_FAILED(NS_NewSafeLocalFileOutputStream(getter_AddRefs(stream), file,
+                                                -1, 0600))) {
+    return;
+  }
+  const char* buf = data.BeginReading();
+  uint32_t remaining = data.Length();
+  while (remaining) {
+    uint32_t written = 0;
+    if (NS_FAILED(stream->Write(buf, remaining, &written))) {
+      return;
+    }
+    buf += written;
+    remaining -= written;
+  }
+  nsCOMPtr<nsISafeOutputStream> safeStream = do_QueryInterface(stream);
+  if (safeStream) {
+    safeStream->Finish();
+  }
+}
+
+// static
+bool VerifiedChainCache::IsEnabled() {
+  StaticMutexAutoLock lock(sMutex);
+  return !!sEntries;
+}
+
+// static
+bool VerifiedChainCache::Get(const SHA256Buffer& aKey,
+                             const SHA256Buffer& aStapledOCSPResponseDigest,
+                             Time aTime,
+                             /*out*/ UniqueCERTCertList& aBuiltChain,
+                             /*out*/ EVStatus& aEVStatus) {
+  nsTArray<nsTArray<uint8_t>> chain;
+  {
+    StaticMutexAutoLock lock(sMutex);
+    if (!sEntries) {
+      return false;
+    }
+    int32_t index = FindLocked(aKey);
+    if (index < 0) {
+      return false;
+    }
+    UniquePtr<Entry> entry = std::move((*sEntries)[index]);
+    sEntries->RemoveElementAt(index);
+    if (aTime >= TimeFromEpochInSeconds(entry->mExpiresAt)) {
+      return false;
+    }
+    if (memcmp(entry->mStapledOCSPResponseDigest, aStapledOCSPResponseDigest,
+               SHA256_LENGTH) != 0) {
+      // The server now staples something else. Verify it from scratch and
+      // let that result replace this entry.
+      return false;
+    }
+    aEVStatus = entry->mEVStatus;
+    chain = TransformIntoNewArray(
+        entry->mChain, [](const auto& cert) { return cert.Clone(); });
+    sEntries->AppendElement(std::move(entry));
+  }
+
+  UniqueCERTCertList builtChain(CERT_NewCertList());
+  if (!builtChain) {
+    return false;
+  }
+  CERTCertDBHandle* certDB(CERT_GetDefaultCertDB());  // non-owning
+  for (auto& der : chain) {
+    SECItem item = {siBuffer, der.Elements(),
+                    static_cast<unsigned int>(der.Length())};
+    UniqueCERTCertificate cert(
+        CERT_NewTempCertificate(certDB, &item, nullptr, false, true));
+    if (!cert || CERT_AddCertToListTail(builtChain.get(), cert.get()) !=
+                     SECSuccess) {
+      return false;
+    }
+    Unused << cert.release();  // cert is now owned by builtChain.
+  }
+
+  aBuiltChain = std::move(builtChain);
+  return true;
+}
+
+// static
+void VerifiedChainCache::Put(const SHA256Buffer& aKey,
+                             const SHA256Buffer& aStapledOCSPResponseDigest,
+                             const UniqueCERTCertList& aBuiltChain,
+                             EVStatus aEVStatus) {
+  if (!aBuiltChain || CERT_LIST_EMPTY(aBuiltChain)) {
+    return;
+  }
+
+  auto entry = MakeUnique<Entry>();
+  memcpy(entry->mKey, aKey, SHA256_LENGTH);
+  memcpy(entry->mStapledOCSPResponseDigest, aStapledOCSPResponseDigest,
+         SHA256_LENGTH);
+  entry->mEVStatus = aEVStatus;
+
+  PRTime expiresAt = std::numeric_limits<PRTime>::max();
+  for (CERTCertListNode* node = CERT_LIST_HEAD(aBuiltChain);
+       !CERT_LIST_END(node, aBuiltChain); node = CERT_LIST_NEXT(node)) {
+    PRTime notBefore, notAfter;
+    if (CERT_GetCertTimes(node->cert, &notBefore, &notAfter) != SECSuccess) {
+      return;
+    }
+    expiresAt = std::min(expiresAt, notAfter);
+    entry->mChain.AppendElement()->AppendElements(node->cert->derCert.data,
+                                                  node->cert->derCert.len);
+  }
+
+  StaticMutexAutoLock lock(sMutex);
+  if (!sEntries) {
+    return;
+  }
+
+  uint64_t now = uint64_t(PR_Now() / PR_USEC_PER_SEC);
+  entry->mExpiresAt = std::min(now + sLifetimeSeconds,
+                               uint64_t(std::max<PRTime>(expiresAt, 0) /
+                                        PR_USEC_PER_SEC));
+
+  int32_t index = FindLocked(aKey);
+  if (index >= 0) {
+    sEntries->RemoveElementAt(index);
+  } else if (sEntries->Length() >= kMaxEntries) {
+    sEntries->RemoveElementAt(0);
+  }
+  sEntries->AppendElement(std::move(entry));
+}
+
+// static
+void VerifiedChainCache::Clear() {
+  StaticMutexAutoLock lock(sMutex);
+  if (!sEntries) {
+    return;
+  }
+  sEntries->Clear();
+  RemoveFile(sFile);
+}
+
+}  // namespace psm
+}  // namespace mozilla
@@ -0,0 +1,70 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef mozilla_psm_VerifiedChainCache_h
+#define mozilla_psm_VerifiedChainCache_h
+
+#include "CertVerifier.h"
+#include "ScopedNSSTypes.h"
+#include "hasht.h"
+#include "mozpkix/Time.h"
+#include "nsString.h"
+#include "nsTArray.h"
+
+class nsIFile;
+
+namespace mozilla {
+namespace psm {
+
+typedef uint8_t SHA256Buffer[SHA256_LENGTH];
+
+// VerifiedChainCache remembers the outcome of successful TLS server
+// certificate path building so that repeat connections can skip it. Each
+// entry is keyed on a digest of the end-entity certificate, the host name,
+// the verification flags, the origin attributes and the trust settings of
+// the CertVerifier that built the chain (see ComputeChainCacheKey in
+// CertVerifier.cpp).
+// An entry also records a digest of the stapled OCSP response it was
+// verified with, and is only used again with that same response.
+//
+// Entries expire after a configurable lifetime or when a certificate in the
+// chain does, whichever comes first. The cache can be saved to and restored
+// from a file in the profile so that it survives restarts; the file is only
+// honoured by the same NSS version and build (which carries the pinning
+// data) that wrote it. A maximum of 256 entries is kept.
+//
+// VerifiedChainCache is a process-wide singleton and is thread-safe.
+class VerifiedChainCache {
+ public:
+  // Enables the cache with the given entry lifetime. If aFile is given, it is
+  // read in the background and written back by Shutdown(). aBuildID tags the
+  // file so that another build ignores it.
+  static void Init(uint32_t aLifetimeSeconds, nsIFile* aFile,
+                   const nsACString& aBuildID);
+  static void Shutdown();
+
+  static bool IsEnabled();
+
+  // On a hit, returns true and rebuilds the cached chain into aBuiltChain.
+  static bool Get(const SHA256Buffer& aKey,
+                  const SHA256Buffer& aStapledOCSPResponseDigest,
+                  mozilla::pkix::Time aTime,
+                  /*out*/ UniqueCERTCertList& aBuiltChain,
+                  /*out*/ EVStatus& aEVStatus);
+
+  static void Put(const SHA256Buffer& aKey,
+                  const SHA256Buffer& aStapledOCSPResponseDigest,
+                  const UniqueCERTCertList& aBuiltChain, EVStatus aEVStatus);
+
+  // Forgets every entry, including the ones saved in the profile. Must be
+  // called whenever certificate trust may have been reduced.
+  static void Clear();
+};
+
+}  // namespace psm
+}  // namespace mozilla
+
+#endif  // mozilla_psm_VerifiedChainCache_h
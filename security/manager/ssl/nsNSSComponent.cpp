@@ -13,6 +13,7 @@
 #include "SSLTokensCache.h"
 #include "ScopedNSSTypes.h"
 #include "SharedSSLState.h"
+#include "VerifiedChainCache.h"
 #include "cert.h"
 #include "cert_storage/src/cert_storage.h"
 #include "certdb.h"
@@ -53,6 +54,7 @@
 #include "nsITimer.h"
 #include "nsITokenPasswordDialogs.h"
 #include "nsIWindowWatcher.h"
+#include "nsIXULAppInfo.h"
 #include "nsIXULRuntime.h"
 #include "nsLiteralString.h"
 #include "nsNSSCertificateDB.h"
@@ -1860,6 +1862,30 @@ static nsresult InitializeNSSWithFallbacks(const nsACString& profilePath,
   return srv == SECSuccess ? NS_OK : NS_ERROR_FAILURE;
 }
 
+// The lifetime pref is only read at startup. With a lifetime of 0 the cache
+// is off and any copy left in the profile is removed.
+static void InitializeVerifiedChainCache() {
+  uint32_t lifetime =
+      Preferences::GetUint("security.pki.verified_chain_cache.lifetime", 0);
+
+  nsCOMPtr<nsIFile> file;
+  if (NS_FAILED(NS_GetSpecialDirectory(NS_APP_USER_PROFILE_50_DIR,
+                                       getter_AddRefs(file))) ||
+      NS_FAILED(file->AppendNative("verified_chains.bin"_ns))) {
+    file = nullptr;
+  }
+
+  nsAutoCString buildID;
+  nsCOMPtr<nsIXULAppInfo> appInfo =
+      do_GetService("@mozilla.org/xre/app-info;1");
+  if (!appInfo || NS_FAILED(appInfo->GetPlatformBuildID(buildID))) {
+    // Without a build ID, a later build couldn't tell the file apart.
+    file = nullptr;
+  }
+
+  VerifiedChainCache::Init(lifetime, file, buildID);
+}
+
 nsresult nsNSSComponent::InitializeNSS() {
   MOZ_LOG(gPIPNSSLog, LogLevel::Debug, ("nsNSSComponent::InitializeNSS\n"));
   AUTO_PROFILER_LABEL("nsNSSComponent::InitializeNSS", OTHER);
@@ -1951,6 +1977,8 @@ nsresult nsNSSComponent::InitializeNSS() {
     // Set dynamic options from prefs.
     setValidationOptions(true, lock);
 
+    InitializeVerifiedChainCache();
+
     bool importEnterpriseRoots =
         Preferences::GetBool(kEnterpriseRootModePref, false);
     uint32_t familySafetyMode =
@@ -2007,6 +2035,8 @@ void nsNSSComponent::ShutdownNSS() {
 
   ::mozilla::psm::UnloadUserModules();
 
+  VerifiedChainCache::Shutdown();
+
   PK11_SetPasswordFunc((PK11PasswordFunc) nullptr);
 
   Preferences::RemoveObserver(this, "security.");
@@ -2487,6 +2517,7 @@ nsNSSComponent::GetDefaultCertVerifier(SharedCertVerifier** result) {
 void nsNSSComponent::DoClearSSLExternalAndInternalSessionCache() {
   SSL_ClearSessionCache();
   mozilla::net::SSLTokensCache::Clear();
+  VerifiedChainCache::Clear();
 }
 
 NS_IMETHODIMP
@@ -8,6 +8,7 @@
 #include "PLDHashTable.h"
 #include "mozilla/IOInterposer.h"
 #include "mozilla/AutoMemMap.h"
+#include "mozilla/BinarySearch.h"
 #include "mozilla/IOBuffers.h"
 #include "mozilla/MemoryReporting.h"
 #include "mozilla/MemUtils.h"
@@ -35,6 +36,9 @@
 #include "GeckoProfiler.h"
 #include "nsAppRunner.h"
 #include "xpcpublic.h"
+
+#include <algorithm>
+
 #ifdef MOZ_BACKGROUNDTASKS
 #  include "mozilla/BackgroundTasks.h"
 #endif
@@ -94,6 +98,10 @@ static uint8_t STARTUP_CACHE_WRITE_TIMEOUT = 60;
 
 #define STARTUP_CACHE_NAME "startupCache." SC_WORDSIZE "." SC_ENDIAN
 
+// Next to the cache file, the order in which the first session using it
+// requested its entries. See ThreadedPrefetch.
+#define STARTUP_CACHE_ORDER_SUFFIX ".order"
+
 static inline Result<Ok, nsresult> Write(PRFileDesc* fd, const void* data,
                                          int32_t len) {
   if (PR_Write(fd, data, len) != len) {
@@ -165,6 +173,8 @@ StartupCache::StartupCache()
       mCurTableReferenced(false),
       mRequestedCount(0),
       mCacheEntriesBaseOffset(0),
+      mFoundOrderLog(false),
+      mOrderLogWritten(false),
       mPrefetchThread(nullptr) {}
 
 StartupCache::~StartupCache() { UnregisterWeakMemoryReporter(this); }
@@ -211,6 +221,15 @@ nsresult StartupCache::Init() {
 
   NS_ENSURE_TRUE(mFile, NS_ERROR_UNEXPECTED);
 
+  nsAutoCString leafName;
+  rv = mFile->GetNativeLeafName(leafName);
+  NS_ENSURE_SUCCESS(rv, rv);
+  rv = mFile->Clone(getter_AddRefs(mOrderFile));
+  NS_ENSURE_SUCCESS(rv, rv);
+  leafName.AppendLiteral(STARTUP_CACHE_ORDER_SUFFIX);
+  rv = mOrderFile->SetNativeLeafName(leafName);
+  NS_ENSURE_SUCCESS(rv, rv);
+
   mObserverService = do_GetService("@mozilla.org/observer-service;1");
 
   if (!mObserverService) {
@@ -262,9 +281,6 @@ Result<Ok, nsresult> StartupCache::LoadArchive() {
 
   MOZ_TRY(mCacheData.init(mFile));
   auto size = mCacheData.size();
-  if (CanPrefetchMemory()) {
-    StartPrefetchMemoryThread();
-  }
 
   uint32_t headerSize;
   if (size < sizeof(MAGIC) + sizeof(headerSize)) {
@@ -298,8 +314,8 @@ Result<Ok, nsresult> StartupCache::LoadArchive() {
       return Err(NS_ERROR_UNEXPECTED);
     }
     auto cleanup = MakeScopeExit([&]() {
-      WaitOnPrefetchThread();
       mTable.clear();
+      mEntryRanges.Clear();
       mCacheData.reset();
     });
     loader::InputBuffer buf(header);
@@ -340,6 +356,7 @@ Result<Ok, nsresult> StartupCache::LoadArchive() {
               StartupCacheEntry(offset, compressedSize, uncompressedSize))) {
         return Err(NS_ERROR_UNEXPECTED);
       }
+      mEntryRanges.AppendElement(EntryRange{offset, compressedSize});
     }
 
     if (buf.error()) {
@@ -349,6 +366,13 @@ Result<Ok, nsresult> StartupCache::LoadArchive() {
     cleanup.release();
   }
 
+  // The prefetch thread needs the entry ranges, so it can only start once
+  // the header has been read.
+  if (CanPrefetchMemory()) {
+    mFoundOrderLog = false;
+    StartPrefetchMemoryThread();
+  }
+
   MMAP_FAULT_HANDLER_CATCH(Err(NS_ERROR_UNEXPECTED))
 
   return Ok();
@@ -491,6 +515,7 @@ size_t StartupCache::HeapSizeOfIncludingThis(
   size_t n = aMallocSizeOf(this);
 
   n += mTable.shallowSizeOfExcludingThis(aMallocSizeOf);
+  n += mEntryRanges.ShallowSizeOfExcludingThis(aMallocSizeOf);
   for (auto iter = mTable.iter(); !iter.done(); iter.next()) {
     if (iter.get().value().mData) {
       n += aMallocSizeOf(iter.get().value().mData.get());
@@ -607,6 +632,12 @@ Result<Ok, nsresult> StartupCache::WriteToDisk() {
   mDirty = false;
   mWrittenOnce = true;
 
+  // The new file is in the order its entries were requested in, so an order
+  // log for the old one would only get in the way.
+  if (mOrderFile) {
+    Unused << mOrderFile->Remove(false);
+  }
+
   return Ok();
 }
 
@@ -635,8 +666,13 @@ void StartupCache::InvalidateCache(bool memoryOnly) {
     mTable.clear();
   }
   mRequestedCount = 0;
+  mEntryRanges.Clear();
+  mOrderLogWritten = false;
   if (!memoryOnly) {
     mCacheData.reset();
+    if (mOrderFile) {
+      Unused << mOrderFile->Remove(false);
+    }
     nsresult rv = mFile->Remove(false);
     if (NS_FAILED(rv) && rv != NS_ERROR_FILE_TARGET_DOES_NOT_EXIST &&
         rv != NS_ERROR_FILE_NOT_FOUND) {
@@ -709,12 +745,142 @@ void StartupCache::ThreadedPrefetch(void* aClosure) {
   StartupCache* startupCacheObj = static_cast<StartupCache*>(aClosure);
   uint8_t* buf = startupCacheObj->mCacheData.get<uint8_t>().get();
   size_t size = startupCacheObj->mCacheData.size();
+
+  nsTArray<uint32_t> order;
+  startupCacheObj->mFoundOrderLog = startupCacheObj->ReadOrderLog(order);
+
   MMAP_FAULT_HANDLER_BEGIN_BUFFER(buf, size)
-  PrefetchMemory(buf, size);
+  if (startupCacheObj->mFoundOrderLog) {
+    // Only read ahead the header and the entries the last session asked for,
+    // in the order it asked for them. Runs of entries that follow each other
+    // in the file are read ahead together.
+    const nsTArray<EntryRange>& ranges = startupCacheObj->mEntryRanges;
+    uint8_t* entries = buf + startupCacheObj->mCacheEntriesBaseOffset;
+    PrefetchMemory(buf, startupCacheObj->mCacheEntriesBaseOffset);
+    for (size_t i = 0; i < order.Length();) {
+      uint32_t start = ranges[order[i]].mOffset;
+      uint32_t end = start + ranges[order[i]].mSize;
+      for (i++; i < order.Length() && ranges[order[i]].mOffset == end; i++) {
+        end += ranges[order[i]].mSize;
+      }
+      PrefetchMemory(entries + start, end - start);
+    }
+  } else {
+    PrefetchMemory(buf, size);
+  }
   MMAP_FAULT_HANDLER_CATCH()
   mozilla::IOInterposer::UnregisterCurrentThread();
 }
 
+/*
+ * The order log is a list of little endian uint32_t: the number of entries in
+ * the cache file and the total size of their data, followed by the indices
+ * of the entries in the file, in the order they were requested.
+ *
+ * Runs on the prefetch thread.
+ */
+bool StartupCache::ReadOrderLog(nsTArray<uint32_t>& aOrder) {
+  if (!mOrderFile) {
+    return false;
+  }
+
+  AutoFDClose fd;
+  if (NS_FAILED(mOrderFile->OpenNSPRFileDesc(PR_RDONLY, 0, &fd.rwget()))) {
+    return false;
+  }
+
+  PRFileInfo64 info;
+  if (PR_GetOpenFileInfo64(fd, &info) != PR_SUCCESS || info.size < 8 ||
+      info.size % 4 || info.size / 4 - 2 > mEntryRanges.Length()) {
+    return false;
+  }
+
+  nsTArray<uint8_t> data;
+  data.SetLength(info.size);
+  if (PR_Read(fd, data.Elements(), info.size) != info.size) {
+    return false;
+  }
+
+  size_t count = mEntryRanges.Length();
+  uint32_t dataSize =
+      count ? mEntryRanges[count - 1].mOffset + mEntryRanges[count - 1].mSize
+            : 0;
+  if (LittleEndian::readUint32(&data[0]) != count ||
+      LittleEndian::readUint32(&data[4]) != dataSize) {
+    return false;
+  }
+
+  for (size_t pos = 8; pos < data.Length(); pos += 4) {
+    uint32_t index = LittleEndian::readUint32(&data[pos]);
+    if (index >= count) {
+      return false;
+    }
+    aOrder.AppendElement(index);
+  }
+  return true;
+}
+
+/*
+ * Records the order in which this session requested the entries of the cache
+ * file, if it wasn't recorded already.
+ */
+void StartupCache::MaybeWriteOrderLog() {
+  WaitOnPrefetchThread();
+  if (mFoundOrderLog || mOrderLogWritten || !mOrderFile ||
+      !mCacheData.initialized() || !CanPrefetchMemory()) {
+    return;
+  }
+  mOrderLogWritten = true;
+
+  nsTArray<std::pair<int32_t, uint32_t>> requested;
+  for (auto iter = mTable.iter(); !iter.done(); iter.next()) {
+    const StartupCacheEntry& entry = iter.get().value();
+    if (!entry.mRequested || !entry.mCompressedSize) {
+      // Entries only put in this session aren't in the file.
+      continue;
+    }
+    size_t index;
+    if (BinarySearchIf(
+            mEntryRanges, 0, mEntryRanges.Length(),
+            [&](const EntryRange& aRange) {
+              return entry.mOffset < aRange.mOffset   ? -1
+                     : entry.mOffset > aRange.mOffset ? 1
+                                                      : 0;
+            },
+            &index)) {
+      requested.AppendElement(std::make_pair(entry.mRequestedOrder, index));
+    }
+  }
+  std::sort(requested.begin(), requested.end());
+
+  size_t count = mEntryRanges.Length();
+  uint32_t dataSize =
+      count ? mEntryRanges[count - 1].mOffset + mEntryRanges[count - 1].mSize
+            : 0;
+  nsTArray<uint8_t> data;
+  data.SetLength((requested.Length() + 2) * 4);
+  LittleEndian::writeUint32(&data[0], count);
+  LittleEndian::writeUint32(&data[4], dataSize);
+  for (size_t i = 0; i < requested.Length(); i++) {
+    LittleEndian::writeUint32(&data[(i + 2) * 4], requested[i].second);
+  }
+
+  nsCOMPtr<nsIFile> file = mOrderFile;
+  nsCOMPtr<nsIRunnable> runnable = NS_NewRunnableFunction(
+      "StartupCache::WriteOrderLog",
+      [file, data = std::move(data)]() mutable {
+        AutoFDClose fd;
+        nsresult rv = file->OpenNSPRFileDesc(
+            PR_WRONLY | PR_CREATE_FILE | PR_TRUNCATE, 0644, &fd.rwget());
+        if (NS_WARN_IF(NS_FAILED(rv))) {
+          return;
+        }
+        auto result = Write(fd, data.Elements(), data.Length());
+        Unused << NS_WARN_IF(result.isErr());
+      });
+  NS_DispatchBackgroundTask(runnable.forget(), NS_DISPATCH_EVENT_MAY_BLOCK);
+}
+
 bool StartupCache::ShouldCompactCache() {
   // If we've requested less than 4/5 of the startup cache, then we should
   // probably compact it down. This can happen quite easily after the first run,
@@ -749,6 +915,7 @@ void StartupCache::MaybeWriteOffMainThread() {
   }
 
   if (mCacheData.initialized() && !ShouldCompactCache()) {
+    MaybeWriteOrderLog();
     return;
   }
 
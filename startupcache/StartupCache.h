@@ -209,6 +209,13 @@ class StartupCache : public nsIMemoryReporter {
   static void WriteTimeout(nsITimer* aTimer, void* aClosure);
   void MaybeWriteOffMainThread();
   static void ThreadedPrefetch(void* aClosure);
+  bool ReadOrderLog(nsTArray<uint32_t>& aOrder);
+  void MaybeWriteOrderLog();
+
+  struct EntryRange {
+    uint32_t mOffset;
+    uint32_t mSize;
+  };
 
   HashMap<nsCString, StartupCacheEntry> mTable;
   // owns references to the contents of tables which have been invalidated.
@@ -216,7 +223,10 @@ class StartupCache : public nsIMemoryReporter {
   // invalidated, but this should not happen in practice.
   nsTArray<decltype(mTable)> mOldTables;
   nsCOMPtr<nsIFile> mFile;
+  nsCOMPtr<nsIFile> mOrderFile;
   loader::AutoMemMap mCacheData;
+  // Where the entries of the cache file are, in file order.
+  nsTArray<EntryRange> mEntryRanges;
   Mutex mTableLock;
 
   nsCOMPtr<nsIObserverService> mObserverService;
@@ -228,6 +238,9 @@ class StartupCache : public nsIMemoryReporter {
   bool mCurTableReferenced;
   uint32_t mRequestedCount;
   size_t mCacheEntriesBaseOffset;
+  // Set by the prefetch thread, read once it's done.
+  bool mFoundOrderLog;
+  bool mOrderLogWritten;
 
   static StaticRefPtr<StartupCache> gStartupCache;
   static bool gShutdownInitiated;
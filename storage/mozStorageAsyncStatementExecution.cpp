@@ -41,6 +41,8 @@ namespace storage {
 #define MAX_MILLISECONDS_BETWEEN_RESULTS 75
 #define MAX_ROWS_PER_RESULT 15
 
+#define BATCH_SAVEPOINT "mozStorageAsyncBatch"
+
 ////////////////////////////////////////////////////////////////////////////////
 //// AsyncExecuteStatements
 
@@ -83,6 +85,8 @@ AsyncExecuteStatements::AsyncExecuteStatements(
       mConnection(aConnection),
       mNativeConnection(aNativeConnection),
       mHasTransaction(false),
+      mInBatch(false),
+      mHasSavepoint(false),
       mCallback(aCallback),
       mCallingThread(::do_GetCurrentThread()),
       mMaxWait(
@@ -364,6 +368,40 @@ nsresult AsyncExecuteStatements::notifyComplete() {
     mHasTransaction = false;
   }
 
+  if (mHasSavepoint) {
+    SQLiteMutexAutoLock lockedScope(mDBMutex);
+    if (mState != COMPLETED) {
+      DebugOnly<int> srv = mConnection->executeSql(
+          mNativeConnection, "ROLLBACK TO " BATCH_SAVEPOINT);
+      NS_WARNING_ASSERTION(srv == SQLITE_OK, "Savepoint failed to rollback");
+    }
+    (void)mConnection->executeSql(mNativeConnection,
+                                  "RELEASE " BATCH_SAVEPOINT);
+    mHasSavepoint = false;
+  }
+
+  if (mInBatch && mState == COMPLETED) {
+    // We are only done once the batch is committed.
+    mConnection->deferAsyncCompletion(this);
+    return NS_OK;
+  }
+
+  dispatchCompletion();
+  return NS_OK;
+}
+
+void AsyncExecuteStatements::notifyBatchCommitted(bool aCommitted) {
+  mMutex.AssertNotCurrentThreadOwns();
+  MOZ_ASSERT(mInBatch);
+
+  if (!aCommitted) {
+    mState = ERROR;
+    (void)notifyError(mozIStorageError::ERROR, "Transaction failed to commit");
+  }
+  dispatchCompletion();
+}
+
+void AsyncExecuteStatements::dispatchCompletion() {
   // This will take ownership of mCallback and make sure its destruction will
   // happen on the owner thread.
   Unused << mCallingThread->Dispatch(
@@ -371,8 +409,6 @@ nsresult AsyncExecuteStatements::notifyComplete() {
                         this,
                         &AsyncExecuteStatements::notifyCompleteOnCallingThread),
       NS_DISPATCH_NORMAL);
-
-  return NS_OK;
 }
 
 nsresult AsyncExecuteStatements::notifyCompleteOnCallingThread() {
@@ -477,6 +513,15 @@ bool AsyncExecuteStatements::statementsNeedTransaction() {
   return false;
 }
 
+bool AsyncExecuteStatements::statementsWrite() {
+  for (uint32_t i = 0; i < mStatements.Length(); ++i) {
+    if (mStatements[i].needsTransaction()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //// mozIStoragePendingStatement
 
@@ -516,7 +561,18 @@ AsyncExecuteStatements::Run() {
   }
   if (mState == CANCELED) return notifyComplete();
 
-  if (statementsNeedTransaction()) {
+  if (mConnection->batchesAsyncWrites() && statementsWrite()) {
+    SQLiteMutexAutoLock lockedScope(mDBMutex);
+    mInBatch = mConnection->joinAsyncWriteBatch(lockedScope);
+    // Keep our statements atomic without ending the batch's transaction.
+    if (mInBatch && statementsNeedTransaction()) {
+      mHasSavepoint = mConnection->executeSql(mNativeConnection,
+                                              "SAVEPOINT " BATCH_SAVEPOINT) ==
+                      SQLITE_OK;
+    }
+  }
+
+  if (!mInBatch && statementsNeedTransaction()) {
     SQLiteMutexAutoLock lockedScope(mDBMutex);
     if (!mConnection->transactionInProgress(lockedScope)) {
       if (NS_SUCCEEDED(mConnection->beginTransactionInternal(
@@ -90,6 +90,16 @@ class AsyncExecuteStatements final : public Runnable,
   nsresult notifyErrorOnCallingThread(mozIStorageError* aError);
   nsresult notifyResultsOnCallingThread(ResultSet* aResultSet);
 
+  /**
+   * Called by the connection once the write batch these statements ran in
+   * is over, to notify completion.
+   *
+   * @param aCommitted
+   *        Whether the batch was committed.  If not, our changes are lost and
+   *        we complete with an error.
+   */
+  void notifyBatchCommitted(bool aCommitted);
+
  private:
   AsyncExecuteStatements(StatementDataArray&& aStatements,
                          Connection* aConnection, sqlite3* aNativeConnection,
@@ -157,6 +167,11 @@ class AsyncExecuteStatements final : public Runnable,
    */
   nsresult notifyComplete();
 
+  /**
+   * Dispatches the completion notification to the calling thread.
+   */
+  void dispatchCompletion();
+
   /**
    * Notifies callback about an error.
    *
@@ -188,10 +203,19 @@ class AsyncExecuteStatements final : public Runnable,
    */
   bool statementsNeedTransaction();
 
+  /**
+   * Tests whether any of the current statements writes to the database.
+   */
+  bool statementsWrite();
+
   StatementDataArray mStatements;
   RefPtr<Connection> mConnection;
   sqlite3* mNativeConnection;
   bool mHasTransaction;
+  // Whether we run in the connection's write batch, and in a savepoint of
+  // our own in it.
+  bool mInBatch;
+  bool mHasSavepoint;
   // Note, this may not be a threadsafe object - never addref/release off
   // the calling thread.  We take a reference when this is created, and
   // release it in the CompletionNotifier::Run() call back to this thread.
@@ -311,6 +311,9 @@ class AsyncCloseConnection final : public Runnable {
                           mConnection, &Connection::shutdownAsyncThread);
     MOZ_ALWAYS_SUCCEEDS(NS_DispatchToMainThread(event));
 
+    // Don't let closing roll back what was batched.
+    mConnection->commitAsyncWriteBatch();
+
     // Internal close.
     (void)mConnection->internalClose(mNativeConnection);
 
@@ -439,6 +442,8 @@ Connection::Connection(Service* aService, int aFlags,
       mAsyncExecutionThreadShuttingDown(false),
       mConnectionClosed(false),
       mDefaultTransactionType(mozIStorageConnection::TRANSACTION_DEFERRED),
+      mBatchAsyncWrites(false),
+      mAsyncWriteBatchOpen(false),
       mDestroying(false),
       mProgressHandler(nullptr),
       mFlags(aFlags),
@@ -2080,6 +2085,66 @@ nsresult Connection::beginTransactionInternal(
   return rv;
 }
 
+bool Connection::joinAsyncWriteBatch(const SQLiteMutexAutoLock& aProofOfLock) {
+  MOZ_ASSERT(mBatchAsyncWrites);
+  MOZ_ASSERT(!threadOpenedOn->IsOnCurrentThread());
+
+  if (mAsyncWriteBatchOpen) {
+    return true;
+  }
+  if (transactionInProgress(aProofOfLock) ||
+      NS_FAILED(beginTransactionInternal(aProofOfLock, mDBConn,
+                                         TRANSACTION_IMMEDIATE))) {
+    return false;
+  }
+
+  // Events are run in order, so whatever is queued by now joins the batch.
+  nsCOMPtr<nsIRunnable> event =
+      NewRunnableMethod("storage::Connection::commitAsyncWriteBatch", this,
+                        &Connection::commitAsyncWriteBatch);
+  if (NS_FAILED(NS_DispatchToCurrentThread(event))) {
+    // Nothing ran in it yet.
+    Unused << commitTransactionInternal(aProofOfLock, mDBConn);
+    return false;
+  }
+  mAsyncWriteBatchOpen = true;
+  return true;
+}
+
+void Connection::deferAsyncCompletion(AsyncExecuteStatements* aEvent) {
+  MOZ_ASSERT(mAsyncWriteBatchOpen);
+  mAsyncWriteBatch.AppendElement(aEvent);
+}
+
+void Connection::commitAsyncWriteBatch() {
+  MOZ_ASSERT(!threadOpenedOn->IsOnCurrentThread());
+
+  if (!mAsyncWriteBatchOpen) {
+    return;
+  }
+  mAsyncWriteBatchOpen = false;
+
+  bool committed = false;
+  {
+    SQLiteMutexAutoLock lockedScope(sharedDBMutex);
+    if (transactionInProgress(lockedScope)) {
+      committed =
+          NS_SUCCEEDED(commitTransactionInternal(lockedScope, mDBConn));
+      if (!committed) {
+        DebugOnly<nsresult> rv =
+            rollbackTransactionInternal(lockedScope, mDBConn);
+        NS_WARNING_ASSERTION(NS_SUCCEEDED(rv),
+                             "Batch transaction failed to rollback");
+      }
+    }
+  }
+
+  nsTArray<RefPtr<AsyncExecuteStatements>> batch = std::move(mAsyncWriteBatch);
+  for (AsyncExecuteStatements* event : batch) {
+    event->notifyBatchCommitted(committed);
+  }
+}
+
 NS_IMETHODIMP
 Connection::CommitTransaction() {
   if (!connectionReady()) {
@@ -34,6 +34,8 @@ class nsIThread;
 namespace mozilla {
 namespace storage {
 
+class AsyncExecuteStatements;
+
 class Connection final : public mozIStorageConnection,
                          public nsIInterfaceRequestor {
  public:
@@ -220,6 +222,17 @@ class Connection final : public mozIStorageConnection,
    */
   int stepStatement(sqlite3* aNativeConnection, sqlite3_stmt* aStatement);
 
+  /**
+   * Helper for calls to sqlite3_exec. Reports long delays to Telemetry.
+   *
+   * @param aNativeConnection
+   *        The underlying Sqlite connection to execute the query with.
+   * @param aSqlString
+   *        SQL string to execute
+   * @return the result from sqlite3_exec.
+   */
+  int executeSql(sqlite3* aNativeConnection, const char* aSqlString);
+
   /**
    * Raw connection transaction management.
    *
@@ -306,6 +319,35 @@ class Connection final : public mozIStorageConnection,
 
   nsresult initializeClone(Connection* aClone, bool aReadOnly);
 
+  /**
+   * Asynchronous write batching, see the batchWrites option of
+   * mozIStorageService::openAsyncDatabase.  Must be set before the async
+   * execution thread is used.
+   */
+  void setBatchAsyncWrites(bool aBatch) { mBatchAsyncWrites = aBatch; }
+  bool batchesAsyncWrites() const { return mBatchAsyncWrites; }
+
+  /**
+   * Makes the current thread's statements part of the open write batch,
+   * opening one if there is none.  Must be called on the async thread.
+   *
+   * @return false if they can't be batched because a transaction that isn't
+   *         ours is in progress, or opening one failed.
+   */
+  bool joinAsyncWriteBatch(const SQLiteMutexAutoLock& aProofOfLock);
+
+  /**
+   * Holds the completion notification of a batched execution until the batch
+   * is committed.
+   */
+  void deferAsyncCompletion(AsyncExecuteStatements* aEvent);
+
+  /**
+   * Commits the open write batch, if any, and notifies the completion of the
+   * executions in it.  Must be called on the async thread.
+   */
+  void commitAsyncWriteBatch();
+
   /**
    * Records a status from a sqlite statement.
    *
@@ -333,17 +375,6 @@ class Connection final : public mozIStorageConnection,
    */
   nsresult setClosedState();
 
-  /**
-   * Helper for calls to sqlite3_exec. Reports long delays to Telemetry.
-   *
-   * @param aNativeConnection
-   *        The underlying Sqlite connection to execute the query with.
-   * @param aSqlString
-   *        SQL string to execute
-   * @return the result from sqlite3_exec.
-   */
-  int executeSql(sqlite3* aNativeConnection, const char* aSqlString);
-
   /**
    * Describes a certain primitive type in the database.
    *
@@ -429,6 +460,15 @@ class Connection final : public mozIStorageConnection,
    */
   mozilla::Atomic<int32_t> mDefaultTransactionType;
 
+  bool mBatchAsyncWrites;
+
+  /**
+   * The open write batch, only used on the async execution thread: whether
+   * its transaction is open, and the executions waiting for it to commit.
+   */
+  bool mAsyncWriteBatchOpen;
+  nsTArray<RefPtr<AsyncExecuteStatements>> mAsyncWriteBatch;
+
   /**
    * Used to trigger cleanup logic only the first time our refcount hits 1.  We
    * may trigger a failsafe Close() that invokes SpinningSynchronousClose()
@@ -497,6 +497,7 @@ Service::OpenAsyncDatabase(nsIVariant* aDatabaseStore,
   bool readOnly = false;
   bool ignoreLockingMode = false;
   int32_t growthIncrement = -1;
+  bool batchWrites = false;
 
 #define FAIL_IF_SET_BUT_INVALID(rv)                    \
   if (NS_FAILED(rv) && rv != NS_ERROR_NOT_AVAILABLE) { \
@@ -522,6 +523,9 @@ Service::OpenAsyncDatabase(nsIVariant* aDatabaseStore,
     // NB: we re-set to -1 if we don't have a storage file later on.
     rv = aOptions->GetPropertyAsInt32(u"growthIncrement"_ns, &growthIncrement);
     FAIL_IF_SET_BUT_INVALID(rv);
+
+    rv = aOptions->GetPropertyAsBool(u"batchWrites"_ns, &batchWrites);
+    FAIL_IF_SET_BUT_INVALID(rv);
   }
   int flags = readOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE;
 
@@ -566,6 +570,7 @@ Service::OpenAsyncDatabase(nsIVariant* aDatabaseStore,
   // Create connection on this thread, but initialize it on its helper thread.
   RefPtr<Connection> msc =
       new Connection(this, flags, Connection::ASYNCHRONOUS, ignoreLockingMode);
+  msc->setBatchAsyncWrites(batchWrites);
   nsCOMPtr<nsIEventTarget> target = msc->getAsyncExecutionTarget();
   MOZ_ASSERT(target,
              "Cannot initialize a connection that has been closed already");
@@ -15,11 +15,16 @@
 #include "mozilla/Unused.h"
 #include "mozilla/GfxMessageUtils.h"  // For ParamTraits<GeckoProcessType>
 #include "mozilla/ResultExtensions.h"
+#include "mozilla/StaticPrefs_toolkit.h"
 
 #ifdef MOZ_GECKO_PROFILER
 #  include "shared-libraries.h"
 #endif
 
+#ifdef MOZ_WIDGET_GONK
+#  include <android/log.h>
+#endif
+
 static const char MAGIC[] = "permahangsavev1";
 
 namespace mozilla {
@@ -274,9 +279,76 @@ nsHangDetails::GetModules(JSContext* aCx, JS::MutableHandleValue aVal) {
   return NS_OK;
 }
 
+#ifdef MOZ_WIDGET_GONK
+// Writes a one-line summary of the hang to logcat: where it happened, how long
+// it lasted, the runnable that was running, and the innermost frames which
+// have a name (profiler labels and JS functions, innermost first).
+static void LogHang(const HangDetails& aDetails) {
+  static const uint32_t kMaxLoggedFrames = 6;
+
+  const HangStack& stack = aDetails.stack();
+  bool validBuffer =
+      !stack.strbuffer().IsEmpty() && stack.strbuffer().LastElement() == '\0';
+
+  nsAutoCString frames;
+  uint32_t logged = 0;
+  for (size_t i = stack.stack().Length(); i > 0 && logged < kMaxLoggedFrames;
+       --i) {
+    const HangEntry& entry = stack.stack()[i - 1];
+    const char* frame = nullptr;
+    switch (entry.type()) {
+      case HangEntry::TnsCString:
+        frame = entry.get_nsCString().get();
+        break;
+      case HangEntry::THangEntryBufOffset: {
+        uint32_t offset = entry.get_HangEntryBufOffset().index();
+        if (validBuffer && offset < stack.strbuffer().Length()) {
+          frame = reinterpret_cast<const char*>(stack.strbuffer().Elements() +
+                                                offset);
+        }
+        break;
+      }
+      case HangEntry::THangEntryContent:
+        frame = "(content script)";
+        break;
+      case HangEntry::THangEntryChromeScript:
+        frame = "(chrome script)";
+        break;
+      default:
+        // Native frames are only useful once symbolicated.
+        break;
+    }
+    if (!frame) {
+      continue;
+    }
+    if (logged++) {
+      frames.AppendLiteral(" < ");
+    }
+    frames.Append(frame);
+  }
+
+  __android_log_print(
+      ANDROID_LOG_WARN, "Gecko", "Hang: %s/%s %.0fms in %s: %s",
+      aDetails.process().get(), aDetails.threadName().get(),
+      aDetails.duration().ToMilliseconds(),
+      aDetails.runnableName().IsEmpty() ? "(unknown runnable)"
+                                        : aDetails.runnableName().get(),
+      frames.IsEmpty() ? "(no labels)" : frames.get());
+}
+#endif
+
 // Processing and submitting the stack as an observer notification.
 
 void nsHangDetails::Submit() {
+#ifdef MOZ_WIDGET_GONK
+  uint32_t logThreshold =
+      StaticPrefs::toolkit_background_hang_monitor_log_threshold_ms();
+  if (logThreshold &&
+      mDetails.duration().ToMilliseconds() >= double(logThreshold)) {
+    LogHang(mDetails);
+  }
+#endif
+
   RefPtr<nsHangDetails> hangDetails = this;
   nsCOMPtr<nsIRunnable> notifyObservers =
       NS_NewRunnableFunction("NotifyBHRHangObservers", [hangDetails] {
@@ -251,6 +251,31 @@ const char* GetPathAfterComponent(const char* filename,
   return found;
 }
 
+#ifdef MOZ_WIDGET_GONK
+// Gaia apps, the system app included, are served from
+// http(s)://<app>.localhost/. They are part of the product rather than web
+// content, so hangs in them are reported with the script name like chrome.
+bool IsGaiaJSScript(JSScript* aScript) {
+  const char* filename = JS_GetScriptFilename(aScript);
+  if (!filename) {
+    return false;
+  }
+  const char* host = GetFullPathForScheme(filename, "http://");
+  if (!host) {
+    host = GetFullPathForScheme(filename, "https://");
+  }
+  if (!host) {
+    return false;
+  }
+  static const char kSuffix[] = ".localhost";
+  const size_t suffixLength = sizeof(kSuffix) - 1;
+  const char* hostEnd = strpbrk(host, ":/");
+  size_t hostLength = hostEnd ? size_t(hostEnd - host) : strlen(host);
+  return hostLength > suffixLength &&
+         !strncmp(host + hostLength - suffixLength, kSuffix, suffixLength);
+}
+#endif
+
 }  // namespace
 
 bool ThreadStackHelper::MaybeAppendDynamicStackFrame(Span<const char> aBuf) {
@@ -319,7 +344,11 @@ void ThreadStackHelper::CollectProfilingStackFrame(
     return;
   }
 
-  if (!IsChromeJSScript(aFrame.script())) {
+  if (!IsChromeJSScript(aFrame.script())
+#ifdef MOZ_WIDGET_GONK
+      && !IsGaiaJSScript(aFrame.script())
+#endif
+  ) {
     TryAppendFrame(HangEntryContent());
     return;
   }
@@ -354,6 +383,14 @@ void ThreadStackHelper::CollectProfilingStackFrame(
   if (!basename) {
     basename = GetFullPathForScheme(filename, "resource://");
   }
+#ifdef MOZ_WIDGET_GONK
+  if (!basename) {
+    basename = GetFullPathForScheme(filename, "http://");
+  }
+  if (!basename) {
+    basename = GetFullPathForScheme(filename, "https://");
+  }
+#endif
   if (!basename) {
     // If we're in an add-on script, under the {profile}/extensions
     // directory, extract the path after the /extensions/ part.
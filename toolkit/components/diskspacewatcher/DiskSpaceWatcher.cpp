@@ -18,6 +18,7 @@ NS_IMPL_ISUPPORTS(DiskSpaceWatcher, nsIDiskSpaceWatcher, nsIObserver)
 
 uint64_t DiskSpaceWatcher::sFreeSpace = 0;
 bool DiskSpaceWatcher::sIsDiskFull = false;
+uint16_t DiskSpaceWatcher::sLevel = nsIDiskSpaceWatcher::LEVEL_NORMAL;
 
 DiskSpaceWatcher::DiskSpaceWatcher() {
   MOZ_ASSERT(NS_IsMainThread());
@@ -86,6 +87,11 @@ NS_IMETHODIMP DiskSpaceWatcher::GetFreeSpace(uint64_t* aFreeSpace) {
   return NS_OK;
 }
 
+NS_IMETHODIMP DiskSpaceWatcher::GetLevel(uint16_t* aLevel) {
+  *aLevel = sLevel;
+  return NS_OK;
+}
+
 // static
 void DiskSpaceWatcher::UpdateState(bool aIsDiskFull, uint64_t aFreeSpace) {
   MOZ_ASSERT(NS_IsMainThread());
@@ -112,3 +118,29 @@ void DiskSpaceWatcher::UpdateState(bool aIsDiskFull, uint64_t aFreeSpace) {
   observerService->NotifyObservers(subject, DISKSPACEWATCHER_OBSERVER_TOPIC,
                                    sIsDiskFull ? stateFull : stateFree);
 }
+
+// static
+void DiskSpaceWatcher::UpdateLevel(uint16_t aLevel) {
+  MOZ_ASSERT(NS_IsMainThread());
+  if (!gDiskSpaceWatcher || aLevel == sLevel) {
+    return;
+  }
+
+  sLevel = aLevel;
+
+  nsCOMPtr<nsIObserverService> observerService =
+      mozilla::services::GetObserverService();
+  if (!observerService) {
+    return;
+  }
+
+  static const char16_t* const kLevelNames[] = {u"normal", u"warning", u"low",
+                                                u"critical"};
+  MOZ_ASSERT(sLevel < MOZ_ARRAY_LENGTH(kLevelNames));
+
+  nsCOMPtr<nsISupports> subject;
+  CallQueryInterface(gDiskSpaceWatcher.get(), getter_AddRefs(subject));
+  MOZ_ASSERT(subject);
+  observerService->NotifyObservers(
+      subject, DISKSPACEWATCHER_LEVEL_OBSERVER_TOPIC, kLevelNames[sLevel]);
+}
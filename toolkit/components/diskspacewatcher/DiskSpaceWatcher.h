@@ -19,12 +19,14 @@ class DiskSpaceWatcher final : public nsIDiskSpaceWatcher, public nsIObserver {
   static already_AddRefed<DiskSpaceWatcher> FactoryCreate();
 
   static void UpdateState(bool aIsDiskFull, uint64_t aFreeSpace);
+  static void UpdateLevel(uint16_t aLevel);
 
  private:
   ~DiskSpaceWatcher();
 
   static uint64_t sFreeSpace;
   static bool sIsDiskFull;
+  static uint16_t sLevel;
 };
 
 #endif  // __DISKSPACEWATCHER_H__
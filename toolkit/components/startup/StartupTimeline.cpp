@@ -5,7 +5,16 @@
 #include "StartupTimeline.h"
 #include "mozilla/Telemetry.h"
 #include "mozilla/TimeStamp.h"
+#include "nsPrintfCString.h"
+#include "nsString.h"
 #include "nsXULAppAPI.h"
+#include "prenv.h"
+
+#include <stdio.h>
+
+#ifdef MOZ_WIDGET_GONK
+#  include <android/log.h>
+#endif
 
 namespace mozilla {
 
@@ -34,6 +43,48 @@ void XRE_StartupTimelineRecord(int aEvent, TimeStamp aWhen) {
   StartupTimeline::Record((StartupTimeline::Event)aEvent, aWhen);
 }
 
+/**
+ * Emit the startup timeline as a single JSON object mapping each recorded
+ * event to its offset, in milliseconds, from process creation. The timeline is
+ * written to the file named by MOZ_STARTUP_TIMELINE_FILE when set, and to
+ * logcat on Gonk, so that cold start regressions can be tracked by tooling.
+ */
+static void DumpStartupTimeline() {
+  bool error = false;
+  TimeStamp processCreation = TimeStamp::ProcessCreation(&error);
+  if (error) {
+    return;
+  }
+
+  nsAutoCString json("{");
+  bool first = true;
+  for (int i = 0; i < StartupTimeline::MAX_EVENT_ID; ++i) {
+    StartupTimeline::Event ev = static_cast<StartupTimeline::Event>(i);
+    TimeStamp stamp = StartupTimeline::Get(ev);
+    if (stamp.IsNull()) {
+      continue;
+    }
+    json.Append(nsPrintfCString("%s\"%s\":%.3f", first ? "" : ",",
+                                StartupTimeline::Describe(ev),
+                                (stamp - processCreation).ToMilliseconds()));
+    first = false;
+  }
+  json.Append('}');
+
+#ifdef MOZ_WIDGET_GONK
+  __android_log_print(ANDROID_LOG_INFO, "StartupTimeline", "%s", json.get());
+#endif
+
+  const char* path = PR_GetEnv("MOZ_STARTUP_TIMELINE_FILE");
+  if (path && *path) {
+    if (FILE* file = fopen(path, "w")) {
+      fputs(json.get(), file);
+      fputc('\n', file);
+      fclose(file);
+    }
+  }
+}
+
 void StartupTimeline::RecordOnce(Event ev) { RecordOnce(ev, TimeStamp::Now()); }
 
 void StartupTimeline::RecordOnce(Event ev, const TimeStamp& aWhen) {
@@ -55,4 +106,8 @@ void StartupTimeline::RecordOnce(Event ev, const TimeStamp& aWhen) {
           firstPaintTime);
     }
   }
+
+  if (ev == FIRST_PAINT && XRE_IsParentProcess()) {
+    DumpStartupTimeline();
+  }
 }
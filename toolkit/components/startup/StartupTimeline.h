@@ -9,6 +9,12 @@
   mozilla_StartupTimeline_Event(MAIN, "main")
   mozilla_StartupTimeline_Event(SELECT_PROFILE, "selectProfile")
   mozilla_StartupTimeline_Event(AFTER_PROFILE_LOCKED, "afterProfileLocked")
+  mozilla_StartupTimeline_Event(XPCOM_INITIALIZED, "xpcomInitialized")
+
+  // Bracket the background read-ahead of startup files which runs in parallel
+  // with profile selection and XPCOM initialization.
+  mozilla_StartupTimeline_Event(PREWARM_BEGIN, "prewarmBegin")
+  mozilla_StartupTimeline_Event(PREWARM_END, "prewarmEnd")
 
   // Record the beginning and end of startup crash detection to compare with
   // crash stats to know whether detection should be improved to start or end
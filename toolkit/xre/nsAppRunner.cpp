@@ -161,6 +161,7 @@
 #include "nsXREDirProvider.h"
 
 #include "nsINIParser.h"
+#include "mozilla/FileUtils.h"
 #include "mozilla/Omnijar.h"
 #include "mozilla/StartupTimeline.h"
 #include "mozilla/LateWriteChecks.h"
@@ -4013,6 +4014,54 @@ static void AnnotateLSBRelease(void*) {
 
 #endif  // defined(XP_LINUX) && !defined(ANDROID)
 
+#ifdef MOZ_WIDGET_GONK
+// Files read during startup whose first access would otherwise block the main
+// thread on flash I/O. They are pulled into the page cache from a helper
+// thread while profile selection and XPCOM initialization proceed serially.
+static void PR_CALLBACK PrewarmStartupFiles_ThreadStart(void* arg) {
+  UniquePtr<nsTArray<nsCString>> paths(static_cast<nsTArray<nsCString>*>(arg));
+
+  StartupTimeline::Record(StartupTimeline::PREWARM_BEGIN);
+  for (const nsCString& path : *paths) {
+    ReadAheadFile(path.get());
+  }
+  StartupTimeline::Record(StartupTimeline::PREWARM_END);
+}
+
+static void StartPrewarmStartupFiles(nsIFile* aGREDir, nsIFile* aAppDir) {
+  if (PR_GetEnv("XRE_NO_PREWARM")) {
+    return;
+  }
+
+  auto paths = MakeUnique<nsTArray<nsCString>>();
+  auto appendFile = [&paths](nsIFile* aDir, const nsACString& aName) {
+    nsCOMPtr<nsIFile> file;
+    if (!aDir || NS_FAILED(aDir->Clone(getter_AddRefs(file))) ||
+        NS_FAILED(file->AppendNative(aName))) {
+      return;
+    }
+    nsAutoCString path;
+    if (NS_SUCCEEDED(file->GetNativePath(path)) && !paths->Contains(path)) {
+      paths->AppendElement(path);
+    }
+  };
+
+  // The GRE and app omni.ja hold the chrome, modules and default prefs that
+  // the first parts of XPCOM and the system app need. ICU data is linked into
+  // libxul, which is already resident by now.
+  appendFile(aGREDir, nsLiteralCString(MOZ_STRINGIFY(OMNIJAR_NAME)));
+  appendFile(aAppDir, nsLiteralCString(MOZ_STRINGIFY(OMNIJAR_NAME)));
+  paths->AppendElement("/system/etc/fonts.xml"_ns);
+
+  PRThread* thread = PR_CreateThread(
+      PR_USER_THREAD, PrewarmStartupFiles_ThreadStart, paths.get(),
+      PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD, PR_UNJOINABLE_THREAD, 0);
+  if (thread) {
+    Unused << paths.release();
+  }
+}
+#endif  // MOZ_WIDGET_GONK
+
 #ifdef XP_WIN
 static void ReadAheadSystemDll(const wchar_t* dllName) {
   wchar_t dllPath[MAX_PATH];
@@ -5429,6 +5478,10 @@ int XREMain::XRE_main(int argc, char* argv[], const BootstrapConfig& aConfig) {
     return NS_OK;
   });
 
+#ifdef MOZ_WIDGET_GONK
+  StartPrewarmStartupFiles(mDirProvider.GetGREDir(), mDirProvider.GetAppDir());
+#endif
+
   // startup
   result = XRE_mainStartup(&exit);
   if (result != 0 || exit) return result;
@@ -5441,6 +5494,8 @@ int XREMain::XRE_main(int argc, char* argv[], const BootstrapConfig& aConfig) {
   rv = mScopedXPCOM->Initialize(/* aInitJSContext = */ false);
   NS_ENSURE_SUCCESS(rv, 1);
 
+  StartupTimeline::Record(StartupTimeline::XPCOM_INITIALIZED);
+
   // run!
   rv = XRE_mainRun();
 
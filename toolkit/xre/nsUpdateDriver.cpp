@@ -4,6 +4,8 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <algorithm>
+#include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include "nsUpdateDriver.h"
@@ -14,6 +16,7 @@
 #include "nsCOMPtr.h"
 #include "nsString.h"
 #include "prproces.h"
+#include "prthread.h"
 #include "mozilla/Logging.h"
 #include "prenv.h"
 #include "nsVersionComparator.h"
@@ -50,10 +53,20 @@
 #  define getcwd(path, size) _getcwd(path, size)
 #  define getpid() GetCurrentProcessId()
 #elif defined(XP_UNIX)
+#  include <signal.h>
 #  include <unistd.h>
+#  include <sys/resource.h>
 #  include <sys/wait.h>
 #endif
 
+#ifdef XP_LINUX
+#  include <sys/syscall.h>
+// From linux/ioprio.h, which not every libc ships.
+#  define UPDATER_IOPRIO_WHO_PROCESS 1
+#  define UPDATER_IOPRIO_CLASS_IDLE 3
+#  define UPDATER_IOPRIO_CLASS_SHIFT 13
+#endif
+
 using namespace mozilla;
 
 static LazyLogModule sUpdateLog("updatedriver");
@@ -709,9 +722,10 @@ nsresult ProcessUpdates(nsIFile* greDir, nsIFile* appDir, nsIFile* updRootDir,
   return NS_OK;
 }
 
-NS_IMPL_ISUPPORTS(nsUpdateProcessor, nsIUpdateProcessor)
+NS_IMPL_ISUPPORTS(nsUpdateProcessor, nsIUpdateProcessor, nsIObserver)
 
-nsUpdateProcessor::nsUpdateProcessor() : mUpdaterPID(0) {}
+nsUpdateProcessor::nsUpdateProcessor()
+    : mUpdaterPID(0), mUserInteracting(false) {}
 
 nsUpdateProcessor::~nsUpdateProcessor() = default;
 
@@ -764,8 +778,20 @@ nsUpdateProcessor::ProcessUpdate() {
   mInfo.mArgc = 0;
   mInfo.mArgv = nullptr;
   mInfo.mAppVersion = appVersion;
+  mInfo.mLowPriority =
+      Preferences::GetBool("app.update.staging.lowPriority", false);
+  mInfo.mInteractiveDutyPercent = std::max(
+      10, std::min(100, Preferences::GetInt(
+                            "app.update.staging.interactiveDutyPercent", 100)));
 
   MOZ_ASSERT(NS_IsMainThread(), "not main thread");
+  if (mInfo.mInteractiveDutyPercent < 100) {
+    nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+    if (obs) {
+      obs->AddObserver(this, "user-interaction-active", false);
+      obs->AddObserver(this, "user-interaction-inactive", false);
+    }
+  }
   nsCOMPtr<nsIRunnable> r =
       NewRunnableMethod("nsUpdateProcessor::StartStagedUpdate", this,
                         &nsUpdateProcessor::StartStagedUpdate);
@@ -1030,6 +1056,10 @@ void nsUpdateProcessor::StartStagedUpdate() {
   NS_ENSURE_SUCCESS_VOID(rv);
 
   if (mUpdaterPID) {
+    if (mInfo.mLowPriority) {
+      LowerUpdaterPriority();
+    }
+
     // Track the state of the updater process while it is staging an update.
     rv = NS_DispatchToCurrentThread(
         NewRunnableMethod("nsUpdateProcessor::WaitForProcess", this,
@@ -1048,6 +1078,11 @@ void nsUpdateProcessor::StartStagedUpdate() {
 
 void nsUpdateProcessor::ShutdownWatcherThread() {
   MOZ_ASSERT(NS_IsMainThread(), "not main thread");
+  nsCOMPtr<nsIObserverService> obs = services::GetObserverService();
+  if (obs && mInfo.mInteractiveDutyPercent < 100) {
+    obs->RemoveObserver(this, "user-interaction-active");
+    obs->RemoveObserver(this, "user-interaction-inactive");
+  }
   mProcessWatcher->Shutdown();
   mProcessWatcher = nullptr;
 }
@@ -1058,12 +1093,62 @@ void nsUpdateProcessor::WaitForProcess() {
     NS_DispatchToMainThread(NewRunnableMethod(
         "nsUpdateProcessor::UpdateDone", this, &nsUpdateProcessor::UpdateDone));
   } else {
+    ThrottleWhileInteracting();
     NS_DispatchToCurrentThread(
         NewRunnableMethod("nsUpdateProcessor::WaitForProcess", this,
                           &nsUpdateProcessor::WaitForProcess));
   }
 }
 
+/**
+ * Staging an update reads and writes the whole application, which makes the
+ * device sluggish on slow storage. Only let the updater use the disk when
+ * nothing else does, and the CPU likewise.
+ */
+void nsUpdateProcessor::LowerUpdaterPriority() {
+#ifdef XP_LINUX
+  int ioprio = UPDATER_IOPRIO_CLASS_IDLE << UPDATER_IOPRIO_CLASS_SHIFT;
+  if (syscall(SYS_ioprio_set, UPDATER_IOPRIO_WHO_PROCESS, mUpdaterPID,
+              ioprio) != 0) {
+    LOG(("failed to lower the updater's I/O priority: %d\n", errno));
+  }
+#endif
+#if defined(XP_UNIX) && !defined(XP_MACOSX)
+  setpriority(PRIO_PROCESS, mUpdaterPID, 19);
+#endif
+}
+
+/**
+ * While the user interacts with the device, the updater only runs
+ * app.update.staging.interactiveDutyPercent of the time: it is stopped
+ * after every second it ran for as long as needed. The idle I/O class
+ * doesn't help with the flash bandwidth the updater's writes take once
+ * they are queued, this does.
+ */
+void nsUpdateProcessor::ThrottleWhileInteracting() {
+  MOZ_ASSERT(!NS_IsMainThread(), "main thread");
+#if defined(XP_UNIX) && !defined(XP_MACOSX)
+  uint32_t duty = mInfo.mInteractiveDutyPercent;
+  if (!mUserInteracting || duty >= 100) {
+    return;
+  }
+
+  uint32_t stopMs = 1000 * (100 - duty) / duty;
+  if (kill(mUpdaterPID, SIGSTOP) != 0) {
+    return;
+  }
+  PR_Sleep(PR_MillisecondsToInterval(stopMs));
+  kill(mUpdaterPID, SIGCONT);
+#endif
+}
+
+NS_IMETHODIMP
+nsUpdateProcessor::Observe(nsISupports* aSubject, const char* aTopic,
+                           const char16_t* aData) {
+  mUserInteracting = !strcmp(aTopic, "user-interaction-active");
+  return NS_OK;
+}
+
 void nsUpdateProcessor::UpdateDone() {
   MOZ_ASSERT(NS_IsMainThread(), "not main thread");
 
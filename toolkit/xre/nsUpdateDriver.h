@@ -9,9 +9,11 @@
 
 #include "nscore.h"
 #include "nsIUpdateService.h"
+#include "nsIObserver.h"
 #include "nsIThread.h"
 #include "nsCOMPtr.h"
 #include "nsString.h"
+#include "mozilla/Atomics.h"
 #include "mozilla/Attributes.h"
 
 class nsIFile;
@@ -54,18 +56,24 @@ nsresult ProcessUpdates(nsIFile* greDir, nsIFile* appDir, nsIFile* updRootDir,
 // updater application for staging an update.
 // XXX ehsan this is living in this file in order to make use of the existing
 // stuff here, we might want to move it elsewhere in the future.
-class nsUpdateProcessor final : public nsIUpdateProcessor {
+class nsUpdateProcessor final : public nsIUpdateProcessor,
+                                public nsIObserver {
  public:
   nsUpdateProcessor();
 
   NS_DECL_THREADSAFE_ISUPPORTS
   NS_DECL_NSIUPDATEPROCESSOR
+  NS_DECL_NSIOBSERVER
 
  private:
   ~nsUpdateProcessor();
 
   struct StagedUpdateInfo {
-    StagedUpdateInfo() : mArgc(0), mArgv(nullptr) {}
+    StagedUpdateInfo()
+        : mArgc(0),
+          mArgv(nullptr),
+          mLowPriority(false),
+          mInteractiveDutyPercent(100) {}
     ~StagedUpdateInfo() {
       for (int i = 0; i < mArgc; ++i) {
         delete[] mArgv[i];
@@ -79,6 +87,10 @@ class nsUpdateProcessor final : public nsIUpdateProcessor {
     int mArgc;
     char** mArgv;
     nsCString mAppVersion;
+    // From app.update.staging.lowPriority and interactiveDutyPercent, read
+    // on the main thread.
+    bool mLowPriority;
+    uint32_t mInteractiveDutyPercent;
   };
 
  private:
@@ -86,9 +98,14 @@ class nsUpdateProcessor final : public nsIUpdateProcessor {
   void WaitForProcess();
   void UpdateDone();
   void ShutdownWatcherThread();
+  void LowerUpdaterPriority();
+  void ThrottleWhileInteracting();
 
  private:
   ProcessType mUpdaterPID;
+  // Whether the user is interacting with the device, see
+  // ThrottleWhileInteracting().
+  mozilla::Atomic<bool> mUserInteracting;
   nsCOMPtr<nsIThread> mProcessWatcher;
   StagedUpdateInfo mInfo;
 };
@@ -6,6 +6,7 @@
 
 #include "nsProfiler.h"
 
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -21,7 +22,10 @@
 #include "mozilla/dom/Promise.h"
 #include "mozilla/dom/TypedArray.h"
 #include "mozilla/Preferences.h"
+#include "mozilla/StaticPrefs_profiler.h"
+#include "nsAppDirectoryServiceDefs.h"
 #include "nsComponentManagerUtils.h"
+#include "nsDirectoryServiceUtils.h"
 #include "nsIFileStreams.h"
 #include "nsIInterfaceRequestor.h"
 #include "nsIInterfaceRequestorUtils.h"
@@ -29,11 +33,14 @@
 #include "nsIObserverService.h"
 #include "nsIWebNavigation.h"
 #include "nsLocalFile.h"
+#include "nsISafeOutputStream.h"
 #include "nsMemory.h"
+#include "nsNetUtil.h"
 #include "nsProfilerStartParams.h"
 #include "nsProxyRelease.h"
 #include "nsString.h"
 #include "nsThreadUtils.h"
+#include "nsXULAppAPI.h"
 #include "platform.h"
 #include "shared-libraries.h"
 #include "zlib.h"
@@ -48,6 +55,7 @@ NS_IMPL_ISUPPORTS(nsProfiler, nsIProfiler, nsIObserver)
 
 nsProfiler::nsProfiler()
     : mLockedForPrivateBrowsing(false),
+      mInFieldMode(false),
       mPendingProfiles(0),
       mGathering(false) {}
 
@@ -57,6 +65,10 @@ nsProfiler::~nsProfiler() {
   if (observerService) {
     observerService->RemoveObserver(this, "chrome-document-global-created");
     observerService->RemoveObserver(this, "last-pb-context-exited");
+    if (mInFieldMode) {
+      observerService->RemoveObserver(this, "bhr-thread-hang");
+      observerService->RemoveObserver(this, "process-hang-report");
+    }
   }
   if (mSymbolTableThread) {
     mSymbolTableThread->Shutdown();
@@ -94,10 +106,105 @@ nsProfiler::Observe(nsISupports* aSubject, const char* aTopic,
     }
   } else if (strcmp(aTopic, "last-pb-context-exited") == 0) {
     mLockedForPrivateBrowsing = false;
+  } else if (strcmp(aTopic, "profile-after-change") == 0) {
+    if (XRE_IsParentProcess() && StaticPrefs::profiler_field_mode_enabled() &&
+        !profiler_is_active()) {
+      StartFieldMode();
+    }
+  } else if (strcmp(aTopic, "bhr-thread-hang") == 0 ||
+             strcmp(aTopic, "process-hang-report") == 0) {
+    DumpFieldModeProfile();
   }
   return NS_OK;
 }
 
+// Field mode keeps a small, low-rate profile of the main threads running on
+// devices in the field, and saves it to the profile directory when a hang is
+// reported so that field performance problems can be looked at without
+// reproducing them. Child processes pick up the same settings when they
+// connect to ProfilerParent.
+void nsProfiler::StartFieldMode() {
+  // Only native stacks: the "js" feature is left out, so JS shows up through
+  // the labels on the profiling stack.
+  uint32_t features =
+      ProfilerFeature::StackWalk & profiler_get_available_features();
+  const char* filters[] = {"GeckoMain"};
+  uint32_t interval =
+      std::max(StaticPrefs::profiler_field_mode_interval_ms(), 1u);
+
+  profiler_start(PowerOfTwo32(StaticPrefs::profiler_field_mode_entries()),
+                 std::min(double(interval), double(PROFILER_MAX_INTERVAL)),
+                 features, filters, MOZ_ARRAY_LENGTH(filters),
+                 PROFILER_DEFAULT_ACTIVE_TAB_ID);
+
+  nsCOMPtr<nsIObserverService> observerService =
+      mozilla::services::GetObserverService();
+  if (observerService) {
+    observerService->AddObserver(this, "bhr-thread-hang", false);
+    observerService->AddObserver(this, "process-hang-report", false);
+  }
+  mInFieldMode = true;
+}
+
+void nsProfiler::DumpFieldModeProfile() {
+  MOZ_ASSERT(NS_IsMainThread());
+
+  // A profiler started by the user replaces the field mode one, and is not
+  // ours to save.
+  if (!mInFieldMode || !profiler_is_active() || mGathering) {
+    return;
+  }
+
+  TimeStamp now = TimeStamp::Now();
+  if (!mLastFieldModeDump.IsNull() &&
+      (now - mLastFieldModeDump).ToSeconds() <
+          StaticPrefs::profiler_field_mode_min_dump_interval_s()) {
+    return;
+  }
+
+  nsCOMPtr<nsIFile> file;
+  nsresult rv =
+      NS_GetSpecialDirectory(NS_APP_USER_PROFILE_50_DIR, getter_AddRefs(file));
+  if (NS_FAILED(rv)) {
+    return;
+  }
+  rv = file->AppendNative("profiler_field_mode.json"_ns);
+  if (NS_FAILED(rv)) {
+    return;
+  }
+  mLastFieldModeDump = now;
+
+  StartGathering(0)->Then(
+      GetMainThreadSerialEventTarget(), __func__,
+      [file](const nsCString& aResult) {
+        nsCString profile(aResult);
+        NS_DispatchBackgroundTask(
+            NS_NewRunnableFunction(
+                "nsProfiler::DumpFieldModeProfile",
+                [file, profile]() {
+                  nsCOMPtr<nsIOutputStream> stream;
+                  nsresult rv = NS_NewSafeLocalFileOutputStream(
+                      getter_AddRefs(stream), file);
+                  if (NS_FAILED(rv)) {
+                    return;
+                  }
+                  uint32_t written;
+                  rv = stream->Write(profile.get(), profile.Length(),
+                                     &written);
+                  if (NS_FAILED(rv) || written != profile.Length()) {
+                    return;
+                  }
+                  nsCOMPtr<nsISafeOutputStream> safeStream =
+                      do_QueryInterface(stream);
+                  if (safeStream) {
+                    Unused << safeStream->Finish();
+                  }
+                }),
+            NS_DISPATCH_EVENT_MAY_BLOCK);
+      },
+      [](nsresult aRv) {});
+}
+
 NS_IMETHODIMP
 nsProfiler::CanProfile(bool* aCanProfile) {
   *aCanProfile = !mLockedForPrivateBrowsing;
@@ -125,6 +232,7 @@ nsProfiler::StartProfiler(uint32_t aEntries, double aInterval,
   }
 
   ResetGathering();
+  mInFieldMode = false;
 
   Vector<const char*> featureStringVector;
   nsresult rv = FillVectorFromStringArray(featureStringVector, aFeatures);
@@ -150,6 +258,7 @@ nsProfiler::StartProfiler(uint32_t aEntries, double aInterval,
 NS_IMETHODIMP
 nsProfiler::StopProfiler() {
   ResetGathering();
+  mInFieldMode = false;
 
   profiler_stop();
 
@@ -44,6 +44,9 @@ class nsProfiler final : public nsIProfiler, public nsIObserver {
   typedef mozilla::MozPromise<mozilla::SymbolTable, nsresult, true>
       SymbolTablePromise;
 
+  void StartFieldMode();
+  void DumpFieldModeProfile();
+
   RefPtr<GatheringPromise> StartGathering(double aSinceTime);
   void FinishGathering();
   void ResetGathering();
@@ -54,6 +57,11 @@ class nsProfiler final : public nsIProfiler, public nsIObserver {
 
   bool mLockedForPrivateBrowsing;
 
+  // Whether the running profiler was started by StartFieldMode(), and when
+  // it last saved a profile because of a hang.
+  bool mInFieldMode;
+  mozilla::TimeStamp mLastFieldModeDump;
+
   struct ExitProfile {
     nsCString mJSON;
     uint64_t mBufferPositionAtGatherTime;
@@ -122,8 +122,8 @@ struct JSContext;
     }
 
 // Match the conditions for MOZ_ENABLE_BACKGROUND_HANG_MONITOR
-#  if defined(NIGHTLY_BUILD) && !defined(MOZ_DEBUG) && !defined(MOZ_TSAN) && \
-      !defined(MOZ_ASAN)
+#  if (defined(NIGHTLY_BUILD) || defined(MOZ_WIDGET_GONK)) && \
+      !defined(MOZ_DEBUG) && !defined(MOZ_TSAN) && !defined(MOZ_ASAN)
 #    define SHOULD_CREATE_ALL_NONSENSITIVE_LABEL_FRAMES true
 #  else
 #    define SHOULD_CREATE_ALL_NONSENSITIVE_LABEL_FRAMES profiler_is_active()
@@ -23,7 +23,11 @@
 #include "base/basictypes.h"
 #include "libui/Input.h"
 #include "mozilla/ClearOnShutdown.h"
+#include "mozilla/Hal.h"
 #include "mozilla/Mutex.h"
+#include "mozilla/StaticPrefs_dom.h"
+#include "mozilla/StaticPrefs_gfx.h"
+#include "mozilla/Telemetry.h"
 #include "mozilla/TimeStamp.h"
 #include "mozilla/TouchEvents.h"
 #include "mozilla/dom/Touch.h"
@@ -31,9 +35,11 @@
 #include "mozilla/layers/CompositorBridgeParent.h"
 #include "nsAppShell.h"
 #include "nsDebug.h"
+#include "nsPrintfCString.h"
 #include "nsThreadUtils.h"
 #include "nsWindow.h"
 #include "mozilla/layers/CompositorVsyncScheduler.h"
+#include <cmath>
 #include <sys/types.h>
 #include <unistd.h>
 #include <utils/Timers.h>
@@ -64,7 +70,11 @@ GeckoTouchDispatcher::GeckoTouchDispatcher()
       mHavePendingTouchMoves(false),
       mInflightNonMoveEvents(0),
       mTouchEventsFiltered(false),
-      mMouseAvailable(false) {
+      mMouseAvailable(false),
+      mPredictionErrorSum(0.0),
+      mPredictionErrorCount(0),
+      mLatencyLock("GeckoTouchDispatcher::mLatencyLock"),
+      mLatencyCollector(this, &GeckoTouchDispatcher::GetLatencyInfo) {
   // Since GeckoTouchDispatcher is initialized when input is initialized
   // and reads gfxPrefs, it is the first thing to touch gfxPrefs.
   // The first thing to touch gfxPrefs MUST occur on the main thread and init
@@ -73,16 +83,21 @@ GeckoTouchDispatcher::GeckoTouchDispatcher()
   MOZ_ASSERT(NS_IsMainThread());
 
   mEnabledUniformityInfo = true; /* StaticPrefs::UniformityInfo(); */
-  mVsyncAdjust =
-      TimeDuration::FromMilliseconds(0 /*gfxPrefs::TouchVsyncSampleAdjust()*/);
-  mMaxPredict =
-      TimeDuration::FromMilliseconds(0 /*gfxPrefs::TouchResampleMaxPredict()*/);
-  mMinDelta =
-      TimeDuration::FromMilliseconds(0 /*gfxPrefs::TouchResampleMinDelta()*/);
+  mResamplingEnabled = StaticPrefs::gfx_touch_resample_enabled_AtStartup();
+  mVsyncAdjust = TimeDuration::FromMilliseconds(
+      StaticPrefs::gfx_touch_resample_vsync_adjust_AtStartup());
+  mMaxPredict = TimeDuration::FromMilliseconds(
+      StaticPrefs::gfx_touch_resample_max_predict_AtStartup());
+  mMinDelta = TimeDuration::FromMilliseconds(
+      StaticPrefs::gfx_touch_resample_min_delta_AtStartup());
   mOldTouchThreshold = TimeDuration::FromMilliseconds(
-      0 /*gfxPrefs::TouchResampleOldTouchThreshold()*/);
+      StaticPrefs::gfx_touch_resample_old_touch_threshold_AtStartup());
   mDelayedVsyncThreshold = TimeDuration::FromMilliseconds(
-      0 /*gfxPrefs::TouchResampleVsyncDelayThreshold()*/);
+      StaticPrefs::gfx_touch_resample_vsync_delay_threshold_AtStartup());
+  mPredictionEnabled = StaticPrefs::gfx_touch_resample_predict_enabled();
+  // We need at least three samples to estimate an acceleration.
+  mPredictionSamples = std::max<uint32_t>(
+      3, StaticPrefs::gfx_touch_resample_predict_samples_AtStartup());
 }
 
 void GeckoTouchDispatcher::SetCompositorVsyncScheduler(
@@ -91,16 +106,22 @@ void GeckoTouchDispatcher::SetCompositorVsyncScheduler(
   mCompositorVsyncScheduler = aObserver;
 }
 
-void GeckoTouchDispatcher::NotifyVsync(TimeStamp aVsyncTimestamp) {
+// aPresentTimestamp is when the frame composited for this vsync is expected
+// to be displayed. It is only used by the predictive resampling mode and may
+// be null, in which case the vsync time is used instead.
+void GeckoTouchDispatcher::NotifyVsync(TimeStamp aVsyncTimestamp,
+                                       TimeStamp aPresentTimestamp) {
   if (!layers::APZThreadUtils::IsControllerThread()){
     layers::APZThreadUtils::RunOnControllerThread(
-          NewRunnableMethod<TimeStamp>(
+          NewRunnableMethod<TimeStamp, TimeStamp>(
               "GonkTouch", this, &GeckoTouchDispatcher::NotifyVsync,
-              aVsyncTimestamp));
+              aVsyncTimestamp, aPresentTimestamp));
     return;
   }
   layers::APZThreadUtils::AssertOnControllerThread();
-  DispatchTouchMoveEvents(aVsyncTimestamp);
+  DispatchTouchMoveEvents(aVsyncTimestamp, aPresentTimestamp.IsNull()
+                                               ? aVsyncTimestamp
+                                               : aPresentTimestamp);
 }
 
 // Touch data timestamps are in milliseconds, aEventTime is in nanoseconds
@@ -110,6 +131,20 @@ void GeckoTouchDispatcher::NotifyTouch(MultiTouchInput& aTouch,
     mCompositorVsyncScheduler->SetNeedsComposite();
   }
 
+  // Get the CPU going before the touch even reaches the app. Moves keep the
+  // hint going while the user scrolls.
+  if (aTouch.mType == MultiTouchInput::MULTITOUCH_START ||
+      aTouch.mType == MultiTouchInput::MULTITOUCH_MOVE) {
+    uint32_t boostMs =
+        StaticPrefs::dom_ipc_processPriorityManager_inputBoostMS();
+    if (boostMs) {
+      if (aTouch.mType == MultiTouchInput::MULTITOUCH_START) {
+        hal::BoostForegroundProcesses(boostMs);
+      }
+      hal::NotifyPerformanceHint(hal::PERFORMANCE_HINT_INTERACTION, boostMs);
+    }
+  }
+
 // FIXME: why were we doing that???
 #if 0
   if (aTouch.mType == MultiTouchInput::MULTITOUCH_MOVE) {
@@ -138,6 +173,9 @@ void GeckoTouchDispatcher::NotifyTouch(MultiTouchInput& aTouch,
 
     mTouchMoveEvents.push_back(aTouch);
     mHavePendingTouchMoves = true;
+    if (mPredictionEnabled) {
+      RecordTouchMoveSample(aTouch);
+    }
   } else {
     {  // scope lock
       MutexAutoLock lock(mTouchQueueLock);
@@ -157,6 +195,7 @@ void GeckoTouchDispatcher::DispatchTouchNonMoveEvent(MultiTouchInput aInput) {
   // (DispatchTouchMoveEvents will check the mHavePendingTouchMoves flag and
   // bail out if there's nothing to be done).
   NotifyVsync(TimeStamp::Now());
+  RecordLatency(aInput.mTimeStamp, TimeStamp());
   DispatchTouchEvent(aInput);
 
   {  // scope lock
@@ -166,8 +205,11 @@ void GeckoTouchDispatcher::DispatchTouchNonMoveEvent(MultiTouchInput aInput) {
   }
 }
 
-void GeckoTouchDispatcher::DispatchTouchMoveEvents(TimeStamp aVsyncTime) {
+void GeckoTouchDispatcher::DispatchTouchMoveEvents(TimeStamp aVsyncTime,
+                                                   TimeStamp aPresentTime) {
   MultiTouchInput touchMove;
+  // The newest real touch this move is resampled from.
+  TimeStamp eventTime;
 
   {
     MutexAutoLock lock(mTouchQueueLock);
@@ -175,6 +217,7 @@ void GeckoTouchDispatcher::DispatchTouchMoveEvents(TimeStamp aVsyncTime) {
       return;
     }
     mHavePendingTouchMoves = false;
+    eventTime = mTouchMoveEvents.back().mTimeStamp;
 
     int touchCount = mTouchMoveEvents.size();
     TimeDuration vsyncTouchDiff =
@@ -183,9 +226,14 @@ void GeckoTouchDispatcher::DispatchTouchMoveEvents(TimeStamp aVsyncTime) {
     // vsync time is delayed from the touch, so add a negative sign.
     bool isDelayedVsyncEvent = vsyncTouchDiff < -mDelayedVsyncThreshold;
     bool isOldTouch = vsyncTouchDiff > mOldTouchThreshold;
-    bool resample = (touchCount > 1) && !isDelayedVsyncEvent && !isOldTouch;
-
-    if (!resample) {
+    bool resample = mResamplingEnabled && (touchCount > 1) &&
+                    !isDelayedVsyncEvent && !isOldTouch;
+
+    if (mPredictionEnabled && !isOldTouch) {
+      // The predictor keeps its own history, so it doesn't care about how
+      // many moves were queued since the last vsync.
+      PredictTouchMoves(touchMove, aPresentTime);
+    } else if (!resample) {
       touchMove = mTouchMoveEvents.back();
       mTouchMoveEvents.clear();
       if (!isDelayedVsyncEvent && !isOldTouch) {
@@ -201,6 +249,7 @@ void GeckoTouchDispatcher::DispatchTouchMoveEvents(TimeStamp aVsyncTime) {
     nsWindow::NotifyHoverMove(point);
   }
 
+  RecordLatency(eventTime, aPresentTime);
   DispatchTouchEvent(touchMove);
 }
 
@@ -323,6 +372,196 @@ void GeckoTouchDispatcher::ResampleTouchMoves(MultiTouchInput& aOutTouch,
   aOutTouch.mTimeStamp = sampleTime;
 }
 
+const GeckoTouchDispatcher::PointerSample&
+GeckoTouchDispatcher::PointerHistory::Newest() const {
+  MOZ_ASSERT(!mSamples.IsEmpty());
+  return mSamples[(mNext + mSamples.Length() - 1) % mSamples.Length()];
+}
+
+GeckoTouchDispatcher::PointerHistory* GeckoTouchDispatcher::GetPointerHistory(
+    int32_t aIdentifier) {
+  for (PointerHistory& history : mPointerHistories) {
+    if (history.mIdentifier == aIdentifier) {
+      return &history;
+    }
+  }
+  return nullptr;
+}
+
+void GeckoTouchDispatcher::RecordTouchMoveSample(
+    const MultiTouchInput& aTouch) {
+  mTouchQueueLock.AssertCurrentThreadOwns();
+
+  for (const SingleTouchData& touch : aTouch.mTouches) {
+    PointerHistory* history = GetPointerHistory(touch.mIdentifier);
+    if (!history) {
+      history = mPointerHistories.AppendElement();
+      history->mIdentifier = touch.mIdentifier;
+      history->mNext = 0;
+    }
+
+    // Check the last prediction against where the finger really was at the
+    // predicted time, interpolating between the samples around it.
+    if (!history->mPredictedTime.IsNull() &&
+        aTouch.mTimeStamp >= history->mPredictedTime) {
+      ScreenIntPoint actual = touch.mScreenPoint;
+      if (!history->mSamples.IsEmpty()) {
+        const PointerSample& prev = history->Newest();
+        TimeDuration touchDiff = aTouch.mTimeStamp - prev.mTime;
+        if (prev.mTime < history->mPredictedTime &&
+            touchDiff > TimeDuration()) {
+          TimeDuration frameDiff = history->mPredictedTime - prev.mTime;
+          actual.x = Interpolate(prev.mPoint.x, touch.mScreenPoint.x,
+                                 frameDiff, touchDiff);
+          actual.y = Interpolate(prev.mPoint.y, touch.mScreenPoint.y,
+                                 frameDiff, touchDiff);
+        }
+      }
+      ScreenIntPoint delta = actual - history->mPredictedPoint;
+      mPredictionErrorSum += std::hypot(delta.x, delta.y);
+      mPredictionErrorCount++;
+      history->mPredictedTime = TimeStamp();
+    }
+
+    PointerSample sample = {aTouch.mTimeStamp, touch.mScreenPoint};
+    if (history->mSamples.Length() < mPredictionSamples) {
+      history->mSamples.AppendElement(sample);
+    } else {
+      history->mSamples[history->mNext] = sample;
+    }
+    history->mNext = (history->mNext + 1) % mPredictionSamples;
+  }
+}
+
+// Fits x(t) = a + b * t + c * t^2 over the pointer history by least squares,
+// with t in milliseconds relative to the newest sample, and evaluates it at
+// aTarget. Falls back to a linear fit if the system is degenerate, e.g. when
+// we only have two samples.
+bool GeckoTouchDispatcher::Predict(const PointerHistory& aHistory,
+                                   TimeStamp aTarget,
+                                   ScreenIntPoint& aOutPoint) const {
+  size_t count = aHistory.mSamples.Length();
+  if (count < 2) {
+    return false;
+  }
+
+  const PointerSample& newest = aHistory.Newest();
+  double s[5] = {0, 0, 0, 0, 0};
+  double sx[3] = {0, 0, 0};
+  double sy[3] = {0, 0, 0};
+  TimeStamp oldest = newest.mTime;
+  for (const PointerSample& sample : aHistory.mSamples) {
+    double t = (sample.mTime - newest.mTime).ToMilliseconds();
+    double tk = 1.0;
+    for (int k = 0; k < 5; k++) {
+      s[k] += tk;
+      if (k < 3) {
+        sx[k] += sample.mPoint.x * tk;
+        sy[k] += sample.mPoint.y * tk;
+      }
+      tk *= t;
+    }
+    oldest = std::min(oldest, sample.mTime);
+  }
+
+  if (newest.mTime - oldest < mMinDelta) {
+    return false;
+  }
+
+  double h = (aTarget - newest.mTime).ToMilliseconds();
+  double x, y;
+  double det = s[0] * (s[2] * s[4] - s[3] * s[3]) -
+               s[1] * (s[1] * s[4] - s[3] * s[2]) +
+               s[2] * (s[1] * s[3] - s[2] * s[2]);
+  if (count >= 3 && std::abs(det) > 1e-6) {
+    auto solve = [&](const double* sv) {
+      double a = (sv[0] * (s[2] * s[4] - s[3] * s[3]) -
+                  s[1] * (sv[1] * s[4] - s[3] * sv[2]) +
+                  s[2] * (sv[1] * s[3] - s[2] * sv[2])) /
+                 det;
+      double b = (s[0] * (sv[1] * s[4] - s[3] * sv[2]) -
+                  sv[0] * (s[1] * s[4] - s[3] * s[2]) +
+                  s[2] * (s[1] * sv[2] - sv[1] * s[2])) /
+                 det;
+      double c = (s[0] * (s[2] * sv[2] - sv[1] * s[3]) -
+                  s[1] * (s[1] * sv[2] - sv[1] * s[2]) +
+                  sv[0] * (s[1] * s[3] - s[2] * s[2])) /
+                 det;
+      return a + b * h + c * h * h;
+    };
+    x = solve(sx);
+    y = solve(sy);
+  } else {
+    double det2 = s[0] * s[2] - s[1] * s[1];
+    if (std::abs(det2) < 1e-6) {
+      return false;
+    }
+    auto solve = [&](const double* sv) {
+      double a = (sv[0] * s[2] - s[1] * sv[1]) / det2;
+      double b = (s[0] * sv[1] - s[1] * sv[0]) / det2;
+      return a + b * h;
+    };
+    x = solve(sx);
+    y = solve(sy);
+  }
+
+  aOutPoint.x = int32_t(std::round(x));
+  aOutPoint.y = int32_t(std::round(y));
+  return true;
+}
+
+void GeckoTouchDispatcher::PredictTouchMoves(MultiTouchInput& aOutTouch,
+                                             TimeStamp aPresentTime) {
+  mTouchQueueLock.AssertCurrentThreadOwns();
+
+  MultiTouchInput currentTouch = mTouchMoveEvents.back();
+  mTouchMoveEvents.clear();
+  mTouchMoveEvents.push_back(currentTouch);
+  aOutTouch = currentTouch;
+
+  if (aPresentTime <= currentTouch.mTimeStamp) {
+    // The touch is already newer than the frame it will show up in.
+    return;
+  }
+
+  TimeStamp sampleTime = std::min(
+      aPresentTime,
+      currentTouch.mTimeStamp +
+          TimeDuration::FromMilliseconds(
+              StaticPrefs::gfx_touch_resample_predict_max_predict_AtStartup()));
+
+  for (SingleTouchData& touch : aOutTouch.mTouches) {
+    PointerHistory* history = GetPointerHistory(touch.mIdentifier);
+    ScreenIntPoint predicted;
+    if (!history || !Predict(*history, sampleTime, predicted)) {
+      continue;
+    }
+#ifdef LOG_RESAMPLE_DATA
+    LOG("predict (%d, %d) to (%d, %d), %d ms ahead\n", touch.mScreenPoint.x,
+        touch.mScreenPoint.y, predicted.x, predicted.y,
+        (int)(sampleTime - currentTouch.mTimeStamp).ToMilliseconds());
+#endif
+    touch.mScreenPoint = predicted;
+    history->mPredictedTime = sampleTime;
+    history->mPredictedPoint = predicted;
+  }
+
+  aOutTouch.mTime += (sampleTime - aOutTouch.mTimeStamp).ToMilliseconds();
+  aOutTouch.mTimeStamp = sampleTime;
+}
+
+void GeckoTouchDispatcher::ReportPredictionError() {
+  mTouchQueueLock.AssertCurrentThreadOwns();
+
+  if (mPredictionErrorCount) {
+    Telemetry::Accumulate(
+        Telemetry::TOUCH_RESAMPLE_PREDICTION_ERROR_PX,
+        uint32_t(std::round(mPredictionErrorSum / mPredictionErrorCount)));
+  }
+  mPredictionErrorSum = 0.0;
+  mPredictionErrorCount = 0;
+}
+
 static bool IsExpired(const MultiTouchInput& aTouch) {
   // No pending events, the filter state can be updated.
   uint64_t timeNowMs = systemTime(SYSTEM_TIME_MONOTONIC) / 1000000;
@@ -366,6 +605,50 @@ void GeckoTouchDispatcher::DispatchTouchEvent(MultiTouchInput aMultiTouch) {
   }
 }
 
+void GeckoTouchDispatcher::LatencyWindow::Add(float aMs) {
+  mSamples[mNext] = aMs;
+  mNext = (mNext + 1) % kSize;
+  mCount = std::min(mCount + 1, kSize);
+}
+
+void GeckoTouchDispatcher::LatencyWindow::Describe(widget::InfoObject& aObj,
+                                                   const char* aName) const {
+  if (!mCount) {
+    return;
+  }
+
+  float sum = 0;
+  float max = 0;
+  for (uint32_t i = 0; i < mCount; i++) {
+    sum += mSamples[i];
+    max = std::max(max, mSamples[i]);
+  }
+  nsPrintfCString value("avg %.1f ms, max %.1f ms over the last %u touches",
+                        sum / mCount, max, mCount);
+  aObj.DefineProperty(aName, value.get());
+}
+
+void GeckoTouchDispatcher::RecordLatency(TimeStamp aEventTime,
+                                         TimeStamp aPresentTime) {
+  layers::APZThreadUtils::AssertOnControllerThread();
+
+  if (aEventTime.IsNull()) {
+    return;
+  }
+
+  MutexAutoLock lock(mLatencyLock);
+  mToApzLatency.Add((TimeStamp::Now() - aEventTime).ToMilliseconds());
+  if (!aPresentTime.IsNull()) {
+    mToPresentLatency.Add((aPresentTime - aEventTime).ToMilliseconds());
+  }
+}
+
+void GeckoTouchDispatcher::GetLatencyInfo(widget::InfoObject& aObj) {
+  MutexAutoLock lock(mLatencyLock);
+  mToApzLatency.Describe(aObj, "TouchLatencyToAPZ");
+  mToPresentLatency.Describe(aObj, "TouchLatencyToPresent");
+}
+
 void GeckoTouchDispatcher::SetMouseDevice(bool aMouseAvailable) {
   mMouseAvailable = aMouseAvailable;
   nsWindow::SetMouseDevice(aMouseAvailable);
@@ -18,11 +18,14 @@
 #ifndef GECKO_TOUCH_INPUT_DISPATCHER_h
 #define GECKO_TOUCH_INPUT_DISPATCHER_h
 
+#include "GfxInfoCollector.h"
 #include "InputData.h"
 #include "Units.h"
 #include "mozilla/Mutex.h"
 #include <vector>
 #include "mozilla/RefPtr.h"
+#include "mozilla/TimeStamp.h"
+#include "nsTArray.h"
 
 class nsIWidget;
 
@@ -41,18 +44,37 @@ class CompositorVsyncScheduler;
 // occurs BEFORE this sample time, we extrapolate the last two touch events to
 // the sample time. The magic numbers defined as constants are taken from
 // android InputTransport.cpp.
+//
+// When gfx.touch.resample.predict.enabled is set, a predictive mode is used
+// instead. Each pointer keeps a short history of samples and we fit a
+// second order polynomial (position, velocity, acceleration) over it by least
+// squares. The fit is evaluated at the time the frame is expected to hit the
+// screen, as reported by the vsync output time, rather than at the vsync
+// itself. The distance between each predicted point and the position the
+// finger actually reached is accumulated per gesture and reported to
+// telemetry when the gesture ends.
+//
+// For every dispatched touch we also record how long it took from the kernel
+// timestamp of the input event to reach APZ, and for moves, to the expected
+// presentation time of the frame it was sampled for. The figures for the
+// most recent touches are listed in about:support.
 class GeckoTouchDispatcher final {
   NS_INLINE_DECL_THREADSAFE_REFCOUNTING(GeckoTouchDispatcher)
 
+  // Drives the resampling code directly, see widget/gonk/tests/gtest.
+  friend class GeckoTouchDispatcherBench;
+
  public:
   static GeckoTouchDispatcher* GetInstance();
   void NotifyTouch(MultiTouchInput& aTouch, TimeStamp aEventTime);
   void DispatchTouchEvent(MultiTouchInput aMultiTouch);
   void DispatchTouchNonMoveEvent(MultiTouchInput aInput);
-  void DispatchTouchMoveEvents(TimeStamp aVsyncTime);
-  void NotifyVsync(TimeStamp aVsyncTimestamp);
+  void DispatchTouchMoveEvents(TimeStamp aVsyncTime, TimeStamp aPresentTime);
+  void NotifyVsync(TimeStamp aVsyncTimestamp,
+                   TimeStamp aPresentTimestamp = TimeStamp());
   void SetCompositorVsyncScheduler(layers::CompositorVsyncScheduler* aObserver);
   void SetMouseDevice(bool aMouseAvailable);
+  void GetLatencyInfo(widget::InfoObject& aObj);
 
  protected:
   ~GeckoTouchDispatcher() {}
@@ -60,9 +82,13 @@ class GeckoTouchDispatcher final {
  private:
   GeckoTouchDispatcher();
   void ResampleTouchMoves(MultiTouchInput& aOutTouch, TimeStamp vsyncTime);
+  void PredictTouchMoves(MultiTouchInput& aOutTouch, TimeStamp aPresentTime);
+  void RecordTouchMoveSample(const MultiTouchInput& aTouch);
+  void ReportPredictionError();
   void SendTouchEvent(MultiTouchInput& aData);
   void DispatchMouseEvent(MultiTouchInput& aMultiTouch,
                           bool aForwardToChildren);
+  void RecordLatency(TimeStamp aEventTime, TimeStamp aPresentTime);
 
   // mTouchQueueLock is used to protect the vector and state below
   // as it is accessed on multiple threads.
@@ -98,6 +124,55 @@ class GeckoTouchDispatcher final {
   TimeDuration mOldTouchThreshold;
 
   RefPtr<layers::CompositorVsyncScheduler> mCompositorVsyncScheduler;
+
+  // State for the predictive resampling mode, protected by mTouchQueueLock.
+  struct PointerSample {
+    TimeStamp mTime;
+    ScreenIntPoint mPoint;
+  };
+
+  struct PointerHistory {
+    int32_t mIdentifier;
+    // Ring buffer of the most recent samples, mNext is the slot that will be
+    // overwritten by the next sample.
+    nsTArray<PointerSample> mSamples;
+    size_t mNext;
+    // The last prediction we made for this pointer, checked against the
+    // real position once a sample at or after mPredictedTime comes in.
+    TimeStamp mPredictedTime;
+    ScreenIntPoint mPredictedPoint;
+
+    const PointerSample& Newest() const;
+  };
+
+  PointerHistory* GetPointerHistory(int32_t aIdentifier);
+  bool Predict(const PointerHistory& aHistory, TimeStamp aTarget,
+               ScreenIntPoint& aOutPoint) const;
+
+  bool mPredictionEnabled;
+  size_t mPredictionSamples;
+  nsTArray<PointerHistory> mPointerHistories;
+  // Sum of the prediction errors in pixels and the number of predictions that
+  // were checked for the current gesture.
+  double mPredictionErrorSum;
+  uint32_t mPredictionErrorCount;
+
+  // Latencies in ms of the most recent touches. Written on the controller
+  // thread and read on the main thread, protected by mLatencyLock.
+  struct LatencyWindow {
+    static constexpr uint32_t kSize = 128;
+    float mSamples[kSize];
+    uint32_t mCount = 0;
+    uint32_t mNext = 0;
+
+    void Add(float aMs);
+    void Describe(widget::InfoObject& aObj, const char* aName) const;
+  };
+
+  Mutex mLatencyLock;
+  LatencyWindow mToApzLatency;
+  LatencyWindow mToPresentLatency;
+  widget::GfxInfoCollector<GeckoTouchDispatcher> mLatencyCollector;
 };
 
 }  // namespace mozilla
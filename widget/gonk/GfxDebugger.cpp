@@ -18,6 +18,7 @@
 
 #include "GfxDebugger.h"
 #include "GonkScreenshot.h"
+#include "HwcComposer2D.h"
 #include "mozilla/layers/LayerManagerComposite.h"
 #include "mozilla/layers/CompositorBridgeParent.h"
 #include "mozilla/layers/SharedBufferManagerParent.h"
@@ -362,6 +363,35 @@ void GfxDebugger::ReceiveSocketData(int aIndex,
       } // case GD_CMD_SCREENCAP
       break;
 
+      case GD_CMD_HWC: {
+        uint32_t op = parcel.readUint32();
+        aBuffer->Consume(usb->GetSize());
+
+        switch (op) {
+          case HWC_OP_PLAN_CACHE_STATS: {
+            uint32_t hits, misses;
+            HwcComposer2D::GetInstance()->GetPlanCacheStats(&hits, &misses);
+
+            Parcel reply;
+            reply.writeUint32(hits);
+            reply.writeUint32(misses);
+            GD_LOGD("hwc plan cache: %u hits, %u misses", hits, misses);
+            write(mConnector->mStreamFd, reply.data(), reply.dataSize());
+            break;
+          }
+
+          case HWC_OP_PLAN_CACHE_RESET: {
+            HwcComposer2D::GetInstance()->ResetPlanCacheStats();
+
+            Parcel reply;
+            reply.writeUint32(0);
+            write(mConnector->mStreamFd, reply.data(), reply.dataSize());
+            break;
+          }
+        }
+      } // case GD_CMD_HWC
+      break;
+
       default:
         GD_LOGE("Unknown command: %d", cmd);
         break;
@@ -6,6 +6,7 @@ enum {
   GD_CMD_SCREENCAP,
   GD_CMD_LAYER,
   GD_CMD_APZ,
+  GD_CMD_HWC,
 
   GD_ERR,
 };
@@ -14,6 +15,8 @@ enum {
   GRALLOC_OP_LIST,
   GRALLOC_OP_DUMP,
   SCREENCAP_OP_CAPTURE,
+  HWC_OP_PLAN_CACHE_STATS,
+  HWC_OP_PLAN_CACHE_RESET,
 
   OP_ERR,
 };
@@ -13,18 +13,29 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
+
+#include "GonkMemoryPressureMonitoring.h"
 #include "nsIObserverService.h"
 #include "nsIThread.h"
+#include "nsPrintfCString.h"
 #include "nsThreadUtils.h"
+#include "nsXULAppAPI.h"
 #include "mozilla/Assertions.h"
 #include "mozilla/DebugOnly.h"
 #include "mozilla/Services.h"
+#include "mozilla/StaticPrefs_widget.h"
+#include "mozilla/TimeStamp.h"
 
 #define LOG(args...) \
   __android_log_print(ANDROID_LOG_INFO, "GonkMemoryPressure", ##args)
 
 namespace {
 
+using mozilla::MemoryPressureLevel;
+using mozilla::TimeDuration;
+using mozilla::TimeStamp;
+
 /**
  * Watch on /dev/socket/kickgccc socket to receive memory pressure events.
  *
@@ -32,12 +43,20 @@ namespace {
  * /dev/socket/kickgccc, and the isntance of this class will notify
  * the observers of the "memory-pressure" topic, including GC & CC, to
  * reclaim memory.
+ *
+ * In the parent process, it also installs PSI triggers on
+ * /proc/pressure/memory, one per MemoryPressureLevel, so that we can react
+ * in steps before b2gkillerd or the LMK have to. The notifications sent for
+ * each level are described in GonkMemoryPressureMonitoring.h. Children get
+ * them through ContentParent forwarding "memory-pressure", so they don't
+ * need their own triggers.
  */
 class MemoryPressureWatcher final : public nsIRunnable {
   static constexpr char kKickSocketPath[] = "/dev/socket/kickgccc";
+  static constexpr char kPsiMemoryPath[] = "/proc/pressure/memory";
 
  public:
-  MemoryPressureWatcher() {
+  explicit MemoryPressureWatcher(bool aWatchPsi) {
     // Remove the socket if there is, or the address can't be reused.
     unlink(kKickSocketPath);
 
@@ -49,41 +68,183 @@ class MemoryPressureWatcher final : public nsIRunnable {
     mozilla::DebugOnly<int> r =
         bind(mServerFd, (struct sockaddr*)&addr, sizeof(addr));
     MOZ_ASSERT(r == 0, "can't bind to kickgccc socket");
+
+    for (int& fd : mPsiFds) {
+      fd = -1;
+    }
+    if (aWatchPsi) {
+      uint32_t windowMs = mozilla::StaticPrefs::
+          widget_gonk_memory_pressure_psi_window_ms_AtStartup();
+      mWindow = TimeDuration::FromMilliseconds(windowMs);
+      OpenPsiTrigger(
+          MemoryPressureLevel::Low, "some",
+          mozilla::StaticPrefs::
+              widget_gonk_memory_pressure_psi_low_stall_ms_AtStartup(),
+          windowMs);
+      OpenPsiTrigger(
+          MemoryPressureLevel::Moderate, "some",
+          mozilla::StaticPrefs::
+              widget_gonk_memory_pressure_psi_moderate_stall_ms_AtStartup(),
+          windowMs);
+      OpenPsiTrigger(
+          MemoryPressureLevel::Critical, "full",
+          mozilla::StaticPrefs::
+              widget_gonk_memory_pressure_psi_critical_stall_ms_AtStartup(),
+          windowMs);
+    }
   }
 
   NS_DECL_THREADSAFE_ISUPPORTS
 
   NS_IMETHOD Run() override {
     MOZ_ASSERT(!NS_IsMainThread());
+
+    // Slot 0 is the kickgccc socket, the rest are the PSI triggers indexed
+    // by level.
+    struct pollfd fds[1 + kNumLevels];
+    nfds_t nfds = 0;
+    MemoryPressureLevel levels[1 + kNumLevels];
+    fds[nfds].fd = mServerFd;
+    fds[nfds].events = POLLIN;
+    nfds++;
+    for (size_t i = 0; i < kNumLevels; i++) {
+      if (mPsiFds[i] >= 0) {
+        fds[nfds].fd = mPsiFds[i];
+        fds[nfds].events = POLLPRI;
+        levels[nfds] = MemoryPressureLevel(i);
+        nfds++;
+      }
+    }
+
     while (true) {
-      char buf[128];
-      mozilla::DebugOnly<int> sz = recv(mServerFd, buf, 128, 0);
-      MOZ_ASSERT(sz == sizeof(int), "invalid message size");
-      // The content of the message is a pid.  It is not used now, but
-      // will be used to specify which process to notify later.
-      MOZ_ASSERT(*(int*)buf == getpid(), "invalid PID");
-      nsCOMPtr<nsIRunnable> notify = mozilla::NewRunnableMethod(
-          "NotifyMemoryPressure", this,
-          &MemoryPressureWatcher::NotifyMemoryPressure);
-      NS_DispatchToMainThread(notify);
+      int ret = poll(fds, nfds, -1);
+      if (ret < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        LOG("poll() failed: %s", strerror(errno));
+        return NS_OK;
+      }
+
+      if (fds[0].revents & POLLIN) {
+        char buf[128];
+        mozilla::DebugOnly<int> sz = recv(mServerFd, buf, 128, 0);
+        MOZ_ASSERT(sz == sizeof(int), "invalid message size");
+        // The content of the message is a pid.  It is not used now, but
+        // will be used to specify which process to notify later.
+        MOZ_ASSERT(*(int*)buf == getpid(), "invalid PID");
+        Dispatch(MemoryPressureLevel::Moderate);
+      }
+
+      // Only report the most severe level that fired in this round; the
+      // lower ones are implied by it.
+      int worst = -1;
+      for (nfds_t i = 1; i < nfds; i++) {
+        if (fds[i].revents & POLLERR) {
+          // The trigger is gone (e.g. the cgroup was removed); stop polling
+          // it rather than spinning.
+          LOG("PSI trigger for level %d failed, disabling it",
+              int(levels[i]));
+          fds[i].fd = -1;
+        } else if (fds[i].revents & POLLPRI) {
+          worst = std::max(worst, int(levels[i]));
+        }
+      }
+      if (worst >= 0) {
+        Dispatch(MemoryPressureLevel(worst));
+      }
     }
     return NS_OK;
   }
 
  private:
-  ~MemoryPressureWatcher() {}
+  static constexpr size_t kNumLevels = size_t(MemoryPressureLevel::Critical) + 1;
+
+  ~MemoryPressureWatcher() {
+    for (int fd : mPsiFds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+
+  void OpenPsiTrigger(MemoryPressureLevel aLevel, const char* aKind,
+                      uint32_t aStallMs, uint32_t aWindowMs) {
+    if (!aStallMs || aStallMs >= aWindowMs) {
+      return;
+    }
 
-  void NotifyMemoryPressure() {
+    int fd = open(kPsiMemoryPath, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+      // Kernels before 4.20, or built without CONFIG_PSI.
+      LOG("PSI is not available: %s", strerror(errno));
+      return;
+    }
+
+    // The trigger format is "<some|full> <stall us> <window us>".
+    nsPrintfCString trigger("%s %u %u", aKind, aStallMs * 1000,
+                            aWindowMs * 1000);
+    if (write(fd, trigger.get(), trigger.Length() + 1) < 0) {
+      LOG("Failed to set PSI trigger '%s': %s", trigger.get(),
+          strerror(errno));
+      close(fd);
+      return;
+    }
+    mPsiFds[size_t(aLevel)] = fd;
+  }
+
+  // Called on the watcher thread.
+  void Dispatch(MemoryPressureLevel aLevel) {
+    nsCOMPtr<nsIRunnable> notify =
+        mozilla::NewRunnableMethod<MemoryPressureLevel>(
+            "NotifyMemoryPressure", this,
+            &MemoryPressureWatcher::NotifyMemoryPressure, aLevel);
+    NS_DispatchToMainThread(notify);
+  }
+
+  void NotifyMemoryPressure(MemoryPressureLevel aLevel) {
     nsCOMPtr<nsIObserverService> os = mozilla::services::GetObserverService();
-    if (os) {
-      os->NotifyObservers(nullptr, "memory-pressure", u"low-memory");
-      LOG("The observers of 'memory-pressure' are notified.");
-    } else {
+    if (!os) {
       NS_WARNING("Can't get observer service!");
+      return;
+    }
+
+    // Triggers keep firing once per window while the stall lasts. Tell the
+    // observers that it is the same episode, so they can skip the costly
+    // parts (see nsIMemory.idl).
+    TimeStamp now = TimeStamp::Now();
+    bool ongoing = !mLastNotification.IsNull() &&
+                   aLevel <= mLastLevel &&
+                   now - mLastNotification < mWindow * 2;
+    mLastNotification = now;
+    mLastLevel = aLevel;
+
+    switch (aLevel) {
+      case MemoryPressureLevel::Low:
+        if (!ongoing) {
+          os->NotifyObservers(nullptr, "memory-pressure", u"heap-minimize");
+        }
+        break;
+      case MemoryPressureLevel::Moderate:
+        os->NotifyObservers(nullptr, "memory-pressure",
+                            ongoing ? u"low-memory-ongoing" : u"low-memory");
+        break;
+      case MemoryPressureLevel::Critical:
+        os->NotifyObservers(nullptr, "memory-pressure",
+                            ongoing ? u"low-memory-ongoing" : u"low-memory");
+        os->NotifyObservers(nullptr, GONK_MEMORY_PRESSURE_CRITICAL_TOPIC,
+                            nullptr);
+        break;
     }
+    LOG("The observers of 'memory-pressure' are notified (level %d%s).",
+        int(aLevel), ongoing ? ", ongoing" : "");
   }
 
   int mServerFd;
+  int mPsiFds[kNumLevels];
+  TimeDuration mWindow;
+  TimeStamp mLastNotification;
+  MemoryPressureLevel mLastLevel = MemoryPressureLevel::Low;
 };
 
 NS_IMPL_ISUPPORTS(MemoryPressureWatcher, nsIRunnable);
@@ -93,8 +254,10 @@ NS_IMPL_ISUPPORTS(MemoryPressureWatcher, nsIRunnable);
 namespace mozilla {
 
 void InitGonkMemoryPressureMonitoring() {
+  bool watchPsi = XRE_IsParentProcess() &&
+                  StaticPrefs::widget_gonk_memory_pressure_psi_enabled_AtStartup();
   RefPtr<MemoryPressureWatcher> memoryPressureWatcher =
-      new MemoryPressureWatcher();
+      new MemoryPressureWatcher(watchPsi);
   nsCOMPtr<nsIThread> thread;
   NS_NewNamedThread("MemoryPressure", getter_AddRefs(thread),
                     memoryPressureWatcher);
@@ -7,7 +7,34 @@
 #ifndef __mozilla_GonkMemeoryMonitoring_h_
 #define __mozilla_GonkMemeoryMonitoring_h_
 
+#include <stdint.h>
+
+/**
+ * Observer topic fired, after "memory-pressure", when the system reaches
+ * MemoryPressureLevel::Critical. ProcessPriorityManager reacts to it by
+ * killing a background process.
+ */
+#define GONK_MEMORY_PRESSURE_CRITICAL_TOPIC "gonk-memory-pressure-critical"
+
 namespace mozilla {
+
+/**
+ * Graded memory pressure, from PSI triggers.
+ *
+ * Low: "memory-pressure" / "heap-minimize", flush caches.
+ * Moderate: "memory-pressure" / "low-memory", also GC & CC. This is what a
+ *   kickgccc event from b2gkillerd maps to.
+ * Critical: as Moderate, followed by GONK_MEMORY_PRESSURE_CRITICAL_TOPIC.
+ *
+ * Repeated Moderate and Critical notifications within the same episode use
+ * "low-memory-ongoing" instead of "low-memory".
+ */
+enum class MemoryPressureLevel : uint8_t {
+  Low,
+  Moderate,
+  Critical,
+};
+
 void InitGonkMemoryPressureMonitoring();
 }
 
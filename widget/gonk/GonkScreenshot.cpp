@@ -32,7 +32,19 @@
 #include <system/graphics.h>
 
 #include "GonkScreenshot.h"
+#include "imgIEncoder.h"
+#include "libdisplay/GonkColorConvert.h"
 #include "libdisplay/GonkDisplay.h"
+#include "mozilla/ClearOnShutdown.h"
+#include "mozilla/EndianUtils.h"
+#include "mozilla/ErrorResult.h"
+#include "mozilla/StaticPtr.h"
+#include "mozilla/UniquePtr.h"
+#include "mozilla/dom/MemoryBlobImpl.h"
+#include "nsComponentManagerUtils.h"
+#include "nsIInputStream.h"
+#include "nsNetUtil.h"
+#include "nsThreadUtils.h"
 #include "png.h"
 
 using namespace android;
@@ -120,14 +132,8 @@ static uint32_t encodeToPng(FILE *dstFp, uint32_t w, uint32_t h,
             png_bytep src_pointer = (png_bytep)srcPtr +
                 (i * s * bytesPerPixel(f));
             // convert RGB565 to RGB888 for a row.
-            for (size_t j=0; j<w; j++) {
-                row_pointer[j * png_bytes_pixel] = *(src_pointer + 1);
-                row_pointer[j * png_bytes_pixel + 1] =
-                    (*(src_pointer + 1) & 0x07) << 5 |
-                    (*src_pointer & 0xe0) >> 3;
-                row_pointer[j * png_bytes_pixel + 2] = (*src_pointer) << 3;
-                src_pointer += 2;
-            }
+            mozilla::gonk::ConvertRGB565ToRGB888(src_pointer,
+                s * bytesPerPixel(f), row_pointer, w * png_bytes_pixel, w, 1);
             png_write_row(png_ptr, row_pointer);
         }
 
@@ -150,6 +156,73 @@ static uint32_t encodeToPng(FILE *dstFp, uint32_t w, uint32_t h,
 
 namespace mozilla {
 
+using dom::BlobImpl;
+using dom::MemoryBlobImpl;
+
+// In-memory captures are stored as a top-down BMP: a WinBMPv3 header
+// followed by BITFIELDS masks, so both framebuffer formats can be copied
+// byte for byte and still be decoded by any image consumer.
+static const uint32_t kBmpFileHeaderSize = 14;
+static const uint32_t kBmpInfoHeaderSize = 40;
+static const uint32_t kBmpBitFieldsSize = 12;
+static const uint32_t kBmpDataOffset =
+    kBmpFileHeaderSize + kBmpInfoHeaderSize + kBmpBitFieldsSize;
+static const uint32_t kBmpCompressionBitFields = 3;
+
+static StaticRefPtr<nsISerialEventTarget> sEncodeQueue;
+
+static uint32_t bmpRowSize(uint32_t w, uint32_t bpp)
+{
+    return (w * bpp + 3) & ~3u;
+}
+
+static void writeBmpHeader(uint8_t* dst, uint32_t w, uint32_t h,
+    uint32_t f, uint32_t imageSize)
+{
+    uint32_t bpp = bytesPerPixel(f);
+    uint32_t redMask, greenMask, blueMask;
+    if (f == HAL_PIXEL_FORMAT_RGB_565) {
+        redMask = 0xF800;
+        greenMask = 0x07E0;
+        blueMask = 0x001F;
+    } else if (f == HAL_PIXEL_FORMAT_BGRA_8888) {
+        redMask = 0x00FF0000;
+        greenMask = 0x0000FF00;
+        blueMask = 0x000000FF;
+    } else {
+        redMask = 0x000000FF;
+        greenMask = 0x0000FF00;
+        blueMask = 0x00FF0000;
+    }
+
+    // File header.
+    dst[0] = 'B';
+    dst[1] = 'M';
+    LittleEndian::writeUint32(dst + 2, kBmpDataOffset + imageSize);
+    LittleEndian::writeUint32(dst + 6, 0);
+    LittleEndian::writeUint32(dst + 10, kBmpDataOffset);
+
+    // Info header. A negative height makes the rows top-down, which is the
+    // order the framebuffer is in.
+    uint8_t* info = dst + kBmpFileHeaderSize;
+    LittleEndian::writeUint32(info, kBmpInfoHeaderSize);
+    LittleEndian::writeInt32(info + 4, int32_t(w));
+    LittleEndian::writeInt32(info + 8, -int32_t(h));
+    LittleEndian::writeUint16(info + 12, 1);
+    LittleEndian::writeUint16(info + 14, bpp * 8);
+    LittleEndian::writeUint32(info + 16, kBmpCompressionBitFields);
+    LittleEndian::writeUint32(info + 20, imageSize);
+    LittleEndian::writeInt32(info + 24, 2835);  // 72 dpi
+    LittleEndian::writeInt32(info + 28, 2835);
+    LittleEndian::writeUint32(info + 32, 0);
+    LittleEndian::writeUint32(info + 36, 0);
+
+    uint8_t* masks = info + kBmpInfoHeaderSize;
+    LittleEndian::writeUint32(masks, redMask);
+    LittleEndian::writeUint32(masks + 4, greenMask);
+    LittleEndian::writeUint32(masks + 8, blueMask);
+}
+
 int GonkScreenshot::capture(uint32_t displayId, const char* fileName)
 {
     bool png = false;
@@ -223,4 +296,189 @@ int GonkScreenshot::capture(uint32_t displayId, const char* fileName)
     return 0;
 }
 
+already_AddRefed<BlobImpl> GonkScreenshot::captureToBlob(uint32_t displayId)
+{
+    sp<GraphicBuffer> outBuffer = GetGonkDisplay()->GetFrameBuffer(
+        (DisplayType)displayId);
+    if (!outBuffer) {
+        GS_LOGE("Failed to GetFrameBuffer from GonkDisplay\n");
+        return nullptr;
+    }
+
+    uint32_t w = outBuffer->getWidth();
+    uint32_t h = outBuffer->getHeight();
+    uint32_t s = outBuffer->getStride();
+    uint32_t f = outBuffer->getPixelFormat();
+    if (f != HAL_PIXEL_FORMAT_RGB_565 && f != HAL_PIXEL_FORMAT_RGBA_8888 &&
+        f != HAL_PIXEL_FORMAT_RGBX_8888 && f != HAL_PIXEL_FORMAT_BGRA_8888) {
+        GS_LOGE("Unsupport color format %d\n", f);
+        return nullptr;
+    }
+
+    uint32_t Bpp = bytesPerPixel(f);
+    uint32_t rowSize = bmpRowSize(w, Bpp);
+    uint32_t imageSize = rowSize * h;
+    uint8_t* data = static_cast<uint8_t*>(malloc(kBmpDataOffset + imageSize));
+    if (!data) {
+        GS_LOGE("Failed to allocate %u bytes for screenshot\n",
+            kBmpDataOffset + imageSize);
+        return nullptr;
+    }
+
+    void* base = nullptr;
+    status_t result = outBuffer->lock(
+        GraphicBuffer::USAGE_SW_READ_OFTEN, &base);
+    if (base == nullptr || result != NO_ERROR) {
+        GS_LOGE("Failed to take screenshot (Error Code: %d)\n", result);
+        free(data);
+        return nullptr;
+    }
+
+    writeBmpHeader(data, w, h, f, imageSize);
+
+    // This is the only pass over the pixels; the gralloc buffer is handed
+    // back to the display as soon as it is done.
+    uint8_t* dst = data + kBmpDataOffset;
+    const uint8_t* src = static_cast<const uint8_t*>(base);
+    if (s * Bpp == rowSize) {
+        memcpy(dst, src, imageSize);
+    } else {
+        for (size_t i=0; i<h; i++) {
+            memcpy(dst, src, w * Bpp);
+            dst += rowSize;
+            src += s * Bpp;
+        }
+    }
+    outBuffer->unlock();
+
+    RefPtr<BlobImpl> blob = new MemoryBlobImpl(data,
+        kBmpDataOffset + imageSize, u"image/bmp"_ns);
+    return blob.forget();
+}
+
+// Runs on the encode task queue.
+static nsresult encodeBmpToBlob(BlobImpl* aCapture, const nsACString& aType,
+    RefPtr<BlobImpl>* aResult)
+{
+    ErrorResult err;
+    uint64_t size = aCapture->GetSize(err);
+    if (NS_WARN_IF(err.Failed())) {
+        return err.StealNSResult();
+    }
+    if (size < kBmpDataOffset) {
+        return NS_ERROR_INVALID_ARG;
+    }
+
+    nsCOMPtr<nsIInputStream> input;
+    aCapture->CreateInputStream(getter_AddRefs(input), err);
+    if (NS_WARN_IF(err.Failed())) {
+        return err.StealNSResult();
+    }
+
+    void* raw = nullptr;
+    nsresult rv = NS_ReadInputStreamToBuffer(input, &raw, size);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+        return rv;
+    }
+    UniquePtr<uint8_t, FreePolicy<uint8_t>> bmp(static_cast<uint8_t*>(raw));
+
+    const uint8_t* info = bmp.get() + kBmpFileHeaderSize;
+    if (bmp.get()[0] != 'B' || bmp.get()[1] != 'M' ||
+        LittleEndian::readUint32(bmp.get() + 10) != kBmpDataOffset ||
+        LittleEndian::readUint32(info + 16) != kBmpCompressionBitFields) {
+        // Not one of ours.
+        return NS_ERROR_INVALID_ARG;
+    }
+    uint32_t w = LittleEndian::readInt32(info + 4);
+    uint32_t h = -LittleEndian::readInt32(info + 8);
+    uint32_t Bpp = LittleEndian::readUint16(info + 14) / 8;
+    uint32_t redMask = LittleEndian::readUint32(info + kBmpInfoHeaderSize);
+    uint32_t rowSize = bmpRowSize(w, Bpp);
+    if (uint64_t(rowSize) * h + kBmpDataOffset > size) {
+        return NS_ERROR_INVALID_ARG;
+    }
+    uint8_t* pixels = bmp.get() + kBmpDataOffset;
+
+    UniquePtr<uint8_t[]> rgb;
+    uint32_t inputFormat, stride;
+    if (Bpp == 2) {
+        // The encoders don't take 565, so expand it once here.
+        stride = w * 3;
+        rgb = MakeUnique<uint8_t[]>(stride * h);
+        if (!gonk::ConvertRGB565ToRGB888(pixels, rowSize, rgb.get(), stride,
+                w, h)) {
+            return NS_ERROR_FAILURE;
+        }
+        pixels = rgb.get();
+        inputFormat = imgIEncoder::INPUT_FORMAT_RGB;
+    } else {
+        stride = rowSize;
+        inputFormat = redMask == 0x000000FF ?
+            imgIEncoder::INPUT_FORMAT_RGBA : imgIEncoder::INPUT_FORMAT_HOSTARGB;
+    }
+
+    nsAutoCString contractId("@mozilla.org/image/encoder;2?type=");
+    contractId.Append(aType);
+    nsCOMPtr<imgIEncoder> encoder = do_CreateInstance(contractId.get());
+    if (!encoder) {
+        return NS_ERROR_NOT_AVAILABLE;
+    }
+
+    rv = encoder->InitFromData(pixels, stride * h, w, h, stride, inputFormat,
+        EmptyString());
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+        return rv;
+    }
+
+    uint64_t length = 0;
+    rv = encoder->Available(&length);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+        return rv;
+    }
+
+    void* encoded = nullptr;
+    rv = NS_ReadInputStreamToBuffer(encoder, &encoded, length);
+    if (NS_WARN_IF(NS_FAILED(rv))) {
+        return rv;
+    }
+
+    *aResult = new MemoryBlobImpl(encoded, length,
+        NS_ConvertUTF8toUTF16(aType));
+    return NS_OK;
+}
+
+RefPtr<GonkScreenshot::EncodePromise> GonkScreenshot::encode(
+    BlobImpl* aCapture, const nsACString& aType)
+{
+    MOZ_ASSERT(NS_IsMainThread());
+
+    if (!aCapture) {
+        return EncodePromise::CreateAndReject(NS_ERROR_INVALID_ARG, __func__);
+    }
+
+    if (!sEncodeQueue) {
+        nsCOMPtr<nsISerialEventTarget> queue;
+        nsresult rv = NS_CreateBackgroundTaskQueue("GonkScreenshot",
+            getter_AddRefs(queue));
+        if (NS_FAILED(rv)) {
+            return EncodePromise::CreateAndReject(rv, __func__);
+        }
+        sEncodeQueue = queue.forget();
+        ClearOnShutdown(&sEncodeQueue);
+    }
+
+    RefPtr<BlobImpl> capture = aCapture;
+    nsCString type(aType);
+    return InvokeAsync(sEncodeQueue.get(), __func__, [capture, type]() {
+        RefPtr<BlobImpl> result;
+        nsresult rv = encodeBmpToBlob(capture, type, &result);
+        if (NS_FAILED(rv)) {
+            GS_LOGE("Failed to encode screenshot as %s (0x%x)\n", type.get(),
+                unsigned(rv));
+            return EncodePromise::CreateAndReject(rv, __func__);
+        }
+        return EncodePromise::CreateAndResolve(result, __func__);
+    });
+}
+
 } /* namespace mozilla */
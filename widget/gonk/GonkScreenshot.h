@@ -16,11 +16,42 @@
 #ifndef GonkScreenshot_H_
 #define GonkScreenshot_H_
 
+#include <stdint.h>
+
+#include "mozilla/MozPromise.h"
+#include "mozilla/RefPtr.h"
+#include "nsString.h"
+
 namespace mozilla {
 
+namespace dom {
+class BlobImpl;
+}
+
 class GonkScreenshot {
 public:
     static int capture(uint32_t displayId, const char* fileName);
+
+    /**
+     * Captures the display straight into memory, without going through the
+     * filesystem. The returned blob is an uncompressed "image/bmp" whose pixel
+     * data is a single copy of the framebuffer (RGB565 and RGBA8888 are both
+     * described with BMP bitfields, so no conversion happens), which image
+     * decoders and IPC can consume as is.
+     *
+     * Returns null if the framebuffer could not be read.
+     */
+    static already_AddRefed<dom::BlobImpl> captureToBlob(uint32_t displayId);
+
+    typedef MozPromise<RefPtr<dom::BlobImpl>, nsresult, true> EncodePromise;
+
+    /**
+     * Encodes a blob returned by captureToBlob() as aType ("image/png" or
+     * "image/jpeg") on a background task queue. Callers only need this when
+     * the screenshot is actually persisted.
+     */
+    static RefPtr<EncodePromise> encode(dom::BlobImpl* aCapture,
+                                        const nsACString& aType);
 };
 
 } /* namespace mozilla */
@@ -25,6 +25,7 @@
 #include "LayerScope.h"
 #include "Units.h"
 #include "mozilla/ClearOnShutdown.h"
+#include "mozilla/layers/CompositableHost.h"
 #include "mozilla/layers/CompositorBridgeParent.h"
 #include "mozilla/layers/LayerManagerComposite.h"
 #include "mozilla/layers/PLayerTransaction.h"
@@ -96,7 +97,12 @@ HwcComposer2D::HwcComposer2D()
       mHasHWVsync(false),
       mStopRenderWithHwc(false),
       mAlwaysEnabled(false),
-      mLock("mozilla.HwcComposer2D.mLock") {
+      mLock("mozilla.HwcComposer2D.mLock"),
+      mPlanFingerprint(0),
+      mPlanValid(false),
+      mPlanFullOverlay(false),
+      mPlanCacheHits(0),
+      mPlanCacheMisses(0) {
   mHal = HwcHALBase::CreateHwcHAL();
   if (!mHal->HasHwc()) {
     LOGD("no hwc support");
@@ -643,6 +649,102 @@ bool HwcComposer2D::PrepareLayerList(Layer* aLayer, const nsIntRect& aClip,
 #endif
 }
 
+// Hashes everything PrepareLayerList() bases its decisions on, except for the
+// buffer handles themselves, which change from frame to frame.
+HashNumber HwcComposer2D::ComputeLayerTreeFingerprint(Layer* aLayer,
+                                                      HashNumber aHash) {
+  aHash = AddToHash(aHash, aLayer, uint32_t(aLayer->GetType()));
+
+  const Maybe<ParentLayerIntRect>& clip = aLayer->GetLocalClipRect();
+  if (clip) {
+    aHash = AddToHash(aHash, clip->x, clip->y, clip->width, clip->height);
+  }
+
+  const gfx::Matrix4x4& transform = aLayer->GetEffectiveTransform();
+  for (int i = 0; i < 16; i++) {
+    aHash = AddToHash(aHash, transform.components[i]);
+  }
+
+  const nsIntRect visible =
+      aLayer->GetLocalVisibleRegion().ToUnknownRegion().GetBounds();
+  aHash = AddToHash(aHash, visible.x, visible.y, visible.width,
+                    visible.height, aLayer->GetEffectiveOpacity());
+
+  if (HostLayer* host = aLayer->AsHostLayer()) {
+    CompositableHost* compositable = host->GetCompositableHost();
+    TextureHost* texture =
+        compositable ? compositable->GetAsTextureHost() : nullptr;
+    if (texture) {
+      gfx::IntSize size = texture->GetSize();
+      aHash = AddToHash(aHash, uint32_t(texture->GetFormat()), size.width,
+                        size.height);
+    }
+  }
+
+  for (Layer* child = aLayer->GetFirstChild(); child;
+       child = child->GetNextSibling()) {
+    aHash = ComputeLayerTreeFingerprint(child, aHash);
+  }
+  return aHash;
+}
+
+// Refreshes the per-frame state of the layer list kept from the last frame.
+// Returns false if the list can't be reused, e.g. because a layer lost its
+// buffer.
+bool HwcComposer2D::UpdateCachedPlan() {
+  // TODO: FIXME
+  return false;
+#if 0
+    MOZ_ASSERT(mPlanValid && mList && mList->numHwLayers > 0);
+
+    // The last entry is the framebuffer target, which a full overlay
+    // composition doesn't use.
+    for (uint32_t j = 0; j < (mList->numHwLayers - 1); j++) {
+        HwcLayer& hwcLayer = mList->hwLayers[j];
+        hwcLayer.acquireFenceFd = -1;
+        hwcLayer.releaseFenceFd = -1;
+        if (hwcLayer.flags & HwcUtils::HWC_COLOR_FILL) {
+            continue;
+        }
+
+        LayerComposite* layerComposite = mHwcLayerMap[j];
+        LayerRenderState state = layerComposite->GetLayer()->GetRenderState();
+        if (state.GetSidebandStream().IsValid()) {
+            hwcLayer.handle = state.GetSidebandStream().GetRawNativeHandle();
+        } else if (state.GetGrallocBuffer()) {
+            hwcLayer.handle = state.GetGrallocBuffer()->getNativeBuffer()->handle;
+        } else {
+            return false;
+        }
+
+        if (layerComposite->Damaged()) {
+            hwcLayer.surfaceDamage.numRects = 0;
+            hwcLayer.surfaceDamage.rects = nullptr;
+        } else {
+            static hwc_rect_t empty = {0, 0, 0, 0};
+            hwcLayer.surfaceDamage.numRects = 1;
+            hwcLayer.surfaceDamage.rects = &empty;
+        }
+        layerComposite->SetLayerComposited(true);
+    }
+
+    mList->flags = 0;
+    mList->retireFenceFd = -1;
+    return true;
+#endif
+}
+
+void HwcComposer2D::GetPlanCacheStats(uint32_t* aHits,
+                                      uint32_t* aMisses) const {
+  *aHits = mPlanCacheHits;
+  *aMisses = mPlanCacheMisses;
+}
+
+void HwcComposer2D::ResetPlanCacheStats() {
+  mPlanCacheHits = 0;
+  mPlanCacheMisses = 0;
+}
+
 bool HwcComposer2D::TryHwComposition(nsScreenGonk* aScreen) {
   // TODO: FIXME
   return false;
@@ -674,6 +776,7 @@ bool HwcComposer2D::TryHwComposition(nsScreenGonk* aScreen) {
     bool gpuComposite = false;
     bool blitComposite = false;
     bool overlayComposite = true;
+    mPlanFullOverlay = false;
 
     for (int j=0; j < idx; j++) {
         if (mList->hwLayers[j].compositionType == HWC_FRAMEBUFFER ||
@@ -740,7 +843,9 @@ bool HwcComposer2D::TryHwComposition(nsScreenGonk* aScreen) {
         }
     }
 
-    // BLIT or full OVERLAY Composition
+    // BLIT or full OVERLAY Composition. Only the latter doesn't depend on
+    // the contents of the framebuffer target, so only it can be reused.
+    mPlanFullOverlay = overlayComposite;
     return Commit(aScreen);
 #endif
 }
@@ -884,9 +989,24 @@ bool HwcComposer2D::TryRenderWithHwc(Layer* aRoot, nsIWidget* aWidget,
     }
 
     if (mStopRenderWithHwc) {
+        mPlanValid = false;
         return false;
     }
 
+    // Reuse the last plan if the layer tree has the same shape as in the
+    // last frame we fully composed with hwc.
+    HashNumber fingerprint = ComputeLayerTreeFingerprint(aRoot, 0);
+    if (mPlanValid && !aGeometryChanged && !aHasImageHostOverlays &&
+        fingerprint == mPlanFingerprint && !mPrepared) {
+        if (UpdateCachedPlan() && Commit(screen)) {
+            mPlanCacheHits++;
+            LOGD("Frame rendered with cached plan");
+            return true;
+        }
+    }
+    mPlanCacheMisses++;
+    mPlanValid = false;
+
     if (mList) {
         mList->flags = mHal->GetGeometryChangedFlag(aGeometryChanged);
         mList->numHwLayers = 0;
@@ -938,6 +1058,9 @@ bool HwcComposer2D::TryRenderWithHwc(Layer* aRoot, nsIWidget* aWidget,
         return false;
     }
 
+    mPlanFingerprint = fingerprint;
+    mPlanValid = mPlanFullOverlay;
+
     LOGD("Frame rendered");
     return true;
 #endif
@@ -24,6 +24,8 @@
 #include "Layers.h"
 #include "mozilla/layers/Composer2D.h"
 #include "mozilla/layers/FenceUtils.h"
+#include "mozilla/Atomics.h"
+#include "mozilla/HashFunctions.h"
 #include "mozilla/Mutex.h"
 #include "mozilla/UniquePtr.h"  // for HwcHAL
 
@@ -95,6 +97,10 @@ class HwcComposer2D : public mozilla::layers::Composer2D {
 
   void SetVsyncAlwaysEnabled(bool aAlways);
 
+  // Hit/miss counters of the HWC plan cache, reported by GfxDebugger.
+  void GetPlanCacheStats(uint32_t* aHits, uint32_t* aMisses) const;
+  void ResetPlanCacheStats();
+
  private:
   void Reset();
   void Prepare(buffer_handle_t dispHandle, int fence, nsScreenGonk* screen);
@@ -104,6 +110,9 @@ class HwcComposer2D : public mozilla::layers::Composer2D {
   bool PrepareLayerList(layers::Layer* aContainer, const nsIntRect& aClip,
                         const gfx::Matrix& aParentTransform,
                         bool aFindSidebandStreams);
+  HashNumber ComputeLayerTreeFingerprint(layers::Layer* aLayer,
+                                         HashNumber aHash);
+  bool UpdateCachedPlan();
   void SendtoLayerScope();
 
   UniquePtr<HwcHALBase> mHal;
@@ -125,6 +134,14 @@ class HwcComposer2D : public mozilla::layers::Composer2D {
   bool mAlwaysEnabled;
   layers::CompositorBridgeParent* mCompositorBridgeParent;
   Mutex mLock;
+  // The layer list of the last full overlay composition is kept in mList.
+  // When the next frame has the same layer tree structure, that list is
+  // reused and only its buffer handles and fences are refreshed.
+  HashNumber mPlanFingerprint;
+  bool mPlanValid;
+  bool mPlanFullOverlay;
+  Atomic<uint32_t> mPlanCacheHits;
+  Atomic<uint32_t> mPlanCacheMisses;
 };
 
 class HWComposerCallback : public HWC2::ComposerCallback {
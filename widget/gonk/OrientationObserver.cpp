@@ -23,7 +23,6 @@
 #include "nsIScreenManager.h"
 #include "OrientationObserver.h"
 #include "mozilla/HalSensor.h"
-#include "ProcessOrientation.h"
 #include "nsServiceManagerUtils.h"
 #include "ScreenHelperGonk.h"
 
@@ -157,8 +156,7 @@ OrientationObserver* OrientationObserver::GetInstance() {
 
 OrientationObserver::OrientationObserver()
     : mAutoOrientationEnabled(false),
-      mAllowedOrientations(sDefaultOrientations),
-      mOrientation(new mozilla::ProcessOrientation()) {
+      mAllowedOrientations(sDefaultOrientations) {
   DetectDefaultOrientation();
 
   EnableAutoOrientation();
@@ -181,9 +179,14 @@ OrientationObserver::~OrientationObserver() {
 }
 
 void OrientationObserver::Notify(const hal::SensorData& aSensorData) {
-  // Sensor will call us on the main thread.
+  // Sensor will call us on the main thread, and only when the rotation
+  // changes: orientation detection runs in the sensor HAL.
   MOZ_ASSERT(NS_IsMainThread());
-  MOZ_ASSERT(aSensorData.sensor() == hal::SensorType::SENSOR_ACCELERATION);
+  MOZ_ASSERT(aSensorData.sensor() == hal::SensorType::SENSOR_SCREEN_ROTATION);
+
+  if (aSensorData.values().IsEmpty()) {
+    return;
+  }
 
   nsCOMPtr<nsIScreen> screen = GetPrimaryScreen();
   if (!screen) {
@@ -195,8 +198,7 @@ void OrientationObserver::Notify(const hal::SensorData& aSensorData) {
     return;
   }
 
-  int rotation = mOrientation->OnSensorChanged(aSensorData,
-                                               static_cast<int>(currRotation));
+  int rotation = static_cast<int>(aSensorData.values()[0]);
   if (rotation < 0 || uint32_t(rotation) == currRotation) {
     return;
   }
@@ -223,8 +225,7 @@ void OrientationObserver::Notify(const hal::SensorData& aSensorData) {
 void OrientationObserver::EnableAutoOrientation() {
   MOZ_ASSERT(NS_IsMainThread() && !mAutoOrientationEnabled);
 
-  mOrientation->Reset();
-  hal::RegisterSensorObserver(hal::SENSOR_ACCELERATION, this);
+  hal::RegisterSensorObserver(hal::SENSOR_SCREEN_ROTATION, this);
   mAutoOrientationEnabled = true;
 }
 
@@ -234,7 +235,7 @@ void OrientationObserver::EnableAutoOrientation() {
 void OrientationObserver::DisableAutoOrientation() {
   MOZ_ASSERT(NS_IsMainThread() && mAutoOrientationEnabled);
 
-  hal::UnregisterSensorObserver(hal::SENSOR_ACCELERATION, this);
+  hal::UnregisterSensorObserver(hal::SENSOR_SCREEN_ROTATION, this);
   mAutoOrientationEnabled = false;
 }
 
@@ -19,10 +19,8 @@
 #define OrientationObserver_h
 
 #include "mozilla/Observer.h"
-#include "mozilla/UniquePtr.h"
 
 namespace mozilla {
-class ProcessOrientation;
 namespace hal {
 class SensorData;
 typedef mozilla::Observer<SensorData> ISensorObserver;
@@ -58,7 +56,6 @@ class OrientationObserver : public ISensorObserver {
  private:
   bool mAutoOrientationEnabled;
   uint32_t mAllowedOrientations;
-  mozilla::UniquePtr<mozilla::ProcessOrientation> mOrientation;
 
   static const uint32_t sDefaultOrientations =
       mozilla::hal::eScreenOrientation_PortraitPrimary |
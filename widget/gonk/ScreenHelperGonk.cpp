@@ -121,6 +121,7 @@ nsScreenGonk::nsScreenGonk(uint32_t aId, DisplayType aDisplayType,
       mScreenRotation(ROTATION_0),
       mPhysicalScreenRotation(ROTATION_0),
       mDisplaySurface(aNativeData.mDisplaySurface),
+      mHwcVirtualDisplay(aNativeData.mHwcVirtualDisplay),
       mComposer2DSupported(aNativeData.mComposer2DSupported),
       mVsyncSupported(aNativeData.mVsyncSupported),
       mIsMirroring(false),
@@ -186,6 +187,10 @@ bool nsScreenGonk::IsPrimaryScreen() {
   return mDisplayType == DisplayType::DISPLAY_PRIMARY;
 }
 
+bool nsScreenGonk::IsMirroredByHwc() {
+  return mHwcVirtualDisplay.get() && mHwcVirtualDisplay->isActive();
+}
+
 NS_IMETHODIMP
 nsScreenGonk::GetId(uint32_t* outId) {
   *outId = mId;
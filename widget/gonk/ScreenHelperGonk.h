@@ -113,6 +113,9 @@ class nsScreenGonk : public nsBaseScreen {
   bool EnableMirroring();
   bool DisableMirroring();
   bool IsMirroring() { return mIsMirroring; }
+  // True while the HWC mirrors the primary screen into this one, which then
+  // doesn't have to be composed.
+  bool IsMirroredByHwc();
 
   // Primary screen only
   bool SetMirroringScreen(nsScreenGonk* aScreen);
@@ -146,6 +149,7 @@ class nsScreenGonk : public nsBaseScreen {
   uint32_t mPhysicalScreenRotation;
   nsTArray<nsWindow*> mTopWindows;
   android::sp<android::DisplaySurface> mDisplaySurface;
+  android::sp<android::HwcVirtualDisplay> mHwcVirtualDisplay;
   bool mComposer2DSupported;
   bool mVsyncSupported;
   bool mIsMirroring;                      // Non-primary screen only
@@ -20,6 +20,7 @@
 #include <string>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 #include "mozilla/Sprintf.h"
 #include "png.h"
@@ -31,6 +32,7 @@
 #include "NativeGralloc.h"
 #include <dlfcn.h>
 
+#include "GonkColorConvert.h"
 #include "GonkDisplay.h"
 
 #define LOG(args...) __android_log_print(ANDROID_LOG_INFO, "Gonk", ##args)
@@ -232,30 +234,79 @@ class ZipReader {
   }
 };
 
+/* Raw frames are zip entries whose name ends in ".raw". They hold pixels
+ * that are ready for the framebuffer, so playing one is a copy out of the
+ * mapped archive rather than a PNG decode competing with Gecko startup.
+ * Like the PNG frames they must be stored uncompressed. Pixels start at
+ * data_offset from the start of the entry; with the entry aligned to a page
+ * (zipalign -p) and data_offset a multiple of the page size they come
+ * straight from the page cache.
+ */
+#define RAW_FRAME_MAGIC 0x52473242 /* "B2GR" */
+
+struct raw_frame_header {
+  uint32_t magic;
+  uint16_t width;
+  uint16_t height;
+  uint32_t format;      /* HAL_PIXEL_FORMAT_* */
+  uint32_t stride;      /* in bytes */
+  uint32_t data_offset; /* from the start of this header */
+  uint8_t has_bgcolor;
+  uint8_t bg_red;
+  uint8_t bg_green;
+  uint8_t bg_blue;
+
+  bool Valid(uint32_t aEntrySize) const {
+    if (letoh32(magic) != RAW_FRAME_MAGIC) {
+      return false;
+    }
+    uint64_t end = uint64_t(letoh32(data_offset)) +
+                   uint64_t(letoh32(stride)) * letoh16(height);
+    return letoh32(data_offset) >= sizeof(raw_frame_header) &&
+           end <= aEntrySize;
+  }
+} __attribute__((__packed__));
+
 struct AnimationFrame {
   char path[256];
   png_color_16 bgcolor;
+  // Owned copy of a decoded PNG frame, null for raw frames.
   char* buf;
+  // The pixels to draw: buf, or the data of a raw frame in the archive.
+  const char* pixels;
   const local_file_header* file;
   uint32_t width;
   uint32_t height;
+  // Bytes per row of pixels.
+  uint32_t stride;
+  // HAL_PIXEL_FORMAT_* of pixels.
+  int32_t format;
   uint16_t bytepp;
   bool has_bgcolor;
 
-  AnimationFrame() : buf(nullptr) {}
-  AnimationFrame(const AnimationFrame& frame) : buf(nullptr) {
+  AnimationFrame() : buf(nullptr), pixels(nullptr) {}
+  AnimationFrame(const AnimationFrame& frame) : buf(nullptr), pixels(nullptr) {
     strncpy(path, frame.path, sizeof(path));
     file = frame.file;
   }
-  ~AnimationFrame() {
-    if (buf) free(buf);
-  }
+  ~AnimationFrame() { Release(); }
 
   bool operator<(const AnimationFrame& other) const {
     return strcmp(path, other.path) < 0;
   }
 
+  void ReadFrame(int outputFormat);
+  bool ReadRawFrame(int outputFormat);
   void ReadPngFrame(int outputFormat);
+
+  // Starts reading the frame's data from storage ahead of ReadFrame().
+  void Prefetch() const;
+
+  void Release() {
+    if (buf) free(buf);
+    buf = nullptr;
+    pixels = nullptr;
+  }
 };
 
 struct AnimationPart {
@@ -366,6 +417,69 @@ static uint16_t GetFormatBPP(int aFormat) {
   return bpp;
 }
 
+static bool EndsWith(const char* aString, const char* aSuffix) {
+  size_t len = strlen(aString);
+  size_t suffixLen = strlen(aSuffix);
+  return len >= suffixLen && !strcmp(aString + len - suffixLen, aSuffix);
+}
+
+void AnimationFrame::ReadFrame(int outputFormat) {
+  if (EndsWith(path, ".raw")) {
+    if (!ReadRawFrame(outputFormat)) {
+      LOGW("Invalid raw frame %s", path);
+    }
+    return;
+  }
+  ReadPngFrame(outputFormat);
+}
+
+bool AnimationFrame::ReadRawFrame(int outputFormat) {
+  const raw_frame_header* header =
+      reinterpret_cast<const raw_frame_header*>(file->GetData());
+  if (file->GetDataSize() < sizeof(raw_frame_header) ||
+      !header->Valid(file->GetDataSize())) {
+    return false;
+  }
+
+  width = letoh16(header->width);
+  height = letoh16(header->height);
+  stride = letoh32(header->stride);
+  format = letoh32(header->format);
+  bytepp = GetFormatBPP(format);
+  if (stride < width * bytepp) {
+    return false;
+  }
+
+  // Only 32bpp frames can be drawn on a 565 framebuffer; see DrawFrame().
+  if (format != outputFormat &&
+      !(outputFormat == HAL_PIXEL_FORMAT_RGB_565 && bytepp == 4)) {
+    LOGW("Raw frame %s has format %d, the display has %d", path, format,
+         outputFormat);
+    return false;
+  }
+
+  has_bgcolor = header->has_bgcolor;
+  bgcolor = png_color_16();
+  bgcolor.red = header->bg_red;
+  bgcolor.green = header->bg_green;
+  bgcolor.blue = header->bg_blue;
+
+  pixels = file->GetData() + letoh32(header->data_offset);
+  return true;
+}
+
+void AnimationFrame::Prefetch() const {
+  if (pixels) {
+    return;
+  }
+  // madvise() wants a page aligned start.
+  uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+  uintptr_t start = reinterpret_cast<uintptr_t>(file->GetData());
+  uintptr_t end = start + file->GetDataSize();
+  start &= ~(pageSize - 1);
+  madvise(reinterpret_cast<void*>(start), end - start, MADV_WILLNEED);
+}
+
 void AnimationFrame::ReadPngFrame(int outputFormat) {
 #ifdef PNG_HANDLE_AS_UNKNOWN_SUPPORTED
   static const png_byte unused_chunks[] = {99,  72, 82, 77,  '\0',  /* cHRM */
@@ -434,6 +548,7 @@ void AnimationFrame::ReadPngFrame(int outputFormat) {
       bgcolor.green, bgcolor.blue, bgcolor.gray);
 
   bytepp = GetFormatBPP(outputFormat);
+  stride = width * bytepp;
 
   switch (outputFormat) {
     case HAL_PIXEL_FORMAT_BGRA_8888:
@@ -462,7 +577,6 @@ void AnimationFrame::ReadPngFrame(int outputFormat) {
   buf = (char*)malloc(width * (height + 1) * bytepp);
 
   vector<char*> rows(height + 1);
-  uint32_t stride = width * bytepp;
   for (uint32_t i = 0; i < height; i++) {
     rows[i] = buf + (stride * i);
   }
@@ -472,6 +586,9 @@ void AnimationFrame::ReadPngFrame(int outputFormat) {
   png_set_gray_to_rgb(pngread);
   png_read_image(pngread, (png_bytepp)&rows.front());
   png_destroy_read_struct(&pngread, &pnginfo, nullptr);
+
+  pixels = buf;
+  format = outputFormat;
 }
 
 struct Animation {
@@ -534,6 +651,8 @@ bool Animation::LoadAnimations(const char* aFileName) {
    * This is the boot animation file format that Android uses.
    * It's a zip file with a directories containing png frames
    * and a desc.txt that describes how they should be played.
+   * Frames may also be pre-converted ".raw" files, see
+   * raw_frame_header.
    *
    * desc.txt contains two types of lines
    * 1. [width] [height] [fps]
@@ -679,37 +798,49 @@ static void ShowSolidColorFrame(GonkDisplay* aDisplay, int32_t aFormat,
 
 static bool DrawFrame(AnimationFrame& aFrame, ANativeWindowBuffer* aBuf,
                       int32_t format, void* aVaddr) {
-  if (!aBuf || !aFrame.buf) {
+  if (!aBuf || !aFrame.pixels) {
     return false;
   }
 
   uint32_t bufWidth = aBuf->width;
   uint32_t bufHeight = aBuf->height;
   uint32_t bufStride = aBuf->stride;
+  uint16_t bufBytepp = GetFormatBPP(format);
 
   if (aFrame.has_bgcolor) {
     wchar_t bgfill = AsBackgroundFill(aFrame.bgcolor, format);
     wmemset((wchar_t*)aVaddr, bgfill,
-            (bufHeight * bufStride * aFrame.bytepp) / sizeof(wchar_t));
+            (bufHeight * bufStride * bufBytepp) / sizeof(wchar_t));
   }
 
-  if (bufHeight == aFrame.height && bufStride == aFrame.width) {
-    memcpy(aVaddr, aFrame.buf, aFrame.width * aFrame.height * aFrame.bytepp);
-  } else if (bufHeight >= aFrame.height && bufWidth >= aFrame.width) {
-    int startx = (bufWidth - aFrame.width) / 2;
-    int starty = (bufHeight - aFrame.height) / 2;
+  if (bufHeight < aFrame.height || bufWidth < aFrame.width) {
+    return true;
+  }
 
-    int src_stride = aFrame.width * aFrame.bytepp;
-    int dst_stride = bufStride * aFrame.bytepp;
+  int startx = (bufWidth - aFrame.width) / 2;
+  int starty = (bufHeight - aFrame.height) / 2;
+  int dst_stride = bufStride * bufBytepp;
+  char* dst = (char*)aVaddr + starty * dst_stride + startx * bufBytepp;
 
-    char* src = aFrame.buf;
-    char* dst = (char*)aVaddr + starty * dst_stride + startx * aFrame.bytepp;
+  if (aFrame.format != format) {
+    // A 32bpp raw frame on a 565 framebuffer, see ReadRawFrame().
+    return gonk::ConvertRGBA8888ToRGB565(
+        reinterpret_cast<const uint8_t*>(aFrame.pixels), aFrame.stride,
+        reinterpret_cast<uint8_t*>(dst), dst_stride, aFrame.width,
+        aFrame.height);
+  }
 
-    for (uint32_t i = 0; i < aFrame.height; i++) {
-      memcpy(dst, src, src_stride);
-      src += src_stride;
-      dst += dst_stride;
-    }
+  int src_stride = aFrame.width * aFrame.bytepp;
+  if (aFrame.stride == uint32_t(src_stride) && dst_stride == src_stride) {
+    memcpy(dst, aFrame.pixels, src_stride * aFrame.height);
+    return true;
+  }
+
+  const char* src = aFrame.pixels;
+  for (uint32_t i = 0; i < aFrame.height; i++) {
+    memcpy(dst, src, src_stride);
+    src += aFrame.stride;
+    dst += dst_stride;
   }
 
   return true;
@@ -783,10 +914,13 @@ static void* AnimationThread(void*) {
 
         for (uint32_t s = 0; s < numAnim; s++) {
           Animation& anim = animVec[s];
-          AnimationFrame& frame = anim.parts[i].frames[k];
-          if (!frame.buf) {
-            frame.ReadPngFrame(anim.format);
+          vector<AnimationFrame>& frames = anim.parts[i].frames;
+          AnimationFrame& frame = frames[k];
+          if (!frame.pixels) {
+            frame.ReadFrame(anim.format);
           }
+          // Have storage read the next frame while we draw this one.
+          frames[(k + 1) % frames.size()].Prefetch();
 
           ANativeWindowBuffer* buf = display->DequeueBuffer(anim.dpy);
 
@@ -818,8 +952,7 @@ static void* AnimationThread(void*) {
           }
 
           if (part.count && j >= part.count) {
-            free(frame.buf);
-            frame.buf = nullptr;
+            frame.Release();
           }
         }
 
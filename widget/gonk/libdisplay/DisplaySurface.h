@@ -94,6 +94,11 @@ class DisplaySurface : public ConsumerBase {
 
   virtual void setVisibility(bool visibility) = 0;
 
+  // repostCurrentFrame presents the last latched buffer again, without
+  // waiting for a new one from the producer. It is used to light the panel
+  // with the retained frame right after it is powered back on.
+  virtual void repostCurrentFrame() = 0;
+
   buffer_handle_t lastHandle;
 
  protected:
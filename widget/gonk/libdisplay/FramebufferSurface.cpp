@@ -21,6 +21,7 @@
  */
 
 #include <errno.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -33,6 +34,7 @@
 #include <ui/GraphicBuffer.h>
 #include <ui/Rect.h>
 #include <utils/String8.h>
+#include <utils/Timers.h>
 #include <vndk/hardware_buffer.h>
 
 #include "GonkDisplayWorkThread.h"
@@ -68,6 +70,7 @@ FramebufferSurface::FramebufferSurface(
       mPreviousBuffer(),
       mPrevFBAcquireFence(Fence::NO_FENCE),
       mLastPresentFence(Fence::NO_FENCE),
+      mLastFrameNumber(0),
       mDisplayUtils(displayUtils),
       mVisibility(visibility) {
   mName = "FramebufferSurface";
@@ -120,7 +123,17 @@ status_t FramebufferSurface::nextBuffer(sp<GraphicBuffer>& outBuffer,
   const auto slot = item.mSlot;
   const auto buffer = mSlots[item.mSlot].mGraphicBuffer;
   const auto acquireFence = item.mFence;
-  presentLocked(slot, buffer, acquireFence);
+
+  // The producer reports damage relative to the previous frame it queued.
+  // If we haven't presented that one the damage isn't enough to bring the
+  // display up to date.
+  Region damage = item.mSurfaceDamage;
+  if (mLastFrameNumber && item.mFrameNumber != mLastFrameNumber + 1) {
+    damage = Region::INVALID_REGION;
+  }
+  mLastFrameNumber = item.mFrameNumber;
+
+  presentLocked(slot, buffer, acquireFence, damage);
 
   // If the BufferQueue has freed and reallocated a buffer in mCurrentSlot
   // then we may have acquired the slot we already own.  If we had released
@@ -166,9 +179,30 @@ void FramebufferSurface::onFrameAvailable(const BufferItem& item) {
   });
 }
 
+void FramebufferSurface::repostCurrentFrame() {
+  carthage::GonkDisplayWorkThread::Get()->Post([=] {
+    Mutex::Autolock lock(mMutex);
+    if (mCurrentSlot == BufferQueue::INVALID_BUFFER_SLOT ||
+        !mCurrentBuffer.get()) {
+      return;
+    }
+
+    // The panel lost its contents while it was off, so the whole buffer has
+    // to be sent again. It was fully rendered before it was first presented.
+    nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    presentLocked(mCurrentSlot, mCurrentBuffer, Fence::NO_FENCE,
+                  Region::INVALID_REGION);
+    ALOGI("repostCurrentFrame: retained frame presented in %" PRId64 " us",
+          ns2us(systemTime(SYSTEM_TIME_MONOTONIC) - start));
+  });
+}
+
+// surfaceDamage is in buffer coordinates. Region::INVALID_REGION means the
+// whole buffer is damaged.
 void FramebufferSurface::presentLocked(const int bufferSlot,
                                        const sp<GraphicBuffer>& buffer,
-                                       const sp<Fence>& acquireFence) {
+                                       const sp<Fence>& acquireFence,
+                                       const Region& surfaceDamage) {
   uint32_t numTypes = 0;
   uint32_t numRequests = 0;
   HWC2::Error error = HWC2::Error::None;
@@ -182,8 +216,18 @@ void FramebufferSurface::presentLocked(const int bufferSlot,
         sp<Fence> fenceObj = new Fence(acquireFence->dup());
         fenceObj->waitForever("FramebufferSurface::Post");
       }
-      mDisplayUtils.utils.extFBDevice->Post(buffer->handle);
+      Rect damageBounds = surfaceDamage.getBounds();
+      if (!damageBounds.isValid() || surfaceDamage.isEmpty()) {
+        damageBounds = Rect(buffer->getWidth(), buffer->getHeight());
+      }
+      mDisplayUtils.utils.extFBDevice->Post(buffer->handle, damageBounds);
     } else {
+      // Panels with partial update support use this to limit the region
+      // that gets transferred to the display.
+      if (mDisplayUtils.hwcLayer) {
+        (void)mDisplayUtils.hwcLayer->setSurfaceDamage(surfaceDamage);
+      }
+
       error = mDisplayUtils.utils.hwcDisplay->validate(&numTypes, &numRequests);
       if (error != HWC2::Error::None && error != HWC2::Error::HasChanges) {
         ALOGE("prepare: validate failed : %s (%d)", to_string(error).c_str(),
@@ -210,6 +254,11 @@ void FramebufferSurface::presentLocked(const int bufferSlot,
       if (error != HWC2::Error::None) {
         ALOGE("present: failed : %s (%d)", to_string(error).c_str(),
               static_cast<int32_t>(error));
+      } else if (mMirror.get()) {
+        mMirror->present(bufferSlot, buffer, acquireFence);
+        if (!mMirror->isActive()) {
+          mMirror = nullptr;
+        }
       }
     }
   }
@@ -226,6 +275,13 @@ FrameCommitted:
   onFrameCommitted();
 }
 
+void FramebufferSurface::setMirror(const sp<HwcVirtualDisplay>& mirror) {
+  carthage::GonkDisplayWorkThread::Get()->Post([=] {
+    Mutex::Autolock lock(mMutex);
+    mMirror = mirror;
+  });
+}
+
 void FramebufferSurface::freeBufferLocked(int slotIndex) {
   ConsumerBase::freeBufferLocked(slotIndex);
   if (slotIndex == mCurrentSlot) {
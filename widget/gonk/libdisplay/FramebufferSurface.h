@@ -23,8 +23,11 @@
 
 #include "DisplaySurface.h"
 #include "HwcHAL.h"  // for HWC2
+#include "HwcVirtualDisplay.h"
 #include "NativeFramebufferDevice.h"
 
+#include <ui/Region.h>
+
 // ---------------------------------------------------------------------------
 namespace android {
 // ---------------------------------------------------------------------------
@@ -45,6 +48,10 @@ typedef struct DisplayUtils {
         // FB device for external screen update.
         NativeFramebufferDevice* extFBDevice;
     } utils;
+
+    // HWC layer showing the client target of a MAIN display, whose surface
+    // damage is updated with the damage of each posted buffer.
+    HWC2::Layer* hwcLayer;
 } DisplayUtils;
 // ---------------------------------------------------------------------------
 
@@ -70,6 +77,12 @@ public:
 
     virtual void setVisibility(bool visibility) { mVisibility = visibility; }
 
+    virtual void repostCurrentFrame();
+
+    // Also present the frames of this MAIN display on |mirror|, until it
+    // stops. nullptr stops mirroring.
+    void setMirror(const sp<HwcVirtualDisplay>& mirror);
+
     // setReleaseFenceFd stores a fence file descriptor that will signal when the
     // current buffer is no longer being read. This fence will be returned to
     // the producer when the current buffer is released by updateTexImage().
@@ -90,10 +103,11 @@ private:
     // BufferQueue.  The new buffer is returned in the 'buffer' argument.
     status_t nextBuffer(sp<GraphicBuffer>& outBuffer, sp<Fence>& outFence);
 
-	void presentLocked(
+    void presentLocked(
         const int slot,
         const sp<GraphicBuffer>& buffer,
-        const sp<Fence>& acquireFence);
+        const sp<Fence>& acquireFence,
+        const Region& surfaceDamage);
 
     // mCurrentBufferIndex is the slot index of the current buffer or
     // INVALID_BUFFER_SLOT to indicate that either there is no current buffer
@@ -111,8 +125,15 @@ private:
     sp<Fence> mPrevFBAcquireFence;
     sp<Fence> mLastPresentFence;
 
+    // Frame number of the last buffer we latched. A gap in frame numbers
+    // means we didn't see the damage of every frame, so the next update
+    // can't be partial.
+    uint64_t mLastFrameNumber;
+
     DisplayUtils mDisplayUtils;
 
+    sp<HwcVirtualDisplay> mMirror;
+
     // Indicator to control whether to update frame or not with this Surface.
     bool mVisibility;
 };
@@ -0,0 +1,192 @@
+/* Copyright (C) 2020 KAI OS TECHNOLOGIES (HONG KONG) LIMITED. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GonkColorConvert.h"
+
+#include "libyuv/convert.h"
+#include "libyuv/convert_from.h"
+#include "libyuv/convert_argb.h"
+#include "libyuv/convert_from_argb.h"
+#include "libyuv/scale.h"
+#include "libyuv/scale_argb.h"
+#include "mozilla/UniquePtr.h"
+
+#ifdef BUILD_ARM_NEON
+#  include "mozilla/arm.h"
+#  include "rgb8888_to_rgb565_neon.h"
+#endif
+
+namespace mozilla {
+namespace gonk {
+
+static inline bool IsValidSize(int aWidth, int aHeight) {
+  return aWidth > 0 && aHeight > 0;
+}
+
+static void Transform8888To565Row_C(uint16_t* aOut, const uint8_t* aIn,
+                                    int aPixels) {
+  for (int i = 0; i < aPixels; i++, aIn += 4) {
+    *aOut++ = ((aIn[0] & 0xF8) << 8) | ((aIn[1] & 0xFC) << 3) | (aIn[2] >> 3);
+  }
+}
+
+bool ConvertRGBA8888ToRGB565(const uint8_t* aSrc, int aSrcStride,
+                             uint8_t* aDst, int aDstStride, int aWidth,
+                             int aHeight) {
+  if (!aSrc || !aDst || !IsValidSize(aWidth, aHeight)) {
+    return false;
+  }
+
+  // Contiguous buffers are converted as one long row, which keeps the NEON
+  // loop running rather than restarting it for every scanline.
+  if (aSrcStride == aWidth * 4 && aDstStride == aWidth * 2) {
+    aWidth *= aHeight;
+    aHeight = 1;
+  }
+
+#ifdef BUILD_ARM_NEON
+  // The NEON kernel handles 8 pixels per iteration and must not be handed
+  // a partial block, so the remainder goes through the C loop.
+  const bool useNeon = mozilla::supports_neon();
+#endif
+
+  for (int y = 0; y < aHeight; y++) {
+    const uint8_t* in = aSrc + y * aSrcStride;
+    uint16_t* out = reinterpret_cast<uint16_t*>(aDst + y * aDstStride);
+    int done = 0;
+#ifdef BUILD_ARM_NEON
+    if (useNeon) {
+      done = aWidth & ~7;
+      if (done) {
+        Transform8888To565_NEON(reinterpret_cast<uint8_t*>(out), in, done);
+      }
+    }
+#endif
+    Transform8888To565Row_C(out + done, in + done * 4, aWidth - done);
+  }
+  return true;
+}
+
+bool ConvertRGB565ToRGB888(const uint8_t* aSrc, int aSrcStride, uint8_t* aDst,
+                           int aDstStride, int aWidth, int aHeight) {
+  if (!aSrc || !aDst || !IsValidSize(aWidth, aHeight)) {
+    return false;
+  }
+
+  // libyuv has no direct 565 -> RAW path, so go through one row of BGRA
+  // ("ARGB" in libyuv naming) at a time to keep the scratch buffer small.
+  UniquePtr<uint8_t[]> row = MakeUnique<uint8_t[]>(aWidth * 4);
+  for (int y = 0; y < aHeight; y++) {
+    if (libyuv::RGB565ToARGB(aSrc + y * aSrcStride, aSrcStride, row.get(),
+                             aWidth * 4, aWidth, 1) ||
+        libyuv::ARGBToRAW(row.get(), aWidth * 4, aDst + y * aDstStride,
+                          aDstStride, aWidth, 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ConvertNV12ToI420(const uint8_t* aSrcY, int aSrcStrideY,
+                       const uint8_t* aSrcUV, int aSrcStrideUV, uint8_t* aDstY,
+                       int aDstStrideY, uint8_t* aDstU, int aDstStrideU,
+                       uint8_t* aDstV, int aDstStrideV, int aWidth,
+                       int aHeight) {
+  if (!IsValidSize(aWidth, aHeight)) {
+    return false;
+  }
+  return libyuv::NV12ToI420(aSrcY, aSrcStrideY, aSrcUV, aSrcStrideUV, aDstY,
+                            aDstStrideY, aDstU, aDstStrideU, aDstV,
+                            aDstStrideV, aWidth, aHeight) == 0;
+}
+
+bool ConvertNV21ToI420(const uint8_t* aSrcY, int aSrcStrideY,
+                       const uint8_t* aSrcVU, int aSrcStrideVU, uint8_t* aDstY,
+                       int aDstStrideY, uint8_t* aDstU, int aDstStrideU,
+                       uint8_t* aDstV, int aDstStrideV, int aWidth,
+                       int aHeight) {
+  if (!IsValidSize(aWidth, aHeight)) {
+    return false;
+  }
+  return libyuv::NV21ToI420(aSrcY, aSrcStrideY, aSrcVU, aSrcStrideVU, aDstY,
+                            aDstStrideY, aDstU, aDstStrideU, aDstV,
+                            aDstStrideV, aWidth, aHeight) == 0;
+}
+
+bool ConvertI420ToRGBX8888(const uint8_t* aSrcY, int aSrcStrideY,
+                           const uint8_t* aSrcU, int aSrcStrideU,
+                           const uint8_t* aSrcV, int aSrcStrideV,
+                           uint8_t* aDst, int aDstStride, int aWidth,
+                           int aHeight) {
+  if (!IsValidSize(aWidth, aHeight)) {
+    return false;
+  }
+  // libyuv's "ABGR" is R,G,B,A in memory, i.e. HAL_PIXEL_FORMAT_RGBA_8888.
+  return libyuv::I420ToABGR(aSrcY, aSrcStrideY, aSrcU, aSrcStrideU, aSrcV,
+                            aSrcStrideV, aDst, aDstStride, aWidth,
+                            aHeight) == 0;
+}
+
+bool ScaleRGBA8888(const uint8_t* aSrc, int aSrcStride, int aSrcWidth,
+                   int aSrcHeight, uint8_t* aDst, int aDstStride,
+                   int aDstWidth, int aDstHeight) {
+  if (!IsValidSize(aSrcWidth, aSrcHeight) ||
+      !IsValidSize(aDstWidth, aDstHeight)) {
+    return false;
+  }
+  return libyuv::ARGBScale(aSrc, aSrcStride, aSrcWidth, aSrcHeight, aDst,
+                           aDstStride, aDstWidth, aDstHeight,
+                           libyuv::kFilterBilinear) == 0;
+}
+
+bool ScaleI420ToRGBX8888(const uint8_t* aSrcY, int aSrcStrideY,
+                         const uint8_t* aSrcU, int aSrcStrideU,
+                         const uint8_t* aSrcV, int aSrcStrideV, int aSrcWidth,
+                         int aSrcHeight, uint8_t* aDst, int aDstStride,
+                         int aDstWidth, int aDstHeight) {
+  if (!IsValidSize(aSrcWidth, aSrcHeight) ||
+      !IsValidSize(aDstWidth, aDstHeight)) {
+    return false;
+  }
+
+  if (aSrcWidth == aDstWidth && aSrcHeight == aDstHeight) {
+    return ConvertI420ToRGBX8888(aSrcY, aSrcStrideY, aSrcU, aSrcStrideU, aSrcV,
+                                 aSrcStrideV, aDst, aDstStride, aDstWidth,
+                                 aDstHeight);
+  }
+
+  // Scale in YUV first: for the usual thumbnail case the destination is far
+  // smaller than the source, so this converts the fewest pixels.
+  int chromaWidth = (aDstWidth + 1) / 2;
+  int chromaHeight = (aDstHeight + 1) / 2;
+  size_t lumaSize = size_t(aDstWidth) * aDstHeight;
+  size_t chromaSize = size_t(chromaWidth) * chromaHeight;
+  UniquePtr<uint8_t[]> scaled = MakeUnique<uint8_t[]>(lumaSize + 2 * chromaSize);
+  uint8_t* y = scaled.get();
+  uint8_t* u = y + lumaSize;
+  uint8_t* v = u + chromaSize;
+
+  if (libyuv::I420Scale(aSrcY, aSrcStrideY, aSrcU, aSrcStrideU, aSrcV,
+                        aSrcStrideV, aSrcWidth, aSrcHeight, y, aDstWidth, u,
+                        chromaWidth, v, chromaWidth, aDstWidth, aDstHeight,
+                        libyuv::kFilterBilinear)) {
+    return false;
+  }
+  return ConvertI420ToRGBX8888(y, aDstWidth, u, chromaWidth, v, chromaWidth,
+                               aDst, aDstStride, aDstWidth, aDstHeight);
+}
+
+}  // namespace gonk
+}  // namespace mozilla
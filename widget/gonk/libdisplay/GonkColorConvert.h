@@ -0,0 +1,86 @@
+/* Copyright (C) 2020 KAI OS TECHNOLOGIES (HONG KONG) LIMITED. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GONK_COLOR_CONVERT_H
+#define GONK_COLOR_CONVERT_H
+
+#include <stdint.h>
+
+namespace mozilla {
+namespace gonk {
+
+/**
+ * Colour conversion helpers shared by the display, screenshot, camera and
+ * video decoder code on gonk.
+ *
+ * All byte orders below are memory orders, the same as the Android
+ * HAL_PIXEL_FORMAT_* names: RGBA_8888 is R,G,B,A bytes and RGB_565 is a
+ * native-endian 16-bit word with red in the top bits. Strides are in bytes.
+ *
+ * The implementations pick a NEON code path at runtime when the CPU has it
+ * (through libyuv, or our own kernel for RGBA->565) and otherwise fall back
+ * to portable C, so callers never need to care about the target.
+ *
+ * Every function returns false if the arguments are invalid or the
+ * underlying converter failed; the destination is then left unspecified.
+ */
+
+// RGBA_8888 / RGBX_8888 -> RGB_565. Alpha is dropped.
+bool ConvertRGBA8888ToRGB565(const uint8_t* aSrc, int aSrcStride,
+                             uint8_t* aDst, int aDstStride, int aWidth,
+                             int aHeight);
+
+// RGB_565 -> RGB_888 (R,G,B bytes), e.g. for PNG encoding.
+bool ConvertRGB565ToRGB888(const uint8_t* aSrc, int aSrcStride, uint8_t* aDst,
+                           int aDstStride, int aWidth, int aHeight);
+
+// Semi-planar 4:2:0 -> I420. NV12 has the chroma plane ordered U,V and NV21
+// (the camera preview format) orders it V,U.
+bool ConvertNV12ToI420(const uint8_t* aSrcY, int aSrcStrideY,
+                       const uint8_t* aSrcUV, int aSrcStrideUV, uint8_t* aDstY,
+                       int aDstStrideY, uint8_t* aDstU, int aDstStrideU,
+                       uint8_t* aDstV, int aDstStrideV, int aWidth,
+                       int aHeight);
+
+bool ConvertNV21ToI420(const uint8_t* aSrcY, int aSrcStrideY,
+                       const uint8_t* aSrcVU, int aSrcStrideVU, uint8_t* aDstY,
+                       int aDstStrideY, uint8_t* aDstU, int aDstStrideU,
+                       uint8_t* aDstV, int aDstStrideV, int aWidth,
+                       int aHeight);
+
+// I420 -> RGBX_8888. The X byte is written as 0xff.
+bool ConvertI420ToRGBX8888(const uint8_t* aSrcY, int aSrcStrideY,
+                           const uint8_t* aSrcU, int aSrcStrideU,
+                           const uint8_t* aSrcV, int aSrcStrideV,
+                           uint8_t* aDst, int aDstStride, int aWidth,
+                           int aHeight);
+
+// Bilinear scale of a 32bpp image. The channel order is preserved.
+bool ScaleRGBA8888(const uint8_t* aSrc, int aSrcStride, int aSrcWidth,
+                   int aSrcHeight, uint8_t* aDst, int aDstStride,
+                   int aDstWidth, int aDstHeight);
+
+// Scale-and-convert in one call, used for thumbnails of video and camera
+// frames: the I420 source is scaled and then converted to RGBX_8888.
+bool ScaleI420ToRGBX8888(const uint8_t* aSrcY, int aSrcStrideY,
+                         const uint8_t* aSrcU, int aSrcStrideU,
+                         const uint8_t* aSrcV, int aSrcStrideV, int aSrcWidth,
+                         int aSrcHeight, uint8_t* aDst, int aDstStride,
+                         int aDstWidth, int aDstHeight);
+
+}  // namespace gonk
+}  // namespace mozilla
+
+#endif /* GONK_COLOR_CONVERT_H */
@@ -24,6 +24,8 @@
 #include <hardware/hwcomposer.h>
 #include <hardware/power.h>
 #include <suspend/autosuspend.h>
+#include <utils/Timers.h>
+#include <inttypes.h>
 
 #include "cutils/properties.h"
 #include "FramebufferSurface.h"
@@ -210,6 +212,7 @@ GonkDisplayP::GonkDisplayP()
   DisplayUtils displayUtils;
   displayUtils.type = DisplayUtils::MAIN;
   displayUtils.utils.hwcDisplay = mHwcDisplay;
+  displayUtils.hwcLayer = mlayer;
   // disable mDispSurface by default to avoid updating frame during boot
   // animation is being played.
   CreateFramebufferSurface(mSTClient, mDispSurface, config->getWidth(),
@@ -224,6 +227,7 @@ GonkDisplayP::GonkDisplayP()
   (void)mlayerBootAnim->setDisplayFrame(r);
   (void)mlayerBootAnim->setVisibleRegion(Region(r));
 
+  displayUtils.hwcLayer = mlayerBootAnim;
   CreateFramebufferSurface(mBootAnimSTClient, mBootAnimDispSurface,
                            config->getWidth(), config->getHeight(),
                            dispData.mSurfaceformat, displayUtils, true);
@@ -260,6 +264,7 @@ GonkDisplayP::GonkDisplayP()
 
       displayUtils.type = DisplayUtils::EXTERNAL;
       displayUtils.utils.extFBDevice = mExtFBDevice;
+      displayUtils.hwcLayer = nullptr;
       CreateFramebufferSurface(mExtSTClient, mExtDispSurface,
                                extDispData.mWidth, extDispData.mHeight,
                                extDispData.mSurfaceformat, displayUtils, true);
@@ -306,26 +311,42 @@ void GonkDisplayP::CreateFramebufferSurface(
   nativeWindow = new Surface(producer, true);
 }
 
+// Mirrors the primary display into |sink| with a virtual display of the HWC
+// when it has one, so that the frame composed for the primary display is
+// scaled into the sink in the same pass. Otherwise the screen gets a window on
+// the sink for the compositor to compose into with GL. Setting
+// persist.b2g.mirroring.hwc to false always takes the GL path.
 void GonkDisplayP::CreateVirtualDisplaySurface(
     IGraphicBufferProducer* sink, sp<ANativeWindow>& nativeWindow,
-    sp<DisplaySurface>& displaySurface) {
-  /* TODO: implement VirtualDisplay*/
-  (void)sink;
-  (void)nativeWindow;
+    sp<DisplaySurface>& displaySurface,
+    sp<HwcVirtualDisplay>& hwcVirtualDisplay) {
   (void)displaySurface;
+  if (!sink) {
+    return;
+  }
 
-  /* FIXME: bug 4036, fix the build error in libdisplay
-  #if ANDROID_VERSION >= 19
-      sp<VirtualDisplaySurface> virtualDisplay;
-      virtualDisplay = new VirtualDisplaySurface(-1, aSink, producer, consumer,
-  String8("VirtualDisplaySurface")); aDisplaySurface = virtualDisplay;
-      aNativeWindow = new Surface(virtualDisplay);
-  #endif*/
+  if (property_get_bool("persist.b2g.mirroring.hwc", true)) {
+    const DisplayNativeData& primary =
+        mDispNativeData[(uint32_t)DisplayType::DISPLAY_PRIMARY];
+    hwcVirtualDisplay = HwcVirtualDisplay::Create(mHwc.get(), sink,
+                                                  primary.mWidth,
+                                                  primary.mHeight);
+  }
+
+  if (hwcVirtualDisplay.get()) {
+    static_cast<FramebufferSurface*>(mDispSurface.get())
+        ->setMirror(hwcVirtualDisplay);
+    nativeWindow = hwcVirtualDisplay->getNativeWindow();
+  } else {
+    nativeWindow = new Surface(sink, true);
+  }
 }
 
 void GonkDisplayP::SetEnabled(bool enabled) {
   android::Mutex::Autolock lock(mPrimaryScreenLock);
   if (enabled) {
+    nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    nsecs_t poweredOn = start;
     if (!mExtFBEnabled) {
       autosuspend_disable();
       mPower->setInteractive(true);
@@ -335,6 +356,14 @@ void GonkDisplayP::SetEnabled(bool enabled) {
       } else if (mFBDevice && mFBDevice->enableScreen) {
         mFBDevice->enableScreen(mFBDevice, enabled);
       }
+      poweredOn = systemTime(SYSTEM_TIME_MONOTONIC);
+
+      // Light the panel with the last committed frame straight away. The
+      // display work thread presents it while the compositor produces a fresh
+      // frame, which is queued behind it on the same thread.
+      if (mDispSurface.get() && !mBootAnimSTClient.get()) {
+        mDispSurface->repostCurrentFrame();
+      }
     }
     mFBEnabled = enabled;
 
@@ -342,6 +371,10 @@ void GonkDisplayP::SetEnabled(bool enabled) {
     if (mEnabledCallback && !mExtFBEnabled) {
       mEnabledCallback(enabled);
     }
+
+    ALOGI("SetEnabled: power on %" PRId64 " us, vsync enabled %" PRId64 " us",
+          ns2us(poweredOn - start),
+          ns2us(systemTime(SYSTEM_TIME_MONOTONIC) - start));
   } else {
     if (mEnabledCallback && !mExtFBEnabled) {
       mEnabledCallback(enabled);
@@ -601,7 +634,8 @@ GonkDisplay::NativeData GonkDisplayP::GetNativeData(
   } else if (displayType == DisplayType::DISPLAY_VIRTUAL) {
     data.mXdpi = mDispNativeData[(uint32_t)DisplayType::DISPLAY_PRIMARY].mXdpi;
     CreateVirtualDisplaySurface(sink, data.mNativeWindow,
-                                data.mDisplaySurface);
+                                data.mDisplaySurface,
+                                data.mHwcVirtualDisplay);
   }
 
   return data;
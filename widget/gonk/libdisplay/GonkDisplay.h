@@ -20,6 +20,7 @@
 #include <system/window.h>
 #include <utils/StrongPointer.h>
 #include "DisplaySurface.h"
+#include "HwcVirtualDisplay.h"
 #include "nsIScreen.h"
 
 namespace android {
@@ -43,6 +44,9 @@ class MOZ_EXPORT GonkDisplay {
     // event occurs on this screen. We use it as a hint to create relative
     // VsyncSource::Display and VsyncScheduler.
     bool mVsyncSupported;
+    // Set on a virtual display while the HWC mirrors the primary display
+    // into it, see HwcVirtualDisplay. It doesn't need to be composed then.
+    android::sp<android::HwcVirtualDisplay> mHwcVirtualDisplay;
   };
 
   struct DisplayNativeData {
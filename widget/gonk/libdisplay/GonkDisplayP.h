@@ -85,7 +85,8 @@ private:
 
     void CreateVirtualDisplaySurface(IGraphicBufferProducer* aSink,
         sp<ANativeWindow>& aNativeWindow,
-        sp<DisplaySurface>& aDisplaySurface);
+        sp<DisplaySurface>& aDisplaySurface,
+        sp<HwcVirtualDisplay>& aHwcVirtualDisplay);
 
     void PowerOnDisplay(int aDpy);
 
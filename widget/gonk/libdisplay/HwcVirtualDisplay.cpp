@@ -0,0 +1,177 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <errno.h>
+#include <string.h>
+#include <cutils/log.h>
+#include <hardware/gralloc.h>
+#include <system/window.h>
+#include <ui/Rect.h>
+#include <ui/Region.h>
+
+#include "GonkDisplay.h"
+#include "HwcHAL.h"  // for HWC2
+
+#include "HwcVirtualDisplay.h"
+
+#ifdef LOG_TAG
+#  undef LOG_TAG
+#  define LOG_TAG "HwcVirtualDisplay"
+#endif
+
+// ----------------------------------------------------------------------------
+namespace android {
+// ----------------------------------------------------------------------------
+
+/* static */
+sp<HwcVirtualDisplay> HwcVirtualDisplay::Create(
+    HWC2::Device* hwc, const sp<IGraphicBufferProducer>& sink,
+    uint32_t sourceWidth, uint32_t sourceHeight) {
+  if (!hwc || !sink.get() || !hwc->getMaxVirtualDisplayCount()) {
+    return nullptr;
+  }
+
+  sp<Surface> surface = new Surface(sink, true);
+  ANativeWindow* window = surface.get();
+  int width = 0;
+  int height = 0;
+  window->query(window, NATIVE_WINDOW_DEFAULT_WIDTH, &width);
+  window->query(window, NATIVE_WINDOW_DEFAULT_HEIGHT, &height);
+  if (width <= 0 || height <= 0) {
+    width = sourceWidth;
+    height = sourceHeight;
+  }
+
+  ui::PixelFormat format = ui::PixelFormat::RGBA_8888;
+  HWC2::Display* display = nullptr;
+  HWC2::Error error =
+      hwc->createVirtualDisplay(width, height, &format, &display);
+  if (error != HWC2::Error::None || !display) {
+    ALOGI("no %dx%d virtual display: %s (%d)", width, height,
+          to_string(error).c_str(), static_cast<int32_t>(error));
+    return nullptr;
+  }
+
+  HWC2::Layer* layer = nullptr;
+  if (display->createLayer(&layer) != HWC2::Error::None) {
+    hwc->destroyDisplay(display->getId());
+    return nullptr;
+  }
+
+  // Keep the aspect ratio of the primary display, centered in the sink.
+  Rect frame(width, height);
+  if (uint64_t(sourceWidth) * height > uint64_t(sourceHeight) * width) {
+    int32_t h = uint64_t(sourceHeight) * width / sourceWidth;
+    frame = Rect(0, (height - h) / 2, width, (height - h) / 2 + h);
+  } else {
+    int32_t w = uint64_t(sourceWidth) * height / sourceHeight;
+    frame = Rect((width - w) / 2, 0, (width - w) / 2 + w, height);
+  }
+  (void)layer->setCompositionType(HWC2::Composition::Device);
+  (void)layer->setBlendMode(HWC2::BlendMode::None);
+  (void)layer->setSourceCrop(FloatRect(0.0f, 0.0f, sourceWidth, sourceHeight));
+  (void)layer->setDisplayFrame(frame);
+  (void)layer->setVisibleRegion(Region(frame));
+
+  int err = native_window_api_connect(window, NATIVE_WINDOW_API_EGL);
+  if (err != NO_ERROR) {
+    ALOGE("can't connect to the sink: %s (%d)", strerror(-err), err);
+    (void)display->destroyLayer(layer);
+    hwc->destroyDisplay(display->getId());
+    return nullptr;
+  }
+  native_window_set_buffers_format(window, static_cast<int>(format));
+  native_window_set_buffers_dimensions(window, width, height);
+  native_window_set_usage(
+      window, GRALLOC_USAGE_HW_COMPOSER | GRALLOC_USAGE_HW_VIDEO_ENCODER);
+
+  ALOGI("mirroring %ux%u into %dx%d with the HWC", sourceWidth, sourceHeight,
+        width, height);
+  return new HwcVirtualDisplay(hwc, display, layer, surface);
+}
+
+HwcVirtualDisplay::HwcVirtualDisplay(HWC2::Device* hwc,
+                                     HWC2::Display* display,
+                                     HWC2::Layer* layer,
+                                     const sp<Surface>& sink)
+    : mHwc(hwc),
+      mDisplay(display),
+      mLayer(layer),
+      mSink(sink),
+      mActive(true) {}
+
+HwcVirtualDisplay::~HwcVirtualDisplay() {
+  if (mActive) {
+    native_window_api_disconnect(mSink.get(), NATIVE_WINDOW_API_EGL);
+  }
+  (void)mDisplay->destroyLayer(mLayer);
+  mHwc->destroyDisplay(mDisplay->getId());
+}
+
+void HwcVirtualDisplay::present(int slot, const sp<GraphicBuffer>& buffer,
+                                const sp<Fence>& acquireFence) {
+  if (!mActive) {
+    return;
+  }
+
+  ANativeWindowBuffer* out = nullptr;
+  int releaseFenceFd = -1;
+  int err = mSink->dequeueBuffer(mSink.get(), &out, &releaseFenceFd);
+  if (err != NO_ERROR) {
+    // The encoder went away.
+    ALOGW("can't dequeue a sink buffer: %s (%d)", strerror(-err), err);
+    stop();
+    return;
+  }
+
+  uint32_t numTypes = 0;
+  uint32_t numRequests = 0;
+  sp<Fence> presentFence = Fence::NO_FENCE;
+  (void)mLayer->setBuffer(slot, buffer, acquireFence);
+  (void)mDisplay->setOutputBuffer(GraphicBuffer::from(out),
+                                  new Fence(releaseFenceFd));
+  HWC2::Error error = mDisplay->validate(&numTypes, &numRequests);
+  if ((error != HWC2::Error::None && error != HWC2::Error::HasChanges) ||
+      numTypes) {
+    // The HWC wants the layer composed by GL, which is what we avoid.
+    ALOGI("HWC declined the mirrored frame: %s (%d)",
+          to_string(error).c_str(), static_cast<int32_t>(error));
+    goto Declined;
+  }
+
+  error = mDisplay->acceptChanges();
+  if (error == HWC2::Error::None) {
+    error = mDisplay->present(&presentFence);
+  }
+  if (error != HWC2::Error::None) {
+    ALOGE("present failed: %s (%d)", to_string(error).c_str(),
+          static_cast<int32_t>(error));
+    goto Declined;
+  }
+
+  // The output buffer is written once the present fence signals.
+  mSink->queueBuffer(mSink.get(), out,
+                     presentFence->isValid() ? presentFence->dup() : -1);
+  return;
+
+Declined:
+  mSink->cancelBuffer(mSink.get(), out, -1);
+  stop();
+}
+
+void HwcVirtualDisplay::stop() {
+  mActive = false;
+  native_window_api_disconnect(mSink.get(), NATIVE_WINDOW_API_EGL);
+
+  // Have the screen composed again, with GL this time.
+  mozilla::GonkDisplay::GonkDisplayInvalidateCBFun invalidate =
+      mozilla::GetGonkDisplay()->getInvalidateCallBack();
+  if (invalidate) {
+    invalidate();
+  }
+}
+
+// ----------------------------------------------------------------------------
+}  // namespace android
+// ----------------------------------------------------------------------------
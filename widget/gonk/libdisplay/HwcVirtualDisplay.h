@@ -0,0 +1,81 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef ANDROID_HWC_VIRTUAL_DISPLAY_H
+#define ANDROID_HWC_VIRTUAL_DISPLAY_H
+
+#include <atomic>
+#include <stdint.h>
+
+#include <gui/Surface.h>
+#include <ui/Fence.h>
+#include <ui/GraphicBuffer.h>
+#include <utils/RefBase.h>
+
+namespace HWC2 {
+class Device;
+class Display;
+class Layer;
+}  // namespace HWC2
+
+// ---------------------------------------------------------------------------
+namespace android {
+// ---------------------------------------------------------------------------
+
+class IGraphicBufferProducer;
+
+/*
+ * Mirrors the primary display into a sink, like the input surface of a
+ * hardware encoder streaming to a cast dongle, with a virtual display of the
+ * hardware composer.
+ *
+ * Each frame presented on the primary display is handed to the virtual
+ * display as a layer that the HWC scales, usually with its writeback engine,
+ * into the next buffer of the sink. The screen is composed once by GL for the
+ * primary display instead of twice.
+ *
+ * When the HWC can't do it, because it has no virtual display to spare or
+ * asks for the layer to be composed by GL, the mirror stops and disconnects
+ * from the sink so that the screen can be composed into it with GL instead.
+ */
+class HwcVirtualDisplay : public RefBase {
+ public:
+  // Returns nullptr if the HWC can't drive a virtual display of the size of
+  // |sink|. |sourceWidth| and |sourceHeight| are the size of the primary
+  // display, which is letterboxed into the sink.
+  static sp<HwcVirtualDisplay> Create(HWC2::Device* hwc,
+                                      const sp<IGraphicBufferProducer>& sink,
+                                      uint32_t sourceWidth,
+                                      uint32_t sourceHeight);
+
+  // Composes |buffer|, just presented on the primary display, into the next
+  // buffer of the sink. Called on the display work thread.
+  void present(int slot, const sp<GraphicBuffer>& buffer,
+               const sp<Fence>& acquireFence);
+
+  // The window on the sink, connected for the HWC while it is active.
+  sp<ANativeWindow> getNativeWindow() const { return mSink; }
+
+  // False once the HWC declined a frame or the sink went away.
+  bool isActive() const { return mActive; }
+
+ private:
+  HwcVirtualDisplay(HWC2::Device* hwc, HWC2::Display* display,
+                    HWC2::Layer* layer, const sp<Surface>& sink);
+  virtual ~HwcVirtualDisplay();
+
+  void stop();
+
+  HWC2::Device* mHwc;
+  HWC2::Display* mDisplay;
+  HWC2::Layer* mLayer;
+  sp<Surface> mSink;
+  std::atomic<bool> mActive;
+};
+
+// ---------------------------------------------------------------------------
+}  // namespace android
+// ---------------------------------------------------------------------------
+
+#endif  // ANDROID_HWC_VIRTUAL_DISPLAY_H
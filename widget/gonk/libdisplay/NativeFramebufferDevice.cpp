@@ -17,18 +17,16 @@
  */
 
 #include <fcntl.h>
+#include <algorithm>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
 
 #include "cutils/properties.h"
+#include "GonkColorConvert.h"
 #include "NativeFramebufferDevice.h"
 #include "NativeGralloc.h"
 #include "utils/Log.h"
 
-#ifdef BUILD_ARM_NEON
-#  include "rgb8888_to_rgb565_neon.h"
-#endif
-
 #define DEFAULT_XDPI 75.0
 
 // ----------------------------------------------------------------------------
@@ -39,26 +37,6 @@ inline unsigned int roundUpToPageSize(unsigned int x) {
   return (x + (PAGE_SIZE - 1)) & ~(PAGE_SIZE - 1);
 }
 
-inline void Transform8888To565_Software(uint8_t* outbuf, const uint8_t* inbuf,
-                                        int PixelNum) {
-  uint32_t bytes = PixelNum * 4;
-  uint16_t* out = (uint16_t*)outbuf;
-  uint8_t* in = (uint8_t*)inbuf;
-  for (uint32_t i = 0; i < bytes; i += 4) {
-    *out++ =
-        ((in[i] & 0xF8) << 8) | ((in[i + 1] & 0xFC) << 3) | ((in[i + 2]) >> 3);
-  }
-}
-
-inline void Transform8888To565(uint8_t* outbuf, const uint8_t* inbuf,
-                               int PixelNum) {
-#ifdef BUILD_ARM_NEON
-  Transform8888To565_NEON(outbuf, inbuf, PixelNum);
-#else
-  Transform8888To565_Software(outbuf, inbuf, PixelNum);
-#endif
-}
-
 NativeFramebufferDevice::NativeFramebufferDevice(int aExtFbFd)
     : mWidth(320),
       mHeight(480),
@@ -68,7 +46,8 @@ NativeFramebufferDevice::NativeFramebufferDevice(int aExtFbFd)
       mFd(aExtFbFd),
       mMappedAddr(nullptr),
       mMemLength(0),
-      mGrmodule(nullptr) {}
+      mGrmodule(nullptr),
+      mNeedsFullUpdate(true) {}
 
 NativeFramebufferDevice::~NativeFramebufferDevice() { Close(); }
 
@@ -208,26 +187,47 @@ bool NativeFramebufferDevice::Open() {
   //       gecko should be different then fb format.
   mSurfaceformat = mFBSurfaceformat;
   mIsEnabled = true;
+  mNeedsFullUpdate = true;
 
   return true;
 }
 
-bool NativeFramebufferDevice::Post(buffer_handle_t buf) {
+bool NativeFramebufferDevice::Post(buffer_handle_t buf,
+                                   const android::Rect& aDamage) {
   android::Mutex::Autolock lock(mMutex);
 
+  // We copy whole rows, which keeps the copy contiguous and is good enough
+  // for the typical damage of a clock or a status bar.
+  uint32_t top = 0;
+  uint32_t bottom = mVInfo.yres;
+  if (!mNeedsFullUpdate) {
+    top = std::min<uint32_t>(std::max(aDamage.top, 0), mVInfo.yres);
+    bottom = std::min<uint32_t>(std::max(aDamage.bottom, 0), mVInfo.yres);
+    if (top >= bottom) {
+      return true;
+    }
+  }
+  mNeedsFullUpdate = false;
+
   void* vaddr;
-  if (native_gralloc_lock(buf, GRALLOC_USAGE_SW_READ_RARELY, 0, 0, mVInfo.xres,
-                          mVInfo.yres, &vaddr)) {
+  if (native_gralloc_lock(buf, GRALLOC_USAGE_SW_READ_RARELY, 0, top,
+                          mVInfo.xres, bottom - top, &vaddr)) {
     ALOGE("Failed to lock buffer_handle_t");
     return false;
   }
 
+  // The locked address is always the start of the buffer, whatever the
+  // locked rectangle is.
   if (mFBSurfaceformat == HAL_PIXEL_FORMAT_RGB_565 &&
       mSurfaceformat == HAL_PIXEL_FORMAT_RGBA_8888) {
-    Transform8888To565((uint8_t*)mMappedAddr, (uint8_t*)vaddr,
-                       mVInfo.xres * mVInfo.yres);
+    gonk::ConvertRGBA8888ToRGB565(
+        (uint8_t*)vaddr + top * mVInfo.xres * 4, mVInfo.xres * 4,
+        (uint8_t*)mMappedAddr + top * mVInfo.xres * 2, mVInfo.xres * 2,
+        mVInfo.xres, bottom - top);
   } else {
-    memcpy(mMappedAddr, vaddr, mFInfo.line_length * mVInfo.yres);
+    memcpy((uint8_t*)mMappedAddr + top * mFInfo.line_length,
+           (uint8_t*)vaddr + top * mFInfo.line_length,
+           mFInfo.line_length * (bottom - top));
   }
 
   native_gralloc_unlock(buf);
@@ -267,6 +267,7 @@ void NativeFramebufferDevice::DrawSolidColorFrame() {
   }
 
   memset(mMappedAddr, 0, mMemLength);
+  mNeedsFullUpdate = true;
 
   mVInfo.activate = FB_ACTIVATE_VBL;
 
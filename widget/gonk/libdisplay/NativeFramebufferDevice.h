@@ -20,6 +20,7 @@
 #include <hardware/gralloc.h>
 #include <linux/fb.h>
 #include <system/window.h>
+#include <ui/Rect.h>
 #include <utils/Mutex.h>
 
 // ----------------------------------------------------------------------------
@@ -34,7 +35,9 @@ public:
 
     bool Open();
 
-    bool Post(buffer_handle_t buf);
+    // Only the rows covered by aDamage are copied to the framebuffer, the
+    // rest of it is expected to still hold the previous frame.
+    bool Post(buffer_handle_t buf, const android::Rect& aDamage);
 
     bool EnableScreen(int enabled);
 
@@ -59,6 +62,9 @@ private:
     struct fb_fix_screeninfo mFInfo;
     gralloc_module_t *mGrmodule;
     int32_t mFBSurfaceformat;
+    // Set when the framebuffer contents no longer match the last posted
+    // buffer, e.g. after it was cleared, so the next Post() is a full one.
+    bool mNeedsFullUpdate;
 
     // Locks against both mFd and mIsEnable.
     mutable android::Mutex mMutex;
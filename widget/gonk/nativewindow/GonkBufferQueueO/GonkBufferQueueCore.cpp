@@ -29,9 +29,11 @@
 #include <private/gui/ComposerService.h>
 
 #include <cutils/compiler.h>
+#include <cutils/properties.h>
 #include "mozilla/Atomics.h"
 #include "mozilla/layers/GrallocTextureClient.h"
 #include "mozilla/layers/ImageBridgeChild.h"
+#include "nsThreadUtils.h"
 
 namespace android {
 
@@ -64,11 +66,27 @@ GonkBufferQueueCore::GonkBufferQueueCore()
       mFrameCounter(0),
       mTransformHint(0),
       mIsAllocating(false),
-      mIsAllocatingCondition() {
+      mIsAllocatingCondition(),
+      mDynamicBufferCount(true),
+      mExtraBufferCount(0),
+      mLastBlockedTime(0),
+      mShrinkScheduled(false),
+      mBuffersFreed(false) {
   ALOGV("GonkBufferQueueCore");
+
+  char value[PROPERTY_VALUE_MAX];
+  property_get("persist.b2g.bufferqueue.dynamic", value, "1");
+  mDynamicBufferCount = atoi(value) != 0;
 }
 
-GonkBufferQueueCore::~GonkBufferQueueCore() {}
+GonkBufferQueueCore::~GonkBufferQueueCore() {
+  if (mDequeueStats.mWaits) {
+    ALOGI("%s: %" PRIu64 " of %" PRIu64 " dequeues waited, %" PRId64
+          " ms in total",
+          mConsumerName.string(), mDequeueStats.mWaits,
+          mDequeueStats.mDequeues, ns2ms(mDequeueStats.mTotalWaitTime));
+  }
+}
 
 void GonkBufferQueueCore::dump(String8& result, const char* prefix) const {
   Mutex::Autolock lock(mMutex);
@@ -94,6 +112,13 @@ void GonkBufferQueueCore::dump(String8& result, const char* prefix) const {
       mDefaultHeight, mDefaultBufferFormat, mTransformHint, mQueue.size(),
       fifo.string());
 
+  result.appendFormat(
+      "%s  dequeues=%" PRIu64 " waits=%" PRIu64 " wait-total=%" PRId64
+      "ms wait-max=%" PRId64 "ms extra-buffers=%d grows=%u shrinks=%u\n",
+      prefix, mDequeueStats.mDequeues, mDequeueStats.mWaits,
+      ns2ms(mDequeueStats.mTotalWaitTime), ns2ms(mDequeueStats.mMaxWaitTime),
+      mExtraBufferCount, mDequeueStats.mGrows, mDequeueStats.mShrinks);
+
   // Trim the free buffers so as to not spam the dump
   int maxBufferCount = 0;
   for (int s = GonkBufferQueueDefs::NUM_BUFFER_SLOTS - 1; s >= 0; --s) {
@@ -144,7 +169,8 @@ int GonkBufferQueueCore::getMinMaxBufferCountLocked(bool async) const {
 int GonkBufferQueueCore::getMaxBufferCountLocked(bool async) const {
   int minMaxBufferCount = getMinMaxBufferCountLocked(async);
 
-  int maxBufferCount = std::max(mDefaultMaxBufferCount, minMaxBufferCount);
+  int maxBufferCount =
+      std::max(mDefaultMaxBufferCount + mExtraBufferCount, minMaxBufferCount);
   if (mOverrideMaxBufferCount != 0) {
     assert(mOverrideMaxBufferCount >= minMaxBufferCount);
     maxBufferCount = mOverrideMaxBufferCount;
@@ -238,4 +264,98 @@ void GonkBufferQueueCore::waitWhileAllocatingLocked() const {
   }
 }
 
+bool GonkBufferQueueCore::growBufferCountLocked(bool async) {
+  mLastBlockedTime = systemTime(SYSTEM_TIME_MONOTONIC);
+  if (!mDynamicBufferCount || mOverrideMaxBufferCount || mExtraBufferCount) {
+    return false;
+  }
+
+  int maxBufferCount = getMaxBufferCountLocked(async);
+  if (maxBufferCount >= GonkBufferQueueDefs::NUM_BUFFER_SLOTS) {
+    return false;
+  }
+  mExtraBufferCount = 1;
+  if (getMaxBufferCountLocked(async) == maxBufferCount) {
+    // The count is already kept up by the async buffer or the slots in use.
+    mExtraBufferCount = 0;
+    return false;
+  }
+
+  ALOGV("growBufferCountLocked: growing to %d", maxBufferCount + 1);
+  mDequeueStats.mGrows++;
+  if (!mShrinkScheduled) {
+    scheduleShrinkLocked(kShrinkIdleTime);
+  }
+  return true;
+}
+
+void GonkBufferQueueCore::scheduleShrinkLocked(nsecs_t delay) {
+  RefPtr<ImageBridgeChild> imageBridge = ImageBridgeChild::GetSingleton();
+  if (!imageBridge) {
+    return;
+  }
+
+  wp<GonkBufferQueueCore> weakThis(this);
+  auto shrink = [weakThis]() {
+    sp<GonkBufferQueueCore> core = weakThis.promote();
+    if (core != NULL) {
+      core->shrinkBufferCount();
+    }
+  };
+  RefPtr<Runnable> task = NS_NewRunnableFunction(
+      "GonkBufferQueueCore::shrinkBufferCount", shrink);
+  mShrinkScheduled = true;
+  imageBridge->GetThread()->DelayedDispatch(task.forget(), ns2ms(delay) + 1);
+}
+
+void GonkBufferQueueCore::shrinkBufferCount() {
+  sp<IConsumerListener> listener;
+  {  // Autolock scope
+    Mutex::Autolock lock(mMutex);
+    mShrinkScheduled = false;
+    if (mIsAbandoned || !mExtraBufferCount) {
+      return;
+    }
+
+    nsecs_t idle = systemTime(SYSTEM_TIME_MONOTONIC) - mLastBlockedTime;
+    if (idle < kShrinkIdleTime) {
+      scheduleShrinkLocked(kShrinkIdleTime - idle);
+      return;
+    }
+    // Slots being allocated into by dequeueBuffer are DEQUEUED, so they
+    // are not freed below.
+    mExtraBufferCount = 0;
+    mDequeueStats.mShrinks++;
+    if (freeBuffersBeyondMaxLocked(false)) {
+      listener = mConsumerListener;
+    }
+    ALOGI("%s: back to %d buffers, %" PRIu64 " of %" PRIu64
+          " dequeues waited, %" PRId64 " ms at most",
+          mConsumerName.string(), getMaxBufferCountLocked(false),
+          mDequeueStats.mWaits, mDequeueStats.mDequeues,
+          ns2ms(mDequeueStats.mMaxWaitTime));
+  }  // Autolock scope
+
+  // Call back without lock held
+  if (listener != NULL) {
+    listener->onBuffersReleased();
+  }
+}
+
+bool GonkBufferQueueCore::freeBuffersBeyondMaxLocked(bool async) {
+  bool freed = false;
+  for (int s = getMaxBufferCountLocked(async);
+       s < GonkBufferQueueDefs::NUM_BUFFER_SLOTS; ++s) {
+    if (mSlots[s].mBufferState == GonkBufferSlot::FREE &&
+        mSlots[s].mGraphicBuffer != NULL) {
+      freeBufferLocked(s);
+      freed = true;
+    }
+  }
+  if (freed) {
+    mBuffersFreed = true;
+  }
+  return freed;
+}
+
 }  // namespace android
@@ -27,6 +27,7 @@
 #include <utils/RefBase.h>
 #include <utils/String8.h>
 #include <utils/StrongPointer.h>
+#include <utils/Timers.h>
 #include <utils/Trace.h>
 #include <utils/Vector.h>
 
@@ -120,6 +121,27 @@ class GonkBufferQueueCore : public virtual RefBase {
   // waitWhileAllocatingLocked blocks until mIsAllocating is false.
   void waitWhileAllocatingLocked() const;
 
+  // growBufferCountLocked lets the producer have one more buffer than the
+  // consumer asked for, when it is about to block on dequeueBuffer. It
+  // returns false if the buffer count is not dynamic, was set by the
+  // producer, or is already grown, in which case the producer has to wait.
+  bool growBufferCountLocked(bool async);
+
+  // shrinkBufferCount goes back to the buffer count of the consumer once
+  // the producer didn't block for kShrinkIdleTime, and frees the buffers of
+  // the slots that are then beyond it. It runs on the ImageBridge thread.
+  void shrinkBufferCount();
+  void scheduleShrinkLocked(nsecs_t delay);
+
+  // freeBuffersBeyondMaxLocked frees the buffers of the FREE slots beyond the
+  // max buffer count, which are left over from a grown buffer count. It
+  // returns true if any was freed.
+  bool freeBuffersBeyondMaxLocked(bool async);
+
+  // How long the producer must not block on dequeueBuffer before the extra
+  // buffer is freed, one second.
+  static constexpr nsecs_t kShrinkIdleTime = 1000000000;
+
   // mMutex is the mutex used to prevent concurrent access to the member
   // variables of GonkBufferQueueCore objects. It must be locked whenever any
   // member variable is accessed.
@@ -239,6 +261,36 @@ class GonkBufferQueueCore : public virtual RefBase {
   // mIsAllocatingCondition is a condition variable used by producers to wait
   // until mIsAllocating becomes false.
   mutable Condition mIsAllocatingCondition;
+
+  // mDynamicBufferCount indicates whether the producer gets an extra buffer
+  // while it would block on dequeueBuffer, as long as it didn't set the
+  // buffer count itself. It is read from persist.b2g.bufferqueue.dynamic.
+  bool mDynamicBufferCount;
+
+  // mExtraBufferCount is 1 while the buffer count is grown, 0 otherwise.
+  int mExtraBufferCount;
+
+  // mLastBlockedTime is when the producer last found no free slot.
+  nsecs_t mLastBlockedTime;
+
+  // mShrinkScheduled indicates whether shrinkBufferCount is pending.
+  bool mShrinkScheduled;
+
+  // mBuffersFreed indicates that buffers were freed by shrinkBufferCount,
+  // so the next dequeueBuffer has to tell the producer to drop its
+  // references to them with RELEASE_ALL_BUFFERS.
+  bool mBuffersFreed;
+
+  // mDequeueStats is how long the producer waited in dequeueBuffer. It is
+  // in dump() and logged when the buffer count shrinks.
+  struct DequeueStats {
+    uint64_t mDequeues = 0;
+    uint64_t mWaits = 0;
+    nsecs_t mTotalWaitTime = 0;
+    nsecs_t mMaxWaitTime = 0;
+    uint32_t mGrows = 0;
+    uint32_t mShrinks = 0;
+  } mDequeueStats;
 };  // class GonkBufferQueueCore
 
 }  // namespace android
@@ -183,6 +183,11 @@ status_t GonkBufferQueueProducer::waitForFreeSlotThenRelock(
     //        *returnFlags |= RELEASE_ALL_BUFFERS;
     //    }
     //}
+    // Only the extra buffer of a dynamic buffer count is freed that way,
+    // once the consumer released it; dequeueBuffer reports it.
+    if (mCore->mDynamicBufferCount) {
+      mCore->freeBuffersBeyondMaxLocked(async);
+    }
 
     // Look for a free buffer to give to the client
     *found = GonkBufferQueueCore::INVALID_BUFFER_SLOT;
@@ -254,6 +259,12 @@ status_t GonkBufferQueueProducer::waitForFreeSlotThenRelock(
     tryAgain =
         (*found == GonkBufferQueueCore::INVALID_BUFFER_SLOT) || tooManyBuffers;
     if (tryAgain) {
+      // Rather than blocking, have one more buffer if the buffer count is
+      // dynamic. It is freed again once the producer stops blocking.
+      if (!tooManyBuffers && mCore->growBufferCountLocked(async)) {
+        continue;
+      }
+
       // Return an error if we're in non-blocking mode (producer and
       // consumer are controlled by the application).
       // However, the consumer is allowed to briefly acquire an extra
@@ -264,7 +275,13 @@ status_t GonkBufferQueueProducer::waitForFreeSlotThenRelock(
           (acquiredCount <= mCore->mMaxAcquiredBufferCount)) {
         return WOULD_BLOCK;
       }
+      nsecs_t waitStart = systemTime(SYSTEM_TIME_MONOTONIC);
       mCore->mDequeueCondition.wait(mCore->mMutex);
+      nsecs_t waitTime = systemTime(SYSTEM_TIME_MONOTONIC) - waitStart;
+      mCore->mDequeueStats.mWaits++;
+      mCore->mDequeueStats.mTotalWaitTime += waitTime;
+      mCore->mDequeueStats.mMaxWaitTime =
+          std::max(mCore->mDequeueStats.mMaxWaitTime, waitTime);
     }
   }  // while (tryAgain)
 
@@ -294,6 +311,7 @@ status_t GonkBufferQueueProducer::dequeueBuffer(
   *outSlot = GonkBufferQueueCore::INVALID_BUFFER_SLOT;
 
   bool attachedByConsumer = false;
+  sp<IConsumerListener> listener;
 
   {  // Autolock scope
     Mutex::Autolock lock(mCore->mMutex);
@@ -306,6 +324,7 @@ status_t GonkBufferQueueProducer::dequeueBuffer(
     // Enable the usage bits the consumer requested
     usage |= mCore->mConsumerUsageBits;
 
+    mCore->mDequeueStats.mDequeues++;
     int found;
     status_t status =
         waitForFreeSlotThenRelock("dequeueBuffer", false, &found, &returnFlags);
@@ -313,6 +332,14 @@ status_t GonkBufferQueueProducer::dequeueBuffer(
       return status;
     }
 
+    // The extra buffer of a dynamic buffer count was freed, the producer and
+    // the consumer have to drop their references to it too.
+    if (mCore->mBuffersFreed) {
+      mCore->mBuffersFreed = false;
+      returnFlags |= RELEASE_ALL_BUFFERS;
+      listener = mCore->mConsumerListener;
+    }
+
     // This should not happen
     if (found == GonkBufferQueueCore::INVALID_BUFFER_SLOT) {
       ALOGE("dequeueBuffer: no available buffer slots");
@@ -364,6 +391,11 @@ status_t GonkBufferQueueProducer::dequeueBuffer(
     mSlots[found].mFence = Fence::NO_FENCE;
   }  // Autolock scope
 
+  // Call back without lock held
+  if (listener != NULL) {
+    listener->onBuffersReleased();
+  }
+
   if (returnFlags & BUFFER_NEEDS_REALLOCATION) {
     RefPtr<ImageBridgeChild> allocator = ImageBridgeChild::GetSingleton().get();
     usage |= GraphicBuffer::USAGE_HW_TEXTURE;
@@ -19,7 +19,9 @@
 #  define _GNU_SOURCE
 #endif
 
+#include <algorithm>
 #include <cutils/properties.h>
+#include <deque>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -516,7 +518,7 @@ class GeckoInputDispatcher : public InputDispatcherInterface {
   // UserInputData is pushed on on the InputReaderThread and
   // popped and dispatched on the main thread.
   mozilla::Mutex mQueueLock;
-  std::queue<UserInputData> mEventQueue;
+  std::deque<UserInputData> mEventQueue;
   sp<EventHub> mEventHub;
   RefPtr<GeckoTouchDispatcher> mTouchDispatcher;
 
@@ -528,15 +530,20 @@ class GeckoInputDispatcher : public InputDispatcherInterface {
   void InitRepeatKey();
   void DeinitRepeatKey();
   void ReportRepeatKey(UserInputData& data);
+  static bool IsRepeatOf(const UserInputData& aQueued,
+                         const UserInputData& aData);
 };
 
 enum events { SUPPORTED_KEY_DOWN, SUPPORTED_KEY_LONG_PRESSED, STOP_KEY };
 
 enum states { STOP, START, REPEAT };
 
+// Generates repeats for held D-pad keys. The state machine runs on the main
+// thread as repeats are dispatched, but the timer fires on a background task
+// queue, so a busy main thread doesn't also delay when repeats are queued.
 class nsRepeatKeyTimer final : public nsITimerCallback {
  public:
-  NS_DECL_ISUPPORTS
+  NS_DECL_THREADSAFE_ISUPPORTS
 
   nsRepeatKeyTimer();
   nsresult Init(GeckoInputDispatcher* aGeckoInputDispatcher);
@@ -547,7 +554,11 @@ class nsRepeatKeyTimer final : public nsITimerCallback {
   virtual ~nsRepeatKeyTimer();
 
  private:
+  // mLock protects mGeckoInputDispatcher and mPendingKey, which Notify()
+  // reads on mTaskQueue.
+  mozilla::Mutex mLock;
   GeckoInputDispatcher* mGeckoInputDispatcher;
+  nsCOMPtr<nsISerialEventTarget> mTaskQueue;
   nsCOMPtr<nsITimer> mTimer;
   uint32_t mDelay;
   uint32_t mRepeatCnt;
@@ -568,16 +579,26 @@ class nsRepeatKeyTimer final : public nsITimerCallback {
 };
 
 nsRepeatKeyTimer::nsRepeatKeyTimer()
-    : mDelay(mSpeeds[0]), mRepeatCnt(0), mCurrentState(STOP) {}
+    : mLock("nsRepeatKeyTimer::mLock"),
+      mGeckoInputDispatcher(nullptr),
+      mDelay(mSpeeds[0]),
+      mRepeatCnt(0),
+      mCurrentState(STOP) {}
 
 nsresult nsRepeatKeyTimer::Init(GeckoInputDispatcher* aGeckoInputDispatcher) {
-  mGeckoInputDispatcher = aGeckoInputDispatcher;
+  {
+    MutexAutoLock lock(mLock);
+    mGeckoInputDispatcher = aGeckoInputDispatcher;
+  }
   ResetState();
-  return NS_OK;
+  return NS_CreateBackgroundTaskQueue("KeyRepeat", getter_AddRefs(mTaskQueue));
 }
 
 nsresult nsRepeatKeyTimer::Deinit() {
-  mGeckoInputDispatcher = nullptr;
+  {
+    MutexAutoLock lock(mLock);
+    mGeckoInputDispatcher = nullptr;
+  }
   Stop();
   ResetState();
   return NS_OK;
@@ -588,14 +609,18 @@ bool nsRepeatKeyTimer::Handler(UserInputData& data) {
   switch (mNewEvent) {
     case SUPPORTED_KEY_DOWN:
       switch (mCurrentState) {
-        case STOP:
-          memcpy(&mPendingKey, &data, sizeof(UserInputData));
+        case STOP: {
+          {
+            MutexAutoLock lock(mLock);
+            memcpy(&mPendingKey, &data, sizeof(UserInputData));
+          }
           mRepeatCnt = 0;
           SetDelay(mSpeeds[0]);
           Start();
           mRepeatCnt++;
           mCurrentState = START;
           break;
+        }
         case START:
         case REPEAT:
           Stop();
@@ -669,6 +694,9 @@ nsresult nsRepeatKeyTimer::Start() {
       LOG("Fail to get timer instance for repeat key");
       return result;
     }
+    if (mTaskQueue) {
+      mTimer->SetTarget(mTaskQueue);
+    }
   }
 
   return mTimer->InitWithCallback(this, mDelay, nsITimer::TYPE_ONE_SHOT);
@@ -695,8 +723,11 @@ static already_AddRefed<nsIScreen> GetPrimaryScreen() {
 
 NS_IMETHODIMP
 nsRepeatKeyTimer::Notify(nsITimer* timer) {
-  if (mGeckoInputDispatcher)
-    mGeckoInputDispatcher->ReportRepeatKey(mPendingKey);
+  MutexAutoLock lock(mLock);
+  if (mGeckoInputDispatcher) {
+    UserInputData data = mPendingKey;
+    mGeckoInputDispatcher->ReportRepeatKey(data);
+  }
   return NS_OK;
 }
 
@@ -728,7 +759,10 @@ enum events nsRepeatKeyTimer::GetEvent(UserInputData& data) {
 }
 
 void nsRepeatKeyTimer::ResetState(void) {
-  memset(&mPendingKey, 0, sizeof(UserInputData));
+  {
+    MutexAutoLock lock(mLock);
+    memset(&mPendingKey, 0, sizeof(UserInputData));
+  }
   mDelay = mSpeeds[0];
   mRepeatCnt = 0;
   mCurrentState = STOP;
@@ -801,7 +835,7 @@ void GeckoInputDispatcher::dispatchOnce() {
     MutexAutoLock lock(mQueueLock);
     if (mEventQueue.empty()) return;
     data = mEventQueue.front();
-    mEventQueue.pop();
+    mEventQueue.pop_front();
     if (!mEventQueue.empty()) gAppShell->NotifyNativeEvent();
   }
 
@@ -854,7 +888,17 @@ void GeckoInputDispatcher::notifyKey(const NotifyKeyArgs* args) {
   data.key.scanCode = args->scanCode;
   {
     MutexAutoLock lock(mQueueLock);
-    mEventQueue.push(data);
+    if (data.action == AKEY_EVENT_ACTION_UP) {
+      // Repeats of this key that the main thread hasn't got to yet would
+      // land after the user let go, and make a scroll overshoot.
+      mEventQueue.erase(
+          std::remove_if(mEventQueue.begin(), mEventQueue.end(),
+                         [&](const UserInputData& aQueued) {
+                           return IsRepeatOf(aQueued, data);
+                         }),
+          mEventQueue.end());
+    }
+    mEventQueue.push_back(data);
     if (!mPowerWakelock) {
       // From https://cs.android.com/android/platform/superproject/+/android-10.0.0_r30:hardware/libhardware_legacy/power.cpp;l=62
       // return 0 indicates acquire wakelock successfully, return -1 indicates failed to acquire wakelock.
@@ -872,12 +916,29 @@ void GeckoInputDispatcher::SetMouseDevice(bool aMouseDevice) {
   mTouchDispatcher->SetMouseDevice(aMouseDevice);
 }
 
+/* static */
+bool GeckoInputDispatcher::IsRepeatOf(const UserInputData& aQueued,
+                                      const UserInputData& aData) {
+  return aQueued.type == UserInputData::KEY_DATA &&
+         aQueued.action == AKEY_EVENT_ACTION_DOWN &&
+         (aQueued.flags & AKEY_EVENT_FLAG_LONG_PRESS) &&
+         aQueued.key.keyCode == aData.key.keyCode;
+}
+
 void GeckoInputDispatcher::ReportRepeatKey(UserInputData& data) {
   data.timeMs = nanosecsToMillisecs(systemTime(SYSTEM_TIME_MONOTONIC));
   data.flags |= AKEY_EVENT_FLAG_LONG_PRESS;
   {
     MutexAutoLock lock(mQueueLock);
-    mEventQueue.push(data);
+    // If the main thread hasn't handled the previous repeat yet, refresh
+    // it rather than queueing up another one.
+    for (UserInputData& queued : mEventQueue) {
+      if (IsRepeatOf(queued, data)) {
+        queued.timeMs = data.timeMs;
+        return;
+      }
+    }
+    mEventQueue.push_back(data);
   }
   gAppShell->NotifyNativeEvent();
 }
@@ -163,17 +163,16 @@ void nsWindow::ConfigureAPZControllerThread() {
 }
 
 void nsWindow::SetMouseCursorPosition(const ScreenIntPoint& aScreenIntPoint) {
-#if 0
-  // The only implementation of nsIWidget::SetMouseCursorPosition in nsWindow
-  // is for remote control.
-  if (gFocusedWindow) {
-    // NB: this is a racy use of gFocusedWindow.  We assume that
-    // our one and only top widget is already in a stable state by
-    // the time we start receiving mousemove events.
-    gFocusedWindow->SetScreenIntPoint(aScreenIntPoint);
-    KickOffComposition();
-  }
-#endif
+  // Move the cursor overlay drawn by DrawWindowOverlay directly, so that the
+  // virtual cursor follows the keys with a composite only, ahead of the
+  // mousemove that has to be hit-tested and delivered to content.
+  LayoutDeviceIntPoint position(
+      std::clamp(aScreenIntPoint.x, 0, mBounds.width),
+      std::clamp(aScreenIntPoint.y, 0, mBounds.height));
+
+  EnsureGLCursorImageManager();
+  mGLCursorImageManager->SetGLCursorPosition(position);
+  KickOffComposition();
 }
 
 TextEventDispatcherListener* nsWindow::GetNativeTextEventDispatcherListener() {
@@ -842,7 +841,7 @@ LayoutDeviceIntRect nsWindow::GetNaturalBounds() {
 nsScreenGonk* nsWindow::GetScreen() { return mScreen; }
 
 bool nsWindow::NeedsPaint() {
-  if (!mLayerManager) {
+  if (!mLayerManager || mScreen->IsMirroredByHwc()) {
     return false;
   }
   return nsIWidget::NeedsPaint();
@@ -0,0 +1,110 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "DeviceStorage.h"
+#include "gtest/gtest.h"
+#include "gtest/MozGTestBench.h"
+#include "mozilla/Preferences.h"
+#include "mozilla/StaticPtr.h"
+#include "nsDirectoryServiceDefs.h"
+#include "nsDirectoryServiceUtils.h"
+#include "nsIFile.h"
+#include "nsPrintfCString.h"
+
+using namespace mozilla;
+
+// Enumerates a synthetic sdcard laid out like a well used phone: a camera
+// roll, a music library a few levels deep, some videos and downloads.
+// device.storage.overrideRootDir points every storage type at it, the
+// volume itself still has to be mounted for the storage to be available.
+class GonkDeviceStoragePerf : public ::testing::Test {
+ protected:
+  static constexpr uint32_t kPictures = 600;
+  static constexpr uint32_t kMusic = 800;
+  static constexpr uint32_t kVideos = 50;
+  static constexpr uint32_t kOther = 150;
+
+  static void SetUpTestCase() {
+    nsCOMPtr<nsIFile> root;
+    NS_GetSpecialDirectory(NS_OS_TEMP_DIR, getter_AddRefs(root));
+    ASSERT_TRUE(root);
+    root->AppendNative("gonk-perf-devicestorage"_ns);
+    root->Remove(true);
+
+    for (uint32_t i = 0; i < kPictures; i++) {
+      CreateFile(root, nsPrintfCString("DCIM/100MEDIA/IMG_%04u.jpg", i));
+    }
+    for (uint32_t i = 0; i < kMusic; i++) {
+      CreateFile(root, nsPrintfCString("Music/Artist%02u/Album%u/%02u.mp3",
+                                       i / 40, i / 10 % 4, i % 10));
+    }
+    for (uint32_t i = 0; i < kVideos; i++) {
+      CreateFile(root, nsPrintfCString("Movies/VID_%04u.mp4", i));
+    }
+    static const char* const kExtensions[] = {"pdf", "zip", "txt"};
+    for (uint32_t i = 0; i < kOther; i++) {
+      CreateFile(root, nsPrintfCString("Download/file%03u.%s", i,
+                                       kExtensions[i % 3]));
+    }
+
+    nsAutoString path;
+    root->GetPath(path);
+    Preferences::SetString("device.storage.overrideRootDir", path);
+    sRoot = root;
+  }
+
+  static void TearDownTestCase() {
+    Preferences::ClearUser("device.storage.overrideRootDir");
+    if (sRoot) {
+      sRoot->Remove(true);
+      sRoot = nullptr;
+    }
+  }
+
+  static void CreateFile(nsIFile* aRoot, const nsACString& aPath) {
+    nsCOMPtr<nsIFile> file;
+    aRoot->Clone(getter_AddRefs(file));
+    file->AppendRelativeNativePath(aPath);
+    file->Create(nsIFile::NORMAL_FILE_TYPE, 0644);
+  }
+
+  // Walks the tree the way enumerate() does when there is no file index.
+  static void Enumerate(const char16_t* aType, uint32_t aExpected) {
+    nsDependentString type(aType);
+    nsAutoString storageName;
+    nsDOMDeviceStorage::GetDefaultStorageName(type, storageName);
+    RefPtr<DeviceStorageFile> dir =
+        new DeviceStorageFile(type, storageName, u""_ns, u""_ns);
+    if (!dir->mFile || !dir->IsAvailable()) {
+      printf("%s storage isn't available, not measured\n",
+             NS_ConvertUTF16toUTF8(type).get());
+      return;
+    }
+
+    nsAutoString rootPath;
+    dir->mFile->GetPath(rootPath);
+    nsTArray<RefPtr<DeviceStorageFile>> files;
+    dir->collectFilesInternal(files, 0, rootPath);
+    EXPECT_EQ(files.Length(), aExpected);
+  }
+
+  static StaticRefPtr<nsIFile> sRoot;
+};
+
+StaticRefPtr<nsIFile> GonkDeviceStoragePerf::sRoot;
+
+MOZ_GTEST_BENCH_F(GonkDeviceStoragePerf, Enumerate_Pictures,
+                  [] { Enumerate(u"pictures", kPictures); });
+
+MOZ_GTEST_BENCH_F(GonkDeviceStoragePerf, Enumerate_Music,
+                  [] { Enumerate(u"music", kMusic); });
+
+MOZ_GTEST_BENCH_F(GonkDeviceStoragePerf, Enumerate_Videos,
+                  [] { Enumerate(u"videos", kVideos); });
+
+MOZ_GTEST_BENCH_F(GonkDeviceStoragePerf, Enumerate_Sdcard, [] {
+  Enumerate(u"sdcard", kPictures + kMusic + kVideos + kOther);
+});
@@ -0,0 +1,140 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "HwcUtils.h"
+#include "gtest/gtest.h"
+#include "gtest/MozGTestBench.h"
+#include "mozilla/Maybe.h"
+#include "nsRegion.h"
+
+using namespace mozilla;
+using namespace mozilla::gfx;
+
+namespace {
+
+// The geometry HwcComposer2D::PrepareLayerList works on for each layer,
+// taken from layer dumps of a 1080x1920 device.
+struct RecordedLayer {
+  nsIntRegion mVisible;
+  Matrix mTransform;
+  Maybe<nsIntRect> mClip;
+  nsIntRect mBufferRect;
+  bool mYFlipped;
+};
+
+static const nsIntRect kScreen(0, 0, 1080, 1920);
+
+// Wallpaper, a grid of app icons in a scrolled container, the dock and the
+// status bar.
+static nsTArray<RecordedLayer> Homescreen() {
+  nsTArray<RecordedLayer> layers;
+  layers.AppendElement(RecordedLayer{nsIntRegion(nsIntRect(0, 0, 1440, 2560)),
+                                     Matrix::Scaling(0.75f, 0.75f), Nothing(),
+                                     nsIntRect(0, 0, 1440, 2560), false});
+  for (int32_t row = 0; row < 6; row++) {
+    for (int32_t col = 0; col < 4; col++) {
+      layers.AppendElement(RecordedLayer{
+          nsIntRegion(nsIntRect(0, 0, 192, 192)),
+          Matrix::Translation(54 + col * 258, 120 + row * 280),
+          Some(nsIntRect(0, 72, 1080, 1560)), nsIntRect(0, 0, 192, 192),
+          false});
+    }
+  }
+  layers.AppendElement(RecordedLayer{nsIntRegion(nsIntRect(0, 0, 1080, 288)),
+                                     Matrix::Translation(0, 1632), Nothing(),
+                                     nsIntRect(0, 0, 1080, 288), false});
+  layers.AppendElement(RecordedLayer{nsIntRegion(nsIntRect(0, 0, 1080, 72)),
+                                     Matrix(), Nothing(),
+                                     nsIntRect(0, 0, 1080, 72), false});
+  return layers;
+}
+
+// A page being scrolled: tiled content partly covered by a fixed header,
+// so that its visible region has several rectangles, and the scrollbar.
+static nsTArray<RecordedLayer> ScrollingPage() {
+  nsTArray<RecordedLayer> layers;
+  for (int32_t tile = 0; tile < 4; tile++) {
+    nsIntRegion visible(nsIntRect(0, 0, 1080, 512));
+    visible.SubOut(nsIntRect(0, 0, 1080, 40 * tile));
+    visible.SubOut(nsIntRect(900, 100, 180, 96));
+    layers.AppendElement(RecordedLayer{
+        visible, Matrix::Translation(0, 72 + tile * 512 - 137),
+        Some(nsIntRect(0, 72, 1080, 1848)), nsIntRect(0, 0, 1080, 512),
+        false});
+  }
+  layers.AppendElement(RecordedLayer{nsIntRegion(nsIntRect(0, 0, 1080, 168)),
+                                     Matrix::Translation(0, 72), Nothing(),
+                                     nsIntRect(0, 0, 1080, 168), false});
+  layers.AppendElement(RecordedLayer{nsIntRegion(nsIntRect(0, 0, 12, 400)),
+                                     Matrix::Translation(1064, 600), Nothing(),
+                                     nsIntRect(0, 0, 12, 400), false});
+  layers.AppendElement(RecordedLayer{nsIntRegion(nsIntRect(0, 0, 1080, 72)),
+                                     Matrix(), Nothing(),
+                                     nsIntRect(0, 0, 1080, 72), false});
+  return layers;
+}
+
+// A 1280x720 video scaled into the screen width, with its controls on top.
+static nsTArray<RecordedLayer> Video() {
+  nsTArray<RecordedLayer> layers;
+  Matrix video = Matrix::Scaling(1080.0f / 1280, 1080.0f / 1280);
+  video.PostTranslate(0, 656);
+  layers.AppendElement(RecordedLayer{nsIntRegion(nsIntRect(0, 0, 1280, 720)),
+                                     video, Nothing(),
+                                     nsIntRect(0, 0, 1280, 720), true});
+  layers.AppendElement(RecordedLayer{nsIntRegion(nsIntRect(0, 0, 1080, 160)),
+                                     Matrix::Translation(0, 1760), Nothing(),
+                                     nsIntRect(0, 0, 1080, 160), false});
+  return layers;
+}
+
+// Runs the per layer geometry of PrepareLayerList for a thousand frames.
+static void PrepareFrames(const nsTArray<RecordedLayer>& aLayers) {
+  uint32_t rendered = 0;
+  HwcUtils::RectVector visibleRects;
+  for (int frame = 0; frame < 1000; frame++) {
+    rendered = 0;
+    for (const RecordedLayer& layer : aLayers) {
+      nsIntRect clip;
+      if (!HwcUtils::CalculateClipRect(Matrix(), layer.mClip.ptrOr(nullptr),
+                                       kScreen, &clip)) {
+        continue;
+      }
+
+      bool visible = true;
+      if (layer.mVisible.GetNumRects() > 1) {
+        visibleRects.clear();
+        if (!HwcUtils::PrepareVisibleRegion(layer.mVisible, layer.mTransform,
+                                            layer.mTransform, clip,
+                                            layer.mBufferRect, &visibleRects,
+                                            visible)) {
+          continue;
+        }
+      } else {
+        hwc_rect_t sourceCrop, displayFrame;
+        visible = HwcUtils::PrepareLayerRects(
+            layer.mVisible.GetBounds(), layer.mTransform, layer.mTransform,
+            clip, layer.mBufferRect, layer.mYFlipped, &sourceCrop,
+            &displayFrame);
+      }
+      if (visible) {
+        rendered++;
+      }
+    }
+  }
+  EXPECT_GT(rendered, 0u);
+}
+
+}  // namespace
+
+MOZ_GTEST_BENCH(GonkHwcPerf, PrepareLayerList_Homescreen,
+                [] { PrepareFrames(Homescreen()); });
+
+MOZ_GTEST_BENCH(GonkHwcPerf, PrepareLayerList_ScrollingPage,
+                [] { PrepareFrames(ScrollingPage()); });
+
+MOZ_GTEST_BENCH(GonkHwcPerf, PrepareLayerList_Video,
+                [] { PrepareFrames(Video()); });
@@ -0,0 +1,71 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <cmath>
+
+#include "ProcessOrientation.h"
+#include "gtest/gtest.h"
+#include "gtest/MozGTestBench.h"
+#include "mozilla/Hal.h"
+
+using namespace mozilla;
+using namespace mozilla::hal;
+
+namespace {
+
+static const float kGravity = 9.81f;
+
+// A minute of accelerometer samples at aRateHz, built the way the sensors
+// polling thread builds them: the device is held upright with some hand
+// tremor and turned to landscape and back every five seconds.
+static void DispatchAccelerometer(uint32_t aRateHz) {
+  const int64_t intervalNs = 1000000000LL / aRateHz;
+  const uint32_t count = aRateHz * 60;
+
+  ProcessOrientation orientation;
+  int rotation = 0;
+  uint32_t changes = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    int64_t timestampNs = i * intervalNs;
+    double seconds = timestampNs / 1e9;
+    // Rotated by 0 or 90 degrees around the screen normal, with half a
+    // second to turn in between.
+    double turn = std::fmod(seconds, 10.0);
+    double angle = M_PI / 2 * std::min(std::max(turn - 5.0, 0.0) * 2, 1.0);
+    if (turn > 9.5) {
+      angle = M_PI / 2 * (10.0 - turn) * 2;
+    }
+    float tremor = 0.2f * std::sin(seconds * 2 * M_PI * 9);
+
+    nsTArray<float> values;
+    values.AppendElement(kGravity * std::sin(angle) + tremor);
+    values.AppendElement(kGravity * std::cos(angle) * 0.95f);
+    values.AppendElement(kGravity * 0.3f + tremor);
+    SensorData data(SENSOR_ACCELERATION, timestampNs, values);
+
+    int proposed = orientation.OnSensorChanged(data, rotation);
+    if (proposed >= 0 && proposed != rotation) {
+      rotation = proposed;
+      changes++;
+    }
+  }
+
+  // The device was turned twelve times, the tremor alone must never change
+  // the rotation.
+  EXPECT_LE(changes, 12u);
+}
+
+}  // namespace
+
+MOZ_GTEST_BENCH(GonkSensorPerf, Accelerometer_Normal,
+                [] { DispatchAccelerometer(5); });
+
+MOZ_GTEST_BENCH(GonkSensorPerf, Accelerometer_Game,
+                [] { DispatchAccelerometer(50); });
+
+MOZ_GTEST_BENCH(GonkSensorPerf, Accelerometer_Fastest,
+                [] { DispatchAccelerometer(200); });
@@ -0,0 +1,100 @@
+/* -*- Mode: C++; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/* vim: set ts=8 sts=2 et sw=2 tw=80: */
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <cmath>
+
+#include "GeckoTouchDispatcher.h"
+#include "InputData.h"
+#include "gtest/gtest.h"
+#include "gtest/MozGTestBench.h"
+#include "mozilla/TimeStamp.h"
+
+namespace mozilla {
+
+class GeckoTouchDispatcherBench {
+ public:
+  // Replays ten seconds of a finger scrolling up and down, sampled by the
+  // touch panel at 120Hz, and resamples it for every 60Hz vsync, either
+  // linearly or with the predictor. Works on the dispatcher's queue directly
+  // so that nothing is sent to APZ.
+  static void Run(int32_t aFingers, bool aPredict) {
+    RefPtr<GeckoTouchDispatcher> dispatcher =
+        GeckoTouchDispatcher::GetInstance();
+    MutexAutoLock lock(dispatcher->mTouchQueueLock);
+
+    TimeStamp start = TimeStamp::Now();
+    ScreenIntPoint last;
+    for (uint32_t frame = 0; frame < kFrames; frame++) {
+      for (uint32_t i = 0; i < kTouchesPerVsync; i++) {
+        uint32_t sample = frame * kTouchesPerVsync + i;
+        double ms = sample * kTouchIntervalMs;
+        MultiTouchInput touch(MultiTouchInput::MULTITOUCH_MOVE, uint32_t(ms),
+                              start + TimeDuration::FromMilliseconds(ms), 0);
+        for (int32_t finger = 0; finger < aFingers; finger++) {
+          touch.mTouches.AppendElement(SingleTouchData(
+              finger, FingerPosition(ms, finger), ScreenSize(), 0.0f, 0.0f));
+        }
+        dispatcher->mTouchMoveEvents.push_back(touch);
+        if (aPredict) {
+          dispatcher->RecordTouchMoveSample(touch);
+        }
+      }
+
+      TimeStamp vsync = start + TimeDuration::FromMilliseconds(
+                                    (frame + 1) * kVsyncIntervalMs);
+      // The frame started at this vsync is shown at the next one.
+      TimeStamp present =
+          vsync + TimeDuration::FromMilliseconds(kVsyncIntervalMs);
+      MultiTouchInput resampled;
+      if (aPredict) {
+        dispatcher->PredictTouchMoves(resampled, present);
+      } else {
+        dispatcher->ResampleTouchMoves(resampled, vsync);
+      }
+      last = resampled.mTouches[0].mScreenPoint;
+    }
+
+    // Leave the dispatcher the way the input code expects to find it.
+    dispatcher->mTouchMoveEvents.clear();
+    dispatcher->mPointerHistories.Clear();
+    dispatcher->mPredictionErrorSum = 0.0;
+    dispatcher->mPredictionErrorCount = 0;
+
+    // Resampling never lands far off the path of the finger.
+    EXPECT_NEAR(last.y, kCenterY, kAmplitude + 100);
+  }
+
+ private:
+  static constexpr uint32_t kFrames = 600;
+  static constexpr uint32_t kTouchesPerVsync = 2;
+  static constexpr double kVsyncIntervalMs = 1000.0 / 60;
+  static constexpr double kTouchIntervalMs = kVsyncIntervalMs / 2;
+  static constexpr int32_t kCenterY = 960;
+  static constexpr int32_t kAmplitude = 700;
+
+  static ScreenIntPoint FingerPosition(double aMs, int32_t aFinger) {
+    // One full scroll up and down every 1.5 seconds.
+    double phase = 2 * M_PI * aMs / 1500.0;
+    return ScreenIntPoint(300 + 400 * aFinger,
+                          kCenterY + int32_t(kAmplitude * std::sin(phase)));
+  }
+};
+
+}  // namespace mozilla
+
+using namespace mozilla;
+
+MOZ_GTEST_BENCH(GonkTouchPerf, Resample_OneFinger,
+                [] { GeckoTouchDispatcherBench::Run(1, false); });
+
+MOZ_GTEST_BENCH(GonkTouchPerf, Resample_TwoFingers,
+                [] { GeckoTouchDispatcherBench::Run(2, false); });
+
+MOZ_GTEST_BENCH(GonkTouchPerf, Predict_OneFinger,
+                [] { GeckoTouchDispatcherBench::Run(1, true); });
+
+MOZ_GTEST_BENCH(GonkTouchPerf, Predict_TwoFingers,
+                [] { GeckoTouchDispatcherBench::Run(2, true); });
@@ -1264,7 +1264,7 @@ already_AddRefed<LayerManager> nsBaseWidget::CreateCompositorSession(
     MOZ_ASSERT(supportsAcceleration);
     options.SetAllowSoftwareWebRenderOGL(
         StaticPrefs::gfx_webrender_software_opengl_AtStartup());
-#elif defined(MOZ_WIDGET_GTK)
+#elif defined(MOZ_WIDGET_GTK) || defined(MOZ_WIDGET_GONK)
     if (supportsAcceleration) {
       options.SetAllowSoftwareWebRenderOGL(
           StaticPrefs::gfx_webrender_software_opengl_AtStartup());
@@ -39,6 +39,8 @@ class MOZ_ONLY_USED_TO_AVOID_STATIC_CONSTRUCTORS StaticMutex {
 
   void Unlock() { Mutex()->Unlock(); }
 
+  [[nodiscard]] bool TryLock() { return Mutex()->TryLock(); }
+
   void AssertCurrentThreadOwns() {
 #ifdef DEBUG
     Mutex()->AssertCurrentThreadOwns();
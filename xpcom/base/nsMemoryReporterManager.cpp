@@ -2418,8 +2418,8 @@ int64_t nsMemoryReporterManager::ResidentUnique(ResidentUniqueArg) {
 NS_IMETHODIMP
 nsMemoryReporterManager::GetHeapAllocated(int64_t* aAmount) {
 #ifdef HAVE_JEMALLOC_STATS
-  jemalloc_stats_t stats;
-  jemalloc_stats(&stats);
+  jemalloc_stats_lite_t stats;
+  jemalloc_stats_lite(&stats);
   *aAmount = stats.allocated;
   return NS_OK;
 #else
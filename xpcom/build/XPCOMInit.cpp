@@ -64,10 +64,12 @@
 
 #include "nsSystemInfo.h"
 #include "nsMemoryReporterManager.h"
+#include "nsPrintfCString.h"
 #include "nsMessageLoop.h"
 #include "nss.h"
 #include "nsNSSComponent.h"
 
+#include <algorithm>
 #include <locale.h>
 #include "mozilla/Services.h"
 #include "mozilla/Omnijar.h"
@@ -87,6 +89,7 @@
 #include "mozilla/ipc/BrowserProcessSubThread.h"
 #include "mozilla/ClearOnShutdown.h"
 #include "mozilla/CountingAllocatorBase.h"
+#include "mozilla/intl/ICUServiceMemory.h"
 #include "mozilla/UniquePtr.h"
 #include "mozilla/ServoStyleConsts.h"
 
@@ -104,6 +107,8 @@
 
 using base::AtExitManager;
 using mozilla::ipc::BrowserProcessSubThread;
+using mozilla::intl::ICUService;
+using mozilla::intl::ICUServiceMemory;
 
 // From toolkit/library/rust/lib.rs
 extern "C" void GkRust_Init();
@@ -191,22 +196,47 @@ class ICUReporter final : public nsIMemoryReporter,
   NS_DECL_ISUPPORTS
 
   static void* Alloc(const void*, size_t aSize) {
-    return CountingMalloc(aSize);
+    void* p = CountingMalloc(aSize);
+    ICUServiceMemory::NoteAlloc(p);
+    return p;
   }
 
   static void* Realloc(const void*, void* aPtr, size_t aSize) {
-    return CountingRealloc(aPtr, aSize);
+    ICUServiceMemory::NoteFree(aPtr);
+    void* p = CountingRealloc(aPtr, aSize);
+    // A failed non-empty reallocation leaves the original block in place.
+    ICUServiceMemory::NoteAlloc(p || !aSize ? p : aPtr);
+    return p;
   }
 
-  static void Free(const void*, void* aPtr) { return CountingFree(aPtr); }
+  static void Free(const void*, void* aPtr) {
+    ICUServiceMemory::NoteFree(aPtr);
+    CountingFree(aPtr);
+  }
 
  private:
   NS_IMETHOD
   CollectReports(nsIHandleReportCallback* aHandleReport, nsISupports* aData,
                  bool aAnonymize) override {
+    size_t other = MemoryAllocated();
+    for (uint8_t i = 0; i < uint8_t(ICUService::Count); i++) {
+      ICUService service = ICUService(i);
+      size_t amount = std::min(ICUServiceMemory::Amount(service), other);
+      other -= amount;
+      aHandleReport->Callback(
+          ""_ns,
+          nsPrintfCString("explicit/icu/%s", ICUServiceMemory::Name(service)),
+          KIND_HEAP, UNITS_BYTES, amount,
+          "Memory used by ICU for this service, including the locale data "
+          "it loaded."_ns,
+          aData);
+    }
+
     MOZ_COLLECT_REPORT(
-        "explicit/icu", KIND_HEAP, UNITS_BYTES, MemoryAllocated(),
-        "Memory used by ICU, a Unicode and globalization support library.");
+        "explicit/icu/other", KIND_HEAP, UNITS_BYTES, other,
+        "Memory used by ICU, a Unicode and globalization support library, "
+        "that isn't attributed to a service above, such as the JS Intl "
+        "objects.");
 
     return NS_OK;
   }
@@ -576,6 +606,7 @@ namespace mozilla {
 void SetICUMemoryFunctions() {
   static bool sICUReporterInitialized = false;
   if (!sICUReporterInitialized) {
+    ICUServiceMemory::Init();
     if (!JS_SetICUMemoryFunctions(ICUReporter::Alloc, ICUReporter::Realloc,
                                   ICUReporter::Free)) {
       MOZ_CRASH("JS_SetICUMemoryFunctions failed.");
@@ -183,4 +183,30 @@ TEST(Queue, PushPopSequence)
   }
 }
 
+TEST(Queue, ElementAt)
+{
+  // Popping and pushing again wraps the head page around.
+  for (uint32_t push1 = 0; push1 < 16; ++push1) {
+    for (uint32_t pop = 0; pop <= push1; ++pop) {
+      for (uint32_t push2 = 0; push2 < 16; ++push2) {
+        Queue<uint32_t, 8> queue;
+        uint32_t inSerial = 0;
+        for (uint32_t i = 0; i < push1; ++i) {
+          queue.Push(inSerial++);
+        }
+        for (uint32_t i = 0; i < pop; ++i) {
+          queue.Pop();
+        }
+        for (uint32_t i = 0; i < push2; ++i) {
+          queue.Push(inSerial++);
+        }
+        ASSERT_EQ(queue.Count(), push1 - pop + push2);
+        for (uint32_t i = 0; i < queue.Count(); ++i) {
+          EXPECT_EQ(queue.ElementAt(i), pop + i);
+        }
+      }
+    }
+  }
+}
+
 }  // namespace TestQueue
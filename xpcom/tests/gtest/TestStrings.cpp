@@ -2309,6 +2309,29 @@ MOZ_GTEST_BENCH_F(Strings, PerfIsUTF8Example3, [this] {
   }
 });
 
+MOZ_GTEST_BENCH_F(Strings, PerfIsUTF8Thousand, [this] {
+  for (int i = 0; i < 20000; i++) {
+    bool b = IsUtf8(*BlackBox(&mAsciiThousandUtf8));
+    BlackBox(&b);
+  }
+});
+
+MOZ_GTEST_BENCH_F(Strings, PerfIsUTF8DEThousand, [this] {
+  for (int i = 0; i < 20000; i++) {
+    bool b = IsUtf8(*BlackBox(&mDeThousandUtf8));
+    BlackBox(&b);
+  }
+});
+
+MOZ_GTEST_BENCH_F(Strings, PerfConvertUtf8toUtf16AsciiThousand, [this] {
+  char16_t dst[1001];
+  for (int i = 0; i < 20000; i++) {
+    size_t written =
+        mozilla::ConvertUtf8toUtf16(*BlackBox(&mAsciiThousandUtf8), dst);
+    BlackBox(&written);
+  }
+});
+
 MOZ_GTEST_BENCH_F(Strings, PerfIsASCII8One, [this] {
   for (int i = 0; i < 200000; i++) {
     bool b = IsAscii(*BlackBox(&mAsciiOneUtf8));
@@ -15,6 +15,7 @@
 #include "nsUnicharUtils.h"
 #include "mozilla/HashFunctions.h"
 #include "nsUTF8Utils.h"
+#include "mozilla/Utf8.h"
 
 #include "gtest/gtest.h"
 
@@ -92,6 +93,48 @@ TEST(UTF, Malformed8)
   }
 }
 
+// Exercises an ASCII run of every length around the 16-byte vector width
+// followed by a multi-byte, and then a malformed, sequence.
+TEST(UTF, AsciiPrefix8)
+{
+  for (size_t prefix = 0; prefix < 50; ++prefix) {
+    nsAutoCString ascii;
+    for (size_t i = 0; i < prefix; ++i) {
+      ascii.Append(char('a' + i % 26));
+    }
+
+    nsAutoCString valid(ascii);
+    valid.AppendLiteral("\xC3\xA9tail");
+    EXPECT_TRUE(IsUtf8(valid));
+    EXPECT_EQ(Utf8ValidUpTo(valid), valid.Length());
+
+    nsAutoString expected;
+    CopyASCIItoUTF16(ascii, expected);
+    expected.AppendLiteral(u"\u00E9tail");
+
+    nsAutoString out;
+    out.SetLength(valid.Length() + 1);
+    size_t written = ConvertUtf8toUtf16(valid, out);
+    out.SetLength(written);
+    EXPECT_TRUE(out.Equals(expected));
+
+    out.SetLength(valid.Length() + 1);
+    Maybe<size_t> maybeWritten =
+        ConvertUtf8toUtf16WithoutReplacement(valid, out);
+    ASSERT_TRUE(maybeWritten.isSome());
+    out.SetLength(*maybeWritten);
+    EXPECT_TRUE(out.Equals(expected));
+
+    nsAutoCString invalid(ascii);
+    invalid.AppendLiteral("\xC3(tail");
+    EXPECT_FALSE(IsUtf8(invalid));
+    EXPECT_EQ(Utf8ValidUpTo(invalid), prefix);
+
+    out.SetLength(invalid.Length() + 1);
+    EXPECT_TRUE(ConvertUtf8toUtf16WithoutReplacement(invalid, out).isNothing());
+  }
+}
+
 TEST(UTF, Hash16)
 {
   for (unsigned int i = 0; i < ArrayLength(ValidStrings); ++i) {
@@ -197,6 +197,22 @@ class Queue {
     return mTail->mEvents[offset];
   }
 
+  // Returns the element aIndex places behind the first one. This walks the
+  // pages, so it is only cheap near the head.
+  T& ElementAt(size_t aIndex) {
+    MOZ_ASSERT(aIndex < Count());
+    if (aIndex < mHeadLength) {
+      return mHead->mEvents[(mOffsetHead + aIndex) % ItemsPerPage];
+    }
+    aIndex -= mHeadLength;
+    Page* page = mHead->mNext;
+    while (aIndex >= ItemsPerPage) {
+      aIndex -= ItemsPerPage;
+      page = page->mNext;
+    }
+    return page->mEvents[aIndex];
+  }
+
   size_t Count() const {
     // It is obvious count is 0 when the queue is empty.
     if (!mHead) {
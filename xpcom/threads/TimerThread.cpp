@@ -10,6 +10,7 @@
 #include "nsThreadUtils.h"
 #include "pratom.h"
 
+#include "nsIMemoryReporter.h"
 #include "nsIObserverService.h"
 #include "mozilla/Services.h"
 #include "mozilla/ChaosMode.h"
@@ -37,6 +38,7 @@ TimerThread::TimerThread()
       mWaiting(false),
       mNotified(false),
       mSleeping(false),
+      mCoalescing(false),
       mAllowedEarlyFiringMicroseconds(0) {}
 
 TimerThread::~TimerThread() {
@@ -49,6 +51,27 @@ nsresult TimerThread::InitLocks() { return NS_OK; }
 
 namespace {
 
+// Every time the timer thread woke up, to fire timers or because the set of
+// timers changed.
+static Atomic<uint64_t, Relaxed> sTimerThreadWakeups;
+
+class TimerThreadWakeupReporter final : public nsIMemoryReporter {
+  ~TimerThreadWakeupReporter() = default;
+
+ public:
+  NS_DECL_ISUPPORTS
+
+  NS_IMETHOD CollectReports(nsIHandleReportCallback* aHandleReport,
+                            nsISupports* aData, bool aAnonymize) override {
+    MOZ_COLLECT_REPORT("timer-thread-wakeups", KIND_OTHER,
+                       UNITS_COUNT_CUMULATIVE, uint64_t(sTimerThreadWakeups),
+                       "The number of times the timer thread woke up.");
+    return NS_OK;
+  }
+};
+
+NS_IMPL_ISUPPORTS(TimerThreadWakeupReporter, nsIMemoryReporter)
+
 class TimerObserverRunnable : public Runnable {
  public:
   explicit TimerObserverRunnable(nsIObserver* aObserver)
@@ -72,6 +95,7 @@ TimerObserverRunnable::Run() {
     observerService->AddObserver(mObserver, "resume_process_notification",
                                  false);
   }
+  RegisterStrongMemoryReporter(new TimerThreadWakeupReporter());
   return NS_OK;
 }
 
@@ -453,6 +477,16 @@ TimerThread::Run() {
 
       if (!mTimers.IsEmpty()) {
         TimeStamp timeout = mTimers[0]->Value()->mTimeout;
+        uint32_t coalescingMs = StaticPrefs::timer_coalescing_ms();
+        if (mCoalescing && coalescingMs &&
+            !mTimers[0]->Value()->IsPrecise()) {
+          // Round up to the next boundary, where the timers that are due by
+          // then all fire in one go.
+          TimeDuration boundary = TimeDuration::FromMilliseconds(coalescingMs);
+          int64_t periods = std::max<int64_t>(
+              0, int64_t(ceil((timeout - mCoalescingEpoch) / boundary)));
+          timeout = mCoalescingEpoch + boundary * periods;
+        }
 
         // Don't wait at all (even for PR_INTERVAL_NO_WAIT) if the next timer
         // is due now or overdue.
@@ -497,6 +531,7 @@ TimerThread::Run() {
     mWaiting = true;
     mNotified = false;
     mMonitor.Wait(waitFor);
+    sTimerThreadWakeups++;
     if (mNotified) {
       forceRunNextTimer = false;
     }
@@ -779,6 +814,23 @@ TimerThread::Observe(nsISupports* /* aSubject */, const char* aTopic,
   return NS_OK;
 }
 
+void TimerThread::SetCoalescing(bool aEnabled) {
+  MonitorAutoLock lock(mMonitor);
+  if (mCoalescing == aEnabled) {
+    return;
+  }
+  mCoalescing = aEnabled;
+  if (mCoalescingEpoch.IsNull()) {
+    mCoalescingEpoch = TimeStamp::Now();
+  }
+
+  // Have the timer thread work out its next wakeup again.
+  if (mWaiting) {
+    mNotified = true;
+    mMonitor.Notify();
+  }
+}
+
 uint32_t TimerThread::AllowedEarlyFiringMicroseconds() const {
   return mAllowedEarlyFiringMicroseconds;
 }
@@ -56,6 +56,8 @@ class TimerThread final : public mozilla::Runnable, public nsIObserver {
 
   uint32_t AllowedEarlyFiringMicroseconds() const;
 
+  void SetCoalescing(bool aEnabled);
+
  private:
   ~TimerThread();
 
@@ -79,6 +81,9 @@ class TimerThread final : public mozilla::Runnable, public nsIObserver {
   bool mWaiting;
   bool mNotified;
   bool mSleeping;
+  bool mCoalescing;
+  // Coalesced timers fire on multiples of timer.coalescing_ms from here.
+  TimeStamp mCoalescingEpoch;
 
   class Entry final : public nsTimerImplHolder {
     const TimeStamp mTimeout;
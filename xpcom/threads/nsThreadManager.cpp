@@ -5,6 +5,9 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "nsThreadManager.h"
+
+#include <algorithm>
+
 #include "nsThread.h"
 #include "nsThreadPool.h"
 #include "nsThreadUtils.h"
@@ -25,6 +28,7 @@
 #include "mozilla/ThreadEventQueue.h"
 #include "mozilla/ThreadLocal.h"
 #include "TaskController.h"
+#include "prsystem.h"
 #ifdef MOZ_CANARY
 #  include <fcntl.h>
 #  include <unistd.h>
@@ -70,6 +74,15 @@ class BackgroundEventTarget final : public nsIEventTarget {
 
 NS_IMPL_ISUPPORTS(BackgroundEventTarget, nsIEventTarget)
 
+// How long idle background threads are kept alive. Every process has these
+// pools, and on b2g a thread kept around for minutes is a stack and a wakeup
+// source we'd rather give back.
+#ifdef MOZ_WIDGET_GONK
+static const uint32_t kBackgroundIdleThreadTimeoutMs = 30000;
+#else
+static const uint32_t kBackgroundIdleThreadTimeoutMs = 300000;
+#endif
+
 BackgroundEventTarget::BackgroundEventTarget()
     : mMutex("BackgroundEventTarget::mMutex") {}
 
@@ -84,15 +97,18 @@ nsresult BackgroundEventTarget::Init() {
   rv = pool->SetThreadStackSize(nsIThreadManager::kThreadPoolStackSize);
   NS_ENSURE_SUCCESS(rv, rv);
 
-  // Thread limit of 2 makes deadlock during synchronous dispatch less likely.
-  rv = pool->SetThreadLimit(2);
+  // Thread limit of at least 2 makes deadlock during synchronous dispatch
+  // less likely. Beyond that, use the cores we have, but don't let the pool
+  // grow past what is worth having on a phone.
+  uint32_t threadLimit =
+      std::min<int32_t>(4, std::max<int32_t>(2, PR_GetNumberOfProcessors()));
+  rv = pool->SetThreadLimit(threadLimit);
   NS_ENSURE_SUCCESS(rv, rv);
 
   rv = pool->SetIdleThreadLimit(1);
   NS_ENSURE_SUCCESS(rv, rv);
 
-  // Leave threads alive for up to 5 minutes
-  rv = pool->SetIdleThreadTimeout(300000);
+  rv = pool->SetIdleThreadTimeout(kBackgroundIdleThreadTimeoutMs);
   NS_ENSURE_SUCCESS(rv, rv);
 
   // Initialize the background I/O event target.
@@ -113,8 +129,7 @@ nsresult BackgroundEventTarget::Init() {
   rv = ioPool->SetIdleThreadLimit(1);
   NS_ENSURE_SUCCESS(rv, rv);
 
-  // Leave threads alive for up to 5 minutes
-  rv = ioPool->SetIdleThreadTimeout(300000);
+  rv = ioPool->SetIdleThreadTimeout(kBackgroundIdleThreadTimeoutMs);
   NS_ENSURE_SUCCESS(rv, rv);
 
   pool.swap(mPool);
@@ -1716,6 +1716,15 @@ void NS_UnsetMainThread();
 extern mozilla::TimeStamp NS_GetTimerDeadlineHintOnCurrentThread(
     mozilla::TimeStamp aDefault, uint32_t aSearchBound);
 
+/**
+ * Lets the timer thread fire timers late, so that the timers of a process
+ * that is in the background wake it up together rather than one by one.
+ * While enabled, timers, other than the TYPE_REPEATING_PRECISE* ones, fire on
+ * the first boundary of timer.coalescing_ms milliseconds after their
+ * deadline.
+ */
+extern void NS_SetTimerCoalescing(bool aEnabled);
+
 /**
  * Dispatches the given event to a background thread.  The primary benefit of
  * this API is that you do not have to manage the lifetime of your own thread
@@ -54,6 +54,12 @@ TimeStamp NS_GetTimerDeadlineHintOnCurrentThread(TimeStamp aDefault,
              : TimeStamp();
 }
 
+void NS_SetTimerCoalescing(bool aEnabled) {
+  if (gThread) {
+    gThread->SetCoalescing(aEnabled);
+  }
+}
+
 already_AddRefed<nsITimer> NS_NewTimer() { return NS_NewTimer(nullptr); }
 
 already_AddRefed<nsITimer> NS_NewTimer(nsIEventTarget* aTarget) {
@@ -120,6 +120,11 @@ class nsTimerImpl {
            mType == nsITimer::TYPE_REPEATING_SLACK_LOW_PRIORITY;
   }
 
+  bool IsPrecise() const {
+    return mType == nsITimer::TYPE_REPEATING_PRECISE ||
+           mType == nsITimer::TYPE_REPEATING_PRECISE_CAN_SKIP;
+  }
+
   bool IsSlack() const {
     return mType == nsITimer::TYPE_REPEATING_SLACK ||
            mType == nsITimer::TYPE_REPEATING_SLACK_LOW_PRIORITY;